@@ -103,6 +103,7 @@ typedef struct _CASC_INDEX_FILE
 {
     TCHAR * szFileName;                             // Name of the index file
     LPBYTE  pbFileData;                             // Pointer to the file data
+    TFileStream * pMapStream;                       // Stream owning the mapped view, if pbFileData points into one
     DWORD   cbFileData;                             // Length of the file data
     BYTE   ExtraBytes;                              // (?) Extra bytes in the key record
     BYTE   SpanSizeBytes;                           // Byte size of the "file size" field. Expected to be 5
@@ -14,6 +14,10 @@
 #include "CascLib.h"
 #include "CascCommon.h"
 
+#ifndef PLATFORM_WINDOWS
+#include <pthread.h>
+#endif
+
 //-----------------------------------------------------------------------------
 // Local structures
 
@@ -118,6 +122,16 @@ typedef struct _FILE_ESPEC_ENTRY
 
 } FILE_ESPEC_ENTRY, *PFILE_ESPEC_ENTRY;
 
+// One worker's share of the parallel index file loading
+typedef struct _CASC_INDEX_LOAD_JOB
+{
+    TCascStorage * hs;                              // The storage being opened
+    DWORD dwFirstIndex;                             // Index of the first index file of this job
+    DWORD dwStep;                                   // Distance between the index files of this job
+    int * Errors;                                   // Result of loading of each index file
+
+} CASC_INDEX_LOAD_JOB, *PCASC_INDEX_LOAD_JOB;
+
 #define FILE_INDEX_HASH_LENGTH  (CASC_EKEY_SIZE + 5 + 4 + 1)
 #define FILE_INDEX_BLOCK_SIZE    0x200
 
@@ -163,23 +177,21 @@ static bool IsIndexFileName_V2(const TCHAR * szFileName)
 
 static bool IsCascIndexHeader_V1(LPBYTE pbFileData, DWORD cbFileData)
 {
-    PFILE_INDEX_HEADER_V1 pIndexHeader = (PFILE_INDEX_HEADER_V1)pbFileData;
+    FILE_INDEX_HEADER_V1 IndexHeader;
     DWORD dwHeaderHash;
     bool bResult = false;
 
     // Check the size
     if(cbFileData >= sizeof(FILE_INDEX_HEADER_V1))
     {
-        // Save the header hash
-        dwHeaderHash = pIndexHeader->dwHeaderHash;
-        pIndexHeader->dwHeaderHash = 0;
+        // Work on a copy of the header; the file data may be a read-only mapped view
+        memcpy(&IndexHeader, pbFileData, sizeof(FILE_INDEX_HEADER_V1));
+        dwHeaderHash = IndexHeader.dwHeaderHash;
+        IndexHeader.dwHeaderHash = 0;
 
         // Calculate the hash
-        if(hashlittle(pIndexHeader, sizeof(FILE_INDEX_HEADER_V1), 0) == dwHeaderHash)
+        if(hashlittle(&IndexHeader, sizeof(FILE_INDEX_HEADER_V1), 0) == dwHeaderHash)
             bResult = true;
-
-        // Put the hash back
-        pIndexHeader->dwHeaderHash = dwHeaderHash;
     }
 
     return bResult;
@@ -613,12 +625,31 @@ static int LoadIndexFile(PCASC_INDEX_FILE pIndexFile, DWORD KeyIndex)
 {
     TFileStream * pStream;
     ULONGLONG FileSize = 0;
+    LPBYTE pbMappedView;
     int nError = ERROR_SUCCESS;
 
     // Sanity checks
     assert(pIndexFile->szFileName != NULL && pIndexFile->szFileName[0] != 0);
 
-    // Open the stream for read-only access and read the file
+    // Map the index file to memory. The EKey entries are used in place,
+    // so the stream (and the view) stays open until the storage is closed
+    pStream = FileStream_OpenFile(pIndexFile->szFileName, STREAM_FLAG_READ_ONLY | STREAM_PROVIDER_FLAT | BASE_PROVIDER_MAP);
+    if(pStream != NULL)
+    {
+        pbMappedView = FileStream_GetMappedView(pStream, &FileSize);
+        if(pbMappedView != NULL && 0 < FileSize && FileSize <= 0x200000)
+        {
+            pIndexFile->pMapStream = pStream;
+            pIndexFile->pbFileData = pbMappedView;
+            pIndexFile->cbFileData = (DWORD)FileSize;
+            return VerifyAndLoadIndexFile(pIndexFile, KeyIndex);
+        }
+
+        FileStream_Close(pStream);
+        FileSize = 0;
+    }
+
+    // If the file can't be mapped, open the stream for read-only access and read the file
     pStream = FileStream_OpenFile(pIndexFile->szFileName, STREAM_FLAG_READ_ONLY | STREAM_PROVIDER_FLAT | BASE_PROVIDER_FILE);
     if(pStream != NULL)
     {
@@ -657,6 +688,126 @@ static int LoadIndexFile(PCASC_INDEX_FILE pIndexFile, DWORD KeyIndex)
     return nError;
 }
 
+// Loads every dwStep-th index file, starting with dwFirstIndex
+static void LoadIndexFileRun(PCASC_INDEX_LOAD_JOB pJob)
+{
+    PCASC_INDEX_FILE pIndexFile;
+
+    for(DWORD i = pJob->dwFirstIndex; i < CASC_INDEX_COUNT; i += pJob->dwStep)
+    {
+        pIndexFile = &pJob->hs->IndexFile[i];
+        if(pIndexFile->szFileName != NULL)
+        {
+            pJob->Errors[i] = LoadIndexFile(pIndexFile, i);
+            if(pJob->Errors[i] != ERROR_SUCCESS)
+                break;
+        }
+    }
+}
+
+#ifdef PLATFORM_WINDOWS
+static DWORD WINAPI IndexLoadWorker(LPVOID lpParameter)
+{
+    LoadIndexFileRun((PCASC_INDEX_LOAD_JOB)lpParameter);
+    return 0;
+}
+#else
+static void * IndexLoadWorker(void * lpParameter)
+{
+    LoadIndexFileRun((PCASC_INDEX_LOAD_JOB)lpParameter);
+    return NULL;
+}
+#endif
+
+static DWORD GetIndexLoadWorkerCount()
+{
+    DWORD dwProcessors = 1;
+
+#ifdef PLATFORM_WINDOWS
+    SYSTEM_INFO SystemInfo;
+
+    GetSystemInfo(&SystemInfo);
+    dwProcessors = SystemInfo.dwNumberOfProcessors;
+#else
+    long nProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if(nProcessors > 0)
+        dwProcessors = (DWORD)nProcessors;
+#endif
+
+    return (dwProcessors > CASC_INDEX_COUNT) ? CASC_INDEX_COUNT : dwProcessors;
+}
+
+// The index files are independent of each other. Each worker loads
+// every n-th file, the calling thread loads the first share itself.
+// If a worker thread can't be created, its share is loaded by the calling thread.
+// The error reported is the one of the lowest failed index, as with serial loading.
+static int LoadIndexFilesParallel(TCascStorage * hs)
+{
+    CASC_INDEX_LOAD_JOB Jobs[CASC_INDEX_COUNT];
+#ifdef PLATFORM_WINDOWS
+    HANDLE Threads[CASC_INDEX_COUNT];
+#else
+    pthread_t Threads[CASC_INDEX_COUNT];
+#endif
+    bool bThreadStarted[CASC_INDEX_COUNT];
+    DWORD dwWorkers = GetIndexLoadWorkerCount();
+    int Errors[CASC_INDEX_COUNT];
+
+    // Prepare the jobs
+    for(DWORD i = 0; i < CASC_INDEX_COUNT; i++)
+        Errors[i] = ERROR_SUCCESS;
+    for(DWORD i = 0; i < dwWorkers; i++)
+    {
+        Jobs[i].hs = hs;
+        Jobs[i].dwFirstIndex = i;
+        Jobs[i].dwStep = dwWorkers;
+        Jobs[i].Errors = Errors;
+    }
+
+    // Start the worker threads
+    for(DWORD i = 1; i < dwWorkers; i++)
+    {
+#ifdef PLATFORM_WINDOWS
+        Threads[i] = CreateThread(NULL, 0, IndexLoadWorker, &Jobs[i], 0, NULL);
+        bThreadStarted[i] = (Threads[i] != NULL);
+#else
+        bThreadStarted[i] = (pthread_create(&Threads[i], NULL, IndexLoadWorker, &Jobs[i]) == 0);
+#endif
+    }
+
+    // Load our own share, and the share of the workers that failed to start
+    LoadIndexFileRun(&Jobs[0]);
+    for(DWORD i = 1; i < dwWorkers; i++)
+    {
+        if(bThreadStarted[i] == false)
+            LoadIndexFileRun(&Jobs[i]);
+    }
+
+    // Wait for the workers
+    for(DWORD i = 1; i < dwWorkers; i++)
+    {
+        if(bThreadStarted[i])
+        {
+#ifdef PLATFORM_WINDOWS
+            WaitForSingleObject(Threads[i], INFINITE);
+            CloseHandle(Threads[i]);
+#else
+            pthread_join(Threads[i], NULL);
+#endif
+        }
+    }
+
+    // Pick the first error
+    for(DWORD i = 0; i < CASC_INDEX_COUNT; i++)
+    {
+        if(Errors[i] != ERROR_SUCCESS)
+            return Errors[i];
+    }
+
+    return ERROR_SUCCESS;
+}
+
 static int CreateMapOfEKeyEntries(TCascStorage * hs)
 {
     PCASC_MAP pMap;
@@ -782,17 +933,12 @@ static int LoadIndexFiles(TCascStorage * hs)
     nError = ScanIndexDirectory(hs->szIndexPath, IndexDirectory_OnFileFound, IndexArray, OldIndexArray, hs);
     if(nError == ERROR_SUCCESS)
     {
-        // Load each index file
+        // Create the names of all index files
         for(i = 0; i < CASC_INDEX_COUNT; i++)
-        {
             hs->IndexFile[i].szFileName = CreateIndexFileName(hs, i, IndexArray[i]);
-            if(hs->IndexFile[i].szFileName != NULL)
-            {
-                nError = LoadIndexFile(&hs->IndexFile[i], i);
-                if(nError != ERROR_SUCCESS)
-                    break;
-            }
-        }
+
+        // Load and verify the index files in parallel
+        nError = LoadIndexFilesParallel(hs);
     }
 
     // Now we need to build the map of the EKey entries (EKey -> CASC_EKEY_ENTRY)
@@ -1017,7 +1163,9 @@ static TCascStorage * FreeCascStorage(TCascStorage * hs)
         {
             if(hs->IndexFile[i].szFileName != NULL)
                 CASC_FREE(hs->IndexFile[i].szFileName);
-            if(hs->IndexFile[i].pbFileData != NULL)
+            if(hs->IndexFile[i].pMapStream != NULL)
+                FileStream_Close(hs->IndexFile[i].pMapStream);
+            else if(hs->IndexFile[i].pbFileData != NULL)
                 CASC_FREE(hs->IndexFile[i].pbFileData);
             if(hs->IndexFile[i].pEKeyEntries && hs->IndexFile[i].FreeEKeyEntries)
                 CASC_FREE(hs->IndexFile[i].pEKeyEntries);
@@ -65,7 +65,8 @@ unsigned char IntToHexChar[] = "0123456789abcdef";
 // GetLastError/SetLastError support for non-Windows platform
 
 #ifndef PLATFORM_WINDOWS
-static DWORD dwLastError = ERROR_SUCCESS;
+// Per thread, like on Windows. The index files are loaded by multiple threads
+static thread_local DWORD dwLastError = ERROR_SUCCESS;
 
 DWORD GetLastError()
 {
@@ -502,9 +502,13 @@ static bool BaseMap_Open(TFileStream * pStream, const TCHAR * szFileName, DWORD
         // Get the file size
         if(fstat64(handle, &fileinfo) != -1)
         {
-            pStream->Base.Map.pbFile = (LPBYTE)mmap(NULL, (size_t)fileinfo.st_size, PROT_READ, MAP_PRIVATE, handle, 0);
-            if(pStream->Base.Map.pbFile != NULL)
+            void * pvFile = mmap(NULL, (size_t)fileinfo.st_size, PROT_READ, MAP_PRIVATE, handle, 0);
+
+            // Note that mmap reports failure as MAP_FAILED, not NULL
+            if(pvFile != MAP_FAILED)
             {
+                pStream->Base.Map.pbFile = (LPBYTE)pvFile;
+
                 // time_t is number of seconds since 1.1.1970, UTC.
                 // 1 second = 10000000 (decimal) in FILETIME
                 // Set the start to 1.1.1970 00:00:00
@@ -2679,6 +2683,24 @@ bool FileStream_GetFlags(TFileStream * pStream, PDWORD pdwStreamFlags)
     return true;
 }
 
+/**
+ * Returns pointer to the memory-mapped view of the file. Only available
+ * for flat streams opened with BASE_PROVIDER_MAP; returns NULL otherwise.
+ * The view stays valid until the stream is closed.
+ *
+ * \a pStream Pointer to an open stream
+ * \a pFileSize Pointer where to store the size of the mapped view
+ */
+LPBYTE FileStream_GetMappedView(TFileStream * pStream, ULONGLONG * pFileSize)
+{
+    // Block-oriented providers and bitmaps don't map the stream 1:1 to the file
+    if(pStream->BaseRead != BaseMap_Read || (pStream->dwFlags & (STREAM_PROVIDER_MASK | STREAM_FLAG_USE_BITMAP)) != STREAM_PROVIDER_FLAT)
+        return NULL;
+
+    *pFileSize = pStream->Base.Map.FileSize;
+    return pStream->Base.Map.pbFile;
+}
+
 /**
  * Switches a stream with another. Used for final phase of archive compacting.
  * Performs these steps:
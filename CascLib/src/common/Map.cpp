@@ -12,20 +12,34 @@
 #include "../CascLib.h"
 #include "../CascCommon.h"
 
+//-----------------------------------------------------------------------------
+// Local defines
+
+#define MAP_MIN_TABLE_SIZE  0x10                // Smallest size of the hash table
+
 //-----------------------------------------------------------------------------
 // Local functions
 
+static size_t GetNearestPowerOfTwo(size_t MaxItems)
+{
+    size_t PowerOfTwo = MAP_MIN_TABLE_SIZE;
+
+    while(PowerOfTwo < MaxItems)
+        PowerOfTwo <<= 1;
+    return PowerOfTwo;
+}
+
 static DWORD CalcHashIndex_Key(PCASC_MAP pMap, void * pvKey)
 {
-    LPBYTE pbKey = (LPBYTE)pvKey;
-    DWORD dwHash = 0x7EEE7EEE;
+    ULONGLONG KeyValue = 0;
 
-    // Construct the hash from the key
-    for(DWORD i = 0; i < pMap->KeyLength; i++)
-        dwHash = (dwHash >> 24) ^ (dwHash << 5) ^ dwHash ^ pbKey[i];
+    // The keys are either MD5-based (CKey, EKey, name hash) or small integers (data ID).
+    // Load up to 8 bytes of the key at once and spread them by a multiplicative hash
+    memcpy(&KeyValue, pvKey, pMap->KeyLength);
+    KeyValue *= 0x9E3779B97F4A7C15ULL;
 
     // Return the hash limited by the table size
-    return (dwHash % pMap->TableSize);
+    return (DWORD)(KeyValue >> 32) & (DWORD)(pMap->TableSize - 1);
 }
 
 static DWORD CalcHashIndex_String(PCASC_MAP pMap, const char * szString, const char * szStringEnd)
@@ -41,8 +55,11 @@ static DWORD CalcHashIndex_String(PCASC_MAP pMap, const char * szString, const c
         pbKey++;
     }
 
-    // Return the hash limited by the table size
-    return (dwHash % pMap->TableSize);
+    // Mix the upper bits down, then limit the hash by the table size
+    dwHash ^= dwHash >> 16;
+    dwHash *= 0x85EBCA6B;
+    dwHash ^= dwHash >> 13;
+    return (dwHash & (DWORD)(pMap->TableSize - 1));
 }
 
 static bool CompareObject_Key(PCASC_MAP pMap, void * pvObject, void * pvKey)
@@ -83,8 +100,9 @@ PCASC_MAP Map_Create(size_t MaxItems, size_t KeyLength, size_t KeyOffset)
     size_t cbToAllocate;
     size_t TableSize;
 
-    // Calculate the size of the table
-    TableSize = (MaxItems * 3 / 2) | 0x01;
+    // Calculate the size of the table. Keep the load factor at most 2/3
+    // and the size a power of two, so the probing doesn't need a division
+    TableSize = GetNearestPowerOfTwo(MaxItems * 3 / 2);
     KeyLength = CASCLIB_MIN(KeyLength, 8);
 
     // Allocate new map for the objects
@@ -149,7 +167,7 @@ void * Map_FindObject(PCASC_MAP pMap, void * pvKey, PDWORD PtrIndex)
             }
 
             // Move to the next entry
-            dwHashIndex = (dwHashIndex + 1) % pMap->TableSize;
+            dwHashIndex = (dwHashIndex + 1) & (DWORD)(pMap->TableSize - 1);
         }
     }
 
@@ -181,7 +199,7 @@ bool Map_InsertObject(PCASC_MAP pMap, void * pvNewObject, void * pvKey)
                 return false;
 
             // Move to the next entry
-            dwHashIndex = (dwHashIndex + 1) % pMap->TableSize;
+            dwHashIndex = (dwHashIndex + 1) & (DWORD)(pMap->TableSize - 1);
         }
 
         // Insert at that position
@@ -225,7 +243,7 @@ bool Map_InsertString(PCASC_MAP pMap, const char * szString, bool bCutExtension)
                 return false;
 
             // Move to the next entry
-            dwHashIndex = (dwHashIndex + 1) % pMap->TableSize;
+            dwHashIndex = (dwHashIndex + 1) & (DWORD)(pMap->TableSize - 1);
         }
 
         // Insert at that position
@@ -258,7 +276,7 @@ const char * Map_FindString(PCASC_MAP pMap, const char * szString, const char *
                 return szExistingString;
 
             // Move to the next entry
-            dwHashIndex = (dwHashIndex + 1) % pMap->TableSize;
+            dwHashIndex = (dwHashIndex + 1) & (DWORD)(pMap->TableSize - 1);
         }
     }
 
@@ -32,6 +32,10 @@
 #include <dirent.h>
 #endif
 
+#ifndef PLATFORM_WINDOWS
+#include <sys/time.h>
+#endif
+
 //------------------------------------------------------------------------------
 // Defines
 
@@ -330,6 +334,327 @@ static int ExtractFile(
     return nError;
 }
 
+//-----------------------------------------------------------------------------
+// Synthetic storage. Writes a minimal Warcraft III-like storage with a large
+// number of files, so that CascOpenStorage can be timed without a game install.
+
+#define SYNTHETIC_CKEY_PAGE_SIZE    0x1000      // Size of one CKey page in the ENCODING file
+#define SYNTHETIC_HEADER_SPAN       0x1E        // Size of the header span before "BLTE"
+#define SYNTHETIC_CONTENT_SIZE      0x100       // Fake content size of the generated files
+
+typedef struct _SYNTHETIC_FILE
+{
+    BYTE CKey[MD5_HASH_SIZE];                   // Content key of the file
+    BYTE EKey[MD5_HASH_SIZE];                   // Encoded key of the file
+    DWORD ContentSize;                          // Size of the file content
+    DWORD StorageOffset;                        // Offset of the encoded file in data.000
+    DWORD EncodedSize;                          // Size of the encoded file, including the header span
+} SYNTHETIC_FILE, *PSYNTHETIC_FILE;
+
+static DWORD dwRandomSeed;
+
+static DWORD GetMilliseconds()
+{
+#ifdef PLATFORM_WINDOWS
+    return GetTickCount();
+#else
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (DWORD)(tv.tv_sec * 1000 + tv.tv_usec / 1000);
+#endif
+}
+
+static void FillRandomKey(LPBYTE pbKey)
+{
+    // Xorshift; we want the same storage on every run
+    for(size_t i = 0; i < MD5_HASH_SIZE; i++)
+    {
+        dwRandomSeed ^= dwRandomSeed << 13;
+        dwRandomSeed ^= dwRandomSeed >> 17;
+        dwRandomSeed ^= dwRandomSeed << 5;
+        pbKey[i] = (BYTE)(dwRandomSeed >> 24);
+    }
+}
+
+static void CalculateMD5(LPBYTE pbData, size_t cbData, LPBYTE md5_digest)
+{
+    hash_state md5_state;
+
+    md5_init(&md5_state);
+    md5_process(&md5_state, pbData, (unsigned long)cbData);
+    md5_done(&md5_state, md5_digest);
+}
+
+// The bucket (index file) of an EKey is the XOR of its bytes, folded to 4 bits
+static DWORD GetBucketIndex(LPBYTE pbEKey)
+{
+    BYTE HashValue = 0;
+
+    for(size_t i = 0; i < CASC_EKEY_SIZE; i++)
+        HashValue ^= pbEKey[i];
+    return (HashValue & 0x0F) ^ (HashValue >> 0x04);
+}
+
+static int WriteSyntheticFile(const TCHAR * szStorage, const char * szFileName, const void * pvData, size_t cbData)
+{
+    TFileStream * pStream;
+    TCHAR * szFullPath;
+    int nError = ERROR_NOT_ENOUGH_MEMORY;
+
+    szFullPath = CombinePathAndString(szStorage, szFileName, strlen(szFileName));
+    if(szFullPath != NULL)
+    {
+        ForceCreatePath(szFullPath);
+        pStream = FileStream_CreateFile(szFullPath, 0);
+        if(pStream != NULL)
+        {
+            nError = FileStream_Write(pStream, NULL, pvData, (DWORD)cbData) ? ERROR_SUCCESS : GetLastError();
+            FileStream_Close(pStream);
+        }
+        else
+            nError = GetLastError();
+        CASC_FREE(szFullPath);
+    }
+
+    return nError;
+}
+
+// Encodes the file as the header span, BLTE header with no frame table and one uncompressed frame
+static DWORD EncodeSyntheticFile(PSYNTHETIC_FILE pFile, LPBYTE pbBuffer, LPBYTE pbContent, DWORD StorageOffset)
+{
+    DWORD EncodedSize = SYNTHETIC_HEADER_SPAN + 8 + 1 + pFile->ContentSize;
+
+    // Header span: byte-reversed EKey, encoded size, two flags, Jenkins hash and checksum
+    memset(pbBuffer, 0, SYNTHETIC_HEADER_SPAN);
+    for(size_t i = 0; i < MD5_HASH_SIZE; i++)
+        pbBuffer[i] = pFile->EKey[MD5_HASH_SIZE - 1 - i];
+    ConvertIntegerToBytes_4_LE(EncodedSize, pbBuffer + 0x10);
+    ConvertIntegerToBytes_4_LE(hashlittle(pbBuffer, 0x16, 0x3D6BE971), pbBuffer + 0x16);
+
+    // BLTE header with zero header size, followed by the plain frame
+    memcpy(pbBuffer + SYNTHETIC_HEADER_SPAN, "BLTE", 4);
+    ConvertIntegerToBytes_4(0, pbBuffer + SYNTHETIC_HEADER_SPAN + 4);
+    pbBuffer[SYNTHETIC_HEADER_SPAN + 8] = 'N';
+    memcpy(pbBuffer + SYNTHETIC_HEADER_SPAN + 9, pbContent, pFile->ContentSize);
+
+    pFile->StorageOffset = StorageOffset;
+    pFile->EncodedSize = EncodedSize;
+    return EncodedSize;
+}
+
+static int WriteSyntheticIndexFile(const TCHAR * szStorage, DWORD BucketIndex, PSYNTHETIC_FILE pFiles, DWORD dwFileCount)
+{
+    unsigned int HashHigh = 0;
+    unsigned int HashLow = 0;
+    LPBYTE pbIndexFile;
+    LPBYTE pbEntry;
+    DWORD dwEntries = 0;
+    DWORD cbIndexFile;
+    char szFileName[0x40];
+    int nError;
+
+    // Count the EKeys that fall into this bucket
+    for(DWORD i = 0; i < dwFileCount; i++)
+        dwEntries += (GetBucketIndex(pFiles[i].EKey) == BucketIndex) ? 1 : 0;
+
+    // Index header (0x20 bytes) and the block of EKey entries (0x12 bytes each)
+    cbIndexFile = 0x28 + dwEntries * 0x12;
+    pbIndexFile = CASC_ALLOC(BYTE, cbIndexFile);
+    if(pbIndexFile == NULL)
+        return ERROR_NOT_ENOUGH_MEMORY;
+    memset(pbIndexFile, 0, cbIndexFile);
+
+    // Index header: version 7, 4-byte sizes, 5-byte offsets, 9-byte keys, 30 bits of offset
+    ConvertIntegerToBytes_4_LE(0x10, pbIndexFile + 0x00);
+    pbIndexFile[0x08] = 0x07;
+    pbIndexFile[0x0A] = (BYTE)BucketIndex;
+    pbIndexFile[0x0C] = 0x04;
+    pbIndexFile[0x0D] = 0x05;
+    pbIndexFile[0x0E] = CASC_EKEY_SIZE;
+    pbIndexFile[0x0F] = 0x1E;
+    ConvertIntegerToBytes_4_LE(0x40000000, pbIndexFile + 0x10);
+    ConvertIntegerToBytes_4_LE(hashlittle(pbIndexFile + 0x08, 0x10, 0), pbIndexFile + 0x04);
+
+    // EKey entries. Archive index is always zero, so the 5-byte offset is the plain offset
+    pbEntry = pbIndexFile + 0x28;
+    for(DWORD i = 0; i < dwFileCount; i++)
+    {
+        if(GetBucketIndex(pFiles[i].EKey) == BucketIndex)
+        {
+            memcpy(pbEntry, pFiles[i].EKey, CASC_EKEY_SIZE);
+            ConvertIntegerToBytes_4(pFiles[i].StorageOffset, pbEntry + CASC_EKEY_SIZE + 1);
+            ConvertIntegerToBytes_4_LE(pFiles[i].EncodedSize, pbEntry + CASC_EKEY_SIZE + 5);
+            hashlittle2(pbEntry, 0x12, &HashHigh, &HashLow);
+            pbEntry += 0x12;
+        }
+    }
+    ConvertIntegerToBytes_4_LE(dwEntries * 0x12, pbIndexFile + 0x20);
+    ConvertIntegerToBytes_4_LE(HashHigh, pbIndexFile + 0x24);
+
+    sprintf(szFileName, "Data/data/%02x%08x.idx", BucketIndex, 1);
+    nError = WriteSyntheticFile(szStorage, szFileName, pbIndexFile, cbIndexFile);
+    CASC_FREE(pbIndexFile);
+    return nError;
+}
+
+static LPBYTE CreateSyntheticEncoding(PSYNTHETIC_FILE pFiles, DWORD dwFileCount, DWORD * pcbEncoding)
+{
+    LPBYTE pbEncoding;
+    LPBYTE pbPageHeader;
+    LPBYTE pbPage;
+    DWORD dwEntriesPerPage = (SYNTHETIC_CKEY_PAGE_SIZE - sizeof(USHORT)) / sizeof(CASC_CKEY_ENTRY);
+    DWORD dwPageCount = (dwFileCount + dwEntriesPerPage - 1) / dwEntriesPerPage;
+    DWORD cbEncoding = 0x16 + dwPageCount * (0x20 + SYNTHETIC_CKEY_PAGE_SIZE);
+
+    pbEncoding = CASC_ALLOC(BYTE, cbEncoding);
+    if(pbEncoding != NULL)
+    {
+        // ENCODING header: no ESpec block and no EKey pages
+        memset(pbEncoding, 0, cbEncoding);
+        pbEncoding[0x00] = 'E';
+        pbEncoding[0x01] = 'N';
+        pbEncoding[0x02] = 0x01;
+        pbEncoding[0x03] = MD5_HASH_SIZE;
+        pbEncoding[0x04] = MD5_HASH_SIZE;
+        pbEncoding[0x06] = (BYTE)(SYNTHETIC_CKEY_PAGE_SIZE / 1024);
+        pbEncoding[0x08] = (BYTE)(SYNTHETIC_CKEY_PAGE_SIZE / 1024);
+        ConvertIntegerToBytes_4(dwPageCount, pbEncoding + 0x09);
+
+        // Page headers are followed by the pages themselves
+        pbPageHeader = pbEncoding + 0x16;
+        pbPage = pbPageHeader + dwPageCount * 0x20;
+        for(DWORD i = 0; i < dwFileCount; i++)
+        {
+            PCASC_CKEY_ENTRY pCKeyEntry = (PCASC_CKEY_ENTRY)(pbPage + (i % dwEntriesPerPage) * sizeof(CASC_CKEY_ENTRY));
+
+            pCKeyEntry->EKeyCount = 1;
+            ConvertIntegerToBytes_4(pFiles[i].ContentSize, pCKeyEntry->ContentSize);
+            memcpy(pCKeyEntry->CKey, pFiles[i].CKey, MD5_HASH_SIZE);
+            memcpy(pCKeyEntry->EKey, pFiles[i].EKey, MD5_HASH_SIZE);
+
+            // The first CKey of the page goes to the page header
+            if((i % dwEntriesPerPage) == 0)
+            {
+                memcpy(pbPageHeader, pFiles[i].CKey, MD5_HASH_SIZE);
+                pbPageHeader += 0x20;
+            }
+
+            // Move to the next page
+            if((i % dwEntriesPerPage) == dwEntriesPerPage - 1)
+                pbPage += SYNTHETIC_CKEY_PAGE_SIZE;
+        }
+    }
+
+    pcbEncoding[0] = cbEncoding;
+    return pbEncoding;
+}
+
+static int CreateSyntheticStorage(const TCHAR * szStorage, DWORD dwFileCount)
+{
+    PSYNTHETIC_FILE pFiles;
+    PSYNTHETIC_FILE pRootFile;
+    PSYNTHETIC_FILE pEncodingFile;
+    LPBYTE pbEncoding = NULL;
+    LPBYTE pbDataFile = NULL;
+    char * szRootFile = NULL;
+    char szBuildConfig[0x200];
+    char szBuildInfo[0x200];
+    char szFileName[0x80];
+    char szKey1[MD5_STRING_SIZE + 1];
+    char szKey2[MD5_STRING_SIZE + 1];
+    BYTE BuildKey[MD5_HASH_SIZE];
+    BYTE CdnKey[MD5_HASH_SIZE];
+    DWORD cbEncoding = 0;
+    DWORD cbRootFile = 0;
+    DWORD cbDataFile = 0;
+    int nError = ERROR_NOT_ENOUGH_MEMORY;
+
+    // Files, then ROOT and ENCODING
+    pFiles = CASC_ALLOC(SYNTHETIC_FILE, dwFileCount + 2);
+    szRootFile = CASC_ALLOC(char, dwFileCount * 0x40);
+    if(pFiles != NULL && szRootFile != NULL)
+    {
+        pRootFile = pFiles + dwFileCount;
+        pEncodingFile = pRootFile + 1;
+        dwRandomSeed = 0x5EED1234;
+
+        // Regular files. Their data is never read, so they all point to the start of data.000
+        for(DWORD i = 0; i < dwFileCount; i++)
+        {
+            FillRandomKey(pFiles[i].CKey);
+            FillRandomKey(pFiles[i].EKey);
+            pFiles[i].ContentSize = SYNTHETIC_CONTENT_SIZE;
+            pFiles[i].StorageOffset = 0;
+            pFiles[i].EncodedSize = SYNTHETIC_HEADER_SPAN + 8 + 1 + SYNTHETIC_CONTENT_SIZE;
+
+            StringFromBinary(pFiles[i].CKey, MD5_HASH_SIZE, szKey1);
+            cbRootFile += sprintf(szRootFile + cbRootFile, "synthetic/file%06u.dat|%s\n", i, szKey1);
+        }
+
+        // The ROOT file is a Starcraft I-like text listfile
+        CalculateMD5((LPBYTE)szRootFile, cbRootFile, pRootFile->CKey);
+        FillRandomKey(pRootFile->EKey);
+        pRootFile->ContentSize = cbRootFile;
+
+        // The ENCODING file covers all files including ROOT
+        pbEncoding = CreateSyntheticEncoding(pFiles, dwFileCount + 1, &cbEncoding);
+        if(pbEncoding != NULL)
+        {
+            CalculateMD5(pbEncoding, cbEncoding, pEncodingFile->CKey);
+            FillRandomKey(pEncodingFile->EKey);
+            pEncodingFile->ContentSize = cbEncoding;
+
+            // data.000 contains just the encoded ROOT and ENCODING
+            pbDataFile = CASC_ALLOC(BYTE, 2 * (SYNTHETIC_HEADER_SPAN + 9) + cbRootFile + cbEncoding);
+            if(pbDataFile != NULL)
+            {
+                cbDataFile += EncodeSyntheticFile(pRootFile, pbDataFile, (LPBYTE)szRootFile, cbDataFile);
+                cbDataFile += EncodeSyntheticFile(pEncodingFile, pbDataFile + cbDataFile, pbEncoding, cbDataFile);
+                nError = WriteSyntheticFile(szStorage, "Data/data/data.000", pbDataFile, cbDataFile);
+            }
+        }
+
+        // Index files
+        for(DWORD i = 0; i < CASC_INDEX_COUNT && nError == ERROR_SUCCESS; i++)
+        {
+            nError = WriteSyntheticIndexFile(szStorage, i, pFiles, dwFileCount + 2);
+        }
+
+        // Build config. Its name is the MD5 of its content
+        if(nError == ERROR_SUCCESS)
+        {
+            StringFromBinary(pRootFile->CKey, MD5_HASH_SIZE, szKey1);
+            sprintf(szBuildConfig, "# Build Configuration\n\nroot = %s\n", szKey1);
+
+            StringFromBinary(pEncodingFile->CKey, MD5_HASH_SIZE, szKey1);
+            StringFromBinary(pEncodingFile->EKey, MD5_HASH_SIZE, szKey2);
+            sprintf(szBuildConfig + strlen(szBuildConfig), "encoding = %s %s\nencoding-size = %u %u\nbuild-name = WAR3-12345\nbuild-product = War3\n",
+                                                           szKey1, szKey2, cbEncoding, pEncodingFile->EncodedSize);
+
+            CalculateMD5((LPBYTE)szBuildConfig, strlen(szBuildConfig), BuildKey);
+            StringFromBinary(BuildKey, MD5_HASH_SIZE, szKey1);
+            sprintf(szFileName, "Data/config/%02x/%02x/%s", BuildKey[0], BuildKey[1], szKey1);
+            nError = WriteSyntheticFile(szStorage, szFileName, szBuildConfig, strlen(szBuildConfig));
+        }
+
+        // The .build.info refers to the build config. The CDN config does not exist
+        if(nError == ERROR_SUCCESS)
+        {
+            FillRandomKey(CdnKey);
+            StringFromBinary(CdnKey, MD5_HASH_SIZE, szKey2);
+            sprintf(szBuildInfo, "Branch!STRING:0|Active!DEC:1|Build Key!HEX:16|CDN Key!HEX:16|Version!STRING:0\nus|1|%s|%s|1.32.0.12345\n", szKey1, szKey2);
+            nError = WriteSyntheticFile(szStorage, ".build.info", szBuildInfo, strlen(szBuildInfo));
+        }
+    }
+
+    CASC_FREE(pbDataFile);
+    CASC_FREE(pbEncoding);
+    CASC_FREE(szRootFile);
+    CASC_FREE(pFiles);
+    return nError;
+}
+
 //-----------------------------------------------------------------------------
 // Testing functions
 
@@ -552,6 +877,55 @@ static int TestOpenStorage_GetFileDataId(const TCHAR * szStorage, const char * s
     return nError;
 }
 
+static int TestOpenStorage_Synthetic(const TCHAR * szStorage, DWORD dwFileCount, DWORD dwPasses)
+{
+    TLogHelper LogHelper("Synthetic storage");
+    HANDLE hStorage;
+    DWORD dwTotalTime = 0;
+    DWORD dwBestTime = 0xFFFFFFFF;
+    DWORD dwStartTime;
+    DWORD dwElapsed;
+    DWORD dwFileCountFound = 0;
+    int nError;
+
+    // Create the storage with the given number of files
+    LogHelper.PrintProgress("Creating synthetic storage ...");
+    nError = CreateSyntheticStorage(szStorage, dwFileCount);
+    if(nError != ERROR_SUCCESS)
+    {
+        LogHelper.PrintErrorVa("Error: Failed to create synthetic storage");
+        return nError;
+    }
+
+    // Open the storage several times and take the best time
+    for(DWORD i = 0; i < dwPasses; i++)
+    {
+        LogHelper.PrintProgress("Opening storage (pass %u of %u) ...", i + 1, dwPasses);
+        dwStartTime = GetMilliseconds();
+        if(!CascOpenStorage(szStorage, 0, &hStorage))
+        {
+            LogHelper.PrintErrorVa("Error: Failed to open synthetic storage");
+            return GetLastError();
+        }
+        dwElapsed = GetMilliseconds() - dwStartTime;
+
+        // All files, plus ROOT and ENCODING, must be in the EKey map
+        CascGetStorageInfo(hStorage, CascStorageFileCount, &dwFileCountFound, sizeof(DWORD), NULL);
+        CascCloseStorage(hStorage);
+        if(dwFileCountFound != dwFileCount + 2)
+        {
+            LogHelper.PrintMessage("Error: Expected %u files, found %u", dwFileCount + 2, dwFileCountFound);
+            return ERROR_FILE_CORRUPT;
+        }
+
+        dwBestTime = CASCLIB_MIN(dwBestTime, dwElapsed);
+        dwTotalTime += dwElapsed;
+    }
+
+    LogHelper.PrintMessage("Opened storage with %u files: best %u ms, average %u ms", dwFileCount, dwBestTime, dwTotalTime / dwPasses);
+    return ERROR_SUCCESS;
+}
+
 //-----------------------------------------------------------------------------
 // Storage list
 
@@ -619,6 +993,11 @@ int main(int argc, char * argv[])
     // Single tests
     //                                   
 
+    // Time opening of a large synthetic storage
+    nError = TestOpenStorage_Synthetic(_T("casc-synthetic"), 300000, 5);
+    if(nError != ERROR_SUCCESS)
+        return nError;
+
 //  TestOpenStorage_OpenFile("2014 - Heroes of the Storm/29049", "fd45b0f59067a8dda512b740c782cd70");
 //  TestOpenStorage_OpenFile("z:\\47161", "ROOT");
 //  TestOpenStorage_EnumFiles("2016 - WoW/23420", NULL);
@@ -97,11 +97,11 @@ void Compress_ZLIB(void * pvOutBuffer, int * pcbOutBuffer, void * pvInBuffer, in
 {
     z_stream z;                        // Stream information for zlib
     int windowBits;
+    int nLevel;
     int nResult;
 
     // Keep compilers happy
     STORMLIB_UNUSED(pCmpType);
-    STORMLIB_UNUSED(nCmpLevel);
 
     // Fill the stream structure for zlib
     z.next_in   = (Bytef *)pvInBuffer;
@@ -131,11 +131,16 @@ void Compress_ZLIB(void * pvOutBuffer, int * pcbOutBuffer, void * pvInBuffer, in
     else
         windowBits = 15;
 
+    // Z_BEST_COMPRESSION is requested by archives created with MPQ_CREATE_BEST_COMPRESSION.
+    // Any other value (including the ADPCM levels) keeps the level used by WoW MPQs.
+    // The level only affects the encoder; every deflate stream inflates the same way.
+    nLevel = (nCmpLevel == Z_BEST_COMPRESSION) ? Z_BEST_COMPRESSION : 6;
+
     // Initialize the compression.
     // Storm.dll uses zlib version 1.1.3
     // Wow.exe uses zlib version 1.2.3
     nResult = deflateInit2(&z,
-                            6,                  // Compression level used by WoW MPQs
+                            nLevel,
                             Z_DEFLATED,
                             windowBits,
                             8,
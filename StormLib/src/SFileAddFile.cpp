@@ -223,8 +223,12 @@ static int WriteDataToMpqFile(
                         dwCompression = (dwSectorIndex == 0) ? hf->dwCompression0 : dwCompression;
 
                         // If the caller wants ADPCM compression, we will set wave compression level to 4,
-                        // which corresponds to medium quality
-                        nCompressionLevel = (dwCompression & MPQ_LOSSY_COMPRESSION_MASK) ? 4 : -1;
+                        // which corresponds to medium quality. Lossless data in archives created
+                        // with MPQ_CREATE_BEST_COMPRESSION gets the strongest zlib level.
+                        if(dwCompression & MPQ_LOSSY_COMPRESSION_MASK)
+                            nCompressionLevel = 4;
+                        else
+                            nCompressionLevel = (ha->dwFlags & MPQ_FLAG_BEST_COMPRESSION) ? Z_BEST_COMPRESSION : -1;
                         SCompCompress(pbCompressed, &nOutBuffer, hf->pbFileSector, nInBuffer, (unsigned)dwCompression, 0, nCompressionLevel);
                     }
 
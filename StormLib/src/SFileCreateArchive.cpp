@@ -85,6 +85,7 @@ bool WINAPI SFileCreateArchive(const TCHAR * szMpqName, DWORD dwCreateFlags, DWO
     CreateInfo.dwSectorSize   = (CreateInfo.dwMpqVersion >= MPQ_FORMAT_VERSION_3) ? 0x4000 : 0x1000;
     CreateInfo.dwRawChunkSize = (CreateInfo.dwMpqVersion >= MPQ_FORMAT_VERSION_4) ? 0x4000 : 0;
     CreateInfo.dwMaxFileCount = dwMaxFileCount;
+    CreateInfo.dwCreateFlags  = dwCreateFlags & MPQ_CREATE_BEST_COMPRESSION;
 
     // Set the proper attribute parts
     if((CreateInfo.dwMpqVersion >= MPQ_FORMAT_VERSION_3) && (dwCreateFlags & MPQ_CREATE_ATTRIBUTES))
@@ -177,6 +178,13 @@ bool WINAPI SFileCreateArchive2(const TCHAR * szMpqName, PSFILE_CREATE_MPQ pCrea
         dwReservedFiles++;
     }
 
+    // Callers built against an older SFILE_CREATE_MPQ don't have dwCreateFlags
+    if(pCreateInfo->cbSize >= offsetof(SFILE_CREATE_MPQ, dwCreateFlags) + sizeof(DWORD))
+    {
+        if(pCreateInfo->dwCreateFlags & MPQ_CREATE_BEST_COMPRESSION)
+            dwMpqFlags |= MPQ_FLAG_BEST_COMPRESSION;
+    }
+
     // If file count is not zero, initialize the hash table size
     dwHashTableSize = GetNearestPowerOfTwo(pCreateInfo->dwMaxFileCount + dwReservedFiles);
 
@@ -228,6 +228,9 @@ bool WINAPI SFileOpenArchive(
 
         // Also remember if this MPQ is a patch
         ha->dwFlags |= (dwFlags & MPQ_OPEN_PATCH) ? MPQ_FLAG_PATCH : 0;
+
+        // Also remember if we shall decode large reads on multiple threads
+        ha->dwFlags |= (dwFlags & MPQ_OPEN_PARALLEL_DECODE) ? MPQ_FLAG_PARALLEL_DECODE : 0;
        
         // Limit the header searching to about 130 MB of data
         if(EndOfSearch > 0x08000000)
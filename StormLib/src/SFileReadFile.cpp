@@ -13,9 +13,266 @@
 #include "StormLib.h"
 #include "StormCommon.h"
 
+//-----------------------------------------------------------------------------
+// Local structures
+
+#ifndef PLATFORM_WINDOWS
+#include <pthread.h>
+#endif
+
+// Reads that span at least this number of sectors may be decoded in parallel
+#define MIN_PARALLEL_SECTORS    16
+#define MAX_PARALLEL_WORKERS    8
+
+// One worker's share of a parallel sector decode. The sectors are independent
+// of each other, so each worker decodes a contiguous run of them straight
+// into the caller's buffer.
+struct TSectorDecodeJob
+{
+    TMPQFile * hf;                          // The file being read
+    LPBYTE pbOutSector;                     // Target for the first sector of this job
+    LPBYTE pbInSector;                      // Raw data of the first sector of this job
+    DWORD dwSectorIndex;                    // Index of the first sector of this job
+    DWORD dwSectorCount;                    // Number of sectors in this job
+    DWORD dwBytesToRead;                    // Number of decoded bytes from the first sector to the end of the read
+    int nError;                             // Result of the job
+};
+
 //-----------------------------------------------------------------------------
 // Local functions
 
+// Decrypts, verifies and decompresses one sector. The file key must be known.
+//  hf            - MPQ File handle.
+//  pbOutSector   - Target buffer for the decoded sector.
+//  pbInSector    - Raw sector data. Decrypted in place.
+//  dwIndex       - Index of the sector within the file
+static int DecodeMpqSector(TMPQFile * hf, LPBYTE pbOutSector, LPBYTE pbInSector, DWORD dwIndex, DWORD dwRawBytesInThisSector, DWORD dwBytesInThisSector)
+{
+    TMPQArchive * ha = hf->ha;
+    TFileEntry * pFileEntry = hf->pFileEntry;
+
+    // If the file is encrypted, we have to decrypt the sector
+    if(pFileEntry->dwFlags & MPQ_FILE_ENCRYPTED)
+    {
+        BSWAP_ARRAY32_UNSIGNED(pbInSector, dwRawBytesInThisSector);
+        DecryptMpqBlock(pbInSector, dwRawBytesInThisSector, hf->dwFileKey + dwIndex);
+        BSWAP_ARRAY32_UNSIGNED(pbInSector, dwRawBytesInThisSector);
+    }
+
+    // If the file has sector CRC check turned on, perform it
+    if(hf->bCheckSectorCRCs && hf->SectorChksums != NULL)
+    {
+        DWORD dwAdlerExpected = hf->SectorChksums[dwIndex];
+        DWORD dwAdlerValue = 0;
+
+        // We can only check sector CRC when it's not zero
+        // Neither can we check it if it's 0xFFFFFFFF.
+        if(dwAdlerExpected != 0 && dwAdlerExpected != 0xFFFFFFFF)
+        {
+            dwAdlerValue = adler32(0, pbInSector, dwRawBytesInThisSector);
+            if(dwAdlerValue != dwAdlerExpected)
+                return ERROR_CHECKSUM_ERROR;
+        }
+    }
+
+    // If the sector is really compressed, decompress it.
+    // WARNING : Some sectors may not be compressed, it can be determined only
+    // by comparing uncompressed and compressed size !!!
+    if(dwRawBytesInThisSector < dwBytesInThisSector)
+    {
+        int cbOutSector = dwBytesInThisSector;
+        int cbInSector = dwRawBytesInThisSector;
+        int nResult = 0;
+
+        // Is the file compressed by Blizzard's multiple compression ?
+        if(pFileEntry->dwFlags & MPQ_FILE_COMPRESS)
+        {
+            // Decompress the data
+            if(ha->pHeader->wFormatVersion >= MPQ_FORMAT_VERSION_2)
+                nResult = SCompDecompress2(pbOutSector, &cbOutSector, pbInSector, cbInSector);
+            else
+                nResult = SCompDecompress(pbOutSector, &cbOutSector, pbInSector, cbInSector);
+        }
+
+        // Is the file compressed by PKWARE Data Compression Library ?
+        else if(pFileEntry->dwFlags & MPQ_FILE_IMPLODE)
+        {
+            nResult = SCompExplode(pbOutSector, &cbOutSector, pbInSector, cbInSector);
+        }
+
+        // Did the decompression fail ?
+        if(nResult == 0)
+            return ERROR_FILE_CORRUPT;
+    }
+    else
+    {
+        if(pbOutSector != pbInSector)
+            memcpy(pbOutSector, pbInSector, dwBytesInThisSector);
+    }
+
+    return ERROR_SUCCESS;
+}
+
+// Decodes a run of sectors of a compressed file. Used by the parallel decoder.
+static void DecodeMpqSectorRun(TSectorDecodeJob * pJob)
+{
+    TMPQFile * hf = pJob->hf;
+    LPBYTE pbOutSector = pJob->pbOutSector;
+    LPBYTE pbInSector = pJob->pbInSector;
+    DWORD dwSectorSize = hf->ha->dwSectorSize;
+    DWORD dwBytesToRead = pJob->dwBytesToRead;
+
+    for(DWORD i = 0; i < pJob->dwSectorCount; i++)
+    {
+        DWORD dwIndex = pJob->dwSectorIndex + i;
+        DWORD dwRawBytesInThisSector = hf->SectorOffsets[dwIndex + 1] - hf->SectorOffsets[dwIndex];
+        DWORD dwBytesInThisSector = (dwBytesToRead < dwSectorSize) ? dwBytesToRead : dwSectorSize;
+
+        pJob->nError = DecodeMpqSector(hf, pbOutSector, pbInSector, dwIndex, dwRawBytesInThisSector, dwBytesInThisSector);
+        if(pJob->nError != ERROR_SUCCESS)
+            break;
+
+        dwBytesToRead -= dwBytesInThisSector;
+        pbOutSector += dwBytesInThisSector;
+        pbInSector += dwRawBytesInThisSector;
+    }
+}
+
+#ifdef PLATFORM_WINDOWS
+static DWORD WINAPI SectorDecodeWorker(LPVOID lpParameter)
+{
+    DecodeMpqSectorRun((TSectorDecodeJob *)lpParameter);
+    return 0;
+}
+#else
+static void * SectorDecodeWorker(void * lpParameter)
+{
+    DecodeMpqSectorRun((TSectorDecodeJob *)lpParameter);
+    return NULL;
+}
+#endif
+
+static DWORD GetSectorDecodeWorkerCount()
+{
+    DWORD dwProcessors = 1;
+
+#ifdef PLATFORM_WINDOWS
+    SYSTEM_INFO SystemInfo;
+
+    GetSystemInfo(&SystemInfo);
+    dwProcessors = SystemInfo.dwNumberOfProcessors;
+#else
+    long nProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if(nProcessors > 0)
+        dwProcessors = (DWORD)nProcessors;
+#endif
+
+    return (dwProcessors > MAX_PARALLEL_WORKERS) ? MAX_PARALLEL_WORKERS : dwProcessors;
+}
+
+//  hf            - MPQ File handle.
+//  pbBuffer      - Target buffer for the decoded sectors.
+//  pbRawSectors  - Raw data of all sectors, as loaded from the file.
+//  dwSectorIndex - Index of the first sector
+//  dwSectorsToRead - Number of sectors. Must be at least MIN_PARALLEL_SECTORS.
+//  dwBytesToRead - Number of decoded bytes
+//
+// The sectors are split into contiguous runs, one per worker. The calling
+// thread decodes the first run itself. If a worker thread can't be created,
+// its run is decoded by the calling thread as well.
+static int DecodeMpqSectorsParallel(TMPQFile * hf, LPBYTE pbBuffer, LPBYTE pbRawSectors, DWORD dwSectorIndex, DWORD dwSectorsToRead, DWORD dwBytesToRead)
+{
+    TSectorDecodeJob Jobs[MAX_PARALLEL_WORKERS];
+#ifdef PLATFORM_WINDOWS
+    HANDLE Threads[MAX_PARALLEL_WORKERS];
+#else
+    pthread_t Threads[MAX_PARALLEL_WORKERS];
+#endif
+    bool bThreadStarted[MAX_PARALLEL_WORKERS];
+    DWORD dwSectorSize = hf->ha->dwSectorSize;
+    DWORD dwWorkers = GetSectorDecodeWorkerCount();
+    DWORD dwFirstSector = 0;
+    int nError = ERROR_SUCCESS;
+
+    // Don't give a worker less than a few sectors
+    if(dwWorkers > dwSectorsToRead / (MIN_PARALLEL_SECTORS / 4))
+        dwWorkers = dwSectorsToRead / (MIN_PARALLEL_SECTORS / 4);
+
+    // Prepare the jobs
+    for(DWORD i = 0; i < dwWorkers; i++)
+    {
+        DWORD dwSectorCount = (dwSectorsToRead / dwWorkers) + ((i < dwSectorsToRead % dwWorkers) ? 1 : 0);
+
+        Jobs[i].hf = hf;
+        Jobs[i].pbOutSector = pbBuffer + (dwFirstSector * dwSectorSize);
+        Jobs[i].pbInSector = pbRawSectors + (hf->SectorOffsets[dwSectorIndex + dwFirstSector] - hf->SectorOffsets[dwSectorIndex]);
+        Jobs[i].dwSectorIndex = dwSectorIndex + dwFirstSector;
+        Jobs[i].dwSectorCount = dwSectorCount;
+        Jobs[i].dwBytesToRead = dwBytesToRead - (dwFirstSector * dwSectorSize);
+        Jobs[i].nError = ERROR_SUCCESS;
+        dwFirstSector += dwSectorCount;
+    }
+
+    // Start the worker threads
+    for(DWORD i = 1; i < dwWorkers; i++)
+    {
+#ifdef PLATFORM_WINDOWS
+        Threads[i] = CreateThread(NULL, 0, SectorDecodeWorker, &Jobs[i], 0, NULL);
+        bThreadStarted[i] = (Threads[i] != NULL);
+#else
+        bThreadStarted[i] = (pthread_create(&Threads[i], NULL, SectorDecodeWorker, &Jobs[i]) == 0);
+#endif
+    }
+
+    // Decode our own share, and the share of the workers that failed to start
+    DecodeMpqSectorRun(&Jobs[0]);
+    for(DWORD i = 1; i < dwWorkers; i++)
+    {
+        if(bThreadStarted[i] == false)
+            DecodeMpqSectorRun(&Jobs[i]);
+    }
+
+    // Wait for the workers and pick the first error
+    for(DWORD i = 0; i < dwWorkers; i++)
+    {
+        if(i > 0 && bThreadStarted[i])
+        {
+#ifdef PLATFORM_WINDOWS
+            WaitForSingleObject(Threads[i], INFINITE);
+            CloseHandle(Threads[i]);
+#else
+            pthread_join(Threads[i], NULL);
+#endif
+        }
+
+        if(nError == ERROR_SUCCESS)
+            nError = Jobs[i].nError;
+    }
+
+    // Remember the last used compression
+    if(nError == ERROR_SUCCESS && (hf->pFileEntry->dwFlags & MPQ_FILE_COMPRESS))
+    {
+        for(DWORD i = dwSectorsToRead; i > 0; i--)
+        {
+            DWORD dwIndex = dwSectorIndex + i - 1;
+            DWORD dwRawBytesInThisSector = hf->SectorOffsets[dwIndex + 1] - hf->SectorOffsets[dwIndex];
+            DWORD dwBytesInThisSector = dwBytesToRead - ((i - 1) * dwSectorSize);
+
+            if(dwBytesInThisSector > dwSectorSize)
+                dwBytesInThisSector = dwSectorSize;
+            if(dwRawBytesInThisSector < dwBytesInThisSector)
+            {
+                hf->dwCompression0 = pbRawSectors[hf->SectorOffsets[dwIndex] - hf->SectorOffsets[dwSectorIndex]];
+                break;
+            }
+        }
+    }
+
+    return nError;
+}
+
+
 //  hf            - MPQ File handle.
 //  pbBuffer      - Pointer to target buffer to store sectors.
 //  dwByteOffset  - Position of sector in the file (relative to file begin)
@@ -97,111 +354,66 @@ static int ReadMpqSectors(TMPQFile * hf, LPBYTE pbBuffer, DWORD dwByteOffset, DW
     // Set file pointer and read all required sectors
     if(FileStream_Read(ha->pStream, &RawFilePos, pbInSector, dwRawBytesToRead))
     {
-        // Now we have to decrypt and decompress all file sectors that have been loaded
-        for(DWORD i = 0; i < dwSectorsToRead; i++)
+        // If the file key has to be detected, do it on the first sector
+        if((pFileEntry->dwFlags & MPQ_FILE_ENCRYPTED) && hf->dwFileKey == 0 && dwSectorsToRead > 0)
         {
-            DWORD dwRawBytesInThisSector = ha->dwSectorSize;
-            DWORD dwBytesInThisSector = ha->dwSectorSize;
-            DWORD dwIndex = dwSectorIndex + i;
-
-            // If there is not enough bytes in the last sector,
-            // cut the number of bytes in this sector
-            if(dwRawBytesInThisSector > dwBytesToRead)
-                dwRawBytesInThisSector = dwBytesToRead;
-            if(dwBytesInThisSector > dwBytesToRead)
-                dwBytesInThisSector = dwBytesToRead;
-
-            // If the file is compressed, we have to adjust the raw sector size
-            if(pFileEntry->dwFlags & MPQ_FILE_COMPRESS_MASK)
-                dwRawBytesInThisSector = hf->SectorOffsets[dwIndex + 1] - hf->SectorOffsets[dwIndex];
-
-            // If the file is encrypted, we have to decrypt the sector
-            if(pFileEntry->dwFlags & MPQ_FILE_ENCRYPTED)
-            {
-                BSWAP_ARRAY32_UNSIGNED(pbInSector, dwRawBytesInThisSector);
-
-                // If we don't know the key, try to detect it by file content
-                if(hf->dwFileKey == 0)
-                {
-                    hf->dwFileKey = DetectFileKeyByContent(pbInSector, dwBytesInThisSector, hf->dwDataSize);
-                    if(hf->dwFileKey == 0)
-                    {
-                        nError = ERROR_UNKNOWN_FILE_KEY;
-                        break;
-                    }
-                }
-
-                DecryptMpqBlock(pbInSector, dwRawBytesInThisSector, hf->dwFileKey + dwIndex);
-                BSWAP_ARRAY32_UNSIGNED(pbInSector, dwRawBytesInThisSector);
-            }
+            DWORD dwBytesInThisSector = (dwBytesToRead < ha->dwSectorSize) ? dwBytesToRead : ha->dwSectorSize;
+
+            BSWAP_ARRAY32_UNSIGNED(pbInSector, dwBytesInThisSector);
+            hf->dwFileKey = DetectFileKeyByContent(pbInSector, dwBytesInThisSector, hf->dwDataSize);
+            BSWAP_ARRAY32_UNSIGNED(pbInSector, dwBytesInThisSector);
+
+            if(hf->dwFileKey == 0)
+                nError = ERROR_UNKNOWN_FILE_KEY;
+        }
 
-            // If the file has sector CRC check turned on, perform it
-            if(hf->bCheckSectorCRCs && hf->SectorChksums != NULL)
+        // Large reads of compressed files can have their sectors decoded in parallel
+        if(nError == ERROR_SUCCESS && (ha->dwFlags & MPQ_FLAG_PARALLEL_DECODE) && (pFileEntry->dwFlags & MPQ_FILE_COMPRESS_MASK) && dwSectorsToRead >= MIN_PARALLEL_SECTORS)
+        {
+            nError = DecodeMpqSectorsParallel(hf, pbOutSector, pbInSector, dwSectorIndex, dwSectorsToRead, dwBytesToRead);
+            if(nError == ERROR_SUCCESS)
             {
-                DWORD dwAdlerExpected = hf->SectorChksums[dwIndex];
-                DWORD dwAdlerValue = 0;
-
-                // We can only check sector CRC when it's not zero
-                // Neither can we check it if it's 0xFFFFFFFF.
-                if(dwAdlerExpected != 0 && dwAdlerExpected != 0xFFFFFFFF)
-                {
-                    dwAdlerValue = adler32(0, pbInSector, dwRawBytesInThisSector);
-                    if(dwAdlerValue != dwAdlerExpected)
-                    {
-                        nError = ERROR_CHECKSUM_ERROR;
-                        break;
-                    }
-                }
+                dwBytesRead = dwBytesToRead;
+                dwSectorsDone = dwSectorsToRead;
             }
-
-            // If the sector is really compressed, decompress it.
-            // WARNING : Some sectors may not be compressed, it can be determined only
-            // by comparing uncompressed and compressed size !!!
-            if(dwRawBytesInThisSector < dwBytesInThisSector)
+        }
+        else if(nError == ERROR_SUCCESS)
+        {
+            // Now we have to decrypt and decompress all file sectors that have been loaded
+            for(DWORD i = 0; i < dwSectorsToRead; i++)
             {
-                int cbOutSector = dwBytesInThisSector;
-                int cbInSector = dwRawBytesInThisSector;
-                int nResult = 0;
-
-                // Is the file compressed by Blizzard's multiple compression ?
-                if(pFileEntry->dwFlags & MPQ_FILE_COMPRESS)
-                {
-                    // Remember the last used compression
+                DWORD dwRawBytesInThisSector = ha->dwSectorSize;
+                DWORD dwBytesInThisSector = ha->dwSectorSize;
+                DWORD dwIndex = dwSectorIndex + i;
+
+                // If there is not enough bytes in the last sector,
+                // cut the number of bytes in this sector
+                if(dwRawBytesInThisSector > dwBytesToRead)
+                    dwRawBytesInThisSector = dwBytesToRead;
+                if(dwBytesInThisSector > dwBytesToRead)
+                    dwBytesInThisSector = dwBytesToRead;
+
+                // If the file is compressed, we have to adjust the raw sector size
+                if(pFileEntry->dwFlags & MPQ_FILE_COMPRESS_MASK)
+                    dwRawBytesInThisSector = hf->SectorOffsets[dwIndex + 1] - hf->SectorOffsets[dwIndex];
+
+                // Decrypt, verify and decompress the sector
+                nError = DecodeMpqSector(hf, pbOutSector, pbInSector, dwIndex, dwRawBytesInThisSector, dwBytesInThisSector);
+                if(nError != ERROR_SUCCESS)
+                    break;
+
+                // Remember the last used compression
+                if(dwRawBytesInThisSector < dwBytesInThisSector && (pFileEntry->dwFlags & MPQ_FILE_COMPRESS))
                     hf->dwCompression0 = pbInSector[0];
 
-                    // Decompress the data
-                    if(ha->pHeader->wFormatVersion >= MPQ_FORMAT_VERSION_2)
-                        nResult = SCompDecompress2(pbOutSector, &cbOutSector, pbInSector, cbInSector);
-                    else
-                        nResult = SCompDecompress(pbOutSector, &cbOutSector, pbInSector, cbInSector);
-                }
-
-                // Is the file compressed by PKWARE Data Compression Library ?
-                else if(pFileEntry->dwFlags & MPQ_FILE_IMPLODE)
-                {
-                    nResult = SCompExplode(pbOutSector, &cbOutSector, pbInSector, cbInSector);
-                }
-
-                // Did the decompression fail ?
-                if(nResult == 0)
-                {
-                    nError = ERROR_FILE_CORRUPT;
-                    break;
-                }
-            }
-            else
-            {
-                if(pbOutSector != pbInSector)
-                    memcpy(pbOutSector, pbInSector, dwBytesInThisSector);
+                // Move pointers
+                dwBytesToRead -= dwBytesInThisSector;
+                dwByteOffset += dwBytesInThisSector;
+                dwBytesRead += dwBytesInThisSector;
+                pbOutSector += dwBytesInThisSector;
+                pbInSector += dwRawBytesInThisSector;
+                dwSectorsDone++;
             }
-
-            // Move pointers
-            dwBytesToRead -= dwBytesInThisSector;
-            dwByteOffset += dwBytesInThisSector;
-            dwBytesRead += dwBytesInThisSector;
-            pbOutSector += dwBytesInThisSector;
-            pbInSector += dwRawBytesInThisSector;
-            dwSectorsDone++;
         }
     }
     else
@@ -197,6 +197,8 @@ extern "C" {
 #define MPQ_FLAG_ATTRIBUTES_NEW     0x00001000  // Set when (attributes) invalidated by InvalidateInternalFiles
 #define MPQ_FLAG_SIGNATURE_NONE     0x00002000  // Set when no (signature) was found in InvalidateInternalFiles
 #define MPQ_FLAG_SIGNATURE_NEW      0x00004000  // Set when (signature) invalidated by InvalidateInternalFiles
+#define MPQ_FLAG_PARALLEL_DECODE    0x00008000  // Decode the sectors of large file reads on multiple threads
+#define MPQ_FLAG_BEST_COMPRESSION   0x00010000  // Files added to the archive are deflated with the strongest zlib level
 
 // Values for TMPQArchive::dwSubType
 #define MPQ_SUBTYPE_MPQ             0x00000000  // The file is a MPQ file (Blizzard games)
@@ -322,12 +324,14 @@ extern "C" {
 #define MPQ_OPEN_FORCE_MPQ_V1       0x00080000  // Always open the archive as MPQ v 1.00, ignore the "wFormatVersion" variable in the header
 #define MPQ_OPEN_CHECK_SECTOR_CRC   0x00100000  // On files with MPQ_FILE_SECTOR_CRC, the CRC will be checked when reading file
 #define MPQ_OPEN_PATCH              0x00200000  // This archive is a patch MPQ. Used internally.
+#define MPQ_OPEN_PARALLEL_DECODE    0x00400000  // Reads spanning many sectors of a compressed file are decoded on multiple threads
 #define MPQ_OPEN_READ_ONLY          STREAM_FLAG_READ_ONLY
 
 // Flags for SFileCreateArchive
 #define MPQ_CREATE_LISTFILE         0x00100000  // Also add the (listfile) file
 #define MPQ_CREATE_ATTRIBUTES       0x00200000  // Also add the (attributes) file
 #define MPQ_CREATE_SIGNATURE        0x00400000  // Also add the (signature) file
+#define MPQ_CREATE_BEST_COMPRESSION 0x00800000  // Deflate added files with the strongest zlib level instead of the WoW default
 #define MPQ_CREATE_ARCHIVE_V1       0x00000000  // Creates archive of version 1 (size up to 4GB)
 #define MPQ_CREATE_ARCHIVE_V2       0x01000000  // Creates archive of version 2 (larger than 4 GB)
 #define MPQ_CREATE_ARCHIVE_V3       0x02000000  // Creates archive of version 3
@@ -928,6 +932,7 @@ typedef struct _SFILE_CREATE_MPQ
     DWORD dwSectorSize;                         // Sector size for compressed files
     DWORD dwRawChunkSize;                       // Size of raw data chunk
     DWORD dwMaxFileCount;                       // File limit for the MPQ
+    DWORD dwCreateFlags;                        // Additional MPQ_CREATE_XXX flags. Only MPQ_CREATE_BEST_COMPRESSION is used.
 
 } SFILE_CREATE_MPQ, *PSFILE_CREATE_MPQ;
 
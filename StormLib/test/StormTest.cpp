@@ -30,6 +30,7 @@
 
 #ifndef PLATFORM_WINDOWS
 #include <dirent.h>
+#include <sys/time.h>
 #endif
 
 //------------------------------------------------------------------------------
@@ -4263,6 +4264,221 @@ static int TestCreateArchive_BigArchive(LPCTSTR szPlainName)
     return nError;
 }
 
+static DWORD GetMilliseconds()
+{
+#ifdef PLATFORM_WINDOWS
+    return GetTickCount();
+#else
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (DWORD)(tv.tv_sec * 1000 + tv.tv_usec / 1000);
+#endif
+}
+
+// Reads the whole file and a range that starts and ends in the middle of a sector.
+// Returns the time spent by reading, or -1 if the data don't match.
+static int ReadAndCompareFile(TLogHelper * pLogger, LPCTSTR szFullPath, DWORD dwOpenFlags, LPCSTR szFileName, LPBYTE pbExpected, LPBYTE pbBuffer, DWORD dwFileSize, DWORD dwPasses)
+{
+    HANDLE hMpq = NULL;
+    HANDLE hFile = NULL;
+    DWORD dwStartTime;
+    DWORD dwBytesRead = 0;
+    DWORD dwOffset = 0x1234;
+    int nTime = -1;
+
+    if(OpenExistingArchive(pLogger, szFullPath, dwOpenFlags, &hMpq) != ERROR_SUCCESS)
+        return -1;
+
+    if(SFileOpenFileEx(hMpq, szFileName, 0, &hFile))
+    {
+        dwStartTime = GetMilliseconds();
+        for(DWORD i = 0; i < dwPasses; i++)
+        {
+            // Read the whole file
+            memset(pbBuffer, 0, dwFileSize);
+            SFileSetFilePointer(hFile, 0, NULL, FILE_BEGIN);
+            if(!SFileReadFile(hFile, pbBuffer, dwFileSize, &dwBytesRead, NULL) || dwBytesRead != dwFileSize || memcmp(pbBuffer, pbExpected, dwFileSize))
+                break;
+
+            // Read a range which is not aligned to sectors
+            SFileSetFilePointer(hFile, dwOffset, NULL, FILE_BEGIN);
+            if(!SFileReadFile(hFile, pbBuffer, dwFileSize / 2, &dwBytesRead, NULL) || dwBytesRead != dwFileSize / 2 || memcmp(pbBuffer, pbExpected + dwOffset, dwFileSize / 2))
+                break;
+
+            if(i == dwPasses - 1)
+                nTime = (int)(GetMilliseconds() - dwStartTime);
+        }
+
+        SFileCloseFile(hFile);
+    }
+
+    SFileCloseArchive(hMpq);
+
+    if(nTime < 0)
+        pLogger->PrintError("Data read from %s don't match", szFileName);
+    return nTime;
+}
+
+static int TestReadFile_ParallelDecode(LPCTSTR szPlainName)
+{
+    TLogHelper Logger("ParallelDecodeTest", szPlainName);
+    HANDLE hMpq = NULL;
+    HANDLE hFile = NULL;
+    LPCSTR szFileName = "war3map.j";
+    TCHAR szFullPath[MAX_PATH];
+    LPBYTE pbFileData;
+    LPBYTE pbBuffer;
+    DWORD dwFileSize = 0x00600000;
+    DWORD dwSeed = 0x12345678;
+    int nSerialTime;
+    int nParallelTime;
+    int nError;
+
+    // Create a big script-like file. It compresses well, but not to nothing
+    pbFileData = STORM_ALLOC(BYTE, dwFileSize);
+    pbBuffer = STORM_ALLOC(BYTE, dwFileSize);
+    if(pbFileData == NULL || pbBuffer == NULL)
+    {
+        STORM_FREE(pbFileData);
+        STORM_FREE(pbBuffer);
+        return Logger.PrintError("Not enough memory");
+    }
+
+    for(DWORD i = 0; i < dwFileSize; i++)
+    {
+        dwSeed = dwSeed * 1103515245 + 12345;
+        pbFileData[i] = ((dwSeed >> 16) % 7 == 0) ? ' ' : (BYTE)('a' + (dwSeed >> 16) % 26);
+    }
+
+    // Store the file encrypted and compressed, so every sector goes through the whole decoding
+    nError = CreateNewArchive(&Logger, szPlainName, MPQ_CREATE_LISTFILE, 0x10, &hMpq);
+    if(nError == ERROR_SUCCESS)
+    {
+        if(SFileCreateFile(hMpq, szFileName, 0, dwFileSize, 0, MPQ_FILE_COMPRESS | MPQ_FILE_ENCRYPTED, &hFile))
+        {
+            if(!SFileWriteFile(hFile, pbFileData, dwFileSize, MPQ_COMPRESSION_ZLIB))
+                nError = Logger.PrintError("Failed to write data to the MPQ");
+            SFileCloseFile(hFile);
+        }
+        else
+        {
+            nError = Logger.PrintError("Failed to create %s in the MPQ", szFileName);
+        }
+
+        SFileCloseArchive(hMpq);
+    }
+
+    // Read it back with both decoders and compare the speed
+    if(nError == ERROR_SUCCESS)
+    {
+        CreateFullPathName(szFullPath, _countof(szFullPath), NULL, szPlainName);
+        nSerialTime = ReadAndCompareFile(&Logger, szFullPath, 0, szFileName, pbFileData, pbBuffer, dwFileSize, 8);
+        nParallelTime = ReadAndCompareFile(&Logger, szFullPath, MPQ_OPEN_PARALLEL_DECODE, szFileName, pbFileData, pbBuffer, dwFileSize, 8);
+
+        if(nSerialTime >= 0 && nParallelTime >= 0)
+            Logger.PrintMessage("Serial decode: %u ms, parallel decode: %u ms", nSerialTime, nParallelTime);
+        else
+            nError = ERROR_FILE_CORRUPT;
+    }
+
+    STORM_FREE(pbBuffer);
+    STORM_FREE(pbFileData);
+    return nError;
+}
+
+static int CreateArchiveWithFile(TLogHelper * pLogger, LPCTSTR szPlainName, DWORD dwCreateFlags, LPCSTR szFileName, LPBYTE pbFileData, DWORD dwFileSize, DWORD * pdwCompressedSize)
+{
+    HANDLE hMpq = NULL;
+    HANDLE hFile = NULL;
+    int nError;
+
+    nError = CreateNewArchive(pLogger, szPlainName, dwCreateFlags, 0x10, &hMpq);
+    if(nError == ERROR_SUCCESS)
+    {
+        if(SFileCreateFile(hMpq, szFileName, 0, dwFileSize, 0, MPQ_FILE_COMPRESS, &hFile))
+        {
+            if(!SFileWriteFile(hFile, pbFileData, dwFileSize, MPQ_COMPRESSION_ZLIB))
+                nError = pLogger->PrintError("Failed to write data to the MPQ");
+            SFileCloseFile(hFile);
+        }
+        else
+        {
+            nError = pLogger->PrintError("Failed to create %s in the MPQ", szFileName);
+        }
+
+        // Query the packed size of the file we have just written
+        if(nError == ERROR_SUCCESS && SFileOpenFileEx(hMpq, szFileName, 0, &hFile))
+        {
+            if(!SFileGetFileInfo(hFile, SFileInfoCompressedSize, pdwCompressedSize, sizeof(DWORD), NULL))
+                nError = pLogger->PrintError("Failed to query the compressed size of %s", szFileName);
+            SFileCloseFile(hFile);
+        }
+
+        SFileCloseArchive(hMpq);
+    }
+
+    return nError;
+}
+
+static int TestCreateArchive_BestCompression(LPCTSTR szPlainName1, LPCTSTR szPlainName2)
+{
+    TLogHelper Logger("BestCompressionTest", szPlainName2);
+    LPCSTR szFileName = "war3map.j";
+    TCHAR szFullPath[MAX_PATH];
+    LPBYTE pbFileData;
+    LPBYTE pbBuffer;
+    DWORD dwDefaultSize = 0;
+    DWORD dwBestSize = 0;
+    DWORD dwFileSize = 0x00100000;
+    DWORD dwSeed = 0x9E3779B9;
+    int nError;
+
+    pbFileData = STORM_ALLOC(BYTE, dwFileSize);
+    pbBuffer = STORM_ALLOC(BYTE, dwFileSize);
+    if(pbFileData == NULL || pbBuffer == NULL)
+    {
+        STORM_FREE(pbFileData);
+        STORM_FREE(pbBuffer);
+        return Logger.PrintError("Not enough memory");
+    }
+
+    // Repetitive text with some noise, so that the deflate levels actually differ
+    for(DWORD i = 0; i < dwFileSize; i++)
+    {
+        dwSeed = dwSeed * 1103515245 + 12345;
+        pbFileData[i] = ((dwSeed >> 16) % 11 == 0) ? (BYTE)('a' + (dwSeed >> 16) % 26) : (BYTE)("call SetUnitState(u, UNIT_STATE_LIFE, 100)\n"[i % 44]);
+    }
+
+    // The same file, once with the default level and once with the strongest one
+    nError = CreateArchiveWithFile(&Logger, szPlainName1, MPQ_CREATE_LISTFILE, szFileName, pbFileData, dwFileSize, &dwDefaultSize);
+    if(nError == ERROR_SUCCESS)
+        nError = CreateArchiveWithFile(&Logger, szPlainName2, MPQ_CREATE_LISTFILE | MPQ_CREATE_BEST_COMPRESSION, szFileName, pbFileData, dwFileSize, &dwBestSize);
+
+    // The archive must not grow and must still read back unchanged
+    if(nError == ERROR_SUCCESS)
+    {
+        if(dwBestSize > dwDefaultSize)
+        {
+            Logger.PrintMessage("Best compression produced %u bytes, default produced %u bytes", dwBestSize, dwDefaultSize);
+            nError = ERROR_FILE_CORRUPT;
+        }
+    }
+
+    if(nError == ERROR_SUCCESS)
+    {
+        CreateFullPathName(szFullPath, _countof(szFullPath), NULL, szPlainName2);
+        if(ReadAndCompareFile(&Logger, szFullPath, 0, szFileName, pbFileData, pbBuffer, dwFileSize, 1) < 0)
+            nError = ERROR_FILE_CORRUPT;
+        else
+            Logger.PrintMessage("Default level: %u bytes, best level: %u bytes", dwDefaultSize, dwBestSize);
+    }
+
+    STORM_FREE(pbBuffer);
+    STORM_FREE(pbFileData);
+    return nError;
+}
+
 // "MPQ_2014_v4_Heroes_Replay.MPQ", "AddFile-replay.message.events"
 static int TestModifyArchive_ReplaceFile(LPCTSTR szMpqPlainName, LPCTSTR szFileName)
 {
@@ -4403,6 +4619,14 @@ int _tmain(int argc, TCHAR * argv[])
     printf("==== Test Suite for StormLib version %s ====\n", STORMLIB_VERSION_STRING);
     nError = InitializeMpqDirectory(argv, argc);
 
+    // Decode large file reads on multiple threads and compare with the serial decoder
+    if(nError == ERROR_SUCCESS)
+        nError = TestReadFile_ParallelDecode(_T("StormLibTest_ParallelDecode.mpq"));
+
+    // Create archives with the default and the strongest zlib level
+    if(nError == ERROR_SUCCESS)
+        nError = TestCreateArchive_BestCompression(_T("StormLibTest_DefaultCompression.mpq"), _T("StormLibTest_BestCompression.mpq"));
+
     // Not a test, but rather a tool for creating links to duplicated files
 //  if(nError == ERROR_SUCCESS)
 //      nError = FindFilePairs(ForEachFile_CreateArchiveLink, "2004 - WoW\\06080", "2004 - WoW\\06299");
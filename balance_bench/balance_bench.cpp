@@ -0,0 +1,230 @@
+/*
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*/
+
+
+// balance_bench
+// times CTeamBalancer on random scores for every team layout from 2 to 12 players split into 2 to 4 teams
+// small layouts are also solved with a plain exhaustive search (the approach the bot used before) to check the balancer finds the same spread
+
+#include "ghost.h"
+#include "util.h"
+#include "balance.h"
+
+#include <stdlib.h>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+void CONSOLE_Print( string message )
+{
+	cout << message << endl;
+}
+
+//
+// exhaustive reference search
+//
+
+// tries every assignment of players to teams in order, this is exact but visits every ordering of equal teams
+// returns the smallest largest difference between any two teams
+
+double ExhaustiveSpread( const double *scores, uint32_t numPlayers, const unsigned char *teamSizes, uint32_t numTeams, uint32_t team, uint32_t remaining, double *teamScores, uint64_t *leaves )
+{
+	if( team == numTeams )
+	{
+		++*leaves;
+		double MaxScore = teamScores[0];
+		double MinScore = teamScores[0];
+
+		for( uint32_t i = 1; i < numTeams; ++i )
+		{
+			MaxScore = max( MaxScore, teamScores[i] );
+			MinScore = min( MinScore, teamScores[i] );
+		}
+
+		return MaxScore - MinScore;
+	}
+
+	double Best = -1.0;
+
+	for( uint32_t Sub = remaining; Sub != 0; Sub = ( Sub - 1 ) & remaining )
+	{
+		uint32_t Size = 0;
+		double Score = 0.0;
+
+		for( uint32_t i = 0; i < numPlayers; ++i )
+		{
+			if( Sub & ( 1 << i ) )
+			{
+				++Size;
+				Score += scores[i];
+			}
+		}
+
+		if( Size != teamSizes[team] )
+			continue;
+
+		teamScores[team] = Score;
+		double Spread = ExhaustiveSpread( scores, numPlayers, teamSizes, numTeams, team + 1, remaining ^ Sub, teamScores, leaves );
+
+		if( Best < 0.0 || Spread < Best )
+			Best = Spread;
+	}
+
+	return Best;
+}
+
+uint64_t Microseconds( )
+{
+	static const boost :: posix_time :: ptime Start = boost :: posix_time :: microsec_clock :: universal_time( );
+	return (uint64_t)( boost :: posix_time :: microsec_clock :: universal_time( ) - Start ).total_microseconds( );
+}
+
+int main( int argc, char **argv )
+{
+	uint32_t Trials = 200;
+	uint32_t Budget = BALANCE_DEFAULT_BUDGET;
+	uint64_t ExhaustiveLimit = 400000;
+
+	if( argc > 1 )
+		Trials = strtoul( argv[1], NULL, 10 );
+
+	if( argc > 2 )
+		Budget = strtoul( argv[2], NULL, 10 );
+
+	if( Trials == 0 )
+	{
+		cout << "usage: balance_bench [trials per layout] [node budget]" << endl;
+		return 1;
+	}
+
+	srand( 1 );
+	CTeamBalancer *Balancer = new CTeamBalancer( );
+	uint32_t Mismatches = 0;
+
+	cout << "players teams   sizes   avg us   max us  avg nodes  max nodes  over budget  exhaustive us  mismatches" << endl;
+
+	for( uint32_t NumPlayers = 2; NumPlayers <= BALANCE_MAX_PLAYERS; ++NumPlayers )
+	{
+		for( uint32_t NumTeams = 2; NumTeams <= 4 && NumTeams <= NumPlayers; ++NumTeams )
+		{
+			// spread the players as evenly as possible, the first teams get the extra players
+
+			unsigned char TeamSizes[BALANCE_MAX_TEAMS];
+			string Sizes;
+			uint64_t Combinations = 1;
+			uint32_t PlayersLeft = NumPlayers;
+
+			for( uint32_t i = 0; i < NumTeams; ++i )
+			{
+				TeamSizes[i] = (unsigned char)( NumPlayers / NumTeams + ( i < NumPlayers % NumTeams ? 1 : 0 ) );
+				Combinations *= nCr( PlayersLeft, TeamSizes[i] );
+				PlayersLeft -= TeamSizes[i];
+
+				if( !Sizes.empty( ) )
+					Sizes += "/";
+
+				Sizes += UTIL_ToString( TeamSizes[i] );
+			}
+
+			bool CheckExhaustive = Combinations <= ExhaustiveLimit;
+			uint64_t TotalTime = 0;
+			uint64_t MaxTime = 0;
+			uint64_t TotalNodes = 0;
+			uint32_t MaxNodes = 0;
+			uint32_t OverBudget = 0;
+			uint64_t ExhaustiveTime = 0;
+			uint32_t LayoutMismatches = 0;
+
+			for( uint32_t Trial = 0; Trial < Trials; ++Trial )
+			{
+				// scores in the range of the usual DotA ratings, rounded like the scores stored in the database
+
+				double Scores[BALANCE_MAX_PLAYERS];
+
+				for( uint32_t i = 0; i < NumPlayers; ++i )
+					Scores[i] = 1000.0 + rand( ) % 150000 / 100.0;
+
+				uint64_t Start = Microseconds( );
+				Balancer->Balance( Scores, NumPlayers, TeamSizes, NumTeams, Budget );
+				uint64_t Time = Microseconds( ) - Start;
+
+				TotalTime += Time;
+				MaxTime = max( MaxTime, Time );
+				TotalNodes += Balancer->GetNodes( );
+				MaxNodes = max( MaxNodes, Balancer->GetNodes( ) );
+
+				if( !Balancer->GetComplete( ) )
+					++OverBudget;
+
+				// check the returned teams are a valid split with the reported spread
+
+				uint32_t Used = 0;
+				double MaxScore = 0.0;
+				double MinScore = 0.0;
+				bool Valid = true;
+
+				for( uint32_t i = 0; i < NumTeams; ++i )
+				{
+					uint32_t Team = Balancer->GetTeam( i );
+					uint32_t Size = 0;
+					double Score = 0.0;
+
+					for( uint32_t j = 0; j < NumPlayers; ++j )
+					{
+						if( Team & ( 1 << j ) )
+						{
+							++Size;
+							Score += Scores[j];
+						}
+					}
+
+					if( Size != TeamSizes[i] || ( Used & Team ) )
+						Valid = false;
+
+					Used |= Team;
+					MaxScore = i == 0 ? Score : max( MaxScore, Score );
+					MinScore = i == 0 ? Score : min( MinScore, Score );
+				}
+
+				if( !Valid || Used != (uint32_t)( ( 1 << NumPlayers ) - 1 ) || fabs( MaxScore - MinScore - Balancer->GetSpread( ) ) > 0.001 )
+					++LayoutMismatches;
+				else if( CheckExhaustive && Balancer->GetComplete( ) )
+				{
+					double TeamScores[BALANCE_MAX_TEAMS];
+					uint64_t Leaves = 0;
+					Start = Microseconds( );
+					double Best = ExhaustiveSpread( Scores, NumPlayers, TeamSizes, NumTeams, 0, ( 1 << NumPlayers ) - 1, TeamScores, &Leaves );
+					ExhaustiveTime += Microseconds( ) - Start;
+
+					if( fabs( Best - Balancer->GetSpread( ) ) > 0.001 )
+						++LayoutMismatches;
+				}
+			}
+
+			Mismatches += LayoutMismatches;
+			printf( "%7u %5u %7s %8.1f %8u %10.1f %10u %12u %14s %11u\n", NumPlayers, NumTeams, Sizes.c_str( ), (double)TotalTime / Trials, (uint32_t)MaxTime, (double)TotalNodes / Trials, MaxNodes, OverBudget, CheckExhaustive ? UTIL_ToString( (double)ExhaustiveTime / Trials, 1 ).c_str( ) : "-", LayoutMismatches );
+		}
+	}
+
+	delete Balancer;
+
+	if( Mismatches > 0 )
+	{
+		cout << Mismatches << " trials didn't match the exhaustive search" << endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,967 @@
+/*
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*/
+
+// bnet_standin
+// a minimal battle.net/PvPGN stand-in server so the bot's realm code can be benchmarked and regression tested on localhost
+// it accepts any cd key and password (use bnet_passwordhashtype = pvpgn), then handles chat, channels, whispers, /whois, game adverts and game listing
+// a PvPGN style message quota is enforced per connection and -floodkick disconnects a bot that keeps exceeding it like the official servers do
+// the server can also play a user who sends the bots a command at a fixed rate and times the reply, and fill the channel with chatters
+// every connected bot gets a report line: chat command latency, the spacing of its outgoing chat (what its send queue lets through),
+// quota violations and its game refresh cadence
+
+#include "ghost.h"
+#include "util.h"
+#include "socket.h"
+#include "bnetprotocol.h"
+
+#include <signal.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+bool gVerbose = false;
+volatile bool gExit = false;
+
+void CONSOLE_Print( string message )
+{
+	if( gVerbose )
+		cerr << message << endl;
+}
+
+void DEBUG_Print( string message )
+{
+	CONSOLE_Print( message );
+}
+
+void DEBUG_Print( BYTEARRAY b )
+{
+	CONSOLE_Print( UTIL_ByteArrayToHexString( b ) );
+}
+
+uint32_t GetTicks( )
+{
+	static const boost :: posix_time :: ptime Start = boost :: posix_time :: microsec_clock :: universal_time( );
+	return (uint32_t)( boost :: posix_time :: microsec_clock :: universal_time( ) - Start ).total_milliseconds( );
+}
+
+uint32_t GetTime( )
+{
+	return GetTicks( ) / 1000;
+}
+
+void SignalCatcher( int s )
+{
+	gExit = true;
+}
+
+string ToLower( string s )
+{
+	transform( s.begin( ), s.end( ), s.begin( ), (int(*)(int))tolower );
+	return s;
+}
+
+//
+// StandInOptions
+//
+
+struct StandInOptions
+{
+	string m_BindAddress;
+	uint16_t m_Port;
+	uint32_t m_Duration;			// seconds, 0 to run until interrupted
+	uint32_t m_ReportInterval;
+	uint32_t m_QuotaLines;			// PvPGN's quota_lines, 0 disables the quota
+	uint32_t m_QuotaTime;			// PvPGN's quota_time in milliseconds
+	uint32_t m_QuotaWrap;			// PvPGN's quota_wrapline, longer messages count as several lines
+	uint32_t m_FloodKick;			// disconnect after this many messages over quota within one quota window, 0 to never disconnect
+	string m_BenchUser;
+	string m_Inject;				// the command the bench user sends, empty to disable
+	uint32_t m_InjectInterval;
+	bool m_InjectWhisper;
+	uint32_t m_Chatters;
+	uint32_t m_ChatRate;			// lines per minute from all chatters in a channel
+	bool m_SpoofOK;					// answer /whois for unknown users as if they were in the asking bot's game
+};
+
+StandInOptions gOptions;
+
+//
+// CStandInSamples
+//
+
+// the rates here are low (a bot sends at most a few chat lines per second) so keeping every sample is fine
+
+class CStandInSamples
+{
+private:
+	vector<uint32_t> m_Values;
+
+public:
+	uint32_t GetCount( ) const		{ return m_Values.size( ); }
+	void Add( uint32_t value )		{ m_Values.push_back( value ); }
+
+	uint32_t GetPercentile( double percentile ) const
+	{
+		if( m_Values.empty( ) )
+			return 0;
+
+		vector<uint32_t> Sorted = m_Values;
+		vector<uint32_t> :: iterator Nth = Sorted.begin( ) + (size_t)( ( Sorted.size( ) - 1 ) * percentile / 100.0 );
+		nth_element( Sorted.begin( ), Nth, Sorted.end( ) );
+		return *Nth;
+	}
+
+	string ToString( ) const
+	{
+		if( m_Values.empty( ) )
+			return "n/a";
+
+		return "p50 " + UTIL_ToString( GetPercentile( 50 ) ) + " p99 " + UTIL_ToString( GetPercentile( 99 ) ) + " min " + UTIL_ToString( GetPercentile( 0 ) ) + " max " + UTIL_ToString( GetPercentile( 100 ) ) + " ms";
+	}
+};
+
+//
+// CStandInUser
+//
+
+// one connected client, normally a bot
+
+class CStandInUser
+{
+public:
+	CTCPSocket *m_Socket;
+	string m_AccountName;
+	string m_UniqueName;
+	string m_Channel;				// empty when not in chat
+	bool m_SelectorReceived;
+	bool m_LoggedIn;
+	uint32_t m_ConnectedTicks;
+
+	// game advert
+
+	string m_GameName;				// empty when not advertising
+	string m_GameHostCounter;		// the 8 character hex string from SID_STARTADVEX3, sent back unchanged in SID_GETADVLISTEX
+	uint16_t m_GamePort;
+	uint32_t m_LastRefreshTicks;
+	uint32_t m_Refreshes;
+	CStandInSamples m_RefreshGaps;
+
+	// outgoing chat of the bot
+
+	uint32_t m_ChatCommands;
+	uint32_t m_LastChatTicks;
+	CStandInSamples m_ChatGaps;
+	deque<uint32_t> m_QuotaLines;	// ticks of every quota line inside the window
+	deque<uint32_t> m_QuotaDrops;	// ticks of every message dropped inside the window
+	uint32_t m_QuotaExceeded;
+
+	// bench user commands waiting for a reply
+
+	deque<uint32_t> m_Pending;
+	uint32_t m_NextInjectTicks;
+	uint32_t m_Injected;
+	CStandInSamples m_ReplyLatency;
+
+	CStandInUser( CTCPSocket *nSocket ) : m_Socket( nSocket ), m_SelectorReceived( false ), m_LoggedIn( false ), m_ConnectedTicks( GetTicks( ) ), m_GamePort( 0 ), m_LastRefreshTicks( 0 ), m_Refreshes( 0 ), m_ChatCommands( 0 ), m_LastChatTicks( 0 ), m_QuotaExceeded( 0 ), m_NextInjectTicks( 0 ), m_Injected( 0 ) { }
+	~CStandInUser( )	{ delete m_Socket; }
+
+	string GetName( )	{ return m_UniqueName.empty( ) ? m_Socket->GetIPString( ) : m_UniqueName; }
+};
+
+//
+// CStandInServer
+//
+
+class CStandInServer
+{
+private:
+	CTCPServer *m_Server;
+	vector<CStandInUser *> m_Users;
+	vector<string> m_Chatters;
+	uint32_t m_NextChatterTicks;
+	uint32_t m_StartTicks;
+
+public:
+	CStandInServer( );
+	~CStandInServer( );
+
+	bool Listen( );
+	void Update( );
+	void PrintReport( );
+
+private:
+	void ExtractPackets( CStandInUser *user );
+	void ProcessPacket( CStandInUser *user, const BYTEARRAY &data );
+	void ProcessChatCommand( CStandInUser *user, const string &message );
+	void JoinChannel( CStandInUser *user, const string &channel );
+	void LeaveChannel( CStandInUser *user );
+	void Inject( uint32_t ticks );
+	void Chatter( uint32_t ticks );
+	bool CheckQuota( CStandInUser *user, const string &message, uint32_t ticks );
+	CStandInUser *GetUser( const string &name );
+	bool IsVirtualUser( const string &name );
+
+	void Send( CStandInUser *user, unsigned char id, const BYTEARRAY &payload );
+	void SendChatEvent( CStandInUser *user, uint32_t eventID, const string &from, const string &message );
+	void SendChannelEvent( const string &channel, CStandInUser *except, uint32_t eventID, const string &from, const string &message );
+};
+
+CStandInServer :: CStandInServer( ) : m_Server( new CTCPServer( ) ), m_NextChatterTicks( 0 ), m_StartTicks( GetTicks( ) )
+{
+	for( uint32_t i = 0; i < gOptions.m_Chatters; ++i )
+		m_Chatters.push_back( "chatter" + UTIL_ToString( i ) );
+}
+
+CStandInServer :: ~CStandInServer( )
+{
+	for( vector<CStandInUser *> :: iterator i = m_Users.begin( ); i != m_Users.end( ); ++i )
+		delete *i;
+
+	delete m_Server;
+}
+
+bool CStandInServer :: Listen( )
+{
+	return m_Server->Listen( gOptions.m_BindAddress, gOptions.m_Port );
+}
+
+void CStandInServer :: Send( CStandInUser *user, unsigned char id, const BYTEARRAY &payload )
+{
+	BYTEARRAY packet;
+	packet.reserve( 4 + payload.size( ) );
+	packet.push_back( BNET_HEADER_CONSTANT );
+	packet.push_back( id );
+	UTIL_AppendByteArray( packet, (uint16_t)( 4 + payload.size( ) ), false );
+	packet.insert( packet.end( ), payload.begin( ), payload.end( ) );
+	user->m_Socket->PutBytes( packet );
+}
+
+void CStandInServer :: SendChatEvent( CStandInUser *user, uint32_t eventID, const string &from, const string &message )
+{
+	// see CBNETProtocol :: RECEIVE_SID_CHATEVENT
+
+	BYTEARRAY Payload;
+	UTIL_AppendByteArray( Payload, eventID, false );
+	UTIL_AppendByteArray( Payload, (uint32_t)0, false );	// user flags
+	UTIL_AppendByteArray( Payload, (uint32_t)0, false );	// ping
+	Payload.resize( Payload.size( ) + 12, 0 );				// ip, account number, registration authority
+	UTIL_AppendByteArray( Payload, from );
+	UTIL_AppendByteArray( Payload, message );
+	Send( user, CBNETProtocol :: SID_CHATEVENT, Payload );
+}
+
+void CStandInServer :: SendChannelEvent( const string &channel, CStandInUser *except, uint32_t eventID, const string &from, const string &message )
+{
+	for( vector<CStandInUser *> :: iterator i = m_Users.begin( ); i != m_Users.end( ); ++i )
+	{
+		if( *i != except && (*i)->m_Channel == channel )
+			SendChatEvent( *i, eventID, from, message );
+	}
+}
+
+CStandInUser *CStandInServer :: GetUser( const string &name )
+{
+	string Name = ToLower( name );
+
+	for( vector<CStandInUser *> :: iterator i = m_Users.begin( ); i != m_Users.end( ); ++i )
+	{
+		if( (*i)->m_LoggedIn && ToLower( (*i)->m_UniqueName ) == Name )
+			return *i;
+	}
+
+	return NULL;
+}
+
+bool CStandInServer :: IsVirtualUser( const string &name )
+{
+	string Name = ToLower( name );
+
+	if( Name == ToLower( gOptions.m_BenchUser ) )
+		return true;
+
+	for( vector<string> :: iterator i = m_Chatters.begin( ); i != m_Chatters.end( ); ++i )
+	{
+		if( *i == Name )
+			return true;
+	}
+
+	return false;
+}
+
+void CStandInServer :: Update( )
+{
+	fd_set fd;
+	fd_set send_fd;
+	FD_ZERO( &fd );
+	FD_ZERO( &send_fd );
+	int nfds = 0;
+
+	m_Server->SetFD( &fd, &send_fd, &nfds );
+
+	for( vector<CStandInUser *> :: iterator i = m_Users.begin( ); i != m_Users.end( ); ++i )
+		(*i)->m_Socket->SetFD( &fd, &send_fd, &nfds );
+
+	struct timeval tv;
+	tv.tv_sec = 0;
+	tv.tv_usec = 10000;
+
+	struct timeval send_tv;
+	send_tv.tv_sec = 0;
+	send_tv.tv_usec = 0;
+
+	select( nfds + 1, &fd, NULL, NULL, &tv );
+	select( nfds + 1, NULL, &send_fd, NULL, &send_tv );
+
+	CTCPSocket *NewSocket = m_Server->Accept( &fd );
+
+	if( NewSocket )
+	{
+		NewSocket->SetNoDelay( true );
+		CONSOLE_Print( "[STANDIN] connection from " + NewSocket->GetIPString( ) );
+		m_Users.push_back( new CStandInUser( NewSocket ) );
+	}
+
+	uint32_t Ticks = GetTicks( );
+
+	for( vector<CStandInUser *> :: iterator i = m_Users.begin( ); i != m_Users.end( ); )
+	{
+		CStandInUser *User = *i;
+		User->m_Socket->DoRecv( &fd );
+		ExtractPackets( User );
+
+		if( User->m_Socket->HasError( ) || !User->m_Socket->GetConnected( ) )
+		{
+			CONSOLE_Print( "[STANDIN] [" + User->GetName( ) + "] disconnected" );
+			LeaveChannel( User );
+			delete User;
+			i = m_Users.erase( i );
+			continue;
+		}
+
+		User->m_Socket->DoSend( &send_fd );
+		++i;
+	}
+
+	Inject( Ticks );
+	Chatter( Ticks );
+}
+
+void CStandInServer :: ExtractPackets( CStandInUser *user )
+{
+	string *RecvBuffer = user->m_Socket->GetBytes( );
+
+	// the client starts with a single protocol selector byte (1 = game) before the first packet
+
+	if( !user->m_SelectorReceived && !RecvBuffer->empty( ) )
+	{
+		user->m_SelectorReceived = true;
+
+		if( (*RecvBuffer)[0] == 1 )
+			*RecvBuffer = RecvBuffer->substr( 1 );
+	}
+
+	while( RecvBuffer->size( ) >= 4 && user->m_Socket->GetConnected( ) )
+	{
+		if( (unsigned char)(*RecvBuffer)[0] != BNET_HEADER_CONSTANT )
+		{
+			CONSOLE_Print( "[STANDIN] [" + user->GetName( ) + "] bad header constant, disconnecting" );
+			user->m_Socket->Disconnect( );
+			return;
+		}
+
+		uint16_t Length = (uint16_t)( (unsigned char)(*RecvBuffer)[2] | ( (unsigned char)(*RecvBuffer)[3] << 8 ) );
+
+		if( Length < 4 )
+		{
+			CONSOLE_Print( "[STANDIN] [" + user->GetName( ) + "] bad length, disconnecting" );
+			user->m_Socket->Disconnect( );
+			return;
+		}
+
+		if( RecvBuffer->size( ) < Length )
+			return;
+
+		BYTEARRAY Data = UTIL_CreateByteArray( (unsigned char *)RecvBuffer->c_str( ), Length );
+		*RecvBuffer = RecvBuffer->substr( Length );
+		ProcessPacket( user, Data );
+	}
+}
+
+void CStandInServer :: ProcessPacket( CStandInUser *user, const BYTEARRAY &data )
+{
+	BYTEARRAY Payload;
+	uint32_t Ticks = GetTicks( );
+
+	switch( data[1] )
+	{
+	case CBNETProtocol :: SID_NULL:
+		// PvPGN answers these, see the note in CBNET :: ProcessPackets
+
+		Send( user, CBNETProtocol :: SID_NULL, Payload );
+		break;
+
+	case CBNETProtocol :: SID_AUTH_INFO:
+	{
+		// see CBNETProtocol :: RECEIVE_SID_AUTH_INFO, the formula has to be one bncsutil can evaluate against the local game files
+
+		Send( user, CBNETProtocol :: SID_PING, UTIL_CreateByteArray( Ticks, false ) );
+		UTIL_AppendByteArray( Payload, (uint32_t)2, false );			// logon type (NLS version 2)
+		UTIL_AppendByteArray( Payload, (uint32_t)rand( ), false );		// server token
+		UTIL_AppendByteArray( Payload, (uint32_t)0, false );			// udp value
+		Payload.resize( Payload.size( ) + 8, 0 );						// mpq filetime
+		UTIL_AppendByteArray( Payload, string( "ver-IX86-1.mpq" ) );
+		UTIL_AppendByteArray( Payload, string( "A=3845581634 B=880823580 C=1363937103 4 A=A-S B=B-C C=C-A A=A-B" ) );
+		Payload.resize( Payload.size( ) + 128, 0 );						// server signature
+		Send( user, CBNETProtocol :: SID_AUTH_INFO, Payload );
+		break;
+	}
+
+	case CBNETProtocol :: SID_AUTH_CHECK:
+		UTIL_AppendByteArray( Payload, (uint32_t)CBNETProtocol :: KR_GOOD, false );
+		UTIL_AppendByteArray( Payload, string( ) );
+		Send( user, CBNETProtocol :: SID_AUTH_CHECK, Payload );
+		break;
+
+	case CBNETProtocol :: SID_AUTH_ACCOUNTLOGON:
+		// 32 bytes client key then the account name
+
+		if( data.size( ) > 36 )
+		{
+			BYTEARRAY Data = data;
+			BYTEARRAY Name = UTIL_ExtractCString( Data, 36 );
+			user->m_AccountName = string( Name.begin( ), Name.end( ) );
+		}
+
+		UTIL_AppendByteArray( Payload, (uint32_t)0, false );			// status
+		Payload.resize( Payload.size( ) + 64, 0 );						// salt and server key, nothing checks them
+		Send( user, CBNETProtocol :: SID_AUTH_ACCOUNTLOGON, Payload );
+		break;
+
+	case CBNETProtocol :: SID_AUTH_ACCOUNTLOGONPROOF:
+		UTIL_AppendByteArray( Payload, (uint32_t)0, false );			// status
+		Payload.resize( Payload.size( ) + 20, 0 );						// server password proof
+		UTIL_AppendByteArray( Payload, string( ) );
+		Send( user, CBNETProtocol :: SID_AUTH_ACCOUNTLOGONPROOF, Payload );
+		break;
+
+	case CBNETProtocol :: SID_NETGAMEPORT:
+		if( data.size( ) >= 6 )
+			user->m_GamePort = (uint16_t)( data[4] | ( data[5] << 8 ) );
+
+		break;
+
+	case CBNETProtocol :: SID_ENTERCHAT:
+	{
+		// a second connection with the same account gets a #2 suffix like on battle.net
+
+		if( !user->m_LoggedIn )
+		{
+			string Name = user->m_AccountName.empty( ) ? "user" : user->m_AccountName;
+			user->m_UniqueName = Name;
+
+			for( uint32_t n = 2; GetUser( user->m_UniqueName ) || IsVirtualUser( user->m_UniqueName ); ++n )
+				user->m_UniqueName = Name + "#" + UTIL_ToString( n );
+
+			user->m_LoggedIn = true;
+			CONSOLE_Print( "[STANDIN] [" + user->m_UniqueName + "] logged in" );
+		}
+
+		UTIL_AppendByteArray( Payload, user->m_UniqueName );
+		UTIL_AppendByteArray( Payload, string( "PX3W 0 0 0" ) );
+		UTIL_AppendByteArray( Payload, user->m_AccountName );
+		Send( user, CBNETProtocol :: SID_ENTERCHAT, Payload );
+		break;
+	}
+
+	case CBNETProtocol :: SID_JOINCHANNEL:
+		if( user->m_LoggedIn && data.size( ) >= 9 )
+		{
+			BYTEARRAY Data = data;
+			BYTEARRAY Channel = UTIL_ExtractCString( Data, 8 );
+			JoinChannel( user, Channel.empty( ) ? string( "The Void" ) : string( Channel.begin( ), Channel.end( ) ) );
+		}
+
+		break;
+
+	case CBNETProtocol :: SID_CHATCOMMAND:
+		if( user->m_LoggedIn && data.size( ) >= 5 )
+		{
+			BYTEARRAY Data = data;
+			BYTEARRAY Message = UTIL_ExtractCString( Data, 4 );
+			ProcessChatCommand( user, string( Message.begin( ), Message.end( ) ) );
+		}
+
+		break;
+
+	case CBNETProtocol :: SID_STARTADVEX3:
+		if( user->m_LoggedIn && data.size( ) >= 25 )
+		{
+			// state, uptime, game type, ???, custom game, then the game name, an empty password, the slots character and the host counter
+
+			BYTEARRAY Data = data;
+			BYTEARRAY GameName = UTIL_ExtractCString( Data, 24 );
+			uint32_t HostCounterStart = 24 + GameName.size( ) + 3;
+
+			if( data.size( ) >= HostCounterStart + 8 )
+			{
+				if( user->m_LastRefreshTicks != 0 )
+					user->m_RefreshGaps.Add( Ticks - user->m_LastRefreshTicks );
+
+				// creating a game takes the bot out of chat, refreshing it doesn't
+
+				if( user->m_GameName.empty( ) )
+					LeaveChannel( user );
+
+				user->m_GameName = string( GameName.begin( ), GameName.end( ) );
+				user->m_GameHostCounter = string( data.begin( ) + HostCounterStart, data.begin( ) + HostCounterStart + 8 );
+				user->m_LastRefreshTicks = Ticks;
+				++user->m_Refreshes;
+				UTIL_AppendByteArray( Payload, (uint32_t)0, false );
+			}
+			else
+				UTIL_AppendByteArray( Payload, (uint32_t)1, false );
+
+			Send( user, CBNETProtocol :: SID_STARTADVEX3, Payload );
+		}
+
+		break;
+
+	case CBNETProtocol :: SID_STOPADV:
+		user->m_GameName.clear( );
+		user->m_LastRefreshTicks = 0;
+		break;
+
+	case CBNETProtocol :: SID_GETADVLISTEX:
+	{
+		// see CBNETProtocol :: RECEIVE_SID_GETADVLISTEX, the bot only ever asks for one game by name
+
+		BYTEARRAY Data = data;
+		BYTEARRAY Wanted = data.size( ) > 20 ? UTIL_ExtractCString( Data, 20 ) : BYTEARRAY( );
+		string WantedName = string( Wanted.begin( ), Wanted.end( ) );
+		CStandInUser *Host = NULL;
+
+		for( vector<CStandInUser *> :: iterator i = m_Users.begin( ); i != m_Users.end( ) && !Host; ++i )
+		{
+			if( !(*i)->m_GameName.empty( ) && ( WantedName.empty( ) || (*i)->m_GameName == WantedName ) )
+				Host = *i;
+		}
+
+		if( Host )
+		{
+			BYTEARRAY IP = Host->m_Socket->GetIP( );
+			UTIL_AppendByteArray( Payload, (uint32_t)1, false );
+			Payload.resize( Payload.size( ) + 10, 0 );
+			UTIL_AppendByteArray( Payload, Host->m_GamePort, false );
+			UTIL_AppendByteArrayFast( Payload, IP );
+			UTIL_AppendByteArray( Payload, Host->m_GameName );
+			Payload.push_back( 0 );
+			Payload.push_back( 0 );
+			UTIL_AppendByteArray( Payload, Host->m_GameHostCounter, false );
+		}
+		else
+			UTIL_AppendByteArray( Payload, (uint32_t)0, false );
+
+		Send( user, CBNETProtocol :: SID_GETADVLISTEX, Payload );
+		break;
+	}
+
+	case CBNETProtocol :: SID_FRIENDSLIST:
+		Payload.push_back( 0 );
+		Send( user, CBNETProtocol :: SID_FRIENDSLIST, Payload );
+		break;
+
+	case CBNETProtocol :: SID_CLANMEMBERLIST:
+		// echo the cookie and report an empty clan
+
+		if( data.size( ) >= 8 )
+			Payload.insert( Payload.end( ), data.begin( ) + 4, data.begin( ) + 8 );
+		else
+			UTIL_AppendByteArray( Payload, (uint32_t)0, false );
+
+		Payload.push_back( 0 );
+		Send( user, CBNETProtocol :: SID_CLANMEMBERLIST, Payload );
+		break;
+
+	case CBNETProtocol :: SID_PING:
+	case CBNETProtocol :: SID_CHECKAD:
+	case CBNETProtocol :: SID_NOTIFYJOIN:
+	default:
+		break;
+	}
+}
+
+bool CStandInServer :: CheckQuota( CStandInUser *user, const string &message, uint32_t ticks )
+{
+	if( gOptions.m_QuotaLines == 0 )
+		return true;
+
+	while( !user->m_QuotaLines.empty( ) && ticks - user->m_QuotaLines.front( ) >= gOptions.m_QuotaTime )
+		user->m_QuotaLines.pop_front( );
+
+	while( !user->m_QuotaDrops.empty( ) && ticks - user->m_QuotaDrops.front( ) >= gOptions.m_QuotaTime )
+		user->m_QuotaDrops.pop_front( );
+
+	// like PvPGN a long message counts as one line per quota_wrapline characters
+
+	uint32_t Lines = 1 + ( message.empty( ) ? 0 : ( message.size( ) - 1 ) / gOptions.m_QuotaWrap );
+
+	if( user->m_QuotaLines.size( ) + Lines <= gOptions.m_QuotaLines )
+	{
+		user->m_QuotaLines.insert( user->m_QuotaLines.end( ), Lines, ticks );
+		return true;
+	}
+
+	++user->m_QuotaExceeded;
+	user->m_QuotaDrops.push_back( ticks );
+	SendChatEvent( user, CBNETProtocol :: EID_ERROR, user->m_UniqueName, "Your message quota has been exceeded!" );
+
+	if( gOptions.m_FloodKick > 0 && user->m_QuotaDrops.size( ) >= gOptions.m_FloodKick )
+	{
+		cout << "[STANDIN] [" << user->m_UniqueName << "] disconnected for flooding" << endl;
+		user->m_Socket->Disconnect( );
+	}
+
+	return false;
+}
+
+void CStandInServer :: ProcessChatCommand( CStandInUser *user, const string &message )
+{
+	uint32_t Ticks = GetTicks( );
+
+	if( user->m_LastChatTicks != 0 )
+		user->m_ChatGaps.Add( Ticks - user->m_LastChatTicks );
+
+	user->m_LastChatTicks = Ticks;
+	++user->m_ChatCommands;
+
+	if( !CheckQuota( user, message, Ticks ) )
+		return;
+
+	if( message.empty( ) )
+		return;
+
+	if( message[0] != '/' )
+	{
+		if( user->m_Channel.empty( ) )
+			return;
+
+		SendChannelEvent( user->m_Channel, user, CBNETProtocol :: EID_TALK, user->m_UniqueName, message );
+
+		// a channel reply to the bench user's channel command
+
+		if( !gOptions.m_InjectWhisper && !user->m_Pending.empty( ) )
+		{
+			user->m_ReplyLatency.Add( Ticks - user->m_Pending.front( ) );
+			user->m_Pending.pop_front( );
+		}
+
+		return;
+	}
+
+	string Command;
+	string Payload;
+	string :: size_type Split = message.find( " " );
+
+	if( Split != string :: npos )
+	{
+		Command = ToLower( message.substr( 1, Split - 1 ) );
+		Payload = message.substr( Split + 1 );
+	}
+	else
+		Command = ToLower( message.substr( 1 ) );
+
+	if( Command == "w" || Command == "whisper" || Command == "m" || Command == "msg" )
+	{
+		string To;
+		string Text;
+		Split = Payload.find( " " );
+
+		if( Split != string :: npos )
+		{
+			To = Payload.substr( 0, Split );
+			Text = Payload.substr( Split + 1 );
+		}
+		else
+			To = Payload;
+
+		CStandInUser *Target = GetUser( To );
+
+		if( Target )
+		{
+			SendChatEvent( Target, CBNETProtocol :: EID_WHISPER, user->m_UniqueName, Text );
+			SendChatEvent( user, CBNETProtocol :: EID_WHISPERSENT, Target->m_UniqueName, Text );
+		}
+		else if( IsVirtualUser( To ) )
+		{
+			SendChatEvent( user, CBNETProtocol :: EID_WHISPERSENT, To, Text );
+
+			if( gOptions.m_InjectWhisper && ToLower( To ) == ToLower( gOptions.m_BenchUser ) && !user->m_Pending.empty( ) )
+			{
+				user->m_ReplyLatency.Add( Ticks - user->m_Pending.front( ) );
+				user->m_Pending.pop_front( );
+			}
+		}
+		else
+			SendChatEvent( user, CBNETProtocol :: EID_ERROR, user->m_UniqueName, "That user is not logged on." );
+	}
+	else if( Command == "whois" || Command == "where" || Command == "whereis" )
+	{
+		// the wording matches what CBNET :: ProcessChatEvent looks for when spoof checking
+
+		CStandInUser *Target = GetUser( Payload );
+
+		if( Target && !Target->m_GameName.empty( ) )
+			SendChatEvent( user, CBNETProtocol :: EID_INFO, user->m_UniqueName, Target->m_UniqueName + " is using Warcraft III The Frozen Throne in game " + Target->m_GameName + "." );
+		else if( Target && !Target->m_Channel.empty( ) )
+			SendChatEvent( user, CBNETProtocol :: EID_INFO, user->m_UniqueName, Target->m_UniqueName + " is using Warcraft III The Frozen Throne in channel " + Target->m_Channel + "." );
+		else if( IsVirtualUser( Payload ) )
+			SendChatEvent( user, CBNETProtocol :: EID_INFO, user->m_UniqueName, Payload + " is using Warcraft III The Frozen Throne in channel " + ( user->m_Channel.empty( ) ? string( "The Void" ) : user->m_Channel ) + "." );
+		else if( gOptions.m_SpoofOK && !user->m_GameName.empty( ) )
+			SendChatEvent( user, CBNETProtocol :: EID_INFO, user->m_UniqueName, Payload + " is using Warcraft III The Frozen Throne in game " + user->m_GameName + "." );
+		else
+			SendChatEvent( user, CBNETProtocol :: EID_ERROR, user->m_UniqueName, "That user is not logged on." );
+	}
+	else if( Command == "j" || Command == "join" )
+	{
+		if( !Payload.empty( ) )
+			JoinChannel( user, Payload );
+	}
+	else if( Command == "f" || Command == "friends" )
+		SendChatEvent( user, CBNETProtocol :: EID_INFO, user->m_UniqueName, "Your friends list is empty." );
+	else
+		CONSOLE_Print( "[STANDIN] [" + user->m_UniqueName + "] ignored command [" + message + "]" );
+}
+
+void CStandInServer :: JoinChannel( CStandInUser *user, const string &channel )
+{
+	LeaveChannel( user );
+	user->m_Channel = channel;
+	SendChatEvent( user, CBNETProtocol :: EID_CHANNEL, user->m_UniqueName, channel );
+
+	// everyone already there, including the virtual users who live in every channel
+
+	for( vector<CStandInUser *> :: iterator i = m_Users.begin( ); i != m_Users.end( ); ++i )
+	{
+		if( (*i)->m_Channel == channel )
+			SendChatEvent( user, CBNETProtocol :: EID_SHOWUSER, (*i)->m_UniqueName, "PX3W 0 0 0" );
+	}
+
+	if( !gOptions.m_Inject.empty( ) )
+		SendChatEvent( user, CBNETProtocol :: EID_SHOWUSER, gOptions.m_BenchUser, "PX3W 0 0 0" );
+
+	for( vector<string> :: iterator i = m_Chatters.begin( ); i != m_Chatters.end( ); ++i )
+		SendChatEvent( user, CBNETProtocol :: EID_SHOWUSER, *i, "PX3W 0 0 0" );
+
+	SendChannelEvent( channel, user, CBNETProtocol :: EID_JOIN, user->m_UniqueName, "PX3W 0 0 0" );
+}
+
+void CStandInServer :: LeaveChannel( CStandInUser *user )
+{
+	if( user->m_Channel.empty( ) )
+		return;
+
+	string Channel = user->m_Channel;
+	user->m_Channel.clear( );
+	SendChannelEvent( Channel, user, CBNETProtocol :: EID_LEAVE, user->m_UniqueName, string( ) );
+}
+
+void CStandInServer :: Inject( uint32_t ticks )
+{
+	if( gOptions.m_Inject.empty( ) )
+		return;
+
+	for( vector<CStandInUser *> :: iterator i = m_Users.begin( ); i != m_Users.end( ); ++i )
+	{
+		CStandInUser *User = *i;
+
+		if( User->m_Channel.empty( ) && !( gOptions.m_InjectWhisper && User->m_LoggedIn ) )
+			continue;
+
+		if( ticks < User->m_NextInjectTicks )
+			continue;
+
+		User->m_NextInjectTicks = ticks + gOptions.m_InjectInterval;
+
+		// a bot that stopped answering shouldn't grow the queue forever, the oldest commands count as lost
+
+		if( User->m_Pending.size( ) >= 100 )
+			User->m_Pending.pop_front( );
+
+		User->m_Pending.push_back( ticks );
+		++User->m_Injected;
+
+		if( gOptions.m_InjectWhisper )
+			SendChatEvent( User, CBNETProtocol :: EID_WHISPER, gOptions.m_BenchUser, gOptions.m_Inject );
+		else
+			SendChatEvent( User, CBNETProtocol :: EID_TALK, gOptions.m_BenchUser, gOptions.m_Inject );
+	}
+}
+
+void CStandInServer :: Chatter( uint32_t ticks )
+{
+	if( m_Chatters.empty( ) || gOptions.m_ChatRate == 0 || ticks < m_NextChatterTicks )
+		return;
+
+	m_NextChatterTicks = ticks + 60000 / gOptions.m_ChatRate;
+
+	// one random line in every channel that has someone in it
+
+	set<string> Channels;
+
+	for( vector<CStandInUser *> :: iterator i = m_Users.begin( ); i != m_Users.end( ); ++i )
+	{
+		if( !(*i)->m_Channel.empty( ) )
+			Channels.insert( (*i)->m_Channel );
+	}
+
+	static const char *Lines[] = { "anyone up for a game?", "gg", "lol", "where is the dota game", "hi all", "brb", "need one more for 3v3" };
+
+	for( set<string> :: iterator i = Channels.begin( ); i != Channels.end( ); ++i )
+		SendChannelEvent( *i, NULL, CBNETProtocol :: EID_TALK, m_Chatters[rand( ) % m_Chatters.size( )], Lines[rand( ) % ( sizeof( Lines ) / sizeof( Lines[0] ) )] );
+}
+
+void CStandInServer :: PrintReport( )
+{
+	cout << "[" << ( GetTicks( ) - m_StartTicks ) / 1000 << "s] " << m_Users.size( ) << " connections" << endl;
+
+	for( vector<CStandInUser *> :: iterator i = m_Users.begin( ); i != m_Users.end( ); ++i )
+	{
+		CStandInUser *User = *i;
+		double Seconds = (double)( GetTicks( ) - User->m_ConnectedTicks ) / 1000;
+
+		cout << "  " << User->GetName( );
+
+		if( !User->m_GameName.empty( ) )
+			cout << " in game [" << User->m_GameName << "]";
+		else if( !User->m_Channel.empty( ) )
+			cout << " in channel [" << User->m_Channel << "]";
+
+		cout << endl;
+		cout << "    chat " << User->m_ChatCommands << " lines (" << fixed << setprecision( 2 ) << ( Seconds > 0 ? User->m_ChatCommands / Seconds : 0.0 ) << "/s), spacing " << User->m_ChatGaps.ToString( ) << ", over quota " << User->m_QuotaExceeded << endl;
+		cout << "    refreshes " << User->m_Refreshes << ", interval " << User->m_RefreshGaps.ToString( ) << endl;
+
+		if( User->m_Injected > 0 )
+			cout << "    commands " << User->m_Injected << ", answered " << User->m_ReplyLatency.GetCount( ) << ", waiting " << User->m_Pending.size( ) << ", latency " << User->m_ReplyLatency.ToString( ) << endl;
+
+		cout.unsetf( ios :: floatfield );
+	}
+}
+
+int main( int argc, char **argv )
+{
+	gOptions.m_Port = 6112;
+	gOptions.m_Duration = 0;
+	gOptions.m_ReportInterval = 10;
+	gOptions.m_QuotaLines = 5;
+	gOptions.m_QuotaTime = 5000;
+	gOptions.m_QuotaWrap = 40;
+	gOptions.m_FloodKick = 0;
+	gOptions.m_BenchUser = "bench";
+	gOptions.m_InjectInterval = 2000;
+	gOptions.m_InjectWhisper = true;
+	gOptions.m_Chatters = 0;
+	gOptions.m_ChatRate = 30;
+	gOptions.m_SpoofOK = true;
+
+	for( int i = 1; i < argc; ++i )
+	{
+		string Arg = argv[i];
+
+		if( Arg == "-p" && i + 1 < argc )
+			gOptions.m_Port = (uint16_t)strtoul( argv[++i], NULL, 10 );
+		else if( Arg == "-b" && i + 1 < argc )
+			gOptions.m_BindAddress = argv[++i];
+		else if( Arg == "-t" && i + 1 < argc )
+			gOptions.m_Duration = strtoul( argv[++i], NULL, 10 );
+		else if( Arg == "-report" && i + 1 < argc )
+			gOptions.m_ReportInterval = strtoul( argv[++i], NULL, 10 );
+		else if( Arg == "-quota" && i + 2 < argc )
+		{
+			gOptions.m_QuotaLines = strtoul( argv[++i], NULL, 10 );
+			gOptions.m_QuotaTime = strtoul( argv[++i], NULL, 10 ) * 1000;
+		}
+		else if( Arg == "-quotawrap" && i + 1 < argc )
+			gOptions.m_QuotaWrap = strtoul( argv[++i], NULL, 10 );
+		else if( Arg == "-floodkick" && i + 1 < argc )
+			gOptions.m_FloodKick = strtoul( argv[++i], NULL, 10 );
+		else if( Arg == "-bench" && i + 1 < argc )
+			gOptions.m_BenchUser = argv[++i];
+		else if( Arg == "-inject" && i + 1 < argc )
+			gOptions.m_Inject = argv[++i];
+		else if( Arg == "-injectinterval" && i + 1 < argc )
+			gOptions.m_InjectInterval = strtoul( argv[++i], NULL, 10 );
+		else if( Arg == "-injectchannel" )
+			gOptions.m_InjectWhisper = false;
+		else if( Arg == "-chatters" && i + 1 < argc )
+			gOptions.m_Chatters = strtoul( argv[++i], NULL, 10 );
+		else if( Arg == "-chatrate" && i + 1 < argc )
+			gOptions.m_ChatRate = strtoul( argv[++i], NULL, 10 );
+		else if( Arg == "-nospoofok" )
+			gOptions.m_SpoofOK = false;
+		else if( Arg == "-v" )
+			gVerbose = true;
+		else
+		{
+			cerr << "usage: bnet_standin [-p port] [-b address] [-t seconds] [-report seconds] [-quota lines seconds] [-quotawrap chars] [-floodkick drops]" << endl;
+			cerr << "                    [-bench name] [-inject command] [-injectinterval ms] [-injectchannel] [-chatters n] [-chatrate lines per minute] [-nospoofok] [-v]" << endl;
+			cerr << "  point the bot at this server with bnet_server = 127.0.0.1 and bnet_passwordhashtype = pvpgn" << endl;
+			cerr << "  -inject makes the bench user whisper (or with -injectchannel say) the command to every bot and time the reply," << endl;
+			cerr << "  give the bench user admin access on the bot so its replies aren't held back as public commands" << endl;
+			cerr << "  -quota 0 0 turns the message quota off, the default is PvPGN's 5 lines per 5 seconds" << endl;
+			return 1;
+		}
+	}
+
+	if( gOptions.m_QuotaWrap == 0 )
+		gOptions.m_QuotaWrap = 40;
+
+	if( gOptions.m_InjectInterval == 0 )
+		gOptions.m_InjectInterval = 1;
+
+	signal( SIGINT, SignalCatcher );
+	signal( SIGPIPE, SIG_IGN );
+	srand( time( NULL ) );
+
+	CStandInServer Server;
+
+	if( !Server.Listen( ) )
+	{
+		cerr << "error: unable to listen on port " << gOptions.m_Port << endl;
+		return 1;
+	}
+
+	cerr << "listening on port " << gOptions.m_Port << endl;
+
+	uint32_t Start = GetTicks( );
+	uint32_t LastReportTicks = Start;
+
+	while( !gExit && ( gOptions.m_Duration == 0 || GetTicks( ) - Start < gOptions.m_Duration * 1000 ) )
+	{
+		Server.Update( );
+
+		if( gOptions.m_ReportInterval > 0 && GetTicks( ) - LastReportTicks >= gOptions.m_ReportInterval * 1000 )
+		{
+			Server.PrintReport( );
+			LastReportTicks = GetTicks( );
+		}
+	}
+
+	cout << "summary" << endl;
+	Server.PrintReport( );
+	return 0;
+}
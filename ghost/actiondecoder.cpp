@@ -0,0 +1,243 @@
+/*
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*/
+
+#include "ghost.h"
+#include "actiondecoder.h"
+
+// each action id maps to either a fixed total length or one of the variable length layouts below
+// 0 means the action id is unknown (or not sent by current clients) and decoding has to stop
+
+#define ACTIONLEN_UNKNOWN		0
+#define ACTIONLEN_SELECTION		250		// 1 byte mode/group, 1 word n, n * 8 bytes of object ids
+#define ACTIONLEN_CSTRING		251		// a null terminated string
+#define ACTIONLEN_TRIGGERCHAT	252		// 2 dwords then a null terminated string
+#define ACTIONLEN_SYNCSTORED	253		// 3 null terminated strings then a dword
+
+// APM flags from w3g_actions.txt section 2.0, [APM?] actions are handled in Decode
+
+#define ACTIONAPM_NO			0
+#define ACTIONAPM_YES			1
+#define ACTIONAPM_SPECIAL		2
+
+namespace
+{
+	struct ActionInfo
+	{
+		unsigned char m_Length;
+		unsigned char m_APM;
+	};
+
+	struct ActionTable
+	{
+		ActionInfo m_Info[256];
+	};
+
+	constexpr ActionTable GenerateActionTable( )
+	{
+		ActionTable Table = { };
+
+		struct { unsigned char ID; unsigned char Length; unsigned char APM; } Actions[] = {
+			{ 0x01, 1, ACTIONAPM_NO },						// pause game
+			{ 0x02, 1, ACTIONAPM_NO },						// resume game
+			{ 0x03, 2, ACTIONAPM_NO },						// set game speed
+			{ 0x04, 1, ACTIONAPM_NO },						// increase game speed
+			{ 0x05, 1, ACTIONAPM_NO },						// decrease game speed
+			{ 0x06, ACTIONLEN_CSTRING, ACTIONAPM_NO },		// save game
+			{ 0x07, 5, ACTIONAPM_NO },						// save game finished
+			{ 0x10, 15, ACTIONAPM_YES },					// unit/building ability (no additional parameters)
+			{ 0x11, 23, ACTIONAPM_YES },					// unit/building ability (with target position)
+			{ 0x12, 31, ACTIONAPM_YES },					// unit/building ability (with target position and target object id)
+			{ 0x13, 39, ACTIONAPM_YES },					// give item to unit / drop item on ground
+			{ 0x14, 44, ACTIONAPM_YES },					// unit/building ability (with two target positions and two item ids)
+			{ 0x16, ACTIONLEN_SELECTION, ACTIONAPM_SPECIAL },	// change selection
+			{ 0x17, ACTIONLEN_SELECTION, ACTIONAPM_YES },	// assign group hotkey
+			{ 0x18, 3, ACTIONAPM_YES },						// select group hotkey
+			{ 0x19, 13, ACTIONAPM_SPECIAL },				// select subgroup
+			{ 0x1A, 1, ACTIONAPM_NO },						// pre subselection
+			{ 0x1B, 10, ACTIONAPM_NO },						// unknown (scenarios)
+			{ 0x1C, 10, ACTIONAPM_YES },					// select ground item
+			{ 0x1D, 9, ACTIONAPM_YES },						// cancel hero revival
+			{ 0x1E, 6, ACTIONAPM_YES },						// remove unit from building queue
+			{ 0x20, 1, ACTIONAPM_NO },						// single player cheats...
+			{ 0x21, 9, ACTIONAPM_NO },
+			{ 0x22, 1, ACTIONAPM_NO },
+			{ 0x23, 1, ACTIONAPM_NO },
+			{ 0x24, 1, ACTIONAPM_NO },
+			{ 0x25, 1, ACTIONAPM_NO },
+			{ 0x26, 1, ACTIONAPM_NO },
+			{ 0x27, 6, ACTIONAPM_NO },
+			{ 0x28, 6, ACTIONAPM_NO },
+			{ 0x29, 1, ACTIONAPM_NO },
+			{ 0x2A, 1, ACTIONAPM_NO },
+			{ 0x2B, 1, ACTIONAPM_NO },
+			{ 0x2C, 1, ACTIONAPM_NO },
+			{ 0x2D, 6, ACTIONAPM_NO },
+			{ 0x2E, 5, ACTIONAPM_NO },
+			{ 0x2F, 1, ACTIONAPM_NO },
+			{ 0x30, 1, ACTIONAPM_NO },
+			{ 0x31, 1, ACTIONAPM_NO },
+			{ 0x32, 1, ACTIONAPM_NO },						// ...single player cheats
+			{ 0x50, 6, ACTIONAPM_NO },						// change ally options
+			{ 0x51, 10, ACTIONAPM_NO },						// transfer resources
+			{ 0x60, ACTIONLEN_TRIGGERCHAT, ACTIONAPM_NO },	// map trigger chat command
+			{ 0x61, 1, ACTIONAPM_YES },						// esc pressed
+			{ 0x62, 13, ACTIONAPM_NO },						// scenario trigger
+			{ 0x66, 1, ACTIONAPM_YES },						// enter choose hero skill submenu
+			{ 0x67, 1, ACTIONAPM_YES },						// enter choose building submenu
+			{ 0x68, 13, ACTIONAPM_NO },						// minimap signal
+			{ 0x69, 17, ACTIONAPM_NO },						// continue game (block b)
+			{ 0x6A, 17, ACTIONAPM_NO },						// continue game (block a)
+			{ 0x6B, ACTIONLEN_SYNCSTORED, ACTIONAPM_NO },	// sync stored integer (game cache)
+			{ 0x6C, ACTIONLEN_SYNCSTORED, ACTIONAPM_NO },	// sync stored real (game cache)
+			{ 0x6D, ACTIONLEN_SYNCSTORED, ACTIONAPM_NO },	// sync stored boolean (game cache)
+			{ 0x75, 2, ACTIONAPM_NO }						// unknown (scenarios)
+		};
+
+		for( unsigned int i = 0; i < sizeof( Actions ) / sizeof( Actions[0] ); ++i )
+		{
+			Table.m_Info[Actions[i].ID].m_Length = Actions[i].Length;
+			Table.m_Info[Actions[i].ID].m_APM = Actions[i].APM;
+		}
+
+		return Table;
+	}
+
+	constexpr ActionTable g_Actions = GenerateActionTable( );
+
+	// returns the length of the null terminated string at data including the null, or 0 if there's no null before the end
+
+	inline uint32_t CStringLength( const unsigned char *data, uint32_t remaining )
+	{
+		const unsigned char *End = (const unsigned char *)memchr( data, 0, remaining );
+		return End ? End - data + 1 : 0;
+	}
+}
+
+uint32_t CActionDecoder :: GetActionLength( const unsigned char *data, uint32_t remaining )
+{
+	if( remaining == 0 )
+		return 0;
+
+	uint32_t Length = g_Actions.m_Info[data[0]].m_Length;
+
+	if( Length == ACTIONLEN_UNKNOWN )
+		return 0;
+	else if( Length == ACTIONLEN_SELECTION )
+	{
+		if( remaining < 4 )
+			return 0;
+
+		Length = 4 + ( data[2] | ( data[3] << 8 ) ) * 8;
+	}
+	else if( Length == ACTIONLEN_CSTRING )
+	{
+		uint32_t String = CStringLength( data + 1, remaining - 1 );
+
+		if( String == 0 )
+			return 0;
+
+		Length = 1 + String;
+	}
+	else if( Length == ACTIONLEN_TRIGGERCHAT )
+	{
+		if( remaining < 10 )
+			return 0;
+
+		uint32_t String = CStringLength( data + 9, remaining - 9 );
+
+		if( String == 0 )
+			return 0;
+
+		Length = 9 + String;
+	}
+	else if( Length == ACTIONLEN_SYNCSTORED )
+	{
+		Length = 1;
+
+		for( int i = 0; i < 3; ++i )
+		{
+			uint32_t String = Length < remaining ? CStringLength( data + Length, remaining - Length ) : 0;
+
+			if( String == 0 )
+				return 0;
+
+			Length += String;
+		}
+
+		Length += 4;
+	}
+
+	return Length <= remaining ? Length : 0;
+}
+
+bool CActionDecoder :: Decode( unsigned char pid, const unsigned char *data, uint32_t length, CActionHandler *handler )
+{
+	bool LastActionWasDeselect = false;
+	uint32_t i = 0;
+
+	while( i < length )
+	{
+		const unsigned char *Action = data + i;
+		uint32_t ActionLength = GetActionLength( Action, length - i );
+
+		if( ActionLength == 0 )
+			return false;
+
+		unsigned char ActionID = Action[0];
+		bool CountsForAPM = g_Actions.m_Info[ActionID].m_APM == ACTIONAPM_YES;
+
+		// a select immediately following a deselect in the same block is generated by the client and counts as one action together
+
+		if( ActionID == W3GACTION_CHANGESELECTION )
+		{
+			CountsForAPM = Action[1] == 0x02 || !LastActionWasDeselect;
+			LastActionWasDeselect = Action[1] == 0x02;
+		}
+		else
+			LastActionWasDeselect = false;
+
+		// subgroup selections are almost always generated by the client since patch 1.14b and the real ones (tab key) can't be told apart so they're never counted
+
+		if( ActionID == W3GACTION_SELECTSUBGROUP )
+			CountsForAPM = false;
+
+		if( !handler->OnAction( pid, ActionID, Action, ActionLength, CountsForAPM ) )
+			return false;
+
+		if( ActionID == W3GACTION_SYNCSTOREDINTEGER || ActionID == W3GACTION_SYNCSTOREDREAL || ActionID == W3GACTION_SYNCSTOREDBOOLEAN )
+		{
+			// GetActionLength already verified all three strings are null terminated inside the action
+
+			const char *File = (const char *)Action + 1;
+			const char *MissionKey = File + strlen( File ) + 1;
+			const char *Key = MissionKey + strlen( MissionKey ) + 1;
+			const unsigned char *Value = Action + ActionLength - 4;
+			handler->OnSyncStored( pid, ActionID, File, MissionKey, Key, (uint32_t)Value[0] | ( (uint32_t)Value[1] << 8 ) | ( (uint32_t)Value[2] << 16 ) | ( (uint32_t)Value[3] << 24 ) );
+		}
+
+		i += ActionLength;
+	}
+
+	return true;
+}
+
+bool CActionDecoder :: Decode( unsigned char pid, const BYTEARRAY &action, CActionHandler *handler )
+{
+	if( action.empty( ) )
+		return true;
+
+	return Decode( pid, &action[0], action.size( ), handler );
+}
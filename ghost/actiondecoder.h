@@ -0,0 +1,77 @@
+/*
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*/
+
+#ifndef ACTIONDECODER_H
+#define ACTIONDECODER_H
+
+//
+// CActionDecoder
+//
+
+// decodes the W3GS action blocks sent by players (CIncomingAction) and stored in replay TimeSlot blocks
+// the action lengths come from w3g_actions.txt (patch version >= 1.14b layouts) and each block is walked exactly once
+// every decoded action is passed to a CActionHandler as a view into the caller's buffer, nothing is copied
+// SyncStoredInteger/Real/Boolean actions (0x6B/0x6C/0x6D) are additionally split into their game cache strings and value
+// the strings are passed as pointers to the null terminated strings inside the action data so handlers can compare them without building temporaries
+
+#define W3GACTION_PAUSE					0x01
+#define W3GACTION_RESUME				0x02
+#define W3GACTION_SAVEGAME				0x06
+#define W3GACTION_SAVEGAMEFINISHED		0x07
+#define W3GACTION_CHANGESELECTION		0x16
+#define W3GACTION_ASSIGNGROUP			0x17
+#define W3GACTION_SELECTSUBGROUP		0x19
+#define W3GACTION_CHANGEALLY			0x50
+#define W3GACTION_TRANSFERRESOURCES		0x51
+#define W3GACTION_TRIGGERCHAT			0x60
+#define W3GACTION_ESCPRESSED			0x61
+#define W3GACTION_MINIMAPSIGNAL			0x68
+#define W3GACTION_SYNCSTOREDINTEGER		0x6B
+#define W3GACTION_SYNCSTOREDREAL		0x6C
+#define W3GACTION_SYNCSTOREDBOOLEAN		0x6D
+
+class CActionHandler
+{
+public:
+	virtual ~CActionHandler( ) { }
+
+	// called for every decoded action, data points at the action id and length includes it
+	// countsForAPM follows the standardized APM rules in w3g_actions.txt section 1.1
+	// return false to stop decoding the rest of the block
+
+	virtual bool OnAction( unsigned char pid, unsigned char actionID, const unsigned char *data, uint32_t length, bool countsForAPM ) { return true; }
+
+	// called after OnAction for SyncStoredInteger/Real/Boolean actions, value is the raw little endian dword (reinterpret it as a float for 0x6C)
+
+	virtual void OnSyncStored( unsigned char pid, unsigned char actionID, const char *file, const char *missionKey, const char *key, uint32_t value ) { }
+};
+
+class CActionDecoder
+{
+public:
+	// returns the total length of the action starting at data (including the action id)
+	// returns 0 if the action id is unknown or the action is truncated, in which case the rest of the block can't be decoded
+
+	static uint32_t GetActionLength( const unsigned char *data, uint32_t remaining );
+
+	// decodes every action in one player's action block and passes them to the handler in order
+	// returns true if the whole block was decoded, false if it stopped at an unknown or truncated action or the handler asked to stop
+
+	static bool Decode( unsigned char pid, const unsigned char *data, uint32_t length, CActionHandler *handler );
+	static bool Decode( unsigned char pid, const BYTEARRAY &action, CActionHandler *handler );
+};
+
+#endif
@@ -0,0 +1,252 @@
+/*
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*/
+
+
+#include "ghost.h"
+#include "balance.h"
+
+#include <string.h>
+
+//
+// CTeamBalancer
+//
+
+CTeamBalancer :: CTeamBalancer( )
+{
+	m_NumPlayers = 0;
+	m_NumTeams = 0;
+	m_BestSpread = 0.0;
+	m_Budget = 0;
+	m_Nodes = 0;
+	m_Complete = false;
+	memset( m_BestTeams, 0, sizeof( m_BestTeams ) );
+}
+
+CTeamBalancer :: ~CTeamBalancer( )
+{
+
+}
+
+bool CTeamBalancer :: Balance( const double *scores, uint32_t numPlayers, const unsigned char *teamSizes, uint32_t numTeams, uint32_t budget )
+{
+	m_NumPlayers = 0;
+	m_NumTeams = 0;
+	m_BestSpread = 0.0;
+	m_Nodes = 0;
+	m_Complete = false;
+	memset( m_BestTeams, 0, sizeof( m_BestTeams ) );
+
+	if( numPlayers == 0 || numPlayers > BALANCE_MAX_PLAYERS || numTeams == 0 || numTeams > BALANCE_MAX_TEAMS )
+		return false;
+
+	uint32_t TotalSize = 0;
+
+	for( uint32_t i = 0; i < numTeams; ++i )
+	{
+		if( teamSizes[i] == 0 )
+			return false;
+
+		TotalSize += teamSizes[i];
+	}
+
+	if( TotalSize != numPlayers )
+		return false;
+
+	m_NumPlayers = numPlayers;
+	m_NumTeams = numTeams;
+	m_Budget = budget;
+	m_Complete = true;
+
+	// search the largest teams first since they split the remaining players the most
+	// this also puts teams of equal size next to each other which the search relies on to skip mirrored assignments
+
+	for( uint32_t i = 0; i < m_NumTeams; ++i )
+	{
+		uint32_t j = i;
+
+		while( j > 0 && m_TeamSizes[j - 1] < teamSizes[i] )
+		{
+			m_TeamSizes[j] = m_TeamSizes[j - 1];
+			m_TeamOrder[j] = m_TeamOrder[j - 1];
+			--j;
+		}
+
+		m_TeamSizes[j] = teamSizes[i];
+		m_TeamOrder[j] = (unsigned char)i;
+	}
+
+	// precompute the total score and size of every subset of players
+	// every subset containing player i is the same as a subset of the players before i plus player i
+
+	m_MaskScores[0] = 0.0;
+	m_MaskSizes[0] = 0;
+
+	for( uint32_t i = 0; i < m_NumPlayers; ++i )
+	{
+		uint32_t Bit = 1 << i;
+
+		for( uint32_t Mask = Bit; Mask < ( Bit << 1 ); ++Mask )
+		{
+			m_MaskScores[Mask] = m_MaskScores[Mask ^ Bit] + scores[i];
+			m_MaskSizes[Mask] = m_MaskSizes[Mask ^ Bit] + 1;
+		}
+	}
+
+	Greedy( scores );
+	Search( 0, (uint16_t)( ( 1 << m_NumPlayers ) - 1 ), 0.0, 0.0 );
+	return true;
+}
+
+void CTeamBalancer :: Greedy( const double *scores )
+{
+	// place the players from the highest score to the lowest score on the weakest team which still has room
+	// this is usually close to the best answer and gives the search a tight bound to start with
+
+	unsigned char Players[BALANCE_MAX_PLAYERS];
+	double TeamScores[BALANCE_MAX_TEAMS] = { 0.0 };
+	unsigned char TeamPlayers[BALANCE_MAX_TEAMS] = { 0 };
+
+	for( uint32_t i = 0; i < m_NumPlayers; ++i )
+	{
+		uint32_t j = i;
+
+		while( j > 0 && scores[Players[j - 1]] < scores[i] )
+		{
+			Players[j] = Players[j - 1];
+			--j;
+		}
+
+		Players[j] = (unsigned char)i;
+	}
+
+	for( uint32_t i = 0; i < m_NumTeams; ++i )
+	{
+		m_Teams[i] = 0;
+	}
+
+	for( uint32_t i = 0; i < m_NumPlayers; ++i )
+	{
+		uint32_t Weakest = m_NumTeams;
+
+		for( uint32_t j = 0; j < m_NumTeams; ++j )
+		{
+			if( TeamPlayers[j] < m_TeamSizes[j] && ( Weakest == m_NumTeams || TeamScores[j] < TeamScores[Weakest] ) )
+				Weakest = j;
+		}
+
+		m_Teams[Weakest] |= 1 << Players[i];
+		TeamScores[Weakest] += scores[Players[i]];
+		TeamPlayers[Weakest]++;
+	}
+
+	double MaxScore = TeamScores[0];
+	double MinScore = TeamScores[0];
+
+	for( uint32_t i = 1; i < m_NumTeams; ++i )
+	{
+		MaxScore = max( MaxScore, TeamScores[i] );
+		MinScore = min( MinScore, TeamScores[i] );
+	}
+
+	SaveBest( MaxScore - MinScore );
+}
+
+void CTeamBalancer :: Search( uint32_t team, uint16_t remaining, double maxScore, double minScore )
+{
+	// maxScore and minScore are the highest and lowest team scores of the teams already built (they're ignored when team is zero)
+
+	if( team == m_NumTeams - 1 )
+	{
+		// the last team gets everyone who is left
+
+		double Score = m_MaskScores[remaining];
+		double Spread = team == 0 ? 0.0 : max( maxScore, Score ) - min( minScore, Score );
+
+		if( Spread < m_BestSpread )
+		{
+			m_Teams[team] = remaining;
+			SaveBest( Spread );
+		}
+
+		return;
+	}
+
+	// whatever the remaining teams end up being at least one of them scores no less than the average and one no more than the average
+	// so if adding the average to the teams already built can't beat the best spread then nothing below this point can either
+
+	double Average = m_MaskScores[remaining] / ( m_NumTeams - team );
+
+	if( team == 0 )
+	{
+		maxScore = Average;
+		minScore = Average;
+	}
+
+	if( max( maxScore, Average ) - min( minScore, Average ) >= m_BestSpread )
+		return;
+
+	unsigned char Size = m_TeamSizes[team];
+
+	// when the previous team has the same size only build teams whose lowest player comes after the previous team's lowest player
+	// otherwise every split would be visited once for every ordering of the equal teams
+
+	// and when every team left has the same size the lowest remaining player can be put on this team straight away for the same reason
+
+	uint16_t LowestAllowed = 0;
+	uint16_t Required = 0;
+
+	if( team > 0 && m_TeamSizes[team - 1] == Size )
+	{
+		uint16_t Previous = m_Teams[team - 1];
+		LowestAllowed = (uint16_t)( Previous & ( ~Previous + 1 ) );
+	}
+
+	if( m_TeamSizes[m_NumTeams - 1] == Size )
+		Required = (uint16_t)( remaining & ( ~remaining + 1 ) );
+
+	for( uint16_t Sub = remaining; Sub != 0; Sub = ( Sub - 1 ) & remaining )
+	{
+		if( m_MaskSizes[Sub] != Size || ( Sub & Required ) != Required || (uint16_t)( Sub & ( ~Sub + 1 ) ) < LowestAllowed )
+			continue;
+
+		if( ++m_Nodes > m_Budget )
+		{
+			m_Complete = false;
+			return;
+		}
+
+		double Score = m_MaskScores[Sub];
+		double NewMax = team == 0 ? Score : max( maxScore, Score );
+		double NewMin = team == 0 ? Score : min( minScore, Score );
+
+		if( NewMax - NewMin >= m_BestSpread )
+			continue;
+
+		m_Teams[team] = Sub;
+		Search( team + 1, remaining ^ Sub, NewMax, NewMin );
+
+		if( !m_Complete )
+			return;
+	}
+}
+
+void CTeamBalancer :: SaveBest( double spread )
+{
+	for( uint32_t i = 0; i < m_NumTeams; ++i )
+		m_BestTeams[m_TeamOrder[i]] = m_Teams[i];
+
+	m_BestSpread = spread;
+}
@@ -0,0 +1,70 @@
+/*
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*/
+
+
+#ifndef BALANCE_H
+#define BALANCE_H
+
+//
+// CTeamBalancer
+//
+
+// splits up to BALANCE_MAX_PLAYERS players into teams of fixed sizes so that the largest difference in total score between any two teams is as small as possible
+// players are stored as bits in a mask and the total score of every possible subset of players is precomputed once so a team score is a single table lookup
+// the search is a depth first branch and bound seeded with a greedy solution, teams of equal size are only visited in one order
+// the search never allocates and stops after a fixed number of nodes so the worst case cost doesn't depend on the machine or on the scores
+
+#define BALANCE_MAX_PLAYERS		12
+#define BALANCE_MAX_TEAMS		12
+#define BALANCE_DEFAULT_BUDGET	250000
+
+class CTeamBalancer
+{
+private:
+	uint32_t m_NumPlayers;
+	uint32_t m_NumTeams;
+	unsigned char m_TeamSizes[BALANCE_MAX_TEAMS];			// the team sizes in search order (largest first)
+	unsigned char m_TeamOrder[BALANCE_MAX_TEAMS];			// maps a search order position back to the caller's team index
+	double m_MaskScores[1 << BALANCE_MAX_PLAYERS];			// the total score of every subset of players
+	unsigned char m_MaskSizes[1 << BALANCE_MAX_PLAYERS];	// the number of players in every subset of players
+	uint16_t m_Teams[BALANCE_MAX_TEAMS];					// the teams being built by the search
+	uint16_t m_BestTeams[BALANCE_MAX_TEAMS];				// the best teams found so far, in the caller's team order
+	double m_BestSpread;
+	uint32_t m_Budget;
+	uint32_t m_Nodes;
+	bool m_Complete;
+
+public:
+	CTeamBalancer( );
+	~CTeamBalancer( );
+
+	// scores has numPlayers elements and teamSizes has numTeams elements, the team sizes must add up to numPlayers
+	// returns false if the input can't be balanced, otherwise the best teams found are available through GetTeam
+
+	bool Balance( const double *scores, uint32_t numPlayers, const unsigned char *teamSizes, uint32_t numTeams, uint32_t budget = BALANCE_DEFAULT_BUDGET );
+
+	uint16_t GetTeam( uint32_t team )	{ return team < m_NumTeams ? m_BestTeams[team] : 0; }
+	double GetSpread( )					{ return m_BestSpread; }
+	uint32_t GetNodes( )				{ return m_Nodes; }
+	bool GetComplete( )					{ return m_Complete; }
+
+private:
+	void Greedy( const double *scores );
+	void Search( uint32_t team, uint16_t remaining, double maxScore, double minScore );
+	void SaveBest( double spread );
+};
+
+#endif
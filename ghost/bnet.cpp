@@ -23,12 +23,16 @@
 #include "config.h"
 #include "language.h"
 #include "socket.h"
+#include "mailbox.h"
+#include "sendscheduler.h"
 #include "commandpacket.h"
 #include "ghostdb.h"
+#include "commandtable.h"
 #include "bncsutilinterface.h"
 #include "bnlsclient.h"
 #include "bnetprotocol.h"
 #include "bnet.h"
+#include "currentgames.h"
 #include "map.h"
 #include "packed.h"
 #include "savegame.h"
@@ -45,7 +49,7 @@ using namespace boost :: filesystem;
 // CBNET
 //
 
-CBNET :: CBNET( CGHost *nGHost, string nServer, string nServerAlias, string nBNLSServer, uint16_t nBNLSPort, uint32_t nBNLSWardenCookie, string nCDKeyROC, string nCDKeyTFT, string nCountryAbbrev, string nCountry, uint32_t nLocaleID, string nUserName, string nUserPassword, string nFirstChannel, string nRootAdmin, char nCommandTrigger, bool nHoldFriends, bool nHoldClan, bool nPublicCommands, unsigned char nWar3Version, BYTEARRAY nEXEVersion, BYTEARRAY nEXEVersionHash, string nPasswordHashType, string nPVPGNRealmName, uint32_t nMaxMessageLength, string nChildrenBotsNames, string nMasterBotName, uint32_t nHostCounterID )
+CBNET :: CBNET( CGHost *nGHost, string nServer, string nServerAlias, string nBNLSServer, uint16_t nBNLSPort, uint32_t nBNLSWardenCookie, string nCDKeyROC, string nCDKeyTFT, string nCountryAbbrev, string nCountry, uint32_t nLocaleID, string nUserName, string nUserPassword, string nFirstChannel, string nRootAdmin, char nCommandTrigger, bool nHoldFriends, bool nHoldClan, bool nPublicCommands, unsigned char nWar3Version, BYTEARRAY nEXEVersion, BYTEARRAY nEXEVersionHash, string nPasswordHashType, string nPVPGNRealmName, uint32_t nMaxMessageLength, string nChildrenBotsNames, string nMasterBotName, uint32_t nHostCounterID, uint32_t nFloodCapacity, uint32_t nFloodPacketCost, uint32_t nFloodTicksPerByte )
 {
 	// todotodo: append path seperator to Warcraft3Path if needed
 
@@ -54,8 +58,14 @@ CBNET :: CBNET( CGHost *nGHost, string nServer, string nServerAlias, string nBNL
 	m_Protocol = new CBNETProtocol( );
 	m_BNLSClient = NULL;
 	m_BNCSUtil = new CBNCSUtilInterface( nUserName, nUserPassword );
+	m_Callables = new CCallableInbox( m_GHost->m_WakeSocket );
+	m_Mailbox = new CMailbox<CBNETMessage>( m_GHost->m_WakeSocket );
+	m_CommandLimiter = new CCommandLimiter( );
+	m_SendScheduler = new CSendScheduler( nFloodCapacity, nFloodPacketCost, nFloodTicksPerByte );
 	m_CallableAdminList = m_GHost->m_DB->ThreadedAdminList( nServer );
+	m_Callables->Add( m_CallableAdminList, boost::bind( &CBNET :: EventCallableAdminList, this, _1 ) );
 	m_CallableBanList = m_GHost->m_DB->ThreadedBanList( nServer );
+	m_Callables->Add( m_CallableBanList, boost::bind( &CBNET :: EventCallableBanList, this, _1 ) );
 	m_Exiting = false;
 	m_Server = nServer;
 	string LowerServer = m_Server;
@@ -138,9 +148,7 @@ CBNET :: CBNET( CGHost *nGHost, string nServer, string nServerAlias, string nBNL
 	m_LastDisconnectedTime = 0;
 	m_LastConnectionAttemptTime = 0;
 	m_LastNullTime = 0;
-	m_LastOutPacketTicks = 0;
-	m_LastOutPacketSize = 0;
-	m_FrequencyDelayTimes = 0;
+	m_LastSendStatsTime = GetTime( );
 	m_LastAdminRefreshTime = GetTime( );
 	m_LastBanRefreshTime = GetTime( );
 	m_LastChildrenBotsFreeCheck = GetTime( );
@@ -176,43 +184,13 @@ CBNET :: ~CBNET( )
 	for( vector<CIncomingClanList *> :: iterator i = m_Clans.begin( ); i != m_Clans.end( ); ++i )
 		delete *i;
 
-	boost::mutex::scoped_lock lock( m_GHost->m_CallablesMutex );
-	
-	for( vector<PairedAdminCount> :: iterator i = m_PairedAdminCounts.begin( ); i != m_PairedAdminCounts.end( ); ++i )
-		m_GHost->m_Callables.push_back( i->second );
-
-	for( vector<PairedAdminAdd> :: iterator i = m_PairedAdminAdds.begin( ); i != m_PairedAdminAdds.end( ); ++i )
-		m_GHost->m_Callables.push_back( i->second );
-
-	for( vector<PairedAdminRemove> :: iterator i = m_PairedAdminRemoves.begin( ); i != m_PairedAdminRemoves.end( ); ++i )
-		m_GHost->m_Callables.push_back( i->second );
-
-	for( vector<PairedBanCount> :: iterator i = m_PairedBanCounts.begin( ); i != m_PairedBanCounts.end( ); ++i )
-		m_GHost->m_Callables.push_back( i->second );
-
-	for( vector<PairedBanAdd> :: iterator i = m_PairedBanAdds.begin( ); i != m_PairedBanAdds.end( ); ++i )
-		m_GHost->m_Callables.push_back( i->second );
-
-	for( vector<PairedBanRemove> :: iterator i = m_PairedBanRemoves.begin( ); i != m_PairedBanRemoves.end( ); ++i )
-		m_GHost->m_Callables.push_back( i->second );
-
-	for( vector<PairedGPSCheck> :: iterator i = m_PairedGPSChecks.begin( ); i != m_PairedGPSChecks.end( ); ++i )
-		m_GHost->m_Callables.push_back( i->second );
+	// the continuations reference this connection so anything still in flight is handed over to CGHost to be deleted when ready
 
-	for( vector<PairedDPSCheck> :: iterator i = m_PairedDPSChecks.begin( ); i != m_PairedDPSChecks.end( ); ++i )
-		m_GHost->m_Callables.push_back( i->second );
-	for (vector<PairedDPSCheckNew> ::iterator i = m_PairedDPSChecksNew.begin(); i != m_PairedDPSChecksNew.end(); ++i)
-		m_GHost->m_Callables.push_back(i->second);
-	for (vector<PairedCGQuery> ::iterator i = m_PairedCGQuery.begin(); i != m_PairedCGQuery.end(); ++i)
-		m_GHost->m_Callables.push_back(i->second);
-
-	if( m_CallableAdminList )
-		m_GHost->m_Callables.push_back( m_CallableAdminList );
-
-	if( m_CallableBanList )
-		m_GHost->m_Callables.push_back( m_CallableBanList );
-
-	lock.unlock( );
+	m_Callables->Orphan( m_GHost->m_Callables );
+	delete m_Callables;
+	delete m_Mailbox;
+	delete m_CommandLimiter;
+	delete m_SendScheduler;
 
 	boost::mutex::scoped_lock bansLock( m_BansMutex );
 
@@ -222,6 +200,67 @@ CBNET :: ~CBNET( )
 	bansLock.unlock( );
 }
 
+// the commands a user can use on battle.net, see BotCommand
+// the public database and game list commands are rate limited so nobody can flood the database with queries
+
+void CBNET :: RegisterCommands( CCommandTable *commands )
+{
+	commands->Add( CMD_ACCEPT, "accept", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_ADDADMIN, "addadmin", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_ADDBAN, "addban", "ban", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_AUTOHOST, "autohost", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_AUTOHOSTMM, "autohostmm", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_CHANNEL, "channel", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_CHECKADMIN, "checkadmin", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_COUNTADMINS, "countadmins", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_COUNTBANS, "countbans", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_DBSTATUS, "dbstatus", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_DELADMIN, "deladmin", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_DELBAN, "delban", "unban", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_DISABLE, "disable", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_ENABLE, "enable", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_ENFORCESG, "enforcesg", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_EXIT, "exit", "quit", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_GETCLAN, "getclan", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_GETFRIENDS, "getfriends", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_GETGAME, "getgame", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_GETGAMES, "getgames", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_GRUNT, "grunt", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_GS, "gs", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_HOSTSG, "hostsg", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_INVITE, "invite", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_LOAD, "load", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_LOADSG, "loadsg", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_MAP, "map", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_MOTD, "motd", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_PEON, "peon", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_RELOAD, "reload", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_REMOVE, "remove", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_SAY, "say", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_SAYGAMES, "saygames", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_SHAMAN, "shaman", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_UNHOST, "unhost", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_WARDENSTATUS, "wardenstatus", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_CHECKBAN, "checkban", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_FREECHECK, "freecheck", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_WHISPER );
+	commands->Add( CMD_GAME, "game", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_BNET, 3000 );
+	commands->Add( CMD_GAMES, "games", "activity", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_BNET, 3000 );
+	commands->Add( CMD_IMFREE, "imfree", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_WHISPER );
+	commands->Add( CMD_LOBBIES, "lobbies", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_BNET, 3000 );
+	commands->Add( CMD_LOBBY, "lobby", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_BNET, 3000 );
+	commands->Add( CMD_LOCALLOBBIES, "locallobbies", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_BNET, 3000 );
+	commands->Add( CMD_PUB, "pub", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_PRIV, "priv", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_PUBBY, "pubby", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_PRIVBY, "privby", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_PUBMASTER, "pubmaster", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_PRIVMASTER, "privmaster", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_BNET );
+	commands->Add( CMD_SD, "sd", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_BNET, 3000, CMD_SD );
+	commands->Add( CMD_STATS, "stats", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_BNET, 3000, CMD_SD );
+	commands->Add( CMD_STATSDOTA, "statsdota", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_BNET, 3000, CMD_SD );
+	commands->Add( CMD_VERSION, "version", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_BNET );
+}
+
 BYTEARRAY CBNET :: GetUniqueName( )
 {
 	return m_Protocol->GetUniqueName( );
@@ -245,289 +284,14 @@ unsigned int CBNET :: SetFD( void *fd, void *send_fd, int *nfds )
 
 bool CBNET :: Update( void *fd, void *send_fd )
 {
-	//
-	// update callables
-	//
-
-	for( vector<PairedAdminCount> :: iterator i = m_PairedAdminCounts.begin( ); i != m_PairedAdminCounts.end( ); )
-	{
-		if( i->second->GetReady( ) )
-		{
-			uint32_t Count = i->second->GetResult( );
-
-			if( Count == 0 )
-				QueueChatCommand( m_GHost->m_Language->ThereAreNoAdmins( m_Server ), i->first, !i->first.empty( ) );
-			else if( Count == 1 )
-				QueueChatCommand( m_GHost->m_Language->ThereIsAdmin( m_Server ), i->first, !i->first.empty( ) );
-			else
-				QueueChatCommand( m_GHost->m_Language->ThereAreAdmins( m_Server, UTIL_ToString( Count ) ), i->first, !i->first.empty( ) );
-
-			m_GHost->m_DB->RecoverCallable( i->second );
-			delete i->second;
-			i = m_PairedAdminCounts.erase( i );
-		}
-		else
-			++i;
-	}
-
-	for( vector<PairedAdminAdd> :: iterator i = m_PairedAdminAdds.begin( ); i != m_PairedAdminAdds.end( ); )
-	{
-		if( i->second->GetReady( ) )
-		{
-			if( i->second->GetResult( ) )
-			{
-				AddAdmin( i->second->GetUser( ) );
-				QueueChatCommand( m_GHost->m_Language->AddedUserToAdminDatabase( m_Server, i->second->GetUser( ) ), i->first, !i->first.empty( ) );
-			}
-			else
-				QueueChatCommand( m_GHost->m_Language->ErrorAddingUserToAdminDatabase( m_Server, i->second->GetUser( ) ), i->first, !i->first.empty( ) );
-
-			m_GHost->m_DB->RecoverCallable( i->second );
-			delete i->second;
-			i = m_PairedAdminAdds.erase( i );
-		}
-		else
-			++i;
-	}
-
-	for( vector<PairedAdminRemove> :: iterator i = m_PairedAdminRemoves.begin( ); i != m_PairedAdminRemoves.end( ); )
-	{
-		if( i->second->GetReady( ) )
-		{
-			if( i->second->GetResult( ) )
-			{
-				RemoveAdmin( i->second->GetUser( ) );
-				QueueChatCommand( m_GHost->m_Language->DeletedUserFromAdminDatabase( m_Server, i->second->GetUser( ) ), i->first, !i->first.empty( ) );
-			}
-			else
-				QueueChatCommand( m_GHost->m_Language->ErrorDeletingUserFromAdminDatabase( m_Server, i->second->GetUser( ) ), i->first, !i->first.empty( ) );
-
-			m_GHost->m_DB->RecoverCallable( i->second );
-			delete i->second;
-			i = m_PairedAdminRemoves.erase( i );
-		}
-		else
-			++i;
-	}
-
-	for( vector<PairedBanCount> :: iterator i = m_PairedBanCounts.begin( ); i != m_PairedBanCounts.end( ); )
-	{
-		if( i->second->GetReady( ) )
-		{
-			uint32_t Count = i->second->GetResult( );
-
-			if( Count == 0 )
-				QueueChatCommand( m_GHost->m_Language->ThereAreNoBannedUsers( m_Server ), i->first, !i->first.empty( ) );
-			else if( Count == 1 )
-				QueueChatCommand( m_GHost->m_Language->ThereIsBannedUser( m_Server ), i->first, !i->first.empty( ) );
-			else
-				QueueChatCommand( m_GHost->m_Language->ThereAreBannedUsers( m_Server, UTIL_ToString( Count ) ), i->first, !i->first.empty( ) );
-
-			m_GHost->m_DB->RecoverCallable( i->second );
-			delete i->second;
-			i = m_PairedBanCounts.erase( i );
-		}
-		else
-			++i;
-	}
-
-	for( vector<PairedBanAdd> :: iterator i = m_PairedBanAdds.begin( ); i != m_PairedBanAdds.end( ); )
-	{
-		if( i->second->GetReady( ) )
-		{
-			if( i->second->GetResult( ) )
-			{
-				AddBan( i->second->GetUser( ), i->second->GetIP( ), i->second->GetGameName( ), i->second->GetAdmin( ), i->second->GetReason( ) );
-				QueueChatCommand( m_GHost->m_Language->BannedUser( i->second->GetServer( ), i->second->GetUser( ) ), i->first, !i->first.empty( ) );
-			}
-			else
-				QueueChatCommand( m_GHost->m_Language->ErrorBanningUser( i->second->GetServer( ), i->second->GetUser( ) ), i->first, !i->first.empty( ) );
-
-			m_GHost->m_DB->RecoverCallable( i->second );
-			delete i->second;
-			i = m_PairedBanAdds.erase( i );
-		}
-		else
-			++i;
-	}
-
-	for( vector<PairedBanRemove> :: iterator i = m_PairedBanRemoves.begin( ); i != m_PairedBanRemoves.end( ); )
-	{
-		if( i->second->GetReady( ) )
-		{
-			if( i->second->GetResult( ) )
-			{
-				RemoveBan( i->second->GetUser( ) );
-				QueueChatCommand( m_GHost->m_Language->UnbannedUser( i->second->GetUser( ) ), i->first, !i->first.empty( ) );
-			}
-			else
-				QueueChatCommand( m_GHost->m_Language->ErrorUnbanningUser( i->second->GetUser( ) ), i->first, !i->first.empty( ) );
-
-			m_GHost->m_DB->RecoverCallable( i->second );
-			delete i->second;
-			i = m_PairedBanRemoves.erase( i );
-		}
-		else
-			++i;
-	}
-
-	for( vector<PairedGPSCheck> :: iterator i = m_PairedGPSChecks.begin( ); i != m_PairedGPSChecks.end( ); )
-	{
-		if( i->second->GetReady( ) )
-		{
-			CDBGamePlayerSummary *GamePlayerSummary = i->second->GetResult( );
-
-			if( GamePlayerSummary )
-				QueueChatCommand( m_GHost->m_Language->HasPlayedGamesWithThisBot( i->second->GetName( ), GamePlayerSummary->GetFirstGameDateTime( ), GamePlayerSummary->GetLastGameDateTime( ), UTIL_ToString( GamePlayerSummary->GetTotalGames( ) ), UTIL_ToString( (float)GamePlayerSummary->GetAvgLoadingTime( ) / 1000, 2 ), UTIL_ToString( GamePlayerSummary->GetAvgLeftPercent( ) ) ), i->first, !i->first.empty( ) );
-			else
-				QueueChatCommand( m_GHost->m_Language->HasntPlayedGamesWithThisBot( i->second->GetName( ) ), i->first, !i->first.empty( ) );
-
-			m_GHost->m_DB->RecoverCallable( i->second );
-			delete i->second;
-			i = m_PairedGPSChecks.erase( i );
-		}
-		else
-			++i;
-	}
-
-	for( vector<PairedDPSCheck> :: iterator i = m_PairedDPSChecks.begin( ); i != m_PairedDPSChecks.end( ); )
-	{
-		if( i->second->GetReady( ) )
-		{
-			CDBDotAPlayerSummary *DotAPlayerSummary = i->second->GetResult( );
-
-			if( DotAPlayerSummary )
-			{
-				string Summary = m_GHost->m_Language->HasPlayedDotAGamesWithThisBot(	i->second->GetName( ),
-					UTIL_ToString( DotAPlayerSummary->GetTotalGames( ) ),
-					UTIL_ToString( DotAPlayerSummary->GetTotalWins( ) ),
-					UTIL_ToString( DotAPlayerSummary->GetTotalLosses( ) ),
-					UTIL_ToString( DotAPlayerSummary->GetTotalKills( ) ),
-					UTIL_ToString( DotAPlayerSummary->GetTotalDeaths( ) ),
-					UTIL_ToString( DotAPlayerSummary->GetTotalCreepKills( ) ),
-					UTIL_ToString( DotAPlayerSummary->GetTotalCreepDenies( ) ),
-					UTIL_ToString( DotAPlayerSummary->GetTotalAssists( ) ),
-					UTIL_ToString( DotAPlayerSummary->GetTotalNeutralKills( ) ),
-					UTIL_ToString( DotAPlayerSummary->GetTotalTowerKills( ) ),
-					UTIL_ToString( DotAPlayerSummary->GetTotalRaxKills( ) ),
-					UTIL_ToString( DotAPlayerSummary->GetTotalCourierKills( ) ),
-					UTIL_ToString( DotAPlayerSummary->GetAvgKills( ), 2 ),
-					UTIL_ToString( DotAPlayerSummary->GetAvgDeaths( ), 2 ),
-					UTIL_ToString( DotAPlayerSummary->GetAvgCreepKills( ), 2 ),
-					UTIL_ToString( DotAPlayerSummary->GetAvgCreepDenies( ), 2 ),
-					UTIL_ToString( DotAPlayerSummary->GetAvgAssists( ), 2 ),
-					UTIL_ToString( DotAPlayerSummary->GetAvgNeutralKills( ), 2 ),
-					UTIL_ToString( DotAPlayerSummary->GetAvgTowerKills( ), 2 ),
-					UTIL_ToString( DotAPlayerSummary->GetAvgRaxKills( ), 2 ),
-					UTIL_ToString( DotAPlayerSummary->GetAvgCourierKills( ), 2 ) );
-
-				QueueChatCommand( Summary, i->first, !i->first.empty( ) );
-			}
-			else
-				QueueChatCommand( m_GHost->m_Language->HasntPlayedDotAGamesWithThisBot( i->second->GetName( ) ), i->first, !i->first.empty( ) );
-
-			m_GHost->m_DB->RecoverCallable( i->second );
-			delete i->second;
-			i = m_PairedDPSChecks.erase( i );
-		}
-		else
-			++i;
-	}
+	// run the continuations of any database callables which completed since the last update
+	// the wake socket is shared with CGHost and drained by the main loop
 
-	for (vector<PairedDPSCheckNew> ::iterator i = m_PairedDPSChecksNew.begin(); i != m_PairedDPSChecksNew.end(); )
-	{
-		if (i->second->GetReady())
-		{
-			CDBDotAPlayerSummaryNew* DotAPlayerSummary = i->second->GetResult();
+	m_Callables->Process( m_GHost->m_DB );
 
-			if (DotAPlayerSummary)
-			{
-				string SummaryMsg1 = "[" + i->second->GetName() + "] PSR: " + UTIL_ToString(DotAPlayerSummary->GetRating()) + " Games: " + UTIL_ToString(DotAPlayerSummary->GetTotalGames()) +
-					" (W/L: " + UTIL_ToString(DotAPlayerSummary->GetTotalWins()) + "/" + UTIL_ToString(DotAPlayerSummary->GetTotalLosses()) + ") Leave: " + UTIL_ToString(DotAPlayerSummary->GetLeavePercent(), 0) + "% WR: " + UTIL_ToString(DotAPlayerSummary->GetWinsPerGame(), 0) + "%" + "  PlayTime: " + UTIL_ToString((float_t)DotAPlayerSummary->GetTotalPlayedMinutes() / 60, 1) + "hr";
-				string SummaryMsg2 = "Hero KDA: " + UTIL_ToString(DotAPlayerSummary->GetKillsPerGame(), 2) + "/" + UTIL_ToString(DotAPlayerSummary->GetDeathsPerGame(), 2) + "/" + UTIL_ToString(DotAPlayerSummary->GetAssistsPerGame(), 2) +
-					" Creep KDN: " + UTIL_ToString(DotAPlayerSummary->GetCreepKillsPerGame(), 2) + "/" + UTIL_ToString(DotAPlayerSummary->GetCreepDeniesPerGame(), 2) + "/" + UTIL_ToString(DotAPlayerSummary->GetNeutralKillsPerGame(), 2);
-				QueueChatCommand(SummaryMsg1, i->first, !i->first.empty());
-				QueueChatCommand(SummaryMsg2, i->first, !i->first.empty());
-			}
-			else
-				QueueChatCommand(m_GHost->m_Language->HasntPlayedDotAGamesWithThisBot(i->second->GetName()), i->first, !i->first.empty());
-
-			m_GHost->m_DB->RecoverCallable(i->second);
-			delete i->second;
-			i = m_PairedDPSChecksNew.erase(i);
-		}
-		else
-			i++;
-	}
-
-	for (vector<PairedCGQuery> ::iterator i = m_PairedCGQuery.begin(); i != m_PairedCGQuery.end(); )
-	{
-		if (i->second->GetReady())
-		{
-			vector<CDBCurrentGame*> CurrGames = i->second->GetResult();
-			vector<string> Replies;
-
-			if (i->second->GetQueryLimit() > 0)
-			{
-				if (CurrGames.size())
-				{
-					uint32_t num = 1;
-
-					if (i->second->GetQueryLimit() > 1 && i->second->AreLobbiesIncluded())
-					{
-						Replies.push_back("Current open lobbies:");
-					}
-					for (vector<CDBCurrentGame*> ::iterator cg = CurrGames.begin(); cg != CurrGames.end(); cg++)
-					{
-						if (!(*cg)->m_GameStarted) //filter out ongoing games
-						{
-							string reply = "#" + UTIL_ToString(i->second->GetQueryOffset() + num) + " [" + (*cg)->m_GameName + " : " + (*cg)->m_OwnerName + "] [" + UTIL_ToString((*cg)->m_OccupiedSlots) + "/" + UTIL_ToString((*cg)->m_MaxSlots) + "] " + (!(*cg)->m_Names.empty() ? (*cg)->m_Names : "This lobby is empty.");
-							Replies.push_back(reply);
-							num++;
-						}
-					}
-
-					if (i->second->GetQueryLimit() > 1 && i->second->AreStartedGamesIncluded())
-					{
-						Replies.push_back("Current ongoing games:");
-					}
-					for (vector<CDBCurrentGame*> ::iterator cg = CurrGames.begin(); cg != CurrGames.end(); cg++)
-					{
-						if ((*cg)->m_GameStarted) //filter out lobbies
-						{
-							time_t t = time(nullptr);
-							uint32_t MinutesElapsed = (t - (*cg)->m_StartedAt) / 60;
-							//uint32_t minElp = time(nullptr) - time((*cg)->m_StartedAt);
-							string reply = "Game#" + UTIL_ToString(i->second->GetQueryOffset() + num) + " [" + (*cg)->m_GameName + "] (" + UTIL_ToString(MinutesElapsed) + "m) " + (!(*cg)->m_Names.empty() ? (*cg)->m_Names : "No Players");
-							Replies.push_back(reply);
-							num++;
-						}				
-					}		
-				}
-				else
-				{
-					if(i->second->GetQueryLimit() == 1)
-						Replies.push_back(i->second->AreLobbiesIncluded() ? "Lobby#" + UTIL_ToString(i->second->GetQueryOffset() + 1) + " does not exist" : "Game#" + UTIL_ToString(i->second->GetQueryOffset() + 1) + " does not exist");
-					else
-						Replies.push_back(i->second->AreLobbiesIncluded() ? "There are no open lobbies" : "There are no ongoing game");
-				}
-			}
-			else
-			{ //Activity query
-				Replies.push_back("Current ongoing games [" + UTIL_ToString(i->second->GetTotalOngoingGameCount()) + "], current open lobbies [" + UTIL_ToString(i->second->GetTotalLobbyCount()) + "]");
-			}
-
-			for (vector<string>::iterator reply = Replies.begin(); reply != Replies.end(); reply++)
-				QueueChatCommand((*reply), i->first, !i->first.empty());
-
-			m_GHost->m_DB->RecoverCallable(i->second);
-			delete i->second;
-			i = m_PairedCGQuery.erase(i);
-		}
-		else
-			i++;
-	}
+	// handle chat commands posted by game threads
 
+	ProcessMessages( );
 
 	if (m_GHost->m_MasterBotMode)
 	{
@@ -578,38 +342,17 @@ bool CBNET :: Update( void *fd, void *send_fd )
 	// refresh the admin list every 5 minutes
 
 	if( !m_CallableAdminList && GetTime( ) - m_LastAdminRefreshTime >= 300 )
-		m_CallableAdminList = m_GHost->m_DB->ThreadedAdminList( m_Server );
-
-	if( m_CallableAdminList && m_CallableAdminList->GetReady( ) )
 	{
-		// CONSOLE_Print( "[BNET: " + m_ServerAlias + "] refreshed admin list (" + UTIL_ToString( m_Admins.size( ) ) + " -> " + UTIL_ToString( m_CallableAdminList->GetResult( ).size( ) ) + " admins)" );
-		m_Admins = m_CallableAdminList->GetResult( );
-		m_GHost->m_DB->RecoverCallable( m_CallableAdminList );
-		delete m_CallableAdminList;
-		m_CallableAdminList = NULL;
-		m_LastAdminRefreshTime = GetTime( );
+		m_CallableAdminList = m_GHost->m_DB->ThreadedAdminList( m_Server );
+		m_Callables->Add( m_CallableAdminList, boost::bind( &CBNET :: EventCallableAdminList, this, _1 ) );
 	}
 
 	// refresh the ban list every 5 minutes
 
 	if( !m_CallableBanList && GetTime( ) - m_LastBanRefreshTime >= 300 )
-		m_CallableBanList = m_GHost->m_DB->ThreadedBanList( m_Server );
-
-	if( m_CallableBanList && m_CallableBanList->GetReady( ) )
 	{
-		// CONSOLE_Print( "[BNET: " + m_ServerAlias + "] refreshed ban list (" + UTIL_ToString( m_Bans.size( ) ) + " -> " + UTIL_ToString( m_CallableBanList->GetResult( ).size( ) ) + " bans)" );
-		boost::mutex::scoped_lock lock( m_BansMutex );
-		
-		for( vector<CDBBan *> :: iterator i = m_Bans.begin( ); i != m_Bans.end( ); ++i )
-			delete *i;
-
-		m_Bans = m_CallableBanList->GetResult( );
-		lock.unlock( );
-		
-		m_GHost->m_DB->RecoverCallable( m_CallableBanList );
-		delete m_CallableBanList;
-		m_CallableBanList = NULL;
-		m_LastBanRefreshTime = GetTime( );
+		m_CallableBanList = m_GHost->m_DB->ThreadedBanList( m_Server );
+		m_Callables->Add( m_CallableBanList, boost::bind( &CBNET :: EventCallableBanList, this, _1 ) );
 	}
 
 	// we return at the end of each if statement so we don't have to deal with errors related to the order of the if statements
@@ -683,73 +426,32 @@ bool CBNET :: Update( void *fd, void *send_fd )
 			}
 		}
 
-		// check if at least one packet is waiting to be sent and if we've waited long enough to prevent flooding
-		// this formula has changed many times but currently we wait 1 second if the last packet was "small", 3.5 seconds if it was "medium", and 4 seconds if it was "big"
+		// send every waiting packet the server's flood protection would accept now
+		// whatever is left over is sent in a later update, CGHost :: Update wakes up in time for it using GetNextSendTicks
 
-		uint32_t WaitTicks = 0;
+		boost::mutex::scoped_lock packetsLock( m_PacketsMutex );
+		BYTEARRAY Packet;
 
-		//Old
-		/*
-		if( m_LastOutPacketSize < 10 )
-			WaitTicks = 1300;
-		else if( m_LastOutPacketSize < 30 )
-			WaitTicks = 3400;
-		else if( m_LastOutPacketSize < 50 )
-			WaitTicks = 3600;
-		else if( m_LastOutPacketSize < 100 )
-			WaitTicks = 3900;
-		else
-			WaitTicks = 5500;
-		*/
+		while( m_SendScheduler->Pop( Packet, GetTicks( ) ) )
+			m_Socket->PutBytes( Packet );
 
-		uint32_t medium = 3200; //3200
-		uint32_t big = 4000;	//4000
+		uint32_t LastSentTicks = m_SendScheduler->GetLastSentTicks( );
+		string SendStats;
 
-		if (m_PasswordHashType == "pvpgn")
+		if( GetTime( ) - m_LastSendStatsTime >= 300 )
 		{
-			medium = 250;	//2000
-			big = 500;		//2500
+			SendStats = m_SendScheduler->GetStatsSummary( );
+			m_LastSendStatsTime = GetTime( );
 		}
 
-		if (m_LastOutPacketSize < 10)
-			WaitTicks = 100; // 1000
-		else if (m_LastOutPacketSize < 100)
-			WaitTicks = medium;
-		else
-			WaitTicks = big;
-
-
-		
-		// add on frequency delay
-		
-		WaitTicks += m_FrequencyDelayTimes * 60;
-
-		boost::mutex::scoped_lock packetsLock( m_PacketsMutex );
-		
-		if( !m_OutPackets.empty( ) && GetTicks( ) - m_LastOutPacketTicks >= WaitTicks )
-		{
-			if( m_OutPackets.size( ) > 7 )
-				CONSOLE_Print( "[BNET: " + m_ServerAlias + "] packet queue warning - there are " + UTIL_ToString( m_OutPackets.size( ) ) + " packets waiting to be sent" );
-
-			m_Socket->PutBytes( m_OutPackets.front( ) );
-			m_LastOutPacketSize = m_OutPackets.front( ).size( );
-			m_OutPackets.pop( );
-
-			// reset frequency delay (or increment it)
-			
-			if( m_FrequencyDelayTimes >= 100 || GetTicks( ) > m_LastOutPacketTicks + WaitTicks + 500 )
-				m_FrequencyDelayTimes = 0;
-			else
-				m_FrequencyDelayTimes++;
-			
-			m_LastOutPacketTicks = GetTicks( );
-		}
-		
 		packetsLock.unlock( );
 
+		if( !SendStats.empty( ) )
+			CONSOLE_Print( "[BNET: " + m_ServerAlias + "] send queue in the last 5 minutes: " + SendStats );
+
 		// send a null packet every 60 seconds to detect disconnects
 
-		if( GetTime( ) - m_LastNullTime >= 60 && GetTicks( ) - m_LastOutPacketTicks >= 60000 )
+		if( GetTime( ) - m_LastNullTime >= 60 && GetTicks( ) - LastSentTicks >= 60000 )
 		{
 			m_Socket->PutBytes( m_Protocol->SEND_SID_NULL( ) );
 			m_LastNullTime = GetTime( );
@@ -773,13 +475,9 @@ bool CBNET :: Update( void *fd, void *send_fd )
 			m_Socket->PutBytes( m_Protocol->SEND_SID_AUTH_INFO( m_War3Version, m_GHost->m_TFT, m_LocaleID, m_CountryAbbrev, m_Country ) );
 			m_Socket->DoSend( (fd_set *)send_fd );
 			m_LastNullTime = GetTime( );
-			m_LastOutPacketTicks = GetTicks( );
 
 			boost::mutex::scoped_lock packetsLock( m_PacketsMutex );
-			
-			while( !m_OutPackets.empty( ) )
-				m_OutPackets.pop( );
-
+			m_SendScheduler->Reset( GetTicks( ) );
 			packetsLock.unlock( );
 
 			return m_Exiting;
@@ -845,6 +543,218 @@ bool CBNET :: Update( void *fd, void *send_fd )
 	return m_Exiting;
 }
 
+void CBNET :: EventCallableAdminList( CCallableAdminList *callable )
+{
+	// CONSOLE_Print( "[BNET: " + m_ServerAlias + "] refreshed admin list (" + UTIL_ToString( m_Admins.size( ) ) + " -> " + UTIL_ToString( callable->GetResult( ).size( ) ) + " admins)" );
+	m_Admins = callable->GetResult( );
+	m_CallableAdminList = NULL;
+	m_LastAdminRefreshTime = GetTime( );
+}
+
+void CBNET :: EventCallableBanList( CCallableBanList *callable )
+{
+	// CONSOLE_Print( "[BNET: " + m_ServerAlias + "] refreshed ban list (" + UTIL_ToString( m_Bans.size( ) ) + " -> " + UTIL_ToString( callable->GetResult( ).size( ) ) + " bans)" );
+	boost::mutex::scoped_lock lock( m_BansMutex );
+
+	for( vector<CDBBan *> :: iterator i = m_Bans.begin( ); i != m_Bans.end( ); ++i )
+		delete *i;
+
+	m_Bans = callable->GetResult( );
+	lock.unlock( );
+
+	m_CallableBanList = NULL;
+	m_LastBanRefreshTime = GetTime( );
+}
+
+void CBNET :: EventCallableAdminCount( string user, CCallableAdminCount *callable )
+{
+	uint32_t Count = callable->GetResult( );
+
+	if( Count == 0 )
+		QueueChatCommand( m_GHost->m_Language->ThereAreNoAdmins( m_Server ), user, !user.empty( ) );
+	else if( Count == 1 )
+		QueueChatCommand( m_GHost->m_Language->ThereIsAdmin( m_Server ), user, !user.empty( ) );
+	else
+		QueueChatCommand( m_GHost->m_Language->ThereAreAdmins( m_Server, UTIL_ToString( Count ) ), user, !user.empty( ) );
+}
+
+void CBNET :: EventCallableAdminAdd( string user, CCallableAdminAdd *callable )
+{
+	if( callable->GetResult( ) )
+	{
+		AddAdmin( callable->GetUser( ) );
+		QueueChatCommand( m_GHost->m_Language->AddedUserToAdminDatabase( m_Server, callable->GetUser( ) ), user, !user.empty( ) );
+	}
+	else
+		QueueChatCommand( m_GHost->m_Language->ErrorAddingUserToAdminDatabase( m_Server, callable->GetUser( ) ), user, !user.empty( ) );
+}
+
+void CBNET :: EventCallableAdminRemove( string user, CCallableAdminRemove *callable )
+{
+	if( callable->GetResult( ) )
+	{
+		RemoveAdmin( callable->GetUser( ) );
+		QueueChatCommand( m_GHost->m_Language->DeletedUserFromAdminDatabase( m_Server, callable->GetUser( ) ), user, !user.empty( ) );
+	}
+	else
+		QueueChatCommand( m_GHost->m_Language->ErrorDeletingUserFromAdminDatabase( m_Server, callable->GetUser( ) ), user, !user.empty( ) );
+}
+
+void CBNET :: EventCallableBanCount( string user, CCallableBanCount *callable )
+{
+	uint32_t Count = callable->GetResult( );
+
+	if( Count == 0 )
+		QueueChatCommand( m_GHost->m_Language->ThereAreNoBannedUsers( m_Server ), user, !user.empty( ) );
+	else if( Count == 1 )
+		QueueChatCommand( m_GHost->m_Language->ThereIsBannedUser( m_Server ), user, !user.empty( ) );
+	else
+		QueueChatCommand( m_GHost->m_Language->ThereAreBannedUsers( m_Server, UTIL_ToString( Count ) ), user, !user.empty( ) );
+}
+
+void CBNET :: EventCallableBanAdd( string user, CCallableBanAdd *callable )
+{
+	if( callable->GetResult( ) )
+	{
+		AddBan( callable->GetUser( ), callable->GetIP( ), callable->GetGameName( ), callable->GetAdmin( ), callable->GetReason( ) );
+		QueueChatCommand( m_GHost->m_Language->BannedUser( callable->GetServer( ), callable->GetUser( ) ), user, !user.empty( ) );
+	}
+	else
+		QueueChatCommand( m_GHost->m_Language->ErrorBanningUser( callable->GetServer( ), callable->GetUser( ) ), user, !user.empty( ) );
+}
+
+void CBNET :: EventCallableBanRemove( string user, CCallableBanRemove *callable )
+{
+	if( callable->GetResult( ) )
+	{
+		RemoveBan( callable->GetUser( ) );
+		QueueChatCommand( m_GHost->m_Language->UnbannedUser( callable->GetUser( ) ), user, !user.empty( ) );
+	}
+	else
+		QueueChatCommand( m_GHost->m_Language->ErrorUnbanningUser( callable->GetUser( ) ), user, !user.empty( ) );
+}
+
+void CBNET :: EventCallableGamePlayerSummaryCheck( string user, CCallableGamePlayerSummaryCheck *callable )
+{
+	CDBGamePlayerSummary *GamePlayerSummary = callable->GetResult( );
+
+	if( GamePlayerSummary )
+		QueueChatCommand( m_GHost->m_Language->HasPlayedGamesWithThisBot( callable->GetName( ), GamePlayerSummary->GetFirstGameDateTime( ), GamePlayerSummary->GetLastGameDateTime( ), UTIL_ToString( GamePlayerSummary->GetTotalGames( ) ), UTIL_ToString( (float)GamePlayerSummary->GetAvgLoadingTime( ) / 1000, 2 ), UTIL_ToString( GamePlayerSummary->GetAvgLeftPercent( ) ) ), user, !user.empty( ) );
+	else
+		QueueChatCommand( m_GHost->m_Language->HasntPlayedGamesWithThisBot( callable->GetName( ) ), user, !user.empty( ) );
+}
+
+void CBNET :: EventCallableDotAPlayerSummaryCheck( string user, CCallableDotAPlayerSummaryCheck *callable )
+{
+	CDBDotAPlayerSummary *DotAPlayerSummary = callable->GetResult( );
+
+	if( DotAPlayerSummary )
+	{
+		string Summary = m_GHost->m_Language->HasPlayedDotAGamesWithThisBot(	callable->GetName( ),
+			UTIL_ToString( DotAPlayerSummary->GetTotalGames( ) ),
+			UTIL_ToString( DotAPlayerSummary->GetTotalWins( ) ),
+			UTIL_ToString( DotAPlayerSummary->GetTotalLosses( ) ),
+			UTIL_ToString( DotAPlayerSummary->GetTotalKills( ) ),
+			UTIL_ToString( DotAPlayerSummary->GetTotalDeaths( ) ),
+			UTIL_ToString( DotAPlayerSummary->GetTotalCreepKills( ) ),
+			UTIL_ToString( DotAPlayerSummary->GetTotalCreepDenies( ) ),
+			UTIL_ToString( DotAPlayerSummary->GetTotalAssists( ) ),
+			UTIL_ToString( DotAPlayerSummary->GetTotalNeutralKills( ) ),
+			UTIL_ToString( DotAPlayerSummary->GetTotalTowerKills( ) ),
+			UTIL_ToString( DotAPlayerSummary->GetTotalRaxKills( ) ),
+			UTIL_ToString( DotAPlayerSummary->GetTotalCourierKills( ) ),
+			UTIL_ToString( DotAPlayerSummary->GetAvgKills( ), 2 ),
+			UTIL_ToString( DotAPlayerSummary->GetAvgDeaths( ), 2 ),
+			UTIL_ToString( DotAPlayerSummary->GetAvgCreepKills( ), 2 ),
+			UTIL_ToString( DotAPlayerSummary->GetAvgCreepDenies( ), 2 ),
+			UTIL_ToString( DotAPlayerSummary->GetAvgAssists( ), 2 ),
+			UTIL_ToString( DotAPlayerSummary->GetAvgNeutralKills( ), 2 ),
+			UTIL_ToString( DotAPlayerSummary->GetAvgTowerKills( ), 2 ),
+			UTIL_ToString( DotAPlayerSummary->GetAvgRaxKills( ), 2 ),
+			UTIL_ToString( DotAPlayerSummary->GetAvgCourierKills( ), 2 ) );
+
+		QueueChatCommand( Summary, user, !user.empty( ) );
+	}
+	else
+		QueueChatCommand( m_GHost->m_Language->HasntPlayedDotAGamesWithThisBot( callable->GetName( ) ), user, !user.empty( ) );
+}
+
+void CBNET :: EventCallableDotAPlayerSummaryCheckNew( string user, CCallableDotAPlayerSummaryCheckNew *callable )
+{
+	CDBDotAPlayerSummaryNew* DotAPlayerSummary = callable->GetResult();
+
+	if (DotAPlayerSummary)
+	{
+		string SummaryMsg1 = "[" + callable->GetName() + "] PSR: " + UTIL_ToString(DotAPlayerSummary->GetRating()) + " Games: " + UTIL_ToString(DotAPlayerSummary->GetTotalGames()) +
+			" (W/L: " + UTIL_ToString(DotAPlayerSummary->GetTotalWins()) + "/" + UTIL_ToString(DotAPlayerSummary->GetTotalLosses()) + ") Leave: " + UTIL_ToString(DotAPlayerSummary->GetLeavePercent(), 0) + "% WR: " + UTIL_ToString(DotAPlayerSummary->GetWinsPerGame(), 0) + "%" + "  PlayTime: " + UTIL_ToString((float_t)DotAPlayerSummary->GetTotalPlayedMinutes() / 60, 1) + "hr";
+		string SummaryMsg2 = "Hero KDA: " + UTIL_ToString(DotAPlayerSummary->GetKillsPerGame(), 2) + "/" + UTIL_ToString(DotAPlayerSummary->GetDeathsPerGame(), 2) + "/" + UTIL_ToString(DotAPlayerSummary->GetAssistsPerGame(), 2) +
+			" Creep KDN: " + UTIL_ToString(DotAPlayerSummary->GetCreepKillsPerGame(), 2) + "/" + UTIL_ToString(DotAPlayerSummary->GetCreepDeniesPerGame(), 2) + "/" + UTIL_ToString(DotAPlayerSummary->GetNeutralKillsPerGame(), 2);
+		QueueChatCommand(SummaryMsg1, user, !user.empty());
+		QueueChatCommand(SummaryMsg2, user, !user.empty());
+	}
+	else
+		QueueChatCommand(m_GHost->m_Language->HasntPlayedDotAGamesWithThisBot(callable->GetName()), user, !user.empty());
+}
+
+void CBNET :: EventCallableCurrentGamesQuery( string user, CCallableCurrentGamesQuery *callable )
+{
+	vector<CDBCurrentGame*> CurrGames = callable->GetResult();
+	vector<string> Replies;
+
+	if (callable->GetQueryLimit() > 0)
+	{
+		if (CurrGames.size())
+		{
+			uint32_t num = 1;
+
+			if (callable->GetQueryLimit() > 1 && callable->AreLobbiesIncluded())
+			{
+				Replies.push_back("Current open lobbies:");
+			}
+			for (vector<CDBCurrentGame*> ::iterator cg = CurrGames.begin(); cg != CurrGames.end(); cg++)
+			{
+				if (!(*cg)->m_GameStarted) //filter out ongoing games
+				{
+					string reply = "#" + UTIL_ToString(callable->GetQueryOffset() + num) + " [" + (*cg)->m_GameName + " : " + (*cg)->m_OwnerName + "] [" + UTIL_ToString((*cg)->m_OccupiedSlots) + "/" + UTIL_ToString((*cg)->m_MaxSlots) + "] " + (!(*cg)->m_Names.empty() ? (*cg)->m_Names : "This lobby is empty.");
+					Replies.push_back(reply);
+					num++;
+				}
+			}
+
+			if (callable->GetQueryLimit() > 1 && callable->AreStartedGamesIncluded())
+			{
+				Replies.push_back("Current ongoing games:");
+			}
+			for (vector<CDBCurrentGame*> ::iterator cg = CurrGames.begin(); cg != CurrGames.end(); cg++)
+			{
+				if ((*cg)->m_GameStarted) //filter out lobbies
+				{
+					time_t t = time(nullptr);
+					uint32_t MinutesElapsed = (t - (*cg)->m_StartedAt) / 60;
+					//uint32_t minElp = time(nullptr) - time((*cg)->m_StartedAt);
+					string reply = "Game#" + UTIL_ToString(callable->GetQueryOffset() + num) + " [" + (*cg)->m_GameName + "] (" + UTIL_ToString(MinutesElapsed) + "m) " + (!(*cg)->m_Names.empty() ? (*cg)->m_Names : "No Players");
+					Replies.push_back(reply);
+					num++;
+				}				
+			}		
+		}
+		else
+		{
+			if(callable->GetQueryLimit() == 1)
+				Replies.push_back(callable->AreLobbiesIncluded() ? "Lobby#" + UTIL_ToString(callable->GetQueryOffset() + 1) + " does not exist" : "Game#" + UTIL_ToString(callable->GetQueryOffset() + 1) + " does not exist");
+			else
+				Replies.push_back(callable->AreLobbiesIncluded() ? "There are no open lobbies" : "There are no ongoing game");
+		}
+	}
+	else
+	{ //Activity query
+		Replies.push_back("Current ongoing games [" + UTIL_ToString(callable->GetTotalOngoingGameCount()) + "], current open lobbies [" + UTIL_ToString(callable->GetTotalLobbyCount()) + "]");
+	}
+
+	for (vector<string>::iterator reply = Replies.begin(); reply != Replies.end(); reply++)
+		QueueChatCommand((*reply), user, !user.empty());
+}
+
 void CBNET :: ExtractPackets( )
 {
 	// extract as many packets as possible from the socket's receive buffer and put them in the m_Packets queue
@@ -1209,16 +1119,13 @@ void CBNET :: ProcessChatEvent( CIncomingChatEvent *chatEvent )
 		if( Event == CBNETProtocol :: EID_WHISPER && m_GHost->m_CurrentGame )
 		{
 			bool Success = false;
-			QueuedSpoofAdd SpoofAdd;
-			SpoofAdd.server = m_Server;
-			SpoofAdd.name = User;
-			SpoofAdd.sendMessage = false;
-			SpoofAdd.failMessage = string( );
+			string SpoofName = User;
+			bool SpoofSendMessage = false;
 			
 			if( Message == "s" || Message == "sc" || Message == "spoof" || Message == "check" || Message == "spoofcheck" )
 			{
 				Success = true;
-				SpoofAdd.sendMessage = true;
+				SpoofSendMessage = true;
 			}
 			
 			else if( Message.find( m_GHost->m_CurrentGame->GetGameName( ) ) != string :: npos )
@@ -1234,25 +1141,21 @@ void CBNET :: ProcessChatEvent( CIncomingChatEvent *chatEvent )
 					vector<string> Tokens = UTIL_Tokenize( Message, ' ' );
 
 					if( Tokens.size( ) >= 3 )
-						SpoofAdd.name = Tokens[2];
+						SpoofName = Tokens[2];
 				}
 				
 				Success = true;
 			}
 			
 			if( Success )
-			{
-				boost::mutex::scoped_lock spoofLock( m_GHost->m_CurrentGame->m_SpoofAddMutex );
-				m_GHost->m_CurrentGame->m_DoSpoofAdd.push_back( SpoofAdd );
-				spoofLock.unlock( );
-			}
+				m_GHost->m_CurrentGame->PostSpoofAdd( m_Server, SpoofName, SpoofSendMessage, string( ) );
 		}
 		
 		lock.unlock( );
 
 		// handle bot commands
 
-		if( Message == "?trigger" && ( IsAdmin( User ) || IsRootAdmin( User ) || ( m_PublicCommands && m_OutPackets.size( ) <= 3 ) ) )
+		if( Message == "?trigger" && ( IsAdmin( User ) || IsRootAdmin( User ) || ( m_PublicCommands && GetOutPacketsQueued( ) <= 3 ) ) )
 			QueueChatCommand( m_GHost->m_Language->CommandTrigger( string( 1, m_CommandTrigger ) ), User, Whisper );
 		else if( !Message.empty( ) && Message[0] == m_CommandTrigger )
 		{
@@ -1305,11 +1208,7 @@ void CBNET :: ProcessChatEvent( CIncomingChatEvent *chatEvent )
 				FailMessage = m_GHost->m_Language->SpoofDetectedIsInPrivateChannel( UserName );
 			
 			if( !FailMessage.empty( ) )
-			{
-				boost::mutex::scoped_lock sayLock( m_GHost->m_CurrentGame->m_SayGamesMutex );
-				m_GHost->m_CurrentGame->m_DoSayGames.push_back( FailMessage );
-				sayLock.unlock( );
-			}
+				m_GHost->m_CurrentGame->PostSayGame( FailMessage );
 
 			if( Message.find( "is using Warcraft III The Frozen Throne in game" ) != string :: npos || Message.find( "is using Warcraft III Frozen Throne and is currently in  game" ) != string :: npos )
 			{
@@ -1317,18 +1216,12 @@ void CBNET :: ProcessChatEvent( CIncomingChatEvent *chatEvent )
 				// this is because when the game is rehosted, players who joined recently will be in the previous game according to battle.net
 				// note: if the game is rehosted more than once it is possible (but unlikely) for a false positive because only two game names are checked
 
-				QueuedSpoofAdd SpoofAdd;
-				SpoofAdd.server = m_Server;
-				SpoofAdd.name = UserName;
-				SpoofAdd.sendMessage = false;
-				SpoofAdd.failMessage = string( );
+				string SpoofFailMessage;
 
 				if( Message.find( m_GHost->m_CurrentGame->GetGameName( ) ) == string :: npos && Message.find( m_GHost->m_CurrentGame->GetLastGameName( ) ) == string :: npos )
-					SpoofAdd.failMessage = m_GHost->m_Language->SpoofDetectedIsInAnotherGame( UserName );
+					SpoofFailMessage = m_GHost->m_Language->SpoofDetectedIsInAnotherGame( UserName );
 				
-				boost::mutex::scoped_lock spoofLock( m_GHost->m_CurrentGame->m_SpoofAddMutex );
-				m_GHost->m_CurrentGame->m_DoSpoofAdd.push_back( SpoofAdd );
-				spoofLock.unlock( );
+				m_GHost->m_CurrentGame->PostSpoofAdd( m_Server, UserName, false, SpoofFailMessage );
 			}
 		}
 		
@@ -1361,6 +1254,18 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 
 	transform( Command.begin( ), Command.end( ), Command.begin( ), (int(*)(int))tolower );
 
+	// look the command up before doing anything else so unknown commands don't cost us the admin checks below
+
+	const CCommand *BotCommand = m_GHost->m_BNETCommands->Find( Command );
+
+	if( !BotCommand || !BotCommand->HasContext( Whisper ? COMMAND_CONTEXT_WHISPER : COMMAND_CONTEXT_CHANNEL ) )
+		return;
+
+	if( !m_CommandLimiter->Allow( BotCommand, User, GetTicks( ) ) )
+		return;
+
+	uint32_t CommandID = BotCommand->m_ID;
+
 	if( IsAdmin( User ) || IsRootAdmin( User ) || ForceRoot )
 	{
 		CONSOLE_Print( "[BNET: " + m_ServerAlias + "] admin [" + User + "] sent command [" + Message + "]" );
@@ -1373,7 +1278,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !ACCEPT
 		//
 
-		if( Command == "accept" )
+		if( CommandID == CMD_ACCEPT )
 		{
 			if( IsRootAdmin( User ) || ForceRoot )
 				SendClanAcceptInvite( true );
@@ -1385,14 +1290,14 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !ADDADMIN
 		//
 
-		if( Command == "addadmin" && !Payload.empty( ) )
+		if( CommandID == CMD_ADDADMIN && !Payload.empty( ) )
 		{
 			if( IsRootAdmin( User ) || ForceRoot )
 			{
 				if( IsAdmin( Payload ) )
 					QueueChatCommand( m_GHost->m_Language->UserIsAlreadyAnAdmin( m_Server, Payload ), User, Whisper );
 				else
-					m_PairedAdminAdds.push_back( PairedAdminAdd( Whisper ? User : string( ), m_GHost->m_DB->ThreadedAdminAdd( m_Server, Payload ) ) );
+					m_Callables->Add( m_GHost->m_DB->ThreadedAdminAdd( m_Server, Payload ), boost::bind( &CBNET :: EventCallableAdminAdd, this, Whisper ? User : string( ), _1 ) );
 			}
 			else
 				QueueChatCommand( m_GHost->m_Language->YouDontHaveAccessToThatCommand( ), User, Whisper );
@@ -1403,7 +1308,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !BAN
 		//
 
-		else if( ( Command == "addban" || Command == "ban" ) && !Payload.empty( ) )
+		else if( CommandID == CMD_ADDBAN && !Payload.empty( ) )
 		{
 			// extract the victim and the reason
 			// e.g. "Varlock leaver after dying" -> victim: "Varlock", reason: "leaver after dying"
@@ -1426,14 +1331,14 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 			if( IsBannedName( Victim ) )
 				QueueChatCommand( m_GHost->m_Language->UserIsAlreadyBanned( m_Server, Victim ), User, Whisper );
 			else
-				m_PairedBanAdds.push_back( PairedBanAdd( Whisper ? User : string( ), m_GHost->m_DB->ThreadedBanAdd( m_Server, Victim, string( ), string( ), User, Reason ) ) );
+				m_Callables->Add( m_GHost->m_DB->ThreadedBanAdd( m_Server, Victim, string( ), string( ), User, Reason ), boost::bind( &CBNET :: EventCallableBanAdd, this, Whisper ? User : string( ), _1 ) );
 		}
 
 		//
 		// !AUTOHOST
 		//
 
-		else if( Command == "autohost" )
+		else if( CommandID == CMD_AUTOHOST )
 		{
 			if( IsRootAdmin( User ) || ForceRoot )
 			{
@@ -1507,7 +1412,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !AUTOHOSTMM
 		//
 
-		else if( Command == "autohostmm" )
+		else if( CommandID == CMD_AUTOHOSTMM )
 		{
 			if( IsRootAdmin( User ) || ForceRoot )
 			{
@@ -1597,14 +1502,14 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !CHANNEL (change channel)
 		//
 
-		else if( Command == "channel" && !Payload.empty( ) )
+		else if( CommandID == CMD_CHANNEL && !Payload.empty( ) )
 			QueueChatCommand( "/join " + Payload );
 
 		//
 		// !CHECKADMIN
 		//
 
-		else if( Command == "checkadmin" && !Payload.empty( ) )
+		else if( CommandID == CMD_CHECKADMIN && !Payload.empty( ) )
 		{
 			if( IsRootAdmin( User ) || ForceRoot )
 			{
@@ -1621,10 +1526,10 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !COUNTADMINS
 		//
 
-		else if( Command == "countadmins" )
+		else if( CommandID == CMD_COUNTADMINS )
 		{
 			if( IsRootAdmin( User ) || ForceRoot )
-				m_PairedAdminCounts.push_back( PairedAdminCount( Whisper ? User : string( ), m_GHost->m_DB->ThreadedAdminCount( m_Server ) ) );
+				m_Callables->Add( m_GHost->m_DB->ThreadedAdminCount( m_Server ), boost::bind( &CBNET :: EventCallableAdminCount, this, Whisper ? User : string( ), _1 ) );
 			else
 				QueueChatCommand( m_GHost->m_Language->YouDontHaveAccessToThatCommand( ), User, Whisper );
 		}
@@ -1633,31 +1538,31 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !COUNTBANS
 		//
 
-		else if (Command == "countbans")
+		else if (CommandID == CMD_COUNTBANS)
 		{
-			m_PairedBanCounts.push_back(PairedBanCount(Whisper ? User : string(), m_GHost->m_DB->ThreadedBanCount(m_Server)));
-			m_PairedBanCounts.push_back(PairedBanCount(Whisper ? User : string(), m_GHost->m_DB->ThreadedBanCount(string())));
+			m_Callables->Add( m_GHost->m_DB->ThreadedBanCount(m_Server), boost::bind( &CBNET :: EventCallableBanCount, this, Whisper ? User : string(), _1 ) );
+			m_Callables->Add( m_GHost->m_DB->ThreadedBanCount(string()), boost::bind( &CBNET :: EventCallableBanCount, this, Whisper ? User : string(), _1 ) );
 		}
 
 		//
 		// !DBSTATUS
 		//
 
-		else if( Command == "dbstatus" )
+		else if( CommandID == CMD_DBSTATUS )
 			QueueChatCommand( m_GHost->m_DB->GetStatus( ), User, Whisper );
 
 		//
 		// !DELADMIN
 		//
 
-		else if( Command == "deladmin" && !Payload.empty( ) )
+		else if( CommandID == CMD_DELADMIN && !Payload.empty( ) )
 		{
 			if( IsRootAdmin( User ) || ForceRoot )
 			{
 				if( !IsAdmin( Payload ) )
 					QueueChatCommand( m_GHost->m_Language->UserIsNotAnAdmin( m_Server, Payload ), User, Whisper );
 				else
-					m_PairedAdminRemoves.push_back( PairedAdminRemove( Whisper ? User : string( ), m_GHost->m_DB->ThreadedAdminRemove( m_Server, Payload ) ) );
+					m_Callables->Add( m_GHost->m_DB->ThreadedAdminRemove( m_Server, Payload ), boost::bind( &CBNET :: EventCallableAdminRemove, this, Whisper ? User : string( ), _1 ) );
 			}
 			else
 				QueueChatCommand( m_GHost->m_Language->YouDontHaveAccessToThatCommand( ), User, Whisper );
@@ -1668,14 +1573,14 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !UNBAN
 		//
 
-		else if( ( Command == "delban" || Command == "unban" ) && !Payload.empty( ) )
-			m_PairedBanRemoves.push_back( PairedBanRemove( Whisper ? User : string( ), m_GHost->m_DB->ThreadedBanRemove( Payload ) ) );
+		else if( CommandID == CMD_DELBAN && !Payload.empty( ) )
+			m_Callables->Add( m_GHost->m_DB->ThreadedBanRemove( Payload ), boost::bind( &CBNET :: EventCallableBanRemove, this, Whisper ? User : string( ), _1 ) );
 
 		//
 		// !DISABLE
 		//
 
-		else if( Command == "disable" )
+		else if( CommandID == CMD_DISABLE )
 		{
 			if( IsRootAdmin( User ) || ForceRoot )
 			{
@@ -1690,7 +1595,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !ENABLE
 		//
 
-		else if( Command == "enable" )
+		else if( CommandID == CMD_ENABLE )
 		{
 			if( IsRootAdmin( User ) || ForceRoot )
 			{
@@ -1705,7 +1610,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !ENFORCESG
 		//
 
-		else if( Command == "enforcesg" && !Payload.empty( ) )
+		else if( CommandID == CMD_ENFORCESG && !Payload.empty( ) )
 		{
 			// only load files in the current directory just to be safe
 
@@ -1734,7 +1639,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !QUIT
 		//
 
-		else if( Command == "exit" || Command == "quit" )
+		else if( CommandID == CMD_EXIT )
 		{
 			if( IsRootAdmin( User ) || ForceRoot )
 			{
@@ -1758,7 +1663,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !GETCLAN
 		//
 
-		else if( Command == "getclan" )
+		else if( CommandID == CMD_GETCLAN )
 		{
 			SendGetClanList( );
 			QueueChatCommand( m_GHost->m_Language->UpdatingClanList( ), User, Whisper );
@@ -1768,7 +1673,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !GETFRIENDS
 		//
 
-		else if( Command == "getfriends" )
+		else if( CommandID == CMD_GETFRIENDS )
 		{
 			SendGetFriendsList( );
 			QueueChatCommand( m_GHost->m_Language->UpdatingFriendsList( ), User, Whisper );
@@ -1778,7 +1683,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !GETGAME
 		//
 
-		else if( Command == "getgame" && !Payload.empty( ) )
+		else if( CommandID == CMD_GETGAME && !Payload.empty( ) )
 		{
 			boost::mutex::scoped_lock lock( m_GHost->m_GamesMutex );
 			
@@ -1796,7 +1701,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !GETGAMES
 		//
 
-		else if( Command == "getgames" )
+		else if( CommandID == CMD_GETGAMES )
 		{
 			boost::mutex::scoped_lock lock( m_GHost->m_GamesMutex );
 			
@@ -1812,7 +1717,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !GRUNT
 		//
 
-		if( Command == "grunt"  && !Payload.empty( ) && ( IsRootAdmin( User ) || ForceRoot ) )
+		if( CommandID == CMD_GRUNT  && !Payload.empty( ) && ( IsRootAdmin( User ) || ForceRoot ) )
 		{
 			SendClanChangeRank( Payload, CBNETProtocol :: CLAN_MEMBER );
 			SendGetClanList( );
@@ -1823,7 +1728,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !GS
 		//
 
-		else if (Command == "gs")
+		else if (CommandID == CMD_GS)
 		{
 			if (!Payload.empty())
 			{
@@ -1841,14 +1746,14 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !HOSTSG
 		//
 
-		else if( Command == "hostsg" && !Payload.empty( ) )
+		else if( CommandID == CMD_HOSTSG && !Payload.empty( ) )
 			m_GHost->CreateGame( m_GHost->m_Map, GAME_PRIVATE, true, Payload, User, User, m_Server, Whisper );
 
 		//
 		// !INVITE
 		//
 
-		if( Command == "invite" && !Payload.empty( ) )
+		if( CommandID == CMD_INVITE && !Payload.empty( ) )
 		{
 			SendClanInvitation( Payload );
 			SendGetClanList( );
@@ -1859,7 +1764,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !LOAD (load config file)
 		//
 
-		else if( Command == "load" )
+		else if( CommandID == CMD_LOAD )
 		{
 			if( Payload.empty( ) )
 				QueueChatCommand( m_GHost->m_Language->CurrentlyLoadedMapCFGIs( m_GHost->m_Map->GetCFGFile( ) ), User, Whisper );
@@ -1937,7 +1842,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !LOADSG
 		//
 
-		else if( Command == "loadsg" && !Payload.empty( ) )
+		else if( CommandID == CMD_LOADSG && !Payload.empty( ) )
 		{
 			// only load files in the current directory just to be safe
 
@@ -1970,7 +1875,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !MAP (load map file)
 		//
 
-		else if( Command == "map" )
+		else if( CommandID == CMD_MAP )
 		{
 			if( Payload.empty( ) )
 				QueueChatCommand( m_GHost->m_Language->CurrentlyLoadedMapCFGIs( m_GHost->m_Map->GetCFGFile( ) ), User, Whisper );
@@ -2052,7 +1957,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !MOTD
 		//
 
-		if( Command == "motd"  && !Payload.empty( ) && ( IsRootAdmin( User ) || ForceRoot ) )
+		if( CommandID == CMD_MOTD  && !Payload.empty( ) && ( IsRootAdmin( User ) || ForceRoot ) )
 		{
 			SendClanSetMotd( Payload );
 			CONSOLE_Print( "[GHOST] setting motd to " + Payload );
@@ -2062,7 +1967,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !PEON
 		//
 
-		if( Command == "peon"  && !Payload.empty( ) && ( IsRootAdmin( User ) || ForceRoot ) )
+		if( CommandID == CMD_PEON  && !Payload.empty( ) && ( IsRootAdmin( User ) || ForceRoot ) )
 		{
 			SendClanChangeRank( Payload, CBNETProtocol :: CLAN_PARTIAL_MEMBER );
 			SendGetClanList( );
@@ -2073,7 +1978,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !RELOAD
 		//
 
-		else if( Command == "reload" )
+		else if( CommandID == CMD_RELOAD )
 		{
 			if( IsRootAdmin( User ) || ForceRoot )
 			{
@@ -2088,7 +1993,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !REMOVE
 		//
 
-		if( Command == "remove" && !Payload.empty( ) && ( IsRootAdmin( User ) || ForceRoot ) )
+		if( CommandID == CMD_REMOVE && !Payload.empty( ) && ( IsRootAdmin( User ) || ForceRoot ) )
 		{
 			SendClanRemoveMember( Payload );
 			SendGetClanList( );
@@ -2099,7 +2004,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !SAY
 		//
 
-		else if( Command == "say" && !Payload.empty( ) )
+		else if( CommandID == CMD_SAY && !Payload.empty( ) )
 		{
 			if( IsRootAdmin( User ) || ForceRoot ) {
 				QueueChatCommand( Payload );
@@ -2112,25 +2017,17 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !SAYGAMES
 		//
 
-		else if( Command == "saygames" && !Payload.empty( ) )
+		else if( CommandID == CMD_SAYGAMES && !Payload.empty( ) )
 		{
 			if( IsRootAdmin( User ) || ForceRoot )
 			{
 				boost::mutex::scoped_lock lock( m_GHost->m_GamesMutex );
 		
 				if( m_GHost->m_CurrentGame )
-				{
-					boost::mutex::scoped_lock sayLock( m_GHost->m_CurrentGame->m_SayGamesMutex );
-					m_GHost->m_CurrentGame->m_DoSayGames.push_back( Payload );
-					sayLock.unlock( );
-				}
+					m_GHost->m_CurrentGame->PostSayGame( Payload );
 
 				for( vector<CBaseGame *> :: iterator i = m_GHost->m_Games.begin( ); i != m_GHost->m_Games.end( ); ++i )
-				{
-					boost::mutex::scoped_lock sayLock( (*i)->m_SayGamesMutex );
-					(*i)->m_DoSayGames.push_back( Payload );
-					sayLock.unlock( );
-				}
+					(*i)->PostSayGame( Payload );
 		
 				lock.unlock( );
 			}
@@ -2142,7 +2039,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !SHAMAN
 		//
 
-		if( Command == "shaman"  && !Payload.empty( ) && ( IsRootAdmin( User ) || ForceRoot ) )
+		if( CommandID == CMD_SHAMAN  && !Payload.empty( ) && ( IsRootAdmin( User ) || ForceRoot ) )
 		{
 			SendClanChangeRank( Payload, CBNETProtocol :: CLAN_OFFICER );
 			SendGetClanList( );
@@ -2153,7 +2050,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !UNHOST
 		//
 
-		else if( Command == "unhost" )
+		else if( CommandID == CMD_UNHOST )
 		{
 			boost::mutex::scoped_lock lock( m_GHost->m_GamesMutex );
 			
@@ -2175,7 +2072,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !WARDENSTATUS
 		//
 
-		else if( Command == "wardenstatus" )
+		else if( CommandID == CMD_WARDENSTATUS )
 		{
 			if( m_BNLSClient )
 				QueueChatCommand( "WARDEN STATUS --- " + UTIL_ToString( m_BNLSClient->GetTotalWardenIn( ) ) + " requests received, " + UTIL_ToString( m_BNLSClient->GetTotalWardenOut( ) ) + " responses sent.", User, Whisper );
@@ -2187,6 +2084,11 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 	else
 		CONSOLE_Print( "[BNET: " + m_ServerAlias + "] non-admin [" + User + "] sent command [" + Message + "]" );
 
+	// admin commands are only handled above
+
+	if( BotCommand->m_Access == COMMAND_ACCESS_ADMIN )
+		return;
+
 	/*********************
 	* NON ADMIN COMMANDS *
 	*********************/
@@ -2196,14 +2098,14 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 	// in some cases the queue may be full of legitimate messages but we don't really care if the bot ignores one of these commands once in awhile
 	// e.g. when several users join a game at the same time and cause multiple /whois messages to be queued at once
 
-	if( IsAdmin( User ) || IsRootAdmin( User ) || ForceRoot || ( m_PublicCommands && m_OutPackets.size( ) <= 3 ) )
+	if( IsAdmin( User ) || IsRootAdmin( User ) || ForceRoot || ( m_PublicCommands && GetOutPacketsQueued( ) <= 3 ) )
 	{
 		
 		//
 		// !CHECKBAN
 		//
 
-		if (Command == "checkban")
+		if (CommandID == CMD_CHECKBAN)
 		{
 			string CheckUser = !Payload.empty() ? Payload : User;
 			CDBBan* Ban = IsBannedName(Payload);
@@ -2218,7 +2120,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !FREECHECK
 		//
 
-		else if (Command == "freecheck" && Whisper)
+		else if (CommandID == CMD_FREECHECK)
 		{
 			string UserLower = User;
 			transform(UserLower.begin(), UserLower.end(), UserLower.begin(), (int(*)(int))tolower);
@@ -2235,14 +2137,14 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !GAME
 		//
 
-		else if (Command == "game")
+		else if (CommandID == CMD_GAME)
 		{
 			if (!Payload.empty())
 			{
 				uint32_t GameIndex = UTIL_ToUInt32(Payload);
 				GameIndex--;
 				if (GameIndex >= 0 && GameIndex < 99999)
-					m_PairedCGQuery.push_back(PairedCGQuery(User, m_GHost->m_DB->ThreadedCurrentGamesQuery(false, true, GameIndex, 1)));
+					m_Callables->Add( QueryCurrentGames(false, true, GameIndex, 1), boost::bind( &CBNET :: EventCallableCurrentGamesQuery, this, User, _1 ) );
 			}
 		}
 
@@ -2252,40 +2154,19 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !ACTIVITY
 		//
 
-		else if (Command == "games" || Command == "activity")
+		else if (CommandID == CMD_GAMES)
 		{
 			if (m_GHost->m_MasterBotMode)
-				m_PairedCGQuery.push_back(PairedCGQuery(User, m_GHost->m_DB->ThreadedCurrentGamesQuery(false, false, 0, 0)));
+				m_Callables->Add( QueryCurrentGames(false, false, 0, 0), boost::bind( &CBNET :: EventCallableCurrentGamesQuery, this, User, _1 ) );
 			else
-			{
-				if (m_GHost->m_Games.size() > 0)
-				{
-					for (vector<CBaseGame*> ::iterator i = m_GHost->m_Games.begin(); i != m_GHost->m_Games.end(); i++)
-					{
-						string reply = "[" + (*i)->GetGameName() + "] ";
-						BYTEARRAY IDs = (*i)->GetPIDs();
-
-						for (BYTEARRAY::iterator i2 = IDs.begin(); i2 != IDs.end(); i2++)
-						{
-							CGamePlayer* plyr = (*i)->GetPlayerFromPID(*i2);
-							reply += plyr->GetName() + " ";
-						}
-
-						QueueChatCommand(reply, User, Whisper);
-					}
-				}
-				else
-				{
-					QueueChatCommand("There are no ongoing games.", User, Whisper);
-				}
-			}
+				m_Callables->Add( QueryCurrentGames(false, true, 0, 10), boost::bind( &CBNET :: EventCallableCurrentGamesQuery, this, User, _1 ) );
 		}
 
 		//
 		// !IMFREE
 		//
 
-		else if (Command == "imfree" && m_GHost->m_MasterBotMode && Whisper)
+		else if (CommandID == CMD_IMFREE && m_GHost->m_MasterBotMode)
 		{
 			string HostArgs = Payload;
 			if (m_QueuedLobbies.size())
@@ -2319,24 +2200,24 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !LOBBIES
 		//
 
-		else if (Command == "lobbies")
+		else if (CommandID == CMD_LOBBIES)
 		{
 			if(m_GHost->m_MasterBotMode)
-				m_PairedCGQuery.push_back(PairedCGQuery(User, m_GHost->m_DB->ThreadedCurrentGamesQuery(true, false, 0, 5)));
+				m_Callables->Add( QueryCurrentGames(true, false, 0, 5), boost::bind( &CBNET :: EventCallableCurrentGamesQuery, this, User, _1 ) );
 		}
 
 		//
 		// !LOBBY
 		//
 
-		else if (Command == "lobby")
+		else if (CommandID == CMD_LOBBY)
 		{
 			if (!Payload.empty())
 			{
 				uint32_t LobbyIndex = UTIL_ToUInt32(Payload);
 				LobbyIndex--;
 				if (LobbyIndex >= 0 && LobbyIndex < 99999)
-					m_PairedCGQuery.push_back(PairedCGQuery(User, m_GHost->m_DB->ThreadedCurrentGamesQuery(true, false, LobbyIndex, 1)));
+					m_Callables->Add( QueryCurrentGames(true, false, LobbyIndex, 1), boost::bind( &CBNET :: EventCallableCurrentGamesQuery, this, User, _1 ) );
 			}
 		}
 
@@ -2344,7 +2225,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !LOCALLOBBIES
 		//
 
-		if (Command == "locallobbies")
+		if (CommandID == CMD_LOCALLOBBIES)
 		{
 			string reply;
 
@@ -2375,11 +2256,11 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !PUB (host public game) / !PRIV (host private game)
 		//
 
-		else if ((Command == "pub" || Command == "priv") && !Payload.empty())
+		else if ((CommandID == CMD_PUB || CommandID == CMD_PRIV) && !Payload.empty())
 		{
 			if (!m_GHost->m_MasterBotMode && (!m_GHost->m_ChildBotMode || (m_GHost->m_ChildBotMode && (IsAdmin(User) || IsRootAdmin(User) || ForceRoot)))) //use normal pub if bot is not master or its a child bot and the cmd is comming from an admin
 			{
-				m_GHost->CreateGame(m_GHost->m_Map, Command == "pub" ? GAME_PUBLIC : GAME_PRIVATE, false, Payload, User, User, m_Server, true);
+				m_GHost->CreateGame(m_GHost->m_Map, CommandID == CMD_PUB ? GAME_PUBLIC : GAME_PRIVATE, false, Payload, User, User, m_Server, true);
 			}
 			else
 			{
@@ -2414,7 +2295,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 							if (!UserIsInHistory)
 							{
 								QueueChatCommand("Attempting to create a new game...", User, true);
-								m_QueuedLobbies.push_back(new QueuedLobby(GetTime(), Command == "pub" ? GAME_PUBLIC : GAME_PRIVATE, false, Payload, User, User));
+								m_QueuedLobbies.push_back(new QueuedLobby(GetTime(), CommandID == CMD_PUB ? GAME_PUBLIC : GAME_PRIVATE, false, Payload, User, User));
 								m_LastChildrenBotsFreeCheck = GetTime();
 								for (string i : m_ChildrenBotsNames)
 								{
@@ -2436,7 +2317,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !PUBBY (host public game by other player) / !PRIVBY (host private game by other player)
 		//
 
-		else if ((Command == "pubby" || Command == "privby") && !Payload.empty())
+		else if ((CommandID == CMD_PUBBY || CommandID == CMD_PRIVBY) && !Payload.empty())
 		{
 			bool FromMaster = false;
 			if (m_GHost->m_ChildBotMode)
@@ -2456,7 +2337,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 				{
 					Owner = Payload.substr(0, GameNameStart);
 					GameName = Payload.substr(GameNameStart + 1);
-					m_GHost->CreateGame(m_GHost->m_Map, Command == "pubby" ? GAME_PUBLIC : GAME_PRIVATE, false, GameName, Owner, FromMaster? Owner : User, m_Server, true);
+					m_GHost->CreateGame(m_GHost->m_Map, CommandID == CMD_PUBBY ? GAME_PUBLIC : GAME_PRIVATE, false, GameName, Owner, FromMaster? Owner : User, m_Server, true);
 				}
 			}
 			// extract the owner and the game name
@@ -2467,17 +2348,17 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !PUBMASTER / !PRIVMASTER
 		//
 
-		else if ((Command == "pubmaster" || Command == "privmaster") && !Payload.empty())
+		else if ((CommandID == CMD_PUBMASTER || CommandID == CMD_PRIVMASTER) && !Payload.empty())
 		{
 			if (IsAdmin(User) || IsRootAdmin(User) || ForceRoot)
-				m_GHost->CreateGame(m_GHost->m_Map, Command == "pubmaster" ? GAME_PUBLIC : GAME_PRIVATE, false, Payload, User, User, m_Server, Whisper);
+				m_GHost->CreateGame(m_GHost->m_Map, CommandID == CMD_PUBMASTER ? GAME_PUBLIC : GAME_PRIVATE, false, Payload, User, User, m_Server, Whisper);
 		}
 
 		//
 		// !SD
 		//
 
-		else if (Command == "sd")
+		else if (CommandID == CMD_SD)
 		{
 			if (!m_GHost->m_ChildBotMode)
 			{
@@ -2489,7 +2370,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 				// check for potential abuse
 
 				if (!StatsUser.empty() && StatsUser.size() < 16 && StatsUser[0] != '/')
-					m_PairedDPSChecksNew.push_back(PairedDPSCheckNew(Whisper ? User : User, m_GHost->m_DB->ThreadedDotAPlayerSummaryCheckNew(string(), StatsUser, "1", string())));
+					m_Callables->Add( m_GHost->m_DB->ThreadedDotAPlayerSummaryCheckNew(string(), StatsUser, "1", string()), boost::bind( &CBNET :: EventCallableDotAPlayerSummaryCheckNew, this, Whisper ? User : User, _1 ) );
 			}		
 		}
 
@@ -2497,7 +2378,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !STATS
 		//
 
-		else if( Command == "stats" )
+		else if( CommandID == CMD_STATS )
 		{
 			if (!m_GHost->m_ChildBotMode)
 			{
@@ -2509,7 +2390,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 				// check for potential abuse
 
 				if (!StatsUser.empty() && StatsUser.size() < 16 && StatsUser[0] != '/')
-					m_PairedGPSChecks.push_back(PairedGPSCheck(Whisper ? User : string(), m_GHost->m_DB->ThreadedGamePlayerSummaryCheck(StatsUser)));
+					m_Callables->Add( m_GHost->m_DB->ThreadedGamePlayerSummaryCheck(StatsUser), boost::bind( &CBNET :: EventCallableGamePlayerSummaryCheck, this, Whisper ? User : string(), _1 ) );
 			}		
 		}
 
@@ -2518,7 +2399,7 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 		// !SD
 		//
 
-		else if( Command == "statsdota" )
+		else if( CommandID == CMD_STATSDOTA )
 		{
 			if (!m_GHost->m_ChildBotMode)
 			{
@@ -2532,14 +2413,14 @@ void CBNET :: BotCommand( string Message, string User, bool Whisper, bool ForceR
 			// check for potential abuse
 
 			if( !StatsUser.empty( ) && StatsUser.size( ) < 16 && StatsUser[0] != '/' )
-				m_PairedDPSChecks.push_back( PairedDPSCheck( Whisper ? User : string( ), m_GHost->m_DB->ThreadedDotAPlayerSummaryCheck( StatsUser ) ) );
+				m_Callables->Add( m_GHost->m_DB->ThreadedDotAPlayerSummaryCheck( StatsUser ), boost::bind( &CBNET :: EventCallableDotAPlayerSummaryCheck, this, Whisper ? User : string( ), _1 ) );
 		}
 
 		//
 		// !VERSION
 		//
 
-		else if( Command == "version" )
+		else if( CommandID == CMD_VERSION )
 		{
 			if (Whisper)
 			{
@@ -2609,7 +2490,7 @@ void CBNET :: QueueEnterChat( )
 	boost::mutex::scoped_lock packetsLock( m_PacketsMutex );
 	
 	if( m_LoggedIn )
-		m_OutPackets.push( m_Protocol->SEND_SID_ENTERCHAT( ) );
+		m_SendScheduler->Queue( SENDLANE_CONTROL, m_Protocol->SEND_SID_ENTERCHAT( ), GetTicks( ) );
 	
 	packetsLock.unlock( );
 }
@@ -2627,17 +2508,17 @@ void CBNET :: QueueChatCommand( string chatCommand )
 		if( chatCommand.size( ) > 255 )
 			chatCommand = chatCommand.substr( 0, 255 );
 
+		unsigned char Lane = GetChatCommandLane( chatCommand );
+		BYTEARRAY Packet = m_Protocol->SEND_SID_CHATCOMMAND( chatCommand );
 		boost::mutex::scoped_lock packetsLock( m_PacketsMutex );
-		
-		if( m_OutPackets.size( ) > 10 )
-			CONSOLE_Print( "[BNET: " + m_ServerAlias + "] attempted to queue chat command [" + chatCommand + "] but there are too many (" + UTIL_ToString( m_OutPackets.size( ) ) + ") packets queued, discarding" );
-		else
-		{
-			CONSOLE_Print( "[QUEUED: " + m_ServerAlias + "] " + chatCommand );
-			m_OutPackets.push( m_Protocol->SEND_SID_CHATCOMMAND( chatCommand ) );
-		}
-		
+		bool Queued = m_SendScheduler->Queue( Lane, Packet, GetTicks( ) );
+		uint32_t LaneQueued = m_SendScheduler->GetQueued( Lane );
 		packetsLock.unlock( );
+
+		if( Queued )
+			CONSOLE_Print( "[QUEUED: " + m_ServerAlias + "] " + chatCommand );
+		else
+			CONSOLE_Print( "[BNET: " + m_ServerAlias + "] attempted to queue chat command [" + chatCommand + "] but there are too many (" + UTIL_ToString( LaneQueued ) + ") messages of the same priority queued, discarding" );
 	}
 }
 
@@ -2706,13 +2587,18 @@ void CBNET :: QueueGameRefresh( unsigned char state, string gameName, string hos
 			MapHeight.push_back( 192 );
 			MapHeight.push_back( 7 );
 
-			boost::mutex::scoped_lock packetsLock( m_PacketsMutex );
-			
+			// the stat string is cached on the map and shared with the other realms and games hosting it, only the header fields differ per refresh
+
+			BYTEARRAY StatString;
+
 			if( m_GHost->m_Reconnect )
-				m_OutPackets.push( m_Protocol->SEND_SID_STARTADVEX3( state, UTIL_CreateByteArray( MapGameType, false ), map->GetMapGameFlags( ), MapWidth, MapHeight, gameName, hostName, upTime, "Save\\Multiplayer\\" + saveGame->GetFileNameNoPath( ), saveGame->GetMagicNumber( ), map->GetMapSHA1( ), FixedHostCounter ) );
+				StatString = map->GetEncodedStatString( MapWidth, MapHeight, "Save\\Multiplayer\\" + saveGame->GetFileNameNoPath( ), saveGame->GetMagicNumber( ), hostName, true );
 			else
-				m_OutPackets.push( m_Protocol->SEND_SID_STARTADVEX3( state, UTIL_CreateByteArray( MapGameType, false ), map->GetMapGameFlags( ), UTIL_CreateByteArray( (uint16_t)0, false ), UTIL_CreateByteArray( (uint16_t)0, false ), gameName, hostName, upTime, "Save\\Multiplayer\\" + saveGame->GetFileNameNoPath( ), saveGame->GetMagicNumber( ), map->GetMapSHA1( ), FixedHostCounter ) );
-			
+				StatString = map->GetEncodedStatString( UTIL_CreateByteArray( (uint16_t)0, false ), UTIL_CreateByteArray( (uint16_t)0, false ), "Save\\Multiplayer\\" + saveGame->GetFileNameNoPath( ), saveGame->GetMagicNumber( ), hostName, true );
+
+			BYTEARRAY Packet = m_Protocol->SEND_SID_STARTADVEX3( state, UTIL_CreateByteArray( MapGameType, false ), gameName, upTime, StatString, FixedHostCounter );
+			boost::mutex::scoped_lock packetsLock( m_PacketsMutex );
+			m_SendScheduler->Queue( SENDLANE_GAME, Packet, GetTicks( ), true );
 			packetsLock.unlock( );
 		}
 		else
@@ -2734,13 +2620,16 @@ void CBNET :: QueueGameRefresh( unsigned char state, string gameName, string hos
 			MapHeight.push_back( 192 );
 			MapHeight.push_back( 7 );
 
-			boost::mutex::scoped_lock packetsLock( m_PacketsMutex );
-			
+			BYTEARRAY StatString;
+
 			if( m_GHost->m_Reconnect )
-				m_OutPackets.push( m_Protocol->SEND_SID_STARTADVEX3( state, UTIL_CreateByteArray( MapGameType, false ), map->GetMapGameFlags( ), MapWidth, MapHeight, gameName, hostName, upTime, map->GetMapPath( ), map->GetMapCRC( ), map->GetMapSHA1( ), FixedHostCounter ) );
+				StatString = map->GetEncodedStatString( MapWidth, MapHeight, map->GetMapPath( ), map->GetMapCRC( ), hostName, true );
 			else
-				m_OutPackets.push( m_Protocol->SEND_SID_STARTADVEX3( state, UTIL_CreateByteArray( MapGameType, false ), map->GetMapGameFlags( ), map->GetMapWidth( ), map->GetMapHeight( ), gameName, hostName, upTime, map->GetMapPath( ), map->GetMapCRC( ), map->GetMapSHA1( ), FixedHostCounter ) );
-			
+				StatString = map->GetEncodedStatString( map->GetMapWidth( ), map->GetMapHeight( ), map->GetMapPath( ), map->GetMapCRC( ), hostName, true );
+
+			BYTEARRAY Packet = m_Protocol->SEND_SID_STARTADVEX3( state, UTIL_CreateByteArray( MapGameType, false ), gameName, upTime, StatString, FixedHostCounter );
+			boost::mutex::scoped_lock packetsLock( m_PacketsMutex );
+			m_SendScheduler->Queue( SENDLANE_GAME, Packet, GetTicks( ), true );
 			packetsLock.unlock( );
 		}
 	}
@@ -2751,33 +2640,15 @@ void CBNET :: QueueGameUncreate( )
 	boost::mutex::scoped_lock packetsLock( m_PacketsMutex );
 	
 	if( m_LoggedIn )
-		m_OutPackets.push( m_Protocol->SEND_SID_STOPADV( ) );
+		m_SendScheduler->Queue( SENDLANE_GAME, m_Protocol->SEND_SID_STOPADV( ), GetTicks( ) );
 	
 	packetsLock.unlock( );
 }
 
 void CBNET :: UnqueuePackets( unsigned char type )
 {
-	queue<BYTEARRAY> Packets;
-	uint32_t Unqueued = 0;
-
 	boost::mutex::scoped_lock packetsLock( m_PacketsMutex );
-	
-	while( !m_OutPackets.empty( ) )
-	{
-		// todotodo: it's very inefficient to have to copy all these packets while searching the queue
-
-		BYTEARRAY Packet = m_OutPackets.front( );
-		m_OutPackets.pop( );
-
-		if( Packet.size( ) >= 2 && Packet[1] == type )
-			++Unqueued;
-		else
-			Packets.push( Packet );
-	}
-
-	m_OutPackets = Packets;
-	
+	uint32_t Unqueued = m_SendScheduler->Unqueue( type );
 	packetsLock.unlock( );
 
 	if( Unqueued > 0 )
@@ -2786,31 +2657,11 @@ void CBNET :: UnqueuePackets( unsigned char type )
 
 void CBNET :: UnqueueChatCommand( string chatCommand )
 {
-	// hackhack: this is ugly code
-	// generate the packet that would be sent for this chat command
-	// then search the queue for that exact packet
+	// generate the packet that would be sent for this chat command then remove that exact packet from the queue
 
 	BYTEARRAY PacketToUnqueue = m_Protocol->SEND_SID_CHATCOMMAND( chatCommand );
-	queue<BYTEARRAY> Packets;
-	uint32_t Unqueued = 0;
-
 	boost::mutex::scoped_lock packetsLock( m_PacketsMutex );
-	
-	while( !m_OutPackets.empty( ) )
-	{
-		// todotodo: it's very inefficient to have to copy all these packets while searching the queue
-
-		BYTEARRAY Packet = m_OutPackets.front( );
-		m_OutPackets.pop( );
-
-		if( Packet == PacketToUnqueue )
-			++Unqueued;
-		else
-			Packets.push( Packet );
-	}
-
-	m_OutPackets = Packets;
-	
+	uint32_t Unqueued = m_SendScheduler->Unqueue( PacketToUnqueue );
 	packetsLock.unlock( );
 
 	if( Unqueued > 0 )
@@ -2822,6 +2673,96 @@ void CBNET :: UnqueueGameRefreshes( )
 	UnqueuePackets( CBNETProtocol :: SID_STARTADVEX3 );
 }
 
+unsigned char CBNET :: GetChatCommandLane( const string &chatCommand )
+{
+	// whispers to the master bot or the child bots are control messages, the bots depend on them to coordinate hosting
+
+	if( chatCommand.size( ) > 3 && chatCommand.compare( 0, 3, "/w " ) == 0 )
+	{
+		string :: size_type End = chatCommand.find( ' ', 3 );
+		string User = chatCommand.substr( 3, End == string :: npos ? string :: npos : End - 3 );
+		transform( User.begin( ), User.end( ), User.begin( ), (int(*)(int))tolower );
+		string MasterBotName = m_MasterBotName;
+		transform( MasterBotName.begin( ), MasterBotName.end( ), MasterBotName.begin( ), (int(*)(int))tolower );
+
+		if( ( !MasterBotName.empty( ) && User == MasterBotName ) || find( m_ChildrenBotsNames.begin( ), m_ChildrenBotsNames.end( ), User ) != m_ChildrenBotsNames.end( ) )
+			return SENDLANE_CONTROL;
+
+		return SENDLANE_WHISPER;
+	}
+
+	// any other slash command (e.g. /join) changes the bot's state rather than talking to users
+
+	if( !chatCommand.empty( ) && chatCommand[0] == '/' )
+		return SENDLANE_CONTROL;
+
+	return SENDLANE_CHAT;
+}
+
+uint32_t CBNET :: GetOutPacketsQueued( )
+{
+	boost::mutex::scoped_lock packetsLock( m_PacketsMutex );
+	return m_SendScheduler->GetQueued( );
+}
+
+uint32_t CBNET :: GetOutPacketsQueued( unsigned char lane )
+{
+	boost::mutex::scoped_lock packetsLock( m_PacketsMutex );
+	return m_SendScheduler->GetQueued( lane );
+}
+
+uint32_t CBNET :: GetNextSendTicks( )
+{
+	// return the number of ticks (ms) until the next waiting packet can be sent, or 0xFFFFFFFF if there's nothing we could send
+	// the main GHost++ loop will make sure the next loop update happens at or before this value
+
+	if( m_Socket->HasError( ) || !m_Socket->GetConnected( ) )
+		return 0xFFFFFFFF;
+
+	boost::mutex::scoped_lock packetsLock( m_PacketsMutex );
+
+	if( m_SendScheduler->GetQueued( ) == 0 )
+		return 0xFFFFFFFF;
+
+	return m_SendScheduler->GetWaitTicks( GetTicks( ) );
+}
+
+void CBNET :: PostChatCommand( string chatCommand, string user, bool whisper )
+{
+	if( chatCommand.empty( ) )
+		return;
+
+	CBNETMessage *Message = new CBNETMessage( BNETMESSAGE_CHATCOMMAND );
+	Message->m_ChatCommand = chatCommand;
+	Message->m_User = user;
+	Message->m_Whisper = whisper;
+
+	if( !m_Mailbox->Post( Message ) )
+		CONSOLE_Print( "[BNET: " + m_ServerAlias + "] mailbox is full, discarding chat command [" + chatCommand + "]" );
+}
+
+void CBNET :: PostUnqueueChatCommand( string chatCommand )
+{
+	CBNETMessage *Message = new CBNETMessage( BNETMESSAGE_UNQUEUECHATCOMMAND );
+	Message->m_ChatCommand = chatCommand;
+	m_Mailbox->Post( Message );
+}
+
+void CBNET :: ProcessMessages( )
+{
+	// this is only called from the main thread
+
+	while( CBNETMessage *Message = m_Mailbox->Receive( ) )
+	{
+		if( Message->m_Type == BNETMESSAGE_CHATCOMMAND )
+			QueueChatCommand( Message->m_ChatCommand, Message->m_User, Message->m_Whisper );
+		else if( Message->m_Type == BNETMESSAGE_UNQUEUECHATCOMMAND )
+			UnqueueChatCommand( Message->m_ChatCommand );
+
+		delete Message;
+	}
+}
+
 bool CBNET :: IsAdmin( string name )
 {
 	transform( name.begin( ), name.end( ), name.begin( ), (int(*)(int))tolower );
@@ -2969,3 +2910,13 @@ QueuedLobby :: QueuedLobby(uint32_t nCreateTime, unsigned char nGameState, bool
 	CreatorName = nCreatorName;
 }
 
+CCallableCurrentGamesQuery *CBNET :: QueryCurrentGames( bool includeLobbies, bool includeStarted, uint32_t queryOffset, uint32_t queryLimit )
+{
+	// a master bot lists the games of every bot so it has to ask the database
+	// any other bot only knows about its own games and those are already in memory
+
+	if( m_GHost->m_MasterBotMode )
+		return m_GHost->m_DB->ThreadedCurrentGamesQuery( includeLobbies, includeStarted, queryOffset, queryLimit );
+
+	return m_GHost->m_LiveGames->Query( includeLobbies, includeStarted, queryOffset, queryLimit );
+}
@@ -35,6 +35,12 @@ class CBNLSClient;
 class CIncomingFriendList;
 class CIncomingClanList;
 class CIncomingChatEvent;
+class CCallableInbox;
+struct CBNETMessage;
+template <class T> class CMailbox;
+class CCommandTable;
+class CCommandLimiter;
+class CSendScheduler;
 class CCallableAdminCount;
 class CCallableAdminAdd;
 class CCallableAdminRemove;
@@ -49,16 +55,6 @@ class CCallableDotAPlayerSummaryCheckNew;	//breaks?
 class CCallableCurrentGamesQuery;			//breaks?
 class CDBBan;
 
-typedef pair<string,CCallableAdminCount *> PairedAdminCount;
-typedef pair<string,CCallableAdminAdd *> PairedAdminAdd;
-typedef pair<string,CCallableAdminRemove *> PairedAdminRemove;
-typedef pair<string,CCallableBanCount *> PairedBanCount;
-typedef pair<string,CCallableBanAdd *> PairedBanAdd;
-typedef pair<string,CCallableBanRemove *> PairedBanRemove;
-typedef pair<string,CCallableGamePlayerSummaryCheck *> PairedGPSCheck;
-typedef pair<string,CCallableDotAPlayerSummaryCheck *> PairedDPSCheck;
-typedef pair<string, CCallableDotAPlayerSummaryCheckNew *> PairedDPSCheckNew; //New
-typedef pair<string, CCallableCurrentGamesQuery *> PairedCGQuery; //New
 
 
 struct QueuedLobby { //New
@@ -73,6 +69,65 @@ struct QueuedLobby { //New
 
 class CBNET
 {
+public:
+	enum Commands
+	{
+		CMD_ACCEPT = 0,
+		CMD_ADDADMIN,
+		CMD_ADDBAN,
+		CMD_AUTOHOST,
+		CMD_AUTOHOSTMM,
+		CMD_CHANNEL,
+		CMD_CHECKADMIN,
+		CMD_COUNTADMINS,
+		CMD_COUNTBANS,
+		CMD_DBSTATUS,
+		CMD_DELADMIN,
+		CMD_DELBAN,
+		CMD_DISABLE,
+		CMD_ENABLE,
+		CMD_ENFORCESG,
+		CMD_EXIT,
+		CMD_GETCLAN,
+		CMD_GETFRIENDS,
+		CMD_GETGAME,
+		CMD_GETGAMES,
+		CMD_GRUNT,
+		CMD_GS,
+		CMD_HOSTSG,
+		CMD_INVITE,
+		CMD_LOAD,
+		CMD_LOADSG,
+		CMD_MAP,
+		CMD_MOTD,
+		CMD_PEON,
+		CMD_RELOAD,
+		CMD_REMOVE,
+		CMD_SAY,
+		CMD_SAYGAMES,
+		CMD_SHAMAN,
+		CMD_UNHOST,
+		CMD_WARDENSTATUS,
+		CMD_CHECKBAN,
+		CMD_FREECHECK,
+		CMD_GAME,
+		CMD_GAMES,
+		CMD_IMFREE,
+		CMD_LOBBIES,
+		CMD_LOBBY,
+		CMD_LOCALLOBBIES,
+		CMD_PUB,
+		CMD_PRIV,
+		CMD_PUBBY,
+		CMD_PRIVBY,
+		CMD_PUBMASTER,
+		CMD_PRIVMASTER,
+		CMD_SD,
+		CMD_STATS,
+		CMD_STATSDOTA,
+		CMD_VERSION
+	};
+
 public:
 	CGHost *m_GHost;
 
@@ -81,21 +136,14 @@ private:
 	CBNETProtocol *m_Protocol;						// battle.net protocol
 	CBNLSClient *m_BNLSClient;						// the BNLS client (for external warden handling)
 	queue<CCommandPacket *> m_Packets;				// queue of incoming packets
-	boost::mutex m_PacketsMutex;					// game sometimes calls QueueChatCommand and UnqueueChatCommand; this makes the functions synchronized
+	boost::mutex m_PacketsMutex;					// game threads queue game refreshes and enter chat packets; this synchronizes accesses to m_SendScheduler
 	CBNCSUtilInterface *m_BNCSUtil;					// the interface to the bncsutil library (used for logging into battle.net)
-	queue<BYTEARRAY> m_OutPackets;					// queue of outgoing packets to be sent (to prevent getting kicked for flooding)
+	CSendScheduler *m_SendScheduler;				// outgoing packets waiting to be sent (to prevent getting kicked for flooding)
 	vector<CIncomingFriendList *> m_Friends;		// vector of friends
 	vector<CIncomingClanList *> m_Clans;			// vector of clan members
-	vector<PairedAdminCount> m_PairedAdminCounts;	// vector of paired threaded database admin counts in progress
-	vector<PairedAdminAdd> m_PairedAdminAdds;		// vector of paired threaded database admin adds in progress
-	vector<PairedAdminRemove> m_PairedAdminRemoves;	// vector of paired threaded database admin removes in progress
-	vector<PairedBanCount> m_PairedBanCounts;		// vector of paired threaded database ban counts in progress
-	vector<PairedBanAdd> m_PairedBanAdds;			// vector of paired threaded database ban adds in progress
-	vector<PairedBanRemove> m_PairedBanRemoves;		// vector of paired threaded database ban removes in progress
-	vector<PairedGPSCheck> m_PairedGPSChecks;		// vector of paired threaded database game player summary checks in progress
-	vector<PairedDPSCheck> m_PairedDPSChecks;		// vector of paired threaded database DotA player summary checks in progress
-	vector<PairedDPSCheckNew> m_PairedDPSChecksNew; //New
-	vector<PairedCGQuery> m_PairedCGQuery;			//new: vector of paired threaded database current in-progress games queries
+	CCallableInbox *m_Callables;					// database callables owned by this connection
+	CMailbox<CBNETMessage> *m_Mailbox;				// chat commands posted by game threads, see the Post functions
+	CCommandLimiter *m_CommandLimiter;				// per user rate limits for bot commands
 	vector<QueuedLobby*> m_QueuedLobbies;			//New. vector of QueuedLobby that we  will ask child bots to host
 	vector<pair<string, uint32_t>> m_LobbiesCreateHistory; //stores user name and time of when the player last created lobby (used by master bot)
 	CCallableAdminList *m_CallableAdminList;		// threaded database admin list in progress
@@ -134,9 +182,7 @@ private:
 	uint32_t m_LastDisconnectedTime;				// GetTime when we were last disconnected from battle.net
 	uint32_t m_LastConnectionAttemptTime;			// GetTime when we last attempted to connect to battle.net
 	uint32_t m_LastNullTime;						// GetTime when the last null packet was sent for detecting disconnects
-	uint32_t m_LastOutPacketTicks;					// GetTicks when the last packet was sent for the m_OutPackets queue
-	uint32_t m_LastOutPacketSize;
-	uint32_t m_FrequencyDelayTimes;
+	uint32_t m_LastSendStatsTime;					// GetTime when the send scheduler statistics were last printed
 	uint32_t m_LastAdminRefreshTime;				// GetTime when the admin list was last refreshed from the database
 	uint32_t m_LastBanRefreshTime;					// GetTime when the ban list was last refreshed from the database
 	uint32_t m_LastChildrenBotsFreeCheck;			// New: GetTime when the last send "!freecheck" to child bots
@@ -151,9 +197,12 @@ private:
 	bool m_LastInviteCreation;						// whether the last invite received was for a clan creation (else, it was for invitation response)
 
 public:
-	CBNET( CGHost *nGHost, string nServer, string nServerAlias, string nBNLSServer, uint16_t nBNLSPort, uint32_t nBNLSWardenCookie, string nCDKeyROC, string nCDKeyTFT, string nCountryAbbrev, string nCountry, uint32_t nLocaleID, string nUserName, string nUserPassword, string nFirstChannel, string nRootAdmin, char nCommandTrigger, bool nHoldFriends, bool nHoldClan, bool nPublicCommands, unsigned char nWar3Version, BYTEARRAY nEXEVersion, BYTEARRAY nEXEVersionHash, string nPasswordHashType, string nPVPGNRealmName, uint32_t nMaxMessageLength, string nChildrenBotsNames, string nMasterBotName, uint32_t nHostCounterID );
+	CBNET( CGHost *nGHost, string nServer, string nServerAlias, string nBNLSServer, uint16_t nBNLSPort, uint32_t nBNLSWardenCookie, string nCDKeyROC, string nCDKeyTFT, string nCountryAbbrev, string nCountry, uint32_t nLocaleID, string nUserName, string nUserPassword, string nFirstChannel, string nRootAdmin, char nCommandTrigger, bool nHoldFriends, bool nHoldClan, bool nPublicCommands, unsigned char nWar3Version, BYTEARRAY nEXEVersion, BYTEARRAY nEXEVersionHash, string nPasswordHashType, string nPVPGNRealmName, uint32_t nMaxMessageLength, string nChildrenBotsNames, string nMasterBotName, uint32_t nHostCounterID, uint32_t nFloodCapacity, uint32_t nFloodPacketCost, uint32_t nFloodTicksPerByte );
 	~CBNET( );
 
+	static void RegisterCommands( CCommandTable *commands );
+
+
 	bool GetExiting( )					{ return m_Exiting; }
 	string GetServer( )					{ return m_Server; }
 	string GetServerAlias( )			{ return m_ServerAlias; }
@@ -175,7 +224,9 @@ public:
 	bool GetHoldFriends( )				{ return m_HoldFriends; }
 	bool GetHoldClan( )					{ return m_HoldClan; }
 	bool GetPublicCommands( )			{ return m_PublicCommands; }
-	uint32_t GetOutPacketsQueued( )		{ return m_OutPackets.size( ); }
+	uint32_t GetOutPacketsQueued( );
+	uint32_t GetOutPacketsQueued( unsigned char lane );
+	uint32_t GetNextSendTicks( );
 	BYTEARRAY GetUniqueName( );
 
 	// processing functions
@@ -187,6 +238,21 @@ public:
 	void ProcessChatEvent( CIncomingChatEvent *chatEvent );
 	void BotCommand( string Message, string User, bool Whisper, bool ForceRoot );
 
+	// database callable continuations
+
+	void EventCallableAdminList( CCallableAdminList *callable );
+	void EventCallableBanList( CCallableBanList *callable );
+	void EventCallableAdminCount( string user, CCallableAdminCount *callable );
+	void EventCallableAdminAdd( string user, CCallableAdminAdd *callable );
+	void EventCallableAdminRemove( string user, CCallableAdminRemove *callable );
+	void EventCallableBanCount( string user, CCallableBanCount *callable );
+	void EventCallableBanAdd( string user, CCallableBanAdd *callable );
+	void EventCallableBanRemove( string user, CCallableBanRemove *callable );
+	void EventCallableGamePlayerSummaryCheck( string user, CCallableGamePlayerSummaryCheck *callable );
+	void EventCallableDotAPlayerSummaryCheck( string user, CCallableDotAPlayerSummaryCheck *callable );
+	void EventCallableDotAPlayerSummaryCheckNew( string user, CCallableDotAPlayerSummaryCheckNew *callable );
+	void EventCallableCurrentGamesQuery( string user, CCallableCurrentGamesQuery *callable );
+
 	// functions to send packets to battle.net
 
 	void SendJoinChannel( string channel );
@@ -207,6 +273,13 @@ public:
 	void UnqueuePackets( unsigned char type );
 	void UnqueueChatCommand( string chatCommand );
 	void UnqueueGameRefreshes( );
+	unsigned char GetChatCommandLane( const string &chatCommand );
+
+	// functions game threads use to talk to this connection, the messages are handled by the main thread in the same order they were posted
+
+	void PostChatCommand( string chatCommand, string user, bool whisper );
+	void PostUnqueueChatCommand( string chatCommand );
+	void ProcessMessages( );
 
 	// other functions
 
@@ -220,6 +293,24 @@ public:
 	void RemoveBan( string name );
 	void HoldFriends( CBaseGame *game );
 	void HoldClan( CBaseGame *game );
+	CCallableCurrentGamesQuery *QueryCurrentGames( bool includeLobbies, bool includeStarted, uint32_t queryOffset, uint32_t queryLimit );
+};
+
+//
+// CBNETMessage
+//
+
+#define BNETMESSAGE_CHATCOMMAND			1	// queue m_ChatCommand (or whisper it to m_User if m_Whisper is set)
+#define BNETMESSAGE_UNQUEUECHATCOMMAND	2	// remove m_ChatCommand from the queue if it hasn't been sent yet
+
+struct CBNETMessage
+{
+	unsigned char m_Type;
+	string m_ChatCommand;
+	string m_User;
+	bool m_Whisper;
+
+	CBNETMessage( unsigned char nType ) : m_Type( nType ), m_Whisper( false ) { }
 };
 
 #endif
@@ -665,6 +665,31 @@ Flags:
 
 */
 
+	if( mapFlags.size( ) == 4 && mapWidth.size( ) == 2 && mapHeight.size( ) == 2 && !hostName.empty( ) && !mapPath.empty( ) && mapCRC.size( ) == 4 && mapSHA1.size( ) == 20 )
+	{
+		// make the stat string
+
+		BYTEARRAY StatString;
+		UTIL_AppendByteArrayFast( StatString, mapFlags );
+		StatString.push_back( 0 );
+		UTIL_AppendByteArrayFast( StatString, mapWidth );
+		UTIL_AppendByteArrayFast( StatString, mapHeight );
+		UTIL_AppendByteArrayFast( StatString, mapCRC );
+		UTIL_AppendByteArrayFast( StatString, mapPath );
+		UTIL_AppendByteArrayFast( StatString, hostName );
+		StatString.push_back( 0 );
+		UTIL_AppendByteArrayFast( StatString, mapSHA1 );
+		StatString = UTIL_EncodeStatString( StatString );
+
+		return SEND_SID_STARTADVEX3( state, mapGameType, gameName, upTime, StatString, hostCounter );
+	}
+
+	CONSOLE_Print( "[BNETPROTO] invalid parameters passed to SEND_SID_STARTADVEX3" );
+	return BYTEARRAY( );
+}
+
+BYTEARRAY CBNETProtocol :: SEND_SID_STARTADVEX3( unsigned char state, const BYTEARRAY &mapGameType, const string &gameName, uint32_t upTime, const BYTEARRAY &encodedStatString, uint32_t hostCounter )
+{
 	unsigned char Unknown[]		= { 255,  3,  0,  0 };
 	unsigned char CustomGame[]	= {   0,  0,  0,  0 };
 
@@ -677,21 +702,7 @@ Flags:
 
 	BYTEARRAY packet;
 
-	// make the stat string
-
-	BYTEARRAY StatString;
-	UTIL_AppendByteArrayFast( StatString, mapFlags );
-	StatString.push_back( 0 );
-	UTIL_AppendByteArrayFast( StatString, mapWidth );
-	UTIL_AppendByteArrayFast( StatString, mapHeight );
-	UTIL_AppendByteArrayFast( StatString, mapCRC );
-	UTIL_AppendByteArrayFast( StatString, mapPath );
-	UTIL_AppendByteArrayFast( StatString, hostName );
-	StatString.push_back( 0 );
-	UTIL_AppendByteArrayFast( StatString, mapSHA1 );
-	StatString = UTIL_EncodeStatString( StatString );
-
-	if( mapGameType.size( ) == 4 && mapFlags.size( ) == 4 && mapWidth.size( ) == 2 && mapHeight.size( ) == 2 && !gameName.empty( ) && !hostName.empty( ) && !mapPath.empty( ) && mapCRC.size( ) == 4 && mapSHA1.size( ) == 20 && StatString.size( ) < 128 && HostCounterString.size( ) == 8 )
+	if( mapGameType.size( ) == 4 && !gameName.empty( ) && !encodedStatString.empty( ) && encodedStatString.size( ) < 128 && HostCounterString.size( ) == 8 )
 	{
 		// make the rest of the packet
 
@@ -704,17 +715,18 @@ Flags:
 		packet.push_back( 0 );											// State continued...
 		packet.push_back( 0 );											// State continued...
 		UTIL_AppendByteArray( packet, upTime, false );					// time since creation
-		UTIL_AppendByteArrayFast( packet, mapGameType );				// Game Type, Parameter
+		packet.insert( packet.end( ), mapGameType.begin( ), mapGameType.end( ) );	// Game Type, Parameter
 		UTIL_AppendByteArray( packet, Unknown, 4 );						// ???
 		UTIL_AppendByteArray( packet, CustomGame, 4 );					// Custom Game
-		UTIL_AppendByteArrayFast( packet, gameName );					// Game Name
+		packet.insert( packet.end( ), gameName.begin( ), gameName.end( ) );	// Game Name
+		packet.push_back( 0 );											// Game Name null terminator
 		packet.push_back( 0 );											// Game Password is NULL
 		if( MAX_SLOTS > 12 ) 
 			packet.push_back( 110 );										// Slots Free (ascii 98 = char 'b' = 11 slots free) - note: do not reduce this as this is the # of PID's Warcraft III will allocate
 		else
 			packet.push_back( 98 );
 		UTIL_AppendByteArrayFast( packet, HostCounterString, false );	// Host Counter
-		UTIL_AppendByteArrayFast( packet, StatString );					// Stat String
+		packet.insert( packet.end( ), encodedStatString.begin( ), encodedStatString.end( ) );	// Stat String
 		packet.push_back( 0 );											// Stat String null terminator (the stat string is encoded to remove all even numbers i.e. zeros)
 		AssignLength( packet );
 	}
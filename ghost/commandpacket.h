@@ -38,7 +38,7 @@ public:
 
 	unsigned char GetPacketType( )	{ return m_PacketType; }
 	int GetID( )					{ return m_ID; }
-	BYTEARRAY GetData( )			{ return m_Data; }
+	const BYTEARRAY &GetData( )		{ return m_Data; }
 };
 
 #endif
@@ -0,0 +1,219 @@
+/*
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*/
+
+
+#include "ghost.h"
+#include "util.h"
+#include "commandtable.h"
+
+#define NO_SLOT 0xFFFFFFFF
+
+//
+// CCommand
+//
+
+CCommand :: CCommand( uint32_t nID, string nName, unsigned char nAccess, unsigned char nContexts, uint32_t nRateLimit, uint32_t nRateLimitGroup ) : m_ID( nID ), m_Name( nName ), m_Access( nAccess ), m_Contexts( nContexts ), m_RateLimit( nRateLimit ), m_RateLimitGroup( nRateLimitGroup )
+{
+
+}
+
+//
+// CCommandTable
+//
+
+CCommandTable :: CCommandTable( ) : m_BucketMask( 0 ), m_SlotMask( 0 )
+{
+
+}
+
+CCommandTable :: ~CCommandTable( )
+{
+
+}
+
+uint32_t CCommandTable :: Hash( const string &name, uint32_t seed )
+{
+	// FNV-1a with the seed folded into the offset basis and a final avalanche so nearby seeds give unrelated slots
+
+	uint32_t h = 2166136261U ^ ( seed * 0x9E3779B9U );
+
+	for( string :: const_iterator i = name.begin( ); i != name.end( ); ++i )
+	{
+		h ^= (unsigned char)*i;
+		h *= 16777619U;
+	}
+
+	h ^= h >> 16;
+	h *= 0x85EBCA6BU;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35U;
+	h ^= h >> 16;
+	return h;
+}
+
+void CCommandTable :: Add( uint32_t id, string name, string aliases, unsigned char access, unsigned char contexts, uint32_t rateLimit, uint32_t rateLimitGroup )
+{
+	uint32_t Index = m_Commands.size( );
+	m_Commands.push_back( CCommand( id, name, access, contexts, rateLimit, rateLimitGroup == 0xFFFFFFFF ? id : rateLimitGroup ) );
+
+	vector<string> Names = UTIL_Tokenize( aliases, ' ' );
+	Names.insert( Names.begin( ), name );
+
+	for( vector<string> :: iterator i = Names.begin( ); i != Names.end( ); ++i )
+	{
+		if( find( m_Names.begin( ), m_Names.end( ), *i ) != m_Names.end( ) )
+		{
+			CONSOLE_Print( "[COMMANDS] warning - duplicate command name [" + *i + "] ignored" );
+			continue;
+		}
+
+		m_Names.push_back( *i );
+		m_NameCommands.push_back( Index );
+	}
+}
+
+void CCommandTable :: Build( )
+{
+	// use about two names per bucket and at least twice as many slots as names
+	// with that much room a displacement is found after a handful of tries even for the largest buckets
+
+	uint32_t Buckets = 1;
+
+	while( Buckets * 2 < m_Names.size( ) )
+		Buckets *= 2;
+
+	uint32_t Slots = 1;
+
+	while( Slots < m_Names.size( ) * 2 )
+		Slots *= 2;
+
+	while( true )
+	{
+		m_BucketMask = Buckets - 1;
+		m_SlotMask = Slots - 1;
+		m_Displacements.assign( Buckets, 0 );
+		m_Slots.assign( Slots, NO_SLOT );
+
+		// place the buckets with the most names first since they're the hardest to fit
+
+		vector<vector<uint32_t> > BucketNames( Buckets );
+
+		for( uint32_t i = 0; i < m_Names.size( ); ++i )
+			BucketNames[Hash( m_Names[i], 0 ) & m_BucketMask].push_back( i );
+
+		vector<pair<uint32_t, uint32_t> > Order;
+
+		for( uint32_t i = 0; i < Buckets; ++i )
+			Order.push_back( pair<uint32_t, uint32_t>( BucketNames[i].size( ), i ) );
+
+		sort( Order.begin( ), Order.end( ), greater<pair<uint32_t, uint32_t> >( ) );
+		bool Success = true;
+
+		for( vector<pair<uint32_t, uint32_t> > :: iterator i = Order.begin( ); i != Order.end( ) && i->first > 0 && Success; ++i )
+		{
+			vector<uint32_t> &Names = BucketNames[i->second];
+			vector<uint32_t> Positions( Names.size( ) );
+			Success = false;
+
+			for( uint32_t Seed = 1; Seed < 65536 && !Success; ++Seed )
+			{
+				Success = true;
+
+				for( uint32_t j = 0; j < Names.size( ) && Success; ++j )
+				{
+					Positions[j] = Hash( m_Names[Names[j]], Seed ) & m_SlotMask;
+
+					if( m_Slots[Positions[j]] != NO_SLOT || find( Positions.begin( ), Positions.begin( ) + j, Positions[j] ) != Positions.begin( ) + j )
+						Success = false;
+				}
+
+				if( Success )
+				{
+					m_Displacements[i->second] = Seed;
+
+					for( uint32_t j = 0; j < Names.size( ); ++j )
+						m_Slots[Positions[j]] = Names[j];
+				}
+			}
+		}
+
+		if( Success )
+			break;
+
+		// this shouldn't happen with the sizes chosen above but if it does just try again with more room
+
+		Slots *= 2;
+	}
+}
+
+const CCommand *CCommandTable :: Find( const string &name ) const
+{
+	if( m_Slots.empty( ) )
+		return NULL;
+
+	uint32_t Slot = m_Slots[Hash( name, m_Displacements[Hash( name, 0 ) & m_BucketMask] ) & m_SlotMask];
+
+	if( Slot != NO_SLOT && m_Names[Slot] == name )
+		return &m_Commands[m_NameCommands[Slot]];
+
+	return NULL;
+}
+
+//
+// CCommandLimiter
+//
+
+CCommandLimiter :: CCommandLimiter( ) : m_MaxRateLimit( 0 )
+{
+
+}
+
+CCommandLimiter :: ~CCommandLimiter( )
+{
+
+}
+
+bool CCommandLimiter :: Allow( const CCommand *command, string user, uint32_t ticks )
+{
+	if( !command || command->m_RateLimit == 0 )
+		return true;
+
+	transform( user.begin( ), user.end( ), user.begin( ), (int(*)(int))tolower );
+	pair<string, uint32_t> Key( user, command->m_RateLimitGroup );
+	map<pair<string, uint32_t>, uint32_t> :: iterator i = m_LastUses.find( Key );
+
+	if( i != m_LastUses.end( ) && ticks - i->second < command->m_RateLimit )
+		return false;
+
+	if( command->m_RateLimit > m_MaxRateLimit )
+		m_MaxRateLimit = command->m_RateLimit;
+
+	// forget about users who haven't used a rate limited command recently so the map doesn't grow forever
+
+	if( m_LastUses.size( ) >= 256 )
+	{
+		for( map<pair<string, uint32_t>, uint32_t> :: iterator j = m_LastUses.begin( ); j != m_LastUses.end( ); )
+		{
+			if( ticks - j->second >= m_MaxRateLimit )
+				m_LastUses.erase( j++ );
+			else
+				++j;
+		}
+	}
+
+	m_LastUses[Key] = ticks;
+	return true;
+}
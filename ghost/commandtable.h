@@ -0,0 +1,111 @@
+/*
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*/
+
+
+#ifndef COMMANDTABLE_H
+#define COMMANDTABLE_H
+
+// who is allowed to use a command
+
+#define COMMAND_ACCESS_EVERYONE		0
+#define COMMAND_ACCESS_OWNER		1	// the game owner (admins are always allowed too)
+#define COMMAND_ACCESS_ADMIN		2
+
+// where a command may be used (bitmask)
+
+#define COMMAND_CONTEXT_LOBBY		1	// in a game lobby
+#define COMMAND_CONTEXT_INGAME		2	// in a game which is loading or loaded
+#define COMMAND_CONTEXT_CHANNEL		4	// in a battle.net channel
+#define COMMAND_CONTEXT_WHISPER		8	// whispered on battle.net
+#define COMMAND_CONTEXT_GAME		( COMMAND_CONTEXT_LOBBY | COMMAND_CONTEXT_INGAME )
+#define COMMAND_CONTEXT_BNET		( COMMAND_CONTEXT_CHANNEL | COMMAND_CONTEXT_WHISPER )
+
+//
+// CCommand
+//
+
+class CCommand
+{
+public:
+	uint32_t m_ID;					// the owner's command identifier (e.g. CGame :: CMD_PING)
+	string m_Name;					// the canonical name of the command
+	unsigned char m_Access;			// COMMAND_ACCESS_*
+	unsigned char m_Contexts;		// COMMAND_CONTEXT_* bitmask
+	uint32_t m_RateLimit;			// minimum number of milliseconds between two uses by the same user (0 = unlimited)
+	uint32_t m_RateLimitGroup;		// commands in the same group share their rate limit timer (defaults to m_ID)
+
+	CCommand( uint32_t nID, string nName, unsigned char nAccess, unsigned char nContexts, uint32_t nRateLimit, uint32_t nRateLimitGroup );
+
+	bool HasContext( unsigned char context ) const	{ return ( m_Contexts & context ) != 0; }
+};
+
+//
+// CCommandTable
+//
+
+// maps command names and aliases to commands with a minimal perfect hash built once at startup (hash and displace)
+// every name is hashed once to find its bucket and once more with the bucket's displacement to find its slot
+// so a lookup is two hashes and one string comparison no matter how many commands there are
+// the table is read only after Build so it can be shared between the game threads without locking
+
+class CCommandTable
+{
+private:
+	vector<CCommand> m_Commands;
+	vector<string> m_Names;					// every name and alias
+	vector<uint32_t> m_NameCommands;		// the index in m_Commands of each name
+	vector<uint32_t> m_Displacements;		// the hash seed of each bucket
+	vector<uint32_t> m_Slots;				// the index in m_Names of each slot (or NO_SLOT)
+	uint32_t m_BucketMask;
+	uint32_t m_SlotMask;
+
+	static uint32_t Hash( const string &name, uint32_t seed );
+
+public:
+	CCommandTable( );
+	~CCommandTable( );
+
+	// aliases is a space separated list of alternative names, e.g. Add( CMD_PING, "ping", "p", ... )
+
+	void Add( uint32_t id, string name, string aliases, unsigned char access, unsigned char contexts, uint32_t rateLimit = 0, uint32_t rateLimitGroup = 0xFFFFFFFF );
+	void Build( );
+	const CCommand *Find( const string &name ) const;
+	uint32_t GetSize( ) const		{ return m_Names.size( ); }
+};
+
+//
+// CCommandLimiter
+//
+
+// per user rate limiting for commands, each game and battle.net connection has one of these
+// it's only used from the owner's thread so there's no locking
+
+class CCommandLimiter
+{
+private:
+	map<pair<string, uint32_t>, uint32_t> m_LastUses;	// (lowercase user name, rate limit group) -> GetTicks of the last accepted use
+	uint32_t m_MaxRateLimit;							// longest rate limit seen, entries older than this can be pruned
+
+public:
+	CCommandLimiter( );
+	~CCommandLimiter( );
+
+	// returns true and records the use if the user may use the command now
+
+	bool Allow( const CCommand *command, string user, uint32_t ticks );
+};
+
+#endif
@@ -1,43 +1,65 @@
 #include "ghost.h"
 #include "crc32.h"
 
-void CCRC32 :: Initialize( )
+namespace
 {
-	for( int iCodes = 0; iCodes <= 0xFF; ++iCodes )
+	struct CRC32Table
 	{
-		ulTable[iCodes] = Reflect( iCodes, 8 ) << 24;
+		uint32_t ulTable[256];
+	};
 
-		for( int iPos = 0; iPos < 8; iPos++ )
-			ulTable[iCodes] = ( ulTable[iCodes] << 1 ) ^ ( ulTable[iCodes] & (1 << 31) ? CRC32_POLYNOMIAL : 0 );
+	constexpr uint32_t Reflect( uint32_t ulReflect, int cChar )
+	{
+		uint32_t ulValue = 0;
 
-		ulTable[iCodes] = Reflect( ulTable[iCodes], 32 );
-	}
-}
+		for( int iPos = 1; iPos < ( cChar + 1 ); ++iPos )
+		{
+			if( ulReflect & 1 )
+				ulValue |= (uint32_t)1 << ( cChar - iPos );
 
-uint32_t CCRC32 :: Reflect( uint32_t ulReflect, char cChar )
-{
-	uint32_t ulValue = 0;
+			ulReflect >>= 1;
+		}
 
-	for( int iPos = 1; iPos < ( cChar + 1 ); ++iPos )
+		return ulValue;
+	}
+
+	constexpr CRC32Table GenerateTable( )
 	{
-		if( ulReflect & 1 )
-			ulValue |= 1 << ( cChar - iPos );
+		CRC32Table Table = { };
+
+		for( int iCodes = 0; iCodes <= 0xFF; ++iCodes )
+		{
+			uint32_t ulCode = Reflect( iCodes, 8 ) << 24;
 
-		ulReflect >>= 1;
+			for( int iPos = 0; iPos < 8; ++iPos )
+				ulCode = ( ulCode << 1 ) ^ ( ulCode & ( (uint32_t)1 << 31 ) ? CRC32_POLYNOMIAL : 0 );
+
+			Table.ulTable[iCodes] = Reflect( ulCode, 32 );
+		}
+
+		return Table;
 	}
 
-	return ulValue;
+	constexpr CRC32Table g_CRC32 = GenerateTable( );
+
+	// the table is only as good as the generator, check the first entries against the well known zlib table
+
+	static_assert( g_CRC32.ulTable[1] == 0x77073096 && g_CRC32.ulTable[255] == 0x2D02EF8D, "CRC32 table generation is broken" );
 }
 
-uint32_t CCRC32 :: FullCRC( unsigned char *sData, uint32_t ulLength )
+uint32_t CCRC32 :: FullCRC( const unsigned char *sData, uint32_t ulLength )
 {
 	uint32_t ulCRC = 0xFFFFFFFF;
 	PartialCRC( &ulCRC, sData, ulLength );
 	return ulCRC ^ 0xFFFFFFFF;
 }
 
-void CCRC32 :: PartialCRC( uint32_t *ulInCRC, unsigned char *sData, uint32_t ulLength )
+void CCRC32 :: PartialCRC( uint32_t *ulInCRC, const unsigned char *sData, uint32_t ulLength )
 {
+	uint32_t ulCRC = *ulInCRC;
+
 	while( ulLength-- )
-		*ulInCRC = ( *ulInCRC >> 8 ) ^ ulTable[( *ulInCRC & 0xFF ) ^ *sData++];
+		ulCRC = ( ulCRC >> 8 ) ^ g_CRC32.ulTable[( ulCRC & 0xFF ) ^ *sData++];
+
+	*ulInCRC = ulCRC;
 }
@@ -3,16 +3,18 @@
 
 #define CRC32_POLYNOMIAL 0x04c11db7
 
+//
+// CCRC32
+//
+// stateless CRC32 (the reflected zlib/PKZIP variant used by Warcraft III)
+// the lookup table is generated at compile time so every function here is safe to call from any thread without locking
+//
+
 class CCRC32
 {
 public:
-	void Initialize( );
-	uint32_t FullCRC( unsigned char *sData, uint32_t ulLength );
-	void PartialCRC( uint32_t *ulInCRC, unsigned char *sData, uint32_t ulLength );
-
-private:
-	uint32_t Reflect( uint32_t ulReflect, char cChar );
-	uint32_t ulTable[256];
+	static uint32_t FullCRC( const unsigned char *sData, uint32_t ulLength );
+	static void PartialCRC( uint32_t *ulInCRC, const unsigned char *sData, uint32_t ulLength );
 };
 
 #endif
@@ -0,0 +1,212 @@
+/*
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*/
+
+#include "ghost.h"
+#include "util.h"
+#include "ghostdb.h"
+#include "currentgames.h"
+
+#include <time.h>
+
+bool CurrentGamesSortByCreation( const CDBCurrentGame &a, const CDBCurrentGame &b )
+{
+	return a.m_CreatedAt < b.m_CreatedAt;
+}
+
+//
+// CCurrentGames
+//
+
+CCurrentGames :: CCurrentGames( CGHost *nGHost, uint32_t nInterval ) : m_GHost( nGHost ), m_Publishing( NULL ), m_ClearAll( true ), m_Interval( nInterval ), m_LastFlushTicks( 0 )
+{
+
+}
+
+CCurrentGames :: ~CCurrentGames( )
+{
+
+}
+
+bool CCurrentGames :: Changed( const CDBCurrentGame &before, const CDBCurrentGame &after )
+{
+	// the expire date is only set when publishing so it isn't compared here
+
+	return before.m_OwnerName != after.m_OwnerName || before.m_GameName != after.m_GameName || before.m_Names != after.m_Names || before.m_MapName != after.m_MapName ||
+		before.m_CreatedAt != after.m_CreatedAt || before.m_StartedAt != after.m_StartedAt || before.m_GameStarted != after.m_GameStarted ||
+		before.m_OccupiedSlots != after.m_OccupiedSlots || before.m_MaxSlots != after.m_MaxSlots;
+}
+
+void CCurrentGames :: Update( const CDBCurrentGame &game )
+{
+	boost::mutex::scoped_lock lock( m_Mutex );
+	map<uint32_t, CDBCurrentGame> :: iterator i = m_Games.find( game.m_GameRandomID );
+
+	if( i == m_Games.end( ) )
+		m_Games[game.m_GameRandomID] = game;
+	else
+	{
+		// the games derive their creation and start times from GetTime so they can drift by a second between reports
+		// keep the first values we were given so the drift doesn't look like a change
+
+		time_t CreatedAt = i->second.m_CreatedAt;
+		time_t StartedAt = i->second.m_StartedAt;
+		i->second = game;
+		i->second.m_CreatedAt = CreatedAt;
+
+		if( StartedAt != 0 && game.m_StartedAt != 0 )
+			i->second.m_StartedAt = StartedAt;
+	}
+
+	m_Dirty.insert( game.m_GameRandomID );
+}
+
+void CCurrentGames :: Remove( uint32_t gameRandomID )
+{
+	boost::mutex::scoped_lock lock( m_Mutex );
+	m_Games.erase( gameRandomID );
+	m_Dirty.insert( gameRandomID );
+}
+
+void CCurrentGames :: Flush( bool enabled )
+{
+	if( m_Publishing || GetTicks( ) - m_LastFlushTicks < m_Interval )
+		return;
+
+	m_LastFlushTicks = GetTicks( );
+
+	if( !enabled )
+	{
+		boost::mutex::scoped_lock lock( m_Mutex );
+		m_Dirty.clear( );
+		return;
+	}
+
+	uint32_t Time = GetTime( );
+	vector<CDBCurrentGame> Games;
+	vector<uint32_t> Removed;
+	set<uint32_t> Refresh;
+	boost::mutex::scoped_lock lock( m_Mutex );
+
+	for( map<uint32_t, uint32_t> :: iterator i = m_PublishedTimes.begin( ); i != m_PublishedTimes.end( ); ++i )
+	{
+		if( Time - i->second >= CURRENTGAMES_REFRESH )
+		{
+			Refresh.insert( i->first );
+			m_Dirty.insert( i->first );
+		}
+	}
+
+	for( set<uint32_t> :: iterator i = m_Dirty.begin( ); i != m_Dirty.end( ); ++i )
+	{
+		map<uint32_t, CDBCurrentGame> :: iterator Game = m_Games.find( *i );
+		map<uint32_t, CDBCurrentGame> :: iterator Published = m_Published.find( *i );
+
+		if( Game != m_Games.end( ) )
+		{
+			if( Published == m_Published.end( ) || Changed( Published->second, Game->second ) || Refresh.find( *i ) != Refresh.end( ) )
+				Games.push_back( Game->second );
+		}
+		else if( Published != m_Published.end( ) )
+			Removed.push_back( *i );
+	}
+
+	m_Dirty.clear( );
+	lock.unlock( );
+
+	if( Games.empty( ) && Removed.empty( ) && !m_ClearAll )
+		return;
+
+	for( vector<CDBCurrentGame> :: iterator i = Games.begin( ); i != Games.end( ); ++i )
+	{
+		i->m_ExpireDate = time( NULL ) + CURRENTGAMES_EXPIRE;
+		m_Published[i->m_GameRandomID] = *i;
+		m_PublishedTimes[i->m_GameRandomID] = Time;
+	}
+
+	for( vector<uint32_t> :: iterator i = Removed.begin( ); i != Removed.end( ); ++i )
+	{
+		m_Published.erase( *i );
+		m_PublishedTimes.erase( *i );
+	}
+
+	m_Publishing = m_GHost->m_DB->ThreadedCurrentGamesPublish( m_GHost->m_BotID, m_ClearAll, Games, Removed );
+	m_ClearAll = false;
+
+	if( m_Publishing )
+		m_GHost->m_Callables->Add( m_Publishing, boost::bind( &CCurrentGames :: EventPublished, this, _1 ) );
+}
+
+void CCurrentGames :: EventPublished( CCallableCurrentGamesPublish *callable )
+{
+	m_Publishing = NULL;
+
+	if( callable->GetResult( ) )
+		return;
+
+	// we don't know which part of the batch made it to the database so start over with a clean slate and publish everything again
+
+	CONSOLE_Print( "[GHOST] unable to publish the current games [" + callable->GetError( ) + "], publishing all of them again" );
+	m_Published.clear( );
+	m_PublishedTimes.clear( );
+	m_ClearAll = true;
+
+	boost::mutex::scoped_lock lock( m_Mutex );
+
+	for( map<uint32_t, CDBCurrentGame> :: iterator i = m_Games.begin( ); i != m_Games.end( ); ++i )
+		m_Dirty.insert( i->first );
+}
+
+CCallableCurrentGamesQuery *CCurrentGames :: Query( bool includeLobbies, bool includeStarted, uint32_t queryOffset, uint32_t queryLimit )
+{
+	vector<CDBCurrentGame> Games;
+	boost::mutex::scoped_lock lock( m_Mutex );
+
+	for( map<uint32_t, CDBCurrentGame> :: iterator i = m_Games.begin( ); i != m_Games.end( ); ++i )
+		Games.push_back( i->second );
+
+	lock.unlock( );
+
+	// same order and filter as the database query
+
+	sort( Games.begin( ), Games.end( ), CurrentGamesSortByCreation );
+	uint32_t Lobbies = 0;
+	uint32_t Started = 0;
+	uint32_t Skipped = 0;
+	vector<CDBCurrentGame *> Result;
+
+	for( vector<CDBCurrentGame> :: iterator i = Games.begin( ); i != Games.end( ); ++i )
+	{
+		if( i->m_GameStarted )
+			++Started;
+		else
+			++Lobbies;
+
+		if( ( i->m_GameStarted && !includeStarted ) || ( !i->m_GameStarted && includeStarted && !includeLobbies ) )
+			continue;
+
+		if( Skipped < queryOffset )
+			++Skipped;
+		else if( Result.size( ) < queryLimit )
+			Result.push_back( new CDBCurrentGame( *i ) );
+	}
+
+	CCallableCurrentGamesQuery *Callable = new CCallableCurrentGamesQuery( includeLobbies, includeStarted, queryOffset, queryLimit );
+	Callable->Init( );
+	Callable->SetResult( Result );
+	Callable->SetTotals( Lobbies, Started );
+	Callable->Close( );
+	return Callable;
+}
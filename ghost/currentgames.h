@@ -0,0 +1,67 @@
+/*
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*/
+
+#ifndef CURRENTGAMES_H
+#define CURRENTGAMES_H
+
+//
+// CCurrentGames
+//
+
+// the bot's own lobbies and games as they're shown to players browsing the live current games list
+// games report their state here whenever it changes (from their own threads) and the main thread publishes the rows which changed in one batch per interval
+// rows which didn't change since they were last published aren't written again, they're only refreshed before their expire date passes
+// the same snapshot answers !games, !game and !lobby when the bot isn't a master bot (a master bot lists every bot's games so it has to ask the database)
+
+#define CURRENTGAMES_EXPIRE			1860	// seconds until a published row expires if the bot stops refreshing it (e.g. because it crashed)
+#define CURRENTGAMES_REFRESH		900		// seconds after which an unchanged row is published again to push its expire date back
+
+class CCurrentGames
+{
+private:
+	CGHost *m_GHost;
+	boost::mutex m_Mutex;							// protects m_Games and m_Dirty
+	map<uint32_t, CDBCurrentGame> m_Games;			// the latest state reported by each game, keyed by the game's random seed
+	set<uint32_t> m_Dirty;							// games which reported a change or were removed since the last flush
+	map<uint32_t, CDBCurrentGame> m_Published;		// the rows as they were last published (only touched by the main thread)
+	map<uint32_t, uint32_t> m_PublishedTimes;		// GetTime when each row was last published (only touched by the main thread)
+	CCallableCurrentGamesPublish *m_Publishing;		// the batch currently being written, the next one waits until it completes
+	bool m_ClearAll;								// remove any rows left over from a previous session with the next batch
+	uint32_t m_Interval;							// config value: minimum ticks between two batches
+	uint32_t m_LastFlushTicks;						// GetTicks when the last batch was sent
+
+	bool Changed( const CDBCurrentGame &before, const CDBCurrentGame &after );
+	void EventPublished( CCallableCurrentGamesPublish *callable );
+
+public:
+	CCurrentGames( CGHost *nGHost, uint32_t nInterval );
+	~CCurrentGames( );
+
+	// called by the games, from any thread
+
+	void Update( const CDBCurrentGame &game );
+	void Remove( uint32_t gameRandomID );
+
+	// called by the main thread
+
+	void Flush( bool enabled );
+
+	// answers a current games query from the snapshot, the returned callable is already ready
+
+	CCallableCurrentGamesQuery *Query( bool includeLobbies, bool includeStarted, uint32_t queryOffset, uint32_t queryLimit );
+};
+
+#endif
@@ -0,0 +1,223 @@
+/*
+
+   Copyright [2008] [Trevor Hogan]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   CODE PORTED FROM THE ORIGINAL GHOST PROJECT: http://ghost.pwner.org/
+
+*/
+
+#include "ghost.h"
+#include "util.h"
+#include "ghostdb.h"
+#include "actiondecoder.h"
+#include "dotagamecache.h"
+
+// item and hero ids are sent as the 4 character object id packed into the value (e.g. 'I0A3')
+
+static string ValueToObjectID( uint32_t value )
+{
+	char ObjectID[4] = { (char)( value >> 24 ), (char)( value >> 16 ), (char)( value >> 8 ), (char)value };
+	return string( ObjectID, 4 );
+}
+
+//
+// CDotAGameCache
+//
+
+CDotAGameCache :: CDotAGameCache( ) : m_Winner( 0 ), m_Min( 0 ), m_Sec( 0 )
+{
+	for( unsigned int i = 0; i < 12; ++i )
+		m_Players[i] = NULL;
+}
+
+CDotAGameCache :: ~CDotAGameCache( )
+{
+	for( unsigned int i = 0; i < 12; ++i )
+	{
+		if( m_Players[i] )
+			delete m_Players[i];
+	}
+}
+
+void CDotAGameCache :: OnSyncStored( unsigned char pid, unsigned char actionID, const char *file, const char *missionKey, const char *key, uint32_t value )
+{
+	if( actionID != W3GACTION_SYNCSTOREDINTEGER || strcmp( file, "dr.x" ) != 0 )
+		return;
+
+	// the mission key should either be the strings "Data" or "Global" or a player id in ASCII representation, e.g. "1" or "2"
+	// the key identifies the value and the value is a 4 byte integer
+
+	size_t KeyLength = strlen( key );
+
+	// CONSOLE_Print( "[STATS] " + string( missionKey ) + ", " + string( key ) + ", " + UTIL_ToString( value ) );
+
+	if( strcmp( missionKey, "Data" ) == 0 )
+	{
+		// these are received during the game
+		// you could use these to calculate killing sprees and double or triple kills (you'd have to make up your own time restrictions though)
+		// you could also build a table of "who killed who" data
+
+		if( KeyLength >= 5 && memcmp( key, "Hero", 4 ) == 0 )
+		{
+			// a hero died
+
+			OnHeroKill( value, strtoul( key + 4, NULL, 10 ) );
+		}
+		else if( KeyLength >= 8 && memcmp( key, "Courier", 7 ) == 0 )
+		{
+			// a courier died
+
+			if( ( value >= 1 && value <= 5 ) || ( value >= 7 && value <= 11 ) )
+			{
+				if( !m_Players[value] )
+					m_Players[value] = new CDBDotAPlayer( );
+
+				m_Players[value]->SetCourierKills( m_Players[value]->GetCourierKills( ) + 1 );
+			}
+
+			OnCourierKill( value, strtoul( key + 7, NULL, 10 ) );
+		}
+		else if( KeyLength >= 8 && memcmp( key, "Tower", 5 ) == 0 )
+		{
+			// a tower died
+
+			if( ( value >= 1 && value <= 5 ) || ( value >= 7 && value <= 11 ) )
+			{
+				if( !m_Players[value] )
+					m_Players[value] = new CDBDotAPlayer( );
+
+				m_Players[value]->SetTowerKills( m_Players[value]->GetTowerKills( ) + 1 );
+			}
+
+			OnTowerKill( value, key[5], key[6], key[7] );
+		}
+		else if( KeyLength >= 6 && memcmp( key, "Rax", 3 ) == 0 )
+		{
+			// a rax died
+
+			if( ( value >= 1 && value <= 5 ) || ( value >= 7 && value <= 11 ) )
+			{
+				if( !m_Players[value] )
+					m_Players[value] = new CDBDotAPlayer( );
+
+				m_Players[value]->SetRaxKills( m_Players[value]->GetRaxKills( ) + 1 );
+			}
+
+			OnRaxKill( value, key[3], key[4], key[5] );
+		}
+		else if( KeyLength >= 6 && memcmp( key, "Throne", 6 ) == 0 )
+		{
+			// the frozen throne got hurt
+
+			OnThroneHP( value );
+		}
+		else if( KeyLength >= 4 && memcmp( key, "Tree", 4 ) == 0 )
+		{
+			// the world tree got hurt
+
+			OnTreeHP( value );
+		}
+		else if( KeyLength >= 2 && memcmp( key, "CK", 2 ) == 0 )
+		{
+			// a player disconnected
+		}
+	}
+	else if( strcmp( missionKey, "Global" ) == 0 )
+	{
+		// these are only received at the end of the game
+
+		if( strcmp( key, "Winner" ) == 0 )
+		{
+			// Value 1 -> sentinel
+			// Value 2 -> scourge
+
+			m_Winner = value;
+			OnWinner( value );
+		}
+		else if( strcmp( key, "m" ) == 0 )
+			m_Min = value;
+		else if( strcmp( key, "s" ) == 0 )
+			m_Sec = value;
+	}
+	else if( isdigit( (unsigned char)missionKey[0] ) && ( missionKey[1] == 0 || ( isdigit( (unsigned char)missionKey[1] ) && missionKey[2] == 0 ) ) )
+	{
+		// these are only received at the end of the game
+
+		uint32_t ID = strtoul( missionKey, NULL, 10 );
+
+		if( ( ID >= 1 && ID <= 5 ) || ( ID >= 7 && ID <= 11 ) )
+		{
+			if( !m_Players[ID] )
+			{
+				m_Players[ID] = new CDBDotAPlayer( );
+				m_Players[ID]->SetColour( ID );
+			}
+
+			// Key "1"		-> Kills
+			// Key "2"		-> Deaths
+			// Key "3"		-> Creep Kills
+			// Key "4"		-> Creep Denies
+			// Key "5"		-> Assists
+			// Key "6"		-> Current Gold
+			// Key "7"		-> Neutral Kills
+			// Key "8_0"	-> Item 1
+			// Key "8_1"	-> Item 2
+			// Key "8_2"	-> Item 3
+			// Key "8_3"	-> Item 4
+			// Key "8_4"	-> Item 5
+			// Key "8_5"	-> Item 6
+			// Key "id"		-> ID (1-5 for sentinel, 6-10 for scourge, accurate after using -sp and/or -switch)
+
+			if( strcmp( key, "1" ) == 0 )
+				m_Players[ID]->SetKills( value );
+			else if( strcmp( key, "2" ) == 0 )
+				m_Players[ID]->SetDeaths( value );
+			else if( strcmp( key, "3" ) == 0 )
+				m_Players[ID]->SetCreepKills( value );
+			else if( strcmp( key, "4" ) == 0 )
+				m_Players[ID]->SetCreepDenies( value );
+			else if( strcmp( key, "5" ) == 0 )
+				m_Players[ID]->SetAssists( value );
+			else if( strcmp( key, "6" ) == 0 )
+				m_Players[ID]->SetGold( value );
+			else if( strcmp( key, "7" ) == 0 )
+				m_Players[ID]->SetNeutralKills( value );
+			else if( strcmp( key, "8_0" ) == 0 )
+				m_Players[ID]->SetItem( 0, ValueToObjectID( value ) );
+			else if( strcmp( key, "8_1" ) == 0 )
+				m_Players[ID]->SetItem( 1, ValueToObjectID( value ) );
+			else if( strcmp( key, "8_2" ) == 0 )
+				m_Players[ID]->SetItem( 2, ValueToObjectID( value ) );
+			else if( strcmp( key, "8_3" ) == 0 )
+				m_Players[ID]->SetItem( 3, ValueToObjectID( value ) );
+			else if( strcmp( key, "8_4" ) == 0 )
+				m_Players[ID]->SetItem( 4, ValueToObjectID( value ) );
+			else if( strcmp( key, "8_5" ) == 0 )
+				m_Players[ID]->SetItem( 5, ValueToObjectID( value ) );
+			else if( strcmp( key, "9" ) == 0 )
+				m_Players[ID]->SetHero( ValueToObjectID( value ) );
+			else if( strcmp( key, "id" ) == 0 )
+			{
+				// DotA sends id values from 1-10 with 1-5 being sentinel players and 6-10 being scourge players
+				// unfortunately the actual player colours are from 1-5 and from 7-11 so we need to deal with this case here
+
+				if( value >= 6 )
+					m_Players[ID]->SetNewColour( value + 1 );
+				else
+					m_Players[ID]->SetNewColour( value );
+			}
+		}
+	}
+}
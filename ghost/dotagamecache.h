@@ -0,0 +1,65 @@
+/*
+
+   Copyright [2008] [Trevor Hogan]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   CODE PORTED FROM THE ORIGINAL GHOST PROJECT: http://ghost.pwner.org/
+
+*/
+
+#ifndef DOTAGAMECACHE_H
+#define DOTAGAMECACHE_H
+
+//
+// CDotAGameCache
+//
+
+// dota sends its real time replay data as SyncStoredInteger actions (0x6B) on the game cache "dr.x"
+// this class turns those actions into the per colour player table and the game result, it doesn't need a game so it works the same while hosting (CStatsDOTA) and on saved replays (replay_analyzer)
+// the kill, tower, rax and ancient events are passed to the virtual functions below after the player table is updated, the base class ignores them
+
+class CDBDotAPlayer;
+
+class CDotAGameCache : public CActionHandler
+{
+protected:
+	CDBDotAPlayer *m_Players[12];		// indexed by colour, NULL until dota sends something for that colour
+	uint32_t m_Winner;					// 0 until the game ends, 1 for the Sentinel and 2 for the Scourge
+	uint32_t m_Min;
+	uint32_t m_Sec;
+
+public:
+	CDotAGameCache( );
+	virtual ~CDotAGameCache( );
+
+	CDBDotAPlayer *GetPlayer( uint32_t colour )		{ return colour < 12 ? m_Players[colour] : NULL; }
+	uint32_t GetWinner( )							{ return m_Winner; }
+	uint32_t GetMin( )								{ return m_Min; }
+	uint32_t GetSec( )								{ return m_Sec; }
+
+	virtual void OnSyncStored( unsigned char pid, unsigned char actionID, const char *file, const char *missionKey, const char *key, uint32_t value );
+
+	// killer is the killer's colour, 0 for the Sentinel or 6 for the Scourge
+	// alliance, level, side and type are the raw ASCII digits from the key
+
+	virtual void OnHeroKill( uint32_t killer, uint32_t victim ) { }
+	virtual void OnCourierKill( uint32_t killer, uint32_t owner ) { }
+	virtual void OnTowerKill( uint32_t killer, char alliance, char level, char side ) { }
+	virtual void OnRaxKill( uint32_t killer, char alliance, char side, char type ) { }
+	virtual void OnThroneHP( uint32_t percent ) { }
+	virtual void OnTreeHP( uint32_t percent ) { }
+	virtual void OnWinner( uint32_t winner ) { }
+};
+
+#endif
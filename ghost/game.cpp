@@ -24,6 +24,7 @@
 #include "language.h"
 #include "socket.h"
 #include "ghostdb.h"
+#include "commandtable.h"
 #include "bnet.h"
 #include "map.h"
 #include "packed.h"
@@ -32,7 +33,10 @@
 #include "gameprotocol.h"
 #include "game_base.h"
 #include "game.h"
+#include "currentgames.h"
+#include "actiondecoder.h"
 #include "stats.h"
+#include "dotagamecache.h"
 #include "statsdota.h"
 #include "statsw3mmd.h"
 #include "elorating.h"
@@ -88,14 +92,11 @@ CGame :: CGame( CGHost *nGHost, CMap *nMap, CSaveGame *nSaveGame, uint16_t nHost
 		m_Stats = new CStatsDOTA( this );
 
 	m_GameLoadedTime = 0;
-
-	if (m_GHost->m_LiveDBCurrentGamesUpdateEnabled)
-		UpdateCurrentGameLiveDBInfo(0);
+	UpdateCurrentGameLiveDBInfo(0);
 }
 
 CGame :: ~CGame( )
 {
-	boost::mutex::scoped_lock callablesLock( m_GHost->m_CallablesMutex );
 	CONSOLE_Print("[GAME: " + m_GameName + "] started finalizing CGame object...");
 
 	//Ban leavers
@@ -115,9 +116,9 @@ CGame :: ~CGame( )
 				string Reason = " Autobanned, left game \"" +m_GameName + "\"";
 				CONSOLE_Print("[AUTOBAN: " + m_GameName + "] Autobanning " + (*i)->GetName() + " (" + Reason + ")");
 
-				m_GHost->m_Callables.push_back( m_GHost->m_DB->ThreadedBanAdd( (*i)->GetSpoofedRealm(), (*i)->GetName( ), (*i)->GetIP(), m_GameName, "AUTOBAN", Reason ));
+				m_GHost->m_Callables->Add( m_GHost->m_DB->ThreadedBanAdd( (*i)->GetSpoofedRealm(), (*i)->GetName( ), (*i)->GetIP(), m_GameName, "AUTOBAN", Reason ));
 				//New:
-				//m_GHost->m_Callables.push_back(m_GHost->m_DB->ThreadedBanAdd((*i)->GetSpoofedRealm(), (*i)->GetName(), (*i)->GetIP(), m_GameName, "AUTOBAN", Reason, 5, 0));
+				//m_GHost->m_Callables->Add(m_GHost->m_DB->ThreadedBanAdd((*i)->GetSpoofedRealm(), (*i)->GetName(), (*i)->GetIP(), m_GameName, "AUTOBAN", Reason, 5, 0));
 			}
 		}
 	}
@@ -134,7 +135,7 @@ CGame :: ~CGame( )
 			// store the CDBGamePlayers in the database
 
 			for( vector<CDBGamePlayer *> :: iterator i = m_DBGamePlayers.begin( ); i != m_DBGamePlayers.end( ); ++i )
-				m_GHost->m_Callables.push_back( m_GHost->m_DB->ThreadedGamePlayerAdd( m_CallableGameAdd->GetResult( ), (*i)->GetName( ), (*i)->GetIP( ), (*i)->GetSpoofed( ), (*i)->GetSpoofedRealm( ), (*i)->GetReserved( ), (*i)->GetLoadingTime( ), (*i)->GetLeft( ), (*i)->GetLeftReason( ), (*i)->GetTeam( ), (*i)->GetColour( ) ) );
+				m_GHost->m_Callables->Add( m_GHost->m_DB->ThreadedGamePlayerAdd( m_CallableGameAdd->GetResult( ), (*i)->GetName( ), (*i)->GetIP( ), (*i)->GetSpoofed( ), (*i)->GetSpoofedRealm( ), (*i)->GetReserved( ), (*i)->GetLoadingTime( ), (*i)->GetLeft( ), (*i)->GetLeftReason( ), (*i)->GetTeam( ), (*i)->GetColour( ) ) );
 
 			// store the stats in the database
 
@@ -153,36 +154,9 @@ CGame :: ~CGame( )
 		m_CallableGameAdd = NULL;
 	}
 
-	//Delete game from current games in db
-
-	if (m_GHost->m_LiveDBCurrentGamesUpdateEnabled)
-	{
-		CONSOLE_Print("[GAME: " + m_GameName + "] deleting current live game info from db");
-		UpdateCurrentGameLiveDBInfo(1);
-	}
-
-	for( vector<PairedBanCheck> :: iterator i = m_PairedBanChecks.begin( ); i != m_PairedBanChecks.end( ); ++i )
-		m_GHost->m_Callables.push_back( i->second );
-
-	for( vector<PairedBanAdd> :: iterator i = m_PairedBanAdds.begin( ); i != m_PairedBanAdds.end( ); ++i )
-		m_GHost->m_Callables.push_back( i->second );
-
-	for( vector<PairedGPSCheck> :: iterator i = m_PairedGPSChecks.begin( ); i != m_PairedGPSChecks.end( ); ++i )
-		m_GHost->m_Callables.push_back( i->second );
+	//Delete game from current games
 
-	for( vector<PairedDPSCheck> :: iterator i = m_PairedDPSChecks.begin( ); i != m_PairedDPSChecks.end( ); ++i )
-		m_GHost->m_Callables.push_back( i->second );
-
-	for (vector<PairedDPSCheckNew> ::iterator i = m_PairedDPSChecksNew.begin(); i != m_PairedDPSChecksNew.end(); i++)
-		m_GHost->m_Callables.push_back(i->second);
-
-	for (vector<PairedDTopPlayersQuery> ::iterator i = m_PairedDTopPlayersQueries.begin(); i != m_PairedDTopPlayersQueries.end(); ++i)
-		m_GHost->m_Callables.push_back(i->second);
-
-	for (vector<CCallableCurrentGameUpdate*> ::iterator i = m_CurrentGameInfoUpdate.begin(); i != m_CurrentGameInfoUpdate.end(); ++i)
-		m_GHost->m_Callables.push_back(*i);
-
-	callablesLock.unlock( );
+	UpdateCurrentGameLiveDBInfo(1);
 
 	for( vector<CDBBan *> :: iterator i = m_DBBans.begin( ); i != m_DBBans.end( ); ++i )
 		delete *i;
@@ -202,334 +176,349 @@ CGame :: ~CGame( )
 	if( m_CallableGameAdd )
 	{
 		CONSOLE_Print( "[GAME: " + m_GameName + "] game is being deleted before all game data was saved, game data has been lost" );
-		boost::mutex::scoped_lock lock( m_GHost->m_CallablesMutex );
-		m_GHost->m_Callables.push_back( m_CallableGameAdd );
-		lock.unlock( );
+		m_GHost->m_Callables->Add( m_CallableGameAdd );
 	}
 }
 
-bool CGame :: Update( void *fd, void *send_fd )
+// the commands a player can use in a game lobby or in game, see EventPlayerBotCommand
+// the rate limits replace the old per player !stats and !statsdota timers, the dota stats commands share one timer
+
+void CGame :: RegisterCommands( CCommandTable *commands )
 {
-	// update callables
+	commands->Add( CMD_AUTOBAN, "autoban", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_CHECK, "check", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_CHECKBAN, "checkban", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_FROM, "from", "f", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_OWNER, "owner", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_PING, "ping", "p", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_ADDBAN, "addban", "ban", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_ANNOUNCE, "announce", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_BANLAST, "banlast", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_GS, "gs", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_LOCKGAME, "lockgame", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_MUTE, "mute", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_SAY, "say", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_TAKINGOVER, "takingover", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_UNLOCKGAME, "unlockgame", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_VIRTUALHOST, "virtualhost", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_W, "w", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_DROP, "drop", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_END, "end", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_COMP, "comp", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_LOBBY );
+	commands->Add( CMD_COMPCOLOUR, "compcolour", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_LOBBY );
+	commands->Add( CMD_COMPHANDICAP, "comphandicap", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_LOBBY );
+	commands->Add( CMD_COMPRACE, "comprace", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_LOBBY );
+	commands->Add( CMD_COMPTEAM, "compteam", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_LOBBY );
+	commands->Add( CMD_FAKEPLAYER, "fakeplayer", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_FPPAUSE, "fppause", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_FPRESUME, "fpresume", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_UNMUTE, "unmute", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_ABORT, "abort", "a", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_LOBBY );
+	commands->Add( CMD_AUTODISPLAYSTATS, "autodisplaystats", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_AUTOSAVE, "autosave", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_AUTOSTART, "autostart", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_BALANCE, "balance", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_CLEARHCL, "clearhcl", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_CLOSE, "close", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_LOBBY );
+	commands->Add( CMD_CLOSEALL, "closeall", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_LOBBY );
+	commands->Add( CMD_DBSTATUS, "dbstatus", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_DOWNLOAD, "download", "dl", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_LOBBY );
+	commands->Add( CMD_HCL, "hcl", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_HOLD, "hold", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_LOBBY );
+	commands->Add( CMD_KICK, "kick", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_LATENCY, "latency", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_MESSAGES, "messages", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_MUTEALL, "muteall", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_OPEN, "open", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_LOBBY );
+	commands->Add( CMD_OPENALL, "openall", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_LOBBY );
+	commands->Add( CMD_PRIV, "priv", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_PUB, "pub", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_REFRESH, "refresh", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_SENDLAN, "sendlan", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_SP, "sp", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_START, "start", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_SWAP, "swap", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_LOBBY );
+	commands->Add( CMD_SYNCLIMIT, "synclimit", "sync s", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_UNHOST, "unhost", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_UNMUTEALL, "unmuteall", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_VOTECANCEL, "votecancel", "", COMMAND_ACCESS_OWNER, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_CHECKME, "checkme", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_GN, "gn", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_R, "r", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_RALL, "rall", "ratingall", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_RMK, "rmk", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_RS, "rs", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_STATS, "stats", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_GAME, 5000 );
+	commands->Add( CMD_RESD, "resd", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_GAME, 1000, CMD_SD );
+	commands->Add( CMD_SD, "sd", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_GAME, 1000, CMD_SD );
+	commands->Add( CMD_STATSDOTA, "statsdota", "sdold", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_GAME, 3000, CMD_SD );
+	commands->Add( CMD_TOP, "top", "topd", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_GAME, 1000, CMD_SD );
+	commands->Add( CMD_VERSION, "version", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_VOTEKICK, "votekick", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_YES, "yes", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_GAME );
+}
 
-	for( vector<PairedBanCheck> :: iterator i = m_PairedBanChecks.begin( ); i != m_PairedBanChecks.end( ); )
-	{
-		if( i->second->GetReady( ) )
-		{
-			CDBBan *Ban = i->second->GetResult( );
+void CGame :: EventCallableBanCheck( string user, CCallableBanCheck *callable )
+{
+	CDBBan *Ban = callable->GetResult( );
 
-			if( Ban )
-				SendAllChat( m_GHost->m_Language->UserWasBannedOnByBecause( i->second->GetServer( ), i->second->GetUser( ), Ban->GetDate( ), Ban->GetAdmin( ), Ban->GetReason( ) ) );
-			else
-				SendAllChat( m_GHost->m_Language->UserIsNotBanned( i->second->GetServer( ), i->second->GetUser( ) ) );
+	if( Ban )
+		SendAllChat( m_GHost->m_Language->UserWasBannedOnByBecause( callable->GetServer( ), callable->GetUser( ), Ban->GetDate( ), Ban->GetAdmin( ), Ban->GetReason( ) ) );
+	else
+		SendAllChat( m_GHost->m_Language->UserIsNotBanned( callable->GetServer( ), callable->GetUser( ) ) );
+}
 
-			m_GHost->m_DB->RecoverCallable( i->second );
-			delete i->second;
-			i = m_PairedBanChecks.erase( i );
+void CGame :: EventCallableBanAdd( string user, CCallableBanAdd *callable )
+{
+	if( callable->GetResult( ) )
+	{
+		for( vector<CBNET *> :: iterator j = m_GHost->m_BNETs.begin( ); j != m_GHost->m_BNETs.end( ); ++j )
+		{
+			if( (*j)->GetServer( ) == callable->GetServer( ) )
+				(*j)->AddBan( callable->GetUser( ), callable->GetIP( ), callable->GetGameName( ), callable->GetAdmin( ), callable->GetReason( ) );
 		}
-		else
-			++i;
+
+		SendAllChat( m_GHost->m_Language->PlayerWasBannedByPlayer( callable->GetServer( ), callable->GetUser( ), user ) );
 	}
+}
+
+void CGame :: EventCallableGamePlayerSummaryCheck( string user, CCallableGamePlayerSummaryCheck *callable )
+{
+	CDBGamePlayerSummary *GamePlayerSummary = callable->GetResult( );
 
-	for( vector<PairedBanAdd> :: iterator i = m_PairedBanAdds.begin( ); i != m_PairedBanAdds.end( ); )
+	if( GamePlayerSummary )
 	{
-		if( i->second->GetReady( ) )
+		if( user.empty( ) )
+			SendAllChat( m_GHost->m_Language->HasPlayedGamesWithThisBot( callable->GetName( ), GamePlayerSummary->GetFirstGameDateTime( ), GamePlayerSummary->GetLastGameDateTime( ), UTIL_ToString( GamePlayerSummary->GetTotalGames( ) ), UTIL_ToString( (float)GamePlayerSummary->GetAvgLoadingTime( ) / 1000, 2 ), UTIL_ToString( GamePlayerSummary->GetAvgLeftPercent( ) ) ) );
+		else
 		{
-			if( i->second->GetResult( ) )
-			{
-				for( vector<CBNET *> :: iterator j = m_GHost->m_BNETs.begin( ); j != m_GHost->m_BNETs.end( ); ++j )
-				{
-					if( (*j)->GetServer( ) == i->second->GetServer( ) )
-						(*j)->AddBan( i->second->GetUser( ), i->second->GetIP( ), i->second->GetGameName( ), i->second->GetAdmin( ), i->second->GetReason( ) );
-				}
+			CGamePlayer *Player = GetPlayerFromName( user, true );
 
-				SendAllChat( m_GHost->m_Language->PlayerWasBannedByPlayer( i->second->GetServer( ), i->second->GetUser( ), i->first ) );
-			}
-
-			m_GHost->m_DB->RecoverCallable( i->second );
-			delete i->second;
-			i = m_PairedBanAdds.erase( i );
+			if( Player )
+				SendChat( Player, m_GHost->m_Language->HasPlayedGamesWithThisBot( callable->GetName( ), GamePlayerSummary->GetFirstGameDateTime( ), GamePlayerSummary->GetLastGameDateTime( ), UTIL_ToString( GamePlayerSummary->GetTotalGames( ) ), UTIL_ToString( (float)GamePlayerSummary->GetAvgLoadingTime( ) / 1000, 2 ), UTIL_ToString( GamePlayerSummary->GetAvgLeftPercent( ) ) ) );
 		}
-		else
-			++i;
 	}
-
-	for( vector<PairedGPSCheck> :: iterator i = m_PairedGPSChecks.begin( ); i != m_PairedGPSChecks.end( ); )
+	else
 	{
-		if( i->second->GetReady( ) )
+		if( user.empty( ) )
+			SendAllChat( m_GHost->m_Language->HasntPlayedGamesWithThisBot( callable->GetName( ) ) );
+		else
 		{
-			CDBGamePlayerSummary *GamePlayerSummary = i->second->GetResult( );
+			CGamePlayer *Player = GetPlayerFromName( user, true );
 
-			if( GamePlayerSummary )
-			{
-				if( i->first.empty( ) )
-					SendAllChat( m_GHost->m_Language->HasPlayedGamesWithThisBot( i->second->GetName( ), GamePlayerSummary->GetFirstGameDateTime( ), GamePlayerSummary->GetLastGameDateTime( ), UTIL_ToString( GamePlayerSummary->GetTotalGames( ) ), UTIL_ToString( (float)GamePlayerSummary->GetAvgLoadingTime( ) / 1000, 2 ), UTIL_ToString( GamePlayerSummary->GetAvgLeftPercent( ) ) ) );
-				else
-				{
-					CGamePlayer *Player = GetPlayerFromName( i->first, true );
+			if( Player )
+				SendChat( Player, m_GHost->m_Language->HasntPlayedGamesWithThisBot( callable->GetName( ) ) );
+		}
+	}
+}
 
-					if( Player )
-						SendChat( Player, m_GHost->m_Language->HasPlayedGamesWithThisBot( i->second->GetName( ), GamePlayerSummary->GetFirstGameDateTime( ), GamePlayerSummary->GetLastGameDateTime( ), UTIL_ToString( GamePlayerSummary->GetTotalGames( ) ), UTIL_ToString( (float)GamePlayerSummary->GetAvgLoadingTime( ) / 1000, 2 ), UTIL_ToString( GamePlayerSummary->GetAvgLeftPercent( ) ) ) );
-				}
-			}
-			else
-			{
-				if( i->first.empty( ) )
-					SendAllChat( m_GHost->m_Language->HasntPlayedGamesWithThisBot( i->second->GetName( ) ) );
-				else
-				{
-					CGamePlayer *Player = GetPlayerFromName( i->first, true );
+void CGame :: EventCallableDotAPlayerSummaryCheck( string user, CCallableDotAPlayerSummaryCheck *callable )
+{
+	CDBDotAPlayerSummary *DotAPlayerSummary = callable->GetResult( );
 
-					if( Player )
-						SendChat( Player, m_GHost->m_Language->HasntPlayedGamesWithThisBot( i->second->GetName( ) ) );
-				}
-			}
+	if( DotAPlayerSummary )
+	{
+		string Summary = m_GHost->m_Language->HasPlayedDotAGamesWithThisBot(	callable->GetName( ),
+			UTIL_ToString( DotAPlayerSummary->GetTotalGames( ) ),
+			UTIL_ToString( DotAPlayerSummary->GetTotalWins( ) ),
+			UTIL_ToString( DotAPlayerSummary->GetTotalLosses( ) ),
+			UTIL_ToString( DotAPlayerSummary->GetTotalKills( ) ),
+			UTIL_ToString( DotAPlayerSummary->GetTotalDeaths( ) ),
+			UTIL_ToString( DotAPlayerSummary->GetTotalCreepKills( ) ),
+			UTIL_ToString( DotAPlayerSummary->GetTotalCreepDenies( ) ),
+			UTIL_ToString( DotAPlayerSummary->GetTotalAssists( ) ),
+			UTIL_ToString( DotAPlayerSummary->GetTotalNeutralKills( ) ),
+			UTIL_ToString( DotAPlayerSummary->GetTotalTowerKills( ) ),
+			UTIL_ToString( DotAPlayerSummary->GetTotalRaxKills( ) ),
+			UTIL_ToString( DotAPlayerSummary->GetTotalCourierKills( ) ),
+			UTIL_ToString( DotAPlayerSummary->GetAvgKills( ), 2 ),
+			UTIL_ToString( DotAPlayerSummary->GetAvgDeaths( ), 2 ),
+			UTIL_ToString( DotAPlayerSummary->GetAvgCreepKills( ), 2 ),
+			UTIL_ToString( DotAPlayerSummary->GetAvgCreepDenies( ), 2 ),
+			UTIL_ToString( DotAPlayerSummary->GetAvgAssists( ), 2 ),
+			UTIL_ToString( DotAPlayerSummary->GetAvgNeutralKills( ), 2 ),
+			UTIL_ToString( DotAPlayerSummary->GetAvgTowerKills( ), 2 ),
+			UTIL_ToString( DotAPlayerSummary->GetAvgRaxKills( ), 2 ),
+			UTIL_ToString( DotAPlayerSummary->GetAvgCourierKills( ), 2 ) );
+
+		if( user.empty( ) )
+			SendAllChat( Summary );
+		else
+		{
+			CGamePlayer *Player = GetPlayerFromName( user, true );
 
-			m_GHost->m_DB->RecoverCallable( i->second );
-			delete i->second;
-			i = m_PairedGPSChecks.erase( i );
+			if( Player )
+				SendChat( Player, Summary );
 		}
-		else
-			++i;
 	}
-
-	for( vector<PairedDPSCheck> :: iterator i = m_PairedDPSChecks.begin( ); i != m_PairedDPSChecks.end( ); )
+	else
 	{
-		if( i->second->GetReady( ) )
-		{
-			CDBDotAPlayerSummary *DotAPlayerSummary = i->second->GetResult( );
-
-			if( DotAPlayerSummary )
-			{
-				string Summary = m_GHost->m_Language->HasPlayedDotAGamesWithThisBot(	i->second->GetName( ),
-					UTIL_ToString( DotAPlayerSummary->GetTotalGames( ) ),
-					UTIL_ToString( DotAPlayerSummary->GetTotalWins( ) ),
-					UTIL_ToString( DotAPlayerSummary->GetTotalLosses( ) ),
-					UTIL_ToString( DotAPlayerSummary->GetTotalKills( ) ),
-					UTIL_ToString( DotAPlayerSummary->GetTotalDeaths( ) ),
-					UTIL_ToString( DotAPlayerSummary->GetTotalCreepKills( ) ),
-					UTIL_ToString( DotAPlayerSummary->GetTotalCreepDenies( ) ),
-					UTIL_ToString( DotAPlayerSummary->GetTotalAssists( ) ),
-					UTIL_ToString( DotAPlayerSummary->GetTotalNeutralKills( ) ),
-					UTIL_ToString( DotAPlayerSummary->GetTotalTowerKills( ) ),
-					UTIL_ToString( DotAPlayerSummary->GetTotalRaxKills( ) ),
-					UTIL_ToString( DotAPlayerSummary->GetTotalCourierKills( ) ),
-					UTIL_ToString( DotAPlayerSummary->GetAvgKills( ), 2 ),
-					UTIL_ToString( DotAPlayerSummary->GetAvgDeaths( ), 2 ),
-					UTIL_ToString( DotAPlayerSummary->GetAvgCreepKills( ), 2 ),
-					UTIL_ToString( DotAPlayerSummary->GetAvgCreepDenies( ), 2 ),
-					UTIL_ToString( DotAPlayerSummary->GetAvgAssists( ), 2 ),
-					UTIL_ToString( DotAPlayerSummary->GetAvgNeutralKills( ), 2 ),
-					UTIL_ToString( DotAPlayerSummary->GetAvgTowerKills( ), 2 ),
-					UTIL_ToString( DotAPlayerSummary->GetAvgRaxKills( ), 2 ),
-					UTIL_ToString( DotAPlayerSummary->GetAvgCourierKills( ), 2 ) );
-
-				if( i->first.empty( ) )
-					SendAllChat( Summary );
-				else
-				{
-					CGamePlayer *Player = GetPlayerFromName( i->first, true );
-
-					if( Player )
-						SendChat( Player, Summary );
-				}
-			}
-			else
-			{
-				if( i->first.empty( ) )
-					SendAllChat( m_GHost->m_Language->HasntPlayedDotAGamesWithThisBot( i->second->GetName( ) ) );
-				else
-				{
-					CGamePlayer *Player = GetPlayerFromName( i->first, true );
-
-					if( Player )
-						SendChat( Player, m_GHost->m_Language->HasntPlayedDotAGamesWithThisBot( i->second->GetName( ) ) );
-				}
-			}
+		if( user.empty( ) )
+			SendAllChat( m_GHost->m_Language->HasntPlayedDotAGamesWithThisBot( callable->GetName( ) ) );
+		else
+		{
+			CGamePlayer *Player = GetPlayerFromName( user, true );
 
-			m_GHost->m_DB->RecoverCallable( i->second );
-			delete i->second;
-			i = m_PairedDPSChecks.erase( i );
+			if( Player )
+				SendChat( Player, m_GHost->m_Language->HasntPlayedDotAGamesWithThisBot( callable->GetName( ) ) );
 		}
-		else
-			++i;
 	}
+}
 
-	for (vector<PairedDPSCheckNew> ::iterator i = m_PairedDPSChecksNew.begin(); i != m_PairedDPSChecksNew.end(); )
+void CGame :: EventCallableDotAPlayerSummaryCheckNew( string user, CCallableDotAPlayerSummaryCheckNew *callable )
+{
+	CDBDotAPlayerSummaryNew* DotAPlayerSummary = callable->GetResult();
+
+	bool sd = false;
+	bool Whisper = !user.empty();
+	string name = user;
+
+	if (user[0] == '%')
 	{
-		if (i->second->GetReady())
+		name = user.substr(1, user.length() - 1);
+		Whisper = user.length() > 1;
+		sd = true;
+	}
+
+	if (sd)
+		if (DotAPlayerSummary)
 		{
-			CDBDotAPlayerSummaryNew* DotAPlayerSummary = i->second->GetResult();
+			uint32_t scorescount = 99; //= m_GHost->ScoresCount();
 
-			bool sd = false;
-			bool Whisper = !i->first.empty();
-			string name = i->first;
+			CGamePlayer* PlayerN = GetPlayerFromName(callable->GetName(), true);
 
-			if (i->first[0] == '%')
+			if (PlayerN)
 			{
-				name = i->first.substr(1, i->first.length() - 1);
-				Whisper = i->first.length() > 1;
-				sd = true;
+				//PlayerN->SetScoreS(UTIL_ToString2(DotAPlayerSummary->GetScore()));
+				//PlayerN->SetRankS(UTIL_ToString(DotAPlayerSummary->GetRank()));
+				PlayerN->SetDotASummary(DotAPlayerSummary);
 			}
 
-			if (sd)
-				if (DotAPlayerSummary)
-				{
-					uint32_t scorescount = 99; //= m_GHost->ScoresCount();
-
-					CGamePlayer* PlayerN = GetPlayerFromName(i->second->GetName(), true);
-
-					if (PlayerN)
-					{
-						//PlayerN->SetScoreS(UTIL_ToString2(DotAPlayerSummary->GetScore()));
-						//PlayerN->SetRankS(UTIL_ToString(DotAPlayerSummary->GetRank()));
-						PlayerN->SetDotASummary(DotAPlayerSummary);
-					}
+			string RankS = UTIL_ToString(DotAPlayerSummary->GetRank());
+			if (DotAPlayerSummary->GetRank() > 0)
+				RankS = RankS + "/" + UTIL_ToString(scorescount);
 
-					string RankS = UTIL_ToString(DotAPlayerSummary->GetRank());
-					if (DotAPlayerSummary->GetRank() > 0)
-						RankS = RankS + "/" + UTIL_ToString(scorescount);
-
-					string SummaryMsg1 = "[" + i->second->GetName() + "] PSR: " + UTIL_ToString(DotAPlayerSummary->GetRating()) + " Games: " + UTIL_ToString(DotAPlayerSummary->GetTotalGames()) +
-						" (W/L: " + UTIL_ToString(DotAPlayerSummary->GetTotalWins()) + "/" + UTIL_ToString(DotAPlayerSummary->GetTotalLosses()) + ") Leave: " + UTIL_ToString(DotAPlayerSummary->GetLeavePercent() * 100,0) + "% WR: " + UTIL_ToString(DotAPlayerSummary->GetWinsPerGame(), 0) + "%" + "  PT: " + UTIL_ToString((float_t)DotAPlayerSummary->GetTotalPlayedMinutes() / 60, 1) + "hr";
-					string SummaryMsg2 = "Hero KDA: " + UTIL_ToString(DotAPlayerSummary->GetKillsPerGame(), 2) + "/" + UTIL_ToString(DotAPlayerSummary->GetDeathsPerGame(), 2) + "/" + UTIL_ToString(DotAPlayerSummary->GetAssistsPerGame(), 2) +
-						" Creep KDN: " + UTIL_ToString(DotAPlayerSummary->GetCreepKillsPerGame(), 2) + "/" + UTIL_ToString(DotAPlayerSummary->GetCreepDeniesPerGame(), 2) + "/" + UTIL_ToString(DotAPlayerSummary->GetNeutralKillsPerGame(), 2);
+			string SummaryMsg1 = "[" + callable->GetName() + "] PSR: " + UTIL_ToString(DotAPlayerSummary->GetRating()) + " Games: " + UTIL_ToString(DotAPlayerSummary->GetTotalGames()) +
+				" (W/L: " + UTIL_ToString(DotAPlayerSummary->GetTotalWins()) + "/" + UTIL_ToString(DotAPlayerSummary->GetTotalLosses()) + ") Leave: " + UTIL_ToString(DotAPlayerSummary->GetLeavePercent() * 100,0) + "% WR: " + UTIL_ToString(DotAPlayerSummary->GetWinsPerGame(), 0) + "%" + "  PT: " + UTIL_ToString((float_t)DotAPlayerSummary->GetTotalPlayedMinutes() / 60, 1) + "hr";
+			string SummaryMsg2 = "Hero KDA: " + UTIL_ToString(DotAPlayerSummary->GetKillsPerGame(), 2) + "/" + UTIL_ToString(DotAPlayerSummary->GetDeathsPerGame(), 2) + "/" + UTIL_ToString(DotAPlayerSummary->GetAssistsPerGame(), 2) +
+				" Creep KDN: " + UTIL_ToString(DotAPlayerSummary->GetCreepKillsPerGame(), 2) + "/" + UTIL_ToString(DotAPlayerSummary->GetCreepDeniesPerGame(), 2) + "/" + UTIL_ToString(DotAPlayerSummary->GetNeutralKillsPerGame(), 2);
 
-					if (!Whisper) 
-					{
-						SendAllChat(SummaryMsg1);
-						SendAllChat(SummaryMsg2);
-					}					
-					else
-					{
-						CGamePlayer* Player = GetPlayerFromName(i->first, true);
+			if (!Whisper) 
+			{
+				SendAllChat(SummaryMsg1);
+				SendAllChat(SummaryMsg2);
+			}					
+			else
+			{
+				CGamePlayer* Player = GetPlayerFromName(user, true);
 
-						if (Player) 
-						{
-							SendChat(Player, SummaryMsg1);
-							SendChat(Player, SummaryMsg2);
-						}						
-					}
-				}
-				else
+				if (Player) 
 				{
-					if (!Whisper)
-						SendAllChat(m_GHost->m_Language->HasntPlayedDotAGamesWithThisBot(i->second->GetName()));
-					else
-					{
-						CGamePlayer* Player = GetPlayerFromName(i->first, true);
-						if (Player)
-						{
-							SendChat(Player, m_GHost->m_Language->HasntPlayedDotAGamesWithThisBot(i->second->GetName()));
-						
-						}
-					}
-				}
-			if (!sd)
-				if (DotAPlayerSummary)
+					SendChat(Player, SummaryMsg1);
+					SendChat(Player, SummaryMsg2);
+				}						
+			}
+		}
+		else
+		{
+			if (!Whisper)
+				SendAllChat(m_GHost->m_Language->HasntPlayedDotAGamesWithThisBot(callable->GetName()));
+			else
+			{
+				CGamePlayer* Player = GetPlayerFromName(user, true);
+				if (Player)
 				{
-					string SummaryMsg1 = "[" + i->second->GetName() + "] PSR: " + UTIL_ToString(DotAPlayerSummary->GetRating()) + " Games: " + UTIL_ToString(DotAPlayerSummary->GetTotalGames()) +
-						" (W/L: " + UTIL_ToString(DotAPlayerSummary->GetTotalWins()) + "/" + UTIL_ToString(DotAPlayerSummary->GetTotalLosses()) + ") Leave: " + UTIL_ToString(DotAPlayerSummary->GetLeavePercent(), 0) + "% WR: " + UTIL_ToString(DotAPlayerSummary->GetWinsPerGame() * 100, 0) + "%" + "  PT: " + UTIL_ToString((float_t)DotAPlayerSummary->GetTotalPlayedMinutes() / 60, 1) + "hr";
-					string SummaryMsg2 = "Hero KDA: " + UTIL_ToString(DotAPlayerSummary->GetKillsPerGame(), 2) + "/" + UTIL_ToString(DotAPlayerSummary->GetDeathsPerGame(), 2) + "/" + UTIL_ToString(DotAPlayerSummary->GetAssistsPerGame(), 2) +
-						" Creep KDN: " + UTIL_ToString(DotAPlayerSummary->GetCreepKillsPerGame(), 2) + "/" + UTIL_ToString(DotAPlayerSummary->GetCreepDeniesPerGame(), 2) + "/" + UTIL_ToString(DotAPlayerSummary->GetNeutralKillsPerGame(), 2);
+					SendChat(Player, m_GHost->m_Language->HasntPlayedDotAGamesWithThisBot(callable->GetName()));
+				
+				}
+			}
+		}
+	if (!sd)
+		if (DotAPlayerSummary)
+		{
+			string SummaryMsg1 = "[" + callable->GetName() + "] PSR: " + UTIL_ToString(DotAPlayerSummary->GetRating()) + " Games: " + UTIL_ToString(DotAPlayerSummary->GetTotalGames()) +
+				" (W/L: " + UTIL_ToString(DotAPlayerSummary->GetTotalWins()) + "/" + UTIL_ToString(DotAPlayerSummary->GetTotalLosses()) + ") Leave: " + UTIL_ToString(DotAPlayerSummary->GetLeavePercent(), 0) + "% WR: " + UTIL_ToString(DotAPlayerSummary->GetWinsPerGame() * 100, 0) + "%" + "  PT: " + UTIL_ToString((float_t)DotAPlayerSummary->GetTotalPlayedMinutes() / 60, 1) + "hr";
+			string SummaryMsg2 = "Hero KDA: " + UTIL_ToString(DotAPlayerSummary->GetKillsPerGame(), 2) + "/" + UTIL_ToString(DotAPlayerSummary->GetDeathsPerGame(), 2) + "/" + UTIL_ToString(DotAPlayerSummary->GetAssistsPerGame(), 2) +
+				" Creep KDN: " + UTIL_ToString(DotAPlayerSummary->GetCreepKillsPerGame(), 2) + "/" + UTIL_ToString(DotAPlayerSummary->GetCreepDeniesPerGame(), 2) + "/" + UTIL_ToString(DotAPlayerSummary->GetNeutralKillsPerGame(), 2);
 
-					if (i->first.empty()) 
-					{
-						SendAllChat(SummaryMsg1);
-						SendAllChat(SummaryMsg2);
-					}
-					else
-					{
-						CGamePlayer* Player = GetPlayerFromName(i->first, true);
+			if (user.empty()) 
+			{
+				SendAllChat(SummaryMsg1);
+				SendAllChat(SummaryMsg2);
+			}
+			else
+			{
+				CGamePlayer* Player = GetPlayerFromName(user, true);
 
-						if (Player)
-						{
-							SendChat(Player, SummaryMsg1);
-							SendChat(Player, SummaryMsg2);
-						}
-					}
-				}
-				else
+				if (Player)
 				{
-					if (i->first.empty())
-						SendAllChat(m_GHost->m_Language->HasntPlayedDotAGamesWithThisBot(i->second->GetName()));
-					else
-					{
-						CGamePlayer* Player = GetPlayerFromName(i->first, true);
-
-						if (Player)
-							SendChat(Player, m_GHost->m_Language->HasntPlayedDotAGamesWithThisBot(i->second->GetName()));
-					}
+					SendChat(Player, SummaryMsg1);
+					SendChat(Player, SummaryMsg2);
 				}
-
-			m_GHost->m_DB->RecoverCallable(i->second);
-			delete i->second;
-			i = m_PairedDPSChecksNew.erase(i);
+			}
 		}
 		else
-			i++;
-	}
+		{
+			if (user.empty())
+				SendAllChat(m_GHost->m_Language->HasntPlayedDotAGamesWithThisBot(callable->GetName()));
+			else
+			{
+				CGamePlayer* Player = GetPlayerFromName(user, true);
 
-	for (vector<PairedDTopPlayersQuery> ::iterator i = m_PairedDTopPlayersQueries.begin(); i != m_PairedDTopPlayersQueries.end(); )
+				if (Player)
+					SendChat(Player, m_GHost->m_Language->HasntPlayedDotAGamesWithThisBot(callable->GetName()));
+			}
+		}
+}
+
+void CGame :: EventCallableDotATopPlayersQuery( string user, CCallableDotATopPlayersQuery *callable )
+{
+	CDBDotATopPlayers* TopPlayers = callable->GetResult();
+
+	if (TopPlayers)
 	{
-		if (i->second->GetReady())
-		{
-			CDBDotATopPlayers* TopPlayers = i->second->GetResult();
+		vector<string> ReplyMsgs;
 
-			if (TopPlayers)
+		if (TopPlayers && TopPlayers->GetCount() > 0)
+		{
+			ReplyMsgs.push_back(string("DotA Ladder Top Players: "));
+			string CurrentReplyMsg = string();
+			for (unsigned int n = 0; n < TopPlayers->GetCount(); n++)
 			{
-				vector<string> ReplyMsgs;
-
-				if (TopPlayers && TopPlayers->GetCount() > 0)
+				if (CurrentReplyMsg.size() > 80)
 				{
-					ReplyMsgs.push_back(string("DotA Ladder Top Players: "));
-					string CurrentReplyMsg = string();
-					for (unsigned int n = 0; n < TopPlayers->GetCount(); n++)
-					{
-						if (CurrentReplyMsg.size() > 80)
-						{
-							ReplyMsgs.push_back(CurrentReplyMsg);
-							CurrentReplyMsg = string();
-						}
-						uint32_t SDFF = TopPlayers->GetPlayerRating(n);
-						CurrentReplyMsg += "#" + UTIL_ToString(TopPlayers->GetOffset() + n + 1) + ") " + TopPlayers->GetPlayerName(n) + "(" + UTIL_ToString(TopPlayers->GetPlayerRating(n)) + ")  ";
-					}
-					if(CurrentReplyMsg.size())
-						ReplyMsgs.push_back(CurrentReplyMsg);		
-				}
-				else
-					ReplyMsgs.push_back(string("N/A"));
-	
-				for(vector<string>::iterator msg = ReplyMsgs.begin(); msg != ReplyMsgs.end(); msg++)
-				{
-					if (i->first.empty())
-						SendAllChat(*msg);
-					else
-					{
-						CGamePlayer* Player = GetPlayerFromName(i->first, true);
-
-						if (Player)
-							SendChat(Player, *msg);
-					}
+					ReplyMsgs.push_back(CurrentReplyMsg);
+					CurrentReplyMsg = string();
 				}
+				uint32_t SDFF = TopPlayers->GetPlayerRating(n);
+				CurrentReplyMsg += "#" + UTIL_ToString(TopPlayers->GetOffset() + n + 1) + ") " + TopPlayers->GetPlayerName(n) + "(" + UTIL_ToString(TopPlayers->GetPlayerRating(n)) + ")  ";
 			}
+			if(CurrentReplyMsg.size())
+				ReplyMsgs.push_back(CurrentReplyMsg);		
+		}
+		else
+			ReplyMsgs.push_back(string("N/A"));
+
+		for(vector<string>::iterator msg = ReplyMsgs.begin(); msg != ReplyMsgs.end(); msg++)
+		{
+			if (user.empty())
+				SendAllChat(*msg);
 			else
 			{
-				CGamePlayer* Player = GetPlayerFromName(i->first, true);
+				CGamePlayer* Player = GetPlayerFromName(user, true);
 
 				if (Player)
-					SendChat(Player, "Could not retrieve DotA ladder top player list");
+					SendChat(Player, *msg);
 			}
-
-			m_GHost->m_DB->RecoverCallable(i->second);
-			delete i->second;
-			i = m_PairedDTopPlayersQueries.erase(i);
 		}
-		else
-			++i;
 	}
+	else
+	{
+		CGamePlayer* Player = GetPlayerFromName(user, true);
 
-	return CBaseGame :: Update( fd, send_fd );
+		if (Player)
+			SendChat(Player, "Could not retrieve DotA ladder top player list");
+	}
 }
 
 void CGame::EventPlayerJoined(CPotentialPlayer* potential, CIncomingJoinPlayer* joinPlayer)
@@ -539,13 +528,11 @@ void CGame::EventPlayerJoined(CPotentialPlayer* potential, CIncomingJoinPlayer*
 		string StatsUser = joinPlayer->GetName();
 		string GameState = string();
 		string m_ScoreMinGames = "1";
-		m_PairedDPSChecksNew.push_back(PairedDPSCheckNew(m_AutoDisplayStatsOnJoin? "%" : "%NULL", m_GHost->m_DB->ThreadedDotAPlayerSummaryCheckNew(string(), StatsUser, m_ScoreMinGames, GameState)));
+		m_Callables->Add( m_GHost->m_DB->ThreadedDotAPlayerSummaryCheckNew(string(), StatsUser, m_ScoreMinGames, GameState), boost::bind( &CGame :: EventCallableDotAPlayerSummaryCheckNew, this, m_AutoDisplayStatsOnJoin? "%" : "%NULL", _1 ) );
 	}
 
 	CBaseGame::EventPlayerJoined(potential, joinPlayer);
-
-	if (m_GHost->m_LiveDBCurrentGamesUpdateEnabled)
-		UpdateCurrentGameLiveDBInfo(0);
+	UpdateCurrentGameLiveDBInfo(0);
 }
 
 
@@ -699,9 +686,7 @@ void CGame::EventPlayerLeft(CGamePlayer* player, uint32_t reason)
 	}
 
 	CBaseGame::EventPlayerLeft(player, reason);
-
-	if (m_GHost->m_LiveDBCurrentGamesUpdateEnabled)
-		UpdateCurrentGameLiveDBInfo(0);
+	UpdateCurrentGameLiveDBInfo(0);
 }
 
 void CGame :: EventPlayerDeleted( CGamePlayer *player )
@@ -771,6 +756,17 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 	string Command = command;
 	string Payload = payload;
 
+	// look the command up before doing anything else so unknown commands don't cost us the admin checks below
+
+	const CCommand *BotCommand = m_GHost->m_GameCommands->Find( Command );
+
+	if( !BotCommand || !BotCommand->HasContext( m_GameLoading || m_GameLoaded ? COMMAND_CONTEXT_INGAME : COMMAND_CONTEXT_LOBBY ) )
+		return HideCommand;
+
+	if( !m_CommandLimiter->Allow( BotCommand, User, GetTicks( ) ) )
+		return HideCommand;
+
+	uint32_t CommandID = BotCommand->m_ID;
 	bool AdminCheck = false;
 
 	for( vector<CBNET *> :: iterator i = m_GHost->m_BNETs.begin( ); i != m_GHost->m_BNETs.end( ); ++i )
@@ -803,7 +799,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !AUTOBAN
 		//
 
-		if (Command == "autoban")
+		if (CommandID == CMD_AUTOBAN)
 		{
 			if (!Payload.empty())
 			{
@@ -835,7 +831,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !CHECK
 		//
 
-		else if (Command == "check")
+		else if (CommandID == CMD_CHECK)
 		{
 			string reply = string();
 			if (!Payload.empty())
@@ -885,17 +881,17 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !CHECKBAN
 		//
 
-		else if (Command == "checkban" && !Payload.empty() && !m_GHost->m_BNETs.empty())
+		else if (CommandID == CMD_CHECKBAN && !Payload.empty() && !m_GHost->m_BNETs.empty())
 		{
 			for (vector<CBNET*> ::iterator i = m_GHost->m_BNETs.begin(); i != m_GHost->m_BNETs.end(); ++i)
-				m_PairedBanChecks.push_back(PairedBanCheck(User, m_GHost->m_DB->ThreadedBanCheck((*i)->GetServer(), Payload, string())));
+				m_Callables->Add( m_GHost->m_DB->ThreadedBanCheck((*i)->GetServer(), Payload, string()), boost::bind( &CGame :: EventCallableBanCheck, this, User, _1 ) );
 		}
 
 		//
 		// !FROM
 		//
 
-		else if (Command == "from" || Command == "f")
+		else if (CommandID == CMD_FROM)
 		{
 			string Froms;
 
@@ -938,7 +934,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !OWNER (set game owner)
 		//
 
-		else if (Command == "owner")
+		else if (CommandID == CMD_OWNER)
 		{
 			//if m_AllowOwnageTakeOver then anyone can be owner as long as the current owner is not in the game
 			string newOwner = string();
@@ -1010,7 +1006,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !PING
 		//
 
-		else if (Command == "ping" || Command == "p")
+		else if (CommandID == CMD_PING)
 		{
 			// kick players with ping higher than payload if payload isn't empty
 			// we only do this if the game hasn't started since we don't want to kick players from a game in progress
@@ -1098,7 +1094,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 			// !BAN
 			//
 
-			if ((Command == "addban" || Command == "ban") && !Payload.empty() && !m_GHost->m_BNETs.empty())
+			if (CommandID == CMD_ADDBAN && !Payload.empty() && !m_GHost->m_BNETs.empty())
 			{
 				// extract the victim and the reason
 				// e.g. "Varlock leaver after dying" -> victim: "Varlock", reason: "leaver after dying"
@@ -1151,7 +1147,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 					if (Matches == 0)
 						SendAllChat(m_GHost->m_Language->UnableToBanNoMatchesFound(Victim));
 					else if (Matches == 1)
-						m_PairedBanAdds.push_back(PairedBanAdd(User, m_GHost->m_DB->ThreadedBanAdd(LastMatch->GetServer(), LastMatch->GetName(), LastMatch->GetIP(), m_GameName, User, Reason)));
+						m_Callables->Add( m_GHost->m_DB->ThreadedBanAdd(LastMatch->GetServer(), LastMatch->GetName(), LastMatch->GetIP(), m_GameName, User, Reason), boost::bind( &CGame :: EventCallableBanAdd, this, User, _1 ) );
 					else
 						SendAllChat(m_GHost->m_Language->UnableToBanFoundMoreThanOneMatch(Victim));
 				}
@@ -1163,7 +1159,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 					if (Matches == 0)
 						SendAllChat(m_GHost->m_Language->UnableToBanNoMatchesFound(Victim));
 					else if (Matches == 1)
-						m_PairedBanAdds.push_back(PairedBanAdd(User, m_GHost->m_DB->ThreadedBanAdd(LastMatch->GetJoinedRealm(), LastMatch->GetName(), LastMatch->GetExternalIPString(), m_GameName, User, Reason)));
+						m_Callables->Add( m_GHost->m_DB->ThreadedBanAdd(LastMatch->GetJoinedRealm(), LastMatch->GetName(), LastMatch->GetExternalIPString(), m_GameName, User, Reason), boost::bind( &CGame :: EventCallableBanAdd, this, User, _1 ) );
 					else
 						SendAllChat(m_GHost->m_Language->UnableToBanFoundMoreThanOneMatch(Victim));
 				}
@@ -1173,7 +1169,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 			// !ANNOUNCE
 			//
 
-			else if (Command == "announce" && !m_CountDownStarted)
+			else if (CommandID == CMD_ANNOUNCE && !m_CountDownStarted)
 			{
 				if (Payload.empty() || Payload == "off")
 				{
@@ -1216,14 +1212,14 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 			// !BANLAST
 			//
 
-			else if (Command == "banlast" && m_GameLoaded && !m_GHost->m_BNETs.empty() && m_DBBanLast)
-				m_PairedBanAdds.push_back(PairedBanAdd(User, m_GHost->m_DB->ThreadedBanAdd(m_DBBanLast->GetServer(), m_DBBanLast->GetName(), m_DBBanLast->GetIP(), m_GameName, User, Payload)));
+			else if (CommandID == CMD_BANLAST && m_GameLoaded && !m_GHost->m_BNETs.empty() && m_DBBanLast)
+				m_Callables->Add( m_GHost->m_DB->ThreadedBanAdd(m_DBBanLast->GetServer(), m_DBBanLast->GetName(), m_DBBanLast->GetIP(), m_GameName, User, Payload), boost::bind( &CGame :: EventCallableBanAdd, this, User, _1 ) );
 
 			//
 			// !GS
 			//
 
-			else if (Command == "gs")
+			else if (CommandID == CMD_GS)
 			{
 				if (!Payload.empty())
 				{
@@ -1241,7 +1237,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 			// !LOCKGAME
 			//
 
-			else if (Command == "lockgame")
+			else if (CommandID == CMD_LOCKGAME)
 			{
 				SendAllChat(m_GHost->m_Language->GameLocked());
 				m_Locked = true;
@@ -1251,7 +1247,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 			// !MUTE
 			//
 
-			else if (Command == "mute")
+			else if (CommandID == CMD_MUTE)
 			{
 				CGamePlayer* LastMatch = NULL;
 				uint32_t Matches = GetPlayerFromNamePartial(Payload, &LastMatch);
@@ -1271,10 +1267,10 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 			// !SAY
 			//
 
-			else if (Command == "say" && !Payload.empty())
+			else if (CommandID == CMD_SAY && !Payload.empty())
 			{
 				for (vector<CBNET*> ::iterator i = m_GHost->m_BNETs.begin(); i != m_GHost->m_BNETs.end(); ++i)
-					(*i)->QueueChatCommand(Payload);
+					(*i)->PostChatCommand(Payload, string(), false);
 
 				HideCommand = true;
 			}
@@ -1283,7 +1279,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 			// !TAKINGOVER
 			//
 
-			else if (Command == "takingover")
+			else if (CommandID == CMD_TAKINGOVER)
 			{
 				m_AutoUnhost = m_AllowOwnageTakeOver;
 				m_AllowOwnageTakeOver = !m_AllowOwnageTakeOver;
@@ -1297,7 +1293,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 			// !UNLOCKGAME
 			//
 
-			else if (Command == "unlockgame" && (RootAdminCheck || IsOwner(User)))
+			else if (CommandID == CMD_UNLOCKGAME && (RootAdminCheck || IsOwner(User)))
 			{
 				SendAllChat(m_GHost->m_Language->GameUnlocked());
 				m_Locked = false;
@@ -1307,7 +1303,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 			// !VIRTUALHOST
 			//
 
-			else if (Command == "virtualhost" && !Payload.empty() && Payload.size() <= 15 && !m_CountDownStarted)
+			else if (CommandID == CMD_VIRTUALHOST && !Payload.empty() && Payload.size() <= 15 && !m_CountDownStarted)
 			{
 				DeleteVirtualHost();
 				m_VirtualHostName = Payload;
@@ -1317,7 +1313,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 			// !W
 			//
 
-			else if (Command == "w" && !Payload.empty())
+			else if (CommandID == CMD_W && !Payload.empty())
 			{
 				// extract the name and the message
 				// e.g. "Varlock hello there!" -> name: "Varlock", message: "hello there!"
@@ -1332,7 +1328,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 					Message = Payload.substr(MessageStart + 1);
 
 					for (vector<CBNET*> ::iterator i = m_GHost->m_BNETs.begin(); i != m_GHost->m_BNETs.end(); ++i)
-						(*i)->QueueChatCommand(Message, Name, true);
+						(*i)->PostChatCommand(Message, Name, true);
 				}
 
 				HideCommand = true;
@@ -1349,6 +1345,11 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 			CONSOLE_Print( "[GAME: " + m_GameName + "] non-admin [" + User + "] sent command [" + Command + "] with payload [" + Payload + "]" );
 	}
 
+	// admin commands are only handled above
+
+	if( BotCommand->m_Access == COMMAND_ACCESS_ADMIN )
+		return HideCommand;
+
 
 	if (!m_Locked || (RootAdminCheck || AdminCheck || (IsOwner(User) && !m_IsLadderGame)))
 	{
@@ -1361,7 +1362,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !DROP
 		//
 
-		if (Command == "drop" && m_GameLoaded)
+		if (CommandID == CMD_DROP && m_GameLoaded)
 		{
 			if (!m_IsLadderGame || AdminCheck)
 				StopLaggers("lagged out (dropped by admin)");
@@ -1371,7 +1372,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !END
 		//
 
-		else if (Command == "end" && m_GameLoaded)
+		else if (CommandID == CMD_END && m_GameLoaded)
 		{
 			CONSOLE_Print("[GAME: " + m_GameName + "] is over (admin ended game)");
 			StopPlayers("was disconnected (admin ended game)");
@@ -1381,7 +1382,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !COMP (computer slot)
 		//
 
-		else if (Command == "comp" && !Payload.empty() && !m_GameLoading && !m_GameLoaded && !m_SaveGame)
+		else if (CommandID == CMD_COMP && !Payload.empty() && !m_SaveGame)
 		{
 			// extract the slot and the skill
 			// e.g. "1 2" -> slot: "1", skill: "2"
@@ -1410,7 +1411,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !COMPCOLOUR (computer colour change)
 		//
 
-		else if (Command == "compcolour" && !Payload.empty() && !m_GameLoading && !m_GameLoaded && !m_SaveGame)
+		else if (CommandID == CMD_COMPCOLOUR && !Payload.empty() && !m_SaveGame)
 		{
 			// extract the slot and the colour
 			// e.g. "1 2" -> slot: "1", colour: "2"
@@ -1451,7 +1452,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !COMPHANDICAP (computer handicap change)
 		//
 
-		else if (Command == "comphandicap" && !Payload.empty() && !m_GameLoading && !m_GameLoaded && !m_SaveGame)
+		else if (CommandID == CMD_COMPHANDICAP && !Payload.empty() && !m_SaveGame)
 		{
 			// extract the slot and the handicap
 			// e.g. "1 50" -> slot: "1", handicap: "50"
@@ -1495,7 +1496,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !COMPRACE (computer race change)
 		//
 
-		else if (Command == "comprace" && !Payload.empty() && !m_GameLoading && !m_GameLoaded && !m_SaveGame)
+		else if (CommandID == CMD_COMPRACE && !Payload.empty() && !m_SaveGame)
 		{
 			// extract the slot and the race
 			// e.g. "1 human" -> slot: "1", race: "human"
@@ -1564,7 +1565,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !COMPTEAM (computer team change)
 		//
 
-		else if (Command == "compteam" && !Payload.empty() && !m_GameLoading && !m_GameLoaded && !m_SaveGame)
+		else if (CommandID == CMD_COMPTEAM && !Payload.empty() && !m_SaveGame)
 		{
 			// extract the slot and the team
 			// e.g. "1 2" -> slot: "1", team: "2"
@@ -1608,7 +1609,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !FAKEPLAYER
 		//
 
-		else if (Command == "fakeplayer" && !m_CountDownStarted)
+		else if (CommandID == CMD_FAKEPLAYER && !m_CountDownStarted)
 		{
 			if (m_FakePlayerPID == 255)
 				CreateFakePlayer();
@@ -1620,31 +1621,27 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !FPPAUSE
 		//
 
-		else if (Command == "fppause" && m_FakePlayerPID != 255 && m_GameLoaded)
+		else if (CommandID == CMD_FPPAUSE && m_FakePlayerPID != 255 && m_GameLoaded)
 		{
-			BYTEARRAY CRC;
-			BYTEARRAY Action;
-			Action.push_back(1);
-			m_Actions.push(new CIncomingAction(m_FakePlayerPID, CRC, Action));
+			unsigned char Action = 1;
+			m_Actions.Add(m_FakePlayerPID, &Action, 1);
 		}
 
 		//
 		// !FPRESUME
 		//
 
-		else if (Command == "fpresume" && m_FakePlayerPID != 255 && m_GameLoaded)
+		else if (CommandID == CMD_FPRESUME && m_FakePlayerPID != 255 && m_GameLoaded)
 		{
-			BYTEARRAY CRC;
-			BYTEARRAY Action;
-			Action.push_back(2);
-			m_Actions.push(new CIncomingAction(m_FakePlayerPID, CRC, Action));
+			unsigned char Action = 2;
+			m_Actions.Add(m_FakePlayerPID, &Action, 1);
 		}
 
 		//
 		// !UNMUTE
 		//
 
-		else if (Command == "unmute")
+		else if (CommandID == CMD_UNMUTE)
 		{
 			CGamePlayer* LastMatch = NULL;
 			uint32_t Matches = GetPlayerFromNamePartial(Payload, &LastMatch);
@@ -1678,7 +1675,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 
 		// we use "!a" as an alias for abort because you don't have much time to abort the countdown so it's useful for the abort command to be easy to type
 
-		if ((Command == "abort" || Command == "a") && m_CountDownStarted && !m_GameLoading && !m_GameLoaded)
+		if (CommandID == CMD_ABORT && m_CountDownStarted)
 		{
 			SendAllChat(m_GHost->m_Language->CountDownAborted());
 			m_CountDownStarted = false;
@@ -1688,7 +1685,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !AUTODISPLAYSTATS
 		//
 
-		if (Command == "autodisplaystats")
+		if (CommandID == CMD_AUTODISPLAYSTATS)
 		{
 			m_AutoDisplayStatsOnJoin = !m_AutoDisplayStatsOnJoin;
 			if (m_AutoDisplayStatsOnJoin)
@@ -1701,7 +1698,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !AUTOSAVE
 		//
 
-		else if (Command == "autosave")
+		else if (CommandID == CMD_AUTOSAVE)
 		{
 			if (Payload == "on")
 			{
@@ -1719,7 +1716,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !AUTOSTART
 		//
 
-		else if (Command == "autostart" && !m_CountDownStarted)
+		else if (CommandID == CMD_AUTOSTART && !m_CountDownStarted)
 		{
 			if (Payload.empty() || Payload == "off")
 			{
@@ -1742,7 +1739,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !BALANCE
 		//
 
-		else if (Command == "balance")
+		else if (CommandID == CMD_BALANCE)
 		{
 			if (!m_GameLoaded && !m_GameLoading && !m_CountDownStarted)
 				BalanceSlotsNew();
@@ -1752,7 +1749,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !CLEARHCL
 		//
 
-		else if (Command == "clearhcl" && !m_CountDownStarted)
+		else if (CommandID == CMD_CLEARHCL && !m_CountDownStarted)
 		{
 			m_HCLCommandString.clear();
 			SendAllChat(m_GHost->m_Language->ClearingHCL());
@@ -1762,7 +1759,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !CLOSE (close slot)
 		//
 
-		else if (Command == "close" && !Payload.empty() && !m_GameLoading && !m_GameLoaded)
+		else if (CommandID == CMD_CLOSE && !Payload.empty())
 		{
 			// close as many slots as specified, e.g. "5 10" closes slots 5 and 10
 
@@ -1788,14 +1785,14 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !CLOSEALL
 		//
 
-		else if (Command == "closeall" && !m_GameLoading && !m_GameLoaded)
+		else if (CommandID == CMD_CLOSEALL)
 			CloseAllSlots();
 
 		//
 		// !DBSTATUS
 		//
 
-		else if (Command == "dbstatus")
+		else if (CommandID == CMD_DBSTATUS)
 			SendAllChat(m_GHost->m_DB->GetStatus());
 
 		//
@@ -1803,7 +1800,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !DL
 		//
 
-		else if ((Command == "download" || Command == "dl") && !Payload.empty() && !m_GameLoading && !m_GameLoaded)
+		else if (CommandID == CMD_DOWNLOAD && !Payload.empty())
 		{
 			CGamePlayer* LastMatch = NULL;
 			uint32_t Matches = GetPlayerFromNamePartial(Payload, &LastMatch);
@@ -1836,7 +1833,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !HCL
 		//
 
-		else if (Command == "hcl" && !m_CountDownStarted)
+		else if (CommandID == CMD_HCL && !m_CountDownStarted)
 		{
 			if (!Payload.empty())
 			{
@@ -1863,7 +1860,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !HOLD (hold a slot for someone)
 		//
 
-		else if (Command == "hold" && !Payload.empty() && !m_GameLoading && !m_GameLoaded)
+		else if (CommandID == CMD_HOLD && !Payload.empty())
 		{
 			// hold as many players as specified, e.g. "Varlock Kilranin" holds players "Varlock" and "Kilranin"
 
@@ -1892,7 +1889,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !KICK (kick a player)
 		//
 
-		else if (Command == "kick" && !Payload.empty())
+		else if (CommandID == CMD_KICK && !Payload.empty())
 		{
 			if ((!m_GameLoading && !m_GameLoaded) || AdminCheck || RootAdminCheck || !m_IsLadderGame)
 			{
@@ -1923,7 +1920,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !LATENCY (set game latency)
 		//
 
-		else if (Command == "latency")
+		else if (CommandID == CMD_LATENCY)
 		{
 			if (Payload.empty())
 				SendAllChat(m_GHost->m_Language->LatencyIs(UTIL_ToString(m_Latency)));
@@ -1952,7 +1949,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !MESSAGES
 		//
 
-		else if (Command == "messages")
+		else if (CommandID == CMD_MESSAGES)
 		{
 			if (Payload == "on")
 			{
@@ -1970,7 +1967,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !MUTEALL
 		//
 
-		else if (Command == "muteall" && m_GameLoaded)
+		else if (CommandID == CMD_MUTEALL && m_GameLoaded)
 		{
 			SendAllChat(m_GHost->m_Language->GlobalChatMuted());
 			m_MuteAll = true;
@@ -1980,7 +1977,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !OPEN (open slot)
 		//
 
-		else if (Command == "open" && !Payload.empty() && !m_GameLoading && !m_GameLoaded)
+		else if (CommandID == CMD_OPEN && !Payload.empty())
 		{
 			// open as many slots as specified, e.g. "5 10" opens slots 5 and 10
 
@@ -2006,14 +2003,14 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !OPENALL
 		//
 
-		else if (Command == "openall" && !m_GameLoading && !m_GameLoaded)
+		else if (CommandID == CMD_OPENALL)
 			OpenAllSlots();
 
 		//
 		// !PRIV (rehost as private game)
 		//
 
-		else if (Command == "priv" && !Payload.empty() && !m_CountDownStarted && !m_SaveGame)
+		else if (CommandID == CMD_PRIV && !Payload.empty() && !m_CountDownStarted && !m_SaveGame)
 		{
 			if (Payload.length() < 31)
 			{
@@ -2055,7 +2052,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !PUB (rehost as public game)
 		//
 
-		else if (Command == "pub" && !Payload.empty() && !m_CountDownStarted && !m_SaveGame)
+		else if (CommandID == CMD_PUB && !Payload.empty() && !m_CountDownStarted && !m_SaveGame)
 		{
 			if (Payload.length() < 31)
 			{
@@ -2092,7 +2089,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !REFRESH (turn on or off refresh messages)
 		//
 
-		else if (Command == "refresh" && !m_CountDownStarted)
+		else if (CommandID == CMD_REFRESH && !m_CountDownStarted)
 		{
 			if (Payload == "on")
 			{
@@ -2110,7 +2107,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !SENDLAN
 		//
 
-		else if (Command == "sendlan" && !Payload.empty() && !m_CountDownStarted)
+		else if (CommandID == CMD_SENDLAN && !Payload.empty() && !m_CountDownStarted)
 		{
 			// extract the ip and the port
 			// e.g. "1.2.3.4 6112" -> ip: "1.2.3.4", port: "6112"
@@ -2128,45 +2125,12 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 				CONSOLE_Print("[GAME: " + m_GameName + "] bad inputs to sendlan command");
 			else
 			{
-				// construct a fixed host counter which will be used to identify players from this "realm" (i.e. LAN)
-				// the fixed host counter's 4 most significant bits will contain a 4 bit ID (0-15)
-				// the rest of the fixed host counter will contain the 28 least significant bits of the actual host counter
-				// since we're destroying 4 bits of information here the actual host counter should not be greater than 2^28 which is a reasonable assumption
-				// when a player joins a game we can obtain the ID from the received host counter
-				// note: LAN broadcasts use an ID of 0, battle.net refreshes use an ID of 1-10, the rest are unused
-
-				uint32_t FixedHostCounter = m_HostCounter & 0x0FFFFFFF;
-
-				// we send MAX_SLOTS for SlotsTotal because this determines how many PID's Warcraft 3 allocates
-				// we need to make sure Warcraft 3 allocates at least SlotsTotal + 1 but at most MAX_SLOTS PID's
-				// this is because we need an extra PID for the virtual host player (but we always delete the virtual host player when the MAX_SLOTSth person joins)
-				// however, we can't send 13 for SlotsTotal because this causes Warcraft 3 to crash when sharing control of units
-				// nor can we send SlotsTotal because then Warcraft 3 crashes when playing maps with less than MAX_SLOTS PID's (because of the virtual host player taking an extra PID)
-				// we also send MAX_SLOTS for SlotsOpen because Warcraft 3 assumes there's always at least one player in the game (the host)
-				// so if we try to send accurate numbers it'll always be off by one and results in Warcraft 3 assuming the game is full when it still needs one more player
-				// the easiest solution is to simply send MAX_SLOTS for both so the game will always show up as (1/MAX_SLOTS) players
-
-				if (m_SaveGame)
-				{
-					// note: the PrivateGame flag is not set when broadcasting to LAN (as you might expect)
-
-					uint32_t MapGameType = MAPGAMETYPE_SAVEDGAME;
-					BYTEARRAY MapWidth;
-					MapWidth.push_back(0);
-					MapWidth.push_back(0);
-					BYTEARRAY MapHeight;
-					MapHeight.push_back(0);
-					MapHeight.push_back(0);
-					m_GHost->m_UDPSocket->SendTo(IP, Port, m_Protocol->SEND_W3GS_GAMEINFO(m_GHost->m_TFT, m_GHost->m_LANWar3Version, UTIL_CreateByteArray(MapGameType, false), m_Map->GetMapGameFlags(), MapWidth, MapHeight, m_GameName, "Varlock", GetTime() - m_CreationTime, "Save\\Multiplayer\\" + m_SaveGame->GetFileNameNoPath(), m_SaveGame->GetMagicNumber(), MAX_SLOTS, MAX_SLOTS, m_HostPort, FixedHostCounter, m_EntryKey));
-				}
-				else
-				{
-					// note: the PrivateGame flag is not set when broadcasting to LAN (as you might expect)
-					// note: we do not use m_Map->GetMapGameType because none of the filters are set when broadcasting to LAN (also as you might expect)
+				// the LAN game info packet is shared with the periodic LAN broadcast, see CBaseGame :: GetLANGameInfo
 
-					uint32_t MapGameType = MAPGAMETYPE_UNKNOWN0;
-					m_GHost->m_UDPSocket->SendTo(IP, Port, m_Protocol->SEND_W3GS_GAMEINFO(m_GHost->m_TFT, m_GHost->m_LANWar3Version, UTIL_CreateByteArray(MapGameType, false), m_Map->GetMapGameFlags(), m_Map->GetMapWidth(), m_Map->GetMapHeight(), m_GameName, "Varlock", GetTime() - m_CreationTime, m_Map->GetMapPath(), m_Map->GetMapCRC(), MAX_SLOTS, MAX_SLOTS, m_HostPort, FixedHostCounter, m_EntryKey));
-				}
+				BYTEARRAY GameInfo = GetLANGameInfo();
+
+				if (!GameInfo.empty())
+					m_GHost->m_UDPSocket->SendTo(IP, Port, GameInfo);
 			}
 		}
 
@@ -2174,7 +2138,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !SP
 		//
 
-		else if (Command == "sp" && !m_CountDownStarted)
+		else if (CommandID == CMD_SP && !m_CountDownStarted)
 		{
 			SendAllChat(m_GHost->m_Language->ShufflingPlayers());
 			ShuffleSlots();
@@ -2184,7 +2148,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !START
 		//
 
-		else if (Command == "start" && !m_CountDownStarted)
+		else if (CommandID == CMD_START && !m_CountDownStarted)
 		{
 			// if the player sent "!start force" skip the checks and start the countdown
 			// otherwise check that the game is ready to start
@@ -2209,7 +2173,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !SWAP (swap slots)
 		//
 
-		else if (Command == "swap" && !Payload.empty() && !m_GameLoading && !m_GameLoaded)
+		else if (CommandID == CMD_SWAP && !Payload.empty())
 		{
 			uint32_t SID1;
 			uint32_t SID2;
@@ -2239,7 +2203,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !SYNCLIMIT
 		//
 
-		else if (Command == "synclimit" || Command == "sync" || Command == "s")
+		else if (CommandID == CMD_SYNCLIMIT)
 		{
 			if (Payload.empty())
 				SendAllChat(m_GHost->m_Language->SyncLimitIs(UTIL_ToString(m_SyncLimit)));
@@ -2266,7 +2230,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !UNHOST
 		//
 
-		else if (Command == "unhost" && !m_CountDownStarted)
+		else if (CommandID == CMD_UNHOST && !m_CountDownStarted)
 		{
 			//if (GetCreatorName() == User || RootAdminCheck)
 			m_Exiting = true;
@@ -2277,7 +2241,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !UNMUTEALL
 		//
 
-		else if (Command == "unmuteall" && m_GameLoaded)
+		else if (CommandID == CMD_UNMUTEALL && m_GameLoaded)
 		{
 			SendAllChat(m_GHost->m_Language->GlobalChatUnmuted());
 			m_MuteAll = false;
@@ -2287,7 +2251,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		// !VOTECANCEL
 		//
 
-		else if (Command == "votecancel" && !m_KickVotePlayer.empty())
+		else if (CommandID == CMD_VOTECANCEL && !m_KickVotePlayer.empty())
 		{
 			SendAllChat(m_GHost->m_Language->VoteKickCancelled(m_KickVotePlayer));
 			m_KickVotePlayer.clear();
@@ -2295,12 +2259,14 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		}
 
 	}
-	else
+	else if( BotCommand->m_Access == COMMAND_ACCESS_OWNER )
 	{
 		CONSOLE_Print("[GAME: " + m_GameName + "] admin command ignored, the game is locked");
 		SendChat(player, m_GHost->m_Language->TheGameIsLocked());
 	}
 
+	if( BotCommand->m_Access != COMMAND_ACCESS_EVERYONE )
+		return HideCommand;
 
 	/*********************
 	* NON ADMIN COMMANDS *
@@ -2310,14 +2276,14 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 	// !CHECKME
 	//
 
-	if( Command == "checkme" )
+	if( CommandID == CMD_CHECKME )
 		SendChat( player, m_GHost->m_Language->CheckedPlayer( User, player->GetNumPings( ) > 0 ? UTIL_ToString( player->GetPing( m_GHost->m_LCPings ) ) + "ms" : "N/A", m_GHost->m_DBLocal->FromCheck( UTIL_ByteArrayToUInt32( player->GetExternalIP( ), true ) ), AdminCheck || RootAdminCheck ? "Yes" : "No", IsOwner( User ) ? "Yes" : "No", player->GetSpoofed( ) ? "Yes" : "No", player->GetSpoofedRealm( ).empty( ) ? "N/A" : player->GetSpoofedRealm( ), player->GetReserved( ) ? "Yes" : "No" ) );
 
 	//
 	// !GN
 	//
 
-	if (Command == "gn")
+	if (CommandID == CMD_GN)
 	{
 		SendChat( player, "Current game name is \"" + m_GameName + "\"" );
 		//return HideCommand;
@@ -2327,7 +2293,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 	// !R
 	//
 
-	else if (Command == "r")
+	else if (CommandID == CMD_R)
 	{
 
 		string RUser = User;
@@ -2390,7 +2356,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 	// !RALL
 	//
 
-	if (Command == "rall" || Command == "ratingall")
+	if (CommandID == CMD_RALL)
 	{
 
 		string reply = string();
@@ -2454,7 +2420,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 	// !RMK
 	//
 
-	if (Command == "rmk" && !player->GetRmkVote() && m_GameLoaded)
+	if (CommandID == CMD_RMK && !player->GetRmkVote() && m_GameLoaded)
 	{
 		if (m_AutoBanState || m_IsLadderGame)
 		{
@@ -2503,7 +2469,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 	// !RS
 	//
 
-	else if (Command == "rs" )
+	else if (CommandID == CMD_RS )
 	{
 		unsigned char TeamSizes[MAX_SLOTS];
 		uint32_t Team1RatingSum = 0, Team2RatingSum = 0;
@@ -2549,7 +2515,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 	// !STATS
 	//
 
-	else if( Command == "stats" && GetTime( ) - player->GetStatsSentTime( ) >= 5 )
+	else if( CommandID == CMD_STATS )
 	{
 		string StatsUser = User;
 
@@ -2557,18 +2523,16 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 			StatsUser = Payload;
 
 		if( player->GetSpoofed( ) && ( AdminCheck || RootAdminCheck || IsOwner( User ) ) )
-			m_PairedGPSChecks.push_back( PairedGPSCheck( string( ), m_GHost->m_DB->ThreadedGamePlayerSummaryCheck( StatsUser ) ) );
+			m_Callables->Add( m_GHost->m_DB->ThreadedGamePlayerSummaryCheck( StatsUser ), boost::bind( &CGame :: EventCallableGamePlayerSummaryCheck, this, string( ), _1 ) );
 		else
-			m_PairedGPSChecks.push_back( PairedGPSCheck( User, m_GHost->m_DB->ThreadedGamePlayerSummaryCheck( StatsUser ) ) );
-
-		player->SetStatsSentTime( GetTime( ) );
+			m_Callables->Add( m_GHost->m_DB->ThreadedGamePlayerSummaryCheck( StatsUser ), boost::bind( &CGame :: EventCallableGamePlayerSummaryCheck, this, User, _1 ) );
 	}
 
 	//
 	// !RESD (refreshed SD) 
 	//
 
-	if (Command == "resd" && GetTime() >= player->GetStatsDotASentTime() + 1)
+	if (CommandID == CMD_RESD)
 	{
 		string StatsUser = User;
 		string GameState = string();
@@ -2588,18 +2552,16 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 
 		string m_ScoreMinGames = "1";
 		if (!nonadmin)
-			m_PairedDPSChecksNew.push_back(PairedDPSCheckNew("%", m_GHost->m_DB->ThreadedDotAPlayerSummaryCheckNew(string(), StatsUser, m_ScoreMinGames, GameState)));
+			m_Callables->Add( m_GHost->m_DB->ThreadedDotAPlayerSummaryCheckNew(string(), StatsUser, m_ScoreMinGames, GameState), boost::bind( &CGame :: EventCallableDotAPlayerSummaryCheckNew, this, "%", _1 ) );
 		else
-			m_PairedDPSChecksNew.push_back(PairedDPSCheckNew("%" + User, m_GHost->m_DB->ThreadedDotAPlayerSummaryCheckNew(string(), StatsUser, m_ScoreMinGames, GameState)));
-
-		player->SetStatsDotASentTime(GetTime());
+			m_Callables->Add( m_GHost->m_DB->ThreadedDotAPlayerSummaryCheckNew(string(), StatsUser, m_ScoreMinGames, GameState), boost::bind( &CGame :: EventCallableDotAPlayerSummaryCheckNew, this, "%" + User, _1 ) );
 	}
 
 	//
 	// !SD (New)
 	//
 
-	if (Command == "sd" && GetTime() >= player->GetStatsDotASentTime() + 1)
+	if (CommandID == CMD_SD)
 	{
 		string StatsUser = User;
 
@@ -2653,7 +2615,6 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 				}
 			}		
 		}
-		player->SetStatsDotASentTime(GetTime());
 	}
 
 	//
@@ -2661,7 +2622,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 	// !SDOLD
 	//
 
-	else if( (Command == "statsdota" || Command == "sdold") && GetTime( ) - player->GetStatsDotASentTime( ) >= 3 )
+	else if( CommandID == CMD_STATSDOTA )
 	{
 		string StatsUser = User;
 
@@ -2669,18 +2630,16 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 			StatsUser = Payload;
 
 		if( player->GetSpoofed( ) && ( AdminCheck || RootAdminCheck || IsOwner( User ) ) )
-			m_PairedDPSChecks.push_back( PairedDPSCheck( string( ), m_GHost->m_DB->ThreadedDotAPlayerSummaryCheck( StatsUser ) ) );
+			m_Callables->Add( m_GHost->m_DB->ThreadedDotAPlayerSummaryCheck( StatsUser ), boost::bind( &CGame :: EventCallableDotAPlayerSummaryCheck, this, string( ), _1 ) );
 		else
-			m_PairedDPSChecks.push_back( PairedDPSCheck( User, m_GHost->m_DB->ThreadedDotAPlayerSummaryCheck( StatsUser ) ) );
-
-		player->SetStatsDotASentTime( GetTime( ) );
+			m_Callables->Add( m_GHost->m_DB->ThreadedDotAPlayerSummaryCheck( StatsUser ), boost::bind( &CGame :: EventCallableDotAPlayerSummaryCheck, this, User, _1 ) );
 	}
 
 	//
 	// !top / !topd
 	//
 
-	else if ((Command == "top" || Command == "topd") && GetTime() >= player->GetStatsDotASentTime() + 1)
+	else if (CommandID == CMD_TOP)
 	{
 		uint32_t TopOffset = 0;
 		uint32_t TopCount = 10;	
@@ -2697,16 +2656,16 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 
 		bool nonadmin = !((player->GetSpoofed() && AdminCheck) || RootAdminCheck || IsOwner(User));
 		if (nonadmin)
-			m_PairedDTopPlayersQueries.push_back(PairedDTopPlayersQuery(User, m_GHost->m_DB->ThreadedDotATopPlayersQuery(string(), string("1"), TopOffset, TopCount)));
+			m_Callables->Add( m_GHost->m_DB->ThreadedDotATopPlayersQuery(string(), string("1"), TopOffset, TopCount), boost::bind( &CGame :: EventCallableDotATopPlayersQuery, this, User, _1 ) );
 		else
-			m_PairedDTopPlayersQueries.push_back(PairedDTopPlayersQuery(string(), m_GHost->m_DB->ThreadedDotATopPlayersQuery(string(), string("1"), TopOffset, TopCount)));
+			m_Callables->Add( m_GHost->m_DB->ThreadedDotATopPlayersQuery(string(), string("1"), TopOffset, TopCount), boost::bind( &CGame :: EventCallableDotATopPlayersQuery, this, string(), _1 ) );
 	}
 
 	//
 	// !VERSION
 	//
 
-	else if( Command == "version" )
+	else if( CommandID == CMD_VERSION )
 	{
 		if( player->GetSpoofed( ) && ( AdminCheck || RootAdminCheck || IsOwner( User ) ) )
 			SendChat( player, m_GHost->m_Language->VersionAdmin( m_GHost->m_Version ) );
@@ -2718,7 +2677,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 	// !VOTEKICK
 	//
 
-	else if( Command == "votekick" && m_GHost->m_VoteKickAllowed && !Payload.empty( ) )
+	else if( CommandID == CMD_VOTEKICK && m_GHost->m_VoteKickAllowed && !Payload.empty( ) )
 	{
 		if( !m_KickVotePlayer.empty( ) )
 			SendChat( player, m_GHost->m_Language->UnableToVoteKickAlreadyInProgress( ) );
@@ -2758,7 +2717,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 	// !YES
 	//
 
-	else if( Command == "yes" && !m_KickVotePlayer.empty( ) && player->GetName( ) != m_KickVotePlayer && !player->GetKickVote( ) )
+	else if( CommandID == CMD_YES && !m_KickVotePlayer.empty( ) && player->GetName( ) != m_KickVotePlayer && !player->GetKickVote( ) )
 	{
 		player->SetKickVote( true );
 		uint32_t VotesNeeded = (uint32_t)ceil( ( GetNumHumanPlayers( ) - 1 ) * (float)m_GHost->m_VoteKickPercentage / 100 );
@@ -2843,6 +2802,13 @@ void CGame :: EventGameStarted( )
 		}
 	}
 
+	UpdateCurrentGameLiveDBInfo(0);
+}
+
+void CGame :: EventGameLoaded( )
+{
+	CBaseGame :: EventGameLoaded( );
+	UpdateCurrentGameLiveDBInfo(0);
 }
 
 bool CGame :: IsGameDataSaved( )
@@ -2907,48 +2873,28 @@ void CBaseGame :: ReCalculateTeams()
 
 void CGame :: UpdateCurrentGameLiveDBInfo( unsigned char action )
 {
-	CONSOLE_Print("[GAME: " + m_GameName + "] TEMP DEBUG MSG: UpdateCurrentGameLiveDBInfo(" + UTIL_ToString(action) + ")");
+	// this only updates the bot's snapshot, the main thread publishes whatever changed in one batch (see CCurrentGames)
 
-	if (action != 1)
+	if( action == 1 )
 	{
-		string Exp = string();
-		string Create = string();
-		string Start = string();
-		time_t t;
-		char cstr[128];
-
-		m_LastCurrentGameLiveUpdateTime = GetTime();
-
-		t = time(nullptr) + 31 * 60;
-		if (t >= 0)
-		{
-			strftime(cstr, sizeof(cstr), "%Y-%m-%d %H:%M:%S", std::gmtime(&t)); //negative value of t will crash the program
-			Exp = cstr;
-		}
-		else
-			Exp = string();
-		
-		t = time(nullptr) - (GetTime(0) - m_CreationTime);
-		if (t >= 0)
-		{
-			strftime(cstr, sizeof(cstr), "%Y-%m-%d %H:%M:%S", std::gmtime(&t));
-			Create = cstr;
-		}
-		else
-			Create = string();
-
-		t = time(nullptr) - (GetTime(0) - m_GameLoadedTime);
-		if (t >= 0)
-		{
-			strftime(cstr, sizeof(cstr), "%Y-%m-%d %H:%M:%S", std::gmtime(&t));
-			Start = cstr;
-		}
-		else
-			Start = string();
-
-		m_CurrentGameInfoUpdate.push_back(m_GHost->m_DB->ThreadedCurrentGameUpdate(m_GHost->m_BotID, action, string(), m_CreatorName, m_OwnerName, m_GameName, GetAllPlayersNames(), m_MapFileName, Create, Start, Exp, m_GameLoading || m_GameLoaded, m_RandomSeed, false, GetPIDs().size(), m_MapNumPlayers));
+		m_GHost->m_LiveGames->Remove( m_RandomSeed );
+		return;
 	}
-	else
-		m_GHost->m_Callables.push_back(m_GHost->m_DB->ThreadedCurrentGameUpdate(m_GHost->m_BotID, action, string(), string(), string(), string(), string(), string(), string(), string(), string(), true, m_RandomSeed, false, 0, 0));
 
+	m_LastCurrentGameLiveUpdateTime = GetTime( );
+
+	CDBCurrentGame Game;
+	Game.m_BotID = m_GHost->m_BotID;
+	Game.m_CreatorName = m_CreatorName;
+	Game.m_OwnerName = m_OwnerName;
+	Game.m_GameName = m_GameName;
+	Game.m_Names = GetAllPlayersNames( );
+	Game.m_MapName = m_MapFileName;
+	Game.m_CreatedAt = time( NULL ) - ( GetTime( ) - m_CreationTime );
+	Game.m_StartedAt = m_GameLoadedTime != 0 ? time( NULL ) - ( GetTime( ) - m_GameLoadedTime ) : 0;
+	Game.m_GameStarted = m_GameLoading || m_GameLoaded;
+	Game.m_GameRandomID = m_RandomSeed;
+	Game.m_OccupiedSlots = GetPIDs( ).size( );
+	Game.m_MaxSlots = m_MapNumPlayers;
+	m_GHost->m_LiveGames->Update( Game );
 }
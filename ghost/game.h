@@ -36,17 +36,87 @@ class CCallableGamePlayerSummaryCheck;
 class CCallableDotAPlayerSummaryCheck;
 class CCallableDotAPlayerSummaryCheckNew;	//New
 class CCallableDotATopPlayersQuery;			//New
-class CCallableCurrentGameUpdate;			//New
 
-typedef pair<string,CCallableBanCheck *> PairedBanCheck;
-typedef pair<string,CCallableBanAdd *> PairedBanAdd;
-typedef pair<string,CCallableGamePlayerSummaryCheck *> PairedGPSCheck;
-typedef pair<string,CCallableDotAPlayerSummaryCheck *> PairedDPSCheck;
-typedef pair<string, CCallableDotAPlayerSummaryCheckNew*> PairedDPSCheckNew;	//New
-typedef pair<string, CCallableDotATopPlayersQuery*> PairedDTopPlayersQuery;		//New
+class CCommandTable;
 
 class CGame : public CBaseGame
 {
+public:
+	enum Commands
+	{
+		CMD_AUTOBAN = 0,
+		CMD_CHECK,
+		CMD_CHECKBAN,
+		CMD_FROM,
+		CMD_OWNER,
+		CMD_PING,
+		CMD_ADDBAN,
+		CMD_ANNOUNCE,
+		CMD_BANLAST,
+		CMD_GS,
+		CMD_LOCKGAME,
+		CMD_MUTE,
+		CMD_SAY,
+		CMD_TAKINGOVER,
+		CMD_UNLOCKGAME,
+		CMD_VIRTUALHOST,
+		CMD_W,
+		CMD_DROP,
+		CMD_END,
+		CMD_COMP,
+		CMD_COMPCOLOUR,
+		CMD_COMPHANDICAP,
+		CMD_COMPRACE,
+		CMD_COMPTEAM,
+		CMD_FAKEPLAYER,
+		CMD_FPPAUSE,
+		CMD_FPRESUME,
+		CMD_UNMUTE,
+		CMD_ABORT,
+		CMD_AUTODISPLAYSTATS,
+		CMD_AUTOSAVE,
+		CMD_AUTOSTART,
+		CMD_BALANCE,
+		CMD_CLEARHCL,
+		CMD_CLOSE,
+		CMD_CLOSEALL,
+		CMD_DBSTATUS,
+		CMD_DOWNLOAD,
+		CMD_HCL,
+		CMD_HOLD,
+		CMD_KICK,
+		CMD_LATENCY,
+		CMD_MESSAGES,
+		CMD_MUTEALL,
+		CMD_OPEN,
+		CMD_OPENALL,
+		CMD_PRIV,
+		CMD_PUB,
+		CMD_REFRESH,
+		CMD_SENDLAN,
+		CMD_SP,
+		CMD_START,
+		CMD_SWAP,
+		CMD_SYNCLIMIT,
+		CMD_UNHOST,
+		CMD_UNMUTEALL,
+		CMD_VOTECANCEL,
+		CMD_CHECKME,
+		CMD_GN,
+		CMD_R,
+		CMD_RALL,
+		CMD_RMK,
+		CMD_RS,
+		CMD_STATS,
+		CMD_RESD,
+		CMD_SD,
+		CMD_STATSDOTA,
+		CMD_TOP,
+		CMD_VERSION,
+		CMD_VOTEKICK,
+		CMD_YES
+	};
+
 protected:
 	CDBBan *m_DBBanLast;						// last ban for the !banlast command - this is a pointer to one of the items in m_DBBans
 	vector<CDBBan *> m_DBBans;					// vector of potential ban data for the database (see the Update function for more info, it's not as straightforward as you might think)
@@ -54,25 +124,27 @@ protected:
 	vector<CDBGamePlayer *> m_DBGamePlayers;	// vector of potential gameplayer data for the database
 	CStats *m_Stats;							// class to keep track of game stats such as kills/deaths/assists in dota
 	CCallableGameAdd *m_CallableGameAdd;		// threaded database game addition in progress
-	vector<PairedBanCheck> m_PairedBanChecks;	// vector of paired threaded database ban checks in progress
-	vector<PairedBanAdd> m_PairedBanAdds;		// vector of paired threaded database ban adds in progress
-	vector<PairedGPSCheck> m_PairedGPSChecks;	// vector of paired threaded database game player summary checks in progress
-	vector<PairedDPSCheck> m_PairedDPSChecks;	// vector of paired threaded database DotA player summary checks in progress
-	vector<PairedDPSCheckNew> m_PairedDPSChecksNew;				// New
-	vector<PairedDTopPlayersQuery> m_PairedDTopPlayersQueries;	// New
-	vector<CCallableCurrentGameUpdate*> m_CurrentGameInfoUpdate;// New
 
 public:
 	CGame( CGHost *nGHost, CMap *nMap, CSaveGame *nSaveGame, uint16_t nHostPort, unsigned char nGameState, string nGameName, string nOwnerName, string nCreatorName, string nCreatorServer );
 	virtual ~CGame( );
 
-	virtual bool Update( void *fd, void *send_fd );
+	static void RegisterCommands( CCommandTable *commands );
+
+
 	virtual void EventPlayerDeleted( CGamePlayer *player );
 	virtual void EventPlayerJoined(CPotentialPlayer* potential, CIncomingJoinPlayer* joinPlayer);
 	virtual void EventPlayerLeft(CGamePlayer* player, uint32_t reason);
 	virtual bool EventPlayerAction( CGamePlayer *player, CIncomingAction *action );
 	virtual bool EventPlayerBotCommand( CGamePlayer *player, string command, string payload );
 	virtual void EventGameStarted( );
+	virtual void EventGameLoaded( );
+	virtual void EventCallableBanCheck( string user, CCallableBanCheck *callable );
+	virtual void EventCallableBanAdd( string user, CCallableBanAdd *callable );
+	virtual void EventCallableGamePlayerSummaryCheck( string user, CCallableGamePlayerSummaryCheck *callable );
+	virtual void EventCallableDotAPlayerSummaryCheck( string user, CCallableDotAPlayerSummaryCheck *callable );
+	virtual void EventCallableDotAPlayerSummaryCheckNew( string user, CCallableDotAPlayerSummaryCheckNew *callable );
+	virtual void EventCallableDotATopPlayersQuery( string user, CCallableDotATopPlayersQuery *callable );
 	virtual bool IsGameDataSaved( );
 	virtual void SaveGameData( );
 	virtual void UpdateCurrentGameLiveDBInfo( unsigned char action = 0 ); //action: 0=add/update(replace) 1=delete
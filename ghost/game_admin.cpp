@@ -24,6 +24,7 @@
 #include "language.h"
 #include "socket.h"
 #include "ghostdb.h"
+#include "commandtable.h"
 #include "bnet.h"
 #include "map.h"
 #include "packed.h"
@@ -54,219 +55,153 @@ CAdminGame :: CAdminGame( CGHost *nGHost, CMap *nMap, CSaveGame *nSaveGame, uint
 
 CAdminGame :: ~CAdminGame( )
 {
-	for( vector<PairedAdminCount> :: iterator i = m_PairedAdminCounts.begin( ); i != m_PairedAdminCounts.end( ); ++i )
-		m_GHost->m_Callables.push_back( i->second );
 
-	for( vector<PairedAdminAdd> :: iterator i = m_PairedAdminAdds.begin( ); i != m_PairedAdminAdds.end( ); ++i )
-		m_GHost->m_Callables.push_back( i->second );
-
-	for( vector<PairedAdminRemove> :: iterator i = m_PairedAdminRemoves.begin( ); i != m_PairedAdminRemoves.end( ); ++i )
-		m_GHost->m_Callables.push_back( i->second );
-
-	for( vector<PairedBanCount> :: iterator i = m_PairedBanCounts.begin( ); i != m_PairedBanCounts.end( ); ++i )
-		m_GHost->m_Callables.push_back( i->second );
-
-	/*
-
-	for( vector<PairedBanAdd> :: iterator i = m_PairedBanAdds.begin( ); i != m_PairedBanAdds.end( ); ++i )
-		m_GHost->m_Callables.push_back( i->second );
+}
 
-	*/
+// the commands an admin can use in the admin game, see EventPlayerBotCommand
 
-	for( vector<PairedBanRemove> :: iterator i = m_PairedBanRemoves.begin( ); i != m_PairedBanRemoves.end( ); ++i )
-		m_GHost->m_Callables.push_back( i->second );
+void CAdminGame :: RegisterCommands( CCommandTable *commands )
+{
+	commands->Add( CMD_ADDADMIN, "addadmin", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_AUTOHOST, "autohost", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_AUTOHOSTMM, "autohostmm", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_CHECKADMIN, "checkadmin", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_CHECKBAN, "checkban", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_COUNTADMINS, "countadmins", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_COUNTBANS, "countbans", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_DELADMIN, "deladmin", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_DELBAN, "delban", "unban", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_DISABLE, "disable", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_DOWNLOADS, "downloads", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_ENABLE, "enable", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_END, "end", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_ENFORCESG, "enforcesg", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_EXIT, "exit", "quit", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_GETGAME, "getgame", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_GETGAMES, "getgames", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_HOSTSG, "hostsg", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_LOAD, "load", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_LOADSG, "loadsg", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_MAP, "map", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_PRIV, "priv", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_PRIVBY, "privby", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_PUB, "pub", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_PUBBY, "pubby", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_RELOAD, "reload", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_SAY, "say", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_SAYGAME, "saygame", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_SAYGAMES, "saygames", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_UNHOST, "unhost", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_W, "w", "", COMMAND_ACCESS_ADMIN, COMMAND_CONTEXT_GAME );
+	commands->Add( CMD_PASSWORD, "password", "", COMMAND_ACCESS_EVERYONE, COMMAND_CONTEXT_GAME );
 }
 
 bool CAdminGame :: Update( void *fd, void *send_fd )
 {
-	//
-	// update callables
-	//
+	// reset the last reserved seen timer since the admin game should never be considered abandoned
 
-	for( vector<PairedAdminCount> :: iterator i = m_PairedAdminCounts.begin( ); i != m_PairedAdminCounts.end( ); )
-	{
-		if( i->second->GetReady( ) )
-		{
-			CGamePlayer *Player = GetPlayerFromName( i->first, true );
+	m_LastReservedSeen = GetTime( );
+	return CBaseGame :: Update( fd, send_fd );
+}
 
-			if( Player )
-			{
-				uint32_t Count = i->second->GetResult( );
+void CAdminGame :: EventCallableAdminCount( string user, CCallableAdminCount *callable )
+{
+	CGamePlayer *Player = GetPlayerFromName( user, true );
 
-				if( Count == 0 )
-					SendChat( Player, m_GHost->m_Language->ThereAreNoAdmins( i->second->GetServer( ) ) );
-				else if( Count == 1 )
-					SendChat( Player, m_GHost->m_Language->ThereIsAdmin( i->second->GetServer( ) ) );
-				else
-					SendChat( Player, m_GHost->m_Language->ThereAreAdmins( i->second->GetServer( ), UTIL_ToString( Count ) ) );
-			}
+	if( Player )
+	{
+		uint32_t Count = callable->GetResult( );
 
-			m_GHost->m_DB->RecoverCallable( i->second );
-			delete i->second;
-			i = m_PairedAdminCounts.erase( i );
-		}
+		if( Count == 0 )
+			SendChat( Player, m_GHost->m_Language->ThereAreNoAdmins( callable->GetServer( ) ) );
+		else if( Count == 1 )
+			SendChat( Player, m_GHost->m_Language->ThereIsAdmin( callable->GetServer( ) ) );
 		else
-			++i;
+			SendChat( Player, m_GHost->m_Language->ThereAreAdmins( callable->GetServer( ), UTIL_ToString( Count ) ) );
 	}
+}
 
-	for( vector<PairedAdminAdd> :: iterator i = m_PairedAdminAdds.begin( ); i != m_PairedAdminAdds.end( ); )
+void CAdminGame :: EventCallableAdminAdd( string user, CCallableAdminAdd *callable )
+{
+	if( callable->GetResult( ) )
 	{
-		if( i->second->GetReady( ) )
+		for( vector<CBNET *> :: iterator j = m_GHost->m_BNETs.begin( ); j != m_GHost->m_BNETs.end( ); ++j )
 		{
-			if( i->second->GetResult( ) )
-			{
-				for( vector<CBNET *> :: iterator j = m_GHost->m_BNETs.begin( ); j != m_GHost->m_BNETs.end( ); ++j )
-				{
-					if( (*j)->GetServer( ) == i->second->GetServer( ) )
-						(*j)->AddAdmin( i->second->GetUser( ) );
-				}
-			}
-
-			CGamePlayer *Player = GetPlayerFromName( i->first, true );
-
-			if( Player )
-			{
-				if( i->second->GetResult( ) )
-					SendChat( Player, m_GHost->m_Language->AddedUserToAdminDatabase( i->second->GetServer( ), i->second->GetUser( ) ) );
-				else
-					SendChat( Player, m_GHost->m_Language->ErrorAddingUserToAdminDatabase( i->second->GetServer( ), i->second->GetUser( ) ) );
-			}
-
-			m_GHost->m_DB->RecoverCallable( i->second );
-			delete i->second;
-			i = m_PairedAdminAdds.erase( i );
+			if( (*j)->GetServer( ) == callable->GetServer( ) )
+				(*j)->AddAdmin( callable->GetUser( ) );
 		}
-		else
-			++i;
 	}
 
-	for( vector<PairedAdminRemove> :: iterator i = m_PairedAdminRemoves.begin( ); i != m_PairedAdminRemoves.end( ); )
-	{
-		if( i->second->GetReady( ) )
-		{
-			if( i->second->GetResult( ) )
-			{
-				for( vector<CBNET *> :: iterator j = m_GHost->m_BNETs.begin( ); j != m_GHost->m_BNETs.end( ); ++j )
-				{
-					if( (*j)->GetServer( ) == i->second->GetServer( ) )
-						(*j)->RemoveAdmin( i->second->GetUser( ) );
-				}
-			}
-
-			CGamePlayer *Player = GetPlayerFromName( i->first, true );
-
-			if( Player )
-			{
-				if( i->second->GetResult( ) )
-					SendChat( Player, m_GHost->m_Language->DeletedUserFromAdminDatabase( i->second->GetServer( ), i->second->GetUser( ) ) );
-				else
-					SendChat( Player, m_GHost->m_Language->ErrorDeletingUserFromAdminDatabase( i->second->GetServer( ), i->second->GetUser( ) ) );
-			}
+	CGamePlayer *Player = GetPlayerFromName( user, true );
 
-			m_GHost->m_DB->RecoverCallable( i->second );
-			delete i->second;
-			i = m_PairedAdminRemoves.erase( i );
-		}
+	if( Player )
+	{
+		if( callable->GetResult( ) )
+			SendChat( Player, m_GHost->m_Language->AddedUserToAdminDatabase( callable->GetServer( ), callable->GetUser( ) ) );
 		else
-			++i;
+			SendChat( Player, m_GHost->m_Language->ErrorAddingUserToAdminDatabase( callable->GetServer( ), callable->GetUser( ) ) );
 	}
+}
 
-	for( vector<PairedBanCount> :: iterator i = m_PairedBanCounts.begin( ); i != m_PairedBanCounts.end( ); )
+void CAdminGame :: EventCallableAdminRemove( string user, CCallableAdminRemove *callable )
+{
+	if( callable->GetResult( ) )
 	{
-		if( i->second->GetReady( ) )
+		for( vector<CBNET *> :: iterator j = m_GHost->m_BNETs.begin( ); j != m_GHost->m_BNETs.end( ); ++j )
 		{
-			CGamePlayer *Player = GetPlayerFromName( i->first, true );
-
-			if( Player )
-			{
-				uint32_t Count = i->second->GetResult( );
-
-				if( Count == 0 )
-					SendChat( Player, m_GHost->m_Language->ThereAreNoBannedUsers( i->second->GetServer( ) ) );
-				else if( Count == 1 )
-					SendChat( Player, m_GHost->m_Language->ThereIsBannedUser( i->second->GetServer( ) ) );
-				else
-					SendChat( Player, m_GHost->m_Language->ThereAreBannedUsers( i->second->GetServer( ), UTIL_ToString( Count ) ) );
-			}
-
-			m_GHost->m_DB->RecoverCallable( i->second );
-			delete i->second;
-			i = m_PairedBanCounts.erase( i );
+			if( (*j)->GetServer( ) == callable->GetServer( ) )
+				(*j)->RemoveAdmin( callable->GetUser( ) );
 		}
-		else
-			++i;
 	}
 
-	/*
+	CGamePlayer *Player = GetPlayerFromName( user, true );
 
-	for( vector<PairedBanAdd> :: iterator i = m_PairedBanAdds.begin( ); i != m_PairedBanAdds.end( ); )
+	if( Player )
 	{
-		if( i->second->GetReady( ) )
-		{
-			if( i->second->GetResult( ) )
-			{
-				for( vector<CBNET *> :: iterator j = m_GHost->m_BNETs.begin( ); j != m_GHost->m_BNETs.end( ); ++j )
-				{
-					if( (*j)->GetServer( ) == i->second->GetServer( ) )
-						(*j)->AddBan( i->second->GetUser( ), i->second->GetIP( ), i->second->GetGameName( ), i->second->GetAdmin( ), i->second->GetReason( ) );
-				}
-			}
+		if( callable->GetResult( ) )
+			SendChat( Player, m_GHost->m_Language->DeletedUserFromAdminDatabase( callable->GetServer( ), callable->GetUser( ) ) );
+		else
+			SendChat( Player, m_GHost->m_Language->ErrorDeletingUserFromAdminDatabase( callable->GetServer( ), callable->GetUser( ) ) );
+	}
+}
 
-			CGamePlayer *Player = GetPlayerFromName( i->first, true );
+void CAdminGame :: EventCallableBanCount( string user, CCallableBanCount *callable )
+{
+	CGamePlayer *Player = GetPlayerFromName( user, true );
 
-			if( Player )
-			{
-				if( i->second->GetResult( ) )
-					SendChat( Player, m_GHost->m_Language->BannedUser( i->second->GetServer( ), i->second->GetUser( ) ) );
-				else
-					SendChat( Player, m_GHost->m_Language->ErrorBanningUser( i->second->GetServer( ), i->second->GetUser( ) ) );
-			}
+	if( Player )
+	{
+		uint32_t Count = callable->GetResult( );
 
-			m_GHost->m_DB->RecoverCallable( i->second );
-			delete i->second;
-			i = m_PairedBanAdds.erase( i );
-		}
+		if( Count == 0 )
+			SendChat( Player, m_GHost->m_Language->ThereAreNoBannedUsers( callable->GetServer( ) ) );
+		else if( Count == 1 )
+			SendChat( Player, m_GHost->m_Language->ThereIsBannedUser( callable->GetServer( ) ) );
 		else
-			++i;
+			SendChat( Player, m_GHost->m_Language->ThereAreBannedUsers( callable->GetServer( ), UTIL_ToString( Count ) ) );
 	}
+}
 
-	*/
-
-	for( vector<PairedBanRemove> :: iterator i = m_PairedBanRemoves.begin( ); i != m_PairedBanRemoves.end( ); )
+void CAdminGame :: EventCallableBanRemove( string user, CCallableBanRemove *callable )
+{
+	if( callable->GetResult( ) )
 	{
-		if( i->second->GetReady( ) )
+		for( vector<CBNET *> :: iterator j = m_GHost->m_BNETs.begin( ); j != m_GHost->m_BNETs.end( ); ++j )
 		{
-			if( i->second->GetResult( ) )
-			{
-				for( vector<CBNET *> :: iterator j = m_GHost->m_BNETs.begin( ); j != m_GHost->m_BNETs.end( ); ++j )
-				{
-					if( (*j)->GetServer( ) == i->second->GetServer( ) )
-						(*j)->RemoveBan( i->second->GetUser( ) );
-				}
-			}
-
-			CGamePlayer *Player = GetPlayerFromName( i->first, true );
-
-			if( Player )
-			{
-				if( i->second->GetResult( ) )
-					SendChat( Player, m_GHost->m_Language->UnbannedUser( i->second->GetUser( ) ) );
-				else
-					SendChat( Player, m_GHost->m_Language->ErrorUnbanningUser( i->second->GetUser( ) ) );
-			}
-
-			m_GHost->m_DB->RecoverCallable( i->second );
-			delete i->second;
-			i = m_PairedBanRemoves.erase( i );
+			if( (*j)->GetServer( ) == callable->GetServer( ) )
+				(*j)->RemoveBan( callable->GetUser( ) );
 		}
-		else
-			++i;
 	}
 
-	// reset the last reserved seen timer since the admin game should never be considered abandoned
+	CGamePlayer *Player = GetPlayerFromName( user, true );
 
-	m_LastReservedSeen = GetTime( );
-	return CBaseGame :: Update( fd, send_fd );
+	if( Player )
+	{
+		if( callable->GetResult( ) )
+			SendChat( Player, m_GHost->m_Language->UnbannedUser( callable->GetUser( ) ) );
+		else
+			SendChat( Player, m_GHost->m_Language->ErrorUnbanningUser( callable->GetUser( ) ) );
+	}
 }
 
 void CAdminGame :: SendAdminChat( string message )
@@ -329,6 +264,13 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 	string Command = command;
 	string Payload = payload;
 
+	const CCommand *BotCommand = m_GHost->m_AdminGameCommands->Find( Command );
+
+	if( !BotCommand )
+		return true;
+
+	uint32_t CommandID = BotCommand->m_ID;
+
 	if( player->GetLoggedIn( ) )
 	{
 		CONSOLE_Print( "[ADMINGAME] admin [" + User + "] sent command [" + Command + "] with payload [" + Payload + "]" );
@@ -341,7 +283,7 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 		// !ADDADMIN
 		//
 
-		if( Command == "addadmin" && !Payload.empty( ) )
+		if( CommandID == CMD_ADDADMIN && !Payload.empty( ) )
 		{
 			// extract the name and the server
 			// e.g. "Varlock useast.battle.net" -> name: "Varlock", server: "useast.battle.net"
@@ -381,7 +323,7 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 						if( (*i)->IsAdmin( Name ) )
 							SendChat( player, m_GHost->m_Language->UserIsAlreadyAnAdmin( Server, Name ) );
 						else
-							m_PairedAdminAdds.push_back( PairedAdminAdd( player->GetName( ), m_GHost->m_DB->ThreadedAdminAdd( Server, Name ) ) );
+							m_Callables->Add( m_GHost->m_DB->ThreadedAdminAdd( Server, Name ), boost::bind( &CAdminGame :: EventCallableAdminAdd, this, player->GetName( ), _1 ) );
 
 						break;
 					}
@@ -396,7 +338,7 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 		// !AUTOHOST
 		//
 
-		else if( Command == "autohost" )
+		else if( CommandID == CMD_AUTOHOST )
 		{
 			if( Payload.empty( ) || Payload == "off" )
 			{
@@ -465,7 +407,7 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 		// !AUTOHOSTMM
 		//
 
-		else if( Command == "autohostmm" )
+		else if( CommandID == CMD_AUTOHOSTMM )
 		{
 			if( Payload.empty( ) || Payload == "off" )
 			{
@@ -550,7 +492,7 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 		// !CHECKADMIN
 		//
 
-		else if( Command == "checkadmin" && !Payload.empty( ) )
+		else if( CommandID == CMD_CHECKADMIN && !Payload.empty( ) )
 		{
 			// extract the name and the server
 			// e.g. "Varlock useast.battle.net" -> name: "Varlock", server: "useast.battle.net"
@@ -605,7 +547,7 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 		// !CHECKBAN
 		//
 
-		else if( Command == "checkban" && !Payload.empty( ) )
+		else if( CommandID == CMD_CHECKBAN && !Payload.empty( ) )
 		{
 			// extract the name and the server
 			// e.g. "Varlock useast.battle.net" -> name: "Varlock", server: "useast.battle.net"
@@ -661,7 +603,7 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 		// !COUNTADMINS
 		//
 
-		else if( Command == "countadmins" )
+		else if( CommandID == CMD_COUNTADMINS )
 		{
 			string Server = Payload;
 
@@ -669,14 +611,14 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 				Server = m_GHost->m_BNETs[0]->GetServer( );
 
 			if( !Server.empty( ) )
-				m_PairedAdminCounts.push_back( PairedAdminCount( player->GetName( ), m_GHost->m_DB->ThreadedAdminCount( Server ) ) );
+				m_Callables->Add( m_GHost->m_DB->ThreadedAdminCount( Server ), boost::bind( &CAdminGame :: EventCallableAdminCount, this, player->GetName( ), _1 ) );
 		}
 
 		//
 		// !COUNTBANS
 		//
 
-		else if( Command == "countbans" )
+		else if( CommandID == CMD_COUNTBANS )
 		{
 			string Server = Payload;
 
@@ -684,14 +626,14 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 				Server = m_GHost->m_BNETs[0]->GetServer( );
 
 			if( !Server.empty( ) )
-				m_PairedBanCounts.push_back( PairedBanCount( player->GetName( ), m_GHost->m_DB->ThreadedBanCount( Server ) ) );
+				m_Callables->Add( m_GHost->m_DB->ThreadedBanCount( Server ), boost::bind( &CAdminGame :: EventCallableBanCount, this, player->GetName( ), _1 ) );
 		}
 
 		//
 		// !DELADMIN
 		//
 
-		else if( Command == "deladmin" && !Payload.empty( ) )
+		else if( CommandID == CMD_DELADMIN && !Payload.empty( ) )
 		{
 			// extract the name and the server
 			// e.g. "Varlock useast.battle.net" -> name: "Varlock", server: "useast.battle.net"
@@ -731,7 +673,7 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 						if( !(*i)->IsAdmin( Name ) )
 							SendChat( player, m_GHost->m_Language->UserIsNotAnAdmin( Server, Name ) );
 						else
-							m_PairedAdminRemoves.push_back( PairedAdminRemove( player->GetName( ), m_GHost->m_DB->ThreadedAdminRemove( Server, Name ) ) );
+							m_Callables->Add( m_GHost->m_DB->ThreadedAdminRemove( Server, Name ), boost::bind( &CAdminGame :: EventCallableAdminRemove, this, player->GetName( ), _1 ) );
 
 						break;
 					}
@@ -747,14 +689,14 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 		// !UNBAN
 		//
 
-		else if( ( Command == "delban" || Command == "unban" ) && !Payload.empty( ) )
-			m_PairedBanRemoves.push_back( PairedBanRemove( player->GetName( ), m_GHost->m_DB->ThreadedBanRemove( Payload ) ) );
+		else if( CommandID == CMD_DELBAN && !Payload.empty( ) )
+			m_Callables->Add( m_GHost->m_DB->ThreadedBanRemove( Payload ), boost::bind( &CAdminGame :: EventCallableBanRemove, this, player->GetName( ), _1 ) );
 
 		//
 		// !DISABLE
 		//
 
-		else if( Command == "disable" )
+		else if( CommandID == CMD_DISABLE )
 		{
 			SendChat( player, m_GHost->m_Language->BotDisabled( ) );
 			m_GHost->m_Enabled = false;
@@ -764,7 +706,7 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 		// !DOWNLOADS
 		//
 
-		else if( Command == "downloads" && !Payload.empty( ) )
+		else if( CommandID == CMD_DOWNLOADS && !Payload.empty( ) )
 		{
 			uint32_t Downloads = UTIL_ToUInt32( Payload );
 
@@ -789,7 +731,7 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 		// !ENABLE
 		//
 
-		else if( Command == "enable" )
+		else if( CommandID == CMD_ENABLE )
 		{
 			SendChat( player, m_GHost->m_Language->BotEnabled( ) );
 			m_GHost->m_Enabled = true;
@@ -799,7 +741,7 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 		// !END
 		//
 
-		else if( Command == "end" && !Payload.empty( ) )
+		else if( CommandID == CMD_END && !Payload.empty( ) )
 		{
 			// todotodo: what if a game ends just as you're typing this command and the numbering changes?
 
@@ -819,7 +761,7 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 		// !ENFORCESG
 		//
 
-		else if( Command == "enforcesg" && !Payload.empty( ) )
+		else if( CommandID == CMD_ENFORCESG && !Payload.empty( ) )
 		{
 			// only load files in the current directory just to be safe
 
@@ -848,7 +790,7 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 		// !QUIT
 		//
 
-		else if( Command == "exit" || Command == "quit" )
+		else if( CommandID == CMD_EXIT )
 		{
 			if( Payload == "nice" )
 				m_GHost->m_ExitingNice = true;
@@ -867,7 +809,7 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 		// !GETGAME
 		//
 
-		else if( Command == "getgame" && !Payload.empty( ) )
+		else if( CommandID == CMD_GETGAME && !Payload.empty( ) )
 		{
 			uint32_t GameNumber = UTIL_ToUInt32( Payload ) - 1;
 
@@ -881,7 +823,7 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 		// !GETGAMES
 		//
 
-		else if( Command == "getgames" )
+		else if( CommandID == CMD_GETGAMES )
 		{
 			if( m_GHost->m_CurrentGame )
 				SendChat( player, m_GHost->m_Language->GameIsInTheLobby( m_GHost->m_CurrentGame->GetDescription( ), UTIL_ToString( m_GHost->m_Games.size( ) ), UTIL_ToString( m_GHost->m_MaxGames ) ) );
@@ -893,14 +835,14 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 		// !HOSTSG
 		//
 
-		else if( Command == "hostsg" && !Payload.empty( ) )
+		else if( CommandID == CMD_HOSTSG && !Payload.empty( ) )
 			m_GHost->CreateGame( m_GHost->m_Map, GAME_PRIVATE, true, Payload, User, User, string( ), false );
 
 		//
 		// !LOAD (load config file)
 		//
 
-		else if( Command == "load" )
+		else if( CommandID == CMD_LOAD )
 		{
 			if( Payload.empty( ) )
 				SendChat( player, m_GHost->m_Language->CurrentlyLoadedMapCFGIs( m_GHost->m_Map->GetCFGFile( ) ) );
@@ -978,7 +920,7 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 		// !LOADSG
 		//
 
-		else if( Command == "loadsg" && !Payload.empty( ) )
+		else if( CommandID == CMD_LOADSG && !Payload.empty( ) )
 		{
 			// only load files in the current directory just to be safe
 
@@ -1011,7 +953,7 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 		// !MAP (load map file)
 		//
 
-		else if( Command == "map" )
+		else if( CommandID == CMD_MAP )
 		{
 			if( Payload.empty( ) )
 				SendChat( player, m_GHost->m_Language->CurrentlyLoadedMapCFGIs( m_GHost->m_Map->GetCFGFile( ) ) );
@@ -1093,14 +1035,14 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 		// !PRIV (host private game)
 		//
 
-		else if( Command == "priv" && !Payload.empty( ) )
+		else if( CommandID == CMD_PRIV && !Payload.empty( ) )
 			m_GHost->CreateGame( m_GHost->m_Map, GAME_PRIVATE, false, Payload, User, User, string( ), false );
 
 		//
 		// !PRIVBY (host private game by other player)
 		//
 
-		else if( Command == "privby" && !Payload.empty( ) )
+		else if( CommandID == CMD_PRIVBY && !Payload.empty( ) )
 		{
 			// extract the owner and the game name
 			// e.g. "Varlock dota 6.54b arem ~~~" -> owner: "Varlock", game name: "dota 6.54b arem ~~~"
@@ -1121,14 +1063,14 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 		// !PUB (host public game)
 		//
 
-		else if( Command == "pub" && !Payload.empty( ) )
+		else if( CommandID == CMD_PUB && !Payload.empty( ) )
 			m_GHost->CreateGame( m_GHost->m_Map, GAME_PUBLIC, false, Payload, User, User, string( ), false );
 
 		//
 		// !PUBBY (host public game by other player)
 		//
 
-		if( Command == "pubby" && !Payload.empty( ) )
+		if( CommandID == CMD_PUBBY && !Payload.empty( ) )
 		{
 			// extract the owner and the game name
 			// e.g. "Varlock dota 6.54b arem ~~~" -> owner: "Varlock", game name: "dota 6.54b arem ~~~"
@@ -1149,7 +1091,7 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 		// !RELOAD
 		//
 
-		else if( Command == "reload" )
+		else if( CommandID == CMD_RELOAD )
 		{
 			SendChat( player, m_GHost->m_Language->ReloadingConfigurationFiles( ) );
 			m_GHost->ReloadConfigs( );
@@ -1159,17 +1101,17 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 		// !SAY
 		//
 
-		else if( Command == "say" && !Payload.empty( ) )
+		else if( CommandID == CMD_SAY && !Payload.empty( ) )
 		{
 			for( vector<CBNET *> :: iterator i = m_GHost->m_BNETs.begin( ); i != m_GHost->m_BNETs.end( ); ++i )
-				(*i)->QueueChatCommand( Payload );
+				(*i)->PostChatCommand( Payload, string( ), false );
 		}
 
 		//
 		// !SAYGAME
 		//
 
-		else if( Command == "saygame" && !Payload.empty( ) )
+		else if( CommandID == CMD_SAYGAME && !Payload.empty( ) )
 		{
 			// extract the game number and the message
 			// e.g. "3 hello everyone" -> game number: "3", message: "hello everyone"
@@ -1206,7 +1148,7 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 		// !SAYGAMES
 		//
 
-		else if( Command == "saygames" && !Payload.empty( ) )
+		else if( CommandID == CMD_SAYGAMES && !Payload.empty( ) )
 		{
 			if( m_GHost->m_CurrentGame )
 				m_GHost->m_CurrentGame->SendAllChat( Payload );
@@ -1219,7 +1161,7 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 		// !UNHOST
 		//
 
-		else if( Command == "unhost" )
+		else if( CommandID == CMD_UNHOST )
 		{
 			if( m_GHost->m_CurrentGame )
 			{
@@ -1239,7 +1181,7 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 		// !W
 		//
 
-		else if( Command == "w" && !Payload.empty( ) )
+		else if( CommandID == CMD_W && !Payload.empty( ) )
 		{
 			// extract the name and the message
 			// e.g. "Varlock hello there!" -> name: "Varlock", message: "hello there!"
@@ -1254,7 +1196,7 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 				Message = Payload.substr( MessageStart + 1 );
 
 				for( vector<CBNET *> :: iterator i = m_GHost->m_BNETs.begin( ); i != m_GHost->m_BNETs.end( ); ++i )
-					(*i)->QueueChatCommand( Message, Name, true );
+					(*i)->PostChatCommand( Message, Name, true );
 			}
 		}
 	}
@@ -1269,7 +1211,7 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 	// !PASSWORD
 	//
 
-	if( Command == "password" && !player->GetLoggedIn( ) )
+	if( CommandID == CMD_PASSWORD && !player->GetLoggedIn( ) )
 	{
 		if( !m_Password.empty( ) && Payload == m_Password )
 		{
@@ -31,37 +31,70 @@ class CCallableAdminRemove;
 class CCallableBanCount;
 // class CCallableBanAdd;
 class CCallableBanRemove;
-
-typedef pair<string,CCallableAdminCount *> PairedAdminCount;
-typedef pair<string,CCallableAdminAdd *> PairedAdminAdd;
-typedef pair<string,CCallableAdminRemove *> PairedAdminRemove;
-typedef pair<string,CCallableBanCount *> PairedBanCount;
-// typedef pair<string,CCallableBanAdd *> PairedBanAdd;
-typedef pair<string,CCallableBanRemove *> PairedBanRemove;
+class CCommandTable;
 
 typedef pair<string,uint32_t> TempBan;
 
 class CAdminGame : public CBaseGame
 {
+public:
+	enum Commands
+	{
+		CMD_ADDADMIN = 0,
+		CMD_AUTOHOST,
+		CMD_AUTOHOSTMM,
+		CMD_CHECKADMIN,
+		CMD_CHECKBAN,
+		CMD_COUNTADMINS,
+		CMD_COUNTBANS,
+		CMD_DELADMIN,
+		CMD_DELBAN,
+		CMD_DISABLE,
+		CMD_DOWNLOADS,
+		CMD_ENABLE,
+		CMD_END,
+		CMD_ENFORCESG,
+		CMD_EXIT,
+		CMD_GETGAME,
+		CMD_GETGAMES,
+		CMD_HOSTSG,
+		CMD_LOAD,
+		CMD_LOADSG,
+		CMD_MAP,
+		CMD_PRIV,
+		CMD_PRIVBY,
+		CMD_PUB,
+		CMD_PUBBY,
+		CMD_RELOAD,
+		CMD_SAY,
+		CMD_SAYGAME,
+		CMD_SAYGAMES,
+		CMD_UNHOST,
+		CMD_W,
+		CMD_PASSWORD
+	};
+
 protected:
 	string m_Password;
 	vector<TempBan> m_TempBans;
-	vector<PairedAdminCount> m_PairedAdminCounts;	// vector of paired threaded database admin counts in progress
-	vector<PairedAdminAdd> m_PairedAdminAdds;		// vector of paired threaded database admin adds in progress
-	vector<PairedAdminRemove> m_PairedAdminRemoves;	// vector of paired threaded database admin removes in progress
-	vector<PairedBanCount> m_PairedBanCounts;		// vector of paired threaded database ban counts in progress
-	// vector<PairedBanAdd> m_PairedBanAdds;		// vector of paired threaded database ban adds in progress
-	vector<PairedBanRemove> m_PairedBanRemoves;		// vector of paired threaded database ban removes in progress
 
 public:
 	CAdminGame( CGHost *nGHost, CMap *nMap, CSaveGame *nSaveGame, uint16_t nHostPort, unsigned char nGameState, string nGameName, string nPassword );
 	virtual ~CAdminGame( );
 
+	static void RegisterCommands( CCommandTable *commands );
+
+
 	virtual bool Update( void *fd, void *send_fd );
 	virtual void SendAdminChat( string message );
 	virtual void SendWelcomeMessage( CGamePlayer *player );
 	virtual void EventPlayerJoined( CPotentialPlayer *potential, CIncomingJoinPlayer *joinPlayer );
 	virtual bool EventPlayerBotCommand( CGamePlayer *player, string command, string payload );
+	virtual void EventCallableAdminCount( string user, CCallableAdminCount *callable );
+	virtual void EventCallableAdminAdd( string user, CCallableAdminAdd *callable );
+	virtual void EventCallableAdminRemove( string user, CCallableAdminRemove *callable );
+	virtual void EventCallableBanCount( string user, CCallableBanCount *callable );
+	virtual void EventCallableBanRemove( string user, CCallableBanRemove *callable );
 };
 
 #endif
@@ -23,8 +23,11 @@
 #include "config.h"
 #include "language.h"
 #include "socket.h"
+#include "mailbox.h"
 #include "ghostdb.h"
+#include "commandtable.h"
 #include "bnet.h"
+#include "sendscheduler.h"
 #include "map.h"
 #include "packed.h"
 #include "savegame.h"
@@ -32,21 +35,25 @@
 #include "gameplayer.h"
 #include "gameprotocol.h"
 #include "game_base.h"
+#include "ipblacklist.h"
+#include "balance.h"
 
 #include <cmath>
 #include <string.h>
 #include <time.h>
 
-#include "next_combination.h"
-
 //
 // CBaseGame
 //
 
-CBaseGame :: CBaseGame( CGHost *nGHost, CMap *nMap, CSaveGame *nSaveGame, uint16_t nHostPort, unsigned char nGameState, string nGameName, string nOwnerName, string nCreatorName, string nCreatorServer ) : m_GHost( nGHost ), m_SaveGame( nSaveGame ), m_Replay( NULL ), m_Exiting( false ), m_Saving( false ), m_HostPort( nHostPort ), m_GameState( nGameState ), m_VirtualHostPID( 255 ), m_FakePlayerPID( 255 ), m_GProxyEmptyActions( 0 ), m_GameName( nGameName ), m_LastGameName( nGameName ), m_VirtualHostName( m_GHost->m_VirtualHostName ), m_OwnerName( nOwnerName ), m_CreatorName( nCreatorName ), m_CreatorServer( nCreatorServer ), m_HCLCommandString( nMap->GetMapDefaultHCL( ) ), m_RandomSeed( GetTicks( ) ), m_HostCounter( m_GHost->m_HostCounter++ ), m_EntryKey( rand( ) ), m_Latency( m_GHost->m_Latency ), m_SyncLimit( m_GHost->m_SyncLimit ), m_SyncCounter( 0 ), m_GameTicks( 0 ), m_CreationTime( GetTime( ) ), m_LastPingTime( GetTime( ) ), m_LastRefreshTime( GetTime( ) ), m_LastDownloadTicks( GetTime( ) ), m_DownloadCounter( 0 ), m_LastDownloadCounterResetTicks( GetTime( ) ), m_LastAnnounceTime( 0 ), m_AnnounceInterval( 0 ), m_LastAutoStartTime( GetTime( ) ), m_AutoStartPlayers( 0 ), m_LastCountDownTicks( 0 ), m_CountDownCounter( 0 ), m_StartedLoadingTicks( 0 ), m_StartPlayers( 0 ), m_LastLagScreenResetTime( 0 ), m_LastActionSentTicks( 0 ), m_LastActionLateBy( 0 ), m_StartedLaggingTime( 0 ), m_LastLagScreenTime( 0 ), m_LastReservedSeen( GetTime( ) ), m_StartedKickVoteTime( 0 ), m_GameOverTime( 0 ), m_LastPlayerLeaveTicks( 0 ), m_MinimumScore( 0. ), m_MaximumScore( 0. ), m_SlotInfoChanged( false ), m_Locked( false ), m_RefreshMessages( m_GHost->m_RefreshMessages ), m_RefreshError( false ), m_RefreshRehosted( false ), m_MuteAll( false ), m_MuteLobby( false ), m_CountDownStarted( false ), m_GameLoading( false ), m_GameLoaded( false ), m_LoadInGame( nMap->GetMapLoadInGame( ) ), m_Lagging( false ), m_AutoSave( m_GHost->m_AutoSave ), m_MatchMaking( false ), m_LocalAdminMessages( m_GHost->m_LocalAdminMessages ), m_DoDelete( 0 ), m_LastReconnectHandleTime( 0 )
+CBaseGame :: CBaseGame( CGHost *nGHost, CMap *nMap, CSaveGame *nSaveGame, uint16_t nHostPort, unsigned char nGameState, string nGameName, string nOwnerName, string nCreatorName, string nCreatorServer ) : m_GHost( nGHost ), m_SaveGame( nSaveGame ), m_Replay( NULL ), m_Exiting( false ), m_Saving( false ), m_HostPort( nHostPort ), m_GameState( nGameState ), m_VirtualHostPID( 255 ), m_FakePlayerPID( 255 ), m_GProxyEmptyActions( 0 ), m_GameName( nGameName ), m_LastGameName( nGameName ), m_VirtualHostName( m_GHost->m_VirtualHostName ), m_OwnerName( nOwnerName ), m_CreatorName( nCreatorName ), m_CreatorServer( nCreatorServer ), m_HCLCommandString( nMap->GetMapDefaultHCL( ) ), m_RandomSeed( GetTicks( ) ), m_HostCounter( m_GHost->m_HostCounter++ ), m_EntryKey( rand( ) ), m_Latency( m_GHost->m_Latency ), m_SyncLimit( m_GHost->m_SyncLimit ), m_SyncCounter( 0 ), m_GameTicks( 0 ), m_CreationTime( GetTime( ) ), m_LastPingTime( GetTime( ) ), m_LastRefreshTime( GetTime( ) ), m_LastDownloadTicks( GetTime( ) ), m_DownloadCounter( 0 ), m_LastDownloadCounterResetTicks( GetTime( ) ), m_LastAnnounceTime( 0 ), m_AnnounceInterval( 0 ), m_LastAutoStartTime( GetTime( ) ), m_AutoStartPlayers( 0 ), m_LastCountDownTicks( 0 ), m_CountDownCounter( 0 ), m_StartedLoadingTicks( 0 ), m_StartPlayers( 0 ), m_LastLagScreenResetTime( 0 ), m_LastActionSentTicks( 0 ), m_LastActionLateBy( 0 ), m_StartedLaggingTime( 0 ), m_LastLagScreenTime( 0 ), m_LastReservedSeen( GetTime( ) ), m_StartedKickVoteTime( 0 ), m_GameOverTime( 0 ), m_LastPlayerLeaveTicks( 0 ), m_MinimumScore( 0. ), m_MaximumScore( 0. ), m_SlotInfoChanged( false ), m_SlotInfoVersion( 0 ), m_SlotInfoSentVersion( 0 ), m_LastSlotInfoFlushTicks( 0 ), m_Locked( false ), m_RefreshMessages( m_GHost->m_RefreshMessages ), m_RefreshError( false ), m_RefreshRehosted( false ), m_MuteAll( false ), m_MuteLobby( false ), m_CountDownStarted( false ), m_GameLoading( false ), m_GameLoaded( false ), m_LoadInGame( nMap->GetMapLoadInGame( ) ), m_Lagging( false ), m_AutoSave( m_GHost->m_AutoSave ), m_MatchMaking( false ), m_LocalAdminMessages( m_GHost->m_LocalAdminMessages ), m_DoDelete( 0 ), m_LastReconnectHandleTime( 0 )
 {
 	m_Socket = new CTCPServer( );
 	m_Protocol = new CGameProtocol( m_GHost );
+	m_WakeSocket = new CWakeSocket( );
+	m_Callables = new CCallableInbox( m_WakeSocket );
+	m_Mailbox = new CMailbox<CGameMessage>( m_WakeSocket );
+	m_CommandLimiter = new CCommandLimiter( );
 	m_Map = new CMap( *nMap );
 	m_EvenPlayeredTeams = false;
 	m_GameEnded = false;	
@@ -101,47 +108,6 @@ CBaseGame :: CBaseGame( CGHost *nGHost, CMap *nMap, CSaveGame *nSaveGame, uint16
 	else
 		m_Slots = m_Map->GetSlots( );
 
-	if( !m_GHost->m_IPBlackListFile.empty( ) )
-	{
-		ifstream in;
-		in.open( m_GHost->m_IPBlackListFile.c_str( ) );
-
-		if( in.fail( ) )
-			CONSOLE_Print( "[GAME: " + m_GameName + "] error loading IP blacklist file [" + m_GHost->m_IPBlackListFile + "]" );
-		else
-		{
-			CONSOLE_Print( "[GAME: " + m_GameName + "] loading IP blacklist file [" + m_GHost->m_IPBlackListFile + "]" );
-			string Line;
-
-			while( !in.eof( ) )
-			{
-				getline( in, Line );
-
-				// ignore blank lines and comments
-
-				if( Line.empty( ) || Line[0] == '#' )
-					continue;
-
-				// remove newlines and partial newlines to help fix issues with Windows formatted files on Linux systems
-
-				Line.erase( remove( Line.begin( ), Line.end( ), ' ' ), Line.end( ) );
-				Line.erase( remove( Line.begin( ), Line.end( ), '\r' ), Line.end( ) );
-				Line.erase( remove( Line.begin( ), Line.end( ), '\n' ), Line.end( ) );
-
-				// ignore lines that don't look like IP addresses
-
-				if( Line.find_first_not_of( "1234567890." ) != string :: npos )
-					continue;
-
-				m_IPBlackList.insert( Line );
-			}
-
-			in.close( );
-
-			CONSOLE_Print( "[GAME: " + m_GameName + "] loaded " + UTIL_ToString( m_IPBlackList.size( ) ) + " lines from IP blacklist file" );
-		}
-	}
-
 	// start listening for connections
 
 	if( !m_GHost->m_BindAddress.empty( ) )
@@ -175,18 +141,14 @@ CBaseGame :: ~CBaseGame( )
 	for( vector<CGamePlayer *> :: iterator i = m_Players.begin( ); i != m_Players.end( ); ++i )
 		delete *i;
 
-	boost::mutex::scoped_lock lock( m_GHost->m_CallablesMutex );
-	
-	for( vector<CCallableScoreCheck *> :: iterator i = m_ScoreChecks.begin( ); i != m_ScoreChecks.end( ); ++i )
-		m_GHost->m_Callables.push_back( *i );
-	
-	lock.unlock( );
+	// the continuations reference this game so anything still in flight is handed over to CGHost to be deleted when ready
+
+	m_Callables->Orphan( m_GHost->m_Callables );
+	delete m_Callables;
+	delete m_Mailbox;
+	delete m_WakeSocket;
+	delete m_CommandLimiter;
 
-	while( !m_Actions.empty( ) )
-	{
-		delete m_Actions.front( );
-		m_Actions.pop( );
-	}
 }
 
 void CBaseGame :: doDelete( )
@@ -286,7 +248,21 @@ uint32_t CBaseGame :: GetNextTimedActionTicks( )
 	// warning: this function must take into account when actions are not being sent (e.g. during loading or lagging)
 
 	if( !m_GameLoaded || m_Lagging )
+	{
+		// wake up in time to send any pending slot info changes when the flush window ends
+
+		if( m_SlotInfoSentVersion != m_SlotInfoVersion )
+		{
+			uint32_t TicksSinceLastFlush = GetTicks( ) - m_LastSlotInfoFlushTicks;
+
+			if( TicksSinceLastFlush >= m_GHost->m_SlotInfoInterval )
+				return 0;
+			else if( m_GHost->m_SlotInfoInterval - TicksSinceLastFlush < 50 )
+				return m_GHost->m_SlotInfoInterval - TicksSinceLastFlush;
+		}
+
 		return 50;
+	}
 
 	uint32_t TicksSinceLastUpdate = GetTicks( ) - m_LastActionSentTicks;
 
@@ -374,6 +350,9 @@ unsigned int CBaseGame :: SetFD( void *fd, void *send_fd, int *nfds )
 		++NumFDs;
 	}
 
+	m_WakeSocket->SetFD( (fd_set *)fd, (fd_set *)send_fd, nfds );
+	++NumFDs;
+
 	for( vector<CPotentialPlayer *> :: iterator i = m_Potentials.begin( ); i != m_Potentials.end( ); ++i )
 	{
 		if( (*i)->GetSocket( ) )
@@ -397,27 +376,10 @@ unsigned int CBaseGame :: SetFD( void *fd, void *send_fd, int *nfds )
 
 bool CBaseGame :: Update( void *fd, void *send_fd )
 {
-	// update callables
+	// run the continuations of any database callables which completed since the last update
 
-	for( vector<CCallableScoreCheck *> :: iterator i = m_ScoreChecks.begin( ); i != m_ScoreChecks.end( ); )
-	{
-		if( (*i)->GetReady( ) )
-		{
-			double Score = (*i)->GetResult( );
-
-			for( vector<CPotentialPlayer *> :: iterator j = m_Potentials.begin( ); j != m_Potentials.end( ); ++j )
-			{
-				if( (*j)->GetJoinPlayer( ) && (*j)->GetJoinPlayer( )->GetName( ) == (*i)->GetName( ) )
-					EventPlayerJoinedWithScore( *j, (*j)->GetJoinPlayer( ), Score );
-			}
-
-			m_GHost->m_DB->RecoverCallable( *i );
-			delete *i;
-			i = m_ScoreChecks.erase( i );
-		}
-		else
-			++i;
-	}
+	m_WakeSocket->Drain( (fd_set *)fd );
+	m_Callables->Process( m_GHost->m_DB );
 
 	// update players
 
@@ -472,7 +434,9 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 		// so if the player takes longer than 90 seconds to download the map they would be disconnected unless we keep sending pings
 		// todotodo: ignore pings received from players who have recently finished downloading the map
 
-		SendAll( m_Protocol->SEND_W3GS_PING_FROM_HOST( ) );
+		CW3GSPingFromHost Ping;
+		Ping.SetUInt32<4>( GetTicks( ) );
+		SendAll( Ping.GetData( ), Ping.GetSize( ) );
 
 		// we also broadcast the game to the local network every 5 seconds so we hijack this timer for our nefarious purposes
 		// however we only want to broadcast if the countdown hasn't started
@@ -481,45 +445,10 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 
 		if( !m_CountDownStarted )
 		{
-			// construct a fixed host counter which will be used to identify players from this "realm" (i.e. LAN)
-			// the fixed host counter's 4 most significant bits will contain a 4 bit ID (0-15)
-			// the rest of the fixed host counter will contain the 28 least significant bits of the actual host counter
-			// since we're destroying 4 bits of information here the actual host counter should not be greater than 2^28 which is a reasonable assumption
-			// when a player joins a game we can obtain the ID from the received host counter
-			// note: LAN broadcasts use an ID of 0, battle.net refreshes use an ID of 1-10, the rest are unused
-
-			uint32_t FixedHostCounter = m_HostCounter & 0x0FFFFFFF;
-
-			// we send MAX_SLOTS for SlotsTotal because this determines how many PID's Warcraft 3 allocates
-			// we need to make sure Warcraft 3 allocates at least SlotsTotal + 1 but at most MAX_SLOTS PID's
-			// this is because we need an extra PID for the virtual host player (but we always delete the virtual host player when the MAX_SLOTSth person joins)
-			// however, we can't send 13 for SlotsTotal because this causes Warcraft 3 to crash when sharing control of units
-			// nor can we send SlotsTotal because then Warcraft 3 crashes when playing maps with less than MAX_SLOTS PID's (because of the virtual host player taking an extra PID)
-			// we also send MAX_SLOTS for SlotsOpen because Warcraft 3 assumes there's always at least one player in the game (the host)
-			// so if we try to send accurate numbers it'll always be off by one and results in Warcraft 3 assuming the game is full when it still needs one more player
-			// the easiest solution is to simply send MAX_SLOTS for both so the game will always show up as (1/MAX_SLOTS) players
-
-			if( m_SaveGame )
-			{
-				// note: the PrivateGame flag is not set when broadcasting to LAN (as you might expect)
-
-				uint32_t MapGameType = MAPGAMETYPE_SAVEDGAME;
-				BYTEARRAY MapWidth;
-				MapWidth.push_back( 0 );
-				MapWidth.push_back( 0 );
-				BYTEARRAY MapHeight;
-				MapHeight.push_back( 0 );
-				MapHeight.push_back( 0 );
-				m_GHost->m_UDPSocket->Broadcast( 6112, m_Protocol->SEND_W3GS_GAMEINFO( m_GHost->m_TFT, m_GHost->m_LANWar3Version, UTIL_CreateByteArray( MapGameType, false ), m_Map->GetMapGameFlags( ), MapWidth, MapHeight, m_GameName, "Varlock", GetTime( ) - m_CreationTime, "Save\\Multiplayer\\" + m_SaveGame->GetFileNameNoPath( ), m_SaveGame->GetMagicNumber( ), MAX_SLOTS, MAX_SLOTS, m_HostPort, FixedHostCounter, m_EntryKey ) );
-			}
-			else
-			{
-				// note: the PrivateGame flag is not set when broadcasting to LAN (as you might expect)
-				// note: we do not use m_Map->GetMapGameType because none of the filters are set when broadcasting to LAN (also as you might expect)
+			BYTEARRAY GameInfo = GetLANGameInfo( );
 
-				uint32_t MapGameType = MAPGAMETYPE_UNKNOWN0;
-				m_GHost->m_UDPSocket->Broadcast( 6112, m_Protocol->SEND_W3GS_GAMEINFO( m_GHost->m_TFT, m_GHost->m_LANWar3Version, UTIL_CreateByteArray( MapGameType, false ), m_Map->GetMapGameFlags( ), m_Map->GetMapWidth( ), m_Map->GetMapHeight( ), m_GameName, "Varlock", GetTime( ) - m_CreationTime, m_Map->GetMapPath( ), m_Map->GetMapCRC( ), MAX_SLOTS, MAX_SLOTS, m_HostPort, FixedHostCounter, m_EntryKey ) );
-			}
+			if( !GameInfo.empty( ) )
+				m_GHost->m_UDPSocket->Broadcast( 6112, GameInfo );
 		}
 
 		m_LastPingTime = GetTime( );
@@ -579,9 +508,10 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 
 		for( vector<CBNET *> :: iterator i = m_GHost->m_BNETs.begin( ); i != m_GHost->m_BNETs.end( ); ++i )
 		{
-			// don't queue a game refresh message if the queue contains more than 1 packet because they're very low priority
+			// game refreshes have their own lane which jumps ahead of chat and merges queued refreshes so only the game lane is checked here
+			// a burst of whispers or chat replies waiting in the other lanes must not hold up refreshing the game
 
-			if( (*i)->GetOutPacketsQueued( ) <= 1 )
+			if( (*i)->GetOutPacketsQueued( SENDLANE_GAME ) <= 1 )
 			{
 				(*i)->QueueGameRefresh( m_GameState, m_GameName, string( ), m_Map, m_SaveGame, 0, m_HostCounter );
 				Refreshed = true;
@@ -655,7 +585,9 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 					if( m_GHost->m_MaxDownloadSpeed > 0 && m_DownloadCounter > m_GHost->m_MaxDownloadSpeed * 1024 )
 						break;
 
-					Send( *i, m_Protocol->SEND_W3GS_MAPPART( GetHostPID( ), (*i)->GetPID( ), (*i)->GetLastMapPartSent( ), m_Map->GetMapData( ) ) );
+					m_SendFrame.clear( );
+					m_Protocol->WRITE_W3GS_MAPPART( m_SendFrame, GetHostPID( ), (*i)->GetPID( ), (*i)->GetLastMapPartSent( ), m_Map->GetMapData( ) );
+					Send( *i, m_SendFrame );
 					(*i)->SetLastMapPartSent( (*i)->GetLastMapPartSent( ) + 1442 );
 					m_DownloadCounter += 1442;
 				}
@@ -673,37 +605,9 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 		m_LastAnnounceTime = GetTime( );
 	}
 	
-	// handle saygames vector
-	
-	if( !m_DoSayGames.empty( ) )
-	{
-		boost::mutex::scoped_lock lock( m_SayGamesMutex );
-		
-		for( vector<string> :: iterator i = m_DoSayGames.begin( ); i != m_DoSayGames.end( ); ++i )
-			SendAllChat( "ADMIN: " + *i );
-		
-		m_DoSayGames.clear( );
-		
-		lock.unlock( );
-	}
-	
-	// handle add to spoofed vector
-	
-	if( !m_DoSpoofAdd.empty( ) )
-	{
-		boost::mutex::scoped_lock lock( m_SpoofAddMutex );
-		
-		for( vector<QueuedSpoofAdd> :: iterator i = m_DoSpoofAdd.begin( ); i != m_DoSpoofAdd.end( ); ++i )
-		{
-			if( (*i).failMessage.empty( ) )
-				AddToSpoofed( (*i).server, (*i).name, (*i).sendMessage );
-			else
-				SendAllChat( (*i).failMessage );
-		}
-		
-		m_DoSpoofAdd.clear( );
-		lock.unlock( );
-	}
+	// handle messages posted by other threads (say games and spoof checks from battle.net, GProxy++ reconnects from the main thread)
+
+	ProcessMessages( );
 
 	// kick players who don't spoof check within 20 seconds when spoof checks are required and the game is autohosted
 
@@ -788,6 +692,7 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 			m_LastActionSentTicks = GetTicks( );
 			m_GameLoading = false;
 			m_GameLoaded = true;
+			m_LoadInGameLog.Discard( m_LoadInGameLog.GetEnd( ) );
 			EventGameLoaded( );
 		}
 		else
@@ -797,6 +702,7 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 			if( m_LoadInGame && GetTime( ) - m_LastLagScreenResetTime >= 30 )
 			{
 				bool UsingGProxy = false;
+				bool StillLoading = false;
 
 				for( vector<CGamePlayer *> :: iterator i = m_Players.begin( ); i != m_Players.end( ); ++i )
 				{
@@ -829,31 +735,38 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 							// empty actions are used to extend the time a player can use when reconnecting
 
 							for( unsigned char j = 0; j < m_GProxyEmptyActions; ++j )
-								Send( *i, m_Protocol->SEND_W3GS_INCOMING_ACTION( queue<CIncomingAction *>( ), 0 ) );
+								Send( *i, m_Protocol->SEND_W3GS_INCOMING_ACTION( NULL, 0, 0 ) );
 						}
 
-						Send( *i, m_Protocol->SEND_W3GS_INCOMING_ACTION( queue<CIncomingAction *>( ), 0 ) );
+						Send( *i, m_Protocol->SEND_W3GS_INCOMING_ACTION( NULL, 0, 0 ) );
 
 						// start the lag screen
 
 						Send( *i, m_Protocol->SEND_W3GS_START_LAG( m_Players, true ) );
 					}
 					else
-					{
-						// buffer the empty update since the player is still loading the map
+						StillLoading = true;
+				}
 
-						if( UsingGProxy && !(*i)->GetGProxy( ) )
-						{
-							// we must send empty actions to non-GProxy++ players
-							// GProxy++ will insert these itself so we don't need to send them to GProxy++ players
-							// empty actions are used to extend the time a player can use when reconnecting
+				if( StillLoading )
+				{
+					// buffer the empty update since some players are still loading the map
+					// it's added to the log once and every loading player is sent it when they finish loading
 
-							for( unsigned char j = 0; j < m_GProxyEmptyActions; ++j )
-								(*i)->AddLoadInGameData( m_Protocol->SEND_W3GS_INCOMING_ACTION( queue<CIncomingAction *>( ), 0 ) );
-						}
+					m_SendFrame.clear( );
+					m_Protocol->WRITE_W3GS_INCOMING_ACTION( m_SendFrame, NULL, 0, 0 );
 
-						(*i)->AddLoadInGameData( m_Protocol->SEND_W3GS_INCOMING_ACTION( queue<CIncomingAction *>( ), 0 ) );
+					if( UsingGProxy )
+					{
+						// we must send empty actions to non-GProxy++ players
+						// GProxy++ will insert these itself so we don't need to send them to GProxy++ players
+						// empty actions are used to extend the time a player can use when reconnecting
+
+						for( unsigned char j = 0; j < m_GProxyEmptyActions; ++j )
+							m_LoadInGameLog.Add( m_SendFrame, LOADINGAME_NONGPROXY );
 					}
+
+					m_LoadInGameLog.Add( m_SendFrame );
 				}
 
 				// add actions to replay
@@ -863,10 +776,10 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 					if( UsingGProxy )
 					{
 						for( unsigned char i = 0; i < m_GProxyEmptyActions; ++i )
-							m_Replay->AddTimeSlot( 0, queue<CIncomingAction *>( ) );
+							m_Replay->AddTimeSlot( 0, NULL, 0 );
 					}
 
-					m_Replay->AddTimeSlot( 0, queue<CIncomingAction *>( ) );
+					m_Replay->AddTimeSlot( 0, NULL, 0 );
 				}
 
 				// Warcraft III doesn't seem to respond to empty actions
@@ -973,10 +886,10 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 						// empty actions are used to extend the time a player can use when reconnecting
 
 						for( unsigned char j = 0; j < m_GProxyEmptyActions; ++j )
-							Send( *i, m_Protocol->SEND_W3GS_INCOMING_ACTION( queue<CIncomingAction *>( ), 0 ) );
+							Send( *i, m_Protocol->SEND_W3GS_INCOMING_ACTION( NULL, 0, 0 ) );
 					}
 
-					Send( *i, m_Protocol->SEND_W3GS_INCOMING_ACTION( queue<CIncomingAction *>( ), 0 ) );
+					Send( *i, m_Protocol->SEND_W3GS_INCOMING_ACTION( NULL, 0, 0 ) );
 
 					// start the lag screen
 
@@ -990,10 +903,10 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 					if( UsingGProxy )
 					{
 						for( unsigned char i = 0; i < m_GProxyEmptyActions; ++i )
-							m_Replay->AddTimeSlot( 0, queue<CIncomingAction *>( ) );
+							m_Replay->AddTimeSlot( 0, NULL, 0 );
 					}
 
-					m_Replay->AddTimeSlot( 0, queue<CIncomingAction *>( ) );
+					m_Replay->AddTimeSlot( 0, NULL, 0 );
 				}
 
 				// Warcraft III doesn't seem to respond to empty actions
@@ -1043,29 +956,9 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 		}
 		
 		// see if we can handle any pending reconnects
-		if( !m_GHost->m_PendingReconnects.empty( ) && GetTicks( ) - m_LastReconnectHandleTime > 500 )
-		{
-			m_LastReconnectHandleTime = GetTicks( );
-			
-			boost::mutex::scoped_lock lock( m_GHost->m_ReconnectMutex );
-			
-			for( vector<GProxyReconnector *> :: iterator i = m_GHost->m_PendingReconnects.begin( ); i != m_GHost->m_PendingReconnects.end( ); )
-			{
-				CGamePlayer *Player = GetPlayerFromPID( (*i)->PID );
-				
-				if( Player && Player->GetGProxy( ) && Player->GetGProxyReconnectKey( ) == (*i)->ReconnectKey )
-				{
-					Player->EventGProxyReconnect( (*i)->socket, (*i)->LastPacket );
-					delete (*i);
-					i = m_GHost->m_PendingReconnects.erase( i );
-					continue;
-				}
-				
-				i++;
-			}
-			
-			lock.unlock();
-		}
+
+		if( !m_PendingReconnects.empty( ) && GetTicks( ) - m_LastReconnectHandleTime > 500 )
+			ProcessReconnects( );
 	}
 
 	// send actions every m_Latency milliseconds
@@ -1147,9 +1040,9 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 
 		if( NewSocket )
 		{
-			// check the IP blacklist
+			// check the IP blacklist before anything is allocated for the new connection
 
-			if( m_IPBlackList.find( NewSocket->GetIPString( ) ) == m_IPBlackList.end( ) )
+			if( !m_GHost->m_IPBlackList->IsBlackListed( NewSocket->GetIPUInt32( ) ) )
 			{
 				if( m_GHost->m_TCPNoDelay )
 					NewSocket->SetNoDelay( true );
@@ -1167,6 +1060,12 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 			return true;
 	}
 
+	// send the slot info if it changed during this update (or an earlier one) and the flush window has passed
+	// this is done last so every slot change made while processing this update ends up in the same packet
+
+	if( m_SlotInfoSentVersion != m_SlotInfoVersion && GetTicks( ) - m_LastSlotInfoFlushTicks >= m_GHost->m_SlotInfoInterval )
+		FlushSlotInfo( );
+
 	return m_Exiting;
 }
 
@@ -1189,29 +1088,35 @@ void CBaseGame :: UpdatePost( void *send_fd )
 	}
 }
 
-void CBaseGame :: Send( CGamePlayer *player, BYTEARRAY data )
+void CBaseGame :: Send( CGamePlayer *player, const BYTEARRAY &data )
 {
 	if( player )
 		player->Send( data );
 }
 
-void CBaseGame :: Send( unsigned char PID, BYTEARRAY data )
+void CBaseGame :: Send( unsigned char PID, const BYTEARRAY &data )
 {
 	Send( GetPlayerFromPID( PID ), data );
 }
 
-void CBaseGame :: Send( BYTEARRAY PIDs, BYTEARRAY data )
+void CBaseGame :: Send( BYTEARRAY PIDs, const BYTEARRAY &data )
 {
 	for( unsigned int i = 0; i < PIDs.size( ); ++i )
 		Send( PIDs[i], data );
 }
 
-void CBaseGame :: SendAll( BYTEARRAY data )
+void CBaseGame :: SendAll( const BYTEARRAY &data )
 {
 	for( vector<CGamePlayer *> :: iterator i = m_Players.begin( ); i != m_Players.end( ); ++i )
 		(*i)->Send( data );
 }
 
+void CBaseGame :: SendAll( const unsigned char *data, uint32_t length )
+{
+	for( vector<CGamePlayer *> :: iterator i = m_Players.begin( ); i != m_Players.end( ); ++i )
+		(*i)->Send( data, length );
+}
+
 void CBaseGame :: SendChat( unsigned char fromPID, CGamePlayer *player, string message )
 {
 	// send a private message to one player - it'll be marked [Private] in Warcraft 3
@@ -1319,13 +1224,175 @@ void CBaseGame :: SendLocalAdminChat( string message )
 
 void CBaseGame :: SendAllSlotInfo( )
 {
+	// this doesn't send anything right away, it just marks the slot info as out of date
+	// the slot info is encoded and sent at most once per m_SlotInfoInterval by FlushSlotInfo so a burst of slot changes only costs one packet
+
 	if( !m_GameLoading && !m_GameLoaded )
 	{
-		SendAll( m_Protocol->SEND_W3GS_SLOTINFO( m_Slots, m_RandomSeed, m_Map->GetMapLayoutStyle( ), m_Map->GetMapNumPlayers( ) ) );
+		++m_SlotInfoVersion;
 		m_SlotInfoChanged = false;
 	}
 }
 
+void CBaseGame :: FlushSlotInfo( )
+{
+	if( m_GameLoading || m_GameLoaded || m_SlotInfoSentVersion == m_SlotInfoVersion )
+		return;
+
+	m_SlotInfoSentVersion = m_SlotInfoVersion;
+	m_LastSlotInfoFlushTicks = GetTicks( );
+	m_SendFrame.clear( );
+	m_Protocol->WRITE_W3GS_SLOTINFO( m_SendFrame, m_Slots, m_RandomSeed, m_Map->GetMapLayoutStyle( ), m_Map->GetMapNumPlayers( ) );
+
+	// changes within one window often cancel each other out (e.g. a slot being closed and opened again) so don't resend an identical packet
+	// players who joined since the last flush don't need it either because they received the current slots in W3GS_SLOTINFOJOIN
+
+	if( m_SendFrame == m_SlotInfo )
+		return;
+
+	m_SlotInfo = m_SendFrame;
+	SendAll( m_SlotInfo );
+}
+
+BYTEARRAY CBaseGame :: GetLANGameInfo( )
+{
+	// the W3GS_GAMEINFO packet only has to be rebuilt when the game is rehosted (new game name or host counter)
+	// otherwise the cached packet is reused and only the slots open and uptime fields are patched in place
+
+	if( m_LANGameInfo.empty( ) || m_LANGameInfoName != m_GameName || m_LANGameInfoHostCounter != m_HostCounter )
+	{
+		// construct a fixed host counter which will be used to identify players from this "realm" (i.e. LAN)
+		// the fixed host counter's 4 most significant bits will contain a 4 bit ID (0-15)
+		// the rest of the fixed host counter will contain the 28 least significant bits of the actual host counter
+		// since we're destroying 4 bits of information here the actual host counter should not be greater than 2^28 which is a reasonable assumption
+		// when a player joins a game we can obtain the ID from the received host counter
+		// note: LAN broadcasts use an ID of 0, battle.net refreshes use an ID of 1-10, the rest are unused
+
+		uint32_t FixedHostCounter = m_HostCounter & 0x0FFFFFFF;
+
+		// we send MAX_SLOTS for SlotsTotal because this determines how many PID's Warcraft 3 allocates
+		// we need to make sure Warcraft 3 allocates at least SlotsTotal + 1 but at most MAX_SLOTS PID's
+		// this is because we need an extra PID for the virtual host player (but we always delete the virtual host player when the MAX_SLOTSth person joins)
+		// however, we can't send 13 for SlotsTotal because this causes Warcraft 3 to crash when sharing control of units
+		// nor can we send SlotsTotal because then Warcraft 3 crashes when playing maps with less than MAX_SLOTS PID's (because of the virtual host player taking an extra PID)
+		// we also send MAX_SLOTS for SlotsOpen because Warcraft 3 assumes there's always at least one player in the game (the host)
+		// so if we try to send accurate numbers it'll always be off by one and results in Warcraft 3 assuming the game is full when it still needs one more player
+		// the easiest solution is to simply send MAX_SLOTS for both so the game will always show up as (1/MAX_SLOTS) players
+
+		// note: the PrivateGame flag is not set when broadcasting to LAN (as you might expect)
+
+		if( m_SaveGame )
+		{
+			uint32_t MapGameType = MAPGAMETYPE_SAVEDGAME;
+			BYTEARRAY StatString = m_Map->GetEncodedStatString( UTIL_CreateByteArray( (uint16_t)0, false ), UTIL_CreateByteArray( (uint16_t)0, false ), "Save\\Multiplayer\\" + m_SaveGame->GetFileNameNoPath( ), m_SaveGame->GetMagicNumber( ), "Varlock", false );
+			m_LANGameInfo = m_Protocol->SEND_W3GS_GAMEINFO( m_GHost->m_TFT, m_GHost->m_LANWar3Version, UTIL_CreateByteArray( MapGameType, false ), m_GameName, GetTime( ) - m_CreationTime, StatString, MAX_SLOTS, MAX_SLOTS, m_HostPort, FixedHostCounter, m_EntryKey );
+		}
+		else
+		{
+			// note: we do not use m_Map->GetMapGameType because none of the filters are set when broadcasting to LAN (also as you might expect)
+
+			uint32_t MapGameType = MAPGAMETYPE_UNKNOWN0;
+			BYTEARRAY StatString = m_Map->GetEncodedStatString( m_Map->GetMapWidth( ), m_Map->GetMapHeight( ), m_Map->GetMapPath( ), m_Map->GetMapCRC( ), "Varlock", false );
+			m_LANGameInfo = m_Protocol->SEND_W3GS_GAMEINFO( m_GHost->m_TFT, m_GHost->m_LANWar3Version, UTIL_CreateByteArray( MapGameType, false ), m_GameName, GetTime( ) - m_CreationTime, StatString, MAX_SLOTS, MAX_SLOTS, m_HostPort, FixedHostCounter, m_EntryKey );
+		}
+
+		m_LANGameInfoName = m_GameName;
+		m_LANGameInfoHostCounter = m_HostCounter;
+	}
+	else
+		m_Protocol->PATCH_W3GS_GAMEINFO( m_LANGameInfo, MAX_SLOTS, GetTime( ) - m_CreationTime );
+
+	return m_LANGameInfo;
+}
+
+void CBaseGame :: PostSayGame( string message )
+{
+	CGameMessage *Message = new CGameMessage( GAMEMESSAGE_SAYGAME );
+	Message->m_Message = message;
+
+	if( !m_Mailbox->Post( Message ) )
+		CONSOLE_Print( "[GAME: " + m_GameName + "] mailbox is full, discarding say games message [" + message + "]" );
+}
+
+void CBaseGame :: PostSpoofAdd( string server, string name, bool sendMessage, string failMessage )
+{
+	CGameMessage *Message = new CGameMessage( GAMEMESSAGE_SPOOFADD );
+	Message->m_Server = server;
+	Message->m_Name = name;
+	Message->m_SendMessage = sendMessage;
+	Message->m_Message = failMessage;
+
+	if( !m_Mailbox->Post( Message ) )
+		CONSOLE_Print( "[GAME: " + m_GameName + "] mailbox is full, discarding spoof check for [" + name + "@" + server + "]" );
+}
+
+void CBaseGame :: PostReconnect( boost::shared_ptr<GProxyReconnector> reconnector )
+{
+	// if the mailbox is full the main thread rejects the reconnect when it expires
+
+	CGameMessage *Message = new CGameMessage( GAMEMESSAGE_RECONNECT );
+	Message->m_Reconnector = reconnector;
+	m_Mailbox->Post( Message );
+}
+
+void CBaseGame :: ProcessMessages( )
+{
+	// this is only called from the game thread
+
+	while( CGameMessage *Message = m_Mailbox->Receive( ) )
+	{
+		if( Message->m_Type == GAMEMESSAGE_SAYGAME )
+			SendAllChat( "ADMIN: " + Message->m_Message );
+		else if( Message->m_Type == GAMEMESSAGE_SPOOFADD )
+		{
+			if( Message->m_Message.empty( ) )
+				AddToSpoofed( Message->m_Server, Message->m_Name, Message->m_SendMessage );
+			else
+				SendAllChat( Message->m_Message );
+		}
+		else if( Message->m_Type == GAMEMESSAGE_RECONNECT )
+		{
+			// try to match the reconnect on the next update rather than waiting for the retry interval
+
+			m_PendingReconnects.push_back( Message->m_Reconnector );
+			m_LastReconnectHandleTime = 0;
+		}
+
+		delete Message;
+	}
+}
+
+void CBaseGame :: ProcessReconnects( )
+{
+	m_LastReconnectHandleTime = GetTicks( );
+
+	for( vector<boost::shared_ptr<GProxyReconnector> > :: iterator i = m_PendingReconnects.begin( ); i != m_PendingReconnects.end( ); )
+	{
+		// another game or the main thread already took care of this reconnect
+
+		if( (*i)->State != RECONNECT_PENDING )
+		{
+			i = m_PendingReconnects.erase( i );
+			continue;
+		}
+
+		CGamePlayer *Player = GetPlayerFromPID( (*i)->PID );
+
+		if( Player && Player->GetGProxy( ) && Player->GetGProxyReconnectKey( ) == (*i)->ReconnectKey )
+		{
+			int Expected = RECONNECT_PENDING;
+
+			if( (*i)->State.compare_exchange_strong( Expected, RECONNECT_CLAIMED ) )
+				Player->EventGProxyReconnect( (*i)->socket, (*i)->LastPacket );
+
+			i = m_PendingReconnects.erase( i );
+			continue;
+		}
+
+		++i;
+	}
+}
+
 void CBaseGame :: SendVirtualHostPlayerInfo( CGamePlayer *player )
 {
 	if( m_VirtualHostPID == 255 )
@@ -1370,19 +1437,22 @@ void CBaseGame :: SendAllActions( )
 		// GProxy++ will insert these itself so we don't need to send them to GProxy++ players
 		// empty actions are used to extend the time a player can use when reconnecting
 
+		m_SendFrame.clear( );
+		m_Protocol->WRITE_W3GS_INCOMING_ACTION( m_SendFrame, NULL, 0, 0 );
+
 		for( vector<CGamePlayer *> :: iterator i = m_Players.begin( ); i != m_Players.end( ); ++i )
 		{
 			if( !(*i)->GetGProxy( ) )
 			{
 				for( unsigned char j = 0; j < m_GProxyEmptyActions; ++j )
-					Send( *i, m_Protocol->SEND_W3GS_INCOMING_ACTION( queue<CIncomingAction *>( ), 0 ) );
+					Send( *i, m_SendFrame );
 			}
 		}
 
 		if( m_Replay )
 		{
 			for( unsigned char i = 0; i < m_GProxyEmptyActions; ++i )
-				m_Replay->AddTimeSlot( 0, queue<CIncomingAction *>( ) );
+				m_Replay->AddTimeSlot( 0, NULL, 0 );
 		}
 	}
 
@@ -1397,63 +1467,56 @@ void CBaseGame :: SendAllActions( )
 
 	if( !m_Actions.empty( ) )
 	{
-		// we use a "sub actions queue" which we keep adding actions to until we reach the size limit
-		// start by adding one action to the sub actions queue
+		// the actions are already stored back to back in m_Actions so we just have to decide where to split them
+		// start with the first action and keep adding actions to the current run until we reach the size limit
 
-		queue<CIncomingAction *> SubActions;
-		CIncomingAction *Action = m_Actions.front( );
-		m_Actions.pop( );
-		SubActions.push( Action );
-		uint32_t SubActionsLength = Action->GetLength( );
+		uint32_t Start = 0;
+		uint32_t SubActionsLength = m_Actions.GetRecordLength( 0 );
 
-		while( !m_Actions.empty( ) )
+		for( uint32_t Offset = SubActionsLength; Offset < m_Actions.GetSize( ); )
 		{
-			Action = m_Actions.front( );
-			m_Actions.pop( );
+			uint32_t Length = m_Actions.GetRecordLength( Offset );
 
-			// check if adding the next action to the sub actions queue would put us over the limit (1452 because the INCOMING_ACTION and INCOMING_ACTION2 packets use an extra 8 bytes)
+			// check if adding the next action to the current run would put us over the limit (1452 because the INCOMING_ACTION and INCOMING_ACTION2 packets use an extra 8 bytes)
 
-			if( SubActionsLength + Action->GetLength( ) > 1452 )
+			if( SubActionsLength + Length > 1452 )
 			{
-				// we'd be over the limit if we added the next action to the sub actions queue
-				// so send everything already in the queue and then clear it out
+				// we'd be over the limit if we added the next action to the current run
+				// so send everything already in the run and then start a new one
 				// the W3GS_INCOMING_ACTION2 packet handles the overflow but it must be sent *before* the corresponding W3GS_INCOMING_ACTION packet
 
-				SendAll( m_Protocol->SEND_W3GS_INCOMING_ACTION2( SubActions ) );
+				m_SendFrame.clear( );
+				m_Protocol->WRITE_W3GS_INCOMING_ACTION2( m_SendFrame, m_Actions.GetData( Start ), SubActionsLength );
+				SendAll( m_SendFrame );
 
 				if( m_Replay )
-					m_Replay->AddTimeSlot2( SubActions );
-
-				while( !SubActions.empty( ) )
-				{
-					delete SubActions.front( );
-					SubActions.pop( );
-				}
+					m_Replay->AddTimeSlot2( m_Actions.GetData( Start ), SubActionsLength );
 
+				Start = Offset;
 				SubActionsLength = 0;
 			}
 
-			SubActions.push( Action );
-			SubActionsLength += Action->GetLength( );
+			SubActionsLength += Length;
+			Offset += Length;
 		}
 
-		SendAll( m_Protocol->SEND_W3GS_INCOMING_ACTION( SubActions, m_Latency ) );
+		m_SendFrame.clear( );
+		m_Protocol->WRITE_W3GS_INCOMING_ACTION( m_SendFrame, m_Actions.GetData( Start ), SubActionsLength, m_Latency );
+		SendAll( m_SendFrame );
 
 		if( m_Replay )
-			m_Replay->AddTimeSlot( m_Latency, SubActions );
+			m_Replay->AddTimeSlot( m_Latency, m_Actions.GetData( Start ), SubActionsLength );
 
-		while( !SubActions.empty( ) )
-		{
-			delete SubActions.front( );
-			SubActions.pop( );
-		}
+		m_Actions.Clear( );
 	}
 	else
 	{
-		SendAll( m_Protocol->SEND_W3GS_INCOMING_ACTION( m_Actions, m_Latency ) );
+		m_SendFrame.clear( );
+		m_Protocol->WRITE_W3GS_INCOMING_ACTION( m_SendFrame, NULL, 0, m_Latency );
+		SendAll( m_SendFrame );
 
 		if( m_Replay )
-			m_Replay->AddTimeSlot( m_Latency, m_Actions );
+			m_Replay->AddTimeSlot( m_Latency, NULL, 0 );
 	}
 
 	uint32_t ActualSendInterval = GetTicks( ) - m_LastActionSentTicks;
@@ -1473,6 +1536,31 @@ void CBaseGame :: SendAllActions( )
 	m_LastActionSentTicks = GetTicks( );
 }
 
+void CBaseGame :: SendLoadInGameLog( CGamePlayer *player )
+{
+	// send everything in the log from the player's cursor onwards, this is the same data in the same order every other loading player gets
+
+	for( uint32_t Cursor = player->GetLoadInGameCursor( ); Cursor < m_LoadInGameLog.GetEnd( ); Cursor = m_LoadInGameLog.GetNext( Cursor ) )
+	{
+		if( !( m_LoadInGameLog.GetFlags( Cursor ) & LOADINGAME_NONGPROXY ) || !player->GetGProxy( ) )
+			player->Send( m_LoadInGameLog.GetPacket( Cursor ), m_LoadInGameLog.GetPacketLength( Cursor ) );
+	}
+
+	player->SetLoadInGameCursor( m_LoadInGameLog.GetEnd( ) );
+
+	// discard the packets every player who is still loading has already been sent
+
+	uint32_t Oldest = m_LoadInGameLog.GetEnd( );
+
+	for( vector<CGamePlayer *> :: iterator i = m_Players.begin( ); i != m_Players.end( ); ++i )
+	{
+		if( !(*i)->GetFinishedLoading( ) && !(*i)->GetLeftMessageSent( ) && (*i)->GetLoadInGameCursor( ) < Oldest )
+			Oldest = (*i)->GetLoadInGameCursor( );
+	}
+
+	m_LoadInGameLog.Discard( Oldest );
+}
+
 void CBaseGame :: SendWelcomeMessage( CGamePlayer *player )
 {
 	// read from motd.txt if available (thanks to zeeg for this addition)
@@ -1572,11 +1660,11 @@ void CBaseGame :: EventPlayerDeleted( CGamePlayer *player )
 				// hackhack: there must be a better way to do this
 
 				if( (*i)->GetPasswordHashType( ) == "pvpgn" )
-					(*i)->UnqueueChatCommand( "/whereis " + player->GetName( ) );
+					(*i)->PostUnqueueChatCommand( "/whereis " + player->GetName( ) );
 				else
-					(*i)->UnqueueChatCommand( "/whois " + player->GetName( ) );
+					(*i)->PostUnqueueChatCommand( "/whois " + player->GetName( ) );
 
-				(*i)->UnqueueChatCommand( "/w " + player->GetName( ) + " " + m_GHost->m_Language->SpoofCheckByReplying( ) );
+				(*i)->PostUnqueueChatCommand( "/w " + player->GetName( ) + " " + m_GHost->m_Language->SpoofCheckByReplying( ) );
 			}
 		}
 	}
@@ -1605,11 +1693,10 @@ void CBaseGame :: EventPlayerDeleted( CGamePlayer *player )
 	{
 		string SaveGameName = UTIL_FileSafeName( "GHost++ AutoSave " + m_GameName + " (" + player->GetName( ) + ").w3z" );
 		CONSOLE_Print( "[GAME: " + m_GameName + "] auto saving [" + SaveGameName + "] before player drop, shortened send interval = " + UTIL_ToString( GetTicks( ) - m_LastActionSentTicks ) );
-		BYTEARRAY CRC;
 		BYTEARRAY Action;
 		Action.push_back( 6 );
 		UTIL_AppendByteArray( Action, SaveGameName );
-		m_Actions.push( new CIncomingAction( player->GetPID( ), CRC, Action ) );
+		m_Actions.Add( player->GetPID( ), &Action[0], Action.size( ) );
 
 		// todotodo: with the new latency system there needs to be a way to send a 0-time action
 
@@ -1621,6 +1708,9 @@ void CBaseGame :: EventPlayerDeleted( CGamePlayer *player )
 		// we must buffer player leave messages when using "load in game" to prevent desyncs
 		// this ensures the player leave messages are correctly interleaved with the empty updates sent to each player
 
+		BYTEARRAY LeavePacket = m_Protocol->SEND_W3GS_PLAYERLEAVE_OTHERS( player->GetPID( ), player->GetLeftCode( ) );
+		bool StillLoading = false;
+
 		for( vector<CGamePlayer *> :: iterator i = m_Players.begin( ); i != m_Players.end( ); ++i )
 		{
 			if( (*i)->GetFinishedLoading( ) )
@@ -1628,11 +1718,14 @@ void CBaseGame :: EventPlayerDeleted( CGamePlayer *player )
 				if( !player->GetFinishedLoading( ) )
 					Send( *i, m_Protocol->SEND_W3GS_STOP_LAG( player ) );
 
-				Send( *i, m_Protocol->SEND_W3GS_PLAYERLEAVE_OTHERS( player->GetPID( ), player->GetLeftCode( ) ) );
+				Send( *i, LeavePacket );
 			}
-			else
-				(*i)->AddLoadInGameData( m_Protocol->SEND_W3GS_PLAYERLEAVE_OTHERS( player->GetPID( ), player->GetLeftCode( ) ) );
+			else if( *i != player )
+				StillLoading = true;
 		}
+
+		if( StillLoading )
+			m_LoadInGameLog.Add( LeavePacket );
 	}
 	else
 	{
@@ -1937,7 +2030,7 @@ void CBaseGame :: EventPlayerJoined( CPotentialPlayer *potential, CIncomingJoinP
 		// start a database query to determine the player's score
 		// when the query is complete we will call EventPlayerJoinedWithScore
 
-		m_ScoreChecks.push_back( m_GHost->m_DB->ThreadedScoreCheck( m_Map->GetMapMatchMakingCategory( ), joinPlayer->GetName( ), JoinedRealm ) );
+		m_Callables->Add( m_GHost->m_DB->ThreadedScoreCheck( m_Map->GetMapMatchMakingCategory( ), joinPlayer->GetName( ), JoinedRealm ), boost::bind( &CBaseGame :: EventCallableScoreCheck, this, _1 ) );
 		return;
 	}
 
@@ -2275,6 +2368,17 @@ void CBaseGame :: EventPlayerJoined( CPotentialPlayer *potential, CIncomingJoinP
 	Player->SetSpoofedRealm( JoinedRealm );
 }
 
+void CBaseGame :: EventCallableScoreCheck( CCallableScoreCheck *callable )
+{
+	double Score = callable->GetResult( );
+
+	for( vector<CPotentialPlayer *> :: iterator i = m_Potentials.begin( ); i != m_Potentials.end( ); ++i )
+	{
+		if( (*i)->GetJoinPlayer( ) && (*i)->GetJoinPlayer( )->GetName( ) == callable->GetName( ) )
+			EventPlayerJoinedWithScore( *i, (*i)->GetJoinPlayer( ), Score );
+	}
+}
+
 void CBaseGame :: EventPlayerJoinedWithScore( CPotentialPlayer *potential, CIncomingJoinPlayer *joinPlayer, double score )
 {
 	// this function is only called when matchmaking is enabled
@@ -2738,13 +2842,7 @@ void CBaseGame :: EventPlayerLoaded( CGamePlayer *player )
 		// see the Update function for more information about why we do this
 		// this includes player loaded messages, game updates, and player leave messages
 
-		queue<BYTEARRAY> *LoadInGameData = player->GetLoadInGameData( );
-
-		while( !LoadInGameData->empty( ) )
-		{
-			Send( player, LoadInGameData->front( ) );
-			LoadInGameData->pop( );
-		}
+		SendLoadInGameLog( player );
 
 		// start the lag screen for the new player
 
@@ -2781,7 +2879,11 @@ void CBaseGame :: EventPlayerLoaded( CGamePlayer *player )
 			SendChat( player, m_GHost->m_Language->PleaseWaitPlayersStillLoading( ) );
 	}
 	else
-		SendAll( m_Protocol->SEND_W3GS_GAMELOADED_OTHERS( player->GetPID( ) ) );
+	{
+		CW3GSGameLoadedOthers GameLoaded;
+		GameLoaded.SetByte<4>( player->GetPID( ) );
+		SendAll( GameLoaded.GetData( ), GameLoaded.GetSize( ) );
+	}
 
 	ReCalculateTeams(); //wrong place?
 }
@@ -2795,16 +2897,14 @@ bool CBaseGame :: EventPlayerAction( CGamePlayer *player, CIncomingAction *actio
 		player->SetDeleteMe( true );
 		player->SetLeftReason( "Invalid action packet" );
 		player->SetLeftCode( PLAYERLEAVE_LOST );
-
-		delete action;
 		return false;
 	}
 
-	m_Actions.push( action );
+	m_Actions.Add( *action );
 
 	// check for players saving the game and notify everyone
 
-	if( !action->GetAction( )->empty( ) && (*action->GetAction( ))[0] == 6 )
+	if( action->GetActionLength( ) > 0 && action->GetAction( )[0] == 6 )
 	{
 		CONSOLE_Print( "[GAME: " + m_GameName + "] player [" + player->GetName( ) + "] is saving the game" );
 		SendAllChat( m_GHost->m_Language->PlayerIsSavingTheGame( player->GetName( ) ) );
@@ -3322,7 +3422,7 @@ void CBaseGame :: EventPlayerMapSize( CGamePlayer *player, CIncomingMapSize *map
 
 			// add to database
 
-			m_GHost->m_Callables.push_back( m_GHost->m_DB->ThreadedDownloadAdd( m_Map->GetMapPath( ), MapSize, player->GetName( ), player->GetExternalIPString( ), player->GetSpoofed( ) ? 1 : 0, player->GetSpoofedRealm( ), GetTicks( ) - player->GetStartedDownloadingTicks( ) ) );
+			m_GHost->m_Callables->Add( m_GHost->m_DB->ThreadedDownloadAdd( m_Map->GetMapPath( ), MapSize, player->GetName( ), player->GetExternalIPString( ), player->GetSpoofed( ) ? 1 : 0, player->GetSpoofedRealm( ), GetTicks( ) - player->GetStartedDownloadingTicks( ) ) );
 		}
 	}
 
@@ -3451,6 +3551,8 @@ void CBaseGame :: EventGameStarted( )
 	if( m_SlotInfoChanged )
 		SendAllSlotInfo( );
 
+	FlushSlotInfo( );
+
 	m_StartedLoadingTicks = GetTicks( );
 	m_LastLagScreenResetTime = GetTime( );
 	m_GameLoading = true;
@@ -3458,7 +3560,8 @@ void CBaseGame :: EventGameStarted( )
 	// since we use a fake countdown to deal with leavers during countdown the COUNTDOWN_START and COUNTDOWN_END packets are sent in quick succession
 	// send a start countdown packet
 
-	SendAll( m_Protocol->SEND_W3GS_COUNTDOWN_START( ) );
+	CW3GSCountdownStart CountdownStart;
+	SendAll( CountdownStart.GetData( ), CountdownStart.GetSize( ) );
 
 	// remove the virtual host player
 
@@ -3466,12 +3569,17 @@ void CBaseGame :: EventGameStarted( )
 
 	// send an end countdown packet
 
-	SendAll( m_Protocol->SEND_W3GS_COUNTDOWN_END( ) );
+	CW3GSCountdownEnd CountdownEnd;
+	SendAll( CountdownEnd.GetData( ), CountdownEnd.GetSize( ) );
 
 	// send a game loaded packet for the fake player (if present)
 
 	if( m_FakePlayerPID != 255 )
-		SendAll( m_Protocol->SEND_W3GS_GAMELOADED_OTHERS( m_FakePlayerPID ) );
+	{
+		CW3GSGameLoadedOthers GameLoaded;
+		GameLoaded.SetByte<4>( m_FakePlayerPID );
+		SendAll( GameLoaded.GetData( ), GameLoaded.GetSize( ) );
+	}
 
 	// record the starting number of players
 
@@ -3562,8 +3670,10 @@ void CBaseGame :: EventGameStarted( )
 
 		for( vector<CGamePlayer *> :: iterator i = m_Players.begin( ); i != m_Players.end( ); ++i )
 		{
-			for( vector<CGamePlayer *> :: iterator j = m_Players.begin( ); j != m_Players.end( ); ++j )
-				(*j)->AddLoadInGameData( m_Protocol->SEND_W3GS_GAMELOADED_OTHERS( (*i)->GetPID( ) ) );
+			m_SendFrame.clear( );
+			m_Protocol->WRITE_W3GS_GAMELOADED_OTHERS( m_SendFrame, (*i)->GetPID( ) );
+			m_LoadInGameLog.Add( m_SendFrame );
+			(*i)->SetLoadInGameCursor( m_LoadInGameLog.GetBegin( ) );
 		}
 	}
 
@@ -4251,255 +4361,29 @@ void CBaseGame :: ShuffleSlots( )
 	SendAllSlotInfo( );
 }
 
-vector<unsigned char> CBaseGame :: BalanceSlotsRecursive( vector<unsigned char> PlayerIDs, unsigned char *TeamSizes, double *PlayerScores, unsigned char StartTeam )
+double CBaseGame :: GetBalanceScore( CGamePlayer *player, bool dotaRating )
 {
-	// take a brute force approach to finding the best balance by iterating through every possible combination of players
-	// 1.) since the number of teams is arbitrary this algorithm must be recursive
-	// 2.) on the first recursion step every possible combination of players into two "teams" is checked, where the first team is the correct size and the second team contains everyone else
-	// 3.) on the next recursion step every possible combination of the remaining players into two more "teams" is checked, continuing until all the actual teams are accounted for
-	// 4.) for every possible combination, check the largest difference in total scores between any two actual teams
-	// 5.) minimize this value by choosing the combination of players with the smallest difference
-
-	vector<unsigned char> BestOrdering = PlayerIDs;
-	double BestDifference = -1.0;
+	// we are forced to use a default score because there's no way to balance the teams otherwise
 
-	for( unsigned char i = StartTeam; i < MAX_SLOTS; ++i )
-	{
-		if( TeamSizes[i] > 0 )
-		{
-			unsigned char Mid = TeamSizes[i];
-
-			// the base case where only one actual team worth of players was passed to this function is handled by the behaviour of next_combination
-			// in this case PlayerIDs.begin( ) + Mid will actually be equal to PlayerIDs.end( ) and next_combination will return false
-
-			while( next_combination( PlayerIDs.begin( ), PlayerIDs.begin( ) + Mid, PlayerIDs.end( ) ) )
-			{
-				// we're splitting the players into every possible combination of two "teams" based on the midpoint Mid
-				// the first (left) team contains the correct number of players but the second (right) "team" might or might not
-				// for example, it could contain one, two, or more actual teams worth of players
-				// so recurse using the second "team" as the full set of players to perform the balancing on
+	double Score = dotaRating ? (double)player->GetDotARating( ) : player->GetScore( );
 
-				vector<unsigned char> BestSubOrdering = BalanceSlotsRecursive( vector<unsigned char>( PlayerIDs.begin( ) + Mid, PlayerIDs.end( ) ), TeamSizes, PlayerScores, i + 1 );
+	if( Score < -99999.0 )
+		Score = m_Map->GetMapDefaultPlayerScore( );
 
-				// BestSubOrdering now contains the best ordering of all the remaining players (the "right team") given this particular combination of players into two "teams"
-				// in order to calculate the largest difference in total scores we need to recombine the subordering with the first team
-
-				vector<unsigned char> TestOrdering = vector<unsigned char>( PlayerIDs.begin( ), PlayerIDs.begin( ) + Mid );
-				TestOrdering.insert( TestOrdering.end( ), BestSubOrdering.begin( ), BestSubOrdering.end( ) );
-
-				// now calculate the team scores for all the teams that we know about (e.g. on subsequent recursion steps this will NOT be every possible team)
-
-				vector<unsigned char> :: iterator CurrentPID = TestOrdering.begin( );
-				double TeamScores[MAX_SLOTS];
-
-				for( unsigned char j = StartTeam; j < MAX_SLOTS; ++j )
-				{
-					TeamScores[j] = 0.0;
-
-					for( unsigned char k = 0; k < TeamSizes[j]; ++k )
-					{
-						TeamScores[j] += PlayerScores[*CurrentPID];
-						++CurrentPID;
-					}
-				}
-
-				// find the largest difference in total scores between any two teams
-
-				double LargestDifference = 0.0;
-
-				for( unsigned char j = StartTeam; j < MAX_SLOTS; ++j )
-				{
-					if( TeamSizes[j] > 0 )
-					{
-						for( unsigned char k = j + 1; k < MAX_SLOTS; ++k )
-						{
-							if( TeamSizes[k] > 0 )
-							{
-								double Difference = abs( TeamScores[j] - TeamScores[k] );
-
-								if( Difference > LargestDifference )
-									LargestDifference = Difference;
-							}
-						}
-					}
-				}
-
-				// and minimize it
-
-				if( BestDifference < 0.0 || LargestDifference < BestDifference )
-				{
-					BestOrdering = TestOrdering;
-					BestDifference = LargestDifference;
-				}
-			}
-		}
-	}
-
-	return BestOrdering;
+	return Score;
 }
 
-
-void CBaseGame::BalanceSlots()
+void CBaseGame :: BalanceSlots( )
 {
-	if (!(m_Map->GetMapOptions() & MAPOPT_FIXEDPLAYERSETTINGS))
-	{
-		CONSOLE_Print("[GAME: " + m_GameName + "] error balancing slots - can't balance slots without fixed player settings");
-		return;
-	}
-
-	// setup the necessary variables for the balancing algorithm
-	// use an array of 13 elements for MAX_SLOTS players because GHost++ allocates PID's from 1-MAX_SLOTS (i.e. excluding 0) and we use the PID to index the array
-
-	vector<unsigned char> PlayerIDs;
-	unsigned char TeamSizes[MAX_SLOTS];
-	double PlayerScores[13];
-	memset(TeamSizes, 0, sizeof(unsigned char) * MAX_SLOTS);
-
-	for (vector<CGamePlayer*> ::iterator i = m_Players.begin(); i != m_Players.end(); ++i)
-	{
-		unsigned char PID = (*i)->GetPID();
-
-		if (PID < 13)
-		{
-			unsigned char SID = GetSIDFromPID(PID);
-
-			if (SID < m_Slots.size())
-			{
-				unsigned char Team = m_Slots[SID].GetTeam();
-
-				if (Team < MAX_SLOTS)
-				{
-					// we are forced to use a default score because there's no way to balance the teams otherwise
-
-					double Score = (*i)->GetScore();
-
-					if (Score < -99999.0)
-						Score = m_Map->GetMapDefaultPlayerScore();
-
-					PlayerIDs.push_back(PID);
-					TeamSizes[Team]++;
-					PlayerScores[PID] = Score;
-				}
-			}
-		}
-	}
-
-	sort(PlayerIDs.begin(), PlayerIDs.end());
-
-	// balancing the teams is a variation of the bin packing problem which is NP
-	// we can have up to MAX_SLOTS players and/or teams so the scope of the problem is sometimes small enough to process quickly
-	// let's try to figure out roughly how much work this is going to take
-	// examples:
-	//  2 teams of 4 =     70 ~    5ms *** ok
-	//  2 teams of 5 =    252 ~    5ms *** ok
-	//  2 teams of 6 =    924 ~   20ms *** ok
-	//  3 teams of 2 =     90 ~    5ms *** ok
-	//  3 teams of 3 =   1680 ~   25ms *** ok
-	//  3 teams of 4 =  34650 ~  250ms *** will cause a lag spike
-	//  4 teams of 2 =   2520 ~   30ms *** ok
-	//  4 teams of 3 = 369600 ~ 3500ms *** unacceptable
-
-	uint32_t AlgorithmCost = 0;
-	uint32_t PlayersLeft = PlayerIDs.size();
-
-	for (unsigned char i = 0; i < MAX_SLOTS; ++i)
-	{
-		if (TeamSizes[i] > 0)
-		{
-			if (AlgorithmCost == 0)
-				AlgorithmCost = nCr(PlayersLeft, TeamSizes[i]);
-			else
-				AlgorithmCost *= nCr(PlayersLeft, TeamSizes[i]);
-
-			PlayersLeft -= TeamSizes[i];
-		}
-	}
-
-	if (AlgorithmCost > 40000)
-	{
-		// the cost is too high, don't run the algorithm
-		// a possible alternative: stop after enough iterations and/or time has passed
-
-		CONSOLE_Print("[GAME: " + m_GameName + "] shuffling slots instead of balancing - the algorithm is too slow (with a cost of " + UTIL_ToString(AlgorithmCost) + ") for this team configuration");
-		SendAllChat(m_GHost->m_Language->ShufflingPlayers());
-		ShuffleSlots();
-		return;
-	}
-
-	uint32_t StartTicks = GetTicks();
-	vector<unsigned char> BestOrdering = BalanceSlotsRecursive(PlayerIDs, TeamSizes, PlayerScores, 0);
-	uint32_t EndTicks = GetTicks();
-
-	// the BestOrdering assumes the teams are in slot order although this may not be the case
-	// so put the players on the correct teams regardless of slot order
-
-	vector<unsigned char> ::iterator CurrentPID = BestOrdering.begin();
-
-	for (unsigned char i = 0; i < MAX_SLOTS; ++i)
-	{
-		unsigned char CurrentSlot = 0;
-
-		for (unsigned char j = 0; j < TeamSizes[i]; ++j)
-		{
-			while (CurrentSlot < m_Slots.size() && m_Slots[CurrentSlot].GetTeam() != i)
-				++CurrentSlot;
-
-			// put the CurrentPID player on team i by swapping them into CurrentSlot
-
-			unsigned char SID1 = CurrentSlot;
-			unsigned char SID2 = GetSIDFromPID(*CurrentPID);
-
-			if (SID1 < m_Slots.size() && SID2 < m_Slots.size())
-			{
-				CGameSlot Slot1 = m_Slots[SID1];
-				CGameSlot Slot2 = m_Slots[SID2];
-				m_Slots[SID1] = CGameSlot(Slot2.GetPID(), Slot2.GetDownloadStatus(), Slot2.GetSlotStatus(), Slot2.GetComputer(), Slot1.GetTeam(), Slot1.GetColour(), Slot1.GetRace());
-				m_Slots[SID2] = CGameSlot(Slot1.GetPID(), Slot1.GetDownloadStatus(), Slot1.GetSlotStatus(), Slot1.GetComputer(), Slot2.GetTeam(), Slot2.GetColour(), Slot2.GetRace());
-			}
-			else
-			{
-				CONSOLE_Print("[GAME: " + m_GameName + "] shuffling slots instead of balancing - the balancing algorithm tried to do an invalid swap (this shouldn't happen)");
-				SendAllChat(m_GHost->m_Language->ShufflingPlayers());
-				ShuffleSlots();
-				return;
-			}
-
-			++CurrentPID;
-			++CurrentSlot;
-		}
-	}
-
-	CONSOLE_Print("[GAME: " + m_GameName + "] balancing slots completed in " + UTIL_ToString(EndTicks - StartTicks) + "ms (with a cost of " + UTIL_ToString(AlgorithmCost) + ")");
-	SendAllChat(m_GHost->m_Language->BalancingSlotsCompleted());
-	SendAllSlotInfo();
-
-	for (unsigned char i = 0; i < MAX_SLOTS; ++i)
-	{
-		bool TeamHasPlayers = false;
-		double TeamScore = 0.0;
-
-		for (vector<CGamePlayer*> ::iterator j = m_Players.begin(); j != m_Players.end(); ++j)
-		{
-			unsigned char SID = GetSIDFromPID((*j)->GetPID());
-
-			if (SID < m_Slots.size() && m_Slots[SID].GetTeam() == i)
-			{
-				TeamHasPlayers = true;
-				double Score = (*j)->GetScore();
-
-				if (Score < -99999.0)
-					Score = m_Map->GetMapDefaultPlayerScore();
-
-				TeamScore += Score;
-			}
-		}
-
-		if (TeamHasPlayers)
-			SendAllChat(m_GHost->m_Language->TeamCombinedScore(UTIL_ToString(i + 1), UTIL_ToString(TeamScore, 2)));
-	}
+	BalanceSlotsByScore( false );
 }
 
 void CBaseGame :: BalanceSlotsNew( )
+{
+	BalanceSlotsByScore( true );
+}
+
+void CBaseGame :: BalanceSlotsByScore( bool dotaRating )
 {
 	if( !( m_Map->GetMapOptions( ) & MAPOPT_FIXEDPLAYERSETTINGS ) )
 	{
@@ -4508,91 +4392,77 @@ void CBaseGame :: BalanceSlotsNew( )
 	}
 
 	// setup the necessary variables for the balancing algorithm
-	// use an array of 13 elements for MAX_SLOTS players because GHost++ allocates PID's from 1-MAX_SLOTS (i.e. excluding 0) and we use the PID to index the array
+	// the balancer works on player indexes rather than PID's so PlayerIDs[i] is the PID of the player with score PlayerScores[i]
 
 	vector<unsigned char> PlayerIDs;
+	vector<unsigned char> PlayerTeams;
 	unsigned char TeamSizes[MAX_SLOTS];
-	double PlayerScores[13];
+	double PlayerScores[MAX_SLOTS];
 	memset( TeamSizes, 0, sizeof( unsigned char ) * MAX_SLOTS );
 
 	for( vector<CGamePlayer *> :: iterator i = m_Players.begin( ); i != m_Players.end( ); ++i )
 	{
 		unsigned char PID = (*i)->GetPID( );
+		unsigned char SID = GetSIDFromPID( PID );
 
-		if( PID < 13 )
+		if( SID < m_Slots.size( ) && PlayerIDs.size( ) < MAX_SLOTS )
 		{
-			unsigned char SID = GetSIDFromPID( PID );
+			unsigned char Team = m_Slots[SID].GetTeam( );
 
-			if( SID < m_Slots.size( ) )
+			if( Team < MAX_SLOTS )
 			{
-				unsigned char Team = m_Slots[SID].GetTeam( );
-
-				if( Team < MAX_SLOTS )
-				{
-					// we are forced to use a default score because there's no way to balance the teams otherwise
-
-					double Score = (*i)->GetDotARating( );
-
-					if( Score < -99999.0 )
-						Score = m_Map->GetMapDefaultPlayerScore( );
-
-					PlayerIDs.push_back( PID );
-					TeamSizes[Team]++;
-					PlayerScores[PID] = Score;
-				}
+				PlayerScores[PlayerIDs.size( )] = GetBalanceScore( *i, dotaRating );
+				PlayerIDs.push_back( PID );
+				TeamSizes[Team]++;
 			}
 		}
 	}
 
-	sort( PlayerIDs.begin( ), PlayerIDs.end( ) );
+	// the balancer only wants to know about teams with players on them
 
-	// balancing the teams is a variation of the bin packing problem which is NP
-	// we can have up to MAX_SLOTS players and/or teams so the scope of the problem is sometimes small enough to process quickly
-	// let's try to figure out roughly how much work this is going to take
-	// examples:
-	//  2 teams of 4 =     70 ~    5ms *** ok
-	//  2 teams of 5 =    252 ~    5ms *** ok
-	//  2 teams of 6 =    924 ~   20ms *** ok
-	//  3 teams of 2 =     90 ~    5ms *** ok
-	//  3 teams of 3 =   1680 ~   25ms *** ok
-	//  3 teams of 4 =  34650 ~  250ms *** will cause a lag spike
-	//  4 teams of 2 =   2520 ~   30ms *** ok
-	//  4 teams of 3 = 369600 ~ 3500ms *** unacceptable
-
-	uint32_t AlgorithmCost = 0;
-	uint32_t PlayersLeft = PlayerIDs.size( );
+	unsigned char BalanceTeamSizes[MAX_SLOTS];
+	uint32_t NumTeams = 0;
 
 	for( unsigned char i = 0; i < MAX_SLOTS; ++i )
 	{
 		if( TeamSizes[i] > 0 )
 		{
-			if( AlgorithmCost == 0 )
-				AlgorithmCost = nCr( PlayersLeft, TeamSizes[i] );
-			else
-				AlgorithmCost *= nCr( PlayersLeft, TeamSizes[i] );
-
-			PlayersLeft -= TeamSizes[i];
+			BalanceTeamSizes[NumTeams] = TeamSizes[i];
+			++NumTeams;
 		}
 	}
 
-	if( AlgorithmCost > 40000 )
-	{
-		// the cost is too high, don't run the algorithm
-		// a possible alternative: stop after enough iterations and/or time has passed
+	// balancing the teams is a variation of the bin packing problem which is NP
+	// the balancer stops after a fixed amount of work and keeps the best teams found so far so it can't cause a lag spike even with 4 teams of 3
+
+	CTeamBalancer Balancer;
+	uint32_t StartTicks = GetTicks( );
 
-		CONSOLE_Print( "[GAME: " + m_GameName + "] shuffling slots instead of balancing - the algorithm is too slow (with a cost of " + UTIL_ToString( AlgorithmCost ) + ") for this team configuration" );
-		SendAllChat( m_GHost->m_Language->ShufflingPlayers( ) );
-		ShuffleSlots( );
+	if( !Balancer.Balance( PlayerScores, PlayerIDs.size( ), BalanceTeamSizes, NumTeams ) )
+	{
+		CONSOLE_Print( "[GAME: " + m_GameName + "] error balancing slots - there are no players to balance" );
 		return;
 	}
 
-	uint32_t StartTicks = GetTicks( );
-	vector<unsigned char> BestOrdering = BalanceSlotsRecursive( PlayerIDs, TeamSizes, PlayerScores, 0 );
 	uint32_t EndTicks = GetTicks( );
 
-	// the BestOrdering assumes the teams are in slot order although this may not be the case
+	// BestOrdering contains the PID's of team 0 followed by the PID's of team 1 and so on
+	// it assumes the teams are in slot order although this may not be the case
 	// so put the players on the correct teams regardless of slot order
 
+	vector<unsigned char> BestOrdering;
+
+	for( uint32_t i = 0; i < NumTeams; ++i )
+	{
+		uint16_t Team = Balancer.GetTeam( i );
+
+		for( uint32_t j = 0; j < PlayerIDs.size( ); ++j )
+		{
+			if( Team & ( 1 << j ) )
+				BestOrdering.push_back( PlayerIDs[j] );
+		}
+	}
+
 	vector<unsigned char> :: iterator CurrentPID = BestOrdering.begin( );
 
 	for( unsigned char i = 0; i < MAX_SLOTS; ++i )
@@ -4629,7 +4499,7 @@ void CBaseGame :: BalanceSlotsNew( )
 		}
 	}
 
-	CONSOLE_Print( "[GAME: " + m_GameName + "] balancing slots completed in " + UTIL_ToString( EndTicks - StartTicks ) + "ms (with a cost of " + UTIL_ToString( AlgorithmCost ) + ")" );
+	CONSOLE_Print( "[GAME: " + m_GameName + "] balancing slots completed in " + UTIL_ToString( EndTicks - StartTicks ) + "ms (" + UTIL_ToString( Balancer.GetNodes( ) ) + " nodes, " + ( Balancer.GetComplete( ) ? "optimal" : "best found within budget" ) + ", spread " + UTIL_ToString( Balancer.GetSpread( ), 2 ) + ")" );
 	SendAllChat( m_GHost->m_Language->BalancingSlotsCompleted( ) );
 	SendAllSlotInfo( );
 
@@ -4645,12 +4515,7 @@ void CBaseGame :: BalanceSlotsNew( )
 			if( SID < m_Slots.size( ) && m_Slots[SID].GetTeam( ) == i )
 			{
 				TeamHasPlayers = true;
-				double Score = (*j)->GetDotARating( );
-
-				if( Score < -99999.0 )
-					Score = m_Map->GetMapDefaultPlayerScore( );
-
-				TeamScore += Score;
+				TeamScore += GetBalanceScore( *j, dotaRating );
 			}
 		}
 
@@ -5092,11 +4957,11 @@ void CBaseGame::TestDotaSubmit(CGHost* GHost, CGHostDB* DB, uint32_t GameID)
 				CONSOLE_Print("[STATSDOTANEW!: " + m_Game_GetGameName + "] saving " + UTIL_ToString(Players) + " players");
 				CDBDotAGame* DotaGame = new CDBDotAGame(0, 0, m_Winner, m_Min, m_Sec);
 				string serverName = string();
-				GHost->m_Callables.push_back(DB->ThreadedDotAPlayerStatsUpdate(serverName, playerNames[i], m_Players[i], DotaGame, 1500, m_Players[i]->GetNewColour() > 5 ? teamsAvgRating[0] : teamsAvgRating[1])); //Player->GetSpoofedRealm() should be the entered as servername param
+				GHost->m_Callables->Add(DB->ThreadedDotAPlayerStatsUpdate(serverName, playerNames[i], m_Players[i], DotaGame, 1500, m_Players[i]->GetNewColour() > 5 ? teamsAvgRating[0] : teamsAvgRating[1])); //Player->GetSpoofedRealm() should be the entered as servername param
 
 			}
 
-			//back!!  GHost->m_Callables.push_back(DB->ThreadedDotAPlayerAdd(GameID, m_Players[i]->GetColour(), m_Players[i]->GetKills(), m_Players[i]->GetDeaths(), m_Players[i]->GetCreepKills(), m_Players[i]->GetCreepDenies(), m_Players[i]->GetAssists(), m_Players[i]->GetGold(), m_Players[i]->GetNeutralKills(), m_Players[i]->GetItem(0), m_Players[i]->GetItem(1), m_Players[i]->GetItem(2), m_Players[i]->GetItem(3), m_Players[i]->GetItem(4), m_Players[i]->GetItem(5), m_Players[i]->GetHero(), m_Players[i]->GetNewColour(), m_Players[i]->GetTowerKills(), m_Players[i]->GetRaxKills(), m_Players[i]->GetCourierKills()));
+			//back!!  GHost->m_Callables->Add(DB->ThreadedDotAPlayerAdd(GameID, m_Players[i]->GetColour(), m_Players[i]->GetKills(), m_Players[i]->GetDeaths(), m_Players[i]->GetCreepKills(), m_Players[i]->GetCreepDenies(), m_Players[i]->GetAssists(), m_Players[i]->GetGold(), m_Players[i]->GetNeutralKills(), m_Players[i]->GetItem(0), m_Players[i]->GetItem(1), m_Players[i]->GetItem(2), m_Players[i]->GetItem(3), m_Players[i]->GetItem(4), m_Players[i]->GetItem(5), m_Players[i]->GetHero(), m_Players[i]->GetNewColour(), m_Players[i]->GetTowerKills(), m_Players[i]->GetRaxKills(), m_Players[i]->GetCourierKills()));
 
 			++Players;
 		}
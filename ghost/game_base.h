@@ -22,6 +22,9 @@
 #define GAME_BASE_H
 
 #include "gameslot.h"
+#include "gameprotocol.h"
+
+#include <boost/shared_ptr.hpp>
 
 //
 // CBaseGame
@@ -39,7 +42,10 @@ class CIncomingAction;
 class CIncomingChatPlayer;
 class CIncomingMapSize;
 class CCallableScoreCheck;
-struct QueuedSpoofAdd;
+class CCommandLimiter;
+struct GProxyReconnector;
+struct CGameMessage;
+template <class T> class CMailbox;
 
 class CBaseGame
 {
@@ -52,11 +58,15 @@ protected:
 	vector<CGameSlot> m_Slots;						// vector of slots
 	vector<CPotentialPlayer *> m_Potentials;		// vector of potential players (connections that haven't sent a W3GS_REQJOIN packet yet)
 	vector<CGamePlayer *> m_Players;				// vector of players
-	vector<CCallableScoreCheck *> m_ScoreChecks;
-	queue<CIncomingAction *> m_Actions;				// queue of actions to be sent
+	CWakeSocket *m_WakeSocket;						// wakes up the game thread when a database callable completes or a message is posted
+	CCallableInbox *m_Callables;					// database callables owned by this game
+	CMailbox<CGameMessage> *m_Mailbox;				// messages posted to this game by other threads, see the Post functions
+	CCommandLimiter *m_CommandLimiter;				// per player rate limits for bot commands
+	CActionArena m_Actions;							// actions to be sent in the next action tick
+	CLoadInGameLog m_LoadInGameLog;					// packets buffered for the players still loading the map when using "load in game"
+	BYTEARRAY m_SendFrame;							// reused for packets that are written and sent straight away so they don't need a new array every time
 	vector<string> m_Reserved;						// vector of player names with reserved slots (from the !hold command)
 	set<string> m_IgnoredNames;						// set of player names to NOT print ban messages for when joining because they've already been printed
-	set<string> m_IPBlackList;						// set of IP addresses to blacklist from joining (todotodo: convert to uint32's for efficiency)
 	vector<CGameSlot> m_EnforceSlots;				// vector of slots to force players to use (used with saved games)
 	vector<PIDPlayer> m_EnforcePlayers;				// vector of pids to force players to use (used with saved games)
 	CMap *m_Map;									// map data
@@ -83,6 +93,9 @@ protected:
 	uint32_t m_RandomSeed;							// the random seed sent to the Warcraft III clients
 	uint32_t m_HostCounter;							// a unique game number
 	uint32_t m_EntryKey;							// random entry key for LAN, used to prove that a player is actually joining from LAN
+	BYTEARRAY m_LANGameInfo;						// cached W3GS_GAMEINFO packet for LAN, only the slots open and uptime fields are patched before each send
+	string m_LANGameInfoName;						// game name the cached W3GS_GAMEINFO packet was built for
+	uint32_t m_LANGameInfoHostCounter;				// host counter the cached W3GS_GAMEINFO packet was built for
 	uint32_t m_Latency;								// the number of ms to wait between sending action packets (we queue any received during this time)
 	uint32_t m_SyncLimit;							// the maximum number of packets a player can fall out of sync before starting the lag screen
 	uint32_t m_SyncCounter;							// the number of actions sent so far (for determining if anyone is lagging)
@@ -115,7 +128,11 @@ protected:
 	uint32_t m_LastCurrentGameLiveUpdateTime;
 	double m_MinimumScore;							// the minimum allowed score for matchmaking mode
 	double m_MaximumScore;							// the maximum allowed score for matchmaking mode
-	bool m_SlotInfoChanged;							// if the slot info has changed and hasn't been sent to the players yet (optimization)
+	bool m_SlotInfoChanged;							// if a download status has changed and the slot info hasn't been updated yet (optimization)
+	uint32_t m_SlotInfoVersion;						// incremented by SendAllSlotInfo every time the slots change
+	uint32_t m_SlotInfoSentVersion;					// the slot info version which was last sent to the players
+	uint32_t m_LastSlotInfoFlushTicks;				// GetTicks when the slot info was last flushed
+	BYTEARRAY m_SlotInfo;							// the last W3GS_SLOTINFO packet sent to the players
 	bool m_Locked;									// if the game owner is the only one allowed to run game commands or not
 	bool m_RefreshMessages;							// if we should display "game refreshed..." messages or not
 	bool m_RefreshError;							// if there was an error refreshing the game
@@ -132,6 +149,7 @@ protected:
 	bool m_LocalAdminMessages;						// if local admin messages should be relayed or not
 	int m_DoDelete;									// notifies thread to exit
 	uint32_t m_LastReconnectHandleTime;				// last time we tried to handle GProxy reconnects
+	vector<boost::shared_ptr<GProxyReconnector> > m_PendingReconnects;	// GProxy reconnects posted to this game which haven't matched a player yet
 	//New
 	uint32_t m_LagScreenTime;						// GetTime when the last lag screen was activated
 	uint32_t m_GameLoadedTime;						// GetTime when the game was loaded
@@ -141,10 +159,6 @@ protected:
 	bool m_IsLadderGame;
 
 public:
-	vector<string> m_DoSayGames;					// vector of strings we should announce to the current game
-	boost::mutex m_SayGamesMutex;					// mutex for the above vector
-	vector<QueuedSpoofAdd> m_DoSpoofAdd;			// vector of spoof add function call structures
-	boost::mutex m_SpoofAddMutex;
 	vector<string> m_AutoBanTemp;
 	//New
 	string m_MapFileName;
@@ -220,10 +234,11 @@ public:
 
 	// generic functions to send packets to players
 
-	virtual void Send( CGamePlayer *player, BYTEARRAY data );
-	virtual void Send( unsigned char PID, BYTEARRAY data );
-	virtual void Send( BYTEARRAY PIDs, BYTEARRAY data );
-	virtual void SendAll( BYTEARRAY data );
+	virtual void Send( CGamePlayer *player, const BYTEARRAY &data );
+	virtual void Send( unsigned char PID, const BYTEARRAY &data );
+	virtual void Send( BYTEARRAY PIDs, const BYTEARRAY &data );
+	virtual void SendAll( const BYTEARRAY &data );
+	virtual void SendAll( const unsigned char *data, uint32_t length );
 
 	// functions to send packets to players
 
@@ -235,9 +250,20 @@ public:
 	virtual void SendAllChat( string message );
 	virtual void SendLocalAdminChat( string message );
 	virtual void SendAllSlotInfo( );
+	virtual void FlushSlotInfo( );
+	virtual BYTEARRAY GetLANGameInfo( );
+
+	// functions other threads use to talk to the game (the caller must hold m_GHost->m_GamesMutex so the game can't be deleted underneath it)
+
+	virtual void PostSayGame( string message );
+	virtual void PostSpoofAdd( string server, string name, bool sendMessage, string failMessage );
+	virtual void PostReconnect( boost::shared_ptr<GProxyReconnector> reconnector );
+	virtual void ProcessMessages( );
+	virtual void ProcessReconnects( );
 	virtual void SendVirtualHostPlayerInfo( CGamePlayer *player );
 	virtual void SendFakePlayerInfo( CGamePlayer *player );
 	virtual void SendAllActions( );
+	virtual void SendLoadInGameLog( CGamePlayer *player );
 	virtual void SendWelcomeMessage( CGamePlayer *player );
 	virtual void SendEndMessage( );
 
@@ -252,6 +278,7 @@ public:
 	virtual void EventPlayerDisconnectConnectionClosed( CGamePlayer *player );
 	virtual void EventPlayerJoined( CPotentialPlayer *potential, CIncomingJoinPlayer *joinPlayer );
 	virtual void EventPlayerJoinedWithScore( CPotentialPlayer *potential, CIncomingJoinPlayer *joinPlayer, double score );
+	virtual void EventCallableScoreCheck( CCallableScoreCheck *callable );
 	virtual void EventPlayerLeft( CGamePlayer *player, uint32_t reason );
 	virtual void EventPlayerLoaded( CGamePlayer *player );
 	virtual bool EventPlayerAction( CGamePlayer *player, CIncomingAction *action );
@@ -295,9 +322,10 @@ public:
 	virtual void OpenAllSlots( );
 	virtual void CloseAllSlots( );
 	virtual void ShuffleSlots( );
-	virtual vector<unsigned char> BalanceSlotsRecursive( vector<unsigned char> PlayerIDs, unsigned char *TeamSizes, double *PlayerScores, unsigned char StartTeam );
+	virtual double GetBalanceScore( CGamePlayer *player, bool dotaRating );
 	virtual void BalanceSlots( );
 	virtual void BalanceSlotsNew( ); //New
+	virtual void BalanceSlotsByScore( bool dotaRating );
 	virtual void AddToSpoofed( string server, string name, bool sendMessage );
 	virtual void AddToReserved( string name );
 	virtual bool IsOwner( string name );
@@ -320,11 +348,24 @@ public:
 
 };
 
-struct QueuedSpoofAdd {
-	string server;
-	string name;
-	bool sendMessage;
-	string failMessage; //empty if no failure
+//
+// CGameMessage
+//
+
+#define GAMEMESSAGE_SAYGAME				1	// announce m_Message to the game
+#define GAMEMESSAGE_SPOOFADD			2	// spoof check m_Name on m_Server (or announce m_Message if the spoof check failed)
+#define GAMEMESSAGE_RECONNECT			3	// a GProxy++ player is trying to reconnect to a game
+
+struct CGameMessage
+{
+	unsigned char m_Type;
+	string m_Server;
+	string m_Name;
+	bool m_SendMessage;
+	string m_Message;
+	boost::shared_ptr<GProxyReconnector> m_Reconnector;
+
+	CGameMessage( unsigned char nType ) : m_Type( nType ), m_SendMessage( false ) { }
 };
 
 #endif
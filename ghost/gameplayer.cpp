@@ -180,12 +180,18 @@ void CPotentialPlayer::ProcessPackets()
 	}
 }
 
-void CPotentialPlayer::Send(BYTEARRAY data)
+void CPotentialPlayer::Send(const BYTEARRAY& data)
 {
 	if (m_Socket)
 		m_Socket->PutBytes(data);
 }
 
+void CPotentialPlayer::Send(const unsigned char* data, uint32_t length)
+{
+	if (m_Socket)
+		m_Socket->PutBytes(data, length);
+}
+
 //
 // CGamePlayer
 //
@@ -208,9 +214,8 @@ CGamePlayer::CGamePlayer(CGameProtocol* nProtocol, CBaseGame* nGame, CTCPSocket*
 	m_FinishedDownloadingTime = 0;
 	m_FinishedLoadingTicks = 0;
 	m_StartedLaggingTicks = 0;
-	m_StatsSentTime = 0;
-	m_StatsDotASentTime = 0;
 	m_LastGProxyWaitNoticeSentTime = 0;
+	m_LoadInGameCursor = 0;
 	m_Score = -100000.0;
 	m_LoggedIn = false;
 	m_Spoofed = false;
@@ -260,9 +265,8 @@ CGamePlayer::CGamePlayer(CPotentialPlayer* potential, unsigned char nPID, string
 	m_FinishedDownloadingTime = 0;
 	m_FinishedLoadingTicks = 0;
 	m_StartedLaggingTicks = 0;
-	m_StatsSentTime = 0;
-	m_StatsDotASentTime = 0;
 	m_LastGProxyWaitNoticeSentTime = 0;
+	m_LoadInGameCursor = 0;
 	m_Score = -100000.0;
 	m_LoggedIn = false;
 	m_Spoofed = false;
@@ -343,12 +347,12 @@ bool CGamePlayer::Update(void* fd)
 				if (m_Game->GetGameState() == GAME_PUBLIC)
 				{
 					if ((*i)->GetPasswordHashType() == "pvpgn")
-						(*i)->QueueChatCommand("/whereis " + m_Name);
+						(*i)->PostChatCommand("/whereis " + m_Name, string(), false);
 					else
-						(*i)->QueueChatCommand("/whois " + m_Name);
+						(*i)->PostChatCommand("/whois " + m_Name, string(), false);
 				}
 				else if (m_Game->GetGameState() == GAME_PRIVATE)
-					(*i)->QueueChatCommand(m_Game->m_GHost->m_Language->SpoofCheckByReplying(), m_Name, true);
+					(*i)->PostChatCommand(m_Game->m_GHost->m_Language->SpoofCheckByReplying(), m_Name, true);
 			}
 		}
 
@@ -466,7 +470,7 @@ void CGamePlayer::ProcessPackets()
 	if (!m_Socket)
 		return;
 
-	CIncomingAction* Action = NULL;
+	CIncomingAction Action;
 	CIncomingChatPlayer* ChatPlayer = NULL;
 	CIncomingMapSize* MapSize = NULL;
 	bool HasMap = false;
@@ -506,13 +510,10 @@ void CGamePlayer::ProcessPackets()
 				break;
 
 			case CGameProtocol::W3GS_OUTGOING_ACTION:
-				Action = m_Protocol->RECEIVE_W3GS_OUTGOING_ACTION(Packet->GetData(), m_PID);
+				// Action points into the packet data so it has to be handled before the packet is deleted, the game copies it if it accepts it
 
-				if (Action)
-				{
-					// don't delete Action here because the game is going to store it in a queue and delete it later
-					m_Game->EventPlayerAction(this, Action);
-				}
+				if (m_Protocol->RECEIVE_W3GS_OUTGOING_ACTION(Packet->GetData(), m_PID, Action))
+					m_Game->EventPlayerAction(this, &Action);
 
 				break;
 
@@ -631,7 +632,7 @@ void CGamePlayer::ProcessPackets()
 	}
 }
 
-void CGamePlayer::Send(BYTEARRAY data)
+void CGamePlayer::Send(const BYTEARRAY& data)
 {
 	// must start counting packet total from beginning of connection
 	// but we can avoid buffering packets until we know the client is using GProxy++ since that'll be determined before the game starts
@@ -645,6 +646,19 @@ void CGamePlayer::Send(BYTEARRAY data)
 	CPotentialPlayer::Send(data);
 }
 
+void CGamePlayer::Send(const unsigned char* data, uint32_t length)
+{
+	// same as above but for packets that aren't stored in a BYTEARRAY (e.g. a CW3GSFixedPacket on the stack)
+	// only the GProxy++ buffer needs its own copy
+
+	++m_TotalPacketsSent;
+
+	if (m_GProxy && m_Game->GetGameLoaded())
+		m_GProxyBuffer.push(BYTEARRAY(data, data + length));
+
+	CPotentialPlayer::Send(data, length);
+}
+
 void CGamePlayer::EventGProxyReconnect(CTCPSocket* NewSocket, uint32_t LastPacket)
 {
 	delete m_Socket;
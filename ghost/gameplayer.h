@@ -74,7 +74,8 @@ public:
 
 	// other functions
 
-	virtual void Send(BYTEARRAY data);
+	virtual void Send(const BYTEARRAY& data);
+	virtual void Send(const unsigned char* data, uint32_t length);
 };
 
 //
@@ -104,10 +105,8 @@ private:
 	uint32_t m_FinishedDownloadingTime;			// GetTime when the player finished downloading the map
 	uint32_t m_FinishedLoadingTicks;			// GetTicks when the player finished loading the game
 	uint32_t m_StartedLaggingTicks;				// GetTicks when the player started lagging
-	uint32_t m_StatsSentTime;					// GetTime when we sent this player's stats to the chat (to prevent players from spamming !stats)
-	uint32_t m_StatsDotASentTime;				// GetTime when we sent this player's dota stats to the chat (to prevent players from spamming !statsdota)
 	uint32_t m_LastGProxyWaitNoticeSentTime;
-	queue<BYTEARRAY> m_LoadInGameData;			// queued data to be sent when the player finishes loading when using "load in game"
+	uint32_t m_LoadInGameCursor;				// position in the game's CLoadInGameLog of the next packet to send when the player finishes loading when using "load in game"
 	double m_Score;								// the player's generic "score" for the matchmaking algorithm
 	bool m_LoggedIn;							// if the player has logged in or not (used with CAdminGame only)
 	bool m_Spoofed;								// if the player has spoof checked or not
@@ -155,10 +154,8 @@ public:
 	uint32_t GetFinishedDownloadingTime() { return m_FinishedDownloadingTime; }
 	uint32_t GetFinishedLoadingTicks() { return m_FinishedLoadingTicks; }
 	uint32_t GetStartedLaggingTicks() { return m_StartedLaggingTicks; }
-	uint32_t GetStatsSentTime() { return m_StatsSentTime; }
-	uint32_t GetStatsDotASentTime() { return m_StatsDotASentTime; }
 	uint32_t GetLastGProxyWaitNoticeSentTime() { return m_LastGProxyWaitNoticeSentTime; }
-	queue<BYTEARRAY>* GetLoadInGameData() { return &m_LoadInGameData; }
+	uint32_t GetLoadInGameCursor() { return m_LoadInGameCursor; }
 	double GetScore() { return m_Score; }
 	bool GetLoggedIn() { return m_LoggedIn; }
 	bool GetSpoofed() { return m_Spoofed; }
@@ -192,8 +189,6 @@ public:
 	void SetStartedDownloadingTicks(uint32_t nStartedDownloadingTicks) { m_StartedDownloadingTicks = nStartedDownloadingTicks; }
 	void SetFinishedDownloadingTime(uint32_t nFinishedDownloadingTime) { m_FinishedDownloadingTime = nFinishedDownloadingTime; }
 	void SetStartedLaggingTicks(uint32_t nStartedLaggingTicks) { m_StartedLaggingTicks = nStartedLaggingTicks; }
-	void SetStatsSentTime(uint32_t nStatsSentTime) { m_StatsSentTime = nStatsSentTime; }
-	void SetStatsDotASentTime(uint32_t nStatsDotASentTime) { m_StatsDotASentTime = nStatsDotASentTime; }
 	void SetLastGProxyWaitNoticeSentTime(uint32_t nLastGProxyWaitNoticeSentTime) { m_LastGProxyWaitNoticeSentTime = nLastGProxyWaitNoticeSentTime; }
 	void SetScore(double nScore) { m_Score = nScore; }
 	void SetLoggedIn(bool nLoggedIn) { m_LoggedIn = nLoggedIn; }
@@ -216,7 +211,7 @@ public:
 	string GetNameTerminated();
 	uint32_t GetPing(bool LCPing);
 
-	void AddLoadInGameData(BYTEARRAY nLoadInGameData) { m_LoadInGameData.push(nLoadInGameData); }
+	void SetLoadInGameCursor(uint32_t nLoadInGameCursor) { m_LoadInGameCursor = nLoadInGameCursor; }
 
 	// processing functions
 
@@ -226,7 +221,8 @@ public:
 
 	// other functions
 
-	virtual void Send(BYTEARRAY data);
+	virtual void Send(const BYTEARRAY& data);
+	virtual void Send(const unsigned char* data, uint32_t length);
 	virtual void EventGProxyReconnect(CTCPSocket* NewSocket, uint32_t LastPacket);
 };
 
@@ -105,7 +105,7 @@ bool CGameProtocol :: RECEIVE_W3GS_GAMELOADED_SELF( BYTEARRAY data )
 	return false;
 }
 
-CIncomingAction *CGameProtocol :: RECEIVE_W3GS_OUTGOING_ACTION( BYTEARRAY data, unsigned char PID )
+bool CGameProtocol :: RECEIVE_W3GS_OUTGOING_ACTION( const BYTEARRAY &data, unsigned char PID, CIncomingAction &action )
 {
 	// DEBUG_Print( "RECEIVED W3GS_OUTGOING_ACTION" );
 	// DEBUG_Print( data );
@@ -115,14 +115,15 @@ CIncomingAction *CGameProtocol :: RECEIVE_W3GS_OUTGOING_ACTION( BYTEARRAY data,
 	// 4 bytes					-> CRC
 	// remainder of packet		-> Action
 
+	// the action points into data, nothing is copied here
+
 	if( PID != 255 && ValidateLength( data ) && data.size( ) >= 8 )
 	{
-		BYTEARRAY CRC = BYTEARRAY( data.begin( ) + 4, data.begin( ) + 8 );
-		BYTEARRAY Action = BYTEARRAY( data.begin( ) + 8, data.end( ) );
-		return new CIncomingAction( PID, CRC, Action );
+		action = CIncomingAction( PID, data.size( ) > 8 ? &data[8] : NULL, data.size( ) - 8 );
+		return true;
 	}
 
-	return NULL;
+	return false;
 }
 
 uint32_t CGameProtocol :: RECEIVE_W3GS_OUTGOING_KEEPALIVE( BYTEARRAY data )
@@ -298,12 +299,7 @@ uint32_t CGameProtocol :: RECEIVE_W3GS_PONG_TO_HOST( BYTEARRAY data )
 BYTEARRAY CGameProtocol :: SEND_W3GS_PING_FROM_HOST( )
 {
 	BYTEARRAY packet;
-	packet.push_back( W3GS_HEADER_CONSTANT );				// W3GS header constant
-	packet.push_back( W3GS_PING_FROM_HOST );				// W3GS_PING_FROM_HOST
-	packet.push_back( 0 );									// packet length will be assigned later
-	packet.push_back( 0 );									// packet length will be assigned later
-	UTIL_AppendByteArray( packet, GetTicks( ), false );		// ping value
-	AssignLength( packet );
+	WRITE_W3GS_PING_FROM_HOST( packet );
 	// DEBUG_Print( "SENT W3GS_PING_FROM_HOST" );
 	// DEBUG_Print( packet );
 	return packet;
@@ -313,17 +309,13 @@ BYTEARRAY CGameProtocol :: SEND_W3GS_SLOTINFOJOIN( unsigned char PID, BYTEARRAY
 {
 	unsigned char Zeros[] = { 0, 0, 0, 0 };
 
-	BYTEARRAY SlotInfo = EncodeSlotInfo( slots, randomSeed, layoutStyle, playerSlots );
 	BYTEARRAY packet;
 
 	if( port.size( ) == 2 && externalIP.size( ) == 4 )
 	{
-		packet.push_back( W3GS_HEADER_CONSTANT );									// W3GS header constant
-		packet.push_back( W3GS_SLOTINFOJOIN );										// W3GS_SLOTINFOJOIN
-		packet.push_back( 0 );														// packet length will be assigned later
-		packet.push_back( 0 );														// packet length will be assigned later
-		UTIL_AppendByteArray( packet, (uint16_t)SlotInfo.size( ), false );			// SlotInfo length
-		UTIL_AppendByteArrayFast( packet, SlotInfo );								// SlotInfo
+		WriteHeader( packet, W3GS_SLOTINFOJOIN );									// W3GS_SLOTINFOJOIN
+		UTIL_AppendByteArray( packet, (uint16_t)( 7 + slots.size( ) * 9 ), false );	// SlotInfo length
+		WriteSlotInfo( packet, slots, randomSeed, layoutStyle, playerSlots );		// SlotInfo
 		packet.push_back( PID );													// PID
 		packet.push_back( 2 );														// AF_INET
 		packet.push_back( 0 );														// AF_INET continued...
@@ -422,19 +414,7 @@ BYTEARRAY CGameProtocol :: SEND_W3GS_PLAYERLEAVE_OTHERS( unsigned char PID, uint
 BYTEARRAY CGameProtocol :: SEND_W3GS_GAMELOADED_OTHERS( unsigned char PID )
 {
 	BYTEARRAY packet;
-
-	if( PID != 255 )
-	{
-		packet.push_back( W3GS_HEADER_CONSTANT );		// W3GS header constant
-		packet.push_back( W3GS_GAMELOADED_OTHERS );		// W3GS_GAMELOADED_OTHERS
-		packet.push_back( 0 );							// packet length will be assigned later
-		packet.push_back( 0 );							// packet length will be assigned later
-		packet.push_back( PID );						// PID
-		AssignLength( packet );
-	}
-	else
-		CONSOLE_Print( "[GAMEPROTO] invalid parameters passed to SEND_W3GS_GAMELOADED_OTHERS" );
-
+	WRITE_W3GS_GAMELOADED_OTHERS( packet, PID );
 	// DEBUG_Print( "SENT W3GS_GAMELOADED_OTHERS" );
 	// DEBUG_Print( packet );
 	return packet;
@@ -442,15 +422,9 @@ BYTEARRAY CGameProtocol :: SEND_W3GS_GAMELOADED_OTHERS( unsigned char PID )
 
 BYTEARRAY CGameProtocol :: SEND_W3GS_SLOTINFO( vector<CGameSlot> &slots, uint32_t randomSeed, unsigned char layoutStyle, unsigned char playerSlots )
 {
-	BYTEARRAY SlotInfo = EncodeSlotInfo( slots, randomSeed, layoutStyle, playerSlots );
 	BYTEARRAY packet;
-	packet.push_back( W3GS_HEADER_CONSTANT );									// W3GS header constant
-	packet.push_back( W3GS_SLOTINFO );											// W3GS_SLOTINFO
-	packet.push_back( 0 );														// packet length will be assigned later
-	packet.push_back( 0 );														// packet length will be assigned later
-	UTIL_AppendByteArray( packet, (uint16_t)SlotInfo.size( ), false );			// SlotInfo length
-	UTIL_AppendByteArrayFast( packet, SlotInfo );								// SlotInfo
-	AssignLength( packet );
+	packet.reserve( 13 + slots.size( ) * 9 );
+	WRITE_W3GS_SLOTINFO( packet, slots, randomSeed, layoutStyle, playerSlots );
 	// DEBUG_Print( "SENT W3GS_SLOTINFO" );
 	// DEBUG_Print( packet );
 	return packet;
@@ -459,11 +433,7 @@ BYTEARRAY CGameProtocol :: SEND_W3GS_SLOTINFO( vector<CGameSlot> &slots, uint32_
 BYTEARRAY CGameProtocol :: SEND_W3GS_COUNTDOWN_START( )
 {
 	BYTEARRAY packet;
-	packet.push_back( W3GS_HEADER_CONSTANT );		// W3GS header constant
-	packet.push_back( W3GS_COUNTDOWN_START );		// W3GS_COUNTDOWN_START
-	packet.push_back( 0 );							// packet length will be assigned later
-	packet.push_back( 0 );							// packet length will be assigned later
-	AssignLength( packet );
+	WRITE_W3GS_COUNTDOWN_START( packet );
 	// DEBUG_Print( "SENT W3GS_COUNTDOWN_START" );
 	// DEBUG_Print( packet );
 	return packet;
@@ -472,52 +442,17 @@ BYTEARRAY CGameProtocol :: SEND_W3GS_COUNTDOWN_START( )
 BYTEARRAY CGameProtocol :: SEND_W3GS_COUNTDOWN_END( )
 {
 	BYTEARRAY packet;
-	packet.push_back( W3GS_HEADER_CONSTANT );		// W3GS header constant
-	packet.push_back( W3GS_COUNTDOWN_END );			// W3GS_COUNTDOWN_END
-	packet.push_back( 0 );							// packet length will be assigned later
-	packet.push_back( 0 );							// packet length will be assigned later
-	AssignLength( packet );
+	WRITE_W3GS_COUNTDOWN_END( packet );
 	// DEBUG_Print( "SENT W3GS_COUNTDOWN_END" );
 	// DEBUG_Print( packet );
 	return packet;
 }
 
-BYTEARRAY CGameProtocol :: SEND_W3GS_INCOMING_ACTION( queue<CIncomingAction *> actions, uint16_t sendInterval )
+BYTEARRAY CGameProtocol :: SEND_W3GS_INCOMING_ACTION( const unsigned char *actions, uint32_t length, uint16_t sendInterval )
 {
 	BYTEARRAY packet;
-	packet.push_back( W3GS_HEADER_CONSTANT );				// W3GS header constant
-	packet.push_back( W3GS_INCOMING_ACTION );				// W3GS_INCOMING_ACTION
-	packet.push_back( 0 );									// packet length will be assigned later
-	packet.push_back( 0 );									// packet length will be assigned later
-	UTIL_AppendByteArray( packet, sendInterval, false );	// send interval
-
-	// create subpacket
-
-	if( !actions.empty( ) )
-	{
-		BYTEARRAY subpacket;
-
-		while( !actions.empty( ) )
-		{
-			CIncomingAction *Action = actions.front( );
-			actions.pop( );
-			subpacket.push_back( Action->GetPID( ) );
-			UTIL_AppendByteArray( subpacket, (uint16_t)Action->GetAction( )->size( ), false );
-			UTIL_AppendByteArrayFast( subpacket, *Action->GetAction( ) );
-		}
-
-		// calculate crc (we only care about the first 2 bytes though)
-
-		BYTEARRAY crc32 = UTIL_CreateByteArray( m_GHost->m_CRC->FullCRC( (unsigned char *)string( subpacket.begin( ), subpacket.end( ) ).c_str( ), subpacket.size( ) ), false );
-		crc32.resize( 2 );
-
-		// finish subpacket
-
-		UTIL_AppendByteArrayFast( packet, crc32 );			// crc
-		UTIL_AppendByteArrayFast( packet, subpacket );		// subpacket
-	}
-
-	AssignLength( packet );
+	packet.reserve( 8 + length );
+	WRITE_W3GS_INCOMING_ACTION( packet, actions, length, sendInterval );
 	// DEBUG_Print( "SENT W3GS_INCOMING_ACTION" );
 	// DEBUG_Print( packet );
 	return packet;
@@ -526,24 +461,7 @@ BYTEARRAY CGameProtocol :: SEND_W3GS_INCOMING_ACTION( queue<CIncomingAction *> a
 BYTEARRAY CGameProtocol :: SEND_W3GS_CHAT_FROM_HOST( unsigned char fromPID, BYTEARRAY toPIDs, unsigned char flag, BYTEARRAY flagExtra, string message )
 {
 	BYTEARRAY packet;
-
-	if( !toPIDs.empty( ) && !message.empty( ) && message.size( ) < 255 )
-	{
-		packet.push_back( W3GS_HEADER_CONSTANT );		// W3GS header constant
-		packet.push_back( W3GS_CHAT_FROM_HOST );		// W3GS_CHAT_FROM_HOST
-		packet.push_back( 0 );							// packet length will be assigned later
-		packet.push_back( 0 );							// packet length will be assigned later
-		packet.push_back( toPIDs.size( ) );				// number of receivers
-		UTIL_AppendByteArrayFast( packet, toPIDs );		// receivers
-		packet.push_back( fromPID );					// sender
-		packet.push_back( flag );						// flag
-		UTIL_AppendByteArrayFast( packet, flagExtra );	// extra flag
-		UTIL_AppendByteArrayFast( packet, message );	// message
-		AssignLength( packet );
-	}
-	else
-		CONSOLE_Print( "[GAMEPROTO] invalid parameters passed to SEND_W3GS_CHAT_FROM_HOST" );
-
+	WRITE_W3GS_CHAT_FROM_HOST( packet, fromPID, toPIDs, flag, flagExtra, message );
 	// DEBUG_Print( "SENT W3GS_CHAT_FROM_HOST" );
 	// DEBUG_Print( packet );
 	return packet;
@@ -655,14 +573,7 @@ BYTEARRAY CGameProtocol :: SEND_W3GS_SEARCHGAME( bool TFT, unsigned char war3Ver
 
 BYTEARRAY CGameProtocol :: SEND_W3GS_GAMEINFO( bool TFT, unsigned char war3Version, BYTEARRAY mapGameType, BYTEARRAY mapFlags, BYTEARRAY mapWidth, BYTEARRAY mapHeight, string gameName, string hostName, uint32_t upTime, string mapPath, BYTEARRAY mapCRC, uint32_t slotsTotal, uint32_t slotsOpen, uint16_t port, uint32_t hostCounter, uint32_t entryKey )
 {
-	unsigned char ProductID_ROC[]	= {          51, 82, 65, 87 };	// "WAR3"
-	unsigned char ProductID_TFT[]	= {          80, 88, 51, 87 };	// "W3XP"
-	unsigned char Version[]			= { war3Version,  0,  0,  0 };
-	unsigned char Unknown2[]		= {           1,  0,  0,  0 };
-
-	BYTEARRAY packet;
-
-	if( mapGameType.size( ) == 4 && mapFlags.size( ) == 4 && mapWidth.size( ) == 2 && mapHeight.size( ) == 2 && !gameName.empty( ) && !hostName.empty( ) && !mapPath.empty( ) && mapCRC.size( ) == 4 )
+	if( mapFlags.size( ) == 4 && mapWidth.size( ) == 2 && mapHeight.size( ) == 2 && !hostName.empty( ) && !mapPath.empty( ) && mapCRC.size( ) == 4 )
 	{
 		// make the stat string
 
@@ -677,41 +588,42 @@ BYTEARRAY CGameProtocol :: SEND_W3GS_GAMEINFO( bool TFT, unsigned char war3Versi
 		StatString.push_back( 0 );
 		StatString = UTIL_EncodeStatString( StatString );
 
-		// make the rest of the packet
-
-		packet.push_back( W3GS_HEADER_CONSTANT );						// W3GS header constant
-		packet.push_back( W3GS_GAMEINFO );								// W3GS_GAMEINFO
-		packet.push_back( 0 );											// packet length will be assigned later
-		packet.push_back( 0 );											// packet length will be assigned later
-
-		if( TFT )
-			UTIL_AppendByteArray( packet, ProductID_TFT, 4 );			// Product ID (TFT)
-		else
-			UTIL_AppendByteArray( packet, ProductID_ROC, 4 );			// Product ID (ROC)
-
-		UTIL_AppendByteArray( packet, Version, 4 );						// Version
-		UTIL_AppendByteArray( packet, hostCounter, false );				// Host Counter
-		UTIL_AppendByteArray( packet, entryKey, false );				// Entry Key
-		UTIL_AppendByteArrayFast( packet, gameName );					// Game Name
-		packet.push_back( 0 );											// ??? (maybe game password)
-		UTIL_AppendByteArrayFast( packet, StatString );					// Stat String
-		packet.push_back( 0 );											// Stat String null terminator (the stat string is encoded to remove all even numbers i.e. zeros)
-		UTIL_AppendByteArray( packet, slotsTotal, false );				// Slots Total
-		UTIL_AppendByteArrayFast( packet, mapGameType );				// Game Type
-		UTIL_AppendByteArray( packet, Unknown2, 4 );					// ???
-		UTIL_AppendByteArray( packet, slotsOpen, false );				// Slots Open
-		UTIL_AppendByteArray( packet, upTime, false );					// time since creation
-		UTIL_AppendByteArray( packet, port, false );					// port
-		AssignLength( packet );
+		return SEND_W3GS_GAMEINFO( TFT, war3Version, mapGameType, gameName, upTime, StatString, slotsTotal, slotsOpen, port, hostCounter, entryKey );
 	}
-	else
-		CONSOLE_Print( "[GAMEPROTO] invalid parameters passed to SEND_W3GS_GAMEINFO" );
 
+	CONSOLE_Print( "[GAMEPROTO] invalid parameters passed to SEND_W3GS_GAMEINFO" );
+	return BYTEARRAY( );
+}
+
+BYTEARRAY CGameProtocol :: SEND_W3GS_GAMEINFO( bool TFT, unsigned char war3Version, const BYTEARRAY &mapGameType, const string &gameName, uint32_t upTime, const BYTEARRAY &encodedStatString, uint32_t slotsTotal, uint32_t slotsOpen, uint16_t port, uint32_t hostCounter, uint32_t entryKey )
+{
+	BYTEARRAY packet;
+	packet.reserve( 4 + 4 + 4 + 4 + 4 + gameName.size( ) + 2 + encodedStatString.size( ) + 1 + W3GS_GAMEINFO_TAIL_SIZE );
+	WRITE_W3GS_GAMEINFO( packet, TFT, war3Version, mapGameType, gameName, upTime, encodedStatString, slotsTotal, slotsOpen, port, hostCounter, entryKey );
 	// DEBUG_Print( "SENT W3GS_GAMEINFO" );
 	// DEBUG_Print( packet );
 	return packet;
 }
 
+bool CGameProtocol :: PATCH_W3GS_GAMEINFO( BYTEARRAY &packet, uint32_t slotsOpen, uint32_t upTime )
+{
+	// the mutable fields sit at fixed offsets from the end of the packet: slots open (4), time since creation (4), port (2)
+
+	if( packet.size( ) < W3GS_GAMEINFO_TAIL_SIZE + 4 || packet[0] != W3GS_HEADER_CONSTANT || packet[1] != W3GS_GAMEINFO )
+		return false;
+
+	BYTEARRAY::iterator Tail = packet.end( ) - 10;
+	Tail[0] = (unsigned char)slotsOpen;
+	Tail[1] = (unsigned char)( slotsOpen >> 8 );
+	Tail[2] = (unsigned char)( slotsOpen >> 16 );
+	Tail[3] = (unsigned char)( slotsOpen >> 24 );
+	Tail[4] = (unsigned char)upTime;
+	Tail[5] = (unsigned char)( upTime >> 8 );
+	Tail[6] = (unsigned char)( upTime >> 16 );
+	Tail[7] = (unsigned char)( upTime >> 24 );
+	return true;
+}
+
 BYTEARRAY CGameProtocol :: SEND_W3GS_CREATEGAME( bool TFT, unsigned char war3Version )
 {
 	unsigned char ProductID_ROC[]	= {          51, 82, 65, 87 };	// "WAR3"
@@ -819,122 +731,237 @@ BYTEARRAY CGameProtocol :: SEND_W3GS_STARTDOWNLOAD( unsigned char fromPID )
 
 BYTEARRAY CGameProtocol :: SEND_W3GS_MAPPART( unsigned char fromPID, unsigned char toPID, uint32_t start, string *mapData )
 {
-	unsigned char Unknown[] = { 1, 0, 0, 0 };
+	BYTEARRAY packet;
+	packet.reserve( 18 + 1442 );
+	WRITE_W3GS_MAPPART( packet, fromPID, toPID, start, mapData );
+	// DEBUG_Print( "SENT W3GS_MAPPART" );
+	// DEBUG_Print( packet );
+	return packet;
+}
 
+BYTEARRAY CGameProtocol :: SEND_W3GS_INCOMING_ACTION2( const unsigned char *actions, uint32_t length )
+{
 	BYTEARRAY packet;
+	packet.reserve( 8 + length );
+	WRITE_W3GS_INCOMING_ACTION2( packet, actions, length );
+	// DEBUG_Print( "SENT W3GS_INCOMING_ACTION2" );
+	// DEBUG_Print( packet );
+	return packet;
+}
 
-	if( start < mapData->size( ) )
+/////////////////////
+// WRITE FUNCTIONS //
+/////////////////////
+
+bool CGameProtocol :: WRITE_W3GS_PING_FROM_HOST( BYTEARRAY &out )
+{
+	CW3GSPingFromHost Packet;
+	Packet.SetUInt32<4>( GetTicks( ) );			// ping value
+	Packet.Write( out );
+	return true;
+}
+
+bool CGameProtocol :: WRITE_W3GS_GAMELOADED_OTHERS( BYTEARRAY &out, unsigned char PID )
+{
+	if( PID == 255 )
 	{
-		packet.push_back( W3GS_HEADER_CONSTANT );				// W3GS header constant
-		packet.push_back( W3GS_MAPPART );						// W3GS_MAPPART
-		packet.push_back( 0 );									// packet length will be assigned later
-		packet.push_back( 0 );									// packet length will be assigned later
-		packet.push_back( toPID );								// to PID
-		packet.push_back( fromPID );							// from PID
-		UTIL_AppendByteArray( packet, Unknown, 4 );				// ???
-		UTIL_AppendByteArray( packet, start, false );			// start position
+		CONSOLE_Print( "[GAMEPROTO] invalid parameters passed to SEND_W3GS_GAMELOADED_OTHERS" );
+		return false;
+	}
 
-		// calculate end position (don't send more than 1442 map bytes in one packet)
+	CW3GSGameLoadedOthers Packet;
+	Packet.SetByte<4>( PID );					// PID
+	Packet.Write( out );
+	return true;
+}
 
-		uint32_t End = start + 1442;
+bool CGameProtocol :: WRITE_W3GS_SLOTINFO( BYTEARRAY &out, vector<CGameSlot> &slots, uint32_t randomSeed, unsigned char layoutStyle, unsigned char playerSlots )
+{
+	uint32_t Start = out.size( );
+	WriteHeader( out, W3GS_SLOTINFO );												// W3GS_SLOTINFO
+	UTIL_AppendByteArray( out, (uint16_t)( 7 + slots.size( ) * 9 ), false );		// SlotInfo length
+	WriteSlotInfo( out, slots, randomSeed, layoutStyle, playerSlots );				// SlotInfo
+	return AssignLength( out, Start );
+}
 
-		if( End > mapData->size( ) )
-			End = mapData->size( );
+bool CGameProtocol :: WRITE_W3GS_COUNTDOWN_START( BYTEARRAY &out )
+{
+	CW3GSCountdownStart( ).Write( out );
+	return true;
+}
 
-		// calculate crc
+bool CGameProtocol :: WRITE_W3GS_COUNTDOWN_END( BYTEARRAY &out )
+{
+	CW3GSCountdownEnd( ).Write( out );
+	return true;
+}
 
-		BYTEARRAY crc32 = UTIL_CreateByteArray( m_GHost->m_CRC->FullCRC( (unsigned char *)mapData->c_str( ) + start, End - start ), false );
-		UTIL_AppendByteArrayFast( packet, crc32 );
+bool CGameProtocol :: WRITE_W3GS_INCOMING_ACTION( BYTEARRAY &out, const unsigned char *actions, uint32_t length, uint16_t sendInterval )
+{
+	uint32_t Start = out.size( );
+	WriteHeader( out, W3GS_INCOMING_ACTION );				// W3GS_INCOMING_ACTION
+	UTIL_AppendByteArray( out, sendInterval, false );		// send interval
 
-		// map data
+	if( length > 0 )
+	{
+		// calculate crc (we only care about the first 2 bytes though)
 
-		BYTEARRAY Data = UTIL_CreateByteArray( (unsigned char *)mapData->c_str( ) + start, End - start );
-		UTIL_AppendByteArrayFast( packet, Data );
-		AssignLength( packet );
+		uint32_t crc32 = CCRC32 :: FullCRC( actions, length );
+		out.push_back( (unsigned char)crc32 );				// crc
+		out.push_back( (unsigned char)( crc32 >> 8 ) );		// crc
+		out.insert( out.end( ), actions, actions + length );
 	}
-	else
-		CONSOLE_Print( "[GAMEPROTO] invalid parameters passed to SEND_W3GS_MAPPART" );
 
-	// DEBUG_Print( "SENT W3GS_MAPPART" );
-	// DEBUG_Print( packet );
-	return packet;
+	return AssignLength( out, Start );
 }
 
-BYTEARRAY CGameProtocol :: SEND_W3GS_INCOMING_ACTION2( queue<CIncomingAction *> actions )
+bool CGameProtocol :: WRITE_W3GS_CHAT_FROM_HOST( BYTEARRAY &out, unsigned char fromPID, const BYTEARRAY &toPIDs, unsigned char flag, const BYTEARRAY &flagExtra, const string &message )
 {
-	BYTEARRAY packet;
-	packet.push_back( W3GS_HEADER_CONSTANT );				// W3GS header constant
-	packet.push_back( W3GS_INCOMING_ACTION2 );				// W3GS_INCOMING_ACTION2
-	packet.push_back( 0 );									// packet length will be assigned later
-	packet.push_back( 0 );									// packet length will be assigned later
-	packet.push_back( 0 );									// ??? (send interval?)
-	packet.push_back( 0 );									// ??? (send interval?)
+	if( toPIDs.empty( ) || message.empty( ) || message.size( ) >= 255 )
+	{
+		CONSOLE_Print( "[GAMEPROTO] invalid parameters passed to SEND_W3GS_CHAT_FROM_HOST" );
+		return false;
+	}
+
+	uint32_t Start = out.size( );
+	WriteHeader( out, W3GS_CHAT_FROM_HOST );								// W3GS_CHAT_FROM_HOST
+	out.push_back( toPIDs.size( ) );										// number of receivers
+	out.insert( out.end( ), toPIDs.begin( ), toPIDs.end( ) );				// receivers
+	out.push_back( fromPID );												// sender
+	out.push_back( flag );													// flag
+	out.insert( out.end( ), flagExtra.begin( ), flagExtra.end( ) );			// extra flag
+	out.insert( out.end( ), message.begin( ), message.end( ) );				// message
+	out.push_back( 0 );														// message null terminator
+	return AssignLength( out, Start );
+}
+
+bool CGameProtocol :: WRITE_W3GS_GAMEINFO( BYTEARRAY &out, bool TFT, unsigned char war3Version, const BYTEARRAY &mapGameType, const string &gameName, uint32_t upTime, const BYTEARRAY &encodedStatString, uint32_t slotsTotal, uint32_t slotsOpen, uint16_t port, uint32_t hostCounter, uint32_t entryKey )
+{
+	unsigned char ProductID_ROC[]	= {          51, 82, 65, 87 };	// "WAR3"
+	unsigned char ProductID_TFT[]	= {          80, 88, 51, 87 };	// "W3XP"
+	unsigned char Version[]			= { war3Version,  0,  0,  0 };
+	unsigned char Unknown2[]		= {           1,  0,  0,  0 };
+
+	if( mapGameType.size( ) != 4 || gameName.empty( ) || encodedStatString.empty( ) )
+	{
+		CONSOLE_Print( "[GAMEPROTO] invalid parameters passed to SEND_W3GS_GAMEINFO" );
+		return false;
+	}
 
-	// create subpacket
+	uint32_t Start = out.size( );
+	WriteHeader( out, W3GS_GAMEINFO );								// W3GS_GAMEINFO
 
-	if( !actions.empty( ) )
+	if( TFT )
+		UTIL_AppendByteArray( out, ProductID_TFT, 4 );				// Product ID (TFT)
+	else
+		UTIL_AppendByteArray( out, ProductID_ROC, 4 );				// Product ID (ROC)
+
+	UTIL_AppendByteArray( out, Version, 4 );						// Version
+	UTIL_AppendByteArray( out, hostCounter, false );				// Host Counter
+	UTIL_AppendByteArray( out, entryKey, false );					// Entry Key
+	out.insert( out.end( ), gameName.begin( ), gameName.end( ) );	// Game Name
+	out.push_back( 0 );												// Game Name null terminator
+	out.push_back( 0 );												// ??? (maybe game password)
+	out.insert( out.end( ), encodedStatString.begin( ), encodedStatString.end( ) );	// Stat String
+	out.push_back( 0 );												// Stat String null terminator (the stat string is encoded to remove all even numbers i.e. zeros)
+	UTIL_AppendByteArray( out, slotsTotal, false );					// Slots Total
+	out.insert( out.end( ), mapGameType.begin( ), mapGameType.end( ) );	// Game Type
+	UTIL_AppendByteArray( out, Unknown2, 4 );						// ???
+	UTIL_AppendByteArray( out, slotsOpen, false );					// Slots Open
+	UTIL_AppendByteArray( out, upTime, false );						// time since creation
+	UTIL_AppendByteArray( out, port, false );						// port
+	return AssignLength( out, Start );
+}
+
+bool CGameProtocol :: WRITE_W3GS_MAPPART( BYTEARRAY &out, unsigned char fromPID, unsigned char toPID, uint32_t start, const string *mapData )
+{
+	unsigned char Unknown[] = { 1, 0, 0, 0 };
+
+	if( start >= mapData->size( ) )
 	{
-		BYTEARRAY subpacket;
+		CONSOLE_Print( "[GAMEPROTO] invalid parameters passed to SEND_W3GS_MAPPART" );
+		return false;
+	}
 
-		while( !actions.empty( ) )
-		{
-			CIncomingAction *Action = actions.front( );
-			actions.pop( );
-			subpacket.push_back( Action->GetPID( ) );
-			UTIL_AppendByteArray( subpacket, (uint16_t)Action->GetAction( )->size( ), false );
-			UTIL_AppendByteArrayFast( subpacket, *Action->GetAction( ) );
-		}
+	uint32_t Start = out.size( );
+	WriteHeader( out, W3GS_MAPPART );						// W3GS_MAPPART
+	out.push_back( toPID );									// to PID
+	out.push_back( fromPID );								// from PID
+	UTIL_AppendByteArray( out, Unknown, 4 );				// ???
+	UTIL_AppendByteArray( out, start, false );				// start position
 
-		// calculate crc (we only care about the first 2 bytes though)
+	// calculate end position (don't send more than 1442 map bytes in one packet)
 
-		BYTEARRAY crc32 = UTIL_CreateByteArray( m_GHost->m_CRC->FullCRC( (unsigned char *)string( subpacket.begin( ), subpacket.end( ) ).c_str( ), subpacket.size( ) ), false );
-		crc32.resize( 2 );
+	uint32_t End = start + 1442;
 
-		// finish subpacket
+	if( End > mapData->size( ) )
+		End = mapData->size( );
+
+	const unsigned char *Data = (const unsigned char *)mapData->data( ) + start;
+	UTIL_AppendByteArray( out, CCRC32 :: FullCRC( Data, End - start ), false );	// crc
+	out.insert( out.end( ), Data, Data + End - start );								// map data
+	return AssignLength( out, Start );
+}
 
-		UTIL_AppendByteArrayFast( packet, crc32 );			// crc
-		UTIL_AppendByteArrayFast( packet, subpacket );		// subpacket
+bool CGameProtocol :: WRITE_W3GS_INCOMING_ACTION2( BYTEARRAY &out, const unsigned char *actions, uint32_t length )
+{
+	uint32_t Start = out.size( );
+	WriteHeader( out, W3GS_INCOMING_ACTION2 );				// W3GS_INCOMING_ACTION2
+	out.push_back( 0 );										// ??? (send interval?)
+	out.push_back( 0 );										// ??? (send interval?)
+
+	if( length > 0 )
+	{
+		// calculate crc (we only care about the first 2 bytes though)
+
+		uint32_t crc32 = CCRC32 :: FullCRC( actions, length );
+		out.push_back( (unsigned char)crc32 );				// crc
+		out.push_back( (unsigned char)( crc32 >> 8 ) );		// crc
+		out.insert( out.end( ), actions, actions + length );
 	}
 
-	AssignLength( packet );
-	// DEBUG_Print( "SENT W3GS_INCOMING_ACTION2" );
-	// DEBUG_Print( packet );
-	return packet;
+	return AssignLength( out, Start );
 }
 
 /////////////////////
 // OTHER FUNCTIONS //
 /////////////////////
 
-bool CGameProtocol :: AssignLength( BYTEARRAY &content )
+void CGameProtocol :: WriteHeader( BYTEARRAY &out, unsigned char ID )
 {
-	// insert the actual length of the content array into bytes 3 and 4 (indices 2 and 3)
+	out.push_back( W3GS_HEADER_CONSTANT );		// W3GS header constant
+	out.push_back( ID );						// packet ID
+	out.push_back( 0 );							// packet length will be assigned later
+	out.push_back( 0 );							// packet length will be assigned later
+}
 
-	BYTEARRAY LengthBytes;
+bool CGameProtocol :: AssignLength( BYTEARRAY &content, uint32_t start )
+{
+	// insert the actual length of the packet starting at start into its bytes 3 and 4 (indices start + 2 and start + 3)
+	// a packet that's too long can't be sent so it's removed again, otherwise the rest of the buffer would be misframed
 
-	if( content.size( ) >= 4 && content.size( ) <= 65535 )
+	uint32_t Length = content.size( ) - start;
+
+	if( content.size( ) >= start + 4 && Length <= 65535 )
 	{
-		LengthBytes = UTIL_CreateByteArray( (uint16_t)content.size( ), false );
-		content[2] = LengthBytes[0];
-		content[3] = LengthBytes[1];
+		content[start + 2] = (unsigned char)Length;
+		content[start + 3] = (unsigned char)( Length >> 8 );
 		return true;
 	}
 
+	if( content.size( ) > start )
+		content.resize( start );
+
 	return false;
 }
 
-bool CGameProtocol :: ValidateLength( BYTEARRAY &content )
+bool CGameProtocol :: ValidateLength( const BYTEARRAY &content )
 {
 	// verify that bytes 3 and 4 (indices 2 and 3) of the content array describe the length
 
-	uint16_t Length;
-	BYTEARRAY LengthBytes;
-
 	if( content.size( ) >= 4 && content.size( ) <= 65535 )
 	{
-		LengthBytes.push_back( content[2] );
-		LengthBytes.push_back( content[3] );
-		Length = UTIL_ByteArrayToUInt16( LengthBytes, false );
+		uint16_t Length = (uint16_t)( content[2] | ( content[3] << 8 ) );
 
 		if( Length == content.size( ) )
 			return true;
@@ -943,18 +970,16 @@ bool CGameProtocol :: ValidateLength( BYTEARRAY &content )
 	return false;
 }
 
-BYTEARRAY CGameProtocol :: EncodeSlotInfo( vector<CGameSlot> &slots, uint32_t randomSeed, unsigned char layoutStyle, unsigned char playerSlots )
+void CGameProtocol :: WriteSlotInfo( BYTEARRAY &out, vector<CGameSlot> &slots, uint32_t randomSeed, unsigned char layoutStyle, unsigned char playerSlots )
 {
-	BYTEARRAY SlotInfo;
-	SlotInfo.push_back( (unsigned char)slots.size( ) );		// number of slots
+	out.push_back( (unsigned char)slots.size( ) );			// number of slots
 
 	for( unsigned int i = 0; i < slots.size( ); ++i )
-		UTIL_AppendByteArray( SlotInfo, slots[i].GetByteArray( ) );
+		slots[i].AppendByteArray( out );
 
-	UTIL_AppendByteArray( SlotInfo, randomSeed, false );	// random seed
-	SlotInfo.push_back( layoutStyle );						// LayoutStyle (0 = melee, 1 = custom forces, 3 = custom forces + fixed player settings)
-	SlotInfo.push_back( playerSlots );						// number of player slots (non observer)
-	return SlotInfo;
+	UTIL_AppendByteArray( out, randomSeed, false );			// random seed
+	out.push_back( layoutStyle );							// LayoutStyle (0 = melee, 1 = custom forces, 3 = custom forces + fixed player settings)
+	out.push_back( playerSlots );							// number of player slots (non observer)
 }
 
 //
@@ -972,19 +997,75 @@ CIncomingJoinPlayer :: ~CIncomingJoinPlayer( )
 }
 
 //
-// CIncomingAction
+// CActionArena
 //
 
-CIncomingAction :: CIncomingAction( unsigned char nPID, BYTEARRAY &nCRC, BYTEARRAY &nAction ) : m_PID( nPID ), m_CRC( nCRC ), m_Action( nAction )
+CActionArena :: CActionArena( )
 {
+	// enough for a typical tick of a full game, the buffer grows if a tick needs more and keeps that size
 
+	m_Data.reserve( 2048 );
 }
 
-CIncomingAction :: ~CIncomingAction( )
+CActionArena :: ~CActionArena( )
 {
 
 }
 
+void CActionArena :: Add( unsigned char PID, const unsigned char *action, uint32_t length )
+{
+	m_Data.push_back( PID );
+	m_Data.push_back( (unsigned char)length );
+	m_Data.push_back( (unsigned char)( length >> 8 ) );
+
+	if( length > 0 )
+		m_Data.insert( m_Data.end( ), action, action + length );
+}
+
+//
+// CLoadInGameLog
+//
+
+CLoadInGameLog :: CLoadInGameLog( ) : m_Base( 0 )
+{
+
+}
+
+CLoadInGameLog :: ~CLoadInGameLog( )
+{
+
+}
+
+void CLoadInGameLog :: Add( const BYTEARRAY &packet, unsigned char flags )
+{
+	if( packet.size( ) < 4 )
+		return;
+
+	m_Data.push_back( flags );
+	m_Data.insert( m_Data.end( ), packet.begin( ), packet.end( ) );
+}
+
+void CLoadInGameLog :: Discard( uint32_t cursor )
+{
+	// discard every packet before cursor
+
+	if( cursor <= m_Base )
+		return;
+
+	if( cursor >= GetEnd( ) )
+	{
+		// nobody needs anything in the log anymore so release the memory too
+
+		m_Base = GetEnd( );
+		BYTEARRAY( ).swap( m_Data );
+	}
+	else
+	{
+		m_Data.erase( m_Data.begin( ), m_Data.begin( ) + ( cursor - m_Base ) );
+		m_Base = cursor;
+	}
+}
+
 //
 // CIncomingChatPlayer
 //
@@ -26,6 +26,7 @@
 //
 
 #define W3GS_HEADER_CONSTANT		247
+#define W3GS_GAMEINFO_TAIL_SIZE		22		// slots total, game type, unknown, slots open, uptime and port trail every W3GS_GAMEINFO
 
 #define GAME_NONE					0		// this case isn't part of the protocol, it's for internal use only
 #define GAME_FULL					2
@@ -48,6 +49,8 @@
 #define REJECTJOIN_STARTED			10
 #define REJECTJOIN_WRONGPASSWORD	27
 
+#define LOADINGAME_NONGPROXY		1		// CLoadInGameLog packet flag, the packet is only for players who aren't using GProxy++
+
 #include "gameslot.h"
 
 class CGamePlayer;
@@ -109,7 +112,7 @@ public:
 	CIncomingJoinPlayer *RECEIVE_W3GS_REQJOIN( BYTEARRAY data );
 	uint32_t RECEIVE_W3GS_LEAVEGAME( BYTEARRAY data );
 	bool RECEIVE_W3GS_GAMELOADED_SELF( BYTEARRAY data );
-	CIncomingAction *RECEIVE_W3GS_OUTGOING_ACTION( BYTEARRAY data, unsigned char PID );
+	bool RECEIVE_W3GS_OUTGOING_ACTION( const BYTEARRAY &data, unsigned char PID, CIncomingAction &action );
 	uint32_t RECEIVE_W3GS_OUTGOING_KEEPALIVE( BYTEARRAY data );
 	CIncomingChatPlayer *RECEIVE_W3GS_CHAT_TO_HOST( BYTEARRAY data );
 	bool RECEIVE_W3GS_SEARCHGAME( BYTEARRAY data, unsigned char war3Version );
@@ -128,28 +131,100 @@ public:
 	BYTEARRAY SEND_W3GS_SLOTINFO( vector<CGameSlot> &slots, uint32_t randomSeed, unsigned char layoutStyle, unsigned char playerSlots );
 	BYTEARRAY SEND_W3GS_COUNTDOWN_START( );
 	BYTEARRAY SEND_W3GS_COUNTDOWN_END( );
-	BYTEARRAY SEND_W3GS_INCOMING_ACTION( queue<CIncomingAction *> actions, uint16_t sendInterval );
+	BYTEARRAY SEND_W3GS_INCOMING_ACTION( const unsigned char *actions, uint32_t length, uint16_t sendInterval );
 	BYTEARRAY SEND_W3GS_CHAT_FROM_HOST( unsigned char fromPID, BYTEARRAY toPIDs, unsigned char flag, BYTEARRAY flagExtra, string message );
 	BYTEARRAY SEND_W3GS_START_LAG( vector<CGamePlayer *> players, bool loadInGame = false );
 	BYTEARRAY SEND_W3GS_STOP_LAG( CGamePlayer *player, bool loadInGame = false );
 	BYTEARRAY SEND_W3GS_SEARCHGAME( bool TFT, unsigned char war3Version );
 	BYTEARRAY SEND_W3GS_GAMEINFO( bool TFT, unsigned char war3Version, BYTEARRAY mapGameType, BYTEARRAY mapFlags, BYTEARRAY mapWidth, BYTEARRAY mapHeight, string gameName, string hostName, uint32_t upTime, string mapPath, BYTEARRAY mapCRC, uint32_t slotsTotal, uint32_t slotsOpen, uint16_t port, uint32_t hostCounter, uint32_t entryKey );
+	BYTEARRAY SEND_W3GS_GAMEINFO( bool TFT, unsigned char war3Version, const BYTEARRAY &mapGameType, const string &gameName, uint32_t upTime, const BYTEARRAY &encodedStatString, uint32_t slotsTotal, uint32_t slotsOpen, uint16_t port, uint32_t hostCounter, uint32_t entryKey );
+	bool PATCH_W3GS_GAMEINFO( BYTEARRAY &packet, uint32_t slotsOpen, uint32_t upTime );
 	BYTEARRAY SEND_W3GS_CREATEGAME( bool TFT, unsigned char war3Version );
 	BYTEARRAY SEND_W3GS_REFRESHGAME( uint32_t players, uint32_t playerSlots );
 	BYTEARRAY SEND_W3GS_DECREATEGAME( );
 	BYTEARRAY SEND_W3GS_MAPCHECK( string mapPath, BYTEARRAY mapSize, BYTEARRAY mapInfo, BYTEARRAY mapCRC, BYTEARRAY mapSHA1 );
 	BYTEARRAY SEND_W3GS_STARTDOWNLOAD( unsigned char fromPID );
 	BYTEARRAY SEND_W3GS_MAPPART( unsigned char fromPID, unsigned char toPID, uint32_t start, string *mapData );
-	BYTEARRAY SEND_W3GS_INCOMING_ACTION2( queue<CIncomingAction *> actions );
+	BYTEARRAY SEND_W3GS_INCOMING_ACTION2( const unsigned char *actions, uint32_t length );
+
+	// write functions
+	// these append one packet to the end of a buffer owned by the caller instead of returning a new array, the send functions above are wrappers around them
+	// the caller can clear and reuse the same buffer for every packet so nothing is allocated once it has grown large enough
+	// if the parameters are invalid nothing is appended and false is returned
+
+	bool WRITE_W3GS_PING_FROM_HOST( BYTEARRAY &out );
+	bool WRITE_W3GS_GAMELOADED_OTHERS( BYTEARRAY &out, unsigned char PID );
+	bool WRITE_W3GS_SLOTINFO( BYTEARRAY &out, vector<CGameSlot> &slots, uint32_t randomSeed, unsigned char layoutStyle, unsigned char playerSlots );
+	bool WRITE_W3GS_COUNTDOWN_START( BYTEARRAY &out );
+	bool WRITE_W3GS_COUNTDOWN_END( BYTEARRAY &out );
+	bool WRITE_W3GS_INCOMING_ACTION( BYTEARRAY &out, const unsigned char *actions, uint32_t length, uint16_t sendInterval );
+	bool WRITE_W3GS_CHAT_FROM_HOST( BYTEARRAY &out, unsigned char fromPID, const BYTEARRAY &toPIDs, unsigned char flag, const BYTEARRAY &flagExtra, const string &message );
+	bool WRITE_W3GS_GAMEINFO( BYTEARRAY &out, bool TFT, unsigned char war3Version, const BYTEARRAY &mapGameType, const string &gameName, uint32_t upTime, const BYTEARRAY &encodedStatString, uint32_t slotsTotal, uint32_t slotsOpen, uint16_t port, uint32_t hostCounter, uint32_t entryKey );
+	bool WRITE_W3GS_MAPPART( BYTEARRAY &out, unsigned char fromPID, unsigned char toPID, uint32_t start, const string *mapData );
+	bool WRITE_W3GS_INCOMING_ACTION2( BYTEARRAY &out, const unsigned char *actions, uint32_t length );
 
 	// other functions
 
 private:
-	bool AssignLength( BYTEARRAY &content );
-	bool ValidateLength( BYTEARRAY &content );
-	BYTEARRAY EncodeSlotInfo( vector<CGameSlot> &slots, uint32_t randomSeed, unsigned char layoutStyle, unsigned char playerSlots );
+	void WriteHeader( BYTEARRAY &out, unsigned char ID );
+	bool AssignLength( BYTEARRAY &content, uint32_t start = 0 );
+	bool ValidateLength( const BYTEARRAY &content );
+	void WriteSlotInfo( BYTEARRAY &out, vector<CGameSlot> &slots, uint32_t randomSeed, unsigned char layoutStyle, unsigned char playerSlots );
+};
+
+//
+// CW3GSFixedPacket
+//
+
+// a packet whose size never changes, the header and length are filled in at compile time and the rest is set through offsets checked at compile time
+// it lives on the stack so sending one doesn't allocate anything unless the receiver has to keep a copy
+
+template <unsigned char ID, uint16_t Size>
+class CW3GSFixedPacket
+{
+	static_assert( Size >= 4, "a W3GS packet can't be smaller than its header" );
+
+private:
+	unsigned char m_Data[Size];
+
+public:
+	CW3GSFixedPacket( ) : m_Data{ W3GS_HEADER_CONSTANT, ID, (unsigned char)Size, (unsigned char)( Size >> 8 ) } { }
+
+	static constexpr uint16_t GetSize( )	{ return Size; }
+	const unsigned char *GetData( ) const	{ return m_Data; }
+	BYTEARRAY GetByteArray( ) const			{ return BYTEARRAY( m_Data, m_Data + Size ); }
+
+	void Write( BYTEARRAY &out ) const
+	{
+		// grow first and copy into the new tail
+		// inserting a fixed size range into a possibly empty vector makes g++ warn about a memcpy into a zero sized region
+
+		BYTEARRAY :: size_type Start = out.size( );
+		out.resize( Start + Size );
+		memcpy( &out[Start], m_Data, Size );
+	}
+
+	template <uint16_t Offset> void SetByte( unsigned char b )
+	{
+		static_assert( Offset >= 4 && Offset < Size, "byte is outside the packet body" );
+		m_Data[Offset] = b;
+	}
+
+	template <uint16_t Offset> void SetUInt32( uint32_t i )
+	{
+		static_assert( Offset >= 4 && Offset + 4 <= Size, "uint32 is outside the packet body" );
+		m_Data[Offset] = (unsigned char)i;
+		m_Data[Offset + 1] = (unsigned char)( i >> 8 );
+		m_Data[Offset + 2] = (unsigned char)( i >> 16 );
+		m_Data[Offset + 3] = (unsigned char)( i >> 24 );
+	}
 };
 
+typedef CW3GSFixedPacket<CGameProtocol :: W3GS_PING_FROM_HOST, 8>		CW3GSPingFromHost;		// ping value at 4
+typedef CW3GSFixedPacket<CGameProtocol :: W3GS_GAMELOADED_OTHERS, 5>	CW3GSGameLoadedOthers;	// PID at 4
+typedef CW3GSFixedPacket<CGameProtocol :: W3GS_COUNTDOWN_START, 4>		CW3GSCountdownStart;
+typedef CW3GSFixedPacket<CGameProtocol :: W3GS_COUNTDOWN_END, 4>		CW3GSCountdownEnd;
+
 //
 // CIncomingJoinPlayer
 //
@@ -176,21 +251,84 @@ public:
 // CIncomingAction
 //
 
+// a view of one action received from a player
+// it doesn't own the action data, it points into the packet the action was received in so it's only valid while that packet is being processed
+// the game copies the action into its CActionArena if it accepts it
+
 class CIncomingAction
 {
 private:
 	unsigned char m_PID;
-	BYTEARRAY m_CRC;
-	BYTEARRAY m_Action;
+	const unsigned char *m_Action;
+	uint32_t m_ActionLength;
 
 public:
-	CIncomingAction( unsigned char nPID, BYTEARRAY &nCRC, BYTEARRAY &nAction );
-	~CIncomingAction( );
+	CIncomingAction( ) : m_PID( 255 ), m_Action( NULL ), m_ActionLength( 0 ) { }
+	CIncomingAction( unsigned char nPID, const unsigned char *nAction, uint32_t nActionLength ) : m_PID( nPID ), m_Action( nAction ), m_ActionLength( nActionLength ) { }
 
-	unsigned char GetPID( )	{ return m_PID; }
-	BYTEARRAY GetCRC( )		{ return m_CRC; }
-	BYTEARRAY *GetAction( )	{ return &m_Action; }
-	uint32_t GetLength( )	{ return m_Action.size( ) + 3; }
+	unsigned char GetPID( ) const				{ return m_PID; }
+	const unsigned char *GetAction( ) const		{ return m_Action; }
+	uint32_t GetActionLength( ) const			{ return m_ActionLength; }
+	uint32_t GetLength( ) const					{ return m_ActionLength + 3; }
+};
+
+//
+// CActionArena
+//
+
+// the actions waiting to be sent in the next action tick
+// they're stored back to back in the format W3GS_INCOMING_ACTION and the replay TimeSlot blocks use (1 byte PID, 2 bytes length, action data)
+// so a run of actions is sent and saved to the replay by copying one contiguous range of the arena
+// the arena is cleared after each tick but its buffer is kept, once it has grown to fit a busy tick queueing actions doesn't allocate anymore
+
+class CActionArena
+{
+private:
+	BYTEARRAY m_Data;
+
+public:
+	CActionArena( );
+	~CActionArena( );
+
+	bool empty( ) const										{ return m_Data.empty( ); }
+	uint32_t GetSize( ) const								{ return m_Data.size( ); }
+	const unsigned char *GetData( uint32_t offset ) const	{ return offset < m_Data.size( ) ? &m_Data[offset] : NULL; }
+	uint32_t GetRecordLength( uint32_t offset ) const		{ return 3 + ( m_Data[offset + 1] | ( m_Data[offset + 2] << 8 ) ); }
+
+	void Add( unsigned char PID, const unsigned char *action, uint32_t length );
+	void Add( const CIncomingAction &action )				{ Add( action.GetPID( ), action.GetAction( ), action.GetActionLength( ) ); }
+	void Clear( )											{ m_Data.clear( ); }
+};
+
+//
+// CLoadInGameLog
+//
+
+// the packets which players still loading the map can't be sent yet when using "load in game" (empty updates, player loaded and player leave messages)
+// every loading player must receive exactly the same packets in the same order so they're stored once per game instead of once per player
+// each packet is stored back to back behind a flags byte (see the LOADINGAME_ constants), the packet itself carries its length
+// players keep a cursor into the log and are sent everything from their cursor onwards when they finish loading
+// cursors count bytes from the start of the log so they stay valid after the packets every loading player has been sent are discarded
+
+class CLoadInGameLog
+{
+private:
+	BYTEARRAY m_Data;
+	uint32_t m_Base;			// the cursor of m_Data[0]
+
+public:
+	CLoadInGameLog( );
+	~CLoadInGameLog( );
+
+	uint32_t GetBegin( ) const								{ return m_Base; }
+	uint32_t GetEnd( ) const								{ return m_Base + m_Data.size( ); }
+	unsigned char GetFlags( uint32_t cursor ) const			{ return m_Data[cursor - m_Base]; }
+	const unsigned char *GetPacket( uint32_t cursor ) const	{ return &m_Data[cursor - m_Base + 1]; }
+	uint32_t GetPacketLength( uint32_t cursor ) const		{ return m_Data[cursor - m_Base + 3] | ( m_Data[cursor - m_Base + 4] << 8 ); }
+	uint32_t GetNext( uint32_t cursor ) const				{ return cursor + 1 + GetPacketLength( cursor ); }
+
+	void Add( const BYTEARRAY &packet, unsigned char flags = 0 );
+	void Discard( uint32_t cursor );
 };
 
 //
@@ -59,6 +59,13 @@ CGameSlot :: ~CGameSlot( )
 BYTEARRAY CGameSlot :: GetByteArray( ) const
 {
 	BYTEARRAY b;
+	b.reserve( 9 );
+	AppendByteArray( b );
+	return b;
+}
+
+void CGameSlot :: AppendByteArray( BYTEARRAY &b ) const
+{
 	b.push_back( m_PID );
 	b.push_back( m_DownloadStatus );
 	b.push_back( m_SlotStatus );
@@ -68,5 +75,4 @@ BYTEARRAY CGameSlot :: GetByteArray( ) const
 	b.push_back( m_Race );
 	b.push_back( m_ComputerType );
 	b.push_back( m_Handicap );
-	return b;
 }
@@ -81,6 +81,7 @@ public:
 	void SetHandicap( unsigned char nHandicap )					{ m_Handicap = nHandicap; }
 
 	BYTEARRAY GetByteArray( ) const;
+	void AppendByteArray( BYTEARRAY &b ) const;
 };
 
 #endif
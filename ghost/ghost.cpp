@@ -34,15 +34,16 @@ namespace MPQ{
 }
 
 #include "util.h"
-#include "crc32.h"
-#include "sha1.h"
 #include "csvparser.h"
 #include "config.h"
 #include "language.h"
 #include "socket.h"
 #include "ghostdb.h"
+#include "commandtable.h"
 #include "ghostdbsqlite.h"
 #include "ghostdbmysql.h"
+#include "currentgames.h"
+#include "ipblacklist.h"
 #include "bnet.h"
 #include "map.h"
 #include "packed.h"
@@ -427,10 +428,18 @@ CGHost :: CGHost( CConfig *CFG )
 	m_UDPSocket->SetBroadcastTarget( CFG->GetString( "udp_broadcasttarget", string( ) ) );
 	m_UDPSocket->SetDontRoute( CFG->GetInt( "udp_dontroute", 0 ) == 0 ? false : true );
 	m_ReconnectSocket = NULL;
+	m_WakeSocket = new CWakeSocket( );
+	m_Callables = new CCallableInbox( m_WakeSocket );
+	m_GameCommands = new CCommandTable( );
+	CGame :: RegisterCommands( m_GameCommands );
+	m_GameCommands->Build( );
+	m_AdminGameCommands = new CCommandTable( );
+	CAdminGame :: RegisterCommands( m_AdminGameCommands );
+	m_AdminGameCommands->Build( );
+	m_BNETCommands = new CCommandTable( );
+	CBNET :: RegisterCommands( m_BNETCommands );
+	m_BNETCommands->Build( );
 	m_GPSProtocol = new CGPSProtocol( );
-	m_CRC = new CCRC32( );
-	m_CRC->Initialize( );
-	m_SHA = new CSHA1( );
 	m_CurrentGame = NULL;
 	string DBType = CFG->GetString( "db_type", "sqlite3" );
 	CONSOLE_Print( "[GHOST] opening primary database" );
@@ -550,6 +559,8 @@ CGHost :: CGHost( CConfig *CFG )
 	m_MasterBotMode = CFG->GetInt("master_bot_mode", 0) == 0 ? false : true;
 	m_ChildBotMode = CFG->GetInt("child_bot_mode", 0) == 0 ? false : true;
 	m_LiveDBCurrentGamesUpdateEnabled = CFG->GetInt("live_db_current_games_update", 0) == 0 ? false : true;
+	m_LiveGames = new CCurrentGames( this, CFG->GetInt( "live_db_current_games_interval", 2000 ) );
+	m_IPBlackList = new CIPBlackList( );
 	string GlobalSpeedHackVal = CFG->GetString("gs", string( ));
 	m_GlobalSpeed = GlobalSpeedHackVal.empty() ? 0 : UTIL_ToDouble(GlobalSpeedHackVal);
 	m_GlobalSpeed = m_GlobalSpeed < 0 || m_GlobalSpeed > 64 ? 0 : m_GlobalSpeed;
@@ -610,6 +621,9 @@ CGHost :: CGHost( CConfig *CFG )
 		uint32_t MaxMessageLength = CFG->GetInt( Prefix + "custom_maxmessagelength", 200 );	
 		string ChildrenBotsNames = CFG->GetString(Prefix + "childrenbots", string()); //New
 		string MasterBotsName = CFG->GetString(Prefix + "masterbotname", string());	//New
+		uint32_t FloodCapacity = CFG->GetInt( Prefix + "flood_capacity", 600 );
+		uint32_t FloodPacketCost = CFG->GetInt( Prefix + "flood_packetcost", 200 );
+		uint32_t FloodTicksPerByte = CFG->GetInt( Prefix + "flood_ticksperbyte", PasswordHashType == "pvpgn" ? 1 : 10 );
 
 		if( Server.empty( ) )
 			break;
@@ -649,7 +663,7 @@ CGHost :: CGHost( CConfig *CFG )
 #endif
 		}
 
-		m_BNETs.push_back( new CBNET( this, Server, ServerAlias, BNLSServer, (uint16_t)BNLSPort, (uint32_t)BNLSWardenCookie, CDKeyROC, CDKeyTFT, CountryAbbrev, Country, LocaleID, UserName, UserPassword, FirstChannel, RootAdmin, BNETCommandTrigger[0], HoldFriends, HoldClan, PublicCommands, War3Version, EXEVersion, EXEVersionHash, PasswordHashType, PVPGNRealmName, MaxMessageLength, ChildrenBotsNames, MasterBotsName, i ) );
+		m_BNETs.push_back( new CBNET( this, Server, ServerAlias, BNLSServer, (uint16_t)BNLSPort, (uint32_t)BNLSWardenCookie, CDKeyROC, CDKeyTFT, CountryAbbrev, Country, LocaleID, UserName, UserPassword, FirstChannel, RootAdmin, BNETCommandTrigger[0], HoldFriends, HoldClan, PublicCommands, War3Version, EXEVersion, EXEVersionHash, PasswordHashType, PVPGNRealmName, MaxMessageLength, ChildrenBotsNames, MasterBotsName, i, FloodCapacity, FloodPacketCost, FloodTicksPerByte ) );
 	}
 
 	if( m_BNETs.empty( ) )
@@ -739,8 +753,6 @@ CGHost :: ~CGHost( )
 		delete *i;
 
 	delete m_GPSProtocol;
-	delete m_CRC;
-	delete m_SHA;
 
 	for( vector<CBNET *> :: iterator i = m_BNETs.begin( ); i != m_BNETs.end( ); ++i )
 		delete *i;
@@ -756,13 +768,19 @@ CGHost :: ~CGHost( )
 	delete m_DB;
 	delete m_DBLocal;
 
-	// warning: we don't delete any entries of m_Callables here because we can't be guaranteed that the associated threads have terminated
+	// warning: we don't delete m_Callables (or m_WakeSocket) or any of its entries here because we can't be guaranteed that the associated threads have terminated
+	// the same goes for m_LiveGames and m_IPBlackList which the game threads keep using until they exit
 	// this is fine if the program is currently exiting because the OS will clean up after us
 	// but if you try to recreate the CGHost object within a single session you will probably leak resources!
 
-	if( !m_Callables.empty( ) )
-		CONSOLE_Print( "[GHOST] warning - " + UTIL_ToString( m_Callables.size( ) ) + " orphaned callables were leaked (this is not an error)" );
+	uint32_t LeakedCallables = m_Callables->GetSize( );
 
+	if( LeakedCallables > 0 )
+		CONSOLE_Print( "[GHOST] warning - " + UTIL_ToString( LeakedCallables ) + " orphaned callables were leaked (this is not an error)" );
+
+	delete m_GameCommands;
+	delete m_AdminGameCommands;
+	delete m_BNETCommands;
 	delete m_Language;
 	delete m_Map;
 	delete m_AdminMap;
@@ -865,13 +883,13 @@ bool CGHost :: Update( long usecBlock )
 			if( !m_AllGamesFinished )
 			{
 				CONSOLE_Print( "[GHOST] all games finished, waiting 60 seconds for threads to finish" );
-				CONSOLE_Print( "[GHOST] there are " + UTIL_ToString( m_Callables.size( ) ) + " threads in progress" );
+				CONSOLE_Print( "[GHOST] there are " + UTIL_ToString( m_Callables->GetSize( ) ) + " threads in progress" );
 				m_AllGamesFinished = true;
 				m_AllGamesFinishedTime = GetTime( );
 			}
 			else
 			{
-				if( m_Callables.empty( ) )
+				if( m_Callables->GetSize( ) == 0 )
 				{
 					CONSOLE_Print( "[GHOST] all threads finished, exiting nicely" );
 					m_Exiting = true;
@@ -879,7 +897,7 @@ bool CGHost :: Update( long usecBlock )
 				else if( GetTime( ) - m_AllGamesFinishedTime >= 60 )
 				{
 					CONSOLE_Print( "[GHOST] waited 60 seconds for threads to finish, exiting anyway" );
-					CONSOLE_Print( "[GHOST] there are " + UTIL_ToString( m_Callables.size( ) ) + " threads still in progress which will be terminated" );
+					CONSOLE_Print( "[GHOST] there are " + UTIL_ToString( m_Callables->GetSize( ) ) + " threads still in progress which will be terminated" );
 					m_Exiting = true;
 				}
 			}
@@ -887,21 +905,17 @@ bool CGHost :: Update( long usecBlock )
 	}
 
 	// update callables
-	boost::mutex::scoped_lock callablesLock( m_CallablesMutex );
+	// continuations for orphaned callables are never set so this just recovers and deletes the ones that are ready
 
-	for( vector<CBaseCallable *> :: iterator i = m_Callables.begin( ); i != m_Callables.end( ); )
-	{
-		if( (*i)->GetReady( ) )
-		{
-			m_DB->RecoverCallable( *i );
-			delete *i;
-			i = m_Callables.erase( i );
-		}
-		else
-			++i;
-	}
-	
-	callablesLock.unlock( );
+	m_Callables->Process( m_DB );
+
+	// publish the lobbies and games which changed since the last batch
+
+	m_LiveGames->Flush( m_LiveDBCurrentGamesUpdateEnabled );
+
+	// reload the IP blacklist if the file changed
+
+	m_IPBlackList->Update( );
 
 	// create the GProxy++ reconnect listener
 
@@ -945,6 +959,11 @@ bool CGHost :: Update( long usecBlock )
 	for( vector<CBNET *> :: iterator i = m_BNETs.begin( ); i != m_BNETs.end( ); ++i )
 		NumFDs += (*i)->SetFD( &fd, &send_fd, &nfds );
 
+	// 2. the wake socket which is signalled when a database callable completes
+
+	m_WakeSocket->SetFD( &fd, &send_fd, &nfds );
+	++NumFDs;
+
 	// 5. the GProxy++ reconnect socket(s)
 
 	if( m_Reconnect && m_ReconnectSocket )
@@ -970,6 +989,16 @@ bool CGHost :: Update( long usecBlock )
 			usecBlock = (*i)->GetNextTimedActionTicks( ) * 1000;
 	}
 
+	// also wake up when battle.net's flood protection lets the next queued packet out so chat and game refreshes aren't held back a whole interval
+
+	for( vector<CBNET *> :: iterator i = m_BNETs.begin( ); i != m_BNETs.end( ); ++i )
+	{
+		uint32_t NextSendTicks = (*i)->GetNextSendTicks( );
+
+		if( NextSendTicks < usecBlock / 1000 )
+			usecBlock = NextSendTicks * 1000;
+	}
+
 	// always block for at least 1ms just in case something goes wrong
 	// this prevents the bot from sucking up all the available CPU if a game keeps asking for immediate updates
 	// it's a bit ridiculous to include this check since, in theory, the bot is programmed well enough to never make this mistake
@@ -1002,6 +1031,8 @@ bool CGHost :: Update( long usecBlock )
 		MILLISLEEP( 50 );
 	}
 
+	m_WakeSocket->Drain( &fd );
+
 	bool AdminExit = false;
 	bool BNETExit = false;
 
@@ -1020,7 +1051,12 @@ bool CGHost :: Update( long usecBlock )
 		CTCPSocket *NewSocket = m_ReconnectSocket->Accept( &fd );
 
 		if( NewSocket )
-			m_ReconnectSockets.push_back( NewSocket );
+		{
+			if( m_IPBlackList->IsBlackListed( NewSocket->GetIPUInt32( ) ) )
+				delete NewSocket;
+			else
+				m_ReconnectSockets.push_back( NewSocket );
+		}
 	}
 
 	for( vector<CTCPSocket *> :: iterator i = m_ReconnectSockets.begin( ); i != m_ReconnectSockets.end( ); )
@@ -1052,21 +1088,26 @@ bool CGHost :: Update( long usecBlock )
 					{
 						if( Bytes[1] == CGPSProtocol :: GPS_RECONNECT && Length == 13 )
 						{
-							GProxyReconnector *Reconnector = new GProxyReconnector;
+							boost::shared_ptr<GProxyReconnector> Reconnector( new GProxyReconnector );
 							Reconnector->PID = Bytes[4];
 							Reconnector->ReconnectKey = UTIL_ByteArrayToUInt32( Bytes, false, 5 );
 							Reconnector->LastPacket = UTIL_ByteArrayToUInt32( Bytes, false, 9 );
 							Reconnector->PostedTime = GetTicks( );
 							Reconnector->socket = (*i);
+							Reconnector->State = RECONNECT_PENDING;
 							
 							// update the receive buffer
 							*RecvBuffer = RecvBuffer->substr( Length );
 							i = m_ReconnectSockets.erase( i );
 
-							// post in the reconnects buffer and wait to see if a game thread will pick it up
-							boost::mutex::scoped_lock lock( m_ReconnectMutex );
+							// we don't know which game the player belongs to so post the reconnect to every running game and wait to see if one of them claims it
 							m_PendingReconnects.push_back( Reconnector );
-							lock.unlock();
+							boost::mutex::scoped_lock lock( m_GamesMutex );
+
+							for( vector<CBaseGame *> :: iterator j = m_Games.begin( ); j != m_Games.end( ); ++j )
+								(*j)->PostReconnect( Reconnector );
+
+							lock.unlock( );
 							continue;
 						}
 						else
@@ -1102,26 +1143,33 @@ bool CGHost :: Update( long usecBlock )
 		++i;
 	}
 	
-	// delete any old pending reconnects that have not been handled by games
-	if( !m_PendingReconnects.empty( ) ) {
-		boost::mutex::scoped_lock lock( m_ReconnectMutex );
-	
-		for( vector<GProxyReconnector *> :: iterator i = m_PendingReconnects.begin( ); i != m_PendingReconnects.end( ); )
+	// forget reconnects which were claimed by a game and reject the ones which no game claimed in time
+	// the games hold their own references so the reconnector itself is deleted when the last one lets go
+
+	for( vector<boost::shared_ptr<GProxyReconnector> > :: iterator i = m_PendingReconnects.begin( ); i != m_PendingReconnects.end( ); )
+	{
+		if( (*i)->State == RECONNECT_CLAIMED )
+		{
+			i = m_PendingReconnects.erase( i );
+			continue;
+		}
+
+		if( GetTicks( ) - (*i)->PostedTime > 1500 )
 		{
-			if( GetTicks( ) - (*i)->PostedTime > 1500 )
+			int Expected = RECONNECT_PENDING;
+
+			if( (*i)->State.compare_exchange_strong( Expected, RECONNECT_EXPIRED ) )
 			{
 				(*i)->socket->PutBytes( m_GPSProtocol->SEND_GPSS_REJECT( REJECTGPS_NOTFOUND ) );
 				(*i)->socket->DoSend( &send_fd );
 				delete (*i)->socket;
-				delete (*i);
-				i = m_PendingReconnects.erase( i );
-				continue;
 			}
-			
-			i++;
+
+			i = m_PendingReconnects.erase( i );
+			continue;
 		}
-	
-		lock.unlock();
+
+		++i;
 	}
 
 	// autohost
@@ -1252,9 +1300,7 @@ void CGHost :: EventBNETGameRefreshFailed( CBNET *bnet )
 		if( m_AdminGame )
 			m_AdminGame->SendAllChat( m_Language->BNETGameHostingFailed( bnet->GetServer( ), m_CurrentGame->GetGameName( ) ) );
 
-		boost::mutex::scoped_lock sayLock( m_CurrentGame->m_SayGamesMutex );
-		m_CurrentGame->m_DoSayGames.push_back( m_Language->UnableToCreateGameTryAnotherName( bnet->GetServer( ), m_CurrentGame->GetGameName( ) ) );
-		sayLock.unlock( );
+		m_CurrentGame->PostSayGame( m_Language->UnableToCreateGameTryAnotherName( bnet->GetServer( ), m_CurrentGame->GetGameName( ) ) );
 
 		// we take the easy route and simply close the lobby if a refresh fails
 		// it's possible at least one refresh succeeded and therefore the game is still joinable on at least one battle.net (plus on the local network) but we don't keep track of that
@@ -1339,6 +1385,8 @@ void CGHost :: SetConfigs( CConfig *CFG )
 	m_MapCFGPath = UTIL_AddPathSeperator( CFG->GetString( "bot_mapcfgpath", string( ) ) );
 	m_SaveGamePath = UTIL_AddPathSeperator( CFG->GetString( "bot_savegamepath", string( ) ) );
 	m_MapPath = UTIL_AddPathSeperator( CFG->GetString( "bot_mappath", string( ) ) );
+	m_MapOptimize = CFG->GetInt( "bot_mapoptimize", 0 ) == 0 ? false : true;
+	m_MapOptimizeStrip = CFG->GetInt( "bot_mapoptimizestrip", 0 ) == 0 ? false : true;
 	m_SaveReplays = CFG->GetInt( "bot_savereplays", 0 ) == 0 ? false : true;
 	m_ReplayPath = UTIL_AddPathSeperator( CFG->GetString( "bot_replaypath", string( ) ) );
 	m_VirtualHostName = CFG->GetString( "bot_virtualhostname", "|cFF4080C0GHost" );
@@ -1365,9 +1413,11 @@ void CGHost :: SetConfigs( CConfig *CFG )
 	m_AutoKickPing = CFG->GetInt( "bot_autokickping", 400 );
 	m_BanMethod = CFG->GetInt( "bot_banmethod", 1 );
 	m_IPBlackListFile = CFG->GetString( "bot_ipblacklistfile", "ipblacklist.txt" );
+	m_IPBlackList->SetFile( m_IPBlackListFile );
 	m_LobbyTimeLimit = CFG->GetInt( "bot_lobbytimelimit", 10 );
 	m_Latency = CFG->GetInt( "bot_latency", 100 );
 	m_SyncLimit = CFG->GetInt( "bot_synclimit", 50 );
+	m_SlotInfoInterval = CFG->GetInt( "bot_slotinfointerval", 100 );
 	m_VoteKickAllowed = CFG->GetInt( "bot_votekickallowed", 1 ) == 0 ? false : true;
 	m_VoteKickPercentage = CFG->GetInt( "bot_votekickpercentage", 100 );
 	m_DropVoteTime = CFG->GetInt("bot_dropvotetime", 30);
@@ -1405,7 +1455,7 @@ void CGHost :: ExtractScripts( )
 void CGHost :: ExtractScriptsPre130( string PatchMPQFileName){
     MPQH PatchMPQ;
 
-    if( MPQ::SFileOpenArchive( PatchMPQFileName.c_str(), 0, MPQ_OPEN_FORCE_MPQ_V1, &PatchMPQ ) )
+    if( MPQ::SFileOpenArchive( PatchMPQFileName.c_str(), 0, MPQ_OPEN_FORCE_MPQ_V1 | MPQ_OPEN_PARALLEL_DECODE, &PatchMPQ ) )
     {
         CONSOLE_Print( "[GHOST] loading MPQ file [" + PatchMPQFileName + "]" );
         MPQH SubFile;
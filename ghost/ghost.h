@@ -30,25 +30,36 @@
 class CUDPSocket;
 class CTCPServer;
 class CTCPSocket;
+class CWakeSocket;
 class CGPSProtocol;
-class CCRC32;
-class CSHA1;
 class CBNET;
 class CBaseGame;
 class CAdminGame;
 class CGHostDB;
 class CBaseCallable;
+class CCallableInbox;
+class CCurrentGames;
+class CIPBlackList;
+class CCommandTable;
 class CLanguage;
 class CMap;
 class CSaveGame;
 class CConfig;
 
+// a reconnect is posted to every running game and whichever thread moves State away from RECONNECT_PENDING first owns the socket
+// either a game claims it for the matching player or the main thread expires it and rejects the connection
+
+#define RECONNECT_PENDING				0
+#define RECONNECT_CLAIMED				1
+#define RECONNECT_EXPIRED				2
+
 struct GProxyReconnector {
 	CTCPSocket *socket;
 	unsigned char PID;
 	uint32_t ReconnectKey;
 	uint32_t LastPacket;
 	uint32_t PostedTime;
+	boost::atomic<int> State;
 };
 
 class CGHost
@@ -58,8 +69,6 @@ public:
 	CTCPServer *m_ReconnectSocket;			// listening socket for GProxy++ reliable reconnects
 	vector<CTCPSocket *> m_ReconnectSockets;// vector of sockets attempting to reconnect (connected but not identified yet)
 	CGPSProtocol *m_GPSProtocol;
-	CCRC32 *m_CRC;							// for calculating CRC's
-	CSHA1 *m_SHA;							// for calculating SHA1's
 	vector<CBNET *> m_BNETs;				// all our battle.net connections (there can be more than one)
 	CBaseGame *m_CurrentGame;				// this game is still in the lobby state
 	CAdminGame *m_AdminGame;				// this "fake game" allows an admin who knows the password to control the bot from the local network
@@ -68,8 +77,13 @@ public:
 	boost::mutex m_GamesMutex;
 	CGHostDB *m_DB;							// database
 	CGHostDB *m_DBLocal;					// local database (for temporary data)
-	vector<CBaseCallable *> m_Callables;	// vector of orphaned callables waiting to die
-	boost::mutex m_CallablesMutex;
+	CWakeSocket *m_WakeSocket;				// wakes up the main loop when a callable owned by us or a battle.net connection completes
+	CCallableInbox *m_Callables;			// orphaned and fire-and-forget callables waiting to die
+	CCurrentGames *m_LiveGames;				// our lobbies and games as shown in the live current games list
+	CIPBlackList *m_IPBlackList;			// the IP blacklist shared by all games
+	CCommandTable *m_GameCommands;			// commands available in games
+	CCommandTable *m_AdminGameCommands;		// commands available in the admin game
+	CCommandTable *m_BNETCommands;			// commands available on battle.net
 	vector<BYTEARRAY> m_LocalAddresses;		// vector of local IP addresses
 	CLanguage *m_Language;					// language
 	CMap *m_Map;							// the currently loaded map
@@ -106,6 +120,8 @@ public:
 	string m_MapCFGPath;					// config value: map cfg path
 	string m_SaveGamePath;					// config value: savegame path
 	string m_MapPath;						// config value: map path
+	bool m_MapOptimize;						// config value: repack maps with the strongest compression before sending them to players
+	bool m_MapOptimizeStrip;				// config value: also strip files the clients don't need from repacked maps
 	bool m_SaveReplays;						// config value: save replays
 	string m_ReplayPath;					// config value: replay path
 	string m_VirtualHostName;				// config value: virtual host name
@@ -129,6 +145,7 @@ public:
 	uint32_t m_LobbyTimeLimit;				// config value: auto close the game lobby after this many minutes without any reserved players
 	uint32_t m_Latency;						// config value: the latency (by default)
 	uint32_t m_SyncLimit;					// config value: the maximum number of packets a player can fall out of sync before starting the lag screen (by default)
+	uint32_t m_SlotInfoInterval;			// config value: the minimum time between two slot info updates in a lobby (in milliseconds)
 	bool m_VoteKickAllowed;					// config value: if votekicks are allowed or not
 	uint32_t m_VoteKickPercentage;			// config value: percentage of players required to vote yes for a votekick to pass
 	string m_DefaultMap;					// config value: default map (map.cfg)
@@ -146,8 +163,7 @@ public:
 	bool m_TCPNoDelay;						// config value: use Nagle's algorithm or not
 	uint32_t m_MatchMakingMethod;			// config value: the matchmaking method
 	uint32_t m_MapGameType;					// config value: the MapGameType overwrite (aka: refresh hack)
-	vector<GProxyReconnector *> m_PendingReconnects;
-	boost::mutex m_ReconnectMutex;
+	vector<boost::shared_ptr<GProxyReconnector> > m_PendingReconnects;	// reconnects posted to the games, only touched by the main thread
 	bool m_AutoBan;							// if we have auto ban on by default or not	
 	uint32_t m_AutoBanTeamDiffMax;			// if we have more then x number of players more then other team
 	uint32_t m_AutoBanTimer;				// time in mins the auto ban will stay on in game.
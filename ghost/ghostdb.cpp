@@ -21,6 +21,7 @@
 #include "ghost.h"
 #include "util.h"
 #include "config.h"
+#include "socket.h"
 #include "ghostdb.h"
 //#include <boost/thread.hpp>  // delete this
 
@@ -315,7 +316,141 @@ void CBaseCallable :: Init( )
 void CBaseCallable :: Close( )
 {
 	m_EndTicks = GetTicks( );
-	m_Ready = true;
+	SetReady( true );
+}
+
+void CBaseCallable :: SetReady( bool nReady )
+{
+	// the post happens while holding m_InboxMutex so that an inbox being orphaned can't be deleted underneath us
+	// this must be the last thing the database thread does with the callable because it may be deleted as soon as the lock is released
+
+	boost::mutex::scoped_lock lock( m_InboxMutex );
+	m_Ready = nReady;
+
+	if( m_Ready && m_Inbox )
+		m_Inbox->Post( this );
+}
+
+void CBaseCallable :: SetInbox( CCallableInbox *nInbox, const boost::function<void( )> &nContinuation )
+{
+	boost::mutex::scoped_lock lock( m_InboxMutex );
+	m_Inbox = nInbox;
+	m_Continuation = nContinuation;
+
+	// some databases (e.g. SQLite) complete the callable before returning it so it might already be ready
+
+	if( m_Inbox )
+		m_Inbox->Insert( this, m_Ready );
+}
+
+//
+// CCallableInbox
+//
+
+CCallableInbox :: CCallableInbox( CWakeSocket *nWakeSocket ) : m_WakeSocket( nWakeSocket )
+{
+
+}
+
+CCallableInbox :: ~CCallableInbox( )
+{
+	// warning: we don't delete any callables here because we can't be guaranteed that the associated threads have terminated
+	// owners must call Orphan before deleting their inbox, CGHost's inbox is simply leaked on exit
+	// the wake socket belongs to the owner since it may be shared by several inboxes
+}
+
+uint32_t CCallableInbox :: GetSize( )
+{
+	boost::mutex::scoped_lock lock( m_Mutex );
+	return m_Pending.size( ) + m_Completed.size( );
+}
+
+void CCallableInbox :: Insert( CBaseCallable *callable, bool ready )
+{
+	// called with the callable's m_InboxMutex held
+
+	boost::mutex::scoped_lock lock( m_Mutex );
+
+	if( ready )
+		m_Completed.push_back( callable );
+	else
+		m_Pending.insert( callable );
+
+	lock.unlock( );
+
+	if( ready && m_WakeSocket )
+		m_WakeSocket->Wake( );
+}
+
+void CCallableInbox :: Add( CBaseCallable *callable )
+{
+	if( callable )
+		callable->SetInbox( this, boost::function<void( )>( ) );
+}
+
+void CCallableInbox :: Post( CBaseCallable *callable )
+{
+	// called from a database thread with the callable's m_InboxMutex held
+
+	boost::mutex::scoped_lock lock( m_Mutex );
+	m_Pending.erase( callable );
+	m_Completed.push_back( callable );
+	lock.unlock( );
+
+	if( m_WakeSocket )
+		m_WakeSocket->Wake( );
+}
+
+uint32_t CCallableInbox :: Process( CGHostDB *DB )
+{
+	boost::mutex::scoped_lock lock( m_Mutex );
+
+	if( m_Completed.empty( ) )
+		return 0;
+
+	vector<CBaseCallable *> Completed;
+	Completed.swap( m_Completed );
+	lock.unlock( );
+
+	for( vector<CBaseCallable *> :: iterator i = Completed.begin( ); i != Completed.end( ); ++i )
+	{
+		// wait for the database thread to release the callable (it posts while holding the lock)
+
+		boost::function<void( )> Continuation;
+		boost::mutex::scoped_lock callableLock( (*i)->m_InboxMutex );
+		Continuation.swap( (*i)->m_Continuation );
+		callableLock.unlock( );
+
+		if( Continuation )
+			Continuation( );
+
+		DB->RecoverCallable( *i );
+		delete *i;
+	}
+
+	return Completed.size( );
+}
+
+void CCallableInbox :: Orphan( CCallableInbox *orphans )
+{
+	// hand every callable over to another inbox without running the continuations
+	// we can't hold m_Mutex while retargeting because the database threads lock the callable first and the inbox second
+
+	boost::mutex::scoped_lock lock( m_Mutex );
+	vector<CBaseCallable *> Callables( m_Pending.begin( ), m_Pending.end( ) );
+	Callables.insert( Callables.end( ), m_Completed.begin( ), m_Completed.end( ) );
+	m_Pending.clear( );
+	m_Completed.clear( );
+	lock.unlock( );
+
+	for( vector<CBaseCallable *> :: iterator i = Callables.begin( ); i != Callables.end( ); ++i )
+		(*i)->SetInbox( orphans, boost::function<void( )>( ) );
+
+	// anything that completed while we were retargeting was posted here as well as inserted into the orphans inbox
+	// so the copy here must be forgotten rather than processed
+
+	lock.lock( );
+	m_Completed.clear( );
 }
 
 CCallableAdminCount :: ~CCallableAdminCount( )
@@ -720,11 +855,6 @@ CDBCurrentGame::CDBCurrentGame()
 }
 
 
-uint32_t CGHostDB::CurrentGameUpdate(uint32_t nBotID, unsigned char nAction, string nParam, string nCreatorName, string nOwnerName, string nGameName, string nNames, string nMapName, string nCreatedAt, string nStartedAt, string nExpireDate, bool nGameStarted, uint32_t nGameRandomID, bool nClearAll, uint8_t nOccupiedSlots, uint8_t nMaxSlots)
-{
-	return 0;
-}
-
 vector<CDBCurrentGame*> CGHostDB::CurrentGamesQuery(bool includelobbies, bool includestarted, uint32_t queryoffset, uint32_t querylimit, uint32_t& outlobbiescount, uint32_t& outgamescount)
 {
 	vector<CDBCurrentGame*> Res;
@@ -735,6 +865,11 @@ vector<CDBCurrentGame*> CGHostDB::CurrentGamesQuery(bool includelobbies, bool in
 	return Res;
 }
 
+bool CGHostDB :: CurrentGamesPublish( uint32_t botid, bool clearall, vector<CDBCurrentGame> games, vector<uint32_t> removed )
+{
+	return false;
+}
+
 
 //
 // CGHostDB
@@ -760,12 +895,12 @@ CCallableDotATopPlayersQuery* CGHostDB::ThreadedDotATopPlayersQuery(string serve
 	return NULL;
 }
 
-CCallableCurrentGameUpdate* CGHostDB::ThreadedCurrentGameUpdate(uint32_t nBotID, unsigned char nAction, string nParam, string nCreatorName, string nOwnerName, string nGameName, string nNames, string nMapName, string nCreatedAt, string nStartedAt, string nExpireDate, bool nGameStarted, uint32_t nGameRandomID, bool nClearAll, uint8_t nOccupiedSlots, uint8_t nMaxSlots)
+CCallableCurrentGamesQuery* CGHostDB::ThreadedCurrentGamesQuery(bool includelobbies, bool includestarted, uint32_t queryoffset, uint32_t querylimit)
 {
 	return NULL;
 }
 
-CCallableCurrentGamesQuery* CGHostDB::ThreadedCurrentGamesQuery(bool includelobbies, bool includestarted, uint32_t queryoffset, uint32_t querylimit)
+CCallableCurrentGamesPublish *CGHostDB :: ThreadedCurrentGamesPublish( uint32_t botid, bool clearall, vector<CDBCurrentGame> games, vector<uint32_t> removed )
 {
 	return NULL;
 }
@@ -811,13 +946,13 @@ CCallableDotATopPlayersQuery :: ~CCallableDotATopPlayersQuery()
 	delete m_Result;
 }
 
-CCallableCurrentGameUpdate :: ~CCallableCurrentGameUpdate()
-{
-	
-}
-
 CCallableCurrentGamesQuery :: ~CCallableCurrentGamesQuery()
 {
 	for (vector<CDBCurrentGame*> ::iterator i = m_Result.begin(); i != m_Result.end(); ++i)
 		delete* i;
+}
+
+CCallableCurrentGamesPublish :: ~CCallableCurrentGamesPublish( )
+{
+
 }
\ No newline at end of file
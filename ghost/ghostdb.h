@@ -21,10 +21,18 @@
 #ifndef GHOSTDB_H
 #define GHOSTDB_H
 
+#include <boost/function.hpp>
+#include <boost/bind/bind.hpp>
+
+using boost::placeholders::_1;
+
 //
 // CGHostDB
 //
 
+class CWakeSocket;
+class CGHostDB;
+class CCallableInbox;
 class CBaseCallable;
 class CCallableAdminCount;
 class CCallableAdminCheck;
@@ -45,8 +53,8 @@ class CCallableDotAPlayerSummaryCheck;
 class CCallableDotAPlayerSummaryCheckNew;	//New
 class CCallableDotATopPlayersQuery;			//New
 class CCallableDotAPlayerStatsUpdate;		//New
-class CCallableCurrentGameUpdate;			//New
 class CCallableCurrentGamesQuery;			//New
+class CCallableCurrentGamesPublish;
 class CCallableDownloadAdd;
 class CCallableScoreCheck;
 class CCallableW3MMDPlayerAdd;
@@ -116,8 +124,8 @@ public:
 	virtual bool W3MMDVarAdd( uint32_t gameid, map<VarP,string> var_strings );
 	virtual CDBDotAPlayerSummaryNew* DotAPlayerSummaryCheckNew(string name); //New
 	virtual CDBDotATopPlayers* DotAPlayerTopPlayersQuery(string name); //New
-	virtual uint32_t CurrentGameUpdate(uint32_t nBotID, unsigned char nAction, string nParam, string nCreatorName, string nOwnerName, string nGameName, string nNames, string nMapName, string nCreatedAt, string nStartedAt, string nExpireDate, bool nGameStarted, uint32_t nGameRandomID, bool nClearAll, uint8_t nOccupiedSlots, uint8_t nMaxSlots); //New
 	virtual vector<CDBCurrentGame*> CurrentGamesQuery(bool includelobbies, bool includestarted, uint32_t queryoffset, uint32_t querylimit, uint32_t& outlobbiescount, uint32_t& outgamescount);
+	virtual bool CurrentGamesPublish( uint32_t botid, bool clearall, vector<CDBCurrentGame> games, vector<uint32_t> removed );
 
 	//probably StatsUpdate func is missing here, thats why the program crashes when you try to call the inherited func???????? (or not?) <--------------
 
@@ -152,8 +160,8 @@ public:
 	virtual CCallableDotAPlayerSummaryCheckNew* ThreadedDotAPlayerSummaryCheckNew(string servername, string name, string mingames, string gamestate);
 	virtual CCallableDotATopPlayersQuery* ThreadedDotATopPlayersQuery(string server, string mingames, uint32_t offset, uint32_t count);
 	virtual CCallableDotAPlayerStatsUpdate* ThreadedDotAPlayerStatsUpdate(string servername, string name, CDBDotAPlayer* nDotAPlayer, CDBDotAGame* nDotAGame, uint32_t nBaseRating, uint32_t nOpponentAvgRaing);
-	virtual CCallableCurrentGameUpdate* ThreadedCurrentGameUpdate(uint32_t nBotID, unsigned char nAction, string nParam, string nCreatorName, string nOwnerName, string nGameName, string nNames, string nMapName, string nCreatedAt, string nStartedAt, string nExpireDate, bool nGameStarted, uint32_t nGameRandomID, bool nClearAll, uint8_t nOccupiedSlots, uint8_t nMaxSlots);
 	virtual CCallableCurrentGamesQuery* ThreadedCurrentGamesQuery(bool includelobbies, bool includestarted, uint32_t queryoffset, uint32_t querylimit);
+	virtual CCallableCurrentGamesPublish *ThreadedCurrentGamesPublish( uint32_t botid, bool clearall, vector<CDBCurrentGame> games, vector<uint32_t> removed );
 
 };
 
@@ -166,30 +174,37 @@ public:
 //  - initially the callable is NOT ready (i.e. m_Ready = false)
 //  - the ThreadedXXX function normally creates a thread to perform some query and (potentially) store some result in the callable
 //  - at the time of this writing all threads are immediately detached, the code does not join any threads (the callable's "readiness" is used for this purpose instead)
-//  - when the thread completes it will set m_Ready = true
+//  - when the thread completes it will call SetReady( true ) which posts the callable to the inbox it was added to (if any)
 //  - DO NOT DO *ANYTHING* TO THE CALLABLE UNTIL IT'S READY OR YOU WILL CREATE A CONCURRENCY MESS
-//  - THE ONLY SAFE FUNCTION IN THE CALLABLE IS GetReady
+//  - THE ONLY SAFE FUNCTIONS IN THE CALLABLE ARE GetReady AND SetInbox (which is what CCallableInbox :: Add uses)
 //  - when the callable is ready you may access the callable's result which will have been set within the (now terminated) thread
 
 // example usage:
-//  - normally you will call a ThreadedXXX function, store the callable in a vector, and periodically check if the callable is ready
-//  - when the callable is ready you will consume the result then you will pass the callable back to the database via the RecoverCallable function
+//  - normally you will call a ThreadedXXX function and immediately add the callable to your inbox along with a continuation
+//  - e.g. m_Callables->Add( m_GHost->m_DB->ThreadedBanCheck( ... ), boost::bind( &CGame :: EventCallableBanCheck, this, User, _1 ) )
+//  - when the callable completes it's queued in the inbox and the inbox's wake socket (if any) is signalled so the owner's select( ) returns immediately
+//  - the owner calls CCallableInbox :: Process from its own thread which runs each continuation, passes the callable back to the database via RecoverCallable, and deletes it
 //  - the RecoverCallable function allows the database to recover some of the callable's resources to be reused later (e.g. MySQL connections)
-//  - note that this will NOT free the callable's memory, you must do that yourself after calling the RecoverCallable function
 //  - be careful not to leak any callables, it's NOT safe to delete a callable even if you decide that you don't want the result anymore
-//  - you should deliver any to-be-orphaned callables to the main vector in CGHost so they can be properly deleted when ready even if you don't care about the result anymore
-//  - e.g. if a player does a stats check immediately before a game is deleted you can't just delete the callable on game deletion unless it's ready
+//  - callables you don't care about can be added without a continuation to the inbox in CGHost (m_GHost->m_Callables)
+//  - when the owner is deleted it must call CCallableInbox :: Orphan to hand its outstanding callables over to the inbox in CGHost
+//  - orphaned callables never run their continuation (which would reference the dead owner), they're only recovered and deleted when ready
 
 class CBaseCallable
 {
+	friend class CCallableInbox;
+
 protected:
 	string m_Error;
 	volatile bool m_Ready;
 	uint32_t m_StartTicks;
 	uint32_t m_EndTicks;
+	boost::mutex m_InboxMutex;					// protects m_Ready transitions, m_Inbox and m_Continuation
+	CCallableInbox *m_Inbox;					// where to post this callable when it becomes ready
+	boost::function<void( )> m_Continuation;	// what to run in the owner's thread once this callable is ready
 
 public:
-	CBaseCallable( ) : m_Error( ), m_Ready( false ), m_StartTicks( 0 ), m_EndTicks( 0 ) { }
+	CBaseCallable( ) : m_Error( ), m_Ready( false ), m_StartTicks( 0 ), m_EndTicks( 0 ), m_Inbox( NULL ) { }
 	virtual ~CBaseCallable( ) { }
 
 	virtual void operator( )( ) { }
@@ -199,10 +214,58 @@ public:
 
 	virtual string GetError( )				{ return m_Error; }
 	virtual bool GetReady( )				{ return m_Ready; }
-	virtual void SetReady( bool nReady )	{ m_Ready = nReady; }
+	virtual void SetReady( bool nReady );
+	virtual void SetInbox( CCallableInbox *nInbox, const boost::function<void( )> &nContinuation );
 	virtual uint32_t GetElapsed( )			{ return m_Ready ? m_EndTicks - m_StartTicks : 0; }
 };
 
+//
+// CCallableInbox
+//
+
+// a completion queue for callables owned by one object (a game, a battle.net connection, or CGHost itself)
+// callables are posted here from the database threads when they complete and their continuations are run by the owner in Process
+
+class CCallableInbox
+{
+	friend class CBaseCallable;
+
+private:
+	boost::mutex m_Mutex;
+	set<CBaseCallable *> m_Pending;			// callables which haven't completed yet
+	vector<CBaseCallable *> m_Completed;	// callables which have completed but haven't been processed yet
+	CWakeSocket *m_WakeSocket;				// signalled whenever a callable completes (may be NULL or shared, not owned by the inbox)
+
+	void Insert( CBaseCallable *callable, bool ready );
+
+public:
+	CCallableInbox( CWakeSocket *nWakeSocket );
+	~CCallableInbox( );
+
+	CWakeSocket *GetWakeSocket( )			{ return m_WakeSocket; }
+	uint32_t GetSize( );
+
+	// add a callable whose result nobody cares about, it will be recovered and deleted when ready
+
+	void Add( CBaseCallable *callable );
+
+	// add a callable along with a continuation which is called with the (ready) callable as its only argument
+	// the continuation runs in the thread which calls Process, the callable is deleted when it returns
+
+	template<class T, class F> void Add( T *callable, F continuation )
+	{
+		if( callable )
+		{
+			boost::function<void( T * )> Continuation( continuation );
+			callable->SetInbox( this, boost::bind( Continuation, callable ) );
+		}
+	}
+
+	void Post( CBaseCallable *callable );
+	uint32_t Process( CGHostDB *DB );
+	void Orphan( CCallableInbox *orphans );
+};
+
 class CCallableAdminCount : virtual public CBaseCallable
 {
 protected:
@@ -554,17 +617,18 @@ protected:
 	vector<CDBCurrentGame*> m_Result;
 
 public:
-	CCallableCurrentGamesQuery(bool nIncludeLobbies, bool nIncludeStarted, uint32_t nQueryOffset, uint32_t nQueryLimit) : CBaseCallable(), m_IncludeLobbies(nIncludeLobbies), m_IncludeStarted(nIncludeStarted), m_QueryOffset(nQueryOffset), m_QueryLimit(nQueryLimit) { }
+	CCallableCurrentGamesQuery(bool nIncludeLobbies, bool nIncludeStarted, uint32_t nQueryOffset, uint32_t nQueryLimit) : CBaseCallable(), m_IncludeLobbies(nIncludeLobbies), m_IncludeStarted(nIncludeStarted), m_QueryOffset(nQueryOffset), m_QueryLimit(nQueryLimit), m_TotalLobbyCount(0), m_TotalGameCount(0) { }
 	virtual ~CCallableCurrentGamesQuery();
 
 	virtual bool AreLobbiesIncluded() { return m_IncludeLobbies; }
 	virtual bool AreStartedGamesIncluded() { return m_IncludeStarted; }
 	virtual uint32_t GetQueryOffset() { return m_QueryOffset; }
 	virtual uint32_t GetQueryLimit() { return m_QueryLimit; }
-	virtual bool GetTotalLobbyCount() { return m_TotalLobbyCount; }
-	virtual bool GetTotalOngoingGameCount() { return m_TotalGameCount; }
+	virtual uint32_t GetTotalLobbyCount() { return m_TotalLobbyCount; }
+	virtual uint32_t GetTotalOngoingGameCount() { return m_TotalGameCount; }
 	virtual vector<CDBCurrentGame*> GetResult() { return m_Result; }
 	virtual void SetResult(vector<CDBCurrentGame*> nResult) { m_Result = nResult; }
+	virtual void SetTotals(uint32_t nTotalLobbyCount, uint32_t nTotalGameCount) { m_TotalLobbyCount = nTotalLobbyCount; m_TotalGameCount = nTotalGameCount; }
 };
 
 class CCallableDownloadAdd : virtual public CBaseCallable
@@ -1186,36 +1250,23 @@ public:
 	virtual void SetResult(uint32_t nResult) { m_Result = nResult; }
 };
 
-class CCallableCurrentGameUpdate : virtual public CBaseCallable
+// writes every changed row of the bot's current games in one batch (see CCurrentGames)
+
+class CCallableCurrentGamesPublish : virtual public CBaseCallable
 {
 protected:
 	uint32_t m_BotID;
-	unsigned char m_Action;
-	string m_Param;
-	string m_CreatorName;
-	string m_OwnerName;
-	string m_GameName;
-	string m_Names;
-	string m_MapName;
-	string m_CreatedAt;
-	string m_StartedAt;
-	string m_ExpireDate;
-	bool m_GameStarted;
-	uint32_t m_GameRandomID;
-	bool m_ClearAll;
-	uint8_t m_OccupiedSlots;
-	uint8_t m_MaxSlots;
-	uint32_t m_Result;
+	bool m_ClearAll;					// remove every row of this bot before writing the batch
+	vector<CDBCurrentGame> m_Games;		// rows to insert or replace
+	vector<uint32_t> m_Removed;			// game random ids whose rows should be deleted
+	bool m_Result;
 
 public:
-	CCallableCurrentGameUpdate(uint32_t nBotID, unsigned char nAction, string nParam, string nCreatorName, string nOwnerName, string nGameName, string nNames, string nMapName, string nCreatedAt, string nStartedAt, string nExpireDate, bool nGameStarted, uint32_t nGameRandomID, bool nClearAll, uint8_t nOccupiedSlots, uint8_t nMaxSlots) : CBaseCallable(),
-		m_BotID(nBotID), m_Action(nAction), m_Param(nParam), m_CreatorName(nCreatorName), m_OwnerName(nOwnerName), m_GameName(nGameName), m_Names(nNames), m_MapName(nMapName), m_CreatedAt(nCreatedAt), m_ExpireDate(nExpireDate), m_GameStarted(nGameStarted), m_GameRandomID(nGameRandomID), m_ClearAll(nClearAll), m_OccupiedSlots(nOccupiedSlots), m_MaxSlots(nMaxSlots), m_Result(0) { }
-	virtual ~CCallableCurrentGameUpdate();
+	CCallableCurrentGamesPublish( uint32_t nBotID, bool nClearAll, vector<CDBCurrentGame> nGames, vector<uint32_t> nRemoved ) : CBaseCallable( ), m_BotID( nBotID ), m_ClearAll( nClearAll ), m_Games( nGames ), m_Removed( nRemoved ), m_Result( false ) { }
+	virtual ~CCallableCurrentGamesPublish( );
 
-	virtual uint32_t GetGameRandomID() { return m_GameRandomID; }
-	virtual void SetGameRandomID(uint32_t nGameRandomID) { m_GameRandomID = nGameRandomID; }
-	virtual uint32_t GetResult() { return m_Result; }
-	virtual void SetResult(uint32_t nResult) { m_Result = nResult; }
+	virtual bool GetResult( )				{ return m_Result; }
+	virtual void SetResult( bool nResult )	{ m_Result = nResult; }
 };
 
 //---------------------------------------------------------------------------------------------//
@@ -28,6 +28,7 @@
 #include "elorating2.h"
 
 #include <signal.h>
+#include <time.h>
 
 #ifdef WIN32
  #include <winsock.h>
@@ -36,6 +37,158 @@
 #include <mysql/mysql.h>
 #include <boost/thread.hpp>
 
+// MySQL 8 dropped my_bool in favour of bool
+
+#if MYSQL_VERSION_ID >= 80000
+ typedef bool my_bool;
+#endif
+
+//
+// CMySQLConnection
+//
+
+CMySQLConnection :: CMySQLConnection( CGHostDBMySQL *nDB )
+{
+	m_DB = nDB;
+	m_MySQL = NULL;
+	m_ThreadID = 0;
+	m_LastUsedTicks = GetTicks( );
+	m_LastActiveTicks = m_LastUsedTicks;
+}
+
+CMySQLConnection :: ~CMySQLConnection( )
+{
+	ClearStatements( );
+
+	if( m_MySQL )
+		mysql_close( (MYSQL *)m_MySQL );
+}
+
+bool CMySQLConnection :: Connect( string server, string database, string user, string password, uint16_t port, string *error )
+{
+	m_LastUsedTicks = GetTicks( );
+
+	if( m_MySQL )
+	{
+		// a connection which talked to the server recently is assumed to be alive, if it isn't the query fails and the client library reconnects for the next one
+		// this saves a round trip to the server for every callable when the bot is busy
+
+		if( GetTicks( ) - m_LastActiveTicks < m_DB->GetPingInterval( ) * 1000 )
+		{
+			m_LastActiveTicks = GetTicks( );
+			return true;
+		}
+
+		if( Ping( error ) )
+			return true;
+
+		// the client library couldn't bring the connection back so start over with a new one
+
+		ClearStatements( );
+		mysql_close( (MYSQL *)m_MySQL );
+		m_MySQL = NULL;
+	}
+
+	if( !m_DB->CanConnect( error ) )
+		return false;
+
+	if( !( m_MySQL = mysql_init( NULL ) ) )
+	{
+		*error = "error initializing MySQL connection";
+		m_DB->ConnectResult( false, *error );
+		return false;
+	}
+
+	bool Reconnect = true;
+	mysql_options( (MYSQL *)m_MySQL, MYSQL_OPT_RECONNECT, &Reconnect );
+
+	if( !( mysql_real_connect( (MYSQL *)m_MySQL, server.c_str( ), user.c_str( ), password.c_str( ), database.c_str( ), port, NULL, 0 ) ) )
+	{
+		*error = mysql_error( (MYSQL *)m_MySQL );
+		mysql_close( (MYSQL *)m_MySQL );
+		m_MySQL = NULL;
+		m_DB->ConnectResult( false, *error );
+		return false;
+	}
+
+	m_ThreadID = mysql_thread_id( (MYSQL *)m_MySQL );
+	m_LastActiveTicks = GetTicks( );
+	m_DB->ConnectResult( true, string( ) );
+	return true;
+}
+
+bool CMySQLConnection :: Ping( string *error )
+{
+	if( !m_MySQL )
+	{
+		*error = "not connected";
+		return false;
+	}
+
+	if( mysql_ping( (MYSQL *)m_MySQL ) != 0 )
+	{
+		*error = mysql_error( (MYSQL *)m_MySQL );
+		return false;
+	}
+
+	m_LastActiveTicks = GetTicks( );
+	return true;
+}
+
+void *CMySQLConnection :: GetStatement( string query, string *error )
+{
+	// the client library reconnects automatically when it finds the connection has been dropped
+	// prepared statements don't survive that so throw them all away if we're talking to a different server thread than before
+
+	if( mysql_thread_id( (MYSQL *)m_MySQL ) != m_ThreadID )
+	{
+		ClearStatements( );
+		m_ThreadID = mysql_thread_id( (MYSQL *)m_MySQL );
+	}
+
+	map<string, void *> :: iterator i = m_Statements.find( query );
+
+	if( i != m_Statements.end( ) )
+		return i->second;
+
+	MYSQL_STMT *Statement = mysql_stmt_init( (MYSQL *)m_MySQL );
+
+	if( !Statement )
+	{
+		*error = mysql_error( (MYSQL *)m_MySQL );
+		return NULL;
+	}
+
+	if( mysql_stmt_prepare( Statement, query.c_str( ), query.size( ) ) != 0 )
+	{
+		*error = mysql_stmt_error( Statement );
+		mysql_stmt_close( Statement );
+		return NULL;
+	}
+
+	m_Statements[query] = Statement;
+	return Statement;
+}
+
+void CMySQLConnection :: DropStatement( string query )
+{
+	map<string, void *> :: iterator i = m_Statements.find( query );
+
+	if( i != m_Statements.end( ) )
+	{
+		mysql_stmt_close( (MYSQL_STMT *)i->second );
+		m_Statements.erase( i );
+	}
+}
+
+void CMySQLConnection :: ClearStatements( )
+{
+	for( map<string, void *> :: iterator i = m_Statements.begin( ); i != m_Statements.end( ); ++i )
+		mysql_stmt_close( (MYSQL_STMT *)i->second );
+
+	m_Statements.clear( );
+}
+
 //
 // CGHostDBMySQL
 //
@@ -48,47 +201,69 @@ CGHostDBMySQL :: CGHostDBMySQL( CConfig *CFG ) : CGHostDB( CFG )
 	m_Password = CFG->GetString( "db_mysql_password", string( ) );
 	m_Port = CFG->GetInt( "db_mysql_port", 0 );
 	m_BotID = CFG->GetInt( "db_mysql_botid", 0 );
+	m_MinConnections = CFG->GetInt( "db_mysql_minconnections", 2 );
+	m_MaxIdleConnections = CFG->GetInt( "db_mysql_maxidleconnections", 30 );
+	m_PingInterval = CFG->GetInt( "db_mysql_pinginterval", 60 );
+	m_IdleTimeout = CFG->GetInt( "db_mysql_idletimeout", 600 );
+	m_MaxBackoff = CFG->GetInt( "db_mysql_maxbackoff", 60 );
 	m_NumConnections = 1;
 	m_OutstandingCallables = 0;
+	m_ConnectFailures = 0;
+	m_NextConnectTicks = 0;
+	m_MaintenanceThread = NULL;
+	m_Exiting = false;
+
+	if( m_MinConnections == 0 )
+		m_MinConnections = 1;
+
+	if( m_PingInterval == 0 )
+		m_PingInterval = 1;
 
 	mysql_library_init( 0, NULL, NULL );
 
 	// create the first connection
 
 	CONSOLE_Print( "[MYSQL] connecting to database server" );
-	MYSQL *Connection = NULL;
+	CMySQLConnection *Connection = new CMySQLConnection( this );
+	string Error;
 
-	if( !( Connection = mysql_init( NULL ) ) )
+	if( !Connection->Connect( m_Server, m_Database, m_User, m_Password, m_Port, &Error ) )
 	{
-		CONSOLE_Print( string( "[MYSQL] " ) + mysql_error( Connection ) );
+		CONSOLE_Print( "[MYSQL] " + Error );
+		delete Connection;
 		m_HasError = true;
-		m_Error = "error initializing MySQL connection";
+		m_Error = "error connecting to MySQL server";
 		return;
 	}
 
-	bool Reconnect = true;
-	mysql_options( Connection, MYSQL_OPT_RECONNECT, &Reconnect );
+	m_IdleConnections.push_back( Connection );
 
-	if( !( mysql_real_connect( Connection, m_Server.c_str( ), m_User.c_str( ), m_Password.c_str( ), m_Database.c_str( ), m_Port, NULL, 0 ) ) )
-	{
-		CONSOLE_Print( string( "[MYSQL] " ) + mysql_error( Connection ) );
-		m_HasError = true;
-		m_Error = "error connecting to MySQL server";
-		return;
-	}
+	// the rest of the pool is opened by the maintenance thread so we don't hold up startup
 
-	m_IdleConnections.push( Connection );
+	m_MaintenanceThread = new boost::thread( boost::bind( &CGHostDBMySQL :: MaintenanceThread, this ) );
 }
 
 CGHostDBMySQL :: ~CGHostDBMySQL( )
 {
+	if( m_MaintenanceThread )
+	{
+		{
+			boost::mutex::scoped_lock lock( m_DatabaseMutex );
+			m_Exiting = true;
+		}
+
+		m_MaintenanceCond.notify_all( );
+		m_MaintenanceThread->join( );
+		delete m_MaintenanceThread;
+	}
+
 	boost::mutex::scoped_lock lock(m_DatabaseMutex);
 	CONSOLE_Print( "[MYSQL] closing " + UTIL_ToString( m_IdleConnections.size( ) ) + "/" + UTIL_ToString( m_NumConnections ) + " idle MySQL connections" );
 
 	while( !m_IdleConnections.empty( ) )
 	{
-		mysql_close( (MYSQL *)m_IdleConnections.front( ) );
-		m_IdleConnections.pop( );
+		delete m_IdleConnections.front( );
+		m_IdleConnections.pop_front( );
 	}
 
 	if( m_OutstandingCallables > 0 )
@@ -99,7 +274,13 @@ CGHostDBMySQL :: ~CGHostDBMySQL( )
 
 string CGHostDBMySQL :: GetStatus( )
 {
-	return "DB STATUS --- Connections: " + UTIL_ToString( m_IdleConnections.size( ) ) + "/" + UTIL_ToString( m_NumConnections ) + " idle. Outstanding callables: " + UTIL_ToString( m_OutstandingCallables ) + ".";
+	boost::mutex::scoped_lock lock( m_DatabaseMutex );
+	string Status = "DB STATUS --- Connections: " + UTIL_ToString( m_IdleConnections.size( ) ) + "/" + UTIL_ToString( m_NumConnections ) + " idle. Outstanding callables: " + UTIL_ToString( m_OutstandingCallables ) + ".";
+
+	if( m_ConnectFailures > 0 )
+		Status += " Reconnecting after " + UTIL_ToString( m_ConnectFailures ) + " failed attempts.";
+
+	return Status;
 }
 
 void CGHostDBMySQL :: RecoverCallable( CBaseCallable *callable )
@@ -109,13 +290,17 @@ void CGHostDBMySQL :: RecoverCallable( CBaseCallable *callable )
 
 	if( MySQLCallable )
 	{
-		if( m_IdleConnections.size( ) > 30 )
+		// connections which never managed to connect aren't worth keeping, the maintenance thread will open new ones if we drop below the minimum
+
+		CMySQLConnection *Connection = MySQLCallable->GetConnection( );
+
+		if( !Connection->GetMySQL( ) || m_IdleConnections.size( ) >= m_MaxIdleConnections )
 		{
-			mysql_close( (MYSQL *)MySQLCallable->GetConnection( ) );
+			delete Connection;
 			--m_NumConnections;
 		}
 		else
-			m_IdleConnections.push( MySQLCallable->GetConnection( ) );
+			m_IdleConnections.push_back( Connection );
 
 		if( m_OutstandingCallables == 0 )
 			CONSOLE_Print( "[MYSQL] recovered a mysql callable with zero outstanding" );
@@ -129,6 +314,132 @@ void CGHostDBMySQL :: RecoverCallable( CBaseCallable *callable )
 		CONSOLE_Print( "[MYSQL] tried to recover a non-mysql callable" );
 }
 
+bool CGHostDBMySQL :: CanConnect( string *error )
+{
+	boost::mutex::scoped_lock lock( m_DatabaseMutex );
+
+	if( m_ConnectFailures > 0 && (int32_t)( m_NextConnectTicks - GetTicks( ) ) > 0 )
+	{
+		*error = "not connecting to MySQL server for another " + UTIL_ToString( ( m_NextConnectTicks - GetTicks( ) ) / 1000 + 1 ) + " seconds after " + UTIL_ToString( m_ConnectFailures ) + " failed attempts";
+		return false;
+	}
+
+	return true;
+}
+
+void CGHostDBMySQL :: ConnectResult( bool success, string error )
+{
+	boost::mutex::scoped_lock lock( m_DatabaseMutex );
+
+	if( success )
+	{
+		if( m_ConnectFailures > 0 )
+			CONSOLE_Print( "[MYSQL] connected to database server after " + UTIL_ToString( m_ConnectFailures ) + " failed attempts" );
+
+		m_ConnectFailures = 0;
+	}
+	else
+	{
+		// back off 1, 2, 4, ... seconds up to m_MaxBackoff
+
+		++m_ConnectFailures;
+		uint32_t Backoff = m_MaxBackoff;
+
+		if( m_ConnectFailures <= 16 && (uint32_t)( 1 << ( m_ConnectFailures - 1 ) ) < m_MaxBackoff )
+			Backoff = 1 << ( m_ConnectFailures - 1 );
+
+		m_NextConnectTicks = GetTicks( ) + Backoff * 1000;
+		CONSOLE_Print( "[MYSQL] error connecting to database server [" + error + "], waiting " + UTIL_ToString( Backoff ) + " seconds before trying again" );
+	}
+}
+
+void CGHostDBMySQL :: MaintenanceThread( )
+{
+	mysql_thread_init( );
+	boost::mutex::scoped_lock lock( m_DatabaseMutex );
+
+	while( !m_Exiting )
+	{
+		// keep the pool warm so the first callables of a busy evening don't all have to connect first
+
+		while( m_NumConnections < m_MinConnections && !m_Exiting )
+		{
+			++m_NumConnections;
+			lock.unlock( );
+			CMySQLConnection *Connection = new CMySQLConnection( this );
+			string Error;
+			bool Success = Connection->Connect( m_Server, m_Database, m_User, m_Password, m_Port, &Error );
+			lock.lock( );
+
+			if( !Success )
+			{
+				delete Connection;
+				--m_NumConnections;
+				break;
+			}
+
+			m_IdleConnections.push_front( Connection );
+		}
+
+		// take out the idle connections which need attention
+		// connections above the minimum which haven't been used for m_IdleTimeout seconds are closed, the others are pinged so the server doesn't time them out
+
+		vector<CMySQLConnection *> Close;
+		vector<CMySQLConnection *> Ping;
+		uint32_t Ticks = GetTicks( );
+
+		for( deque<CMySQLConnection *> :: iterator i = m_IdleConnections.begin( ); i != m_IdleConnections.end( ); )
+		{
+			if( Ticks - (*i)->GetLastUsedTicks( ) >= m_IdleTimeout * 1000 && m_NumConnections - Close.size( ) > m_MinConnections )
+			{
+				Close.push_back( *i );
+				i = m_IdleConnections.erase( i );
+			}
+			else if( Ticks - (*i)->GetLastActiveTicks( ) >= m_PingInterval * 1000 )
+			{
+				Ping.push_back( *i );
+				i = m_IdleConnections.erase( i );
+			}
+			else
+				++i;
+		}
+
+		lock.unlock( );
+
+		for( vector<CMySQLConnection *> :: iterator i = Close.begin( ); i != Close.end( ); ++i )
+			delete *i;
+
+		vector<CMySQLConnection *> Alive;
+
+		for( vector<CMySQLConnection *> :: iterator i = Ping.begin( ); i != Ping.end( ); ++i )
+		{
+			string Error;
+
+			if( (*i)->Ping( &Error ) )
+				Alive.push_back( *i );
+			else
+			{
+				CONSOLE_Print( "[MYSQL] dropping idle connection [" + Error + "]" );
+				delete *i;
+			}
+		}
+
+		lock.lock( );
+		m_NumConnections -= Close.size( ) + Ping.size( ) - Alive.size( );
+
+		// pinging doesn't count as being used so the pinged connections go back to the front (least recently used)
+
+		for( vector<CMySQLConnection *> :: reverse_iterator i = Alive.rbegin( ); i != Alive.rend( ); ++i )
+			m_IdleConnections.push_front( *i );
+
+		if( !m_Exiting )
+			m_MaintenanceCond.timed_wait( lock, boost::posix_time::seconds( 10 ) );
+	}
+
+	lock.unlock( );
+	mysql_thread_end( );
+}
+
 void CGHostDBMySQL :: CreateThread( CBaseCallable *callable )
 {
 	try
@@ -154,10 +465,7 @@ void CGHostDBMySQL :: CreateThread( CBaseCallable *callable )
 
 CCallableAdminCount *CGHostDBMySQL :: ThreadedAdminCount( string server )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		++m_NumConnections;
+	CMySQLConnection *Connection = GetIdleConnection( );
 
 	CCallableAdminCount *Callable = new CMySQLCallableAdminCount( server, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
@@ -167,10 +475,7 @@ CCallableAdminCount *CGHostDBMySQL :: ThreadedAdminCount( string server )
 
 CCallableAdminCheck *CGHostDBMySQL :: ThreadedAdminCheck( string server, string user )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		++m_NumConnections;
+	CMySQLConnection *Connection = GetIdleConnection( );
 
 	CCallableAdminCheck *Callable = new CMySQLCallableAdminCheck( server, user, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
@@ -180,10 +485,7 @@ CCallableAdminCheck *CGHostDBMySQL :: ThreadedAdminCheck( string server, string
 
 CCallableAdminAdd *CGHostDBMySQL :: ThreadedAdminAdd( string server, string user )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		++m_NumConnections;
+	CMySQLConnection *Connection = GetIdleConnection( );
 
 	CCallableAdminAdd *Callable = new CMySQLCallableAdminAdd( server, user, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
@@ -193,10 +495,7 @@ CCallableAdminAdd *CGHostDBMySQL :: ThreadedAdminAdd( string server, string user
 
 CCallableAdminRemove *CGHostDBMySQL :: ThreadedAdminRemove( string server, string user )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		++m_NumConnections;
+	CMySQLConnection *Connection = GetIdleConnection( );
 
 	CCallableAdminRemove *Callable = new CMySQLCallableAdminRemove( server, user, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
@@ -206,10 +505,7 @@ CCallableAdminRemove *CGHostDBMySQL :: ThreadedAdminRemove( string server, strin
 
 CCallableAdminList *CGHostDBMySQL :: ThreadedAdminList( string server )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		++m_NumConnections;
+	CMySQLConnection *Connection = GetIdleConnection( );
 
 	CCallableAdminList *Callable = new CMySQLCallableAdminList( server, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
@@ -219,10 +515,7 @@ CCallableAdminList *CGHostDBMySQL :: ThreadedAdminList( string server )
 
 CCallableBanCount *CGHostDBMySQL :: ThreadedBanCount( string server )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		++m_NumConnections;
+	CMySQLConnection *Connection = GetIdleConnection( );
 
 	CCallableBanCount *Callable = new CMySQLCallableBanCount( server, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
@@ -232,10 +525,7 @@ CCallableBanCount *CGHostDBMySQL :: ThreadedBanCount( string server )
 
 CCallableBanCheck *CGHostDBMySQL :: ThreadedBanCheck( string server, string user, string ip )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		++m_NumConnections;
+	CMySQLConnection *Connection = GetIdleConnection( );
 
 	CCallableBanCheck *Callable = new CMySQLCallableBanCheck( server, user, ip, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
@@ -245,10 +535,7 @@ CCallableBanCheck *CGHostDBMySQL :: ThreadedBanCheck( string server, string user
 
 CCallableBanAdd *CGHostDBMySQL :: ThreadedBanAdd( string server, string user, string ip, string gamename, string admin, string reason )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		++m_NumConnections;
+	CMySQLConnection *Connection = GetIdleConnection( );
 
 	CCallableBanAdd *Callable = new CMySQLCallableBanAdd( server, user, ip, gamename, admin, reason, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
@@ -258,10 +545,7 @@ CCallableBanAdd *CGHostDBMySQL :: ThreadedBanAdd( string server, string user, st
 
 CCallableBanRemove *CGHostDBMySQL :: ThreadedBanRemove( string server, string user )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		++m_NumConnections;
+	CMySQLConnection *Connection = GetIdleConnection( );
 
 	CCallableBanRemove *Callable = new CMySQLCallableBanRemove( server, user, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
@@ -271,10 +555,7 @@ CCallableBanRemove *CGHostDBMySQL :: ThreadedBanRemove( string server, string us
 
 CCallableBanRemove *CGHostDBMySQL :: ThreadedBanRemove( string user )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		++m_NumConnections;
+	CMySQLConnection *Connection = GetIdleConnection( );
 
 	CCallableBanRemove *Callable = new CMySQLCallableBanRemove( string( ), user, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
@@ -284,10 +565,7 @@ CCallableBanRemove *CGHostDBMySQL :: ThreadedBanRemove( string user )
 
 CCallableBanList *CGHostDBMySQL :: ThreadedBanList( string server )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		++m_NumConnections;
+	CMySQLConnection *Connection = GetIdleConnection( );
 
 	CCallableBanList *Callable = new CMySQLCallableBanList( server, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
@@ -297,10 +575,7 @@ CCallableBanList *CGHostDBMySQL :: ThreadedBanList( string server )
 
 CCallableGameAdd *CGHostDBMySQL :: ThreadedGameAdd( string server, string map, string gamename, string ownername, uint32_t duration, uint32_t gamestate, string creatorname, string creatorserver )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		++m_NumConnections;
+	CMySQLConnection *Connection = GetIdleConnection( );
 
 	CCallableGameAdd *Callable = new CMySQLCallableGameAdd( server, map, gamename, ownername, duration, gamestate, creatorname, creatorserver, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
@@ -310,10 +585,7 @@ CCallableGameAdd *CGHostDBMySQL :: ThreadedGameAdd( string server, string map, s
 
 CCallableGamePlayerAdd *CGHostDBMySQL :: ThreadedGamePlayerAdd( uint32_t gameid, string name, string ip, uint32_t spoofed, string spoofedrealm, uint32_t reserved, uint32_t loadingtime, uint32_t left, string leftreason, uint32_t team, uint32_t colour )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		++m_NumConnections;
+	CMySQLConnection *Connection = GetIdleConnection( );
 
 	CCallableGamePlayerAdd *Callable = new CMySQLCallableGamePlayerAdd( gameid, name, ip, spoofed, spoofedrealm, reserved, loadingtime, left, leftreason, team, colour, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
@@ -323,10 +595,7 @@ CCallableGamePlayerAdd *CGHostDBMySQL :: ThreadedGamePlayerAdd( uint32_t gameid,
 
 CCallableGamePlayerSummaryCheck *CGHostDBMySQL :: ThreadedGamePlayerSummaryCheck( string name )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		++m_NumConnections;
+	CMySQLConnection *Connection = GetIdleConnection( );
 
 	CCallableGamePlayerSummaryCheck *Callable = new CMySQLCallableGamePlayerSummaryCheck( name, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
@@ -336,10 +605,7 @@ CCallableGamePlayerSummaryCheck *CGHostDBMySQL :: ThreadedGamePlayerSummaryCheck
 
 CCallableDotAGameAdd *CGHostDBMySQL :: ThreadedDotAGameAdd( uint32_t gameid, uint32_t winner, uint32_t min, uint32_t sec )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		++m_NumConnections;
+	CMySQLConnection *Connection = GetIdleConnection( );
 
 	CCallableDotAGameAdd *Callable = new CMySQLCallableDotAGameAdd( gameid, winner, min, sec, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
@@ -349,10 +615,7 @@ CCallableDotAGameAdd *CGHostDBMySQL :: ThreadedDotAGameAdd( uint32_t gameid, uin
 
 CCallableDotAPlayerAdd *CGHostDBMySQL :: ThreadedDotAPlayerAdd( uint32_t gameid, uint32_t colour, uint32_t kills, uint32_t deaths, uint32_t creepkills, uint32_t creepdenies, uint32_t assists, uint32_t gold, uint32_t neutralkills, string item1, string item2, string item3, string item4, string item5, string item6, string hero, uint32_t newcolour, uint32_t towerkills, uint32_t raxkills, uint32_t courierkills )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		++m_NumConnections;
+	CMySQLConnection *Connection = GetIdleConnection( );
 
 	CCallableDotAPlayerAdd *Callable = new CMySQLCallableDotAPlayerAdd( gameid, colour, kills, deaths, creepkills, creepdenies, assists, gold, neutralkills, item1, item2, item3, item4, item5, item6, hero, newcolour, towerkills, raxkills, courierkills, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
@@ -362,10 +625,7 @@ CCallableDotAPlayerAdd *CGHostDBMySQL :: ThreadedDotAPlayerAdd( uint32_t gameid,
 
 CCallableDotAPlayerSummaryCheck *CGHostDBMySQL :: ThreadedDotAPlayerSummaryCheck( string name )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		++m_NumConnections;
+	CMySQLConnection *Connection = GetIdleConnection( );
 
 	CCallableDotAPlayerSummaryCheck *Callable = new CMySQLCallableDotAPlayerSummaryCheck( name, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
@@ -375,10 +635,7 @@ CCallableDotAPlayerSummaryCheck *CGHostDBMySQL :: ThreadedDotAPlayerSummaryCheck
 
 CCallableDownloadAdd *CGHostDBMySQL :: ThreadedDownloadAdd( string map, uint32_t mapsize, string name, string ip, uint32_t spoofed, string spoofedrealm, uint32_t downloadtime )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		++m_NumConnections;
+	CMySQLConnection *Connection = GetIdleConnection( );
 
 	CCallableDownloadAdd *Callable = new CMySQLCallableDownloadAdd( map, mapsize, name, ip, spoofed, spoofedrealm, downloadtime, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
@@ -388,10 +645,7 @@ CCallableDownloadAdd *CGHostDBMySQL :: ThreadedDownloadAdd( string map, uint32_t
 
 CCallableScoreCheck *CGHostDBMySQL :: ThreadedScoreCheck( string category, string name, string server )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		++m_NumConnections;
+	CMySQLConnection *Connection = GetIdleConnection( );
 
 	CCallableScoreCheck *Callable = new CMySQLCallableScoreCheck( category, name, server, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
@@ -401,10 +655,7 @@ CCallableScoreCheck *CGHostDBMySQL :: ThreadedScoreCheck( string category, strin
 
 CCallableW3MMDPlayerAdd *CGHostDBMySQL :: ThreadedW3MMDPlayerAdd( string category, uint32_t gameid, uint32_t pid, string name, string flag, uint32_t leaver, uint32_t practicing )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		++m_NumConnections;
+	CMySQLConnection *Connection = GetIdleConnection( );
 
 	CCallableW3MMDPlayerAdd *Callable = new CMySQLCallableW3MMDPlayerAdd( category, gameid, pid, name, flag, leaver, practicing, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
@@ -414,10 +665,7 @@ CCallableW3MMDPlayerAdd *CGHostDBMySQL :: ThreadedW3MMDPlayerAdd( string categor
 
 CCallableW3MMDVarAdd *CGHostDBMySQL :: ThreadedW3MMDVarAdd( uint32_t gameid, map<VarP,int32_t> var_ints )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		++m_NumConnections;
+	CMySQLConnection *Connection = GetIdleConnection( );
 
 	CCallableW3MMDVarAdd *Callable = new CMySQLCallableW3MMDVarAdd( gameid, var_ints, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
@@ -427,10 +675,7 @@ CCallableW3MMDVarAdd *CGHostDBMySQL :: ThreadedW3MMDVarAdd( uint32_t gameid, map
 
 CCallableW3MMDVarAdd *CGHostDBMySQL :: ThreadedW3MMDVarAdd( uint32_t gameid, map<VarP,double> var_reals )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		++m_NumConnections;
+	CMySQLConnection *Connection = GetIdleConnection( );
 
 	CCallableW3MMDVarAdd *Callable = new CMySQLCallableW3MMDVarAdd( gameid, var_reals, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
@@ -440,10 +685,7 @@ CCallableW3MMDVarAdd *CGHostDBMySQL :: ThreadedW3MMDVarAdd( uint32_t gameid, map
 
 CCallableW3MMDVarAdd *CGHostDBMySQL :: ThreadedW3MMDVarAdd( uint32_t gameid, map<VarP,string> var_strings )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		++m_NumConnections;
+	CMySQLConnection *Connection = GetIdleConnection( );
 
 	CCallableW3MMDVarAdd *Callable = new CMySQLCallableW3MMDVarAdd( gameid, var_strings, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
@@ -451,15 +693,23 @@ CCallableW3MMDVarAdd *CGHostDBMySQL :: ThreadedW3MMDVarAdd( uint32_t gameid, map
 	return Callable;
 }
 
-void *CGHostDBMySQL :: GetIdleConnection( )
+CMySQLConnection *CGHostDBMySQL :: GetIdleConnection( )
 {
+	// hand out the most recently used connection since it's the most likely to still be alive and to have its statements prepared already
+	// the callable connects a new connection itself (in its own thread) so we never block here
+
 	boost::mutex::scoped_lock lock(m_DatabaseMutex);
-	void *Connection = NULL;
+	CMySQLConnection *Connection = NULL;
 
 	if( !m_IdleConnections.empty( ) )
 	{
-		Connection = m_IdleConnections.front( );
-		m_IdleConnections.pop( );
+		Connection = m_IdleConnections.back( );
+		m_IdleConnections.pop_back( );
+	}
+	else
+	{
+		Connection = new CMySQLConnection( this );
+		++m_NumConnections;
 	}
 
 	return Connection;
@@ -505,6 +755,158 @@ vector<string> MySQLFetchRow( MYSQL_RES *res )
 // global helper functions
 //
 
+//
+// CMySQLBindings
+//
+
+// the parameters or result columns of a prepared statement
+// the values live in deques so their addresses don't change as more bindings are added
+
+class CMySQLBindings
+{
+private:
+	vector<MYSQL_BIND> m_Binds;
+	deque<string> m_Strings;
+	deque<uint32_t> m_Ints;
+	deque<unsigned long> m_Lengths;
+	deque<my_bool> m_Nulls;
+	deque< vector<char> > m_Buffers;
+
+	MYSQL_BIND *Add( enum_field_types type )
+	{
+		MYSQL_BIND Bind;
+		memset( &Bind, 0, sizeof( MYSQL_BIND ) );
+		Bind.buffer_type = type;
+		m_Binds.push_back( Bind );
+		return &m_Binds.back( );
+	}
+
+public:
+	MYSQL_BIND *GetBinds( )		{ return m_Binds.empty( ) ? NULL : &m_Binds[0]; }
+
+	// parameters
+
+	void AddString( string value )
+	{
+		m_Strings.push_back( value );
+		m_Lengths.push_back( value.size( ) );
+		MYSQL_BIND *Bind = Add( MYSQL_TYPE_STRING );
+		Bind->buffer = (void *)m_Strings.back( ).data( );
+		Bind->buffer_length = m_Lengths.back( );
+		Bind->length = &m_Lengths.back( );
+	}
+
+	void AddNullableString( string value )
+	{
+		// an empty string is sent as NULL
+
+		AddString( value );
+		m_Nulls.push_back( value.empty( ) );
+		m_Binds.back( ).is_null = &m_Nulls.back( );
+	}
+
+	void AddUInt32( uint32_t value )
+	{
+		m_Ints.push_back( value );
+		MYSQL_BIND *Bind = Add( MYSQL_TYPE_LONG );
+		Bind->buffer = &m_Ints.back( );
+		Bind->is_unsigned = 1;
+	}
+
+	// result columns (the client library converts whatever the server sends, e.g. SUM returns a DECIMAL)
+
+	void AddUInt32Result( )
+	{
+		m_Ints.push_back( 0 );
+		m_Nulls.push_back( 0 );
+		MYSQL_BIND *Bind = Add( MYSQL_TYPE_LONG );
+		Bind->buffer = &m_Ints.back( );
+		Bind->is_unsigned = 1;
+		Bind->is_null = &m_Nulls.back( );
+	}
+
+	void AddStringResult( )
+	{
+		m_Buffers.push_back( vector<char>( 256 ) );
+		m_Lengths.push_back( 0 );
+		m_Nulls.push_back( 0 );
+		MYSQL_BIND *Bind = Add( MYSQL_TYPE_STRING );
+		Bind->buffer = &m_Buffers.back( )[0];
+		Bind->buffer_length = m_Buffers.back( ).size( );
+		Bind->length = &m_Lengths.back( );
+		Bind->is_null = &m_Nulls.back( );
+	}
+
+	uint32_t GetUInt32( unsigned int column )
+	{
+		MYSQL_BIND &Bind = m_Binds[column];
+		return *Bind.is_null ? 0 : *(uint32_t *)Bind.buffer;
+	}
+
+	string GetString( MYSQL_STMT *statement, unsigned int column )
+	{
+		MYSQL_BIND &Bind = m_Binds[column];
+
+		if( *Bind.is_null )
+			return string( );
+
+		if( *Bind.length <= Bind.buffer_length )
+			return string( (char *)Bind.buffer, *Bind.length );
+
+		// the value didn't fit in the buffer, fetch it again into one which is big enough
+
+		vector<char> Buffer( *Bind.length );
+		MYSQL_BIND Column;
+		memset( &Column, 0, sizeof( MYSQL_BIND ) );
+		Column.buffer_type = MYSQL_TYPE_STRING;
+		Column.buffer = &Buffer[0];
+		Column.buffer_length = Buffer.size( );
+
+		if( mysql_stmt_fetch_column( statement, &Column, column, 0 ) != 0 )
+			return string( (char *)Bind.buffer, Bind.buffer_length );
+
+		return string( &Buffer[0], Buffer.size( ) );
+	}
+};
+
+// run a statement from the connection's statement cache
+// returns NULL and sets error if it couldn't be run, otherwise the caller must call mysql_stmt_free_result when it's done with the results
+
+MYSQL_STMT *MySQLExecute( CMySQLConnection *conn, string *error, string query, CMySQLBindings &params )
+{
+	MYSQL_STMT *Statement = (MYSQL_STMT *)conn->GetStatement( query, error );
+
+	if( !Statement )
+		return NULL;
+
+	if( ( params.GetBinds( ) && mysql_stmt_bind_param( Statement, params.GetBinds( ) ) != 0 ) || mysql_stmt_execute( Statement ) != 0 )
+	{
+		*error = mysql_stmt_error( Statement );
+		conn->DropStatement( query );
+		return NULL;
+	}
+
+	return Statement;
+}
+
+// fetch the first row of a statement's results into the result bindings, returns false if there were no rows (or on error)
+
+bool MySQLFetch( MYSQL_STMT *statement, string *error, CMySQLBindings &results )
+{
+	if( mysql_stmt_bind_result( statement, results.GetBinds( ) ) != 0 )
+	{
+		*error = mysql_stmt_error( statement );
+		return false;
+	}
+
+	int RC = mysql_stmt_fetch( statement );
+
+	if( RC == 1 )
+		*error = mysql_stmt_error( statement );
+
+	return RC == 0 || RC == MYSQL_DATA_TRUNCATED;
+}
+
 uint32_t MySQLAdminCount( void *conn, string *error, uint32_t botid, string server )
 {
 	string EscServer = MySQLEscapeString( conn, server );
@@ -658,39 +1060,36 @@ uint32_t MySQLBanCount( void *conn, string *error, uint32_t botid, string server
 	return Count;
 }
 
-CDBBan *MySQLBanCheck( void *conn, string *error, uint32_t botid, string server, string user, string ip )
+CDBBan *MySQLBanCheck( CMySQLConnection *conn, string *error, uint32_t botid, string server, string user, string ip )
 {
 	transform( user.begin( ), user.end( ), user.begin( ), (int(*)(int))tolower );
-	string EscServer = MySQLEscapeString( conn, server );
-	string EscUser = MySQLEscapeString( conn, user );
-	string EscIP = MySQLEscapeString( conn, ip );
 	CDBBan *Ban = NULL;
+	CMySQLBindings Params;
 	string Query;
+	Params.AddString( server );
+	Params.AddString( user );
 
 	if( ip.empty( ) )
-		Query = "SELECT name, ip, DATE(date), gamename, `admin`, reason FROM bans WHERE server='" + EscServer + "' AND name='" + EscUser + "'";
+		Query = "SELECT name, ip, DATE(date), gamename, `admin`, reason FROM bans WHERE server=? AND name=?";
 	else
-		Query = "SELECT name, ip, DATE(date), gamename, `admin`, reason FROM bans WHERE (server='" + EscServer + "' AND name='" + EscUser + "') OR ip='" + EscIP + "'";
+	{
+		Query = "SELECT name, ip, DATE(date), gamename, `admin`, reason FROM bans WHERE (server=? AND name=?) OR ip=?";
+		Params.AddString( ip );
+	}
 
-	if( mysql_real_query( (MYSQL *)conn, Query.c_str( ), Query.size( ) ) != 0 )
-		*error = mysql_error( (MYSQL *)conn );
-	else
+	MYSQL_STMT *Statement = MySQLExecute( conn, error, Query, Params );
+
+	if( Statement )
 	{
-		MYSQL_RES *Result = mysql_store_result( (MYSQL *)conn );
+		CMySQLBindings Row;
 
-		if( Result )
-		{
-			vector<string> Row = MySQLFetchRow( Result );
+		for( unsigned int i = 0; i < 6; ++i )
+			Row.AddStringResult( );
 
-			if( Row.size( ) == 6 )
-				Ban = new CDBBan( server, Row[0], Row[1], Row[2], Row[3], Row[4], Row[5] );
-			/* else
-				*error = "error checking ban [" + server + " : " + user + "] - row doesn't have 6 columns"; */
+		if( MySQLFetch( Statement, error, Row ) )
+			Ban = new CDBBan( server, Row.GetString( Statement, 0 ), Row.GetString( Statement, 1 ), Row.GetString( Statement, 2 ), Row.GetString( Statement, 3 ), Row.GetString( Statement, 4 ), Row.GetString( Statement, 5 ) );
 
-			mysql_free_result( Result );
-		}
-		else
-			*error = mysql_error( (MYSQL *)conn );
+		mysql_stmt_free_result( Statement );
 	}
 
 	return Ban;
@@ -778,39 +1177,54 @@ vector<CDBBan *> MySQLBanList( void *conn, string *error, uint32_t botid, string
 	return BanList;
 }
 
-uint32_t MySQLGameAdd( void *conn, string *error, uint32_t botid, string server, string map, string gamename, string ownername, uint32_t duration, uint32_t gamestate, string creatorname, string creatorserver )
+uint32_t MySQLGameAdd( CMySQLConnection *conn, string *error, uint32_t botid, string server, string map, string gamename, string ownername, uint32_t duration, uint32_t gamestate, string creatorname, string creatorserver )
 {
 	uint32_t RowID = 0;
-	string EscServer = MySQLEscapeString( conn, server );
-	string EscMap = MySQLEscapeString( conn, map );
-	string EscGameName = MySQLEscapeString( conn, gamename );
-	string EscOwnerName = MySQLEscapeString( conn, ownername );
-	string EscCreatorName = MySQLEscapeString( conn, creatorname );
-	string EscCreatorServer = MySQLEscapeString( conn, creatorserver );
-	string Query = "INSERT INTO games ( botid, server, map, datetime, gamename, ownername, duration, gamestate, creatorname, creatorserver ) VALUES ( " + UTIL_ToString( botid ) + ", '" + EscServer + "', '" + EscMap + "', NOW( ), '" + EscGameName + "', '" + EscOwnerName + "', " + UTIL_ToString( duration ) + ", " + UTIL_ToString( gamestate ) + ", '" + EscCreatorName + "', '" + EscCreatorServer + "' )";
-
-	if( mysql_real_query( (MYSQL *)conn, Query.c_str( ), Query.size( ) ) != 0 )
-		*error = mysql_error( (MYSQL *)conn );
-	else
-		RowID = mysql_insert_id( (MYSQL *)conn );
+	CMySQLBindings Params;
+	Params.AddUInt32( botid );
+	Params.AddString( server );
+	Params.AddString( map );
+	Params.AddString( gamename );
+	Params.AddString( ownername );
+	Params.AddUInt32( duration );
+	Params.AddUInt32( gamestate );
+	Params.AddString( creatorname );
+	Params.AddString( creatorserver );
+	MYSQL_STMT *Statement = MySQLExecute( conn, error, "INSERT INTO games ( botid, server, map, datetime, gamename, ownername, duration, gamestate, creatorname, creatorserver ) VALUES ( ?, ?, ?, NOW( ), ?, ?, ?, ?, ?, ? )", Params );
+
+	if( Statement )
+	{
+		RowID = mysql_stmt_insert_id( Statement );
+		mysql_stmt_free_result( Statement );
+	}
 
 	return RowID;
 }
 
-uint32_t MySQLGamePlayerAdd( void *conn, string *error, uint32_t botid, uint32_t gameid, string name, string ip, uint32_t spoofed, string spoofedrealm, uint32_t reserved, uint32_t loadingtime, uint32_t left, string leftreason, uint32_t team, uint32_t colour )
+uint32_t MySQLGamePlayerAdd( CMySQLConnection *conn, string *error, uint32_t botid, uint32_t gameid, string name, string ip, uint32_t spoofed, string spoofedrealm, uint32_t reserved, uint32_t loadingtime, uint32_t left, string leftreason, uint32_t team, uint32_t colour )
 {
 	transform( name.begin( ), name.end( ), name.begin( ), (int(*)(int))tolower );
 	uint32_t RowID = 0;
-	string EscName = MySQLEscapeString( conn, name );
-	string EscIP = MySQLEscapeString( conn, ip );
-	string EscSpoofedRealm = MySQLEscapeString( conn, spoofedrealm );
-	string EscLeftReason = MySQLEscapeString( conn, leftreason );
-	string Query = "INSERT INTO gameplayers ( botid, gameid, name, ip, spoofed, reserved, loadingtime, `left`, leftreason, team, colour, spoofedrealm ) VALUES ( " + UTIL_ToString( botid ) + ", " + UTIL_ToString( gameid ) + ", '" + EscName + "', '" + EscIP + "', " + UTIL_ToString( spoofed ) + ", " + UTIL_ToString( reserved ) + ", " + UTIL_ToString( loadingtime ) + ", " + UTIL_ToString( left ) + ", '" + EscLeftReason + "', " + UTIL_ToString( team ) + ", " + UTIL_ToString( colour ) + ", '" + EscSpoofedRealm + "' )";
-
-	if( mysql_real_query( (MYSQL *)conn, Query.c_str( ), Query.size( ) ) != 0 )
-		*error = mysql_error( (MYSQL *)conn );
-	else
-		RowID = mysql_insert_id( (MYSQL *)conn );
+	CMySQLBindings Params;
+	Params.AddUInt32( botid );
+	Params.AddUInt32( gameid );
+	Params.AddString( name );
+	Params.AddString( ip );
+	Params.AddUInt32( spoofed );
+	Params.AddUInt32( reserved );
+	Params.AddUInt32( loadingtime );
+	Params.AddUInt32( left );
+	Params.AddString( leftreason );
+	Params.AddUInt32( team );
+	Params.AddUInt32( colour );
+	Params.AddString( spoofedrealm );
+	MYSQL_STMT *Statement = MySQLExecute( conn, error, "INSERT INTO gameplayers ( botid, gameid, name, ip, spoofed, reserved, loadingtime, `left`, leftreason, team, colour, spoofedrealm ) VALUES ( ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ? )", Params );
+
+	if( Statement )
+	{
+		RowID = mysql_stmt_insert_id( Statement );
+		mysql_stmt_free_result( Statement );
+	}
 
 	return RowID;
 }
@@ -893,105 +1307,69 @@ uint32_t MySQLDotAPlayerAdd( void *conn, string *error, uint32_t botid, uint32_t
 	return RowID;
 }
 
-CDBDotAPlayerSummary *MySQLDotAPlayerSummaryCheck( void *conn, string *error, uint32_t botid, string name )
+CDBDotAPlayerSummary *MySQLDotAPlayerSummaryCheck( CMySQLConnection *conn, string *error, uint32_t botid, string name )
 {
 	transform( name.begin( ), name.end( ), name.begin( ), (int(*)(int))tolower );
-	string EscName = MySQLEscapeString( conn, name );
 	CDBDotAPlayerSummary *DotAPlayerSummary = NULL;
-	string Query = "SELECT COUNT(dotaplayers.id), SUM(kills), SUM(deaths), SUM(creepkills), SUM(creepdenies), SUM(assists), SUM(neutralkills), SUM(towerkills), SUM(raxkills), SUM(courierkills) FROM gameplayers LEFT JOIN games ON games.id=gameplayers.gameid LEFT JOIN dotaplayers ON dotaplayers.gameid=games.id AND dotaplayers.colour=gameplayers.colour WHERE name LIKE '" + EscName + "'";
-
-	if( mysql_real_query( (MYSQL *)conn, Query.c_str( ), Query.size( ) ) != 0 )
-		*error = mysql_error( (MYSQL *)conn );
-	else
-	{
-		MYSQL_RES *Result = mysql_store_result( (MYSQL *)conn );
+	CMySQLBindings Params;
+	Params.AddString( name );
+	MYSQL_STMT *Statement = MySQLExecute( conn, error, "SELECT COUNT(dotaplayers.id), SUM(kills), SUM(deaths), SUM(creepkills), SUM(creepdenies), SUM(assists), SUM(neutralkills), SUM(towerkills), SUM(raxkills), SUM(courierkills) FROM gameplayers LEFT JOIN games ON games.id=gameplayers.gameid LEFT JOIN dotaplayers ON dotaplayers.gameid=games.id AND dotaplayers.colour=gameplayers.colour WHERE name LIKE ?", Params );
 
-		if( Result )
-		{
-			vector<string> Row = MySQLFetchRow( Result );
+	if( !Statement )
+		return NULL;
 
-			if( Row.size( ) == 10 )
-			{
-				uint32_t TotalGames = UTIL_ToUInt32( Row[0] );
+	CMySQLBindings Row;
 
-				if( TotalGames > 0 )
-				{
-					uint32_t TotalWins = 0;
-					uint32_t TotalLosses = 0;
-					uint32_t TotalKills = UTIL_ToUInt32( Row[1] );
-					uint32_t TotalDeaths = UTIL_ToUInt32( Row[2] );
-					uint32_t TotalCreepKills = UTIL_ToUInt32( Row[3] );
-					uint32_t TotalCreepDenies = UTIL_ToUInt32( Row[4] );
-					uint32_t TotalAssists = UTIL_ToUInt32( Row[5] );
-					uint32_t TotalNeutralKills = UTIL_ToUInt32( Row[6] );
-					uint32_t TotalTowerKills = UTIL_ToUInt32( Row[7] );
-					uint32_t TotalRaxKills = UTIL_ToUInt32( Row[8] );
-					uint32_t TotalCourierKills = UTIL_ToUInt32( Row[9] );
-
-					// calculate total wins
-
-					string Query2 = "SELECT COUNT(*) FROM gameplayers LEFT JOIN games ON games.id=gameplayers.gameid LEFT JOIN dotaplayers ON dotaplayers.gameid=games.id AND dotaplayers.colour=gameplayers.colour LEFT JOIN dotagames ON games.id=dotagames.gameid WHERE name='" + EscName + "' AND ((winner=1 AND dotaplayers.newcolour>=1 AND dotaplayers.newcolour<=5) OR (winner=2 AND dotaplayers.newcolour>=7 AND dotaplayers.newcolour<=11))";
-
-					if( mysql_real_query( (MYSQL *)conn, Query2.c_str( ), Query2.size( ) ) != 0 )
-						*error = mysql_error( (MYSQL *)conn );
-					else
-					{
-						MYSQL_RES *Result2 = mysql_store_result( (MYSQL *)conn );
+	for( unsigned int i = 0; i < 10; ++i )
+		Row.AddUInt32Result( );
 
-						if( Result2 )
-						{
-							vector<string> Row2 = MySQLFetchRow( Result2 );
+	bool Found = MySQLFetch( Statement, error, Row );
+	mysql_stmt_free_result( Statement );
 
-							if( Row2.size( ) == 1 )
-								TotalWins = UTIL_ToUInt32( Row2[0] );
-							else
-								*error = "error checking dotaplayersummary wins [" + name + "] - row doesn't have 1 column";
+	if( !Found || Row.GetUInt32( 0 ) == 0 )
+		return NULL;
 
-							mysql_free_result( Result2 );
-						}
-						else
-							*error = mysql_error( (MYSQL *)conn );
-					}
+	uint32_t TotalGames = Row.GetUInt32( 0 );
+	uint32_t TotalWins = 0;
+	uint32_t TotalLosses = 0;
 
-					// calculate total losses
+	// calculate total wins
 
-					string Query3 = "SELECT COUNT(*) FROM gameplayers LEFT JOIN games ON games.id=gameplayers.gameid LEFT JOIN dotaplayers ON dotaplayers.gameid=games.id AND dotaplayers.colour=gameplayers.colour LEFT JOIN dotagames ON games.id=dotagames.gameid WHERE name='" + EscName + "' AND ((winner=2 AND dotaplayers.newcolour>=1 AND dotaplayers.newcolour<=5) OR (winner=1 AND dotaplayers.newcolour>=7 AND dotaplayers.newcolour<=11))";
+	MYSQL_STMT *Statement2 = MySQLExecute( conn, error, "SELECT COUNT(*) FROM gameplayers LEFT JOIN games ON games.id=gameplayers.gameid LEFT JOIN dotaplayers ON dotaplayers.gameid=games.id AND dotaplayers.colour=gameplayers.colour LEFT JOIN dotagames ON games.id=dotagames.gameid WHERE name=? AND ((winner=1 AND dotaplayers.newcolour>=1 AND dotaplayers.newcolour<=5) OR (winner=2 AND dotaplayers.newcolour>=7 AND dotaplayers.newcolour<=11))", Params );
 
-					if( mysql_real_query( (MYSQL *)conn, Query3.c_str( ), Query3.size( ) ) != 0 )
-						*error = mysql_error( (MYSQL *)conn );
-					else
-					{
-						MYSQL_RES *Result3 = mysql_store_result( (MYSQL *)conn );
+	if( Statement2 )
+	{
+		CMySQLBindings Row2;
+		Row2.AddUInt32Result( );
 
-						if( Result3 )
-						{
-							vector<string> Row3 = MySQLFetchRow( Result3 );
+		if( MySQLFetch( Statement2, error, Row2 ) )
+			TotalWins = Row2.GetUInt32( 0 );
+		else
+			*error = "error checking dotaplayersummary wins [" + name + "] - " + ( error->empty( ) ? "no rows" : *error );
 
-							if( Row3.size( ) == 1 )
-								TotalLosses = UTIL_ToUInt32( Row3[0] );
-							else
-								*error = "error checking dotaplayersummary losses [" + name + "] - row doesn't have 1 column";
+		mysql_stmt_free_result( Statement2 );
+	}
 
-							mysql_free_result( Result3 );
-						}
-						else
-							*error = mysql_error( (MYSQL *)conn );
-					}
+	// calculate total losses
 
-					// done
+	MYSQL_STMT *Statement3 = MySQLExecute( conn, error, "SELECT COUNT(*) FROM gameplayers LEFT JOIN games ON games.id=gameplayers.gameid LEFT JOIN dotaplayers ON dotaplayers.gameid=games.id AND dotaplayers.colour=gameplayers.colour LEFT JOIN dotagames ON games.id=dotagames.gameid WHERE name=? AND ((winner=2 AND dotaplayers.newcolour>=1 AND dotaplayers.newcolour<=5) OR (winner=1 AND dotaplayers.newcolour>=7 AND dotaplayers.newcolour<=11))", Params );
 
-					DotAPlayerSummary = new CDBDotAPlayerSummary( string( ), name, TotalGames, TotalWins, TotalLosses, TotalKills, TotalDeaths, TotalCreepKills, TotalCreepDenies, TotalAssists, TotalNeutralKills, TotalTowerKills, TotalRaxKills, TotalCourierKills );
-				}
-			}
-			else
-				*error = "error checking dotaplayersummary [" + name + "] - row doesn't have 10 columns";
+	if( Statement3 )
+	{
+		CMySQLBindings Row3;
+		Row3.AddUInt32Result( );
 
-			mysql_free_result( Result );
-		}
+		if( MySQLFetch( Statement3, error, Row3 ) )
+			TotalLosses = Row3.GetUInt32( 0 );
 		else
-			*error = mysql_error( (MYSQL *)conn );
+			*error = "error checking dotaplayersummary losses [" + name + "] - " + ( error->empty( ) ? "no rows" : *error );
+
+		mysql_stmt_free_result( Statement3 );
 	}
 
+	// done
+
+	DotAPlayerSummary = new CDBDotAPlayerSummary( string( ), name, TotalGames, TotalWins, TotalLosses, Row.GetUInt32( 1 ), Row.GetUInt32( 2 ), Row.GetUInt32( 3 ), Row.GetUInt32( 4 ), Row.GetUInt32( 5 ), Row.GetUInt32( 6 ), Row.GetUInt32( 7 ), Row.GetUInt32( 8 ), Row.GetUInt32( 9 ) );
 	return DotAPlayerSummary;
 }
 
@@ -1157,20 +1535,7 @@ void CMySQLCallable :: Init( )
 #endif
 
 	mysql_thread_init( );
-
-	if( !m_Connection )
-	{
-		if( !( m_Connection = mysql_init( NULL ) ) )
-			m_Error = mysql_error( (MYSQL *)m_Connection );
-
-		bool Reconnect = true;
-		mysql_options( (MYSQL *)m_Connection, MYSQL_OPT_RECONNECT, &Reconnect );
-
-		if( !( mysql_real_connect( (MYSQL *)m_Connection, m_SQLServer.c_str( ), m_SQLUser.c_str( ), m_SQLPassword.c_str( ), m_SQLDatabase.c_str( ), m_SQLPort, NULL, 0 ) ) )
-			m_Error = mysql_error( (MYSQL *)m_Connection );
-	}
-	else if( mysql_ping( (MYSQL *)m_Connection ) != 0 )
-		m_Error = mysql_error( (MYSQL *)m_Connection );
+	m_Connection->Connect( m_SQLServer, m_SQLDatabase, m_SQLUser, m_SQLPassword, m_SQLPort, &m_Error );
 }
 
 void CMySQLCallable :: Close( )
@@ -1185,7 +1550,7 @@ void CMySQLCallableAdminCount :: operator( )( )
 	Init( );
 
 	if( m_Error.empty( ) )
-		m_Result = MySQLAdminCount( m_Connection, &m_Error, m_SQLBotID, m_Server );
+		m_Result = MySQLAdminCount( m_Connection->GetMySQL( ), &m_Error, m_SQLBotID, m_Server );
 
 	Close( );
 }
@@ -1195,7 +1560,7 @@ void CMySQLCallableAdminCheck :: operator( )( )
 	Init( );
 
 	if( m_Error.empty( ) )
-		m_Result = MySQLAdminCheck( m_Connection, &m_Error, m_SQLBotID, m_Server, m_User );
+		m_Result = MySQLAdminCheck( m_Connection->GetMySQL( ), &m_Error, m_SQLBotID, m_Server, m_User );
 
 	Close( );
 }
@@ -1205,7 +1570,7 @@ void CMySQLCallableAdminAdd :: operator( )( )
 	Init( );
 
 	if( m_Error.empty( ) )
-		m_Result = MySQLAdminAdd( m_Connection, &m_Error, m_SQLBotID, m_Server, m_User );
+		m_Result = MySQLAdminAdd( m_Connection->GetMySQL( ), &m_Error, m_SQLBotID, m_Server, m_User );
 
 	Close( );
 }
@@ -1215,7 +1580,7 @@ void CMySQLCallableAdminRemove :: operator( )( )
 	Init( );
 
 	if( m_Error.empty( ) )
-		m_Result = MySQLAdminRemove( m_Connection, &m_Error, m_SQLBotID, m_Server, m_User );
+		m_Result = MySQLAdminRemove( m_Connection->GetMySQL( ), &m_Error, m_SQLBotID, m_Server, m_User );
 
 	Close( );
 }
@@ -1225,7 +1590,7 @@ void CMySQLCallableAdminList :: operator( )( )
 	Init( );
 
 	if( m_Error.empty( ) )
-		m_Result = MySQLAdminList( m_Connection, &m_Error, m_SQLBotID, m_Server );
+		m_Result = MySQLAdminList( m_Connection->GetMySQL( ), &m_Error, m_SQLBotID, m_Server );
 
 	Close( );
 }
@@ -1235,7 +1600,7 @@ void CMySQLCallableBanCount :: operator( )( )
 	Init( );
 
 	if( m_Error.empty( ) )
-		m_Result = MySQLBanCount( m_Connection, &m_Error, m_SQLBotID, m_Server );
+		m_Result = MySQLBanCount( m_Connection->GetMySQL( ), &m_Error, m_SQLBotID, m_Server );
 
 	Close( );
 }
@@ -1255,7 +1620,7 @@ void CMySQLCallableBanAdd :: operator( )( )
 	Init( );
 
 	if( m_Error.empty( ) )
-		m_Result = MySQLBanAdd( m_Connection, &m_Error, m_SQLBotID, m_Server, m_User, m_IP, m_GameName, m_Admin, m_Reason );
+		m_Result = MySQLBanAdd( m_Connection->GetMySQL( ), &m_Error, m_SQLBotID, m_Server, m_User, m_IP, m_GameName, m_Admin, m_Reason );
 
 	Close( );
 }
@@ -1267,9 +1632,9 @@ void CMySQLCallableBanRemove :: operator( )( )
 	if( m_Error.empty( ) )
 	{
 		if( m_Server.empty( ) )
-			m_Result = MySQLBanRemove( m_Connection, &m_Error, m_SQLBotID, m_User );
+			m_Result = MySQLBanRemove( m_Connection->GetMySQL( ), &m_Error, m_SQLBotID, m_User );
 		else
-			m_Result = MySQLBanRemove( m_Connection, &m_Error, m_SQLBotID, m_Server, m_User );
+			m_Result = MySQLBanRemove( m_Connection->GetMySQL( ), &m_Error, m_SQLBotID, m_Server, m_User );
 	}
 
 	Close( );
@@ -1280,7 +1645,7 @@ void CMySQLCallableBanList :: operator( )( )
 	Init( );
 
 	if( m_Error.empty( ) )
-		m_Result = MySQLBanList( m_Connection, &m_Error, m_SQLBotID, m_Server );
+		m_Result = MySQLBanList( m_Connection->GetMySQL( ), &m_Error, m_SQLBotID, m_Server );
 
 	Close( );
 }
@@ -1310,7 +1675,7 @@ void CMySQLCallableGamePlayerSummaryCheck :: operator( )( )
 	Init( );
 
 	if( m_Error.empty( ) )
-		m_Result = MySQLGamePlayerSummaryCheck( m_Connection, &m_Error, m_SQLBotID, m_Name );
+		m_Result = MySQLGamePlayerSummaryCheck( m_Connection->GetMySQL( ), &m_Error, m_SQLBotID, m_Name );
 
 	Close( );
 }
@@ -1320,7 +1685,7 @@ void CMySQLCallableDotAGameAdd :: operator( )( )
 	Init( );
 
 	if( m_Error.empty( ) )
-		m_Result = MySQLDotAGameAdd( m_Connection, &m_Error, m_SQLBotID, m_GameID, m_Winner, m_Min, m_Sec );
+		m_Result = MySQLDotAGameAdd( m_Connection->GetMySQL( ), &m_Error, m_SQLBotID, m_GameID, m_Winner, m_Min, m_Sec );
 
 	Close( );
 }
@@ -1330,7 +1695,7 @@ void CMySQLCallableDotAPlayerAdd :: operator( )( )
 	Init( );
 
 	if( m_Error.empty( ) )
-		m_Result = MySQLDotAPlayerAdd( m_Connection, &m_Error, m_SQLBotID, m_GameID, m_Colour, m_Kills, m_Deaths, m_CreepKills, m_CreepDenies, m_Assists, m_Gold, m_NeutralKills, m_Item1, m_Item2, m_Item3, m_Item4, m_Item5, m_Item6, m_Hero, m_NewColour, m_TowerKills, m_RaxKills, m_CourierKills );
+		m_Result = MySQLDotAPlayerAdd( m_Connection->GetMySQL( ), &m_Error, m_SQLBotID, m_GameID, m_Colour, m_Kills, m_Deaths, m_CreepKills, m_CreepDenies, m_Assists, m_Gold, m_NeutralKills, m_Item1, m_Item2, m_Item3, m_Item4, m_Item5, m_Item6, m_Hero, m_NewColour, m_TowerKills, m_RaxKills, m_CourierKills );
 
 	Close( );
 }
@@ -1350,7 +1715,7 @@ void CMySQLCallableDownloadAdd :: operator( )( )
 	Init( );
 
 	if( m_Error.empty( ) )
-		m_Result = MySQLDownloadAdd( m_Connection, &m_Error, m_SQLBotID, m_Map, m_MapSize, m_Name, m_IP, m_Spoofed, m_SpoofedRealm, m_DownloadTime );
+		m_Result = MySQLDownloadAdd( m_Connection->GetMySQL( ), &m_Error, m_SQLBotID, m_Map, m_MapSize, m_Name, m_IP, m_Spoofed, m_SpoofedRealm, m_DownloadTime );
 
 	Close( );
 }
@@ -1360,7 +1725,7 @@ void CMySQLCallableScoreCheck :: operator( )( )
 	Init( );
 
 	if( m_Error.empty( ) )
-		m_Result = MySQLScoreCheck( m_Connection, &m_Error, m_SQLBotID, m_Category, m_Name, m_Server );
+		m_Result = MySQLScoreCheck( m_Connection->GetMySQL( ), &m_Error, m_SQLBotID, m_Category, m_Name, m_Server );
 
 	Close( );
 }
@@ -1370,7 +1735,7 @@ void CMySQLCallableW3MMDPlayerAdd :: operator( )( )
 	Init( );
 
 	if( m_Error.empty( ) )
-		m_Result = MySQLW3MMDPlayerAdd( m_Connection, &m_Error, m_SQLBotID, m_Category, m_GameID, m_PID, m_Name, m_Flag, m_Leaver, m_Practicing );
+		m_Result = MySQLW3MMDPlayerAdd( m_Connection->GetMySQL( ), &m_Error, m_SQLBotID, m_Category, m_GameID, m_PID, m_Name, m_Flag, m_Leaver, m_Practicing );
 
 	Close( );
 }
@@ -1382,11 +1747,11 @@ void CMySQLCallableW3MMDVarAdd :: operator( )( )
 	if( m_Error.empty( ) )
 	{
 		if( m_ValueType == VALUETYPE_INT )
-			m_Result = MySQLW3MMDVarAdd( m_Connection, &m_Error, m_SQLBotID, m_GameID, m_VarInts );
+			m_Result = MySQLW3MMDVarAdd( m_Connection->GetMySQL( ), &m_Error, m_SQLBotID, m_GameID, m_VarInts );
 		else if( m_ValueType == VALUETYPE_REAL )
-			m_Result = MySQLW3MMDVarAdd( m_Connection, &m_Error, m_SQLBotID, m_GameID, m_VarReals );
+			m_Result = MySQLW3MMDVarAdd( m_Connection->GetMySQL( ), &m_Error, m_SQLBotID, m_GameID, m_VarReals );
 		else
-			m_Result = MySQLW3MMDVarAdd( m_Connection, &m_Error, m_SQLBotID, m_GameID, m_VarStrings );
+			m_Result = MySQLW3MMDVarAdd( m_Connection->GetMySQL( ), &m_Error, m_SQLBotID, m_GameID, m_VarStrings );
 	}
 
 	Close( );
@@ -1793,70 +2158,87 @@ uint32_t MySQLDotAPlayerStatsUpdateTHISTHIS(void* conn, string* error, string se
 	return RowID;
 }
 
-uint32_t MySQLCurrentGameUpdate(void* conn, string* error, uint32_t botid, unsigned char action, string param, string creatorname, string ownername, string gamename, string names, string mapname, string createdat, string startedat, string expiredate, bool gamestarted, uint32_t gamerandomid, bool clearall, uint8_t occupiedslots, uint8_t maxslots)
+string MySQLTimestamp( time_t t )
+{
+	char Buffer[32];
+	strftime( Buffer, sizeof( Buffer ), "%Y-%m-%d %H:%M:%S", gmtime( &t ) );
+	return Buffer;
+}
+
+bool MySQLCurrentGamesPublish( CMySQLConnection *conn, string *error, uint32_t botid, bool clearall, vector<CDBCurrentGame> games, vector<uint32_t> removed )
 {
-	//action: 0=add/update(replace) 1=delete 2=?
-	uint32_t RowID =0;
-	string EscCreatorName = MySQLEscapeString(conn, creatorname);
-	string EscOwnerName = MySQLEscapeString(conn, ownername);
-	string EscGameName = MySQLEscapeString(conn, gamename);
-	string EscPlayersNames = MySQLEscapeString(conn, names);
-	string EscMapName = MySQLEscapeString(conn, mapname);
-	string CreatedAt = !createdat.empty() ? "'" + createdat + "'" : "UTC_TIMESTAMP()";
-	string StartedAt = !startedat.empty() ? "'" + startedat + "'" : "UTC_TIMESTAMP()";
-	string ExpireDate = !expiredate.empty() ? "'" + expiredate + "'" : "NULL";
+	// the whole batch is one transaction running the connection's cached single row statements
+	// empty timestamps are sent as NULL, COALESCE turns them into the current time (the expire date stays NULL)
+
+	MYSQL *MySQL = (MYSQL *)conn->GetMySQL( );
 
-	if (clearall)
+	if( mysql_autocommit( MySQL, 0 ) != 0 )
 	{
-		string ClearQuery = "DELETE FROM `currentgames` WHERE bot_id = " + UTIL_ToString(botid);
-		if (mysql_real_query((MYSQL*)conn, ClearQuery.c_str(), ClearQuery.size()) != 0)
-			*error = mysql_error((MYSQL*)conn);
-		else
-		{
-			//Success = true;
-		}		
+		*error = mysql_error( MySQL );
+		return false;
 	}
 
-	if (action == 0)
+	bool Success = true;
+
+	if( clearall )
 	{
-		string ReplaceQuery = "REPLACE INTO `currentgames` (`id`, `bot_id` , `owner_name`, `game_name`, `names`, `map_name`, `created_at`, `updated_at`, `started_at`, `expire_date`, `started`, `occupied_slots`, `max_slots`) VALUES (" + UTIL_ToString(gamerandomid) + ", '" + UTIL_ToString(botid) + "', '" + EscOwnerName + "', '" + EscGameName + "', '" + EscPlayersNames + "', '" + EscMapName + "', " + CreatedAt + ", UTC_TIMESTAMP(), " + StartedAt + ", " + ExpireDate + ", '" + (gamestarted ? "1" : "0") + "', '" + UTIL_ToString(occupiedslots) + "', '" + UTIL_ToString(maxslots) +"') ";
-		if (mysql_real_query((MYSQL*)conn, ReplaceQuery.c_str(), ReplaceQuery.size()) != 0)
-			*error = mysql_error((MYSQL*)conn);
+		CMySQLBindings Params;
+		Params.AddUInt32( botid );
+		MYSQL_STMT *Statement = MySQLExecute( conn, error, "DELETE FROM currentgames WHERE bot_id=?", Params );
+
+		if( Statement )
+			mysql_stmt_free_result( Statement );
 		else
-			RowID = (uint32_t)mysql_insert_id((MYSQL*)conn);
+			Success = false;
 	}
-	else if (action == 1)
+
+	for( vector<CDBCurrentGame> :: iterator i = games.begin( ); Success && i != games.end( ); ++i )
 	{
-		string DeleteQuery = "DELETE FROM `currentgames` WHERE `id` = " + UTIL_ToString(gamerandomid);
-		if (mysql_real_query((MYSQL*)conn, DeleteQuery.c_str(), DeleteQuery.size()) != 0)
-			*error = mysql_error((MYSQL*)conn);
+		CMySQLBindings Params;
+		Params.AddUInt32( i->m_GameRandomID );
+		Params.AddUInt32( botid );
+		Params.AddString( i->m_OwnerName );
+		Params.AddString( i->m_GameName );
+		Params.AddString( i->m_Names );
+		Params.AddString( i->m_MapName );
+		Params.AddNullableString( i->m_CreatedAt != 0 ? MySQLTimestamp( i->m_CreatedAt ) : string( ) );
+		Params.AddNullableString( i->m_StartedAt != 0 ? MySQLTimestamp( i->m_StartedAt ) : string( ) );
+		Params.AddNullableString( i->m_ExpireDate != 0 ? MySQLTimestamp( i->m_ExpireDate ) : string( ) );
+		Params.AddUInt32( i->m_GameStarted ? 1 : 0 );
+		Params.AddUInt32( i->m_OccupiedSlots );
+		Params.AddUInt32( i->m_MaxSlots );
+		MYSQL_STMT *Statement = MySQLExecute( conn, error, "REPLACE INTO currentgames ( id, bot_id, owner_name, game_name, names, map_name, created_at, updated_at, started_at, expire_date, started, occupied_slots, max_slots ) VALUES ( ?, ?, ?, ?, ?, ?, COALESCE( ?, UTC_TIMESTAMP( ) ), UTC_TIMESTAMP( ), COALESCE( ?, UTC_TIMESTAMP( ) ), ?, ?, ?, ? )", Params );
+
+		if( Statement )
+			mysql_stmt_free_result( Statement );
 		else
-			RowID = (uint32_t)mysql_insert_id((MYSQL*)conn);
+			Success = false;
 	}
-	else if (action == 2)
+
+	for( vector<uint32_t> :: iterator i = removed.begin( ); Success && i != removed.end( ); ++i )
 	{
-		string AddQuery = "INSERT INTO `currentgames` (`id`, `owner_name`, `game_name`, `names`, `map_name`, `created_at`, `updated_at`, `started_at`, `expire_date`, `started`) VALUES (NULL, '" + EscOwnerName + "', '" + EscGameName + "', '" + EscPlayersNames + "', '" + EscMapName + "', " + CreatedAt + ", NOW(), " + StartedAt + ", " + ExpireDate + ", '" + (gamestarted ? "1" : "0") + "') ";
-	}
+		CMySQLBindings Params;
+		Params.AddUInt32( botid );
+		Params.AddUInt32( *i );
+		MYSQL_STMT *Statement = MySQLExecute( conn, error, "DELETE FROM currentgames WHERE bot_id=? AND id=?", Params );
 
-	if (false && action == 0)
-	{ //Update if exists, add if not
-		string SelectQuery = "SELECT `id` FROM `currentgames` where `bot_id` = '" + UTIL_ToString(botid) + "' AND `game_random_id` = '" + UTIL_ToString(gamerandomid) + "'";
-		if (mysql_real_query((MYSQL*)conn, SelectQuery.c_str(), SelectQuery.size()) != 0)
-			*error = mysql_error((MYSQL*)conn);
+		if( Statement )
+			mysql_stmt_free_result( Statement );
 		else
-		{
-			MYSQL_RES* SelectResult = mysql_store_result((MYSQL*)conn);
-			if (SelectResult && SelectResult->row_count > 0)
-			{
-				string UpdateQuery = "";
-			}
-			else
-			{
-			}
-		}
+			Success = false;
 	}
 
-	return RowID;
+	if( Success && mysql_commit( MySQL ) != 0 )
+	{
+		*error = mysql_error( MySQL );
+		Success = false;
+	}
+
+	if( !Success )
+		mysql_rollback( MySQL );
+
+	mysql_autocommit( MySQL, 1 );
+	return Success;
 }
 
 vector<CDBCurrentGame*> MySQLCurrentGamesQuery(void* conn, string* error, bool includelobbies, bool includestarted, uint32_t queryoffset, uint32_t querylimit, uint32_t& outlobbiescount, uint32_t& outgamescount)
@@ -1990,7 +2372,7 @@ void CMySQLCallableDotAPlayerAddNew :: operator( )()
 	Init();
 
 	if (m_Error.empty())
-		m_Result = MySQLDotAPlayerAddNew(m_Connection, &m_Error, m_SQLBotID, m_GameID, m_Colour, m_Kills, m_Deaths, m_CreepKills, m_CreepDenies, m_Assists, m_Gold, m_NeutralKills, m_Item1, m_Item2, m_Item3, m_Item4, m_Item5, m_Item6, m_Hero, m_NewColour, m_TowerKills, m_RaxKills, m_CourierKills);
+		m_Result = MySQLDotAPlayerAddNew(m_Connection->GetMySQL(), &m_Error, m_SQLBotID, m_GameID, m_Colour, m_Kills, m_Deaths, m_CreepKills, m_CreepDenies, m_Assists, m_Gold, m_NeutralKills, m_Item1, m_Item2, m_Item3, m_Item4, m_Item5, m_Item6, m_Hero, m_NewColour, m_TowerKills, m_RaxKills, m_CourierKills);
 
 	Close();
 }
@@ -1999,9 +2381,9 @@ void CMySQLCallableDotAPlayerSummaryCheckNew :: operator( )()
 {
 	Init();
 
-	m_Result = MySQLDotAPlayerSummaryCheckNew(m_Connection, &m_Error, m_Name, m_Server, "it was: m_Formula", m_MinGames);  //was : ( m_Connection, &m_Error, m_SQLBotID, m_Name, m_Formula, m_MinGames, m_GameState )
+	m_Result = MySQLDotAPlayerSummaryCheckNew(m_Connection->GetMySQL(), &m_Error, m_Name, m_Server, "it was: m_Formula", m_MinGames);  //was : ( m_Connection, &m_Error, m_SQLBotID, m_Name, m_Formula, m_MinGames, m_GameState )
 	if (m_Error.empty())
-		m_Result = MySQLDotAPlayerSummaryCheckNew(m_Connection, &m_Error, m_Name, m_Server, "it was: m_Formula", m_MinGames);  //mby this is correct!!!!!!!!
+		m_Result = MySQLDotAPlayerSummaryCheckNew(m_Connection->GetMySQL(), &m_Error, m_Name, m_Server, "it was: m_Formula", m_MinGames);  //mby this is correct!!!!!!!!
 	//m_Result = MySQLDotAPlayerSummaryCheckNew( m_Connection, &m_Error, m_SQLBotID, m_Server,  m_Name, m_MinGames, m_GameState ); //???
 
 	Close();
@@ -2011,9 +2393,9 @@ void CMySQLCallableDotATopPlayersQuery :: operator( )()
 {
 	Init();
 
-	m_Result = MySQLDotATopPlayersQuery(m_Connection, &m_Error, m_Server, m_MinGames, m_Offset, m_Count);
+	m_Result = MySQLDotATopPlayersQuery(m_Connection->GetMySQL(), &m_Error, m_Server, m_MinGames, m_Offset, m_Count);
 	if (m_Error.empty())
-		m_Result = MySQLDotATopPlayersQuery(m_Connection, &m_Error, m_Server, m_MinGames, m_Offset, m_Count); 
+		m_Result = MySQLDotATopPlayersQuery(m_Connection->GetMySQL(), &m_Error, m_Server, m_MinGames, m_Offset, m_Count); 
 	
 	Close();
 }
@@ -2023,7 +2405,7 @@ void CMySQLCallableDotAPlayerStatsUpdate :: operator( )()
 	Init();
 
 	if (m_Error.empty())
-		m_Result = MySQLDotAPlayerStatsUpdate(m_Connection, &m_Error, m_ServerName, m_Name,m_DotAPlayer,m_DotAGame, m_BaseRating, m_OpponentAvgRaing);
+		m_Result = MySQLDotAPlayerStatsUpdate(m_Connection->GetMySQL(), &m_Error, m_ServerName, m_Name,m_DotAPlayer,m_DotAGame, m_BaseRating, m_OpponentAvgRaing);
 	delete m_DotAPlayer;
 	delete m_DotAGame;
 
@@ -2031,36 +2413,32 @@ void CMySQLCallableDotAPlayerStatsUpdate :: operator( )()
 	
 }
 
-void CMySQLCallableCurrentGameUpdate :: operator( )()
+void CMySQLCallableCurrentGamesQuery :: operator( )()
 {
 	Init();
 
 	if (m_Error.empty())
-		m_Result = MySQLCurrentGameUpdate(m_Connection, &m_Error, m_BotID, m_Action, m_Param, m_CreatorName, m_OwnerName, m_GameName, m_Names, m_MapName, m_CreatedAt, m_StartedAt, m_ExpireDate, m_GameStarted, m_GameRandomID, m_ClearAll, m_OccupiedSlots, m_MaxSlots);
+		m_Result = MySQLCurrentGamesQuery(m_Connection->GetMySQL(), &m_Error, m_IncludeLobbies, m_IncludeStarted, m_QueryOffset, m_QueryLimit, m_TotalLobbyCount, m_TotalGameCount);
 
 	Close();
 
 }
 
-void CMySQLCallableCurrentGamesQuery :: operator( )()
+void CMySQLCallableCurrentGamesPublish :: operator( )( )
 {
-	Init();
-
-	if (m_Error.empty())
-		m_Result = MySQLCurrentGamesQuery(m_Connection, &m_Error, m_IncludeLobbies, m_IncludeStarted, m_QueryOffset, m_QueryLimit, m_TotalLobbyCount, m_TotalGameCount);
+	Init( );
 
-	Close();
+	if( m_Error.empty( ) )
+		m_Result = MySQLCurrentGamesPublish( m_Connection, &m_Error, m_BotID, m_ClearAll, m_Games, m_Removed );
 
+	Close( );
 }
 ///////////
 
 //incomplete
 CCallableDotAPlayerAddNew* CGHostDBMySQL::ThreadedDotAPlayerAddNew(uint32_t gameid, uint32_t colour, uint32_t kills, uint32_t deaths, uint32_t creepkills, uint32_t creepdenies, uint32_t assists, uint32_t gold, uint32_t neutralkills, string item1, string item2, string item3, string item4, string item5, string item6, string hero, uint32_t newcolour, uint32_t towerkills, uint32_t raxkills, uint32_t courierkills)
 {
-	void* Connection = GetIdleConnection();
-
-	if (!Connection)
-		m_NumConnections++;
+	CMySQLConnection* Connection = GetIdleConnection();
 
 	CCallableDotAPlayerAddNew* Callable = new CMySQLCallableDotAPlayerAddNew(gameid, colour, kills, deaths, creepkills, creepdenies, assists, gold, neutralkills, item1, item2, item3, item4, item5, item6, hero, newcolour, towerkills, raxkills, courierkills, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port);
 	CreateThread(Callable);
@@ -2070,10 +2448,7 @@ CCallableDotAPlayerAddNew* CGHostDBMySQL::ThreadedDotAPlayerAddNew(uint32_t game
 
 CCallableDotAPlayerSummaryCheckNew* CGHostDBMySQL::ThreadedDotAPlayerSummaryCheckNew(string servername, string name, string mingames, string gamestate)
 {
-	void* Connection = GetIdleConnection();
-
-	if (!Connection)
-		m_NumConnections++;
+	CMySQLConnection* Connection = GetIdleConnection();
 
 	uint32_t minGames = 1;
 	CCallableDotAPlayerSummaryCheckNew* Callable = new CMySQLCallableDotAPlayerSummaryCheckNew(servername, name, UTIL_ToString(minGames), gamestate, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port);
@@ -2084,10 +2459,7 @@ CCallableDotAPlayerSummaryCheckNew* CGHostDBMySQL::ThreadedDotAPlayerSummaryChec
 
 CCallableDotATopPlayersQuery* CGHostDBMySQL::ThreadedDotATopPlayersQuery(string server, string mingames, uint32_t offset, uint32_t count)
 {
-	void* Connection = GetIdleConnection();
-
-	if (!Connection)
-		m_NumConnections++;
+	CMySQLConnection* Connection = GetIdleConnection();
 
 	uint32_t minGames = 1;
 	CCallableDotATopPlayersQuery* Callable = new CMySQLCallableDotATopPlayersQuery(server, mingames, offset,count, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port);
@@ -2098,10 +2470,7 @@ CCallableDotATopPlayersQuery* CGHostDBMySQL::ThreadedDotATopPlayersQuery(string
 
 CCallableDotAPlayerStatsUpdate* CGHostDBMySQL::ThreadedDotAPlayerStatsUpdate(string nServerName, string nName, CDBDotAPlayer* nDotAPlayer, CDBDotAGame* nDotAGame, uint32_t nBaseRating, uint32_t nOpponentAvgRaing)
 {
-	void* Connection = GetIdleConnection();
-
-	if (!Connection)
-		m_NumConnections++;
+	CMySQLConnection* Connection = GetIdleConnection();
 
 	CCallableDotAPlayerStatsUpdate* Callable = new CMySQLCallableDotAPlayerStatsUpdate(nServerName,nName,nDotAPlayer,nDotAGame,nBaseRating, nOpponentAvgRaing, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port);
 	CreateThread(Callable);
@@ -2109,28 +2478,22 @@ CCallableDotAPlayerStatsUpdate* CGHostDBMySQL::ThreadedDotAPlayerStatsUpdate(str
 	return Callable;
 }
 
-CCallableCurrentGameUpdate* CGHostDBMySQL::ThreadedCurrentGameUpdate(uint32_t nBotID, unsigned char nAction, string nParam, string nCreatorName, string nOwnerName, string nGameName, string nNames, string nMapName, string nCreatedAt, string nStartedAt, string nExpireDate, bool nGameStarted, uint32_t nGameRandomID, bool nClearAll, uint8_t nOccupiedSlots, uint8_t nMaxSlots)
+CCallableCurrentGamesQuery* CGHostDBMySQL::ThreadedCurrentGamesQuery(bool includelobbies, bool includestarted, uint32_t queryoffset, uint32_t querylimit)
 {
-	void* Connection = GetIdleConnection();
-
-	if (!Connection)
-		m_NumConnections++;
+	CMySQLConnection* Connection = GetIdleConnection();
 
-	CCallableCurrentGameUpdate* Callable = new CMySQLCallableCurrentGameUpdate(nBotID, nAction, nParam, nCreatorName, nOwnerName, nGameName, nNames, nMapName, nCreatedAt, nStartedAt, nExpireDate, nGameStarted, nGameRandomID, nClearAll, nOccupiedSlots, nMaxSlots, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port);
+	CCallableCurrentGamesQuery* Callable = new CMySQLCallableCurrentGamesQuery(includelobbies, includestarted, queryoffset, querylimit, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port);
 	CreateThread(Callable);
 	m_OutstandingCallables++;
 	return Callable;
 }
 
-CCallableCurrentGamesQuery* CGHostDBMySQL::ThreadedCurrentGamesQuery(bool includelobbies, bool includestarted, uint32_t queryoffset, uint32_t querylimit)
+CCallableCurrentGamesPublish *CGHostDBMySQL :: ThreadedCurrentGamesPublish( uint32_t botid, bool clearall, vector<CDBCurrentGame> games, vector<uint32_t> removed )
 {
-	void* Connection = GetIdleConnection();
-
-	if (!Connection)
-		m_NumConnections++;
+	CMySQLConnection *Connection = GetIdleConnection( );
 
-	CCallableCurrentGamesQuery* Callable = new CMySQLCallableCurrentGamesQuery(includelobbies, includestarted, queryoffset, querylimit, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port);
-	CreateThread(Callable);
+	CCallableCurrentGamesPublish *Callable = new CMySQLCallableCurrentGamesPublish( botid, clearall, games, removed, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CreateThread( Callable );
 	m_OutstandingCallables++;
 	return Callable;
 }
@@ -29,16 +29,26 @@
 // CQSLITE3 (wrapper class)
 //
 
-CSQLITE3 :: CSQLITE3( string filename )
+CSQLITE3 :: CSQLITE3( string filename, bool readOnly )
 {
 	m_Ready = true;
 
-	if( sqlite3_open_v2( filename.c_str( ), (sqlite3 **)&m_DB, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL ) != SQLITE_OK )
+	if( sqlite3_open_v2( filename.c_str( ), (sqlite3 **)&m_DB, readOnly ? SQLITE_OPEN_READONLY : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL ) != SQLITE_OK )
 		m_Ready = false;
+	else
+	{
+		// with several connections open on the same file a connection can find the database locked for a moment (e.g. during a checkpoint)
+		// wait for the lock rather than failing the query immediately
+
+		sqlite3_busy_timeout( (sqlite3 *)m_DB, 5000 );
+	}
 }
 
 CSQLITE3 :: ~CSQLITE3( )
 {
+	for( map<string, void *> :: iterator i = m_Statements.begin( ); i != m_Statements.end( ); ++i )
+		sqlite3_finalize( (sqlite3_stmt *)i->second );
+
 	sqlite3_close( (sqlite3 *)m_DB );
 }
 
@@ -52,6 +62,33 @@ int CSQLITE3 :: Prepare( string query, void **Statement )
 	return sqlite3_prepare_v2( (sqlite3 *)m_DB, query.c_str( ), -1, (sqlite3_stmt **)Statement, NULL );
 }
 
+int CSQLITE3 :: PrepareCached( string query, void **Statement )
+{
+	map<string, void *> :: iterator i = m_Statements.find( query );
+
+	if( i != m_Statements.end( ) )
+	{
+		// the statement should have been released by the last caller but reset it anyway in case it returned early
+
+		sqlite3_reset( (sqlite3_stmt *)i->second );
+		*Statement = i->second;
+		return SQLITE_OK;
+	}
+
+	int RC = Prepare( query, Statement );
+
+	if( RC == SQLITE_OK && *Statement )
+		m_Statements[query] = *Statement;
+
+	return RC;
+}
+
+int CSQLITE3 :: Release( void *Statement )
+{
+	sqlite3_clear_bindings( (sqlite3_stmt *)Statement );
+	return sqlite3_reset( (sqlite3_stmt *)Statement );
+}
+
 int CSQLITE3 :: Step( void *Statement )
 {
 	int RC = sqlite3_step( (sqlite3_stmt *)Statement );
@@ -103,9 +140,19 @@ uint32_t CSQLITE3 :: LastRowID( )
 // CGHostDBSQLite
 //
 
-CGHostDBSQLite :: CGHostDBSQLite( CConfig *CFG ) : CGHostDB( CFG )
+// the database threads only borrow their connections, they're closed by the destructor
+
+static void KeepConnection( CSQLITE3 * )
+{
+
+}
+
+CGHostDBSQLite :: CGHostDBSQLite( CConfig *CFG ) : CGHostDB( CFG ), m_ThreadDB( KeepConnection )
 {
 	m_File = CFG->GetString( "db_sqlite3_file", "ghost.dbs" );
+	m_NumReaders = CFG->GetInt( "db_sqlite3_readers", 2 );
+	m_ThreadsStarted = false;
+	m_Exiting = false;
 	CONSOLE_Print( "[SQLITE3] version " + string( SQLITE_VERSION ) );
 	CONSOLE_Print( "[SQLITE3] opening database [" + m_File + "]" );
 	m_DB = new CSQLITE3( m_File );
@@ -287,21 +334,177 @@ CGHostDBSQLite :: CGHostDBSQLite( CConfig *CFG ) : CGHostDB( CFG )
 		SchemaNumber = "8";
 	}
 
-	if( m_DB->Exec( "CREATE TEMPORARY TABLE iptocountry ( ip1 INTEGER NOT NULL, ip2 INTEGER NOT NULL, country TEXT NOT NULL, PRIMARY KEY ( ip1, ip2 ) )" ) != SQLITE_OK )
-		CONSOLE_Print( "[SQLITE3] error creating temporary iptocountry table - " + m_DB->GetError( ) );
+	// switch to write ahead logging so the reader connections never block on the writer (and vice versa)
+	// with WAL a commit only needs to sync the log so we can relax synchronous without risking corruption
 
-	FromAddStmt = NULL;
+	if( m_DB->Exec( "PRAGMA journal_mode=WAL" ) != SQLITE_OK )
+		CONSOLE_Print( "[SQLITE3] error enabling write ahead logging - " + m_DB->GetError( ) );
+
+	if( m_DB->Exec( "PRAGMA synchronous=NORMAL" ) != SQLITE_OK )
+		CONSOLE_Print( "[SQLITE3] error setting synchronous mode - " + m_DB->GetError( ) );
 }
 
 CGHostDBSQLite :: ~CGHostDBSQLite( )
 {
-	if( FromAddStmt )
-		m_DB->Finalize( FromAddStmt );
+	// let the database threads finish whatever is still queued before closing the connections
+
+	if( m_ThreadsStarted )
+	{
+		{
+			boost::mutex::scoped_lock lock( m_QueueMutex );
+			m_Exiting = true;
+		}
+
+		m_WriteCond.notify_all( );
+		m_ReadCond.notify_all( );
+		m_Threads.join_all( );
+	}
+
+	for( vector<CSQLITE3 *> :: iterator i = m_ReadDBs.begin( ); i != m_ReadDBs.end( ); ++i )
+		delete *i;
 
 	CONSOLE_Print( "[SQLITE3] closing database [" + m_File + "]" );
 	delete m_DB;
 }
 
+CSQLITE3 *CGHostDBSQLite :: GetDB( )
+{
+	// the synchronous functions run on whichever connection belongs to the calling database thread
+	// outside of the database threads (e.g. while upgrading the schema) they use the writer connection
+
+	CSQLITE3 *DB = m_ThreadDB.get( );
+	return DB ? DB : m_DB;
+}
+
+void CGHostDBSQLite :: StartThreads( )
+{
+	// this is called with m_QueueMutex locked the first time a callable is queued
+	// we don't start the threads in the constructor because the local database is often never used for anything but iptocountry
+
+	m_ThreadsStarted = true;
+
+	for( uint32_t i = 0; i < m_NumReaders; ++i )
+	{
+		CSQLITE3 *DB = new CSQLITE3( m_File, true );
+
+		if( !DB->GetReady( ) )
+		{
+			CONSOLE_Print( "[SQLITE3] error opening read only connection to database [" + m_File + "] - " + DB->GetError( ) );
+			delete DB;
+			break;
+		}
+
+		m_ReadDBs.push_back( DB );
+	}
+
+	m_Threads.create_thread( boost::bind( &CGHostDBSQLite :: WriterThread, this ) );
+
+	for( vector<CSQLITE3 *> :: iterator i = m_ReadDBs.begin( ); i != m_ReadDBs.end( ); ++i )
+		m_Threads.create_thread( boost::bind( &CGHostDBSQLite :: ReaderThread, this, *i ) );
+
+	CONSOLE_Print( "[SQLITE3] started database threads [1 writer, " + UTIL_ToString( m_ReadDBs.size( ) ) + " readers]" );
+}
+
+void CGHostDBSQLite :: Queue( CBaseCallable *callable, bool write )
+{
+	boost::mutex::scoped_lock lock( m_QueueMutex );
+
+	if( !m_ThreadsStarted )
+		StartThreads( );
+
+	// without any reader connections the writer runs the reads as well
+
+	if( write || m_ReadDBs.empty( ) )
+	{
+		m_Writes.push( make_pair( callable, write ) );
+		m_WriteCond.notify_one( );
+	}
+	else
+	{
+		m_Reads.push( callable );
+		m_ReadCond.notify_one( );
+	}
+}
+
+void CGHostDBSQLite :: WriterThread( )
+{
+	m_ThreadDB.reset( m_DB );
+
+	while( true )
+	{
+		vector<pair<CBaseCallable *, bool> > Batch;
+
+		{
+			boost::mutex::scoped_lock lock( m_QueueMutex );
+
+			while( m_Writes.empty( ) && !m_Exiting )
+				m_WriteCond.wait( lock );
+
+			if( m_Writes.empty( ) )
+				break;
+
+			while( !m_Writes.empty( ) )
+			{
+				Batch.push_back( m_Writes.front( ) );
+				m_Writes.pop( );
+			}
+		}
+
+		// run everything that was queued in one transaction so we only pay for one sync however many games queued writes at the same time
+		// the callables aren't marked as ready until the transaction has been committed so nobody acts on a result which might still be rolled back
+
+		bool Transaction = Batch.size( ) > 1 && m_DB->Exec( "BEGIN TRANSACTION" ) == SQLITE_OK;
+
+		for( vector<pair<CBaseCallable *, bool> > :: iterator i = Batch.begin( ); i != Batch.end( ); ++i )
+			( *i->first )( );
+
+		if( Transaction && m_DB->Exec( "COMMIT TRANSACTION" ) != SQLITE_OK )
+		{
+			// the rollback throws away every write in the batch so the results they returned (e.g. new game ids) don't exist anymore
+			// run the writes again one at a time without a transaction, each one then either sticks or fails on its own and reports 0/false like any other failed query
+			// the reads keep their results, they didn't change anything
+
+			CONSOLE_Print( "[SQLITE3] error committing " + UTIL_ToString( Batch.size( ) ) + " queued queries, retrying the writes one at a time - " + m_DB->GetError( ) );
+			m_DB->Exec( "ROLLBACK TRANSACTION" );
+
+			for( vector<pair<CBaseCallable *, bool> > :: iterator i = Batch.begin( ); i != Batch.end( ); ++i )
+			{
+				if( i->second )
+					( *i->first )( );
+			}
+		}
+
+		for( vector<pair<CBaseCallable *, bool> > :: iterator i = Batch.begin( ); i != Batch.end( ); ++i )
+			i->first->Close( );
+	}
+}
+
+void CGHostDBSQLite :: ReaderThread( CSQLITE3 *DB )
+{
+	m_ThreadDB.reset( DB );
+
+	while( true )
+	{
+		CBaseCallable *Callable = NULL;
+
+		{
+			boost::mutex::scoped_lock lock( m_QueueMutex );
+
+			while( m_Reads.empty( ) && !m_Exiting )
+				m_ReadCond.wait( lock );
+
+			if( m_Reads.empty( ) )
+				break;
+
+			Callable = m_Reads.front( );
+			m_Reads.pop( );
+		}
+
+		( *Callable )( );
+		Callable->Close( );
+	}
+}
+
 void CGHostDBSQLite :: Upgrade1_2( )
 {
 	CONSOLE_Print( "[SQLITE3] schema upgrade v1 to v2 started" );
@@ -547,184 +750,195 @@ void CGHostDBSQLite :: Upgrade7_8( )
 
 bool CGHostDBSQLite :: Begin( )
 {
-	return m_DB->Exec( "BEGIN TRANSACTION" ) == SQLITE_OK;
+	return true;
 }
 
 bool CGHostDBSQLite :: Commit( )
 {
-	return m_DB->Exec( "COMMIT TRANSACTION" ) == SQLITE_OK;
+	return true;
 }
 
 uint32_t CGHostDBSQLite :: AdminCount( string server )
 {
+	CSQLITE3 *DB = GetDB( );
 	uint32_t Count = 0;
 	sqlite3_stmt *Statement;
-	m_DB->Prepare( "SELECT COUNT(*) FROM admins WHERE server=?", (void **)&Statement );
+	DB->PrepareCached( "SELECT COUNT(*) FROM admins WHERE server=?", (void **)&Statement );
 
 	if( Statement )
 	{
 		sqlite3_bind_text( Statement, 1, server.c_str( ), -1, SQLITE_TRANSIENT );
-		int RC = m_DB->Step( Statement );
+		int RC = DB->Step( Statement );
 
 		if( RC == SQLITE_ROW )
 			Count = sqlite3_column_int( Statement, 0 );
 		else if( RC == SQLITE_ERROR )
-			CONSOLE_Print( "[SQLITE3] error counting admins [" + server + "] - " + m_DB->GetError( ) );
+			CONSOLE_Print( "[SQLITE3] error counting admins [" + server + "] - " + DB->GetError( ) );
 
-		m_DB->Finalize( Statement );
+		DB->Release( Statement );
 	}
 	else
-		CONSOLE_Print( "[SQLITE3] prepare error counting admins [" + server + "] - " + m_DB->GetError( ) );
+		CONSOLE_Print( "[SQLITE3] prepare error counting admins [" + server + "] - " + DB->GetError( ) );
 
 	return Count;
 }
 
 bool CGHostDBSQLite :: AdminCheck( string server, string user )
 {
+	CSQLITE3 *DB = GetDB( );
+
 	transform( user.begin( ), user.end( ), user.begin( ), (int(*)(int))tolower );
 	bool IsAdmin = false;
 	sqlite3_stmt *Statement;
-	m_DB->Prepare( "SELECT * FROM admins WHERE server=? AND name=?", (void **)&Statement );
+	DB->PrepareCached( "SELECT * FROM admins WHERE server=? AND name=?", (void **)&Statement );
 
 	if( Statement )
 	{
 		sqlite3_bind_text( Statement, 1, server.c_str( ), -1, SQLITE_TRANSIENT );
 		sqlite3_bind_text( Statement, 2, user.c_str( ), -1, SQLITE_TRANSIENT );
-		int RC = m_DB->Step( Statement );
+		int RC = DB->Step( Statement );
 
 		// we're just checking to see if the query returned a row, we don't need to check the row data itself
 
 		if( RC == SQLITE_ROW )
 			IsAdmin = true;
 		else if( RC == SQLITE_ERROR )
-			CONSOLE_Print( "[SQLITE3] error checking admin [" + server + " : " + user + "] - " + m_DB->GetError( ) );
+			CONSOLE_Print( "[SQLITE3] error checking admin [" + server + " : " + user + "] - " + DB->GetError( ) );
 
-		m_DB->Finalize( Statement );
+		DB->Release( Statement );
 	}
 	else
-		CONSOLE_Print( "[SQLITE3] prepare error checking admin [" + server + " : " + user + "] - " + m_DB->GetError( ) );
+		CONSOLE_Print( "[SQLITE3] prepare error checking admin [" + server + " : " + user + "] - " + DB->GetError( ) );
 
 	return IsAdmin;
 }
 
 bool CGHostDBSQLite :: AdminAdd( string server, string user )
 {
+	CSQLITE3 *DB = GetDB( );
+
 	transform( user.begin( ), user.end( ), user.begin( ), (int(*)(int))tolower );
 	bool Success = false;
 	sqlite3_stmt *Statement;
-	m_DB->Prepare( "INSERT INTO admins ( server, name ) VALUES ( ?, ? )", (void **)&Statement );
+	DB->PrepareCached( "INSERT INTO admins ( server, name ) VALUES ( ?, ? )", (void **)&Statement );
 
 	if( Statement )
 	{
 		sqlite3_bind_text( Statement, 1, server.c_str( ), -1, SQLITE_TRANSIENT );
 		sqlite3_bind_text( Statement, 2, user.c_str( ), -1, SQLITE_TRANSIENT );
-		int RC = m_DB->Step( Statement );
+		int RC = DB->Step( Statement );
 
 		if( RC == SQLITE_DONE )
 			Success = true;
 		else if( RC == SQLITE_ERROR )
-			CONSOLE_Print( "[SQLITE3] error adding admin [" + server + " : " + user + "] - " + m_DB->GetError( ) );
+			CONSOLE_Print( "[SQLITE3] error adding admin [" + server + " : " + user + "] - " + DB->GetError( ) );
 
-		m_DB->Finalize( Statement );
+		DB->Release( Statement );
 	}
 	else
-		CONSOLE_Print( "[SQLITE3] prepare error adding admin [" + server + " : " + user + "] - " + m_DB->GetError( ) );
+		CONSOLE_Print( "[SQLITE3] prepare error adding admin [" + server + " : " + user + "] - " + DB->GetError( ) );
 
 	return Success;
 }
 
 bool CGHostDBSQLite :: AdminRemove( string server, string user )
 {
+	CSQLITE3 *DB = GetDB( );
+
 	transform( user.begin( ), user.end( ), user.begin( ), (int(*)(int))tolower );
 	bool Success = false;
 	sqlite3_stmt *Statement;
-	m_DB->Prepare( "DELETE FROM admins WHERE server=? AND name=?", (void **)&Statement );
+	DB->PrepareCached( "DELETE FROM admins WHERE server=? AND name=?", (void **)&Statement );
 
 	if( Statement )
 	{
 		sqlite3_bind_text( Statement, 1, server.c_str( ), -1, SQLITE_TRANSIENT );
 		sqlite3_bind_text( Statement, 2, user.c_str( ), -1, SQLITE_TRANSIENT );
-		int RC = m_DB->Step( Statement );
+		int RC = DB->Step( Statement );
 
 		if( RC == SQLITE_DONE )
 			Success = true;
 		else if( RC == SQLITE_ERROR )
-			CONSOLE_Print( "[SQLITE3] error removing admin [" + server + " : " + user + "] - " + m_DB->GetError( ) );
+			CONSOLE_Print( "[SQLITE3] error removing admin [" + server + " : " + user + "] - " + DB->GetError( ) );
 
-		m_DB->Finalize( Statement );
+		DB->Release( Statement );
 	}
 	else
-		CONSOLE_Print( "[SQLITE3] prepare error removing admin [" + server + " : " + user + "] - " + m_DB->GetError( ) );
+		CONSOLE_Print( "[SQLITE3] prepare error removing admin [" + server + " : " + user + "] - " + DB->GetError( ) );
 
 	return Success;
 }
 
 vector<string> CGHostDBSQLite :: AdminList( string server )
 {
+	CSQLITE3 *DB = GetDB( );
 	vector<string> AdminList;
 	sqlite3_stmt *Statement;
-	m_DB->Prepare( "SELECT name FROM admins WHERE server=?", (void **)&Statement );
+	DB->PrepareCached( "SELECT name FROM admins WHERE server=?", (void **)&Statement );
 
 	if( Statement )
 	{
 		sqlite3_bind_text( Statement, 1, server.c_str( ), -1, SQLITE_TRANSIENT );
-		int RC = m_DB->Step( Statement );
+		int RC = DB->Step( Statement );
 
 		while( RC == SQLITE_ROW )
 		{
-			vector<string> *Row = m_DB->GetRow( );
+			vector<string> *Row = DB->GetRow( );
 
 			if( Row->size( ) == 1 )
 				AdminList.push_back( (*Row)[0] );
 
-			RC = m_DB->Step( Statement );
+			RC = DB->Step( Statement );
 		}
 
 		if( RC == SQLITE_ERROR )
-			CONSOLE_Print( "[SQLITE3] error retrieving admin list [" + server + "] - " + m_DB->GetError( ) );
+			CONSOLE_Print( "[SQLITE3] error retrieving admin list [" + server + "] - " + DB->GetError( ) );
 
-		m_DB->Finalize( Statement );
+		DB->Release( Statement );
 	}
 	else
-		CONSOLE_Print( "[SQLITE3] prepare error retrieving admin list [" + server + "] - " + m_DB->GetError( ) );
+		CONSOLE_Print( "[SQLITE3] prepare error retrieving admin list [" + server + "] - " + DB->GetError( ) );
 
 	return AdminList;
 }
 
 uint32_t CGHostDBSQLite :: BanCount( string server )
 {
+	CSQLITE3 *DB = GetDB( );
 	uint32_t Count = 0;
 	sqlite3_stmt *Statement;
-	m_DB->Prepare( "SELECT COUNT(*) FROM bans WHERE server=?", (void **)&Statement );
+	DB->PrepareCached( "SELECT COUNT(*) FROM bans WHERE server=?", (void **)&Statement );
 
 	if( Statement )
 	{
 		sqlite3_bind_text( Statement, 1, server.c_str( ), -1, SQLITE_TRANSIENT );
-		int RC = m_DB->Step( Statement );
+		int RC = DB->Step( Statement );
 
 		if( RC == SQLITE_ROW )
 			Count = sqlite3_column_int( Statement, 0 );
 		else if( RC == SQLITE_ERROR )
-			CONSOLE_Print( "[SQLITE3] error counting bans [" + server + "] - " + m_DB->GetError( ) );
+			CONSOLE_Print( "[SQLITE3] error counting bans [" + server + "] - " + DB->GetError( ) );
 
-		m_DB->Finalize( Statement );
+		DB->Release( Statement );
 	}
 	else
-		CONSOLE_Print( "[SQLITE3] prepare error counting bans [" + server + "] - " + m_DB->GetError( ) );
+		CONSOLE_Print( "[SQLITE3] prepare error counting bans [" + server + "] - " + DB->GetError( ) );
 
 	return Count;
 }
 
 CDBBan *CGHostDBSQLite :: BanCheck( string server, string user, string ip )
 {
+	CSQLITE3 *DB = GetDB( );
+
 	transform( user.begin( ), user.end( ), user.begin( ), (int(*)(int))tolower );
 	CDBBan *Ban = NULL;
 	sqlite3_stmt *Statement;
 
 	if( ip.empty( ) )
-		m_DB->Prepare( "SELECT name, ip, date, gamename, admin, reason FROM bans WHERE server=? AND name=?", (void **)&Statement );
+		DB->PrepareCached( "SELECT name, ip, date, gamename, admin, reason FROM bans WHERE server=? AND name=?", (void **)&Statement );
 	else
-		m_DB->Prepare( "SELECT name, ip, date, gamename, admin, reason FROM bans WHERE (server=? AND name=?) OR ip=?", (void **)&Statement );
+		DB->PrepareCached( "SELECT name, ip, date, gamename, admin, reason FROM bans WHERE (server=? AND name=?) OR ip=?", (void **)&Statement );
 
 	if( Statement )
 	{
@@ -734,11 +948,11 @@ CDBBan *CGHostDBSQLite :: BanCheck( string server, string user, string ip )
 		if( !ip.empty( ) )
 			sqlite3_bind_text( Statement, 3, ip.c_str( ), -1, SQLITE_TRANSIENT );
 
-		int RC = m_DB->Step( Statement );
+		int RC = DB->Step( Statement );
 
 		if( RC == SQLITE_ROW )
 		{
-			vector<string> *Row = m_DB->GetRow( );
+			vector<string> *Row = DB->GetRow( );
 
 			if( Row->size( ) == 6 )
 				Ban = new CDBBan( server, (*Row)[0], (*Row)[1], (*Row)[2], (*Row)[3], (*Row)[4], (*Row)[5] );
@@ -746,22 +960,24 @@ CDBBan *CGHostDBSQLite :: BanCheck( string server, string user, string ip )
 				CONSOLE_Print( "[SQLITE3] error checking ban [" + server + " : " + user + " : " + ip + "] - row doesn't have 6 columns" );
 		}
 		else if( RC == SQLITE_ERROR )
-			CONSOLE_Print( "[SQLITE3] error checking ban [" + server + " : " + user + " : " + ip + "] - " + m_DB->GetError( ) );
+			CONSOLE_Print( "[SQLITE3] error checking ban [" + server + " : " + user + " : " + ip + "] - " + DB->GetError( ) );
 
-		m_DB->Finalize( Statement );
+		DB->Release( Statement );
 	}
 	else
-		CONSOLE_Print( "[SQLITE3] prepare error checking ban [" + server + " : " + user + " : " + ip + "] - " + m_DB->GetError( ) );
+		CONSOLE_Print( "[SQLITE3] prepare error checking ban [" + server + " : " + user + " : " + ip + "] - " + DB->GetError( ) );
 
 	return Ban;
 }
 
 bool CGHostDBSQLite :: BanAdd( string server, string user, string ip, string gamename, string admin, string reason )
 {
+	CSQLITE3 *DB = GetDB( );
+
 	transform( user.begin( ), user.end( ), user.begin( ), (int(*)(int))tolower );
 	bool Success = false;
 	sqlite3_stmt *Statement;
-	m_DB->Prepare( "INSERT INTO bans ( server, name, ip, date, gamename, admin, reason ) VALUES ( ?, ?, ?, date('now'), ?, ?, ? )", (void **)&Statement );
+	DB->PrepareCached( "INSERT INTO bans ( server, name, ip, date, gamename, admin, reason ) VALUES ( ?, ?, ?, date('now'), ?, ?, ? )", (void **)&Statement );
 
 	if( Statement )
 	{
@@ -772,109 +988,115 @@ bool CGHostDBSQLite :: BanAdd( string server, string user, string ip, string gam
 		sqlite3_bind_text( Statement, 5, admin.c_str( ), -1, SQLITE_TRANSIENT );
 		sqlite3_bind_text( Statement, 6, reason.c_str( ), -1, SQLITE_TRANSIENT );
 
-		int RC = m_DB->Step( Statement );
+		int RC = DB->Step( Statement );
 
 		if( RC == SQLITE_DONE )
 			Success = true;
 		else if( RC == SQLITE_ERROR )
-			CONSOLE_Print( "[SQLITE3] error adding ban [" + server + " : " + user + " : " + ip + " : " + gamename + " : " + admin + " : " + reason + "] - " + m_DB->GetError( ) );
+			CONSOLE_Print( "[SQLITE3] error adding ban [" + server + " : " + user + " : " + ip + " : " + gamename + " : " + admin + " : " + reason + "] - " + DB->GetError( ) );
 
-		m_DB->Finalize( Statement );
+		DB->Release( Statement );
 	}
 	else
-		CONSOLE_Print( "[SQLITE3] prepare error adding ban [" + server + " : " + user + " : " + ip + " : " + gamename + " : " + admin + " : " + reason + "] - " + m_DB->GetError( ) );
+		CONSOLE_Print( "[SQLITE3] prepare error adding ban [" + server + " : " + user + " : " + ip + " : " + gamename + " : " + admin + " : " + reason + "] - " + DB->GetError( ) );
 
 	return Success;
 }
 
 bool CGHostDBSQLite :: BanRemove( string server, string user )
 {
+	CSQLITE3 *DB = GetDB( );
+
 	transform( user.begin( ), user.end( ), user.begin( ), (int(*)(int))tolower );
 	bool Success = false;
 	sqlite3_stmt *Statement;
-	m_DB->Prepare( "DELETE FROM bans WHERE server=? AND name=?", (void **)&Statement );
+	DB->PrepareCached( "DELETE FROM bans WHERE server=? AND name=?", (void **)&Statement );
 
 	if( Statement )
 	{
 		sqlite3_bind_text( Statement, 1, server.c_str( ), -1, SQLITE_TRANSIENT );
 		sqlite3_bind_text( Statement, 2, user.c_str( ), -1, SQLITE_TRANSIENT );
-		int RC = m_DB->Step( Statement );
+		int RC = DB->Step( Statement );
 
 		if( RC == SQLITE_DONE )
 			Success = true;
 		else if( RC == SQLITE_ERROR )
-			CONSOLE_Print( "[SQLITE3] error removing ban [" + server + " : " + user + "] - " + m_DB->GetError( ) );
+			CONSOLE_Print( "[SQLITE3] error removing ban [" + server + " : " + user + "] - " + DB->GetError( ) );
 
-		m_DB->Finalize( Statement );
+		DB->Release( Statement );
 	}
 	else
-		CONSOLE_Print( "[SQLITE3] prepare error removing ban [" + server + " : " + user + "] - " + m_DB->GetError( ) );
+		CONSOLE_Print( "[SQLITE3] prepare error removing ban [" + server + " : " + user + "] - " + DB->GetError( ) );
 
 	return Success;
 }
 
 bool CGHostDBSQLite :: BanRemove( string user )
 {
+	CSQLITE3 *DB = GetDB( );
+
 	transform( user.begin( ), user.end( ), user.begin( ), (int(*)(int))tolower );
 	bool Success = false;
 	sqlite3_stmt *Statement;
-	m_DB->Prepare( "DELETE FROM bans WHERE name=?", (void **)&Statement );
+	DB->PrepareCached( "DELETE FROM bans WHERE name=?", (void **)&Statement );
 
 	if( Statement )
 	{
 		sqlite3_bind_text( Statement, 1, user.c_str( ), -1, SQLITE_TRANSIENT );
-		int RC = m_DB->Step( Statement );
+		int RC = DB->Step( Statement );
 
 		if( RC == SQLITE_DONE )
 			Success = true;
 		else if( RC == SQLITE_ERROR )
-			CONSOLE_Print( "[SQLITE3] error removing ban [" + user + "] - " + m_DB->GetError( ) );
+			CONSOLE_Print( "[SQLITE3] error removing ban [" + user + "] - " + DB->GetError( ) );
 
-		m_DB->Finalize( Statement );
+		DB->Release( Statement );
 	}
 	else
-		CONSOLE_Print( "[SQLITE3] prepare error removing ban [" + user + "] - " + m_DB->GetError( ) );
+		CONSOLE_Print( "[SQLITE3] prepare error removing ban [" + user + "] - " + DB->GetError( ) );
 
 	return Success;
 }
 
 vector<CDBBan *> CGHostDBSQLite :: BanList( string server )
 {
+	CSQLITE3 *DB = GetDB( );
 	vector<CDBBan *> BanList;
 	sqlite3_stmt *Statement;
-	m_DB->Prepare( "SELECT name, ip, date, gamename, admin, reason FROM bans WHERE server=?", (void **)&Statement );
+	DB->PrepareCached( "SELECT name, ip, date, gamename, admin, reason FROM bans WHERE server=?", (void **)&Statement );
 
 	if( Statement )
 	{
 		sqlite3_bind_text( Statement, 1, server.c_str( ), -1, SQLITE_TRANSIENT );
-		int RC = m_DB->Step( Statement );
+		int RC = DB->Step( Statement );
 
 		while( RC == SQLITE_ROW )
 		{
-			vector<string> *Row = m_DB->GetRow( );
+			vector<string> *Row = DB->GetRow( );
 
 			if( Row->size( ) == 6 )
 				BanList.push_back( new CDBBan( server, (*Row)[0], (*Row)[1], (*Row)[2], (*Row)[3], (*Row)[4], (*Row)[5] ) );
 
-			RC = m_DB->Step( Statement );
+			RC = DB->Step( Statement );
 		}
 
 		if( RC == SQLITE_ERROR )
-			CONSOLE_Print( "[SQLITE3] error retrieving ban list [" + server + "] - " + m_DB->GetError( ) );
+			CONSOLE_Print( "[SQLITE3] error retrieving ban list [" + server + "] - " + DB->GetError( ) );
 
-		m_DB->Finalize( Statement );
+		DB->Release( Statement );
 	}
 	else
-		CONSOLE_Print( "[SQLITE3] prepare error retrieving ban list [" + server + "] - " + m_DB->GetError( ) );
+		CONSOLE_Print( "[SQLITE3] prepare error retrieving ban list [" + server + "] - " + DB->GetError( ) );
 
 	return BanList;
 }
 
 uint32_t CGHostDBSQLite :: GameAdd( string server, string map, string gamename, string ownername, uint32_t duration, uint32_t gamestate, string creatorname, string creatorserver )
 {
+	CSQLITE3 *DB = GetDB( );
 	uint32_t RowID = 0;
 	sqlite3_stmt *Statement;
-	m_DB->Prepare( "INSERT INTO games ( server, map, datetime, gamename, ownername, duration, gamestate, creatorname, creatorserver ) VALUES ( ?, ?, datetime('now'), ?, ?, ?, ?, ?, ? )", (void **)&Statement );
+	DB->PrepareCached( "INSERT INTO games ( server, map, datetime, gamename, ownername, duration, gamestate, creatorname, creatorserver ) VALUES ( ?, ?, datetime('now'), ?, ?, ?, ?, ?, ? )", (void **)&Statement );
 
 	if( Statement )
 	{
@@ -887,27 +1109,29 @@ uint32_t CGHostDBSQLite :: GameAdd( string server, string map, string gamename,
 		sqlite3_bind_text( Statement, 7, creatorname.c_str( ), -1, SQLITE_TRANSIENT );
 		sqlite3_bind_text( Statement, 8, creatorserver.c_str( ), -1, SQLITE_TRANSIENT );
 
-		int RC = m_DB->Step( Statement );
+		int RC = DB->Step( Statement );
 
 		if( RC == SQLITE_DONE )
-			RowID = m_DB->LastRowID( );
+			RowID = DB->LastRowID( );
 		else if( RC == SQLITE_ERROR )
-			CONSOLE_Print( "[SQLITE3] error adding game [" + server + " : " + map + " : " + gamename + " : " + ownername + " : " + UTIL_ToString( duration ) + " : " + UTIL_ToString( gamestate ) + " : " + creatorname + " : " + creatorserver + "] - " + m_DB->GetError( ) );
+			CONSOLE_Print( "[SQLITE3] error adding game [" + server + " : " + map + " : " + gamename + " : " + ownername + " : " + UTIL_ToString( duration ) + " : " + UTIL_ToString( gamestate ) + " : " + creatorname + " : " + creatorserver + "] - " + DB->GetError( ) );
 
-		m_DB->Finalize( Statement );
+		DB->Release( Statement );
 	}
 	else
-		CONSOLE_Print( "[SQLITE3] prepare error adding game [" + server + " : " + map + " : " + gamename + " : " + ownername + " : " + UTIL_ToString( duration ) + " : " + UTIL_ToString( gamestate ) + " : " + creatorname + " : " + creatorserver + "] - " + m_DB->GetError( ) );
+		CONSOLE_Print( "[SQLITE3] prepare error adding game [" + server + " : " + map + " : " + gamename + " : " + ownername + " : " + UTIL_ToString( duration ) + " : " + UTIL_ToString( gamestate ) + " : " + creatorname + " : " + creatorserver + "] - " + DB->GetError( ) );
 
 	return RowID;
 }
 
 uint32_t CGHostDBSQLite :: GamePlayerAdd( uint32_t gameid, string name, string ip, uint32_t spoofed, string spoofedrealm, uint32_t reserved, uint32_t loadingtime, uint32_t left, string leftreason, uint32_t team, uint32_t colour )
 {
+	CSQLITE3 *DB = GetDB( );
+
 	transform( name.begin( ), name.end( ), name.begin( ), (int(*)(int))tolower );
 	uint32_t RowID = 0;
 	sqlite3_stmt *Statement;
-	m_DB->Prepare( "INSERT INTO gameplayers ( gameid, name, ip, spoofed, reserved, loadingtime, left, leftreason, team, colour, spoofedrealm ) VALUES ( ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ? )", (void **)&Statement );
+	DB->PrepareCached( "INSERT INTO gameplayers ( gameid, name, ip, spoofed, reserved, loadingtime, left, leftreason, team, colour, spoofedrealm ) VALUES ( ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ? )", (void **)&Statement );
 
 	if( Statement )
 	{
@@ -923,60 +1147,64 @@ uint32_t CGHostDBSQLite :: GamePlayerAdd( uint32_t gameid, string name, string i
 		sqlite3_bind_int( Statement, 10, colour );
 		sqlite3_bind_text( Statement, 11, spoofedrealm.c_str( ), -1, SQLITE_TRANSIENT );
 
-		int RC = m_DB->Step( Statement );
+		int RC = DB->Step( Statement );
 
 		if( RC == SQLITE_DONE )
-			RowID = m_DB->LastRowID( );
+			RowID = DB->LastRowID( );
 		else if( RC == SQLITE_ERROR )
-			CONSOLE_Print( "[SQLITE3] error adding gameplayer [" + UTIL_ToString( gameid ) + " : " + name + " : " + ip + " : " + UTIL_ToString( spoofed ) + " : " + spoofedrealm + " : " + UTIL_ToString( reserved ) + " : " + UTIL_ToString( loadingtime ) + " : " + UTIL_ToString( left ) + " : " + leftreason + " : " + UTIL_ToString( team ) + " : " + UTIL_ToString( colour ) + "] - " + m_DB->GetError( ) );
+			CONSOLE_Print( "[SQLITE3] error adding gameplayer [" + UTIL_ToString( gameid ) + " : " + name + " : " + ip + " : " + UTIL_ToString( spoofed ) + " : " + spoofedrealm + " : " + UTIL_ToString( reserved ) + " : " + UTIL_ToString( loadingtime ) + " : " + UTIL_ToString( left ) + " : " + leftreason + " : " + UTIL_ToString( team ) + " : " + UTIL_ToString( colour ) + "] - " + DB->GetError( ) );
 
-		m_DB->Finalize( Statement );
+		DB->Release( Statement );
 	}
 	else
-		CONSOLE_Print( "[SQLITE3] prepare error adding gameplayer [" + UTIL_ToString( gameid ) + " : " + name + " : " + ip + " : " + UTIL_ToString( spoofed ) + " : " + spoofedrealm + " : " + UTIL_ToString( reserved ) + " : " + UTIL_ToString( loadingtime ) + " : " + UTIL_ToString( left ) + " : " + leftreason + " : " + UTIL_ToString( team ) + " : " + UTIL_ToString( colour ) + "] - " + m_DB->GetError( ) );
+		CONSOLE_Print( "[SQLITE3] prepare error adding gameplayer [" + UTIL_ToString( gameid ) + " : " + name + " : " + ip + " : " + UTIL_ToString( spoofed ) + " : " + spoofedrealm + " : " + UTIL_ToString( reserved ) + " : " + UTIL_ToString( loadingtime ) + " : " + UTIL_ToString( left ) + " : " + leftreason + " : " + UTIL_ToString( team ) + " : " + UTIL_ToString( colour ) + "] - " + DB->GetError( ) );
 
 	return RowID;
 }
 
 uint32_t CGHostDBSQLite :: GamePlayerCount( string name )
 {
+	CSQLITE3 *DB = GetDB( );
+
 	transform( name.begin( ), name.end( ), name.begin( ), (int(*)(int))tolower );
 	uint32_t Count = 0;
 	sqlite3_stmt *Statement;
-	m_DB->Prepare( "SELECT COUNT(*) FROM gameplayers LEFT JOIN games ON games.id=gameid WHERE name=?", (void **)&Statement );
+	DB->PrepareCached( "SELECT COUNT(*) FROM gameplayers LEFT JOIN games ON games.id=gameid WHERE name=?", (void **)&Statement );
 
 	if( Statement )
 	{
 		sqlite3_bind_text( Statement, 1, name.c_str( ), -1, SQLITE_TRANSIENT );
-		int RC = m_DB->Step( Statement );
+		int RC = DB->Step( Statement );
 
 		if( RC == SQLITE_ROW )
 			Count = sqlite3_column_int( Statement, 0 );
 		else if( RC == SQLITE_ERROR )
-			CONSOLE_Print( "[SQLITE3] error counting gameplayers [" + name + "] - " + m_DB->GetError( ) );
+			CONSOLE_Print( "[SQLITE3] error counting gameplayers [" + name + "] - " + DB->GetError( ) );
 
-		m_DB->Finalize( Statement );
+		DB->Release( Statement );
 	}
 	else
-		CONSOLE_Print( "[SQLITE3] prepare error counting gameplayers [" + name + "] - " + m_DB->GetError( ) );
+		CONSOLE_Print( "[SQLITE3] prepare error counting gameplayers [" + name + "] - " + DB->GetError( ) );
 
 	return Count;
 }
 
 CDBGamePlayerSummary *CGHostDBSQLite :: GamePlayerSummaryCheck( string name )
 {
+	CSQLITE3 *DB = GetDB( );
+
 	if( GamePlayerCount( name ) == 0 )
 		return NULL;
 
 	transform( name.begin( ), name.end( ), name.begin( ), (int(*)(int))tolower );
 	CDBGamePlayerSummary *GamePlayerSummary = NULL;
 	sqlite3_stmt *Statement;
-	m_DB->Prepare( "SELECT MIN(datetime), MAX(datetime), COUNT(*), MIN(loadingtime), AVG(loadingtime), MAX(loadingtime), MIN(left/CAST(duration AS REAL))*100, AVG(left/CAST(duration AS REAL))*100, MAX(left/CAST(duration AS REAL))*100, MIN(duration), AVG(duration), MAX(duration) FROM gameplayers LEFT JOIN games ON games.id=gameid WHERE name=?", (void **)&Statement );
+	DB->PrepareCached( "SELECT MIN(datetime), MAX(datetime), COUNT(*), MIN(loadingtime), AVG(loadingtime), MAX(loadingtime), MIN(left/CAST(duration AS REAL))*100, AVG(left/CAST(duration AS REAL))*100, MAX(left/CAST(duration AS REAL))*100, MIN(duration), AVG(duration), MAX(duration) FROM gameplayers LEFT JOIN games ON games.id=gameid WHERE name=?", (void **)&Statement );
 
 	if( Statement )
 	{
 		sqlite3_bind_text( Statement, 1, name.c_str( ), -1, SQLITE_TRANSIENT );
-		int RC = m_DB->Step( Statement );
+		int RC = DB->Step( Statement );
 
 		if( RC == SQLITE_ROW )
 		{
@@ -1009,21 +1237,22 @@ CDBGamePlayerSummary *CGHostDBSQLite :: GamePlayerSummaryCheck( string name )
 				CONSOLE_Print( "[SQLITE3] error checking gameplayersummary [" + name + "] - row doesn't have 12 columns" );
 		}
 		else if( RC == SQLITE_ERROR )
-			CONSOLE_Print( "[SQLITE3] error checking gameplayersummary [" + name + "] - " + m_DB->GetError( ) );
+			CONSOLE_Print( "[SQLITE3] error checking gameplayersummary [" + name + "] - " + DB->GetError( ) );
 
-		m_DB->Finalize( Statement );
+		DB->Release( Statement );
 	}
 	else
-		CONSOLE_Print( "[SQLITE3] prepare error checking gameplayersummary [" + name + "] - " + m_DB->GetError( ) );
+		CONSOLE_Print( "[SQLITE3] prepare error checking gameplayersummary [" + name + "] - " + DB->GetError( ) );
 
 	return GamePlayerSummary;
 }
 
 uint32_t CGHostDBSQLite :: DotAGameAdd( uint32_t gameid, uint32_t winner, uint32_t min, uint32_t sec )
 {
+	CSQLITE3 *DB = GetDB( );
 	uint32_t RowID = 0;
 	sqlite3_stmt *Statement;
-	m_DB->Prepare( "INSERT INTO dotagames ( gameid, winner, min, sec ) VALUES ( ?, ?, ?, ? )", (void **)&Statement );
+	DB->PrepareCached( "INSERT INTO dotagames ( gameid, winner, min, sec ) VALUES ( ?, ?, ?, ? )", (void **)&Statement );
 
 	if( Statement )
 	{
@@ -1032,26 +1261,27 @@ uint32_t CGHostDBSQLite :: DotAGameAdd( uint32_t gameid, uint32_t winner, uint32
 		sqlite3_bind_int( Statement, 3, min );
 		sqlite3_bind_int( Statement, 4, sec );
 
-		int RC = m_DB->Step( Statement );
+		int RC = DB->Step( Statement );
 
 		if( RC == SQLITE_DONE )
-			RowID = m_DB->LastRowID( );
+			RowID = DB->LastRowID( );
 		else if( RC == SQLITE_ERROR )
-			CONSOLE_Print( "[SQLITE3] error adding dotagame [" + UTIL_ToString( gameid ) + " : " + UTIL_ToString( winner ) + " : " + UTIL_ToString( min ) + " : " + UTIL_ToString( sec ) + "] - " + m_DB->GetError( ) );
+			CONSOLE_Print( "[SQLITE3] error adding dotagame [" + UTIL_ToString( gameid ) + " : " + UTIL_ToString( winner ) + " : " + UTIL_ToString( min ) + " : " + UTIL_ToString( sec ) + "] - " + DB->GetError( ) );
 
-		m_DB->Finalize( Statement );
+		DB->Release( Statement );
 	}
 	else
-		CONSOLE_Print( "[SQLITE3] prepare error adding dotagame [" + UTIL_ToString( gameid ) + " : " + UTIL_ToString( winner ) + " : " + UTIL_ToString( min ) + " : " + UTIL_ToString( sec ) + "] - " + m_DB->GetError( ) );
+		CONSOLE_Print( "[SQLITE3] prepare error adding dotagame [" + UTIL_ToString( gameid ) + " : " + UTIL_ToString( winner ) + " : " + UTIL_ToString( min ) + " : " + UTIL_ToString( sec ) + "] - " + DB->GetError( ) );
 
 	return RowID;
 }
 
 uint32_t CGHostDBSQLite :: DotAPlayerAdd( uint32_t gameid, uint32_t colour, uint32_t kills, uint32_t deaths, uint32_t creepkills, uint32_t creepdenies, uint32_t assists, uint32_t gold, uint32_t neutralkills, string item1, string item2, string item3, string item4, string item5, string item6, string hero, uint32_t newcolour, uint32_t towerkills, uint32_t raxkills, uint32_t courierkills )
 {
+	CSQLITE3 *DB = GetDB( );
 	uint32_t RowID = 0;
 	sqlite3_stmt *Statement;
-	m_DB->Prepare( "INSERT INTO dotaplayers ( gameid, colour, kills, deaths, creepkills, creepdenies, assists, gold, neutralkills, item1, item2, item3, item4, item5, item6, hero, newcolour, towerkills, raxkills, courierkills ) VALUES ( ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ? )", (void **)&Statement );
+	DB->PrepareCached( "INSERT INTO dotaplayers ( gameid, colour, kills, deaths, creepkills, creepdenies, assists, gold, neutralkills, item1, item2, item3, item4, item5, item6, hero, newcolour, towerkills, raxkills, courierkills ) VALUES ( ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ? )", (void **)&Statement );
 
 	if( Statement )
 	{
@@ -1076,60 +1306,64 @@ uint32_t CGHostDBSQLite :: DotAPlayerAdd( uint32_t gameid, uint32_t colour, uint
 		sqlite3_bind_int( Statement, 19, raxkills );
 		sqlite3_bind_int( Statement, 20, courierkills );
 
-		int RC = m_DB->Step( Statement );
+		int RC = DB->Step( Statement );
 
 		if( RC == SQLITE_DONE )
-			RowID = m_DB->LastRowID( );
+			RowID = DB->LastRowID( );
 		else if( RC == SQLITE_ERROR )
-			CONSOLE_Print( "[SQLITE3] error adding dotaplayer [" + UTIL_ToString( gameid ) + " : " + UTIL_ToString( colour ) + " : " + UTIL_ToString( kills ) + " : " + UTIL_ToString( deaths ) + " : " + UTIL_ToString( creepkills ) + " : " + UTIL_ToString( creepdenies ) + " : " + UTIL_ToString( assists ) + " : " + UTIL_ToString( gold ) + " : " + UTIL_ToString( neutralkills ) + " : " + item1 + " : " + item2 + " : " + item3 + " : " + item4 + " : " + item5 + " : " + item6 + " : " + hero + " : " + UTIL_ToString( newcolour ) + " : " + UTIL_ToString( towerkills ) + " : " + UTIL_ToString( raxkills ) + " : " + UTIL_ToString( courierkills ) + "] - " + m_DB->GetError( ) );
+			CONSOLE_Print( "[SQLITE3] error adding dotaplayer [" + UTIL_ToString( gameid ) + " : " + UTIL_ToString( colour ) + " : " + UTIL_ToString( kills ) + " : " + UTIL_ToString( deaths ) + " : " + UTIL_ToString( creepkills ) + " : " + UTIL_ToString( creepdenies ) + " : " + UTIL_ToString( assists ) + " : " + UTIL_ToString( gold ) + " : " + UTIL_ToString( neutralkills ) + " : " + item1 + " : " + item2 + " : " + item3 + " : " + item4 + " : " + item5 + " : " + item6 + " : " + hero + " : " + UTIL_ToString( newcolour ) + " : " + UTIL_ToString( towerkills ) + " : " + UTIL_ToString( raxkills ) + " : " + UTIL_ToString( courierkills ) + "] - " + DB->GetError( ) );
 
-		m_DB->Finalize( Statement );
+		DB->Release( Statement );
 	}
 	else
-		CONSOLE_Print( "[SQLITE3] prepare error adding dotaplayer [" + UTIL_ToString( gameid ) + " : " + UTIL_ToString( colour ) + " : " + UTIL_ToString( kills ) + " : " + UTIL_ToString( deaths ) + " : " + UTIL_ToString( creepkills ) + " : " + UTIL_ToString( creepdenies ) + " : " + UTIL_ToString( assists ) + " : " + UTIL_ToString( gold ) + " : " + UTIL_ToString( neutralkills ) + " : " + item1 + " : " + item2 + " : " + item3 + " : " + item4 + " : " + item5 + " : " + item6 + " : " + hero + " : " + UTIL_ToString( newcolour ) + " : " + UTIL_ToString( towerkills ) + " : " + UTIL_ToString( raxkills ) + " : " + UTIL_ToString( courierkills ) + "] - " + m_DB->GetError( ) );
+		CONSOLE_Print( "[SQLITE3] prepare error adding dotaplayer [" + UTIL_ToString( gameid ) + " : " + UTIL_ToString( colour ) + " : " + UTIL_ToString( kills ) + " : " + UTIL_ToString( deaths ) + " : " + UTIL_ToString( creepkills ) + " : " + UTIL_ToString( creepdenies ) + " : " + UTIL_ToString( assists ) + " : " + UTIL_ToString( gold ) + " : " + UTIL_ToString( neutralkills ) + " : " + item1 + " : " + item2 + " : " + item3 + " : " + item4 + " : " + item5 + " : " + item6 + " : " + hero + " : " + UTIL_ToString( newcolour ) + " : " + UTIL_ToString( towerkills ) + " : " + UTIL_ToString( raxkills ) + " : " + UTIL_ToString( courierkills ) + "] - " + DB->GetError( ) );
 
 	return RowID;
 }
 
 uint32_t CGHostDBSQLite :: DotAPlayerCount( string name )
 {
+	CSQLITE3 *DB = GetDB( );
+
 	transform( name.begin( ), name.end( ), name.begin( ), (int(*)(int))tolower );
 	uint32_t Count = 0;
 	sqlite3_stmt *Statement;
-	m_DB->Prepare( "SELECT COUNT(dotaplayers.id) FROM gameplayers LEFT JOIN games ON games.id=gameplayers.gameid LEFT JOIN dotaplayers ON dotaplayers.gameid=games.id AND dotaplayers.colour=gameplayers.colour WHERE name=?", (void **)&Statement );
+	DB->PrepareCached( "SELECT COUNT(dotaplayers.id) FROM gameplayers LEFT JOIN games ON games.id=gameplayers.gameid LEFT JOIN dotaplayers ON dotaplayers.gameid=games.id AND dotaplayers.colour=gameplayers.colour WHERE name=?", (void **)&Statement );
 
 	if( Statement )
 	{
 		sqlite3_bind_text( Statement, 1, name.c_str( ), -1, SQLITE_TRANSIENT );
-		int RC = m_DB->Step( Statement );
+		int RC = DB->Step( Statement );
 
 		if( RC == SQLITE_ROW )
 			Count = sqlite3_column_int( Statement, 0 );
 		else if( RC == SQLITE_ERROR )
-			CONSOLE_Print( "[SQLITE3] error counting dotaplayers [" + name + "] - " + m_DB->GetError( ) );
+			CONSOLE_Print( "[SQLITE3] error counting dotaplayers [" + name + "] - " + DB->GetError( ) );
 
-		m_DB->Finalize( Statement );
+		DB->Release( Statement );
 	}
 	else
-		CONSOLE_Print( "[SQLITE3] prepare error counting dotaplayers [" + name + "] - " + m_DB->GetError( ) );
+		CONSOLE_Print( "[SQLITE3] prepare error counting dotaplayers [" + name + "] - " + DB->GetError( ) );
 
 	return Count;
 }
 
 CDBDotAPlayerSummary *CGHostDBSQLite :: DotAPlayerSummaryCheck( string name )
 {
+	CSQLITE3 *DB = GetDB( );
+
 	if( DotAPlayerCount( name ) == 0 )
 		return NULL;
 
 	transform( name.begin( ), name.end( ), name.begin( ), (int(*)(int))tolower );
 	CDBDotAPlayerSummary *DotAPlayerSummary = NULL;
 	sqlite3_stmt *Statement;
-	m_DB->Prepare( "SELECT COUNT(dotaplayers.id), SUM(kills), SUM(deaths), SUM(creepkills), SUM(creepdenies), SUM(assists), SUM(neutralkills), SUM(towerkills), SUM(raxkills), SUM(courierkills) FROM gameplayers LEFT JOIN games ON games.id=gameplayers.gameid LEFT JOIN dotaplayers ON dotaplayers.gameid=games.id AND dotaplayers.colour=gameplayers.colour WHERE name=?", (void **)&Statement );
+	DB->PrepareCached( "SELECT COUNT(dotaplayers.id), SUM(kills), SUM(deaths), SUM(creepkills), SUM(creepdenies), SUM(assists), SUM(neutralkills), SUM(towerkills), SUM(raxkills), SUM(courierkills) FROM gameplayers LEFT JOIN games ON games.id=gameplayers.gameid LEFT JOIN dotaplayers ON dotaplayers.gameid=games.id AND dotaplayers.colour=gameplayers.colour WHERE name=?", (void **)&Statement );
 
 	if( Statement )
 	{
 		sqlite3_bind_text( Statement, 1, name.c_str( ), -1, SQLITE_TRANSIENT );
-		int RC = m_DB->Step( Statement );
+		int RC = DB->Step( Statement );
 
 		if( RC == SQLITE_ROW )
 		{
@@ -1151,42 +1385,42 @@ CDBDotAPlayerSummary *CGHostDBSQLite :: DotAPlayerSummaryCheck( string name )
 				// calculate total wins
 
 				sqlite3_stmt *Statement2;
-				m_DB->Prepare( "SELECT COUNT(*) FROM gameplayers LEFT JOIN games ON games.id=gameplayers.gameid LEFT JOIN dotaplayers ON dotaplayers.gameid=games.id AND dotaplayers.colour=gameplayers.colour LEFT JOIN dotagames ON games.id=dotagames.gameid WHERE name=? AND ((winner=1 AND dotaplayers.newcolour>=1 AND dotaplayers.newcolour<=5) OR (winner=2 AND dotaplayers.newcolour>=7 AND dotaplayers.newcolour<=11))", (void **)&Statement2 );
+				DB->PrepareCached( "SELECT COUNT(*) FROM gameplayers LEFT JOIN games ON games.id=gameplayers.gameid LEFT JOIN dotaplayers ON dotaplayers.gameid=games.id AND dotaplayers.colour=gameplayers.colour LEFT JOIN dotagames ON games.id=dotagames.gameid WHERE name=? AND ((winner=1 AND dotaplayers.newcolour>=1 AND dotaplayers.newcolour<=5) OR (winner=2 AND dotaplayers.newcolour>=7 AND dotaplayers.newcolour<=11))", (void **)&Statement2 );
 
 				if( Statement2 )
 				{
 					sqlite3_bind_text( Statement2, 1, name.c_str( ), -1, SQLITE_TRANSIENT );
-					int RC2 = m_DB->Step( Statement2 );
+					int RC2 = DB->Step( Statement2 );
 
 					if( RC2 == SQLITE_ROW )
 						TotalWins = sqlite3_column_int( Statement2, 0 );
 					else if( RC2 == SQLITE_ERROR )
-						CONSOLE_Print( "[SQLITE3] error counting dotaplayersummary wins [" + name + "] - " + m_DB->GetError( ) );
+						CONSOLE_Print( "[SQLITE3] error counting dotaplayersummary wins [" + name + "] - " + DB->GetError( ) );
 
-					m_DB->Finalize( Statement2 );
+					DB->Release( Statement2 );
 				}
 				else
-					CONSOLE_Print( "[SQLITE3] prepare error counting dotaplayersummary wins [" + name + "] - " + m_DB->GetError( ) );
+					CONSOLE_Print( "[SQLITE3] prepare error counting dotaplayersummary wins [" + name + "] - " + DB->GetError( ) );
 
 				// calculate total losses
 
 				sqlite3_stmt *Statement3;
-				m_DB->Prepare( "SELECT COUNT(*) FROM gameplayers LEFT JOIN games ON games.id=gameplayers.gameid LEFT JOIN dotaplayers ON dotaplayers.gameid=games.id AND dotaplayers.colour=gameplayers.colour LEFT JOIN dotagames ON games.id=dotagames.gameid WHERE name=? AND ((winner=2 AND dotaplayers.newcolour>=1 AND dotaplayers.newcolour<=5) OR (winner=1 AND dotaplayers.newcolour>=7 AND dotaplayers.newcolour<=11))", (void **)&Statement3 );
+				DB->PrepareCached( "SELECT COUNT(*) FROM gameplayers LEFT JOIN games ON games.id=gameplayers.gameid LEFT JOIN dotaplayers ON dotaplayers.gameid=games.id AND dotaplayers.colour=gameplayers.colour LEFT JOIN dotagames ON games.id=dotagames.gameid WHERE name=? AND ((winner=2 AND dotaplayers.newcolour>=1 AND dotaplayers.newcolour<=5) OR (winner=1 AND dotaplayers.newcolour>=7 AND dotaplayers.newcolour<=11))", (void **)&Statement3 );
 
 				if( Statement3 )
 				{
 					sqlite3_bind_text( Statement3, 1, name.c_str( ), -1, SQLITE_TRANSIENT );
-					int RC3 = m_DB->Step( Statement3 );
+					int RC3 = DB->Step( Statement3 );
 
 					if( RC3 == SQLITE_ROW )
 						TotalLosses = sqlite3_column_int( Statement3, 0 );
 					else if( RC3 == SQLITE_ERROR )
-						CONSOLE_Print( "[SQLITE3] error counting dotaplayersummary losses [" + name + "] - " + m_DB->GetError( ) );
+						CONSOLE_Print( "[SQLITE3] error counting dotaplayersummary losses [" + name + "] - " + DB->GetError( ) );
 
-					m_DB->Finalize( Statement3 );
+					DB->Release( Statement3 );
 				}
 				else
-					CONSOLE_Print( "[SQLITE3] prepare error counting dotaplayersummary losses [" + name + "] - " + m_DB->GetError( ) );
+					CONSOLE_Print( "[SQLITE3] prepare error counting dotaplayersummary losses [" + name + "] - " + DB->GetError( ) );
 
 				// done
 
@@ -1196,12 +1430,12 @@ CDBDotAPlayerSummary *CGHostDBSQLite :: DotAPlayerSummaryCheck( string name )
 				CONSOLE_Print( "[SQLITE3] error checking dotaplayersummary [" + name + "] - row doesn't have 7 columns" );
 		}
 		else if( RC == SQLITE_ERROR )
-			CONSOLE_Print( "[SQLITE3] error checking dotaplayersummary [" + name + "] - " + m_DB->GetError( ) );
+			CONSOLE_Print( "[SQLITE3] error checking dotaplayersummary [" + name + "] - " + DB->GetError( ) );
 
-		m_DB->Finalize( Statement );
+		DB->Release( Statement );
 	}
 	else
-		CONSOLE_Print( "[SQLITE3] prepare error checking dotaplayersummary [" + name + "] - " + m_DB->GetError( ) );
+		CONSOLE_Print( "[SQLITE3] prepare error checking dotaplayersummary [" + name + "] - " + DB->GetError( ) );
 
 	return DotAPlayerSummary;
 }
@@ -1209,76 +1443,43 @@ CDBDotAPlayerSummary *CGHostDBSQLite :: DotAPlayerSummaryCheck( string name )
 string CGHostDBSQLite :: FromCheck( uint32_t ip )
 {
 	// a big thank you to tjado for help with the iptocountry feature
+	// the ranges don't overlap so the only candidate is the range with the largest ip1 which is <= ip
 
-	string From = "??";
-	sqlite3_stmt *Statement;
-	m_DB->Prepare( "SELECT country FROM iptocountry WHERE ip1<=? AND ip2>=?", (void **)&Statement );
+	boost::mutex::scoped_lock lock( m_FromMutex );
+	map<uint32_t, pair<uint32_t, string> > :: iterator i = m_From.upper_bound( ip );
 
-	if( Statement )
+	if( i != m_From.begin( ) )
 	{
-		// we bind the ip as an int64 because SQLite treats it as signed
-
-		sqlite3_bind_int64( Statement, 1, ip );
-		sqlite3_bind_int64( Statement, 2, ip );
-		int RC = m_DB->Step( Statement );
+		--i;
 
-		if( RC == SQLITE_ROW )
-		{
-			vector<string> *Row = m_DB->GetRow( );
-
-			if( Row->size( ) == 1 )
-				From = (*Row)[0];
-			else
-				CONSOLE_Print( "[SQLITE3] error checking iptocountry [" + UTIL_ToString( ip ) + "] - row doesn't have 1 column" );
-		}
-		else if( RC == SQLITE_ERROR )
-			CONSOLE_Print( "[SQLITE3] error checking iptocountry [" + UTIL_ToString( ip ) + "] - " + m_DB->GetError( ) );
-
-		m_DB->Finalize( Statement );
+		if( i->second.first >= ip )
+			return i->second.second;
 	}
-	else
-		CONSOLE_Print( "[SQLITE3] prepare error checking iptocountry [" + UTIL_ToString( ip ) + "] - " + m_DB->GetError( ) );
 
-	return From;
+	return "??";
 }
 
 bool CGHostDBSQLite :: FromAdd( uint32_t ip1, uint32_t ip2, string country )
 {
 	// a big thank you to tjado for help with the iptocountry feature
 
-	bool Success = false;
-
-	if( !FromAddStmt )
-		m_DB->Prepare( "INSERT INTO iptocountry VALUES ( ?, ?, ? )", (void **)&FromAddStmt );
+	boost::mutex::scoped_lock lock( m_FromMutex );
 
-	if( FromAddStmt )
+	if( !m_From.insert( make_pair( ip1, make_pair( ip2, country ) ) ).second )
 	{
-		// we bind the ip as an int64 because SQLite treats it as signed
-
-		sqlite3_bind_int64( (sqlite3_stmt *)FromAddStmt, 1, ip1 );
-		sqlite3_bind_int64( (sqlite3_stmt *)FromAddStmt, 2, ip2 );
-		sqlite3_bind_text( (sqlite3_stmt *)FromAddStmt, 3, country.c_str( ), -1, SQLITE_TRANSIENT );
-
-		int RC = m_DB->Step( FromAddStmt );
-
-		if( RC == SQLITE_DONE )
-			Success = true;
-		else if( RC == SQLITE_ERROR )
-			CONSOLE_Print( "[SQLITE3] error adding iptocountry [" + UTIL_ToString( ip1 ) + " : " + UTIL_ToString( ip2 ) + " : " + country + "] - " + m_DB->GetError( ) );
-
-		m_DB->Reset( FromAddStmt );
+		CONSOLE_Print( "[SQLITE3] error adding iptocountry [" + UTIL_ToString( ip1 ) + " : " + UTIL_ToString( ip2 ) + " : " + country + "] - duplicate range" );
+		return false;
 	}
-	else
-		CONSOLE_Print( "[SQLITE3] prepare error adding iptocountry [" + UTIL_ToString( ip1 ) + " : " + UTIL_ToString( ip2 ) + " : " + country + "] - " + m_DB->GetError( ) );
 
-	return Success;
+	return true;
 }
 
 bool CGHostDBSQLite :: DownloadAdd( string map, uint32_t mapsize, string name, string ip, uint32_t spoofed, string spoofedrealm, uint32_t downloadtime )
 {
+	CSQLITE3 *DB = GetDB( );
 	bool Success = false;
 	sqlite3_stmt *Statement;
-	m_DB->Prepare( "INSERT INTO downloads ( map, mapsize, datetime, name, ip, spoofed, spoofedrealm, downloadtime ) VALUES ( ?, ?, datetime('now'), ?, ?, ?, ?, ? )", (void **)&Statement );
+	DB->PrepareCached( "INSERT INTO downloads ( map, mapsize, datetime, name, ip, spoofed, spoofedrealm, downloadtime ) VALUES ( ?, ?, datetime('now'), ?, ?, ?, ?, ? )", (void **)&Statement );
 
 	if( Statement )
 	{
@@ -1290,26 +1491,27 @@ bool CGHostDBSQLite :: DownloadAdd( string map, uint32_t mapsize, string name, s
 		sqlite3_bind_text( Statement, 6, spoofedrealm.c_str( ), -1, SQLITE_TRANSIENT );
 		sqlite3_bind_int( Statement, 7, downloadtime );
 
-		int RC = m_DB->Step( Statement );
+		int RC = DB->Step( Statement );
 
 		if( RC == SQLITE_DONE )
 			Success = true;
 		else if( RC == SQLITE_ERROR )
-			CONSOLE_Print( "[SQLITE3] error adding download [" + map + " : " + UTIL_ToString( mapsize ) + " : " + name + " : " + ip + " : " + UTIL_ToString( spoofed ) + " : " + spoofedrealm + " : " + UTIL_ToString( downloadtime ) + "] - " + m_DB->GetError( ) );
+			CONSOLE_Print( "[SQLITE3] error adding download [" + map + " : " + UTIL_ToString( mapsize ) + " : " + name + " : " + ip + " : " + UTIL_ToString( spoofed ) + " : " + spoofedrealm + " : " + UTIL_ToString( downloadtime ) + "] - " + DB->GetError( ) );
 
-		m_DB->Finalize( Statement );
+		DB->Release( Statement );
 	}
 	else
-		CONSOLE_Print( "[SQLITE3] prepare error adding download [" + map + " : " + UTIL_ToString( mapsize ) + " : " + name + " : " + ip + " : " + UTIL_ToString( spoofed ) + " : " + spoofedrealm + " : " + UTIL_ToString( downloadtime ) + "] - " + m_DB->GetError( ) );
+		CONSOLE_Print( "[SQLITE3] prepare error adding download [" + map + " : " + UTIL_ToString( mapsize ) + " : " + name + " : " + ip + " : " + UTIL_ToString( spoofed ) + " : " + spoofedrealm + " : " + UTIL_ToString( downloadtime ) + "] - " + DB->GetError( ) );
 
 	return Success;
 }
 
 uint32_t CGHostDBSQLite :: W3MMDPlayerAdd( string category, uint32_t gameid, uint32_t pid, string name, string flag, uint32_t leaver, uint32_t practicing )
 {
+	CSQLITE3 *DB = GetDB( );
 	uint32_t RowID = 0;
 	sqlite3_stmt *Statement;
-	m_DB->Prepare( "INSERT INTO w3mmdplayers ( category, gameid, pid, name, flag, leaver, practicing ) VALUES ( ?, ?, ?, ?, ?, ?, ? )", (void **)&Statement );
+	DB->PrepareCached( "INSERT INTO w3mmdplayers ( category, gameid, pid, name, flag, leaver, practicing ) VALUES ( ?, ?, ?, ?, ?, ?, ? )", (void **)&Statement );
 
 	if( Statement )
 	{
@@ -1321,23 +1523,25 @@ uint32_t CGHostDBSQLite :: W3MMDPlayerAdd( string category, uint32_t gameid, uin
 		sqlite3_bind_int( Statement, 6, leaver );
 		sqlite3_bind_int( Statement, 7, practicing );
 
-		int RC = m_DB->Step( Statement );
+		int RC = DB->Step( Statement );
 
 		if( RC == SQLITE_DONE )
-			RowID = m_DB->LastRowID( );
+			RowID = DB->LastRowID( );
 		else if( RC == SQLITE_ERROR )
-			CONSOLE_Print( "[SQLITE3] error adding w3mmdplayer [" + category + " : " + UTIL_ToString( gameid ) + " : " + UTIL_ToString( pid ) + " : " + name + " : " + flag + " : " + UTIL_ToString( leaver ) + " : " + UTIL_ToString( practicing ) + "] - " + m_DB->GetError( ) );
+			CONSOLE_Print( "[SQLITE3] error adding w3mmdplayer [" + category + " : " + UTIL_ToString( gameid ) + " : " + UTIL_ToString( pid ) + " : " + name + " : " + flag + " : " + UTIL_ToString( leaver ) + " : " + UTIL_ToString( practicing ) + "] - " + DB->GetError( ) );
 
-		m_DB->Finalize( Statement );
+		DB->Release( Statement );
 	}
 	else
-		CONSOLE_Print( "[SQLITE3] prepare error adding w3mmdplayer [" + category + " : " + UTIL_ToString( gameid ) + " : " + UTIL_ToString( pid ) + " : " + name + " : " + flag + " : " + UTIL_ToString( leaver ) + " : " + UTIL_ToString( practicing ) + "] - " + m_DB->GetError( ) );
+		CONSOLE_Print( "[SQLITE3] prepare error adding w3mmdplayer [" + category + " : " + UTIL_ToString( gameid ) + " : " + UTIL_ToString( pid ) + " : " + name + " : " + flag + " : " + UTIL_ToString( leaver ) + " : " + UTIL_ToString( practicing ) + "] - " + DB->GetError( ) );
 
 	return RowID;
 }
 
 bool CGHostDBSQLite :: W3MMDVarAdd( uint32_t gameid, map<VarP,int32_t> var_ints )
 {
+	CSQLITE3 *DB = GetDB( );
+
 	if( var_ints.empty( ) )
 		return false;
 
@@ -1347,7 +1551,7 @@ bool CGHostDBSQLite :: W3MMDVarAdd( uint32_t gameid, map<VarP,int32_t> var_ints
 	for( map<VarP,int32_t> :: iterator i = var_ints.begin( ); i != var_ints.end( ); ++i )
 	{
 		if( !Statement )
-			m_DB->Prepare( "INSERT INTO w3mmdvars ( gameid, pid, varname, value_int ) VALUES ( ?, ?, ?, ? )", (void **)&Statement );
+			DB->PrepareCached( "INSERT INTO w3mmdvars ( gameid, pid, varname, value_int ) VALUES ( ?, ?, ?, ? )", (void **)&Statement );
 
 		if( Statement )
 		{
@@ -1356,33 +1560,35 @@ bool CGHostDBSQLite :: W3MMDVarAdd( uint32_t gameid, map<VarP,int32_t> var_ints
 			sqlite3_bind_text( Statement, 3, i->first.second.c_str( ), -1, SQLITE_TRANSIENT );
 			sqlite3_bind_int( Statement, 4, i->second );
 
-			int RC = m_DB->Step( Statement );
+			int RC = DB->Step( Statement );
 
 			if( RC == SQLITE_ERROR )
 			{
 				Success = false;
-				CONSOLE_Print( "[SQLITE3] error adding w3mmdvar-int [" + UTIL_ToString( gameid ) + " : " + UTIL_ToString( i->first.first ) + " : " + i->first.second + " : " + UTIL_ToString( i->second ) + "] - " + m_DB->GetError( ) );
+				CONSOLE_Print( "[SQLITE3] error adding w3mmdvar-int [" + UTIL_ToString( gameid ) + " : " + UTIL_ToString( i->first.first ) + " : " + i->first.second + " : " + UTIL_ToString( i->second ) + "] - " + DB->GetError( ) );
 				break;
 			}
 
-			m_DB->Reset( Statement );
+			DB->Reset( Statement );
 		}
 		else
 		{
 			Success = false;
-			CONSOLE_Print( "[SQLITE3] prepare error adding w3mmdvar-int [" + UTIL_ToString( gameid ) + " : " + UTIL_ToString( i->first.first ) + " : " + i->first.second + " : " + UTIL_ToString( i->second ) + "] - " + m_DB->GetError( ) );
+			CONSOLE_Print( "[SQLITE3] prepare error adding w3mmdvar-int [" + UTIL_ToString( gameid ) + " : " + UTIL_ToString( i->first.first ) + " : " + i->first.second + " : " + UTIL_ToString( i->second ) + "] - " + DB->GetError( ) );
 			break;
 		}
 	}
 
 	if( Statement )
-		m_DB->Finalize( Statement );
+		DB->Release( Statement );
 
 	return Success;
 }
 
 bool CGHostDBSQLite :: W3MMDVarAdd( uint32_t gameid, map<VarP,double> var_reals )
 {
+	CSQLITE3 *DB = GetDB( );
+
 	if( var_reals.empty( ) )
 		return false;
 
@@ -1392,7 +1598,7 @@ bool CGHostDBSQLite :: W3MMDVarAdd( uint32_t gameid, map<VarP,double> var_reals
 	for( map<VarP,double> :: iterator i = var_reals.begin( ); i != var_reals.end( ); ++i )
 	{
 		if( !Statement )
-			m_DB->Prepare( "INSERT INTO w3mmdvars ( gameid, pid, varname, value_real ) VALUES ( ?, ?, ?, ? )", (void **)&Statement );
+			DB->PrepareCached( "INSERT INTO w3mmdvars ( gameid, pid, varname, value_real ) VALUES ( ?, ?, ?, ? )", (void **)&Statement );
 
 		if( Statement )
 		{
@@ -1401,33 +1607,35 @@ bool CGHostDBSQLite :: W3MMDVarAdd( uint32_t gameid, map<VarP,double> var_reals
 			sqlite3_bind_text( Statement, 3, i->first.second.c_str( ), -1, SQLITE_TRANSIENT );
 			sqlite3_bind_double( Statement, 4, i->second );
 
-			int RC = m_DB->Step( Statement );
+			int RC = DB->Step( Statement );
 
 			if( RC == SQLITE_ERROR )
 			{
 				Success = false;
-				CONSOLE_Print( "[SQLITE3] error adding w3mmdvar-real [" + UTIL_ToString( gameid ) + " : " + UTIL_ToString( i->first.first ) + " : " + i->first.second + " : " + UTIL_ToString( i->second, 10 ) + "] - " + m_DB->GetError( ) );
+				CONSOLE_Print( "[SQLITE3] error adding w3mmdvar-real [" + UTIL_ToString( gameid ) + " : " + UTIL_ToString( i->first.first ) + " : " + i->first.second + " : " + UTIL_ToString( i->second, 10 ) + "] - " + DB->GetError( ) );
 				break;
 			}
 
-			m_DB->Reset( Statement );
+			DB->Reset( Statement );
 		}
 		else
 		{
 			Success = false;
-			CONSOLE_Print( "[SQLITE3] prepare error adding w3mmdvar-real [" + UTIL_ToString( gameid ) + " : " + UTIL_ToString( i->first.first ) + " : " + i->first.second + " : " + UTIL_ToString( i->second, 10 ) + "] - " + m_DB->GetError( ) );
+			CONSOLE_Print( "[SQLITE3] prepare error adding w3mmdvar-real [" + UTIL_ToString( gameid ) + " : " + UTIL_ToString( i->first.first ) + " : " + i->first.second + " : " + UTIL_ToString( i->second, 10 ) + "] - " + DB->GetError( ) );
 			break;
 		}
 	}
 
 	if( Statement )
-		m_DB->Finalize( Statement );
+		DB->Release( Statement );
 
 	return Success;
 }
 
 bool CGHostDBSQLite :: W3MMDVarAdd( uint32_t gameid, map<VarP,string> var_strings )
 {
+	CSQLITE3 *DB = GetDB( );
+
 	if( var_strings.empty( ) )
 		return false;
 
@@ -1437,7 +1645,7 @@ bool CGHostDBSQLite :: W3MMDVarAdd( uint32_t gameid, map<VarP,string> var_string
 	for( map<VarP,string> :: iterator i = var_strings.begin( ); i != var_strings.end( ); ++i )
 	{
 		if( !Statement )
-			m_DB->Prepare( "INSERT INTO w3mmdvars ( gameid, pid, varname, value_string ) VALUES ( ?, ?, ?, ? )", (void **)&Statement );
+			DB->PrepareCached( "INSERT INTO w3mmdvars ( gameid, pid, varname, value_string ) VALUES ( ?, ?, ?, ? )", (void **)&Statement );
 
 		if( Statement )
 		{
@@ -1446,203 +1654,326 @@ bool CGHostDBSQLite :: W3MMDVarAdd( uint32_t gameid, map<VarP,string> var_string
 			sqlite3_bind_text( Statement, 3, i->first.second.c_str( ), -1, SQLITE_TRANSIENT );
 			sqlite3_bind_text( Statement, 4, i->second.c_str( ), -1, SQLITE_TRANSIENT );
 
-			int RC = m_DB->Step( Statement );
+			int RC = DB->Step( Statement );
 
 			if( RC == SQLITE_ERROR )
 			{
 				Success = false;
-				CONSOLE_Print( "[SQLITE3] error adding w3mmdvar-string [" + UTIL_ToString( gameid ) + " : " + UTIL_ToString( i->first.first ) + " : " + i->first.second + " : " + i->second + "] - " + m_DB->GetError( ) );
+				CONSOLE_Print( "[SQLITE3] error adding w3mmdvar-string [" + UTIL_ToString( gameid ) + " : " + UTIL_ToString( i->first.first ) + " : " + i->first.second + " : " + i->second + "] - " + DB->GetError( ) );
 				break;
 			}
 
-			m_DB->Reset( Statement );
+			DB->Reset( Statement );
 		}
 		else
 		{
 			Success = false;
-			CONSOLE_Print( "[SQLITE3] prepare error adding w3mmdvar-string [" + UTIL_ToString( gameid ) + " : " + UTIL_ToString( i->first.first ) + " : " + i->first.second + " : " + i->second + "] - " + m_DB->GetError( ) );
+			CONSOLE_Print( "[SQLITE3] prepare error adding w3mmdvar-string [" + UTIL_ToString( gameid ) + " : " + UTIL_ToString( i->first.first ) + " : " + i->first.second + " : " + i->second + "] - " + DB->GetError( ) );
 			break;
 		}
 	}
 
 	if( Statement )
-		m_DB->Finalize( Statement );
+		DB->Release( Statement );
 
 	return Success;
 }
 
 CCallableAdminCount *CGHostDBSQLite :: ThreadedAdminCount( string server )
 {
-	CCallableAdminCount *Callable = new CCallableAdminCount( server );
-	Callable->SetResult( AdminCount( server ) );
-	Callable->SetReady( true );
+	CCallableAdminCount *Callable = new CSQLiteCallableAdminCount( server, this );
+	Queue( Callable, false );
 	return Callable;
 }
 
 CCallableAdminCheck *CGHostDBSQLite :: ThreadedAdminCheck( string server, string user )
 {
-	CCallableAdminCheck *Callable = new CCallableAdminCheck( server, user );
-	Callable->SetResult( AdminCheck( server, user ) );
-	Callable->SetReady( true );
+	CCallableAdminCheck *Callable = new CSQLiteCallableAdminCheck( server, user, this );
+	Queue( Callable, false );
 	return Callable;
 }
 
 CCallableAdminAdd *CGHostDBSQLite :: ThreadedAdminAdd( string server, string user )
 {
-	CCallableAdminAdd *Callable = new CCallableAdminAdd( server, user );
-	Callable->SetResult( AdminAdd( server, user ) );
-	Callable->SetReady( true );
+	CCallableAdminAdd *Callable = new CSQLiteCallableAdminAdd( server, user, this );
+	Queue( Callable, true );
 	return Callable;
 }
 
 CCallableAdminRemove *CGHostDBSQLite :: ThreadedAdminRemove( string server, string user )
 {
-	CCallableAdminRemove *Callable = new CCallableAdminRemove( server, user );
-	Callable->SetResult( AdminRemove( server, user ) );
-	Callable->SetReady( true );
+	CCallableAdminRemove *Callable = new CSQLiteCallableAdminRemove( server, user, this );
+	Queue( Callable, true );
 	return Callable;
 }
 
 CCallableAdminList *CGHostDBSQLite :: ThreadedAdminList( string server )
 {
-	CCallableAdminList *Callable = new CCallableAdminList( server );
-	Callable->SetResult( AdminList( server ) );
-	Callable->SetReady( true );
+	CCallableAdminList *Callable = new CSQLiteCallableAdminList( server, this );
+	Queue( Callable, false );
 	return Callable;
 }
 
 CCallableBanCount *CGHostDBSQLite :: ThreadedBanCount( string server )
 {
-	CCallableBanCount *Callable = new CCallableBanCount( server );
-	Callable->SetResult( BanCount( server ) );
-	Callable->SetReady( true );
+	CCallableBanCount *Callable = new CSQLiteCallableBanCount( server, this );
+	Queue( Callable, false );
 	return Callable;
 }
 
 CCallableBanCheck *CGHostDBSQLite :: ThreadedBanCheck( string server, string user, string ip )
 {
-	CCallableBanCheck *Callable = new CCallableBanCheck( server, user, ip );
-	Callable->SetResult( BanCheck( server, user, ip ) );
-	Callable->SetReady( true );
+	CCallableBanCheck *Callable = new CSQLiteCallableBanCheck( server, user, ip, this );
+	Queue( Callable, false );
 	return Callable;
 }
 
 CCallableBanAdd *CGHostDBSQLite :: ThreadedBanAdd( string server, string user, string ip, string gamename, string admin, string reason )
 {
-	CCallableBanAdd *Callable = new CCallableBanAdd( server, user, ip, gamename, admin, reason );
-	Callable->SetResult( BanAdd( server, user, ip, gamename, admin, reason ) );
-	Callable->SetReady( true );
+	CCallableBanAdd *Callable = new CSQLiteCallableBanAdd( server, user, ip, gamename, admin, reason, this );
+	Queue( Callable, true );
 	return Callable;
 }
 
 CCallableBanRemove *CGHostDBSQLite :: ThreadedBanRemove( string server, string user )
 {
-	CCallableBanRemove *Callable = new CCallableBanRemove( server, user );
-	Callable->SetResult( BanRemove( server, user ) );
-	Callable->SetReady( true );
+	CCallableBanRemove *Callable = new CSQLiteCallableBanRemove( server, user, this );
+	Queue( Callable, true );
 	return Callable;
 }
 
 CCallableBanRemove *CGHostDBSQLite :: ThreadedBanRemove( string user )
 {
-	CCallableBanRemove *Callable = new CCallableBanRemove( string( ), user );
-	Callable->SetResult( BanRemove( user ) );
-	Callable->SetReady( true );
+	CCallableBanRemove *Callable = new CSQLiteCallableBanRemove( string( ), user, this );
+	Queue( Callable, true );
 	return Callable;
 }
 
 CCallableBanList *CGHostDBSQLite :: ThreadedBanList( string server )
 {
-	CCallableBanList *Callable = new CCallableBanList( server );
-	Callable->SetResult( BanList( server ) );
-	Callable->SetReady( true );
+	CCallableBanList *Callable = new CSQLiteCallableBanList( server, this );
+	Queue( Callable, false );
 	return Callable;
 }
 
 CCallableGameAdd *CGHostDBSQLite :: ThreadedGameAdd( string server, string map, string gamename, string ownername, uint32_t duration, uint32_t gamestate, string creatorname, string creatorserver )
 {
-	CCallableGameAdd *Callable = new CCallableGameAdd( server, map, gamename, ownername, duration, gamestate, creatorname, creatorserver );
-	Callable->SetResult( GameAdd( server, map, gamename, ownername, duration, gamestate, creatorname, creatorserver ) );
-	Callable->SetReady( true );
+	CCallableGameAdd *Callable = new CSQLiteCallableGameAdd( server, map, gamename, ownername, duration, gamestate, creatorname, creatorserver, this );
+	Queue( Callable, true );
 	return Callable;
 }
 
 CCallableGamePlayerAdd *CGHostDBSQLite :: ThreadedGamePlayerAdd( uint32_t gameid, string name, string ip, uint32_t spoofed, string spoofedrealm, uint32_t reserved, uint32_t loadingtime, uint32_t left, string leftreason, uint32_t team, uint32_t colour )
 {
-	CCallableGamePlayerAdd *Callable = new CCallableGamePlayerAdd( gameid, name, ip, spoofed, spoofedrealm, reserved, loadingtime, left, leftreason, team, colour );
-	Callable->SetResult( GamePlayerAdd( gameid, name, ip, spoofed, spoofedrealm, reserved, loadingtime, left, leftreason, team, colour ) );
-	Callable->SetReady( true );
+	CCallableGamePlayerAdd *Callable = new CSQLiteCallableGamePlayerAdd( gameid, name, ip, spoofed, spoofedrealm, reserved, loadingtime, left, leftreason, team, colour, this );
+	Queue( Callable, true );
 	return Callable;
 }
 
 CCallableGamePlayerSummaryCheck *CGHostDBSQLite :: ThreadedGamePlayerSummaryCheck( string name )
 {
-	CCallableGamePlayerSummaryCheck *Callable = new CCallableGamePlayerSummaryCheck( name );
-	Callable->SetResult( GamePlayerSummaryCheck( name ) );
-	Callable->SetReady( true );
+	CCallableGamePlayerSummaryCheck *Callable = new CSQLiteCallableGamePlayerSummaryCheck( name, this );
+	Queue( Callable, false );
 	return Callable;
 }
 
 CCallableDotAGameAdd *CGHostDBSQLite :: ThreadedDotAGameAdd( uint32_t gameid, uint32_t winner, uint32_t min, uint32_t sec )
 {
-	CCallableDotAGameAdd *Callable = new CCallableDotAGameAdd( gameid, winner, min, sec );
-	Callable->SetResult( DotAGameAdd( gameid, winner, min, sec ) );
-	Callable->SetReady( true );
+	CCallableDotAGameAdd *Callable = new CSQLiteCallableDotAGameAdd( gameid, winner, min, sec, this );
+	Queue( Callable, true );
 	return Callable;
 }
 
 CCallableDotAPlayerAdd *CGHostDBSQLite :: ThreadedDotAPlayerAdd( uint32_t gameid, uint32_t colour, uint32_t kills, uint32_t deaths, uint32_t creepkills, uint32_t creepdenies, uint32_t assists, uint32_t gold, uint32_t neutralkills, string item1, string item2, string item3, string item4, string item5, string item6, string hero, uint32_t newcolour, uint32_t towerkills, uint32_t raxkills, uint32_t courierkills )
 {
-	CCallableDotAPlayerAdd *Callable = new CCallableDotAPlayerAdd( gameid, colour, kills, deaths, creepkills, creepdenies, assists, gold, neutralkills, item1, item2, item3, item4, item5, item6, hero, newcolour, towerkills, raxkills, courierkills );
-	Callable->SetResult( DotAPlayerAdd( gameid, colour, kills, deaths, creepkills, creepdenies, assists, gold, neutralkills, item1, item2, item3, item4, item5, item6, hero, newcolour, towerkills, raxkills, courierkills ) );
-	Callable->SetReady( true );
+	CCallableDotAPlayerAdd *Callable = new CSQLiteCallableDotAPlayerAdd( gameid, colour, kills, deaths, creepkills, creepdenies, assists, gold, neutralkills, item1, item2, item3, item4, item5, item6, hero, newcolour, towerkills, raxkills, courierkills, this );
+	Queue( Callable, true );
 	return Callable;
 }
 
 CCallableDotAPlayerSummaryCheck *CGHostDBSQLite :: ThreadedDotAPlayerSummaryCheck( string name )
 {
-	CCallableDotAPlayerSummaryCheck *Callable = new CCallableDotAPlayerSummaryCheck( name );
-	Callable->SetResult( DotAPlayerSummaryCheck( name ) );
-	Callable->SetReady( true );
+	CCallableDotAPlayerSummaryCheck *Callable = new CSQLiteCallableDotAPlayerSummaryCheck( name, this );
+	Queue( Callable, false );
 	return Callable;
 }
 
 CCallableDownloadAdd *CGHostDBSQLite :: ThreadedDownloadAdd( string map, uint32_t mapsize, string name, string ip, uint32_t spoofed, string spoofedrealm, uint32_t downloadtime )
 {
-	CCallableDownloadAdd *Callable = new CCallableDownloadAdd( map, mapsize, name, ip, spoofed, spoofedrealm, downloadtime );
-	Callable->SetResult( DownloadAdd( map, mapsize, name, ip, spoofed, spoofedrealm, downloadtime ) );
-	Callable->SetReady( true );
+	CCallableDownloadAdd *Callable = new CSQLiteCallableDownloadAdd( map, mapsize, name, ip, spoofed, spoofedrealm, downloadtime, this );
+	Queue( Callable, true );
 	return Callable;
 }
 
 CCallableW3MMDPlayerAdd *CGHostDBSQLite :: ThreadedW3MMDPlayerAdd( string category, uint32_t gameid, uint32_t pid, string name, string flag, uint32_t leaver, uint32_t practicing )
 {
-	CCallableW3MMDPlayerAdd *Callable = new CCallableW3MMDPlayerAdd( category, gameid, pid, name, flag, leaver, practicing );
-	Callable->SetResult( W3MMDPlayerAdd( category, gameid, pid, name, flag, leaver, practicing ) );
-	Callable->SetReady( true );
+	CCallableW3MMDPlayerAdd *Callable = new CSQLiteCallableW3MMDPlayerAdd( category, gameid, pid, name, flag, leaver, practicing, this );
+	Queue( Callable, true );
 	return Callable;
 }
 
 CCallableW3MMDVarAdd *CGHostDBSQLite :: ThreadedW3MMDVarAdd( uint32_t gameid, map<VarP,int32_t> var_ints )
 {
-	CCallableW3MMDVarAdd *Callable = new CCallableW3MMDVarAdd( gameid, var_ints );
-	Callable->SetResult( W3MMDVarAdd( gameid, var_ints ) );
-	Callable->SetReady( true );
+	CCallableW3MMDVarAdd *Callable = new CSQLiteCallableW3MMDVarAdd( gameid, var_ints, this );
+	Queue( Callable, true );
 	return Callable;
 }
 
 CCallableW3MMDVarAdd *CGHostDBSQLite :: ThreadedW3MMDVarAdd( uint32_t gameid, map<VarP,double> var_reals )
 {
-	CCallableW3MMDVarAdd *Callable = new CCallableW3MMDVarAdd( gameid, var_reals );
-	Callable->SetResult( W3MMDVarAdd( gameid, var_reals ) );
-	Callable->SetReady( true );
+	CCallableW3MMDVarAdd *Callable = new CSQLiteCallableW3MMDVarAdd( gameid, var_reals, this );
+	Queue( Callable, true );
 	return Callable;
 }
 
 CCallableW3MMDVarAdd *CGHostDBSQLite :: ThreadedW3MMDVarAdd( uint32_t gameid, map<VarP,string> var_strings )
 {
-	CCallableW3MMDVarAdd *Callable = new CCallableW3MMDVarAdd( gameid, var_strings );
-	Callable->SetResult( W3MMDVarAdd( gameid, var_strings ) );
-	Callable->SetReady( true );
+	CCallableW3MMDVarAdd *Callable = new CSQLiteCallableW3MMDVarAdd( gameid, var_strings, this );
+	Queue( Callable, true );
 	return Callable;
 }
+
+//
+// SQLite Callables
+//
+
+void CSQLiteCallableAdminCount :: operator( )( )
+{
+	Init( );
+
+	m_Result = m_DB->AdminCount( m_Server );
+}
+
+void CSQLiteCallableAdminCheck :: operator( )( )
+{
+	Init( );
+
+	m_Result = m_DB->AdminCheck( m_Server, m_User );
+}
+
+void CSQLiteCallableAdminAdd :: operator( )( )
+{
+	Init( );
+
+	m_Result = m_DB->AdminAdd( m_Server, m_User );
+}
+
+void CSQLiteCallableAdminRemove :: operator( )( )
+{
+	Init( );
+
+	m_Result = m_DB->AdminRemove( m_Server, m_User );
+}
+
+void CSQLiteCallableAdminList :: operator( )( )
+{
+	Init( );
+
+	m_Result = m_DB->AdminList( m_Server );
+}
+
+void CSQLiteCallableBanCount :: operator( )( )
+{
+	Init( );
+
+	m_Result = m_DB->BanCount( m_Server );
+}
+
+void CSQLiteCallableBanCheck :: operator( )( )
+{
+	Init( );
+
+	m_Result = m_DB->BanCheck( m_Server, m_User, m_IP );
+}
+
+void CSQLiteCallableBanAdd :: operator( )( )
+{
+	Init( );
+
+	m_Result = m_DB->BanAdd( m_Server, m_User, m_IP, m_GameName, m_Admin, m_Reason );
+}
+
+void CSQLiteCallableBanRemove :: operator( )( )
+{
+	Init( );
+
+	if( m_Server.empty( ) )
+		m_Result = m_DB->BanRemove( m_User );
+	else
+		m_Result = m_DB->BanRemove( m_Server, m_User );
+}
+
+void CSQLiteCallableBanList :: operator( )( )
+{
+	Init( );
+
+	m_Result = m_DB->BanList( m_Server );
+}
+
+void CSQLiteCallableGameAdd :: operator( )( )
+{
+	Init( );
+
+	m_Result = m_DB->GameAdd( m_Server, m_Map, m_GameName, m_OwnerName, m_Duration, m_GameState, m_CreatorName, m_CreatorServer );
+}
+
+void CSQLiteCallableGamePlayerAdd :: operator( )( )
+{
+	Init( );
+
+	m_Result = m_DB->GamePlayerAdd( m_GameID, m_Name, m_IP, m_Spoofed, m_SpoofedRealm, m_Reserved, m_LoadingTime, m_Left, m_LeftReason, m_Team, m_Colour );
+}
+
+void CSQLiteCallableGamePlayerSummaryCheck :: operator( )( )
+{
+	Init( );
+
+	m_Result = m_DB->GamePlayerSummaryCheck( m_Name );
+}
+
+void CSQLiteCallableDotAGameAdd :: operator( )( )
+{
+	Init( );
+
+	m_Result = m_DB->DotAGameAdd( m_GameID, m_Winner, m_Min, m_Sec );
+}
+
+void CSQLiteCallableDotAPlayerAdd :: operator( )( )
+{
+	Init( );
+
+	m_Result = m_DB->DotAPlayerAdd( m_GameID, m_Colour, m_Kills, m_Deaths, m_CreepKills, m_CreepDenies, m_Assists, m_Gold, m_NeutralKills, m_Item1, m_Item2, m_Item3, m_Item4, m_Item5, m_Item6, m_Hero, m_NewColour, m_TowerKills, m_RaxKills, m_CourierKills );
+}
+
+void CSQLiteCallableDotAPlayerSummaryCheck :: operator( )( )
+{
+	Init( );
+
+	m_Result = m_DB->DotAPlayerSummaryCheck( m_Name );
+}
+
+void CSQLiteCallableDownloadAdd :: operator( )( )
+{
+	Init( );
+
+	m_Result = m_DB->DownloadAdd( m_Map, m_MapSize, m_Name, m_IP, m_Spoofed, m_SpoofedRealm, m_DownloadTime );
+}
+
+void CSQLiteCallableW3MMDPlayerAdd :: operator( )( )
+{
+	Init( );
+
+	m_Result = m_DB->W3MMDPlayerAdd( m_Category, m_GameID, m_PID, m_Name, m_Flag, m_Leaver, m_Practicing );
+}
+
+void CSQLiteCallableW3MMDVarAdd :: operator( )( )
+{
+	Init( );
+
+	if( m_ValueType == VALUETYPE_INT )
+		m_Result = m_DB->W3MMDVarAdd( m_GameID, m_VarInts );
+	else if( m_ValueType == VALUETYPE_REAL )
+		m_Result = m_DB->W3MMDVarAdd( m_GameID, m_VarReals );
+	else
+		m_Result = m_DB->W3MMDVarAdd( m_GameID, m_VarStrings );
+}
@@ -140,13 +140,6 @@ CREATE TABLE w3mmdvars (
 	value_string TEXT DEFAULT NULL
 )
 
-CREATE TEMPORARY TABLE iptocountry (
-	ip1 INTEGER NOT NULL,
-	ip2 INTEGER NOT NULL,
-	country TEXT NOT NULL,
-	PRIMARY KEY ( ip1, ip2 )
-)
-
 CREATE INDEX idx_gameid ON gameplayers ( gameid )
 CREATE INDEX idx_gameid_colour ON dotaplayers ( gameid, colour )
 
@@ -164,9 +157,10 @@ private:
 	void *m_DB;
 	bool m_Ready;
 	vector<string> m_Row;
+	map<string, void *> m_Statements;	// prepared statements kept for the lifetime of the connection, keyed by query text
 
 public:
-	CSQLITE3( string filename );
+	CSQLITE3( string filename, bool readOnly = false );
 	~CSQLITE3( );
 
 	bool GetReady( )			{ return m_Ready; }
@@ -174,6 +168,12 @@ public:
 	string GetError( );
 
 	int Prepare( string query, void **Statement );
+
+	// PrepareCached returns a statement owned by the connection which is prepared the first time the query is seen
+	// callers must pass it to Release instead of Finalize when they're done with it
+
+	int PrepareCached( string query, void **Statement );
+	int Release( void *Statement );
 	int Step( void *Statement );
 	int Finalize( void *Statement );
 	int Reset( void *Statement );
@@ -190,13 +190,35 @@ class CGHostDBSQLite : public CGHostDB
 {
 private:
 	string m_File;
-	CSQLITE3 *m_DB;
-
-	// we keep some prepared statements in memory rather than recreating them each function call
-	// this is an optimization because preparing statements takes time
-	// however it only pays off if you're going to be using the statement extremely often
-
-	void *FromAddStmt;
+	CSQLITE3 *m_DB;								// the writer connection, only used by the writer thread once the threads are started
+	vector<CSQLITE3 *> m_ReadDBs;				// read only connections, one per reader thread
+	uint32_t m_NumReaders;						// config value: how many reader threads to start (0 means reads are queued to the writer as well)
+	boost::thread_specific_ptr<CSQLITE3> m_ThreadDB;	// the connection owned by the current database thread (NULL outside of the database threads)
+
+	// game threads never run queries themselves, they queue callables here and the database threads pick them up
+	// writes are run in order by a single writer thread which commits everything it finds queued in one transaction
+	// reads are spread over the reader threads, each with its own connection and its own statement cache
+
+	boost::mutex m_QueueMutex;
+	boost::condition_variable m_WriteCond;
+	boost::condition_variable m_ReadCond;
+	queue<pair<CBaseCallable *, bool> > m_Writes;	// the bool is false for reads queued to the writer because there are no reader connections
+	queue<CBaseCallable *> m_Reads;
+	boost::thread_group m_Threads;
+	bool m_ThreadsStarted;
+	bool m_Exiting;
+
+	// the iptocountry table only lives as long as the bot so it's kept in memory rather than in a temporary table
+	// temporary tables are private to the connection which created them and so wouldn't be visible to the reader connections
+
+	boost::mutex m_FromMutex;
+	map<uint32_t, pair<uint32_t, string> > m_From;	// ip1 -> ( ip2, country )
+
+	CSQLITE3 *GetDB( );
+	void StartThreads( );
+	void Queue( CBaseCallable *callable, bool write );
+	void WriterThread( );
+	void ReaderThread( CSQLITE3 *DB );
 
 public:
 	CGHostDBSQLite( CConfig *CFG );
@@ -210,6 +232,8 @@ public:
 	virtual void Upgrade6_7( );
 	virtual void Upgrade7_8( );
 
+	// transactions are managed by the writer thread so Begin and Commit don't do anything (they're kept for callers written against the other backends)
+
 	virtual bool Begin( );
 	virtual bool Commit( );
 	virtual uint32_t AdminCount( string server );
@@ -240,8 +264,7 @@ public:
 	virtual bool W3MMDVarAdd( uint32_t gameid, map<VarP,string> var_strings );
 
 	// threaded database functions
-	// note: these are not actually implemented with threads at the moment, they WILL block until the query is complete
-	// todotodo: implement threads here
+	// these only queue the callable and return immediately, the query is run by one of the database threads
 
 	virtual CCallableAdminCount *ThreadedAdminCount( string server );
 	virtual CCallableAdminCheck *ThreadedAdminCheck( string server, string user );
@@ -267,4 +290,194 @@ public:
 	virtual CCallableW3MMDVarAdd *ThreadedW3MMDVarAdd( uint32_t gameid, map<VarP,string> var_strings );
 };
 
+//
+// SQLite Callables
+//
+
+// these run the synchronous CGHostDBSQLite functions on a database thread using that thread's connection
+// unlike the MySQL callables operator() doesn't call Close, the database thread does that once the transaction the query ran in has been committed
+
+class CSQLiteCallable : virtual public CBaseCallable
+{
+protected:
+	CGHostDBSQLite *m_DB;
+
+public:
+	CSQLiteCallable( CGHostDBSQLite *nDB ) : CBaseCallable( ), m_DB( nDB ) { }
+	virtual ~CSQLiteCallable( ) { }
+};
+
+class CSQLiteCallableAdminCount : public CCallableAdminCount, public CSQLiteCallable
+{
+public:
+	CSQLiteCallableAdminCount( string nServer, CGHostDBSQLite *nDB ) : CBaseCallable( ), CCallableAdminCount( nServer ), CSQLiteCallable( nDB ) { }
+	virtual ~CSQLiteCallableAdminCount( ) { }
+
+	virtual void operator( )( );
+};
+
+class CSQLiteCallableAdminCheck : public CCallableAdminCheck, public CSQLiteCallable
+{
+public:
+	CSQLiteCallableAdminCheck( string nServer, string nUser, CGHostDBSQLite *nDB ) : CBaseCallable( ), CCallableAdminCheck( nServer, nUser ), CSQLiteCallable( nDB ) { }
+	virtual ~CSQLiteCallableAdminCheck( ) { }
+
+	virtual void operator( )( );
+};
+
+class CSQLiteCallableAdminAdd : public CCallableAdminAdd, public CSQLiteCallable
+{
+public:
+	CSQLiteCallableAdminAdd( string nServer, string nUser, CGHostDBSQLite *nDB ) : CBaseCallable( ), CCallableAdminAdd( nServer, nUser ), CSQLiteCallable( nDB ) { }
+	virtual ~CSQLiteCallableAdminAdd( ) { }
+
+	virtual void operator( )( );
+};
+
+class CSQLiteCallableAdminRemove : public CCallableAdminRemove, public CSQLiteCallable
+{
+public:
+	CSQLiteCallableAdminRemove( string nServer, string nUser, CGHostDBSQLite *nDB ) : CBaseCallable( ), CCallableAdminRemove( nServer, nUser ), CSQLiteCallable( nDB ) { }
+	virtual ~CSQLiteCallableAdminRemove( ) { }
+
+	virtual void operator( )( );
+};
+
+class CSQLiteCallableAdminList : public CCallableAdminList, public CSQLiteCallable
+{
+public:
+	CSQLiteCallableAdminList( string nServer, CGHostDBSQLite *nDB ) : CBaseCallable( ), CCallableAdminList( nServer ), CSQLiteCallable( nDB ) { }
+	virtual ~CSQLiteCallableAdminList( ) { }
+
+	virtual void operator( )( );
+};
+
+class CSQLiteCallableBanCount : public CCallableBanCount, public CSQLiteCallable
+{
+public:
+	CSQLiteCallableBanCount( string nServer, CGHostDBSQLite *nDB ) : CBaseCallable( ), CCallableBanCount( nServer ), CSQLiteCallable( nDB ) { }
+	virtual ~CSQLiteCallableBanCount( ) { }
+
+	virtual void operator( )( );
+};
+
+class CSQLiteCallableBanCheck : public CCallableBanCheck, public CSQLiteCallable
+{
+public:
+	CSQLiteCallableBanCheck( string nServer, string nUser, string nIP, CGHostDBSQLite *nDB ) : CBaseCallable( ), CCallableBanCheck( nServer, nUser, nIP ), CSQLiteCallable( nDB ) { }
+	virtual ~CSQLiteCallableBanCheck( ) { }
+
+	virtual void operator( )( );
+};
+
+class CSQLiteCallableBanAdd : public CCallableBanAdd, public CSQLiteCallable
+{
+public:
+	CSQLiteCallableBanAdd( string nServer, string nUser, string nIP, string nGameName, string nAdmin, string nReason, CGHostDBSQLite *nDB ) : CBaseCallable( ), CCallableBanAdd( nServer, nUser, nIP, nGameName, nAdmin, nReason ), CSQLiteCallable( nDB ) { }
+	virtual ~CSQLiteCallableBanAdd( ) { }
+
+	virtual void operator( )( );
+};
+
+class CSQLiteCallableBanRemove : public CCallableBanRemove, public CSQLiteCallable
+{
+public:
+	CSQLiteCallableBanRemove( string nServer, string nUser, CGHostDBSQLite *nDB ) : CBaseCallable( ), CCallableBanRemove( nServer, nUser ), CSQLiteCallable( nDB ) { }
+	virtual ~CSQLiteCallableBanRemove( ) { }
+
+	virtual void operator( )( );
+};
+
+class CSQLiteCallableBanList : public CCallableBanList, public CSQLiteCallable
+{
+public:
+	CSQLiteCallableBanList( string nServer, CGHostDBSQLite *nDB ) : CBaseCallable( ), CCallableBanList( nServer ), CSQLiteCallable( nDB ) { }
+	virtual ~CSQLiteCallableBanList( ) { }
+
+	virtual void operator( )( );
+};
+
+class CSQLiteCallableGameAdd : public CCallableGameAdd, public CSQLiteCallable
+{
+public:
+	CSQLiteCallableGameAdd( string nServer, string nMap, string nGameName, string nOwnerName, uint32_t nDuration, uint32_t nGameState, string nCreatorName, string nCreatorServer, CGHostDBSQLite *nDB ) : CBaseCallable( ), CCallableGameAdd( nServer, nMap, nGameName, nOwnerName, nDuration, nGameState, nCreatorName, nCreatorServer ), CSQLiteCallable( nDB ) { }
+	virtual ~CSQLiteCallableGameAdd( ) { }
+
+	virtual void operator( )( );
+};
+
+class CSQLiteCallableGamePlayerAdd : public CCallableGamePlayerAdd, public CSQLiteCallable
+{
+public:
+	CSQLiteCallableGamePlayerAdd( uint32_t nGameID, string nName, string nIP, uint32_t nSpoofed, string nSpoofedRealm, uint32_t nReserved, uint32_t nLoadingTime, uint32_t nLeft, string nLeftReason, uint32_t nTeam, uint32_t nColour, CGHostDBSQLite *nDB ) : CBaseCallable( ), CCallableGamePlayerAdd( nGameID, nName, nIP, nSpoofed, nSpoofedRealm, nReserved, nLoadingTime, nLeft, nLeftReason, nTeam, nColour ), CSQLiteCallable( nDB ) { }
+	virtual ~CSQLiteCallableGamePlayerAdd( ) { }
+
+	virtual void operator( )( );
+};
+
+class CSQLiteCallableGamePlayerSummaryCheck : public CCallableGamePlayerSummaryCheck, public CSQLiteCallable
+{
+public:
+	CSQLiteCallableGamePlayerSummaryCheck( string nName, CGHostDBSQLite *nDB ) : CBaseCallable( ), CCallableGamePlayerSummaryCheck( nName ), CSQLiteCallable( nDB ) { }
+	virtual ~CSQLiteCallableGamePlayerSummaryCheck( ) { }
+
+	virtual void operator( )( );
+};
+
+class CSQLiteCallableDotAGameAdd : public CCallableDotAGameAdd, public CSQLiteCallable
+{
+public:
+	CSQLiteCallableDotAGameAdd( uint32_t nGameID, uint32_t nWinner, uint32_t nMin, uint32_t nSec, CGHostDBSQLite *nDB ) : CBaseCallable( ), CCallableDotAGameAdd( nGameID, nWinner, nMin, nSec ), CSQLiteCallable( nDB ) { }
+	virtual ~CSQLiteCallableDotAGameAdd( ) { }
+
+	virtual void operator( )( );
+};
+
+class CSQLiteCallableDotAPlayerAdd : public CCallableDotAPlayerAdd, public CSQLiteCallable
+{
+public:
+	CSQLiteCallableDotAPlayerAdd( uint32_t nGameID, uint32_t nColour, uint32_t nKills, uint32_t nDeaths, uint32_t nCreepKills, uint32_t nCreepDenies, uint32_t nAssists, uint32_t nGold, uint32_t nNeutralKills, string nItem1, string nItem2, string nItem3, string nItem4, string nItem5, string nItem6, string nHero, uint32_t nNewColour, uint32_t nTowerKills, uint32_t nRaxKills, uint32_t nCourierKills, CGHostDBSQLite *nDB ) : CBaseCallable( ), CCallableDotAPlayerAdd( nGameID, nColour, nKills, nDeaths, nCreepKills, nCreepDenies, nAssists, nGold, nNeutralKills, nItem1, nItem2, nItem3, nItem4, nItem5, nItem6, nHero, nNewColour, nTowerKills, nRaxKills, nCourierKills ), CSQLiteCallable( nDB ) { }
+	virtual ~CSQLiteCallableDotAPlayerAdd( ) { }
+
+	virtual void operator( )( );
+};
+
+class CSQLiteCallableDotAPlayerSummaryCheck : public CCallableDotAPlayerSummaryCheck, public CSQLiteCallable
+{
+public:
+	CSQLiteCallableDotAPlayerSummaryCheck( string nName, CGHostDBSQLite *nDB ) : CBaseCallable( ), CCallableDotAPlayerSummaryCheck( nName ), CSQLiteCallable( nDB ) { }
+	virtual ~CSQLiteCallableDotAPlayerSummaryCheck( ) { }
+
+	virtual void operator( )( );
+};
+
+class CSQLiteCallableDownloadAdd : public CCallableDownloadAdd, public CSQLiteCallable
+{
+public:
+	CSQLiteCallableDownloadAdd( string nMap, uint32_t nMapSize, string nName, string nIP, uint32_t nSpoofed, string nSpoofedRealm, uint32_t nDownloadTime, CGHostDBSQLite *nDB ) : CBaseCallable( ), CCallableDownloadAdd( nMap, nMapSize, nName, nIP, nSpoofed, nSpoofedRealm, nDownloadTime ), CSQLiteCallable( nDB ) { }
+	virtual ~CSQLiteCallableDownloadAdd( ) { }
+
+	virtual void operator( )( );
+};
+
+class CSQLiteCallableW3MMDPlayerAdd : public CCallableW3MMDPlayerAdd, public CSQLiteCallable
+{
+public:
+	CSQLiteCallableW3MMDPlayerAdd( string nCategory, uint32_t nGameID, uint32_t nPID, string nName, string nFlag, uint32_t nLeaver, uint32_t nPracticing, CGHostDBSQLite *nDB ) : CBaseCallable( ), CCallableW3MMDPlayerAdd( nCategory, nGameID, nPID, nName, nFlag, nLeaver, nPracticing ), CSQLiteCallable( nDB ) { }
+	virtual ~CSQLiteCallableW3MMDPlayerAdd( ) { }
+
+	virtual void operator( )( );
+};
+
+class CSQLiteCallableW3MMDVarAdd : public CCallableW3MMDVarAdd, public CSQLiteCallable
+{
+public:
+	CSQLiteCallableW3MMDVarAdd( uint32_t nGameID, map<VarP,int32_t> nVarInts, CGHostDBSQLite *nDB ) : CBaseCallable( ), CCallableW3MMDVarAdd( nGameID, nVarInts ), CSQLiteCallable( nDB ) { }
+	CSQLiteCallableW3MMDVarAdd( uint32_t nGameID, map<VarP,double> nVarReals, CGHostDBSQLite *nDB ) : CBaseCallable( ), CCallableW3MMDVarAdd( nGameID, nVarReals ), CSQLiteCallable( nDB ) { }
+	CSQLiteCallableW3MMDVarAdd( uint32_t nGameID, map<VarP,string> nVarStrings, CGHostDBSQLite *nDB ) : CBaseCallable( ), CCallableW3MMDVarAdd( nGameID, nVarStrings ), CSQLiteCallable( nDB ) { }
+	virtual ~CSQLiteCallableW3MMDVarAdd( ) { }
+
+	virtual void operator( )( );
+};
+
 #endif
@@ -44,6 +44,7 @@
 #include <string>
 #include <vector>
 #include <boost/thread.hpp>
+#include <boost/atomic.hpp>
 
 using namespace std;
 
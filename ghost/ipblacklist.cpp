@@ -0,0 +1,230 @@
+/*
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*/
+
+#include "ghost.h"
+#include "util.h"
+#include "ipblacklist.h"
+
+#include <boost/filesystem.hpp>
+
+//
+// CIPRanges
+//
+
+CIPRanges :: CIPRanges( vector< pair<uint32_t, uint32_t> > nRanges, uint32_t nLines ) : m_Lines( nLines )
+{
+	// merge overlapping and adjacent ranges so each address is covered by at most one range
+
+	sort( nRanges.begin( ), nRanges.end( ) );
+
+	for( vector< pair<uint32_t, uint32_t> > :: iterator i = nRanges.begin( ); i != nRanges.end( ); ++i )
+	{
+		if( !m_Ranges.empty( ) && ( m_Ranges.back( ).second == 0xFFFFFFFF || i->first <= m_Ranges.back( ).second + 1 ) )
+		{
+			if( i->second > m_Ranges.back( ).second )
+				m_Ranges.back( ).second = i->second;
+		}
+		else
+			m_Ranges.push_back( *i );
+	}
+}
+
+CIPRanges :: ~CIPRanges( )
+{
+
+}
+
+bool CIPRanges :: Contains( uint32_t ip ) const
+{
+	// find the last range starting at or before ip
+
+	vector< pair<uint32_t, uint32_t> > :: const_iterator i = upper_bound( m_Ranges.begin( ), m_Ranges.end( ), make_pair( ip, (uint32_t)0xFFFFFFFF ) );
+
+	if( i == m_Ranges.begin( ) )
+		return false;
+
+	--i;
+	return ip <= i->second;
+}
+
+//
+// CIPBlackList
+//
+
+CIPBlackList :: CIPBlackList( ) : m_Ranges( new CIPRanges( vector< pair<uint32_t, uint32_t> >( ), 0 ) ), m_FileTime( 0 ), m_LastCheckTime( 0 )
+{
+
+}
+
+CIPBlackList :: ~CIPBlackList( )
+{
+
+}
+
+void CIPBlackList :: SetFile( string file )
+{
+	if( file == m_File )
+		return;
+
+	m_File = file;
+	Load( );
+}
+
+void CIPBlackList :: Update( )
+{
+	if( m_File.empty( ) || GetTime( ) - m_LastCheckTime < IPBLACKLIST_CHECK_INTERVAL )
+		return;
+
+	m_LastCheckTime = GetTime( );
+	boost::system::error_code Error;
+	time_t FileTime = boost::filesystem::last_write_time( boost::filesystem::path( m_File ), Error );
+
+	if( Error )
+		FileTime = 0;
+
+	if( FileTime != m_FileTime )
+	{
+		CONSOLE_Print( "[GHOST] IP blacklist file [" + m_File + "] changed, reloading" );
+		Load( );
+	}
+}
+
+void CIPBlackList :: Load( )
+{
+	m_LastCheckTime = GetTime( );
+	vector< pair<uint32_t, uint32_t> > Ranges;
+	uint32_t Lines = 0;
+
+	if( !m_File.empty( ) )
+	{
+		boost::system::error_code Error;
+		m_FileTime = boost::filesystem::last_write_time( boost::filesystem::path( m_File ), Error );
+
+		if( Error )
+			m_FileTime = 0;
+
+		ifstream in;
+		in.open( m_File.c_str( ) );
+
+		if( in.fail( ) )
+			CONSOLE_Print( "[GHOST] error loading IP blacklist file [" + m_File + "]" );
+		else
+		{
+			string Line;
+
+			while( !in.eof( ) )
+			{
+				getline( in, Line );
+
+				// ignore blank lines and comments
+
+				if( Line.empty( ) || Line[0] == '#' )
+					continue;
+
+				// remove newlines and partial newlines to help fix issues with Windows formatted files on Linux systems
+
+				Line.erase( remove( Line.begin( ), Line.end( ), ' ' ), Line.end( ) );
+				Line.erase( remove( Line.begin( ), Line.end( ), '\r' ), Line.end( ) );
+				Line.erase( remove( Line.begin( ), Line.end( ), '\n' ), Line.end( ) );
+
+				// ignore lines that don't look like IP addresses or ranges
+
+				uint32_t First;
+				uint32_t Last;
+
+				if( !UTIL_ParseIPRange( Line, First, Last ) )
+					continue;
+
+				Ranges.push_back( make_pair( First, Last ) );
+				++Lines;
+			}
+
+			in.close( );
+		}
+	}
+
+	boost::shared_ptr<const CIPRanges> NewRanges( new CIPRanges( Ranges, Lines ) );
+	boost::atomic_store( &m_Ranges, NewRanges );
+
+	if( !m_File.empty( ) )
+		CONSOLE_Print( "[GHOST] loaded " + UTIL_ToString( NewRanges->GetNumLines( ) ) + " lines (" + UTIL_ToString( NewRanges->GetNumRanges( ) ) + " ranges) from IP blacklist file" );
+}
+
+bool CIPBlackList :: IsBlackListed( uint32_t ip )
+{
+	boost::shared_ptr<const CIPRanges> Ranges = boost::atomic_load( &m_Ranges );
+	return Ranges->Contains( ip );
+}
+
+bool UTIL_ParseIPRange( string line, uint32_t &first, uint32_t &last )
+{
+	// parses "a.b.c.d" or "a.b.c.d/n"
+
+	if( line.empty( ) || line.find_first_not_of( "1234567890./" ) != string :: npos )
+		return false;
+
+	uint32_t Prefix = 32;
+	string :: size_type Slash = line.find( '/' );
+
+	if( Slash != string :: npos )
+	{
+		string PrefixString = line.substr( Slash + 1 );
+
+		if( PrefixString.empty( ) || PrefixString.size( ) > 2 || PrefixString.find( '/' ) != string :: npos )
+			return false;
+
+		Prefix = UTIL_ToUInt32( PrefixString );
+
+		if( Prefix > 32 )
+			return false;
+
+		line = line.substr( 0, Slash );
+	}
+
+	uint32_t IP = 0;
+	uint32_t Octets = 0;
+	string :: size_type Start = 0;
+
+	while( Start <= line.size( ) )
+	{
+		string :: size_type Dot = line.find( '.', Start );
+
+		if( Dot == string :: npos )
+			Dot = line.size( );
+
+		string Octet = line.substr( Start, Dot - Start );
+
+		if( Octet.empty( ) || Octet.size( ) > 3 || Octets == 4 )
+			return false;
+
+		uint32_t Value = UTIL_ToUInt32( Octet );
+
+		if( Value > 255 )
+			return false;
+
+		IP = ( IP << 8 ) | Value;
+		++Octets;
+		Start = Dot + 1;
+	}
+
+	if( Octets != 4 )
+		return false;
+
+	uint32_t Mask = Prefix == 0 ? 0 : 0xFFFFFFFF << ( 32 - Prefix );
+	first = IP & Mask;
+	last = first | ~Mask;
+	return true;
+}
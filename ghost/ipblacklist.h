@@ -0,0 +1,80 @@
+/*
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*/
+
+#ifndef IPBLACKLIST_H
+#define IPBLACKLIST_H
+
+#include <boost/shared_ptr.hpp>
+
+//
+// CIPRanges
+//
+
+// an immutable set of IP address ranges, merged and sorted so a lookup is a binary search
+// addresses are uint32's in host byte order so 1.2.3.4 is 0x01020304
+
+class CIPRanges
+{
+private:
+	vector< pair<uint32_t, uint32_t> > m_Ranges;	// first and last address of each range, sorted and not overlapping
+	uint32_t m_Lines;								// number of lines the ranges were built from
+
+public:
+	CIPRanges( vector< pair<uint32_t, uint32_t> > nRanges, uint32_t nLines );
+	~CIPRanges( );
+
+	uint32_t GetNumRanges( ) const	{ return m_Ranges.size( ); }
+	uint32_t GetNumLines( ) const	{ return m_Lines; }
+	bool Contains( uint32_t ip ) const;
+};
+
+//
+// CIPBlackList
+//
+
+// the bot's IP blacklist, shared by every game
+// the file is parsed once and the games only ever see a complete CIPRanges, when the file changes a new one is built and swapped in atomically
+// each line is either a single address (1.2.3.4) or a CIDR range (1.2.3.0/24), blank lines and lines starting with # are ignored
+
+#define IPBLACKLIST_CHECK_INTERVAL		5	// seconds between checks for a changed file
+
+class CIPBlackList
+{
+private:
+	boost::shared_ptr<const CIPRanges> m_Ranges;	// only accessed through boost::atomic_load and boost::atomic_store
+	string m_File;									// only touched by the main thread
+	time_t m_FileTime;								// last write time of m_File when it was loaded (0 if it didn't exist)
+	uint32_t m_LastCheckTime;						// GetTime when we last checked if m_File changed
+
+	void Load( );
+
+public:
+	CIPBlackList( );
+	~CIPBlackList( );
+
+	// called by the main thread
+
+	void SetFile( string file );
+	void Update( );
+
+	// called by the games, from any thread
+
+	bool IsBlackListed( uint32_t ip );
+};
+
+bool UTIL_ParseIPRange( string line, uint32_t &first, uint32_t &last );
+
+#endif
@@ -0,0 +1,82 @@
+/*
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*/
+
+
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+#include <boost/lockfree/queue.hpp>
+
+//
+// CMailbox
+//
+
+// a bounded lock free message queue used to hand work to the thread which owns an object (a game or a battle.net connection)
+// any number of threads may call Post but only the owner may call Receive
+// the mailbox owns every message posted to it and signals the owner's wake socket so messages are handled on the next loop instead of after the select timeout
+// note: this header uses CWakeSocket so socket.h must be included before it
+
+#define MAILBOX_SIZE					256
+
+template <class T>
+class CMailbox
+{
+private:
+	boost::lockfree::queue<T *> m_Messages;
+	CWakeSocket *m_WakeSocket;					// the owner's wake socket (may be NULL, not owned by the mailbox)
+
+public:
+	CMailbox( CWakeSocket *nWakeSocket, uint32_t nSize = MAILBOX_SIZE ) : m_Messages( nSize ), m_WakeSocket( nWakeSocket ) { }
+
+	~CMailbox( )
+	{
+		T *Message;
+
+		while( m_Messages.pop( Message ) )
+			delete Message;
+	}
+
+	// returns false and deletes the message if the mailbox is full
+	// the mailbox never grows past its initial size so a stalled owner can't make producers allocate without bound
+
+	bool Post( T *message )
+	{
+		if( !m_Messages.bounded_push( message ) )
+		{
+			delete message;
+			return false;
+		}
+
+		if( m_WakeSocket )
+			m_WakeSocket->Wake( );
+
+		return true;
+	}
+
+	// returns NULL when the mailbox is empty, the caller is responsible for deleting the message
+
+	T *Receive( )
+	{
+		T *Message = NULL;
+
+		if( m_Messages.pop( Message ) )
+			return Message;
+
+		return NULL;
+	}
+};
+
+#endif
@@ -28,6 +28,10 @@
 #define __STORMLIB_SELF__
 #include <StormLib.h>
 
+#include <boost/filesystem.hpp>
+
+using namespace boost :: filesystem;
+
 #define ROTL(x,n) ((x)<<(n))|((x)>>(32-(n)))	// this won't work with signed types
 #define ROTR(x,n) ((x)>>(n))|((x)<<(32-(n)))	// this won't work with signed types
 
@@ -35,7 +39,7 @@
 // CMap
 //
 
-CMap :: CMap( CGHost *nGHost ) : m_GHost( nGHost ), m_Valid( true ), m_MapPath( "Maps\\FrozenThrone\\(12)EmeraldGardens.w3x" ), m_MapSize( UTIL_ExtractNumbers( "174 221 4 0", 4 ) ), m_MapInfo( UTIL_ExtractNumbers( "251 57 68 98", 4 ) ), m_MapCRC( UTIL_ExtractNumbers( "108 250 204 59", 4 ) ), m_MapSHA1( UTIL_ExtractNumbers( "35 81 104 182 223 63 204 215 1 17 87 234 220 66 3 185 82 99 6 13", 20 ) ), m_MapSpeed( MAPSPEED_FAST ), m_MapVisibility( MAPVIS_DEFAULT ), m_MapObservers( MAPOBS_NONE ), m_MapFlags( MAPFLAG_TEAMSTOGETHER | MAPFLAG_FIXEDTEAMS ), m_MapFilterMaker( MAPFILTER_MAKER_BLIZZARD ), m_MapFilterType( MAPFILTER_TYPE_MELEE ), m_MapFilterSize( MAPFILTER_SIZE_LARGE ), m_MapFilterObs( MAPFILTER_OBS_NONE ), m_MapOptions( MAPOPT_MELEE ), m_MapWidth( UTIL_ExtractNumbers( "172 0", 2 ) ), m_MapHeight( UTIL_ExtractNumbers( "172 0", 2 ) ), m_MapLoadInGame( false ), m_MapNumPlayers( 12 ), m_MapNumTeams( 12 )
+CMap :: CMap( CGHost *nGHost ) : m_GHost( nGHost ), m_Valid( true ), m_MapPath( "Maps\\FrozenThrone\\(12)EmeraldGardens.w3x" ), m_MapSize( UTIL_ExtractNumbers( "174 221 4 0", 4 ) ), m_MapInfo( UTIL_ExtractNumbers( "251 57 68 98", 4 ) ), m_MapCRC( UTIL_ExtractNumbers( "108 250 204 59", 4 ) ), m_MapSHA1( UTIL_ExtractNumbers( "35 81 104 182 223 63 204 215 1 17 87 234 220 66 3 185 82 99 6 13", 20 ) ), m_MapSpeed( MAPSPEED_FAST ), m_MapVisibility( MAPVIS_DEFAULT ), m_MapObservers( MAPOBS_NONE ), m_MapFlags( MAPFLAG_TEAMSTOGETHER | MAPFLAG_FIXEDTEAMS ), m_MapFilterMaker( MAPFILTER_MAKER_BLIZZARD ), m_MapFilterType( MAPFILTER_TYPE_MELEE ), m_MapFilterSize( MAPFILTER_SIZE_LARGE ), m_MapFilterObs( MAPFILTER_OBS_NONE ), m_MapOptions( MAPOPT_MELEE ), m_MapWidth( UTIL_ExtractNumbers( "172 0", 2 ) ), m_MapHeight( UTIL_ExtractNumbers( "172 0", 2 ) ), m_MapLoadInGame( false ), m_MapNumPlayers( 12 ), m_MapNumTeams( 12 ), m_StatStringCache( new CMapStatStringCache( ) )
 {
 	CONSOLE_Print( "[MAP] using hardcoded Emerald Gardens map data for Warcraft 3 version 1.24 & 1.24b" );
 	m_Slots.push_back( CGameSlot( 0, 255, SLOTSTATUS_OPEN, 0, 0, 0, SLOTRACE_RANDOM | SLOTRACE_SELECTABLE ) );
@@ -136,6 +140,62 @@ BYTEARRAY CMap :: GetMapGameFlags( )
 	return UTIL_CreateByteArray( GameFlags, false );
 }
 
+BYTEARRAY CMap :: GetEncodedStatString( const BYTEARRAY &mapWidth, const BYTEARRAY &mapHeight, const string &mapPath, const BYTEARRAY &mapCRC, const string &hostName, bool withSHA1 )
+{
+	// the stat string only depends on the map and on who is hosting it so it only needs to be encoded once per variant
+	// the map game flags and the map sha1 aren't part of the key because they can only change when the map is reloaded (which replaces the cache)
+
+	string Key;
+	Key.reserve( mapWidth.size( ) + mapHeight.size( ) + mapCRC.size( ) + mapPath.size( ) + hostName.size( ) + 3 );
+	Key.append( mapWidth.begin( ), mapWidth.end( ) );
+	Key.append( mapHeight.begin( ), mapHeight.end( ) );
+	Key.append( mapCRC.begin( ), mapCRC.end( ) );
+	Key += mapPath;
+	Key.push_back( 0 );
+	Key += hostName;
+	Key.push_back( 0 );
+	Key.push_back( withSHA1 ? 1 : 0 );
+
+	boost::mutex::scoped_lock lock( m_StatStringCache->m_Mutex );
+	map<string, BYTEARRAY> :: iterator i = m_StatStringCache->m_StatStrings.find( Key );
+
+	if( i != m_StatStringCache->m_StatStrings.end( ) )
+		return i->second;
+
+	BYTEARRAY StatString;
+
+	if( mapWidth.size( ) == 2 && mapHeight.size( ) == 2 && !mapPath.empty( ) && mapCRC.size( ) == 4 && !hostName.empty( ) )
+	{
+		BYTEARRAY MapGameFlags = GetMapGameFlags( );
+		StatString.reserve( MapGameFlags.size( ) + 1 + 4 + 4 + mapPath.size( ) + 1 + hostName.size( ) + 2 + m_MapSHA1.size( ) );
+		StatString.insert( StatString.end( ), MapGameFlags.begin( ), MapGameFlags.end( ) );
+		StatString.push_back( 0 );
+		StatString.insert( StatString.end( ), mapWidth.begin( ), mapWidth.end( ) );
+		StatString.insert( StatString.end( ), mapHeight.begin( ), mapHeight.end( ) );
+		StatString.insert( StatString.end( ), mapCRC.begin( ), mapCRC.end( ) );
+		StatString.insert( StatString.end( ), mapPath.begin( ), mapPath.end( ) );
+		StatString.push_back( 0 );
+		StatString.insert( StatString.end( ), hostName.begin( ), hostName.end( ) );
+		StatString.push_back( 0 );
+		StatString.push_back( 0 );
+
+		if( withSHA1 )
+			StatString.insert( StatString.end( ), m_MapSHA1.begin( ), m_MapSHA1.end( ) );
+
+		StatString = UTIL_EncodeStatString( StatString );
+	}
+	else
+		CONSOLE_Print( "[MAP] invalid parameters passed to GetEncodedStatString" );
+
+	// save games and custom host names add variants, don't let a long running bot grow the cache forever
+
+	if( m_StatStringCache->m_StatStrings.size( ) >= MAP_STATSTRING_CACHE_MAX )
+		m_StatStringCache->m_StatStrings.clear( );
+
+	m_StatStringCache->m_StatStrings[Key] = StatString;
+	return StatString;
+}
+
 uint32_t CMap :: GetMapGameType( )
 {
 	/* spec stolen from Strilanc as follows:
@@ -231,22 +291,31 @@ void CMap :: Load( CConfig *CFG, string nCFGFile )
 {
 	m_Valid = true;
 	m_CFGFile = nCFGFile;
+	m_StatStringCache.reset( new CMapStatStringCache( ) );
 
 	// load the map data
 
 	m_MapLocalPath = CFG->GetString( "map_localpath", string( ) );
 	m_MapData.clear( );
 
+	string MapMPQFileName = m_GHost->m_MapPath + m_MapLocalPath;
+
+	// if enabled, send a repacked copy of the map instead of the original
+	// everything below (including map_size and map_info) is then calculated from the repacked copy
+
+	if( !m_MapLocalPath.empty( ) && m_GHost->m_MapOptimize )
+		MapMPQFileName = OptimizeMap( CFG, MapMPQFileName );
+
 	if( !m_MapLocalPath.empty( ) )
-		m_MapData = UTIL_FileRead( m_GHost->m_MapPath + m_MapLocalPath );
+		m_MapData = UTIL_FileRead( MapMPQFileName );
 
 	// load the map MPQ
+	// whole file reads of the big compressed files (e.g. war3map.j) have their sectors decoded on several threads
 
-	string MapMPQFileName = m_GHost->m_MapPath + m_MapLocalPath;
 	HANDLE MapMPQ;
 	bool MapMPQReady = false;
 
-	if( SFileOpenArchive( MapMPQFileName.c_str( ), 0, MPQ_OPEN_FORCE_MPQ_V1, &MapMPQ ) )
+	if( SFileOpenArchive( MapMPQFileName.c_str( ), 0, MPQ_OPEN_FORCE_MPQ_V1 | MPQ_OPEN_PARALLEL_DECODE, &MapMPQ ) )
 	{
 		CONSOLE_Print( "[MAP] loading MPQ file [" + MapMPQFileName + "]" );
 		MapMPQReady = true;
@@ -263,7 +332,7 @@ void CMap :: Load( CConfig *CFG, string nCFGFile )
 
 	if( !m_MapData.empty( ) )
 	{
-		m_GHost->m_SHA->Reset( );
+		CSHA1 SHA;
 
 		// calculate map_size
 
@@ -272,7 +341,7 @@ void CMap :: Load( CConfig *CFG, string nCFGFile )
 
 		// calculate map_info (this is actually the CRC)
 
-		MapInfo = UTIL_CreateByteArray( (uint32_t)m_GHost->m_CRC->FullCRC( (unsigned char *)m_MapData.c_str( ), m_MapData.size( ) ), false );
+		MapInfo = UTIL_CreateByteArray( (uint32_t)CCRC32 :: FullCRC( (unsigned char *)m_MapData.c_str( ), m_MapData.size( ) ), false );
 		CONSOLE_Print( "[MAP] calculated map_info = " + UTIL_ByteArrayToDecString( MapInfo ) );
 
 		// calculate map_crc (this is not the CRC) and map_sha1
@@ -318,7 +387,7 @@ void CMap :: Load( CConfig *CFG, string nCFGFile )
 								CONSOLE_Print( "[MAP] overriding default common.j with map copy while calculating map_crc/sha1" );
 								OverrodeCommonJ = true;
 								Val = Val ^ XORRotateLeft( (unsigned char *)SubFileData, BytesRead );
-								m_GHost->m_SHA->Update( (unsigned char *)SubFileData, BytesRead );
+								SHA.Update( (unsigned char *)SubFileData, BytesRead );
 							}
 
 							delete [] SubFileData;
@@ -331,7 +400,7 @@ void CMap :: Load( CConfig *CFG, string nCFGFile )
 				if( !OverrodeCommonJ )
 				{
 					Val = Val ^ XORRotateLeft( (unsigned char *)CommonJ.c_str( ), CommonJ.size( ) );
-					m_GHost->m_SHA->Update( (unsigned char *)CommonJ.c_str( ), CommonJ.size( ) );
+					SHA.Update( (unsigned char *)CommonJ.c_str( ), CommonJ.size( ) );
 				}
 
 				if( MapMPQReady )
@@ -354,7 +423,7 @@ void CMap :: Load( CConfig *CFG, string nCFGFile )
 								CONSOLE_Print( "[MAP] overriding default blizzard.j with map copy while calculating map_crc/sha1" );
 								OverrodeBlizzardJ = true;
 								Val = Val ^ XORRotateLeft( (unsigned char *)SubFileData, BytesRead );
-								m_GHost->m_SHA->Update( (unsigned char *)SubFileData, BytesRead );
+								SHA.Update( (unsigned char *)SubFileData, BytesRead );
 							}
 
 							delete [] SubFileData;
@@ -367,12 +436,12 @@ void CMap :: Load( CConfig *CFG, string nCFGFile )
 				if( !OverrodeBlizzardJ )
 				{
 					Val = Val ^ XORRotateLeft( (unsigned char *)BlizzardJ.c_str( ), BlizzardJ.size( ) );
-					m_GHost->m_SHA->Update( (unsigned char *)BlizzardJ.c_str( ), BlizzardJ.size( ) );
+					SHA.Update( (unsigned char *)BlizzardJ.c_str( ), BlizzardJ.size( ) );
 				}
 
 				Val = ROTL( Val, 3 );
 				Val = ROTL( Val ^ 0x03F1379E, 3 );
-				m_GHost->m_SHA->Update( (unsigned char *)"\x9E\x37\xF1\x03", 4 );
+				SHA.Update( (unsigned char *)"\x9E\x37\xF1\x03", 4 );
 
 				if( MapMPQReady )
 				{
@@ -413,7 +482,7 @@ void CMap :: Load( CConfig *CFG, string nCFGFile )
 										FoundScript = true;
 
 									Val = ROTL( Val ^ XORRotateLeft( (unsigned char *)SubFileData, BytesRead ), 3 );
-									m_GHost->m_SHA->Update( (unsigned char *)SubFileData, BytesRead );
+									SHA.Update( (unsigned char *)SubFileData, BytesRead );
 									// DEBUG_Print( "*** found: " + *i );
 								}
 
@@ -434,10 +503,10 @@ void CMap :: Load( CConfig *CFG, string nCFGFile )
 					MapCRC = UTIL_CreateByteArray( Val, false );
 					CONSOLE_Print( "[MAP] calculated map_crc = " + UTIL_ByteArrayToDecString( MapCRC ) );
 
-					m_GHost->m_SHA->Final( );
+					SHA.Final( );
 					unsigned char SHA1[20];
 					memset( SHA1, 0, sizeof( unsigned char ) * 20 );
-					m_GHost->m_SHA->GetHash( SHA1 );
+					SHA.GetHash( SHA1 );
 					MapSHA1 = UTIL_CreateByteArray( SHA1, 20 );
 					CONSOLE_Print( "[MAP] calculated map_sha1 = " + UTIL_ByteArrayToDecString( MapSHA1 ) );
 				}
@@ -873,6 +942,221 @@ void CMap :: Load( CConfig *CFG, string nCFGFile )
 	CheckValid( );
 }
 
+string CMap :: OptimizeMap( CConfig *CFG, string MapMPQFileName )
+{
+	// repacks the map MPQ with the strongest zlib level and caches the result under the "optimized" directory in bot_mappath
+	// or under "optimized-strip" when stripping is enabled, keeping the map's own file name
+	// returns the file name of the MPQ to use, which is the original map whenever repacking isn't possible or doesn't help
+	// the files inside the MPQ are copied unchanged so map_crc and map_sha1 are not affected, only map_size and map_info change
+
+	if( CFG->Exists( "map_size" ) || CFG->Exists( "map_info" ) )
+	{
+		CONSOLE_Print( "[MAP] not optimizing map [" + m_MapLocalPath + "] because the config file overrides map_size or map_info" );
+		return MapMPQFileName;
+	}
+
+	path OriginalPath( MapMPQFileName );
+	path CachePath = path( m_GHost->m_MapPath ) / ( m_GHost->m_MapOptimizeStrip ? "optimized-strip" : "optimized" ) / m_MapLocalPath;
+	string CacheFileName = CachePath.string( );
+
+	try
+	{
+		if( !exists( OriginalPath ) )
+			return MapMPQFileName;
+
+		uintmax_t OriginalSize = file_size( OriginalPath );
+
+		// reuse the cached copy unless the original map has been modified since it was built
+
+		if( exists( CachePath ) && last_write_time( CachePath ) >= last_write_time( OriginalPath ) )
+		{
+			uintmax_t CacheSize = file_size( CachePath );
+
+			if( CacheSize > 0 && CacheSize < OriginalSize )
+			{
+				CONSOLE_Print( "[MAP] using optimized map [" + CacheFileName + "], " + UTIL_ToString( (uint32_t)( OriginalSize - CacheSize ) ) + " bytes smaller than the original" );
+				return CacheFileName;
+			}
+		}
+
+		create_directories( CachePath.parent_path( ) );
+	}
+	catch( const exception &ex )
+	{
+		CONSOLE_Print( "[MAP] not optimizing map [" + m_MapLocalPath + "] - " + string( ex.what( ) ) );
+		return MapMPQFileName;
+	}
+
+	HANDLE SourceMPQ;
+
+	if( !SFileOpenArchive( MapMPQFileName.c_str( ), 0, MPQ_OPEN_FORCE_MPQ_V1 | MPQ_OPEN_READ_ONLY | MPQ_OPEN_PARALLEL_DECODE, &SourceMPQ ) )
+		return MapMPQFileName;
+
+	// signed maps (e.g. the Blizzard maps) would fail the signature check once repacked
+
+	DWORD Signatures = 0;
+	ULONGLONG HeaderOffset = 0;
+	DWORD SectorSize = 0;
+	SFileGetFileInfo( SourceMPQ, SFileMpqSignatures, &Signatures, sizeof( Signatures ), NULL );
+	SFileGetFileInfo( SourceMPQ, SFileMpqHeaderOffset, &HeaderOffset, sizeof( HeaderOffset ), NULL );
+	SFileGetFileInfo( SourceMPQ, SFileMpqSectorSize, &SectorSize, sizeof( SectorSize ), NULL );
+
+	if( Signatures != 0 )
+	{
+		CONSOLE_Print( "[MAP] not optimizing map [" + m_MapLocalPath + "] because it is signed" );
+		SFileCloseArchive( SourceMPQ );
+		return MapMPQFileName;
+	}
+
+	// collect the files to copy
+	// files without a name show up as File00000000.xxx, StormLib refuses to add those under a pseudo name so we give up on protected maps
+
+	vector<string> FileNames;
+	bool HasAttributes = false;
+	bool Unnamed = false;
+	SFILE_FIND_DATA FindData;
+	HANDLE Find = SFileFindFirstFile( SourceMPQ, "*", &FindData, NULL );
+
+	if( Find )
+	{
+		do
+		{
+			string FileName = FindData.cFileName;
+			string LowerFileName = FileName;
+			transform( LowerFileName.begin( ), LowerFileName.end( ), LowerFileName.begin( ), (int(*)(int))tolower );
+
+			if( LowerFileName == "(attributes)" )
+				HasAttributes = true;
+			else if( LowerFileName.size( ) == 16 && LowerFileName.compare( 0, 4, "file" ) == 0 && LowerFileName.compare( 12, 4, ".xxx" ) == 0 )
+				Unnamed = true;
+			else if( LowerFileName == "(listfile)" || LowerFileName == "(signature)" )
+				continue;
+			else if( m_GHost->m_MapOptimizeStrip && LowerFileName == "war3mappreview.tga" )
+				continue;
+			else
+				FileNames.push_back( FileName );
+		} while( SFileFindNextFile( Find, &FindData ) );
+
+		SFileFindClose( Find );
+	}
+
+	if( Unnamed || FileNames.empty( ) )
+	{
+		CONSOLE_Print( "[MAP] not optimizing map [" + m_MapLocalPath + "] because it contains unnamed files" );
+		SFileCloseArchive( SourceMPQ );
+		return MapMPQFileName;
+	}
+
+	// build the new MPQ in a temporary file next to the cache so a half written map is never served
+	// Warcraft III reads the map header (the part in front of the MPQ) so it's copied as is
+
+	string TempFileName = CacheFileName + ".tmp";
+	boost :: filesystem :: remove( path( TempFileName ) );
+	bool Success = true;
+
+	if( HeaderOffset > 0 )
+	{
+		string Header = UTIL_FileRead( MapMPQFileName, 0, (uint32_t)HeaderOffset );
+		Success = Header.size( ) == HeaderOffset && UTIL_FileWrite( TempFileName, (unsigned char *)Header.c_str( ), Header.size( ) );
+	}
+
+	SFILE_CREATE_MPQ CreateInfo;
+	memset( &CreateInfo, 0, sizeof( SFILE_CREATE_MPQ ) );
+	CreateInfo.cbSize = sizeof( SFILE_CREATE_MPQ );
+	CreateInfo.dwMpqVersion = MPQ_FORMAT_VERSION_1;
+	CreateInfo.dwStreamFlags = STREAM_PROVIDER_FLAT | BASE_PROVIDER_FILE;
+	CreateInfo.dwFileFlags1 = m_GHost->m_MapOptimizeStrip ? 0 : MPQ_FILE_DEFAULT_INTERNAL;
+	CreateInfo.dwFileFlags2 = ( HasAttributes && !m_GHost->m_MapOptimizeStrip ) ? MPQ_FILE_DEFAULT_INTERNAL : 0;
+	CreateInfo.dwAttrFlags = CreateInfo.dwFileFlags2 ? ( MPQ_ATTRIBUTE_CRC32 | MPQ_ATTRIBUTE_FILETIME | MPQ_ATTRIBUTE_MD5 ) : 0;
+	CreateInfo.dwSectorSize = SectorSize ? SectorSize : 0x1000;
+	CreateInfo.dwMaxFileCount = FileNames.size( );
+	CreateInfo.dwCreateFlags = MPQ_CREATE_BEST_COMPRESSION;
+
+	HANDLE TargetMPQ;
+
+	if( Success && !SFileCreateArchive2( TempFileName.c_str( ), &CreateInfo, &TargetMPQ ) )
+		Success = false;
+
+	if( Success )
+	{
+		for( vector<string> :: iterator i = FileNames.begin( ); Success && i != FileNames.end( ); ++i )
+		{
+			HANDLE SubFile;
+			Success = false;
+
+			if( SFileOpenFileEx( SourceMPQ, (*i).c_str( ), 0, &SubFile ) )
+			{
+				uint32_t FileLength = SFileGetFileSize( SubFile, NULL );
+				DWORD Locale = 0;
+				SFileGetFileInfo( SubFile, SFileInfoLocale, &Locale, sizeof( Locale ), NULL );
+
+				if( FileLength != 0xFFFFFFFF )
+				{
+					// sound files stored with the lossy ADPCM compression are decoded on read and stored losslessly here
+
+					char *SubFileData = new char[FileLength + 1];
+					DWORD BytesRead = 0;
+					HANDLE NewFile;
+
+					if( ( FileLength == 0 || SFileReadFile( SubFile, SubFileData, FileLength, &BytesRead, NULL ) ) && BytesRead == FileLength )
+					{
+						if( SFileCreateFile( TargetMPQ, (*i).c_str( ), 0, FileLength, (LCID)Locale, MPQ_FILE_COMPRESS, &NewFile ) )
+						{
+							Success = FileLength == 0 || SFileWriteFile( NewFile, SubFileData, FileLength, MPQ_COMPRESSION_ZLIB );
+
+							if( !SFileFinishFile( NewFile ) )
+								Success = false;
+						}
+					}
+
+					delete [] SubFileData;
+				}
+
+				SFileCloseFile( SubFile );
+			}
+
+			if( !Success )
+				CONSOLE_Print( "[MAP] unable to copy file [" + *i + "] while optimizing map [" + m_MapLocalPath + "]" );
+		}
+
+		if( !SFileCloseArchive( TargetMPQ ) )
+			Success = false;
+	}
+
+	SFileCloseArchive( SourceMPQ );
+
+	// keep the result only if it's actually smaller
+
+	try
+	{
+		if( Success )
+		{
+			uintmax_t OriginalSize = file_size( OriginalPath );
+			uintmax_t OptimizedSize = file_size( path( TempFileName ) );
+
+			if( OptimizedSize < OriginalSize )
+			{
+				boost :: filesystem :: remove( CachePath );
+				rename( path( TempFileName ), CachePath );
+				CONSOLE_Print( "[MAP] optimized map [" + m_MapLocalPath + "] from " + UTIL_ToString( (uint32_t)OriginalSize ) + " to " + UTIL_ToString( (uint32_t)OptimizedSize ) + " bytes, saved " + UTIL_ToString( (uint32_t)( OriginalSize - OptimizedSize ) ) + " bytes" );
+				return CacheFileName;
+			}
+
+			CONSOLE_Print( "[MAP] optimizing map [" + m_MapLocalPath + "] didn't make it smaller, using the original map" );
+		}
+		else
+			CONSOLE_Print( "[MAP] unable to optimize map [" + m_MapLocalPath + "], using the original map" );
+
+		boost :: filesystem :: remove( path( TempFileName ) );
+	}
+	catch( const exception &ex )
+	{
+		CONSOLE_Print( "[MAP] unable to optimize map [" + m_MapLocalPath + "] - " + string( ex.what( ) ) );
+	}
+
+	return MapMPQFileName;
+}
+
 void CMap :: CheckValid( )
 {
 	// todotodo: should this code fix any errors it sees rather than just warning the user?
@@ -85,6 +85,24 @@
 
 #include "gameslot.h"
 
+#include <boost/shared_ptr.hpp>
+
+//
+// CMapStatStringCache
+//
+
+// encoded stat strings are shared between every copy of a map (each game holds its own CMap copy)
+// the cache is replaced whenever the map is reloaded so a stale stat string can never be advertised
+
+#define MAP_STATSTRING_CACHE_MAX		64
+
+class CMapStatStringCache
+{
+public:
+	boost::mutex m_Mutex;
+	map<string, BYTEARRAY> m_StatStrings;
+};
+
 //
 // CMap
 //
@@ -124,6 +142,7 @@ private:
 	uint32_t m_MapNumPlayers;
 	uint32_t m_MapNumTeams;
 	vector<CGameSlot> m_Slots;
+	boost::shared_ptr<CMapStatStringCache> m_StatStringCache;
 
 public:
 	CMap( CGHost *nGHost );
@@ -159,7 +178,10 @@ public:
 	uint32_t GetMapNumTeams( )				{ return m_MapNumTeams; }
 	vector<CGameSlot> GetSlots( )			{ return m_Slots; }
 
+	BYTEARRAY GetEncodedStatString( const BYTEARRAY &mapWidth, const BYTEARRAY &mapHeight, const string &mapPath, const BYTEARRAY &mapCRC, const string &hostName, bool withSHA1 );
+
 	void Load( CConfig *CFG, string nCFGFile );
+	string OptimizeMap( CConfig *CFG, string MapMPQFileName );
 	void CheckValid( );
 	uint32_t XORRotateLeft( unsigned char *data, uint32_t length );
 };
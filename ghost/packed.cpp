@@ -23,6 +23,7 @@
 #include "crc32.h"
 #include "packed.h"
 
+#include <string.h>
 #include <zlib.h>
 
 // we can't use zlib's uncompress function because it expects a complete compressed buffer
@@ -68,13 +69,12 @@ int tzuncompress( Bytef *dest, uLongf *destLen, const Bytef *source, uLong sourc
 
 CPacked :: CPacked( ) : m_Valid( true ), m_HeaderSize( 0 ), m_CompressedSize( 0 ), m_HeaderVersion( 0 ), m_DecompressedSize( 0 ), m_NumBlocks( 0 ), m_War3Identifier( 0 ), m_War3Version( 0 ), m_BuildNumber( 0 ), m_Flags( 0 ), m_ReplayLength( 0 )
 {
-	m_CRC = new CCRC32( );
-	m_CRC->Initialize( );
+
 }
 
 CPacked :: ~CPacked( )
 {
-	delete m_CRC;
+
 }
 
 void CPacked :: Load( string fileName, bool allBlocks )
@@ -85,6 +85,16 @@ void CPacked :: Load( string fileName, bool allBlocks )
 	Decompress( allBlocks );
 }
 
+void CPacked :: Load( const char *data, size_t size, bool allBlocks )
+{
+	// decompress directly from a caller owned buffer (e.g. a memory mapped file) without keeping a copy of the compressed data
+	// note that m_Compressed is left empty so call Compress before saving
+
+	m_Valid = true;
+	m_Compressed.clear( );
+	Decompress( data, size, allBlocks );
+}
+
 bool CPacked :: Save( bool TFT, string fileName )
 {
 	Compress( TFT );
@@ -125,64 +135,78 @@ bool CPacked :: Pack( bool TFT, string inFileName, string outFileName )
 }
 
 void CPacked :: Decompress( bool allBlocks )
+{
+	Decompress( m_Compressed.data( ), m_Compressed.size( ), allBlocks );
+}
+
+void CPacked :: Decompress( const char *data, size_t size, bool allBlocks )
 {
 	CONSOLE_Print( "[PACKED] decompressing data" );
 
 	// format found at http://www.thehelper.net/forums/showthread.php?t=42787
+	// the data is read in place and every block is inflated straight into m_Decompressed so nothing else is copied or allocated per block
 
 	m_Decompressed.clear( );
-	istringstream ISS( m_Compressed );
-	string GarbageString;
+	const char *End = data + size;
+	const char *Terminator = (const char *)memchr( data, 0, size );
 
 	// read header
 
-	getline( ISS, GarbageString, '\0' );
-
-	if( GarbageString != "Warcraft III recorded game\x01A" )
+	if( !Terminator || string( data, Terminator ) != "Warcraft III recorded game\x01A" )
 	{
 		CONSOLE_Print( "[PACKED] not a valid packed file" );
 		m_Valid = false;
 		return;
 	}
 
-	ISS.read( (char *)&m_HeaderSize, 4 );			// header size
-	ISS.read( (char *)&m_CompressedSize, 4 );		// compressed file size
-	ISS.read( (char *)&m_HeaderVersion, 4 );		// header version
-	ISS.read( (char *)&m_DecompressedSize, 4 );		// decompressed file size
-	ISS.read( (char *)&m_NumBlocks, 4 );			// number of blocks
+	const char *Position = Terminator + 1;
 
-	if( m_HeaderVersion == 0 )
+	if( End - Position < 20 )
 	{
-		ISS.seekg( 2, ios :: cur );					// unknown
-		ISS.seekg( 2, ios :: cur );					// version number
-
-		CONSOLE_Print( "[PACKED] header version is too old" );
+		CONSOLE_Print( "[PACKED] failed to read header" );
 		m_Valid = false;
 		return;
 	}
-	else
+
+	memcpy( &m_HeaderSize, Position, 4 );			// header size
+	memcpy( &m_CompressedSize, Position + 4, 4 );	// compressed file size
+	memcpy( &m_HeaderVersion, Position + 8, 4 );	// header version
+	memcpy( &m_DecompressedSize, Position + 12, 4 );	// decompressed file size
+	memcpy( &m_NumBlocks, Position + 16, 4 );		// number of blocks
+	Position += 20;
+
+	if( m_HeaderVersion == 0 )
 	{
-		ISS.read( (char *)&m_War3Identifier, 4 );	// version identifier
-		ISS.read( (char *)&m_War3Version, 4 );		// version number
+		CONSOLE_Print( "[PACKED] header version is too old" );
+		m_Valid = false;
+		return;
 	}
 
-	ISS.read( (char *)&m_BuildNumber, 2 );			// build number
-	ISS.read( (char *)&m_Flags, 2 );				// flags
-	ISS.read( (char *)&m_ReplayLength, 4 );			// replay length
-	ISS.seekg( 4, ios :: cur );						// CRC
-
-	if( ISS.fail( ) )
+	if( End - Position < 20 )
 	{
 		CONSOLE_Print( "[PACKED] failed to read header" );
 		m_Valid = false;
 		return;
 	}
 
+	memcpy( &m_War3Identifier, Position, 4 );		// version identifier
+	memcpy( &m_War3Version, Position + 4, 4 );		// version number
+	memcpy( &m_BuildNumber, Position + 8, 2 );		// build number
+	memcpy( &m_Flags, Position + 10, 2 );			// flags
+	memcpy( &m_ReplayLength, Position + 12, 4 );	// replay length
+	Position += 20;									// CRC
+
 	if( allBlocks )
 		CONSOLE_Print( "[PACKED] reading " + UTIL_ToString( m_NumBlocks ) + " blocks" );
 	else
 		CONSOLE_Print( "[PACKED] reading 1/" + UTIL_ToString( m_NumBlocks ) + " blocks" );
 
+	// every block decompresses to 8192 bytes so reserve the whole output up front
+	// the block count comes from the file so only trust as many blocks as there are 8 byte block headers left in the data
+
+	if( allBlocks )
+		m_Decompressed.reserve( min( (size_t)m_NumBlocks, (size_t)( End - Position ) / 8 ) * 8192 );
+
 	// read blocks
 
 	for( uint32_t i = 0; i < m_NumBlocks; ++i )
@@ -192,43 +216,37 @@ void CPacked :: Decompress( bool allBlocks )
 
 		// read block header
 
-		ISS.read( (char *)&BlockCompressed, 2 );	// block compressed size
-		ISS.read( (char *)&BlockDecompressed, 2 );	// block decompressed size
-		ISS.seekg( 4, ios :: cur );					// checksum
-
-		if( ISS.fail( ) )
+		if( End - Position < 8 )
 		{
 			CONSOLE_Print( "[PACKED] failed to read block header" );
 			m_Valid = false;
 			return;
 		}
 
-		// read block data
+		memcpy( &BlockCompressed, Position, 2 );	// block compressed size
+		memcpy( &BlockDecompressed, Position + 2, 2 );	// block decompressed size
+		Position += 8;								// checksum
 
-		uLongf BlockCompressedLong = BlockCompressed;
-		uLongf BlockDecompressedLong = BlockDecompressed;
-		unsigned char *CompressedData = new unsigned char[BlockCompressed];
-		unsigned char *DecompressedData = new unsigned char[BlockDecompressed];
-		ISS.read( (char*)CompressedData, BlockCompressed );
+		// read block data
 
-		if( ISS.fail( ) )
+		if( End - Position < BlockCompressed )
 		{
 			CONSOLE_Print( "[PACKED] failed to read block data" );
-			delete [] DecompressedData;
-			delete [] CompressedData;
 			m_Valid = false;
 			return;
 		}
 
 		// decompress block data
 
-		int Result = tzuncompress( DecompressedData, &BlockDecompressedLong, CompressedData, BlockCompressedLong );
+		string :: size_type Offset = m_Decompressed.size( );
+		m_Decompressed.resize( Offset + BlockDecompressed );
+		uLongf BlockDecompressedLong = BlockDecompressed;
+		int Result = tzuncompress( (Bytef *)&m_Decompressed[Offset], &BlockDecompressedLong, (const Bytef *)Position, BlockCompressed );
+		Position += BlockCompressed;
 
 		if( Result != Z_OK )
 		{
 			CONSOLE_Print( "[PACKED] tzuncompress error " + UTIL_ToString( Result ) );
-			delete [] DecompressedData;
-			delete [] CompressedData;
 			m_Valid = false;
 			return;
 		}
@@ -236,16 +254,10 @@ void CPacked :: Decompress( bool allBlocks )
 		if( BlockDecompressedLong != (uLongf)BlockDecompressed )
 		{
 			CONSOLE_Print( "[PACKED] block decompressed size mismatch, actual = " + UTIL_ToString( BlockDecompressedLong ) + ", expected = " + UTIL_ToString( BlockDecompressed ) );
-			delete [] DecompressedData;
-			delete [] CompressedData;
 			m_Valid = false;
 			return;
 		}
 
-		m_Decompressed += string( (char *)DecompressedData, BlockDecompressedLong );
-		delete [] DecompressedData;
-		delete [] CompressedData;
-
 		// stop after one iteration if not decompressing all blocks
 
 		if( !allBlocks )
@@ -350,7 +362,7 @@ void CPacked :: Compress( bool TFT )
 	// calculate header CRC
 
 	string HeaderString = string( Header.begin( ), Header.end( ) );
-	uint32_t CRC = m_CRC->FullCRC( (unsigned char *)HeaderString.c_str( ), HeaderString.size( ) );
+	uint32_t CRC = CCRC32 :: FullCRC( (unsigned char *)HeaderString.c_str( ), HeaderString.size( ) );
 
 	// overwrite the (currently zero) header CRC with the calculated CRC
 
@@ -375,9 +387,9 @@ void CPacked :: Compress( bool TFT )
 		// calculate block header CRC
 
 		string BlockHeaderString = string( BlockHeader.begin( ), BlockHeader.end( ) );
-		uint32_t CRC1 = m_CRC->FullCRC( (unsigned char *)BlockHeaderString.c_str( ), BlockHeaderString.size( ) );
+		uint32_t CRC1 = CCRC32 :: FullCRC( (unsigned char *)BlockHeaderString.c_str( ), BlockHeaderString.size( ) );
 		CRC1 = CRC1 ^ ( CRC1 >> 16 );
-		uint32_t CRC2 = m_CRC->FullCRC( (unsigned char *)(*i).c_str( ), (*i).size( ) );
+		uint32_t CRC2 = CCRC32 :: FullCRC( (unsigned char *)(*i).c_str( ), (*i).size( ) );
 		CRC2 = CRC2 ^ ( CRC2 >> 16 );
 		uint32_t BlockCRC = ( CRC1 & 0xFFFF ) | ( CRC2 << 16 );
 
@@ -25,13 +25,8 @@
 // CPacked
 //
 
-class CCRC32;
-
 class CPacked
 {
-public:
-	CCRC32 *m_CRC;
-
 protected:
 	bool m_Valid;
 	string m_Compressed;
@@ -69,10 +64,12 @@ public:
 	virtual void SetReplayLength( uint32_t nReplayLength )			{ m_ReplayLength = nReplayLength; }
 
 	virtual void Load( string fileName, bool allBlocks );
+	virtual void Load( const char *data, size_t size, bool allBlocks );
 	virtual bool Save( bool TFT, string fileName );
 	virtual bool Extract( string inFileName, string outFileName );
 	virtual bool Pack( bool TFT, string inFileName, string outFileName );
 	virtual void Decompress( bool allBlocks );
+	virtual void Decompress( const char *data, size_t size, bool allBlocks );
 	virtual void Compress( bool TFT );
 };
 
@@ -0,0 +1,220 @@
+/*
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*/
+
+
+#include "ghost.h"
+#include "util.h"
+#include "sendscheduler.h"
+
+static const char *SendLaneNames[SENDLANE_COUNT] = { "game", "control", "whisper", "chat" };
+
+//
+// CSendScheduler
+//
+
+CSendScheduler :: CSendScheduler( uint32_t nCapacity, uint32_t nPacketCost, uint32_t nTicksPerByte ) : m_Capacity( nCapacity ), m_PacketCost( nPacketCost ), m_TicksPerByte( nTicksPerByte ), m_Debt( 0 ), m_LastDrainTicks( GetTicks( ) ), m_LastSentTicks( GetTicks( ) )
+{
+
+}
+
+CSendScheduler :: ~CSendScheduler( )
+{
+
+}
+
+bool CSendScheduler :: Queue( unsigned char lane, const BYTEARRAY &packet, uint32_t ticks, bool coalesce )
+{
+	if( lane >= SENDLANE_COUNT )
+		return false;
+
+	deque<CQueuedPacket> &Lane = m_Lanes[lane];
+
+	if( coalesce && !Lane.empty( ) && Lane.back( ).m_Data.size( ) >= 2 && packet.size( ) >= 2 && Lane.back( ).m_Data[1] == packet[1] )
+	{
+		Lane.back( ).m_Data = packet;
+		++m_Stats[lane].m_Coalesced;
+		return true;
+	}
+
+	if( ( lane == SENDLANE_WHISPER || lane == SENDLANE_CHAT ) && Lane.size( ) >= SENDLANE_MAXQUEUED )
+	{
+		++m_Stats[lane].m_Discarded;
+		return false;
+	}
+
+	Lane.push_back( CQueuedPacket( packet, ticks ) );
+	return true;
+}
+
+bool CSendScheduler :: Pop( BYTEARRAY &packet, uint32_t ticks )
+{
+	for( unsigned char i = 0; i < SENDLANE_COUNT; ++i )
+	{
+		if( m_Lanes[i].empty( ) )
+			continue;
+
+		// only the highest priority packet is considered, a lower priority packet never jumps ahead even if it's small enough to fit
+
+		CQueuedPacket &Next = m_Lanes[i].front( );
+		uint32_t Cost = GetCost( Next.m_Data );
+		Drain( ticks );
+
+		// a packet bigger than the whole bucket is sent as soon as the bucket is empty
+
+		if( m_Debt > 0 && m_Debt + Cost > m_Capacity * m_TicksPerByte )
+			return false;
+
+		uint32_t Wait = ticks - Next.m_QueuedTicks;
+		++m_Stats[i].m_Sent;
+		m_Stats[i].m_TotalWait += Wait;
+
+		if( Wait > m_Stats[i].m_MaxWait )
+			m_Stats[i].m_MaxWait = Wait;
+
+		packet.swap( Next.m_Data );
+		m_Lanes[i].pop_front( );
+		m_Debt += Cost;
+		m_LastSentTicks = ticks;
+		return true;
+	}
+
+	return false;
+}
+
+uint32_t CSendScheduler :: GetWaitTicks( uint32_t ticks )
+{
+	for( unsigned char i = 0; i < SENDLANE_COUNT; ++i )
+	{
+		if( m_Lanes[i].empty( ) )
+			continue;
+
+		uint32_t Cost = GetCost( m_Lanes[i].front( ).m_Data );
+		uint32_t Limit = m_Capacity * m_TicksPerByte;
+		Drain( ticks );
+
+		if( m_Debt == 0 || m_Debt + Cost <= Limit )
+			return 0;
+
+		return Cost > Limit ? m_Debt : m_Debt + Cost - Limit;
+	}
+
+	return 0;
+}
+
+uint32_t CSendScheduler :: Unqueue( unsigned char packetID )
+{
+	uint32_t Unqueued = 0;
+
+	for( unsigned char i = 0; i < SENDLANE_COUNT; ++i )
+	{
+		for( deque<CQueuedPacket> :: iterator j = m_Lanes[i].begin( ); j != m_Lanes[i].end( ); )
+		{
+			if( j->m_Data.size( ) >= 2 && j->m_Data[1] == packetID )
+			{
+				j = m_Lanes[i].erase( j );
+				++Unqueued;
+			}
+			else
+				++j;
+		}
+	}
+
+	return Unqueued;
+}
+
+uint32_t CSendScheduler :: Unqueue( const BYTEARRAY &packet )
+{
+	uint32_t Unqueued = 0;
+
+	for( unsigned char i = 0; i < SENDLANE_COUNT; ++i )
+	{
+		for( deque<CQueuedPacket> :: iterator j = m_Lanes[i].begin( ); j != m_Lanes[i].end( ); )
+		{
+			if( j->m_Data == packet )
+			{
+				j = m_Lanes[i].erase( j );
+				++Unqueued;
+			}
+			else
+				++j;
+		}
+	}
+
+	return Unqueued;
+}
+
+void CSendScheduler :: Reset( uint32_t ticks )
+{
+	for( unsigned char i = 0; i < SENDLANE_COUNT; ++i )
+		m_Lanes[i].clear( );
+
+	m_Debt = 0;
+	m_LastDrainTicks = ticks;
+	m_LastSentTicks = ticks;
+}
+
+uint32_t CSendScheduler :: GetQueued( )
+{
+	uint32_t Queued = 0;
+
+	for( unsigned char i = 0; i < SENDLANE_COUNT; ++i )
+		Queued += m_Lanes[i].size( );
+
+	return Queued;
+}
+
+string CSendScheduler :: GetStatsSummary( )
+{
+	string Summary;
+
+	for( unsigned char i = 0; i < SENDLANE_COUNT; ++i )
+	{
+		CSendLaneStats &Stats = m_Stats[i];
+
+		if( Stats.m_Sent == 0 && Stats.m_Coalesced == 0 && Stats.m_Discarded == 0 )
+			continue;
+
+		if( !Summary.empty( ) )
+			Summary += ", ";
+
+		Summary += string( SendLaneNames[i] ) + " " + UTIL_ToString( Stats.m_Sent ) + " sent";
+
+		if( Stats.m_Sent > 0 )
+			Summary += " (wait avg " + UTIL_ToString( (uint32_t)( Stats.m_TotalWait / Stats.m_Sent ) ) + "ms max " + UTIL_ToString( Stats.m_MaxWait ) + "ms)";
+
+		if( Stats.m_Coalesced > 0 )
+			Summary += " " + UTIL_ToString( Stats.m_Coalesced ) + " coalesced";
+
+		if( Stats.m_Discarded > 0 )
+			Summary += " " + UTIL_ToString( Stats.m_Discarded ) + " discarded";
+
+		Stats = CSendLaneStats( );
+	}
+
+	return Summary;
+}
+
+void CSendScheduler :: Drain( uint32_t ticks )
+{
+	uint32_t Elapsed = ticks - m_LastDrainTicks;
+	m_Debt = Elapsed >= m_Debt ? 0 : m_Debt - Elapsed;
+	m_LastDrainTicks = ticks;
+}
+
+uint32_t CSendScheduler :: GetCost( const BYTEARRAY &packet )
+{
+	return ( m_PacketCost + packet.size( ) ) * m_TicksPerByte;
+}
@@ -0,0 +1,105 @@
+/*
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*/
+
+
+#ifndef SENDSCHEDULER_H
+#define SENDSCHEDULER_H
+
+//
+// CSendScheduler
+//
+
+// flood control for the packets a battle.net connection sends after logging in
+// battle.net allows a small burst and then drains a credit for every byte sent, each packet also costs a fixed overhead on top of its size
+// so the scheduler keeps a token bucket with the same shape and only releases a packet once the server would accept it without a flood disconnect
+// packets wait in priority lanes and the highest priority lane with a packet waiting always goes first
+
+#define SENDLANE_GAME			0	// game create, refresh and uncreate packets
+#define SENDLANE_CONTROL		1	// entering chat, channel commands and messages to the other bots in a master/child setup
+#define SENDLANE_WHISPER		2	// whispers to users
+#define SENDLANE_CHAT			3	// channel chat
+#define SENDLANE_COUNT			4
+
+#define SENDLANE_MAXQUEUED		10	// the whisper and chat lanes discard new messages past this many waiting
+
+class CQueuedPacket
+{
+public:
+	BYTEARRAY m_Data;
+	uint32_t m_QueuedTicks;		// GetTicks when the packet was first queued (a coalesced packet keeps the time of the packet it replaced)
+
+	CQueuedPacket( const BYTEARRAY &nData, uint32_t nQueuedTicks ) : m_Data( nData ), m_QueuedTicks( nQueuedTicks ) { }
+};
+
+class CSendLaneStats
+{
+public:
+	uint32_t m_Sent;			// packets sent
+	uint32_t m_Coalesced;		// packets replaced by a newer packet of the same type before they were sent
+	uint32_t m_Discarded;		// packets discarded because the lane was full
+	uint64_t m_TotalWait;		// total ticks the sent packets waited in the lane
+	uint32_t m_MaxWait;			// longest ticks a sent packet waited in the lane
+
+	CSendLaneStats( ) : m_Sent( 0 ), m_Coalesced( 0 ), m_Discarded( 0 ), m_TotalWait( 0 ), m_MaxWait( 0 ) { }
+};
+
+class CSendScheduler
+{
+private:
+	deque<CQueuedPacket> m_Lanes[SENDLANE_COUNT];
+	CSendLaneStats m_Stats[SENDLANE_COUNT];
+	uint32_t m_Capacity;		// size of the bucket in credits (bytes)
+	uint32_t m_PacketCost;		// credits charged for every packet on top of its size
+	uint32_t m_TicksPerByte;	// ticks it takes the server to forget one credit
+	uint32_t m_Debt;			// credits currently used, stored in ticks (credits * m_TicksPerByte) so draining it doesn't lose precision
+	uint32_t m_LastDrainTicks;	// GetTicks when m_Debt was last drained
+	uint32_t m_LastSentTicks;	// GetTicks when the last packet was sent
+
+public:
+	CSendScheduler( uint32_t nCapacity, uint32_t nPacketCost, uint32_t nTicksPerByte );
+	~CSendScheduler( );
+
+	// queues a packet on a lane, returns false if the packet was discarded because the lane is full
+	// when coalesce is true and the newest packet in the lane has the same packet ID it's replaced instead (e.g. a newer game refresh makes an older one pointless)
+
+	bool Queue( unsigned char lane, const BYTEARRAY &packet, uint32_t ticks, bool coalesce = false );
+
+	// returns true and moves the next packet into packet if the bucket has room for it now
+
+	bool Pop( BYTEARRAY &packet, uint32_t ticks );
+
+	// returns the number of ticks until the next waiting packet can be sent (0 if it can be sent now or nothing is waiting)
+
+	uint32_t GetWaitTicks( uint32_t ticks );
+
+	uint32_t Unqueue( unsigned char packetID );
+	uint32_t Unqueue( const BYTEARRAY &packet );
+	void Reset( uint32_t ticks );
+
+	uint32_t GetQueued( );
+	uint32_t GetQueued( unsigned char lane )	{ return lane < SENDLANE_COUNT ? m_Lanes[lane].size( ) : 0; }
+	uint32_t GetLastSentTicks( )				{ return m_LastSentTicks; }
+
+	// returns a one line summary of the per lane statistics since the last call and resets them (empty if nothing happened)
+
+	string GetStatsSummary( );
+
+private:
+	void Drain( uint32_t ticks );
+	uint32_t GetCost( const BYTEARRAY &packet );
+};
+
+#endif
@@ -19,6 +19,20 @@
 
 #include "sha1.h"
 
+// Rotate x bits to the left
+#define ROL32(value, bits) (((value)<<(bits))|((value)>>(32-(bits))))
+
+// The message schedule lives in a 16 word circular buffer on the stack (no shared workspace)
+// SHABLK0 reads the big endian words loaded up front, SHABLK expands the schedule in place
+#define SHABLK0(i) (W[i])
+#define SHABLK(i) (W[i&15] = ROL32(W[(i+13)&15] ^ W[(i+8)&15] ^ W[(i+2)&15] ^ W[i&15],1))
+
+// SHA-1 rounds
+#define R0(v,w,x,y,z,i) { z+=((w&(x^y))^y)+SHABLK0(i)+0x5A827999+ROL32(v,5); w=ROL32(w,30); }
+#define R1(v,w,x,y,z,i) { z+=((w&(x^y))^y)+SHABLK(i)+0x5A827999+ROL32(v,5); w=ROL32(w,30); }
+#define R2(v,w,x,y,z,i) { z+=(w^x^y)+SHABLK(i)+0x6ED9EBA1+ROL32(v,5); w=ROL32(w,30); }
+#define R3(v,w,x,y,z,i) { z+=(((w|x)&y)|(w&x))+SHABLK(i)+0x8F1BBCDC+ROL32(v,5); w=ROL32(w,30); }
+#define R4(v,w,x,y,z,i) { z+=(w^x^y)+SHABLK(i)+0xCA62C1D6+ROL32(v,5); w=ROL32(w,30); }
 
 CSHA1::CSHA1()
 {
@@ -27,9 +41,8 @@ CSHA1::CSHA1()
 
 CSHA1::~CSHA1()
 {
-	Reset();
-}
 
+}
 
 void CSHA1::Reset()
 {
@@ -44,57 +57,61 @@ void CSHA1::Reset()
 	m_count[1] = 0;
 }
 
-void CSHA1::Transform(uint32_t state[5], unsigned char buffer[64])
+void CSHA1::Transform(uint32_t state[5], const unsigned char *buffer, size_t numBlocks)
 {
-	uint32_t a = 0, b = 0, c = 0, d = 0, e = 0;
-
-	SHA1_WORKSPACE_BLOCK* block;
-	static unsigned char workspace[64];
-	block = (SHA1_WORKSPACE_BLOCK *)workspace;
-	memcpy(block, buffer, 64);
-
-	// Copy state[] to working vars
-	a = state[0];
-	b = state[1];
-	c = state[2];
-	d = state[3];
-	e = state[4];
-
-	// 4 rounds of 20 operations each. Loop unrolled.
-	R0(a,b,c,d,e, 0); R0(e,a,b,c,d, 1); R0(d,e,a,b,c, 2); R0(c,d,e,a,b, 3);
-	R0(b,c,d,e,a, 4); R0(a,b,c,d,e, 5); R0(e,a,b,c,d, 6); R0(d,e,a,b,c, 7);
-	R0(c,d,e,a,b, 8); R0(b,c,d,e,a, 9); R0(a,b,c,d,e,10); R0(e,a,b,c,d,11);
-	R0(d,e,a,b,c,12); R0(c,d,e,a,b,13); R0(b,c,d,e,a,14); R0(a,b,c,d,e,15);
-	R1(e,a,b,c,d,16); R1(d,e,a,b,c,17); R1(c,d,e,a,b,18); R1(b,c,d,e,a,19);
-	R2(a,b,c,d,e,20); R2(e,a,b,c,d,21); R2(d,e,a,b,c,22); R2(c,d,e,a,b,23);
-	R2(b,c,d,e,a,24); R2(a,b,c,d,e,25); R2(e,a,b,c,d,26); R2(d,e,a,b,c,27);
-	R2(c,d,e,a,b,28); R2(b,c,d,e,a,29); R2(a,b,c,d,e,30); R2(e,a,b,c,d,31);
-	R2(d,e,a,b,c,32); R2(c,d,e,a,b,33); R2(b,c,d,e,a,34); R2(a,b,c,d,e,35);
-	R2(e,a,b,c,d,36); R2(d,e,a,b,c,37); R2(c,d,e,a,b,38); R2(b,c,d,e,a,39);
-	R3(a,b,c,d,e,40); R3(e,a,b,c,d,41); R3(d,e,a,b,c,42); R3(c,d,e,a,b,43);
-	R3(b,c,d,e,a,44); R3(a,b,c,d,e,45); R3(e,a,b,c,d,46); R3(d,e,a,b,c,47);
-	R3(c,d,e,a,b,48); R3(b,c,d,e,a,49); R3(a,b,c,d,e,50); R3(e,a,b,c,d,51);
-	R3(d,e,a,b,c,52); R3(c,d,e,a,b,53); R3(b,c,d,e,a,54); R3(a,b,c,d,e,55);
-	R3(e,a,b,c,d,56); R3(d,e,a,b,c,57); R3(c,d,e,a,b,58); R3(b,c,d,e,a,59);
-	R4(a,b,c,d,e,60); R4(e,a,b,c,d,61); R4(d,e,a,b,c,62); R4(c,d,e,a,b,63);
-	R4(b,c,d,e,a,64); R4(a,b,c,d,e,65); R4(e,a,b,c,d,66); R4(d,e,a,b,c,67);
-	R4(c,d,e,a,b,68); R4(b,c,d,e,a,69); R4(a,b,c,d,e,70); R4(e,a,b,c,d,71);
-	R4(d,e,a,b,c,72); R4(c,d,e,a,b,73); R4(b,c,d,e,a,74); R4(a,b,c,d,e,75);
-	R4(e,a,b,c,d,76); R4(d,e,a,b,c,77); R4(c,d,e,a,b,78); R4(b,c,d,e,a,79);
-
-	// Add the working vars back into state[]
-	state[0] += a;
-	state[1] += b;
-	state[2] += c;
-	state[3] += d;
-	state[4] += e;
-
-	// Wipe variables
-	a = 0; b = 0; c = 0; d = 0; e = 0;
+	// Keep the chaining values in registers across consecutive blocks
+	uint32_t s0 = state[0], s1 = state[1], s2 = state[2], s3 = state[3], s4 = state[4];
+
+	for (; numBlocks > 0; --numBlocks, buffer += 64)
+	{
+		// Load the whole block as big endian words before the rounds start
+		// This is a straight gather + byte swap the compiler can vectorize and it works on any endianness
+		uint32_t W[16];
+
+		for (int i = 0; i < 16; ++i)
+			W[i] = ((uint32_t)buffer[i * 4] << 24) | ((uint32_t)buffer[i * 4 + 1] << 16) | ((uint32_t)buffer[i * 4 + 2] << 8) | (uint32_t)buffer[i * 4 + 3];
+
+		uint32_t a = s0, b = s1, c = s2, d = s3, e = s4;
+
+		// 4 rounds of 20 operations each. Loop unrolled.
+		R0(a,b,c,d,e, 0); R0(e,a,b,c,d, 1); R0(d,e,a,b,c, 2); R0(c,d,e,a,b, 3);
+		R0(b,c,d,e,a, 4); R0(a,b,c,d,e, 5); R0(e,a,b,c,d, 6); R0(d,e,a,b,c, 7);
+		R0(c,d,e,a,b, 8); R0(b,c,d,e,a, 9); R0(a,b,c,d,e,10); R0(e,a,b,c,d,11);
+		R0(d,e,a,b,c,12); R0(c,d,e,a,b,13); R0(b,c,d,e,a,14); R0(a,b,c,d,e,15);
+		R1(e,a,b,c,d,16); R1(d,e,a,b,c,17); R1(c,d,e,a,b,18); R1(b,c,d,e,a,19);
+		R2(a,b,c,d,e,20); R2(e,a,b,c,d,21); R2(d,e,a,b,c,22); R2(c,d,e,a,b,23);
+		R2(b,c,d,e,a,24); R2(a,b,c,d,e,25); R2(e,a,b,c,d,26); R2(d,e,a,b,c,27);
+		R2(c,d,e,a,b,28); R2(b,c,d,e,a,29); R2(a,b,c,d,e,30); R2(e,a,b,c,d,31);
+		R2(d,e,a,b,c,32); R2(c,d,e,a,b,33); R2(b,c,d,e,a,34); R2(a,b,c,d,e,35);
+		R2(e,a,b,c,d,36); R2(d,e,a,b,c,37); R2(c,d,e,a,b,38); R2(b,c,d,e,a,39);
+		R3(a,b,c,d,e,40); R3(e,a,b,c,d,41); R3(d,e,a,b,c,42); R3(c,d,e,a,b,43);
+		R3(b,c,d,e,a,44); R3(a,b,c,d,e,45); R3(e,a,b,c,d,46); R3(d,e,a,b,c,47);
+		R3(c,d,e,a,b,48); R3(b,c,d,e,a,49); R3(a,b,c,d,e,50); R3(e,a,b,c,d,51);
+		R3(d,e,a,b,c,52); R3(c,d,e,a,b,53); R3(b,c,d,e,a,54); R3(a,b,c,d,e,55);
+		R3(e,a,b,c,d,56); R3(d,e,a,b,c,57); R3(c,d,e,a,b,58); R3(b,c,d,e,a,59);
+		R4(a,b,c,d,e,60); R4(e,a,b,c,d,61); R4(d,e,a,b,c,62); R4(c,d,e,a,b,63);
+		R4(b,c,d,e,a,64); R4(a,b,c,d,e,65); R4(e,a,b,c,d,66); R4(d,e,a,b,c,67);
+		R4(c,d,e,a,b,68); R4(b,c,d,e,a,69); R4(a,b,c,d,e,70); R4(e,a,b,c,d,71);
+		R4(d,e,a,b,c,72); R4(c,d,e,a,b,73); R4(b,c,d,e,a,74); R4(a,b,c,d,e,75);
+		R4(e,a,b,c,d,76); R4(d,e,a,b,c,77); R4(c,d,e,a,b,78); R4(b,c,d,e,a,79);
+
+		// Add the working vars back into the chaining values
+		s0 += a;
+		s1 += b;
+		s2 += c;
+		s3 += d;
+		s4 += e;
+	}
+
+	state[0] = s0;
+	state[1] = s1;
+	state[2] = s2;
+	state[3] = s3;
+	state[4] = s4;
 }
 
 // Use this function to hash in binary data and strings
-void CSHA1::Update(unsigned char* data, unsigned int len)
+void CSHA1::Update(const unsigned char* data, unsigned int len)
 {
 	uint32_t i = 0, j = 0;
 
@@ -106,13 +123,14 @@ void CSHA1::Update(unsigned char* data, unsigned int len)
 
 	if((j + len) > 63)
 	{
+		// Complete the partially filled buffer first
 		memcpy(&m_buffer[j], data, (i = 64 - j));
-		Transform(m_state, m_buffer);
+		Transform(m_state, m_buffer, 1);
 
-		for (; i+63 < len; i += 64)
-		{
-			Transform(m_state, &data[i]);
-		}
+		// Then process every remaining whole block straight from the caller's data
+		uint32_t numBlocks = (len - i) / 64;
+		Transform(m_state, &data[i], numBlocks);
+		i += numBlocks * 64;
 
 		j = 0;
 	}
@@ -123,72 +141,50 @@ void CSHA1::Update(unsigned char* data, unsigned int len)
 
 void CSHA1::Final()
 {
-	uint32_t i = 0, j = 0;
 	unsigned char finalcount[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
 
-	for (i = 0; i < 8; ++i)
+	for (uint32_t i = 0; i < 8; ++i)
 		finalcount[i] = (unsigned char)((m_count[(i >= 4 ? 0 : 1)]
 			>> ((3 - (i & 3)) * 8) ) & 255); // Endian independent
 
-	Update((unsigned char *)"\200", 1);
-
-	while ((m_count[0] & 504) != 448)
-		Update((unsigned char *)"\0", 1);
+	// Pad with 0x80 then zeroes up to 56 bytes mod 64 in a single update
+	static const unsigned char padding[64] = { 0x80 };
+	uint32_t used = (m_count[0] >> 3) & 63;
+	Update(padding, used < 56 ? 56 - used : 120 - used);
 
 	Update(finalcount, 8); // Cause a SHA1Transform()
 
-	for (i = 0; i < 20; ++i)
+	for (uint32_t i = 0; i < 20; ++i)
 	{
 		m_digest[i] = (unsigned char)((m_state[i >> 2] >> ((3 - (i & 3)) * 8) ) & 255);
 	}
 
 	// Wipe variables for security reasons
-	i = 0; j = 0;
 	memset(m_buffer, 0, 64);
 	memset(m_state, 0, 20);
 	memset(m_count, 0, 8);
-	memset(finalcount, 0, 8);
+}
 
-	Transform(m_state, m_buffer);
+// Get the raw message digest
+void CSHA1::GetHash(unsigned char *uDest)
+{
+	memcpy(uDest, m_digest, 20);
 }
 
-// Get the final hash as a pre-formatted string
-void CSHA1::ReportHash(char *szReport, unsigned char uReportType)
+void CSHA1::Hash(const unsigned char *data, size_t len, unsigned char *uDest)
 {
-	/*
+	CSHA1 SHA;
 
-	unsigned char i = 0;
-	char szTemp[4];
+	// Update takes 32 bit lengths, feed huge buffers in pieces
 
-	if(uReportType == REPORT_HEX)
-	{
-		sprintf(szTemp, "%02x", m_digest[0]);
-		strcat(szReport, szTemp);
-
-		for(i = 1; i < 20; ++i)
-		{
-			sprintf(szTemp, "%02x", m_digest[i]);
-			strcat(szReport, szTemp);
-		}
-	}
-	else if(uReportType == REPORT_DIGIT)
+	while (len > 0x10000000)
 	{
-		sprintf(szTemp, "%u", m_digest[0]);
-		strcat(szReport, szTemp);
-
-		for(i = 1; i < 20; ++i)
-		{
-			sprintf(szTemp, " %u", m_digest[i]);
-			strcat(szReport, szTemp);
-		}
+		SHA.Update(data, 0x10000000);
+		data += 0x10000000;
+		len -= 0x10000000;
 	}
-	else strcpy(szReport, "Error: Unknown report type!");
 
-	*/
-}
-
-// Get the raw message digest
-void CSHA1::GetHash(unsigned char *uDest)
-{
-	memcpy(uDest, m_digest, 20);
+	SHA.Update(data, (unsigned int)len);
+	SHA.Final();
+	SHA.GetHash(uDest);
 }
@@ -19,7 +19,7 @@
 #ifndef ___SHA1_H___
 #define ___SHA1_H___
 
-#include <stdio.h> // Needed for file access
+#include <stddef.h>
 #include <memory.h> // Needed for memset and memcpy
 #include <string.h> // Needed for strcat and strcpy
 
@@ -32,39 +32,17 @@
   #include <stdint.h>
 #endif
 
-#define MAX_FILE_READ_BUFFER 8000
+//
+// CSHA1
+//
+// each CSHA1 object is an independent streaming context (Reset, Update..., Final, GetHash)
+// there is no shared state between objects so any thread can hash in parallel as long as it uses its own context
+// use CSHA1 :: Hash for one shot hashing of a single buffer
+//
 
 class CSHA1
 {
 public:
-	// Rotate x bits to the left
-	#define ROL32(value, bits) (((value)<<(bits))|((value)>>(32-(bits))))
-
-	#ifdef GHOST_BIG_ENDIAN
-		#define SHABLK0(i) (block->l[i])
-	#else
-		#define SHABLK0(i) (block->l[i] = (ROL32(block->l[i],24) & 0xFF00FF00) \
-			| (ROL32(block->l[i],8) & 0x00FF00FF))
-	#endif
-
-	#define SHABLK(i) (block->l[i&15] = ROL32(block->l[(i+13)&15] ^ block->l[(i+8)&15] \
-		^ block->l[(i+2)&15] ^ block->l[i&15],1))
-
-	// SHA-1 rounds
-	#define R0(v,w,x,y,z,i) { z+=((w&(x^y))^y)+SHABLK0(i)+0x5A827999+ROL32(v,5); w=ROL32(w,30); }
-	#define R1(v,w,x,y,z,i) { z+=((w&(x^y))^y)+SHABLK(i)+0x5A827999+ROL32(v,5); w=ROL32(w,30); }
-	#define R2(v,w,x,y,z,i) { z+=(w^x^y)+SHABLK(i)+0x6ED9EBA1+ROL32(v,5); w=ROL32(w,30); }
-	#define R3(v,w,x,y,z,i) { z+=(((w|x)&y)|(w&x))+SHABLK(i)+0x8F1BBCDC+ROL32(v,5); w=ROL32(w,30); }
-	#define R4(v,w,x,y,z,i) { z+=(w^x^y)+SHABLK(i)+0xCA62C1D6+ROL32(v,5); w=ROL32(w,30); }
-
-	typedef union {
-		unsigned char c[64];
-		uint32_t l[16];
-	} SHA1_WORKSPACE_BLOCK;
-
-	// Two different formats for ReportHash(...)
-	enum { REPORT_HEX = 0, REPORT_DIGIT = 1 };
-
 	// Constructor and Destructor
 	CSHA1();
 	virtual ~CSHA1();
@@ -77,16 +55,18 @@ public:
 	void Reset();
 
 	// Update the hash value
-	void Update(unsigned char* data, unsigned int len);
+	void Update(const unsigned char* data, unsigned int len);
 
 	// Finalize hash and report
 	void Final();
-	void ReportHash(char *szReport, unsigned char uReportType = REPORT_HEX);
 	void GetHash(unsigned char *uDest);
 
+	// One shot hash of a single buffer, uDest receives 20 bytes
+	static void Hash(const unsigned char *data, size_t len, unsigned char *uDest);
+
 private:
-	// Private SHA-1 transformation
-	void Transform(uint32_t state[5], unsigned char buffer[64]);
+	// Private SHA-1 transformation, processes numBlocks consecutive 64 byte blocks
+	static void Transform(uint32_t state[5], const unsigned char *buffer, size_t numBlocks);
 };
 
 #endif // ___SHA1_H___
@@ -63,6 +63,11 @@ string CSocket :: GetIPString( )
 	return inet_ntoa( m_SIN.sin_addr );
 }
 
+uint32_t CSocket :: GetIPUInt32( )
+{
+	return ntohl( m_SIN.sin_addr.s_addr );
+}
+
 string CSocket :: GetErrorString( )
 {
 	if( !m_HasError )
@@ -226,9 +231,14 @@ void CTCPSocket :: PutBytes( string bytes )
 	m_SendBuffer += bytes;
 }
 
-void CTCPSocket :: PutBytes( BYTEARRAY bytes )
+void CTCPSocket :: PutBytes( const BYTEARRAY &bytes )
+{
+	m_SendBuffer.append( bytes.begin( ), bytes.end( ) );
+}
+
+void CTCPSocket :: PutBytes( const unsigned char *bytes, uint32_t length )
 {
-	m_SendBuffer += string( bytes.begin( ), bytes.end( ) );
+	m_SendBuffer.append( (const char *)bytes, length );
 }
 
 void CTCPSocket :: DoRecv( fd_set *fd )
@@ -786,3 +796,58 @@ void CUDPServer :: RecvFrom( fd_set *fd, struct sockaddr_in *sin, string *messag
 		}
 	}
 }
+
+//
+// CWakeSocket
+//
+
+CWakeSocket :: CWakeSocket( ) : CUDPServer( )
+{
+	if( !Bind( "127.0.0.1", 0 ) )
+		return;
+
+	// find out which port the OS picked so we know where to send the wakeup datagrams
+
+#ifdef WIN32
+	int AddrLen = sizeof( m_SIN );
+#else
+	socklen_t AddrLen = sizeof( m_SIN );
+#endif
+
+	if( getsockname( m_Socket, (struct sockaddr *)&m_SIN, &AddrLen ) == SOCKET_ERROR )
+	{
+		m_HasError = true;
+		m_Error = GetLastError( );
+		CONSOLE_Print( "[WAKESOCKET] error (getsockname) - " + GetErrorString( ) );
+	}
+}
+
+CWakeSocket :: ~CWakeSocket( )
+{
+
+}
+
+void CWakeSocket :: Wake( )
+{
+	// this is called from other threads so we don't touch any state here
+	// if the socket buffer is full there's already a wakeup pending so a failed send doesn't matter
+
+	if( m_Socket == INVALID_SOCKET || m_HasError )
+		return;
+
+	char Signal = 0;
+	sendto( m_Socket, &Signal, 1, 0, (struct sockaddr *)&m_SIN, sizeof( m_SIN ) );
+}
+
+void CWakeSocket :: Drain( fd_set *fd )
+{
+	if( m_Socket == INVALID_SOCKET || m_HasError || !FD_ISSET( m_Socket, fd ) )
+		return;
+
+	// the datagrams carry no data, we only need to empty the queue so the next select( ) blocks again
+
+	char Buffer[64];
+
+	while( recv( m_Socket, Buffer, sizeof( Buffer ), 0 ) > 0 )
+		;
+}
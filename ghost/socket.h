@@ -116,6 +116,7 @@ public:
 	virtual BYTEARRAY GetPort( );
 	virtual BYTEARRAY GetIP( );
 	virtual string GetIPString( );
+	virtual uint32_t GetIPUInt32( );						// host byte order
 	virtual bool HasError( )						{ return m_HasError; }
 	virtual int GetError( )							{ return m_Error; }
 	virtual string GetErrorString( );
@@ -149,7 +150,8 @@ public:
 	virtual bool GetConnected( )				{ return m_Connected; }
 	virtual string *GetBytes( )					{ return &m_RecvBuffer; }
 	virtual void PutBytes( string bytes );
-	virtual void PutBytes( BYTEARRAY bytes );
+	virtual void PutBytes( const BYTEARRAY &bytes );
+	virtual void PutBytes( const unsigned char *bytes, uint32_t length );
 	virtual void ClearRecvBuffer( )				{ m_RecvBuffer.clear( ); }
 	virtual void ClearSendBuffer( )				{ m_SendBuffer.clear( ); }
 	virtual uint32_t GetLastRecv( )				{ return m_LastRecv; }
@@ -229,4 +231,21 @@ public:
 	virtual void RecvFrom( fd_set *fd, struct sockaddr_in *sin, string *message );
 };
 
+//
+// CWakeSocket
+//
+
+// a UDP socket bound to an ephemeral loopback port which sends datagrams to itself
+// include it in a select( ) set and call Wake from any thread to make that select( ) return early
+
+class CWakeSocket : public CUDPServer
+{
+public:
+	CWakeSocket( );
+	virtual ~CWakeSocket( );
+
+	virtual void Wake( );
+	virtual void Drain( fd_set *fd );
+};
+
 #endif
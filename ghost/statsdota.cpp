@@ -25,21 +25,20 @@
 #include "gameprotocol.h"
 #include "game_base.h"
 #include "stats.h"
+#include "actiondecoder.h"
+#include "dotagamecache.h"
 #include "statsdota.h"
 
 //
 // CStatsDOTA
 //
 
-CStatsDOTA :: CStatsDOTA( CBaseGame *nGame ) : CStats( nGame ), m_Winner( 0 ), m_Min( 0 ), m_Sec( 0 )
+CStatsDOTA :: CStatsDOTA( CBaseGame *nGame ) : CStats( nGame )
 {
 	CONSOLE_Print( "[STATSDOTA] using dota stats" );
 
 	for (unsigned int i = 0; i < 12; ++i)
-	{
-		m_Players[i] = NULL;
 		m_PlayersNames[i] = string();
-	}
 
 	for (unsigned int i = 0; i < 2; ++i)
 		m_TeamsAvgRatings[i] = 1500;
@@ -48,336 +47,135 @@ CStatsDOTA :: CStatsDOTA( CBaseGame *nGame ) : CStats( nGame ), m_Winner( 0 ), m
 
 CStatsDOTA :: ~CStatsDOTA( )
 {
-	for( unsigned int i = 0; i < 12; ++i )
-	{
-		if( m_Players[i] )
-			delete m_Players[i];
-	}
+
 }
 
 bool CStatsDOTA :: ProcessAction( CIncomingAction *Action )
 {
-	unsigned int i = 0;
-	BYTEARRAY *ActionData = Action->GetAction( );
-	BYTEARRAY Data;
-	BYTEARRAY Key;
-	BYTEARRAY Value;
-
-	// dota actions with real time replay data start with 0x6b then the null terminated string "dr.x"
-	// unfortunately more than one action can be sent in a single packet and the length of each action isn't explicitly represented in the packet
-	// so we have to either parse all the actions and calculate the length based on the type or we can search for an identifying sequence
-	// parsing the actions would be more correct but would be a lot more difficult to write for relatively little gain
-	// so we take the easy route (which isn't always guaranteed to work) and search the data for the sequence "6b 64 72 2e 78 00" and hope it identifies an action
-
-	while( ActionData->size( ) >= i + 6 )
+	// more than one action can be sent in a single packet so the decoder walks the whole block and calls OnSyncStored for each one
+
+	CActionDecoder :: Decode( Action->GetPID( ), Action->GetAction( ), Action->GetActionLength( ), this );
+	return m_Winner != 0;
+}
+
+static string AllianceToString( char alliance )
+{
+	if( alliance == '0' )
+		return "Sentinel";
+	else if( alliance == '1' )
+		return "Scourge";
+	else
+		return "unknown";
+}
+
+static string SideToString( char side )
+{
+	if( side == '0' )
+		return "top";
+	else if( side == '1' )
+		return "mid";
+	else if( side == '2' )
+		return "bottom";
+	else
+		return "unknown";
+}
+
+void CStatsDOTA :: OnHeroKill( uint32_t killer, uint32_t victim )
+{
+	CGamePlayer *Killer = m_Game->GetPlayerFromColour( killer );
+	CGamePlayer *Victim = m_Game->GetPlayerFromColour( victim );
+
+	if( Killer && Victim )
+		CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] player [" + Killer->GetName( ) + "] killed player [" + Victim->GetName( ) + "]" );
+	else if( Victim )
 	{
-		if( (*ActionData)[i] == 0x6b && (*ActionData)[i + 1] == 0x64 && (*ActionData)[i + 2] == 0x72 && (*ActionData)[i + 3] == 0x2e && (*ActionData)[i + 4] == 0x78 && (*ActionData)[i + 5] == 0x00 )
-		{
-			// we think we've found an action with real time replay data (but we can't be 100% sure)
-			// next we parse out two null terminated strings and a 4 byte integer
+		if( killer == 0 )
+			CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] the Sentinel killed player [" + Victim->GetName( ) + "]" );
+		else if( killer == 6 )
+			CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] the Scourge killed player [" + Victim->GetName( ) + "]" );
+	}
+}
 
-			if( ActionData->size( ) >= i + 7 )
-			{
-				// the first null terminated string should either be the strings "Data" or "Global" or a player id in ASCII representation, e.g. "1" or "2"
+void CStatsDOTA :: OnCourierKill( uint32_t killer, uint32_t owner )
+{
+	CGamePlayer *Killer = m_Game->GetPlayerFromColour( killer );
+	CGamePlayer *Victim = m_Game->GetPlayerFromColour( owner );
+
+	if( Killer && Victim )
+		CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] player [" + Killer->GetName( ) + "] killed a courier owned by player [" + Victim->GetName( ) + "]" );
+	else if( Victim )
+	{
+		if( killer == 0 )
+			CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] the Sentinel killed a courier owned by player [" + Victim->GetName( ) + "]" );
+		else if( killer == 6 )
+			CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] the Scourge killed a courier owned by player [" + Victim->GetName( ) + "]" );
+	}
+}
 
-				Data = UTIL_ExtractCString( *ActionData, i + 6 );
+void CStatsDOTA :: OnTowerKill( uint32_t killer, char alliance, char level, char side )
+{
+	CGamePlayer *Killer = m_Game->GetPlayerFromColour( killer );
+	string Level( 1, level );
+	string AllianceString = AllianceToString( alliance );
+	string SideString = SideToString( side );
 
-				if( ActionData->size( ) >= i + 8 + Data.size( ) )
-				{
-					// the second null terminated string should be the key
+	if( Killer )
+		CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] player [" + Killer->GetName( ) + "] destroyed a level [" + Level + "] " + AllianceString + " tower (" + SideString + ")" );
+	else
+	{
+		if( killer == 0 )
+			CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] the Sentinel destroyed a level [" + Level + "] " + AllianceString + " tower (" + SideString + ")" );
+		else if( killer == 6 )
+			CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] the Scourge destroyed a level [" + Level + "] " + AllianceString + " tower (" + SideString + ")" );
+	}
+}
 
-					Key = UTIL_ExtractCString( *ActionData, i + 7 + Data.size( ) );
+void CStatsDOTA :: OnRaxKill( uint32_t killer, char alliance, char side, char type )
+{
+	CGamePlayer *Killer = m_Game->GetPlayerFromColour( killer );
+	string AllianceString = AllianceToString( alliance );
+	string SideString = SideToString( side );
+	string TypeString;
+
+	if( type == '0' )
+		TypeString = "melee";
+	else if( type == '1' )
+		TypeString = "ranged";
+	else
+		TypeString = "unknown";
 
-					if( ActionData->size( ) >= i + 12 + Data.size( ) + Key.size( ) )
-					{
-						// the 4 byte integer should be the value
-
-						Value = BYTEARRAY( ActionData->begin( ) + i + 8 + Data.size( ) + Key.size( ), ActionData->begin( ) + i + 12 + Data.size( ) + Key.size( ) );
-						string DataString = string( Data.begin( ), Data.end( ) );
-						string KeyString = string( Key.begin( ), Key.end( ) );
-						uint32_t ValueInt = UTIL_ByteArrayToUInt32( Value, false );
-
-						// CONSOLE_Print( "[STATS] " + DataString + ", " + KeyString + ", " + UTIL_ToString( ValueInt ) );
-
-						if( DataString == "Data" )
-						{
-							// these are received during the game
-							// you could use these to calculate killing sprees and double or triple kills (you'd have to make up your own time restrictions though)
-							// you could also build a table of "who killed who" data
-
-							if( KeyString.size( ) >= 5 && KeyString.substr( 0, 4 ) == "Hero" )
-							{
-								// a hero died
-
-								string VictimColourString = KeyString.substr( 4 );
-								uint32_t VictimColour = UTIL_ToUInt32( VictimColourString );
-								CGamePlayer *Killer = m_Game->GetPlayerFromColour( ValueInt );
-								CGamePlayer *Victim = m_Game->GetPlayerFromColour( VictimColour );
-
-								if( Killer && Victim )
-									CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] player [" + Killer->GetName( ) + "] killed player [" + Victim->GetName( ) + "]" );
-								else if( Victim )
-								{
-									if( ValueInt == 0 )
-										CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] the Sentinel killed player [" + Victim->GetName( ) + "]" );
-									else if( ValueInt == 6 )
-										CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] the Scourge killed player [" + Victim->GetName( ) + "]" );
-								}
-							}
-							else if( KeyString.size( ) >= 8 && KeyString.substr( 0, 7 ) == "Courier" )
-							{
-								// a courier died
-
-								if( ( ValueInt >= 1 && ValueInt <= 5 ) || ( ValueInt >= 7 && ValueInt <= 11 ) )
-								{
-									if( !m_Players[ValueInt] )
-										m_Players[ValueInt] = new CDBDotAPlayer( );
-
-									m_Players[ValueInt]->SetCourierKills( m_Players[ValueInt]->GetCourierKills( ) + 1 );
-								}
-
-								string VictimColourString = KeyString.substr( 7 );
-								uint32_t VictimColour = UTIL_ToUInt32( VictimColourString );
-								CGamePlayer *Killer = m_Game->GetPlayerFromColour( ValueInt );
-								CGamePlayer *Victim = m_Game->GetPlayerFromColour( VictimColour );
-
-								if( Killer && Victim )
-									CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] player [" + Killer->GetName( ) + "] killed a courier owned by player [" + Victim->GetName( ) + "]" );
-								else if( Victim )
-								{
-									if( ValueInt == 0 )
-										CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] the Sentinel killed a courier owned by player [" + Victim->GetName( ) + "]" );
-									else if( ValueInt == 6 )
-										CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] the Scourge killed a courier owned by player [" + Victim->GetName( ) + "]" );
-								}
-							}
-							else if( KeyString.size( ) >= 8 && KeyString.substr( 0, 5 ) == "Tower" )
-							{
-								// a tower died
-
-								if( ( ValueInt >= 1 && ValueInt <= 5 ) || ( ValueInt >= 7 && ValueInt <= 11 ) )
-								{
-									if( !m_Players[ValueInt] )
-										m_Players[ValueInt] = new CDBDotAPlayer( );
-
-									m_Players[ValueInt]->SetTowerKills( m_Players[ValueInt]->GetTowerKills( ) + 1 );
-								}
-
-								string Alliance = KeyString.substr( 5, 1 );
-								string Level = KeyString.substr( 6, 1 );
-								string Side = KeyString.substr( 7, 1 );
-								CGamePlayer *Killer = m_Game->GetPlayerFromColour( ValueInt );
-								string AllianceString;
-								string SideString;
-
-								if( Alliance == "0" )
-									AllianceString = "Sentinel";
-								else if( Alliance == "1" )
-									AllianceString = "Scourge";
-								else
-									AllianceString = "unknown";
-
-								if( Side == "0" )
-									SideString = "top";
-								else if( Side == "1" )
-									SideString = "mid";
-								else if( Side == "2" )
-									SideString = "bottom";
-								else
-									SideString = "unknown";
-
-								if( Killer )
-									CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] player [" + Killer->GetName( ) + "] destroyed a level [" + Level + "] " + AllianceString + " tower (" + SideString + ")" );
-								else
-								{
-									if( ValueInt == 0 )
-										CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] the Sentinel destroyed a level [" + Level + "] " + AllianceString + " tower (" + SideString + ")" );
-									else if( ValueInt == 6 )
-										CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] the Scourge destroyed a level [" + Level + "] " + AllianceString + " tower (" + SideString + ")" );
-								}
-							}
-							else if( KeyString.size( ) >= 6 && KeyString.substr( 0, 3 ) == "Rax" )
-							{
-								// a rax died
-
-								if( ( ValueInt >= 1 && ValueInt <= 5 ) || ( ValueInt >= 7 && ValueInt <= 11 ) )
-								{
-									if( !m_Players[ValueInt] )
-										m_Players[ValueInt] = new CDBDotAPlayer( );
-
-									m_Players[ValueInt]->SetRaxKills( m_Players[ValueInt]->GetRaxKills( ) + 1 );
-								}
-
-								string Alliance = KeyString.substr( 3, 1 );
-								string Side = KeyString.substr( 4, 1 );
-								string Type = KeyString.substr( 5, 1 );
-								CGamePlayer *Killer = m_Game->GetPlayerFromColour( ValueInt );
-								string AllianceString;
-								string SideString;
-								string TypeString;
-
-								if( Alliance == "0" )
-									AllianceString = "Sentinel";
-								else if( Alliance == "1" )
-									AllianceString = "Scourge";
-								else
-									AllianceString = "unknown";
-
-								if( Side == "0" )
-									SideString = "top";
-								else if( Side == "1" )
-									SideString = "mid";
-								else if( Side == "2" )
-									SideString = "bottom";
-								else
-									SideString = "unknown";
-
-								if( Type == "0" )
-									TypeString = "melee";
-								else if( Type == "1" )
-									TypeString = "ranged";
-								else
-									TypeString = "unknown";
-
-								if( Killer )
-									CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] player [" + Killer->GetName( ) + "] destroyed a " + TypeString + " " + AllianceString + " rax (" + SideString + ")" );
-								else
-								{
-									if( ValueInt == 0 )
-										CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] the Sentinel destroyed a " + TypeString + " " + AllianceString + " rax (" + SideString + ")" );
-									else if( ValueInt == 6 )
-										CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] the Scourge destroyed a " + TypeString + " " + AllianceString + " rax (" + SideString + ")" );
-								}
-							}
-							else if( KeyString.size( ) >= 6 && KeyString.substr( 0, 6 ) == "Throne" )
-							{
-								// the frozen throne got hurt
-
-								CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] the Frozen Throne is now at " + UTIL_ToString( ValueInt ) + "% HP" );
-							}
-							else if( KeyString.size( ) >= 4 && KeyString.substr( 0, 4 ) == "Tree" )
-							{
-								// the world tree got hurt
-
-								CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] the World Tree is now at " + UTIL_ToString( ValueInt ) + "% HP" );
-							}
-							else if( KeyString.size( ) >= 2 && KeyString.substr( 0, 2 ) == "CK" )
-							{
-								// a player disconnected
-							}
-						}
-						else if( DataString == "Global" )
-						{
-							// these are only received at the end of the game
-
-							if( KeyString == "Winner" )
-							{
-								// Value 1 -> sentinel
-								// Value 2 -> scourge
-
-								m_Winner = ValueInt;
-
-								if( m_Winner == 1 )
-									CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] detected winner: Sentinel" );
-								else if( m_Winner == 2 )
-									CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] detected winner: Scourge" );
-								else
-									CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] detected winner: " + UTIL_ToString( ValueInt ) );
-							}
-							else if( KeyString == "m" )
-								m_Min = ValueInt;
-							else if( KeyString == "s" )
-								m_Sec = ValueInt;
-						}
-						else if( DataString.size( ) <= 2 && DataString.find_first_not_of( "1234567890" ) == string :: npos )
-						{
-							// these are only received at the end of the game
-
-							uint32_t ID = UTIL_ToUInt32( DataString );
-
-							if( ( ID >= 1 && ID <= 5 ) || ( ID >= 7 && ID <= 11 ) )
-							{
-								if( !m_Players[ID] )
-								{
-									m_Players[ID] = new CDBDotAPlayer( );
-									m_Players[ID]->SetColour( ID );
-								}
-
-								// Key "1"		-> Kills
-								// Key "2"		-> Deaths
-								// Key "3"		-> Creep Kills
-								// Key "4"		-> Creep Denies
-								// Key "5"		-> Assists
-								// Key "6"		-> Current Gold
-								// Key "7"		-> Neutral Kills
-								// Key "8_0"	-> Item 1
-								// Key "8_1"	-> Item 2
-								// Key "8_2"	-> Item 3
-								// Key "8_3"	-> Item 4
-								// Key "8_4"	-> Item 5
-								// Key "8_5"	-> Item 6
-								// Key "id"		-> ID (1-5 for sentinel, 6-10 for scourge, accurate after using -sp and/or -switch)
-
-								if( KeyString == "1" )
-									m_Players[ID]->SetKills( ValueInt );
-								else if( KeyString == "2" )
-									m_Players[ID]->SetDeaths( ValueInt );
-								else if( KeyString == "3" )
-									m_Players[ID]->SetCreepKills( ValueInt );
-								else if( KeyString == "4" )
-									m_Players[ID]->SetCreepDenies( ValueInt );
-								else if( KeyString == "5" )
-									m_Players[ID]->SetAssists( ValueInt );
-								else if( KeyString == "6" )
-									m_Players[ID]->SetGold( ValueInt );
-								else if( KeyString == "7" )
-									m_Players[ID]->SetNeutralKills( ValueInt );
-								else if( KeyString == "8_0" )
-									m_Players[ID]->SetItem( 0, string( Value.rbegin( ), Value.rend( ) ) );
-								else if( KeyString == "8_1" )
-									m_Players[ID]->SetItem( 1, string( Value.rbegin( ), Value.rend( ) ) );
-								else if( KeyString == "8_2" )
-									m_Players[ID]->SetItem( 2, string( Value.rbegin( ), Value.rend( ) ) );
-								else if( KeyString == "8_3" )
-									m_Players[ID]->SetItem( 3, string( Value.rbegin( ), Value.rend( ) ) );
-								else if( KeyString == "8_4" )
-									m_Players[ID]->SetItem( 4, string( Value.rbegin( ), Value.rend( ) ) );
-								else if( KeyString == "8_5" )
-									m_Players[ID]->SetItem( 5, string( Value.rbegin( ), Value.rend( ) ) );
-								else if( KeyString == "9" )
-									m_Players[ID]->SetHero( string( Value.rbegin( ), Value.rend( ) ) );
-								else if( KeyString == "id" )
-								{
-									// DotA sends id values from 1-10 with 1-5 being sentinel players and 6-10 being scourge players
-									// unfortunately the actual player colours are from 1-5 and from 7-11 so we need to deal with this case here
-
-									if( ValueInt >= 6 )
-										m_Players[ID]->SetNewColour( ValueInt + 1 );
-									else
-										m_Players[ID]->SetNewColour( ValueInt );
-								}
-							}
-						}
-
-						i += 12 + Data.size( ) + Key.size( );
-					}
-					else
-						++i;
-				}
-				else
-					++i;
-			}
-			else
-				++i;
-		}
-		else
-			++i;
+	if( Killer )
+		CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] player [" + Killer->GetName( ) + "] destroyed a " + TypeString + " " + AllianceString + " rax (" + SideString + ")" );
+	else
+	{
+		if( killer == 0 )
+			CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] the Sentinel destroyed a " + TypeString + " " + AllianceString + " rax (" + SideString + ")" );
+		else if( killer == 6 )
+			CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] the Scourge destroyed a " + TypeString + " " + AllianceString + " rax (" + SideString + ")" );
 	}
+}
 
-	return m_Winner != 0;
+void CStatsDOTA :: OnThroneHP( uint32_t percent )
+{
+	CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] the Frozen Throne is now at " + UTIL_ToString( percent ) + "% HP" );
+}
+
+void CStatsDOTA :: OnTreeHP( uint32_t percent )
+{
+	CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] the World Tree is now at " + UTIL_ToString( percent ) + "% HP" );
+}
+
+void CStatsDOTA :: OnWinner( uint32_t winner )
+{
+	if( winner == 1 )
+		CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] detected winner: Sentinel" );
+	else if( winner == 2 )
+		CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] detected winner: Scourge" );
+	else
+		CONSOLE_Print( "[STATSDOTA: " + m_Game->GetGameName( ) + "] detected winner: " + UTIL_ToString( winner ) );
 }
 
-void CStatsDOTA :: Save( CGHost *GHost, CGHostDB *DB, uint32_t GameID, bool UpdatePlayerStats = false )
+void CStatsDOTA :: Save( CGHost *GHost, CGHostDB *DB, uint32_t GameID, bool UpdatePlayerStats )
 {
 	if( DB->Begin( ) )
 	{
@@ -392,7 +190,7 @@ void CStatsDOTA :: Save( CGHost *GHost, CGHostDB *DB, uint32_t GameID, bool Upda
 
 		// save the dotagame
 
-		GHost->m_Callables.push_back( DB->ThreadedDotAGameAdd( GameID, m_Winner, m_Min, m_Sec ) );
+		GHost->m_Callables->Add( DB->ThreadedDotAGameAdd( GameID, m_Winner, m_Min, m_Sec ) );
 
 		// check for invalid colours and duplicates
 		// this can only happen if DotA sends us garbage in the "id" value but we should check anyway
@@ -440,9 +238,9 @@ void CStatsDOTA :: Save( CGHost *GHost, CGHostDB *DB, uint32_t GameID, bool Upda
 					//Copy data because it's possible that they will get deleted from memory before getting submitted.
 					CDBDotAGame* DotaGame = new CDBDotAGame(0, 0, m_Winner, m_Min, m_Sec);
 					CDBDotAPlayer *DotaPlayer = new CDBDotAPlayer(0, m_Players[i]->GetGameID(), m_Players[i]->GetColour(), m_Players[i]->GetKills(), m_Players[i]->GetDeaths(), m_Players[i]->GetCreepKills(), m_Players[i]->GetCreepDenies(), m_Players[i]->GetAssists(), m_Players[i]->GetGold(), m_Players[i]->GetNeutralKills(), m_Players[i]->GetItem(0), m_Players[i]->GetItem(1), m_Players[i]->GetItem(2), m_Players[i]->GetItem(3), m_Players[i]->GetItem(4), m_Players[i]->GetItem(5), m_Players[i]->GetHero(), m_Players[i]->GetNewColour(), m_Players[i]->GetTowerKills(), m_Players[i]->GetRaxKills(), m_Players[i]->GetCourierKills());
-					GHost->m_Callables.push_back(DB->ThreadedDotAPlayerStatsUpdate(string(), m_PlayersNames[i], DotaPlayer, DotaGame, 1500, m_Players[i]->GetNewColour() > 5 ? m_TeamsAvgRatings[0] : m_TeamsAvgRatings[1])); //Player->GetSpoofedRealm() should be the entered as servername param
+					GHost->m_Callables->Add(DB->ThreadedDotAPlayerStatsUpdate(string(), m_PlayersNames[i], DotaPlayer, DotaGame, 1500, m_Players[i]->GetNewColour() > 5 ? m_TeamsAvgRatings[0] : m_TeamsAvgRatings[1])); //Player->GetSpoofedRealm() should be the entered as servername param
 				}
-				GHost->m_Callables.push_back( DB->ThreadedDotAPlayerAdd( GameID, m_Players[i]->GetColour( ), m_Players[i]->GetKills( ), m_Players[i]->GetDeaths( ), m_Players[i]->GetCreepKills( ), m_Players[i]->GetCreepDenies( ), m_Players[i]->GetAssists( ), m_Players[i]->GetGold( ), m_Players[i]->GetNeutralKills( ), m_Players[i]->GetItem( 0 ), m_Players[i]->GetItem( 1 ), m_Players[i]->GetItem( 2 ), m_Players[i]->GetItem( 3 ), m_Players[i]->GetItem( 4 ), m_Players[i]->GetItem( 5 ), m_Players[i]->GetHero( ), m_Players[i]->GetNewColour( ), m_Players[i]->GetTowerKills( ), m_Players[i]->GetRaxKills( ), m_Players[i]->GetCourierKills( ) ) );			
+				GHost->m_Callables->Add( DB->ThreadedDotAPlayerAdd( GameID, m_Players[i]->GetColour( ), m_Players[i]->GetKills( ), m_Players[i]->GetDeaths( ), m_Players[i]->GetCreepKills( ), m_Players[i]->GetCreepDenies( ), m_Players[i]->GetAssists( ), m_Players[i]->GetGold( ), m_Players[i]->GetNeutralKills( ), m_Players[i]->GetItem( 0 ), m_Players[i]->GetItem( 1 ), m_Players[i]->GetItem( 2 ), m_Players[i]->GetItem( 3 ), m_Players[i]->GetItem( 4 ), m_Players[i]->GetItem( 5 ), m_Players[i]->GetHero( ), m_Players[i]->GetNewColour( ), m_Players[i]->GetTowerKills( ), m_Players[i]->GetRaxKills( ), m_Players[i]->GetCourierKills( ) ) );			
 				++Players;
 			}
 		}
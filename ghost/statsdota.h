@@ -25,16 +25,8 @@
 // CStatsDOTA
 //
 
-class CDBDotAPlayer;
-
-class CStatsDOTA : public CStats
+class CStatsDOTA : public CStats, public CDotAGameCache
 {
-private:
-	CDBDotAPlayer *m_Players[12];
-	uint32_t m_Winner;
-	uint32_t m_Min;
-	uint32_t m_Sec;
-
 public:
 	string m_PlayersNames[12];
 	uint32_t m_TeamsAvgRatings[2];
@@ -44,6 +36,14 @@ public:
 
 	virtual bool ProcessAction( CIncomingAction *Action );
 	virtual void Save( CGHost *GHost, CGHostDB *DB, uint32_t GameID, bool UpdatePlayerStats = false );
+
+	virtual void OnHeroKill( uint32_t killer, uint32_t victim );
+	virtual void OnCourierKill( uint32_t killer, uint32_t owner );
+	virtual void OnTowerKill( uint32_t killer, char alliance, char level, char side );
+	virtual void OnRaxKill( uint32_t killer, char alliance, char side, char type );
+	virtual void OnThroneHP( uint32_t percent );
+	virtual void OnTreeHP( uint32_t percent );
+	virtual void OnWinner( uint32_t winner );
 };
 
 #endif
@@ -23,6 +23,7 @@
 #include "ghostdb.h"
 #include "gameprotocol.h"
 #include "game_base.h"
+#include "actiondecoder.h"
 #include "stats.h"
 #include "statsw3mmd.h"
 
@@ -30,7 +31,7 @@
 // CStatsW3MMD
 //
 
-CStatsW3MMD :: CStatsW3MMD( CBaseGame *nGame, string nCategory ) : CStats( nGame ), m_Category( nCategory ), m_NextValueID( 0 ), m_NextCheckID( 0 )
+CStatsW3MMD :: CStatsW3MMD( CBaseGame *nGame, string nCategory ) : CStats( nGame ), m_Category( nCategory ), m_NextValueID( 0 ), m_NextCheckID( 0 ), m_PIDNamed( 0 ), m_FlagsLeaver( 0 ), m_FlagsPracticing( 0 ), m_NumTokens( 0 )
 {
 	CONSOLE_Print( "[STATSW3MMD] using Warcraft 3 Map Meta Data stats parser version 1" );
 	CONSOLE_Print( "[STATSW3MMD] using map_statsw3mmdcategory [" + nCategory + "]" );
@@ -43,322 +44,316 @@ CStatsW3MMD :: ~CStatsW3MMD( )
 
 bool CStatsW3MMD :: ProcessAction( CIncomingAction *Action )
 {
-	unsigned int i = 0;
-	BYTEARRAY *ActionData = Action->GetAction( );
-	BYTEARRAY MissionKey;
-	BYTEARRAY Key;
-	BYTEARRAY Value;
+	// W3MMD messages are SyncStoredInteger actions (0x6B) on the game cache "MMD.Dat", the decoder calls OnSyncStored for each one
 
-	while( ActionData->size( ) >= i + 9 )
+	CActionDecoder :: Decode( Action->GetPID( ), Action->GetAction( ), Action->GetActionLength( ), this );
+	return false;
+}
+
+void CStatsW3MMD :: OnSyncStored( unsigned char pid, unsigned char actionID, const char *file, const char *missionKey, const char *key, uint32_t value )
+{
+	if( actionID != W3GACTION_SYNCSTOREDINTEGER || strcmp( file, "MMD.Dat" ) != 0 )
+		return;
+
+	// the mission key and key point into the action data, the 4 byte value isn't used by W3MMD version 1
+
+	if( strncmp( missionKey, "val:", 4 ) == 0 && missionKey[4] != 0 )
+	{
+		ProcessValue( (const unsigned char *)key, strlen( key ) );
+		++m_NextValueID;
+	}
+	else if( strncmp( missionKey, "chk:", 4 ) == 0 && missionKey[4] != 0 )
+	{
+		// todotodo: cheat detection
+
+		++m_NextCheckID;
+	}
+	else
+		CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] unknown mission key [" + string( missionKey ) + "] found, ignoring" );
+}
+
+void CStatsW3MMD :: ProcessValue( const unsigned char *key, uint32_t keyLength )
+{
+	if( !TokenizeKey( key, keyLength ) || m_NumTokens == 0 )
+		return;
+
+	string &Type = m_Tokens[0];
+
+	if( Type == "VarP" && m_NumTokens == 5 )
+		ProcessVarP( key, keyLength );
+	else if( Type == "Event" && m_NumTokens >= 2 )
+		ProcessEvent( key, keyLength );
+	else if( Type == "init" && m_NumTokens >= 2 )
 	{
-		if( (*ActionData)[i] == 'k' &&
-			(*ActionData)[i + 1] == 'M' &&
-			(*ActionData)[i + 2] == 'M' &&
-			(*ActionData)[i + 3] == 'D' &&
-			(*ActionData)[i + 4] == '.' &&
-			(*ActionData)[i + 5] == 'D' &&
-			(*ActionData)[i + 6] == 'a' &&
-			(*ActionData)[i + 7] == 't' &&
-			(*ActionData)[i + 8] == 0x00 )
+		if( m_Tokens[1] == "version" && m_NumTokens == 4 )
 		{
-			if( ActionData->size( ) >= i + 10 )
+			// m_Tokens[2] = minimum
+			// m_Tokens[3] = current
+
+			CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] map is using Warcraft 3 Map Meta Data library version [" + m_Tokens[3] + "]" );
+
+			if( UTIL_ToUInt32( m_Tokens[2] ) > 1 )
+				CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] warning - parser version 1 is not compatible with this map, minimum version [" + m_Tokens[2] + "]" );
+		}
+		else if( m_Tokens[1] == "pid" && m_NumTokens == 4 )
+		{
+			// m_Tokens[2] = pid
+			// m_Tokens[3] = name
+
+			uint32_t PID;
+
+			if( GetPID( m_Tokens[2], &PID ) )
 			{
-				MissionKey = UTIL_ExtractCString( *ActionData, i + 9 );
+				if( m_PIDNamed & ( 1U << PID ) )
+					CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] overwriting previous name [" + m_PIDToName[PID] + "] with new name [" + m_Tokens[3] + "] for PID [" + m_Tokens[2] + "]" );
 
-				if( ActionData->size( ) >= i + 11 + MissionKey.size( ) )
+				m_PIDToName[PID] = m_Tokens[3];
+				m_PIDNamed |= 1U << PID;
+			}
+		}
+	}
+	else if( Type == "DefVarP" && m_NumTokens == 5 )
+	{
+		// m_Tokens[1] = name
+		// m_Tokens[2] = value type
+		// m_Tokens[3] = goal type (ignored here)
+		// m_Tokens[4] = suggestion (ignored here)
+
+		if( m_VarIDs.find( m_Tokens[1] ) != m_VarIDs.end( ) )
+			CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] duplicate DefVarP [" + string( key, key + keyLength ) + "] found, ignoring" );
+		else
+		{
+			unsigned char ValueType = 0;
+
+			if( m_Tokens[2] == "int" )
+				ValueType = W3MMD_VALUETYPE_INT;
+			else if( m_Tokens[2] == "real" )
+				ValueType = W3MMD_VALUETYPE_REAL;
+			else if( m_Tokens[2] == "string" )
+				ValueType = W3MMD_VALUETYPE_STRING;
+
+			if( ValueType )
+			{
+				W3MMDVar Var;
+				Var.m_Name = m_Tokens[1];
+				Var.m_ValueType = ValueType;
+				Var.m_Assigned = 0;
+				memset( Var.m_Ints, 0, sizeof( Var.m_Ints ) );
+				memset( Var.m_Reals, 0, sizeof( Var.m_Reals ) );
+
+				if( ValueType == W3MMD_VALUETYPE_STRING )
+					Var.m_Strings.resize( W3MMD_MAX_PIDS );
+
+				m_VarIDs[Var.m_Name] = m_Vars.size( );
+				m_Vars.push_back( Var );
+			}
+			else
+				CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] unknown DefVarP [" + string( key, key + keyLength ) + "] found, ignoring" );
+		}
+	}
+	else if( Type == "FlagP" && m_NumTokens == 3 )
+	{
+		// m_Tokens[1] = pid
+		// m_Tokens[2] = flag
+
+		string &Flag = m_Tokens[2];
+
+		if( Flag == "winner" || Flag == "loser" || Flag == "drawer" || Flag == "leaver" || Flag == "practicing" )
+		{
+			uint32_t PID;
+
+			if( GetPID( m_Tokens[1], &PID ) )
+			{
+				if( Flag == "leaver" )
+					m_FlagsLeaver |= 1U << PID;
+				else if( Flag == "practicing" )
+					m_FlagsPracticing |= 1U << PID;
+				else
 				{
-					Key = UTIL_ExtractCString( *ActionData, i + 10 + MissionKey.size( ) );
-
-					if( ActionData->size( ) >= i + 15 + MissionKey.size( ) + Key.size( ) )
-					{
-						Value = BYTEARRAY( ActionData->begin( ) + i + 11 + MissionKey.size( ) + Key.size( ), ActionData->begin( ) + i + 15 + MissionKey.size( ) + Key.size( ) );
-						string MissionKeyString = string( MissionKey.begin( ), MissionKey.end( ) );
-						string KeyString = string( Key.begin( ), Key.end( ) );
-						uint32_t ValueInt = UTIL_ByteArrayToUInt32( Value, false );
-
-						// CONSOLE_Print( "[STATSW3MMD] DEBUG: mkey [" + MissionKeyString + "], key [" + KeyString + "], value [" + UTIL_ToString( ValueInt ) + "]" );
-
-						if( MissionKeyString.size( ) > 4 && MissionKeyString.substr( 0, 4 ) == "val:" )
-						{
-							string ValueIDString = MissionKeyString.substr( 4 );
-							uint32_t ValueID = UTIL_ToUInt32( ValueIDString );
-							vector<string> Tokens = TokenizeKey( KeyString );
-
-							if( !Tokens.empty( ) )
-							{
-								if( Tokens[0] == "init" && Tokens.size( ) >= 2 )
-								{
-									if( Tokens[1] == "version" && Tokens.size( ) == 4 )
-									{
-										// Tokens[2] = minimum
-										// Tokens[3] = current
-
-										CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] map is using Warcraft 3 Map Meta Data library version [" + Tokens[3] + "]" );
-
-										if( UTIL_ToUInt32( Tokens[2] ) > 1 )
-											CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] warning - parser version 1 is not compatible with this map, minimum version [" + Tokens[2] + "]" );
-									}
-									else if( Tokens[1] == "pid" && Tokens.size( ) == 4 )
-									{
-										// Tokens[2] = pid
-										// Tokens[3] = name
-
-										uint32_t PID = UTIL_ToUInt32( Tokens[2] );
-
-										if( m_PIDToName.find( PID ) != m_PIDToName.end( ) )
-											CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] overwriting previous name [" + m_PIDToName[PID] + "] with new name [" + Tokens[3] + "] for PID [" + Tokens[2] + "]" );
-
-										m_PIDToName[PID] = Tokens[3];
-									}
-								}
-								else if( Tokens[0] == "DefVarP" && Tokens.size( ) == 5 )
-								{
-									// Tokens[1] = name
-									// Tokens[2] = value type
-									// Tokens[3] = goal type (ignored here)
-									// Tokens[4] = suggestion (ignored here)
-
-									if( m_DefVarPs.find( Tokens[1] ) != m_DefVarPs.end( ) )
-										CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] duplicate DefVarP [" + KeyString + "] found, ignoring" );
-									else
-									{
-										if( Tokens[2] == "int" || Tokens[2] == "real" || Tokens[2] == "string" )
-											m_DefVarPs[Tokens[1]] = Tokens[2];
-										else
-											CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] unknown DefVarP [" + KeyString + "] found, ignoring" );
-									}
-
-								}
-								else if( Tokens[0] == "VarP" && Tokens.size( ) == 5 )
-								{
-									// Tokens[1] = pid
-									// Tokens[2] = name
-									// Tokens[3] = operation
-									// Tokens[4] = value
-
-									if( m_DefVarPs.find( Tokens[2] ) == m_DefVarPs.end( ) )
-										CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] VarP [" + KeyString + "] found without a corresponding DefVarP, ignoring" );
-									else
-									{
-										string ValueType = m_DefVarPs[Tokens[2]];
-
-										if( ValueType == "int" )
-										{
-											VarP VP = VarP( UTIL_ToUInt32( Tokens[1] ), Tokens[2] );
-
-											if( Tokens[3] == "=" )
-												m_VarPInts[VP] = UTIL_ToInt32( Tokens[4] );
-											else if( Tokens[3] == "+=" )
-											{
-												if( m_VarPInts.find( VP ) != m_VarPInts.end( ) )
-													m_VarPInts[VP] += UTIL_ToInt32( Tokens[4] );
-												else
-												{
-													// CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] int VarP [" + KeyString + "] found with relative operation [+=] without a previously assigned value, ignoring" );
-													m_VarPInts[VP] = UTIL_ToInt32( Tokens[4] );
-												}
-											}
-											else if( Tokens[3] == "-=" )
-											{
-												if( m_VarPInts.find( VP ) != m_VarPInts.end( ) )
-													m_VarPInts[VP] -= UTIL_ToInt32( Tokens[4] );
-												else
-												{
-													// CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] int VarP [" + KeyString + "] found with relative operation [-=] without a previously assigned value, ignoring" );
-													m_VarPInts[VP] = -UTIL_ToInt32( Tokens[4] );
-												}
-											}
-											else
-												CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] unknown int VarP [" + KeyString + "] operation [" + Tokens[3] + "] found, ignoring" );
-										}
-										else if( ValueType == "real" )
-										{
-											VarP VP = VarP( UTIL_ToUInt32( Tokens[1] ), Tokens[2] );
-
-											if( Tokens[3] == "=" )
-												m_VarPReals[VP] = UTIL_ToDouble( Tokens[4] );
-											else if( Tokens[3] == "+=" )
-											{
-												if( m_VarPReals.find( VP ) != m_VarPReals.end( ) )
-													m_VarPReals[VP] += UTIL_ToDouble( Tokens[4] );
-												else
-												{
-													// CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] real VarP [" + KeyString + "] found with relative operation [+=] without a previously assigned value, ignoring" );
-													m_VarPReals[VP] = UTIL_ToDouble( Tokens[4] );
-												}
-											}
-											else if( Tokens[3] == "-=" )
-											{
-												if( m_VarPReals.find( VP ) != m_VarPReals.end( ) )
-													m_VarPReals[VP] -= UTIL_ToDouble( Tokens[4] );
-												else
-												{
-													// CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] real VarP [" + KeyString + "] found with relative operation [-=] without a previously assigned value, ignoring" );
-													m_VarPReals[VP] = -UTIL_ToDouble( Tokens[4] );
-												}
-											}
-											else
-												CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] unknown real VarP [" + KeyString + "] operation [" + Tokens[3] + "] found, ignoring" );
-										}
-										else
-										{
-											VarP VP = VarP( UTIL_ToUInt32( Tokens[1] ), Tokens[2] );
-
-											if( Tokens[3] == "=" )
-												m_VarPStrings[VP] = Tokens[4];
-											else
-												CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] unknown string VarP [" + KeyString + "] operation [" + Tokens[3] + "] found, ignoring" );
-										}
-									}
-								}
-								else if( Tokens[0] == "FlagP" && Tokens.size( ) == 3 )
-								{
-									// Tokens[1] = pid
-									// Tokens[2] = flag
-
-									if( Tokens[2] == "winner" || Tokens[2] == "loser" || Tokens[2] == "drawer" || Tokens[2] == "leaver" || Tokens[2] == "practicing" )
-									{
-										uint32_t PID = UTIL_ToUInt32( Tokens[1] );
-
-										if( Tokens[2] == "leaver" )
-											m_FlagsLeaver[PID] = true;
-										else if( Tokens[2] == "practicing" )
-											m_FlagsPracticing[PID] = true;
-										else
-										{
-											if( m_Flags.find( PID ) != m_Flags.end( ) )
-												CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] overwriting previous flag [" + m_Flags[PID] + "] with new flag [" + Tokens[2] + "] for PID [" + Tokens[1] + "]" );
-
-											m_Flags[PID] = Tokens[2];
-										}
-									}
-									else
-										CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] unknown flag [" + Tokens[2] + "] found, ignoring" );
-								}
-								else if( Tokens[0] == "DefEvent" && Tokens.size( ) >= 4 )
-								{
-									// Tokens[1] = name
-									// Tokens[2] = # of arguments (n)
-									// Tokens[3..n+3] = arguments
-									// Tokens[n+3] = format
-
-									if( m_DefEvents.find( Tokens[1] ) != m_DefEvents.end( ) )
-										CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] duplicate DefEvent [" + KeyString + "] found, ignoring" );
-									else
-									{
-										uint32_t Arguments = UTIL_ToUInt32( Tokens[2] );
-
-										if( Tokens.size( ) == Arguments + 4 )
-											m_DefEvents[Tokens[1]] = vector<string>( Tokens.begin( ) + 3, Tokens.end( ) );
-									}
-								}
-								else if( Tokens[0] == "Event" && Tokens.size( ) >= 2 )
-								{
-									// Tokens[1] = name
-									// Tokens[2..n+2] = arguments (where n is the # of arguments in the corresponding DefEvent)
-
-									if( m_DefEvents.find( Tokens[1] ) == m_DefEvents.end( ) )
-										CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] Event [" + KeyString + "] found without a corresponding DefEvent, ignoring" );
-									else
-									{
-										vector<string> DefEvent = m_DefEvents[Tokens[1]];
-
-										if( !DefEvent.empty( ) )
-										{
-											string Format = DefEvent[DefEvent.size( ) - 1];
-
-											if( Tokens.size( ) - 2 != DefEvent.size( ) - 1 )
-												CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] Event [" + KeyString + "] found with " + UTIL_ToString( Tokens.size( ) - 2 ) + " arguments but expected " + UTIL_ToString( DefEvent.size( ) - 1 ) + " arguments, ignoring" );
-											else
-											{
-												// replace the markers in the format string with the arguments
-
-												for( uint32_t i = 0; i < Tokens.size( ) - 2; ++i )
-												{
-													// check if the marker is a PID marker
-
-													if( DefEvent[i].substr( 0, 4 ) == "pid:" )
-													{
-														// replace it with the player's name rather than their PID
-
-														uint32_t PID = UTIL_ToUInt32( Tokens[i + 2] );
-
-														if( m_PIDToName.find( PID ) == m_PIDToName.end( ) )
-															UTIL_Replace( Format, "{" + UTIL_ToString( i ) + "}", "PID:" + Tokens[i + 2] );
-														else
-															UTIL_Replace( Format, "{" + UTIL_ToString( i ) + "}", m_PIDToName[PID] );
-													}
-													else
-														UTIL_Replace( Format, "{" + UTIL_ToString( i ) + "}", Tokens[i + 2] );
-												}
-
-												CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] " + Format );
-											}
-										}
-									}
-
-									// CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] event [" + KeyString + "]" );
-								}
-								else if( Tokens[0] == "Blank" )
-								{
-									// ignore
-								}
-								else if( Tokens[0] == "Custom" )
-								{
-									CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] custom [" + KeyString + "]" );
-								}
-								else
-									CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] unknown message type [" + Tokens[0] + "] found, ignoring" );
-							}
-
-							++m_NextValueID;
-						}
-						else if( MissionKeyString.size( ) > 4 && MissionKeyString.substr( 0, 4 ) == "chk:" )
-						{
-							string CheckIDString = MissionKeyString.substr( 4 );
-							uint32_t CheckID = UTIL_ToUInt32( CheckIDString );
-
-							// todotodo: cheat detection
-
-							++m_NextCheckID;
-						}
-						else
-							CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] unknown mission key [" + MissionKeyString + "] found, ignoring" );
-
-						i += 15 + MissionKey.size( ) + Key.size( );
-					}
-					else
-						++i;
+					if( !m_Flags[PID].empty( ) )
+						CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] overwriting previous flag [" + m_Flags[PID] + "] with new flag [" + Flag + "] for PID [" + m_Tokens[1] + "]" );
+
+					m_Flags[PID] = Flag;
 				}
-				else
-					++i;
 			}
+		}
+		else
+			CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] unknown flag [" + Flag + "] found, ignoring" );
+	}
+	else if( Type == "DefEvent" && m_NumTokens >= 4 )
+	{
+		// m_Tokens[1] = name
+		// m_Tokens[2] = # of arguments (n)
+		// m_Tokens[3..n+3] = arguments
+		// m_Tokens[n+3] = format
+
+		if( m_EventIDs.find( m_Tokens[1] ) != m_EventIDs.end( ) )
+			CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] duplicate DefEvent [" + string( key, key + keyLength ) + "] found, ignoring" );
+		else
+		{
+			uint32_t Arguments = UTIL_ToUInt32( m_Tokens[2] );
+
+			if( m_NumTokens == Arguments + 4 )
+			{
+				W3MMDEvent Event;
+				Event.m_Arguments = vector<string>( m_Tokens.begin( ) + 3, m_Tokens.begin( ) + 3 + Arguments );
+				Event.m_Format = m_Tokens[3 + Arguments];
+				m_EventIDs[m_Tokens[1]] = m_Events.size( );
+				m_Events.push_back( Event );
+			}
+		}
+	}
+	else if( Type == "Blank" )
+	{
+		// ignore
+	}
+	else if( Type == "Custom" )
+	{
+		CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] custom [" + string( key, key + keyLength ) + "]" );
+	}
+	else
+		CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] unknown message type [" + Type + "] found, ignoring" );
+}
+
+void CStatsW3MMD :: ProcessVarP( const unsigned char *key, uint32_t keyLength )
+{
+	// m_Tokens[1] = pid
+	// m_Tokens[2] = name
+	// m_Tokens[3] = operation
+	// m_Tokens[4] = value
+
+	map<string,uint32_t> :: iterator VarID = m_VarIDs.find( m_Tokens[2] );
+
+	if( VarID == m_VarIDs.end( ) )
+	{
+		CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] VarP [" + string( key, key + keyLength ) + "] found without a corresponding DefVarP, ignoring" );
+		return;
+	}
+
+	uint32_t PID;
+
+	if( !GetPID( m_Tokens[1], &PID ) )
+		return;
+
+	W3MMDVar &Var = m_Vars[VarID->second];
+	string &Operation = m_Tokens[3];
+	const char *Value = m_Tokens[4].c_str( );
+	bool Assigned = ( Var.m_Assigned & ( 1U << PID ) ) != 0;
+
+	// relative operations on a value that hasn't been assigned yet treat it as zero
+
+	if( Var.m_ValueType == W3MMD_VALUETYPE_INT )
+	{
+		int32_t Current = Assigned ? Var.m_Ints[PID] : 0;
+
+		if( Operation == "=" )
+			Var.m_Ints[PID] = (int32_t)strtol( Value, NULL, 10 );
+		else if( Operation == "+=" )
+			Var.m_Ints[PID] = Current + (int32_t)strtol( Value, NULL, 10 );
+		else if( Operation == "-=" )
+			Var.m_Ints[PID] = Current - (int32_t)strtol( Value, NULL, 10 );
+		else
+		{
+			CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] unknown int VarP [" + string( key, key + keyLength ) + "] operation [" + Operation + "] found, ignoring" );
+			return;
+		}
+	}
+	else if( Var.m_ValueType == W3MMD_VALUETYPE_REAL )
+	{
+		double Current = Assigned ? Var.m_Reals[PID] : 0.0;
+
+		if( Operation == "=" )
+			Var.m_Reals[PID] = strtod( Value, NULL );
+		else if( Operation == "+=" )
+			Var.m_Reals[PID] = Current + strtod( Value, NULL );
+		else if( Operation == "-=" )
+			Var.m_Reals[PID] = Current - strtod( Value, NULL );
+		else
+		{
+			CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] unknown real VarP [" + string( key, key + keyLength ) + "] operation [" + Operation + "] found, ignoring" );
+			return;
+		}
+	}
+	else
+	{
+		if( Operation == "=" )
+			Var.m_Strings[PID].assign( m_Tokens[4] );
+		else
+		{
+			CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] unknown string VarP [" + string( key, key + keyLength ) + "] operation [" + Operation + "] found, ignoring" );
+			return;
+		}
+	}
+
+	Var.m_Assigned |= 1U << PID;
+}
+
+void CStatsW3MMD :: ProcessEvent( const unsigned char *key, uint32_t keyLength )
+{
+	// m_Tokens[1] = name
+	// m_Tokens[2..n+2] = arguments (where n is the # of arguments in the corresponding DefEvent)
+
+	map<string,uint32_t> :: iterator EventID = m_EventIDs.find( m_Tokens[1] );
+
+	if( EventID == m_EventIDs.end( ) )
+	{
+		CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] Event [" + string( key, key + keyLength ) + "] found without a corresponding DefEvent, ignoring" );
+		return;
+	}
+
+	W3MMDEvent &Event = m_Events[EventID->second];
+
+	if( m_NumTokens - 2 != Event.m_Arguments.size( ) )
+	{
+		CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] Event [" + string( key, key + keyLength ) + "] found with " + UTIL_ToString( m_NumTokens - 2 ) + " arguments but expected " + UTIL_ToString( Event.m_Arguments.size( ) ) + " arguments, ignoring" );
+		return;
+	}
+
+	// replace the markers in the format string with the arguments
+
+	string Format = Event.m_Format;
+
+	for( uint32_t i = 0; i < m_NumTokens - 2; ++i )
+	{
+		// check if the marker is a PID marker
+
+		if( Event.m_Arguments[i].compare( 0, 4, "pid:" ) == 0 )
+		{
+			// replace it with the player's name rather than their PID
+
+			uint32_t PID = strtoul( m_Tokens[i + 2].c_str( ), NULL, 10 );
+
+			if( PID >= W3MMD_MAX_PIDS || !( m_PIDNamed & ( 1U << PID ) ) )
+				UTIL_Replace( Format, "{" + UTIL_ToString( i ) + "}", "PID:" + m_Tokens[i + 2] );
 			else
-				++i;
+				UTIL_Replace( Format, "{" + UTIL_ToString( i ) + "}", m_PIDToName[PID] );
 		}
 		else
-			++i;
+			UTIL_Replace( Format, "{" + UTIL_ToString( i ) + "}", m_Tokens[i + 2] );
 	}
 
-	return false;
+	CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] " + Format );
 }
 
-void CStatsW3MMD :: Save( CGHost *GHost, CGHostDB *DB, uint32_t GameID )
+void CStatsW3MMD :: Save( CGHost *GHost, CGHostDB *DB, uint32_t GameID, bool UpdatePlayerStats )
 {
 	CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] received " + UTIL_ToString( m_NextValueID ) + "/" + UTIL_ToString( m_NextCheckID ) + " value/check messages" );
 
 	if( DB->Begin( ) )
 	{
-		// todotodo: there's no reason to create a new callable for each entry in this map
+		// todotodo: there's no reason to create a new callable for each player
 		// rewrite ThreadedW3MMDPlayerAdd to act more like ThreadedW3MMDVarAdd
 
-		for( map<uint32_t,string> :: iterator i = m_PIDToName.begin( ); i != m_PIDToName.end( ); ++i )
+		for( uint32_t PID = 0; PID < W3MMD_MAX_PIDS; ++PID )
 		{
-			string Flags = m_Flags[i->first];
+			if( !( m_PIDNamed & ( 1U << PID ) ) )
+				continue;
+
+			string Flags = m_Flags[PID];
 			uint32_t Leaver = 0;
 			uint32_t Practicing = 0;
 
-			if( m_FlagsLeaver.find( i->first ) != m_FlagsLeaver.end( ) && m_FlagsLeaver[i->first] )
+			if( m_FlagsLeaver & ( 1U << PID ) )
 			{
 				Leaver = 1;
 
@@ -368,7 +363,7 @@ void CStatsW3MMD :: Save( CGHost *GHost, CGHostDB *DB, uint32_t GameID )
 				Flags += "leaver";
 			}
 
-			if( m_FlagsPracticing.find( i->first ) != m_FlagsPracticing.end( ) && m_FlagsPracticing[i->first] )
+			if( m_FlagsPracticing & ( 1U << PID ) )
 			{
 				Practicing = 1;
 
@@ -378,18 +373,40 @@ void CStatsW3MMD :: Save( CGHost *GHost, CGHostDB *DB, uint32_t GameID )
 				Flags += "practicing";
 			}
 
-			CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] recorded flags [" + Flags + "] for player [" + i->second + "] with PID [" + UTIL_ToString( i->first ) + "]" );
-			GHost->m_Callables.push_back( DB->ThreadedW3MMDPlayerAdd( m_Category, GameID, i->first, i->second, m_Flags[i->first], Leaver, Practicing ) );
+			CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] recorded flags [" + Flags + "] for player [" + m_PIDToName[PID] + "] with PID [" + UTIL_ToString( PID ) + "]" );
+			GHost->m_Callables->Add( DB->ThreadedW3MMDPlayerAdd( m_Category, GameID, PID, m_PIDToName[PID], m_Flags[PID], Leaver, Practicing ) );
 		}
 
-		if( !m_VarPInts.empty( ) )
-			GHost->m_Callables.push_back( DB->ThreadedW3MMDVarAdd( GameID, m_VarPInts ) );
+		// flatten the per player arrays into one batch insert per value type
 
-		if( !m_VarPReals.empty( ) )
-			GHost->m_Callables.push_back( DB->ThreadedW3MMDVarAdd( GameID, m_VarPReals ) );
+		map<VarP,int32_t> VarPInts;
+		map<VarP,double> VarPReals;
+		map<VarP,string> VarPStrings;
 
-		if( !m_VarPStrings.empty( ) )
-			GHost->m_Callables.push_back( DB->ThreadedW3MMDVarAdd( GameID, m_VarPStrings ) );
+		for( vector<W3MMDVar> :: iterator i = m_Vars.begin( ); i != m_Vars.end( ); ++i )
+		{
+			for( uint32_t PID = 0; PID < W3MMD_MAX_PIDS; ++PID )
+			{
+				if( !( i->m_Assigned & ( 1U << PID ) ) )
+					continue;
+
+				if( i->m_ValueType == W3MMD_VALUETYPE_INT )
+					VarPInts[VarP( PID, i->m_Name )] = i->m_Ints[PID];
+				else if( i->m_ValueType == W3MMD_VALUETYPE_REAL )
+					VarPReals[VarP( PID, i->m_Name )] = i->m_Reals[PID];
+				else
+					VarPStrings[VarP( PID, i->m_Name )] = i->m_Strings[PID];
+			}
+		}
+
+		if( !VarPInts.empty( ) )
+			GHost->m_Callables->Add( DB->ThreadedW3MMDVarAdd( GameID, VarPInts ) );
+
+		if( !VarPReals.empty( ) )
+			GHost->m_Callables->Add( DB->ThreadedW3MMDVarAdd( GameID, VarPReals ) );
+
+		if( !VarPStrings.empty( ) )
+			GHost->m_Callables->Add( DB->ThreadedW3MMDVarAdd( GameID, VarPStrings ) );
 
 		if( DB->Commit( ) )
 			CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] saving data" );
@@ -400,54 +417,78 @@ void CStatsW3MMD :: Save( CGHost *GHost, CGHostDB *DB, uint32_t GameID )
 		CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] unable to begin database transaction, data not saved" );
 }
 
-vector<string> CStatsW3MMD :: TokenizeKey( string key )
+bool CStatsW3MMD :: TokenizeKey( const unsigned char *key, uint32_t keyLength )
 {
-	vector<string> Tokens;
-	string Token;
+	// tokens are written into the reused m_Tokens buffers, clear( ) keeps their capacity so steady state tokenizing doesn't allocate
+
+	m_NumTokens = 0;
 	bool Escaping = false;
 
-	for( string :: iterator i = key.begin( ); i != key.end( ); ++i )
+	if( m_Tokens.empty( ) )
+		m_Tokens.resize( 8 );
+
+	m_Tokens[0].clear( );
+
+	for( uint32_t i = 0; i < keyLength; ++i )
 	{
+		unsigned char c = key[i];
+
 		if( Escaping )
 		{
-			if( *i == ' ' )
-				Token += ' ';
-			else if( *i == '\\' )
-				Token += '\\';
+			if( c == ' ' || c == '\\' )
+				m_Tokens[m_NumTokens] += c;
 			else
 			{
-				CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] error tokenizing key [" + key + "], invalid escape sequence found, ignoring" );
-				return vector<string>( );
+				CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] error tokenizing key [" + string( key, key + keyLength ) + "], invalid escape sequence found, ignoring" );
+				m_NumTokens = 0;
+				return false;
 			}
 
 			Escaping = false;
 		}
 		else
 		{
-			if( *i == ' ' )
+			if( c == ' ' )
 			{
-				if( Token.empty( ) )
+				if( m_Tokens[m_NumTokens].empty( ) )
 				{
-					CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] error tokenizing key [" + key + "], empty token found, ignoring" );
-					return vector<string>( );
+					CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] error tokenizing key [" + string( key, key + keyLength ) + "], empty token found, ignoring" );
+					m_NumTokens = 0;
+					return false;
 				}
 
-				Tokens.push_back( Token );
-				Token.clear( );
+				++m_NumTokens;
+
+				if( m_NumTokens >= m_Tokens.size( ) )
+					m_Tokens.resize( m_Tokens.size( ) * 2 );
+
+				m_Tokens[m_NumTokens].clear( );
 			}
-			else if( *i == '\\' )
+			else if( c == '\\' )
 				Escaping = true;
 			else
-				Token += *i;
+				m_Tokens[m_NumTokens] += c;
 		}
 	}
 
-	if( Token.empty( ) )
+	if( m_Tokens[m_NumTokens].empty( ) )
 	{
-		CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] error tokenizing key [" + key + "], empty token found, ignoring" );
-		return vector<string>( );
+		CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] error tokenizing key [" + string( key, key + keyLength ) + "], empty token found, ignoring" );
+		m_NumTokens = 0;
+		return false;
 	}
 
-	Tokens.push_back( Token );
-	return Tokens;
+	++m_NumTokens;
+	return true;
+}
+
+bool CStatsW3MMD :: GetPID( const string &token, uint32_t *pid )
+{
+	*pid = strtoul( token.c_str( ), NULL, 10 );
+
+	if( *pid < W3MMD_MAX_PIDS )
+		return true;
+
+	CONSOLE_Print( "[STATSW3MMD: " + m_Game->GetGameName( ) + "] PID [" + token + "] is out of range, ignoring" );
+	return false;
 }
@@ -25,31 +25,69 @@
 // CStatsW3MMD
 //
 
+// the W3MMD pids are the map's player numbers so they're small and dense, values are stored in flat per player arrays indexed by pid
+// pids at or above this limit are ignored (it must stay <= 32 because the per variable "assigned" sets are 32 bit masks)
+
+#define W3MMD_MAX_PIDS 32
+
+// W3MMD variable value types
+
+#define W3MMD_VALUETYPE_INT		1
+#define W3MMD_VALUETYPE_REAL	2
+#define W3MMD_VALUETYPE_STRING	3
+
 typedef pair<uint32_t,string> VarP;
 
-class CStatsW3MMD : public CStats
+class CStatsW3MMD : public CStats, public CActionHandler
 {
 private:
+	// variable names are interned to small integer ids on DefVarP, after that a VarP is an id lookup plus an array store
+
+	struct W3MMDVar
+	{
+		string m_Name;
+		unsigned char m_ValueType;
+		uint32_t m_Assigned;					// bit n is set when pid n has a value
+		int32_t m_Ints[W3MMD_MAX_PIDS];
+		double m_Reals[W3MMD_MAX_PIDS];
+		vector<string> m_Strings;				// only sized for string variables
+	};
+
+	struct W3MMDEvent
+	{
+		vector<string> m_Arguments;				// argument markers (e.g. "pid:0")
+		string m_Format;						// format string with {0}, {1}... markers
+	};
+
 	string m_Category;
 	uint32_t m_NextValueID;
 	uint32_t m_NextCheckID;
-	map<uint32_t,string> m_PIDToName;			// pid -> player name (e.g. 0 -> "Varlock") --- note: will not be automatically converted to lower case
-	map<uint32_t,string> m_Flags;				// pid -> flag (e.g. 0 -> "winner")
-	map<uint32_t,bool> m_FlagsLeaver;			// pid -> leaver flag (e.g. 0 -> true) --- note: will only be present if true
-	map<uint32_t,bool> m_FlagsPracticing;		// pid -> practice flag (e.g. 0 -> true) --- note: will only be present if true
-	map<string,string> m_DefVarPs;				// varname -> value type (e.g. "kills" -> "int")
-	map<VarP,int32_t> m_VarPInts;				// pid,varname -> value (e.g. 0,"kills" -> 5)
-	map<VarP,double> m_VarPReals;				// pid,varname -> value (e.g. 0,"x" -> 0.8)
-	map<VarP,string> m_VarPStrings;				// pid,varname -> value (e.g. 0,"hero" -> "heroname")
-	map<string, vector<string> > m_DefEvents;	// event -> vector of arguments + format
+	string m_PIDToName[W3MMD_MAX_PIDS];			// pid -> player name (e.g. 0 -> "Varlock") --- note: will not be automatically converted to lower case
+	uint32_t m_PIDNamed;						// bit n is set when pid n has a name
+	string m_Flags[W3MMD_MAX_PIDS];				// pid -> flag (e.g. 0 -> "winner")
+	uint32_t m_FlagsLeaver;						// bit n is set when pid n has the leaver flag
+	uint32_t m_FlagsPracticing;					// bit n is set when pid n has the practicing flag
+	map<string,uint32_t> m_VarIDs;				// varname -> index into m_Vars (e.g. "kills" -> 0)
+	vector<W3MMDVar> m_Vars;					// variable id -> definition and per player values
+	map<string,uint32_t> m_EventIDs;			// event -> index into m_Events
+	vector<W3MMDEvent> m_Events;				// event id -> arguments + format
+	vector<string> m_Tokens;					// token buffers reused for every key so tokenizing doesn't allocate once they've grown
+	uint32_t m_NumTokens;						// number of valid tokens in m_Tokens after TokenizeKey
 
 public:
 	CStatsW3MMD( CBaseGame *nGame, string nCategory );
 	virtual ~CStatsW3MMD( );
 
 	virtual bool ProcessAction( CIncomingAction *Action );
-	virtual void Save( CGHost *GHost, CGHostDB *DB, uint32_t GameID );
-	virtual vector<string> TokenizeKey( string key );
+	virtual void Save( CGHost *GHost, CGHostDB *DB, uint32_t GameID, bool UpdatePlayerStats = false );
+	virtual void OnSyncStored( unsigned char pid, unsigned char actionID, const char *file, const char *missionKey, const char *key, uint32_t value );
+
+private:
+	void ProcessValue( const unsigned char *key, uint32_t keyLength );
+	void ProcessVarP( const unsigned char *key, uint32_t keyLength );
+	void ProcessEvent( const unsigned char *key, uint32_t keyLength );
+	bool TokenizeKey( const unsigned char *key, uint32_t keyLength );
+	bool GetPID( const string &token, uint32_t *pid );
 };
 
 #endif
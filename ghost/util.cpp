@@ -121,7 +121,7 @@ string UTIL_ByteArrayToHexString( BYTEARRAY b )
 	return result;
 }
 
-void UTIL_AppendByteArray( BYTEARRAY &b, BYTEARRAY append )
+void UTIL_AppendByteArray( BYTEARRAY &b, const BYTEARRAY &append )
 {
 	b.insert( b.end( ), append.begin( ), append.end( ) );
 }
@@ -131,9 +131,10 @@ void UTIL_AppendByteArrayFast( BYTEARRAY &b, BYTEARRAY &append )
 	b.insert( b.end( ), append.begin( ), append.end( ) );
 }
 
-void UTIL_AppendByteArray( BYTEARRAY &b, unsigned char *a, int size )
+void UTIL_AppendByteArray( BYTEARRAY &b, const unsigned char *a, int size )
 {
-	UTIL_AppendByteArray( b, UTIL_CreateByteArray( a, size ) );
+	if( size > 0 )
+		b.insert( b.end( ), a, a + size );
 }
 
 void UTIL_AppendByteArray( BYTEARRAY &b, string append, bool terminator )
@@ -158,12 +159,36 @@ void UTIL_AppendByteArrayFast( BYTEARRAY &b, string &append, bool terminator )
 
 void UTIL_AppendByteArray( BYTEARRAY &b, uint16_t i, bool reverse )
 {
-	UTIL_AppendByteArray( b, UTIL_CreateByteArray( i, reverse ) );
+	// append the bytes directly instead of going through UTIL_CreateByteArray, the packet builders call this for almost every field
+
+	if( reverse )
+	{
+		b.push_back( (unsigned char)( i >> 8 ) );
+		b.push_back( (unsigned char)i );
+	}
+	else
+	{
+		b.push_back( (unsigned char)i );
+		b.push_back( (unsigned char)( i >> 8 ) );
+	}
 }
 
 void UTIL_AppendByteArray( BYTEARRAY &b, uint32_t i, bool reverse )
 {
-	UTIL_AppendByteArray( b, UTIL_CreateByteArray( i, reverse ) );
+	if( reverse )
+	{
+		b.push_back( (unsigned char)( i >> 24 ) );
+		b.push_back( (unsigned char)( i >> 16 ) );
+		b.push_back( (unsigned char)( i >> 8 ) );
+		b.push_back( (unsigned char)i );
+	}
+	else
+	{
+		b.push_back( (unsigned char)i );
+		b.push_back( (unsigned char)( i >> 8 ) );
+		b.push_back( (unsigned char)( i >> 16 ) );
+		b.push_back( (unsigned char)( i >> 24 ) );
+	}
 }
 
 BYTEARRAY UTIL_ExtractCString( BYTEARRAY &b, unsigned int start )
@@ -31,9 +31,9 @@ uint16_t UTIL_ByteArrayToUInt16( BYTEARRAY b, bool reverse, unsigned int start =
 uint32_t UTIL_ByteArrayToUInt32( BYTEARRAY b, bool reverse, unsigned int start = 0 );
 string UTIL_ByteArrayToDecString( BYTEARRAY b );
 string UTIL_ByteArrayToHexString( BYTEARRAY b );
-void UTIL_AppendByteArray( BYTEARRAY &b, BYTEARRAY append );
+void UTIL_AppendByteArray( BYTEARRAY &b, const BYTEARRAY &append );
 void UTIL_AppendByteArrayFast( BYTEARRAY &b, BYTEARRAY &append );
-void UTIL_AppendByteArray( BYTEARRAY &b, unsigned char *a, int size );
+void UTIL_AppendByteArray( BYTEARRAY &b, const unsigned char *a, int size );
 void UTIL_AppendByteArray( BYTEARRAY &b, string append, bool terminator = true );
 void UTIL_AppendByteArrayFast( BYTEARRAY &b, string &append, bool terminator = true );
 void UTIL_AppendByteArray( BYTEARRAY &b, uint16_t i, bool reverse );
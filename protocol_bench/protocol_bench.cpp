@@ -0,0 +1,683 @@
+/*
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*/
+
+// protocol_bench
+// times the packet builders and parsers the bot runs for every player and every action, plus the UTIL byte helpers and the SHA1/CRC32 hashes underneath them
+// each benchmark reports nanoseconds and heap allocations per operation, the allocations are counted by replacing the global operator new
+// -o saves the results and -compare checks a run against saved results, exiting with 1 if anything got slower than the tolerance or allocates more
+
+#include "ghost.h"
+#include "util.h"
+#include "crc32.h"
+#include "sha1.h"
+#include "gameslot.h"
+#include "gameprotocol.h"
+#include "bnetprotocol.h"
+#include "gpsprotocol.h"
+
+#include <stdlib.h>
+#include <new>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#define BENCH_RUNS 5
+
+void CONSOLE_Print( string message )
+{
+	cout << message << endl;
+}
+
+void DEBUG_Print( string message )
+{
+	CONSOLE_Print( message );
+}
+
+void DEBUG_Print( BYTEARRAY b )
+{
+	CONSOLE_Print( UTIL_ByteArrayToHexString( b ) );
+}
+
+uint32_t GetTicks( )
+{
+	static const boost :: posix_time :: ptime Start = boost :: posix_time :: microsec_clock :: universal_time( );
+	return (uint32_t)( boost :: posix_time :: microsec_clock :: universal_time( ) - Start ).total_milliseconds( );
+}
+
+uint32_t GetTime( )
+{
+	return GetTicks( ) / 1000;
+}
+
+uint64_t Nanoseconds( )
+{
+	static const boost :: posix_time :: ptime Start = boost :: posix_time :: microsec_clock :: universal_time( );
+	return (uint64_t)( boost :: posix_time :: microsec_clock :: universal_time( ) - Start ).total_microseconds( ) * 1000;
+}
+
+//
+// allocation counting
+//
+
+// the benchmarks are single threaded so a plain counter is enough
+
+uint64_t gAllocations = 0;
+
+void *operator new( size_t size )
+{
+	++gAllocations;
+	void *p = malloc( size ? size : 1 );
+
+	if( !p )
+		throw std :: bad_alloc( );
+
+	return p;
+}
+
+void *operator new[]( size_t size )
+{
+	return operator new( size );
+}
+
+void operator delete( void *p ) noexcept
+{
+	free( p );
+}
+
+void operator delete[]( void *p ) noexcept
+{
+	free( p );
+}
+
+void operator delete( void *p, size_t ) noexcept
+{
+	free( p );
+}
+
+void operator delete[]( void *p, size_t ) noexcept
+{
+	free( p );
+}
+
+//
+// fixtures
+//
+
+// built once before timing starts, the values are typical of a full 12 player DotA game
+
+CGameProtocol *gGameProtocol = NULL;
+CBNETProtocol *gBNETProtocol = NULL;
+CGPSProtocol *gGPSProtocol = NULL;
+
+BYTEARRAY gActionRun;			// back to back action records as CActionArena stores them
+BYTEARRAY gOutgoingAction;		// W3GS_OUTGOING_ACTION as received from a player
+BYTEARRAY gReqJoin;				// W3GS_REQJOIN
+BYTEARRAY gChatEvent;			// SID_CHATEVENT whisper
+vector<CGameSlot> gSlots;
+string gMapData;
+BYTEARRAY gStatString;
+BYTEARRAY gMapGameType;
+volatile uint64_t gSink = 0;	// keeps the compiler from dropping the work
+
+void SetupFixtures( )
+{
+	gGameProtocol = new CGameProtocol( NULL );
+	gBNETProtocol = new CBNETProtocol( );
+	gGPSProtocol = new CGPSProtocol( );
+
+	// 10 players with one 12 byte action each, a busy but ordinary latency interval
+
+	for( unsigned char PID = 1; PID <= 10; ++PID )
+	{
+		gActionRun.push_back( PID );
+		UTIL_AppendByteArray( gActionRun, (uint16_t)12, false );
+
+		for( uint32_t i = 0; i < 12; ++i )
+			gActionRun.push_back( (unsigned char)( PID * 13 + i ) );
+	}
+
+	gOutgoingAction.push_back( W3GS_HEADER_CONSTANT );
+	gOutgoingAction.push_back( CGameProtocol :: W3GS_OUTGOING_ACTION );
+	UTIL_AppendByteArray( gOutgoingAction, (uint16_t)( 8 + 23 ), false );
+	UTIL_AppendByteArray( gOutgoingAction, (uint32_t)0, false );
+
+	for( uint32_t i = 0; i < 23; ++i )
+		gOutgoingAction.push_back( (unsigned char)( 0x12 + i ) );
+
+	BYTEARRAY Payload;
+	UTIL_AppendByteArray( Payload, (uint32_t)0x10000002, false );
+	UTIL_AppendByteArray( Payload, (uint32_t)0x5EED5EED, false );
+	Payload.push_back( 0 );
+	UTIL_AppendByteArray( Payload, (uint16_t)6112, false );
+	UTIL_AppendByteArray( Payload, (uint32_t)0, false );
+	UTIL_AppendByteArray( Payload, string( "SomePlayerName" ) );
+	UTIL_AppendByteArray( Payload, (uint32_t)1, false );
+	UTIL_AppendByteArray( Payload, (uint16_t)6112, false );
+	UTIL_AppendByteArray( Payload, (uint32_t)0x0100007F, false );
+	gReqJoin.push_back( W3GS_HEADER_CONSTANT );
+	gReqJoin.push_back( CGameProtocol :: W3GS_REQJOIN );
+	UTIL_AppendByteArray( gReqJoin, (uint16_t)( 4 + Payload.size( ) ), false );
+	UTIL_AppendByteArrayFast( gReqJoin, Payload );
+
+	Payload.clear( );
+	UTIL_AppendByteArray( Payload, (uint32_t)CBNETProtocol :: EID_WHISPER, false );
+	UTIL_AppendByteArray( Payload, (uint32_t)0, false );
+	UTIL_AppendByteArray( Payload, (uint32_t)120, false );
+	Payload.resize( Payload.size( ) + 12, 0 );
+	UTIL_AppendByteArray( Payload, string( "SomePlayerName" ) );
+	UTIL_AppendByteArray( Payload, string( "!stats SomeOtherPlayer" ) );
+	gChatEvent.push_back( BNET_HEADER_CONSTANT );
+	gChatEvent.push_back( CBNETProtocol :: SID_CHATEVENT );
+	UTIL_AppendByteArray( gChatEvent, (uint16_t)( 4 + Payload.size( ) ), false );
+	UTIL_AppendByteArrayFast( gChatEvent, Payload );
+
+	for( unsigned char i = 0; i < 12; ++i )
+		gSlots.push_back( CGameSlot( i + 1, 100, SLOTSTATUS_OCCUPIED, 0, i < 5 ? 0 : ( i < 10 ? 1 : 12 ), i, SLOTRACE_RANDOM | SLOTRACE_SELECTABLE ) );
+
+	gMapData.resize( 8 * 1024 * 1024 );
+
+	for( uint32_t i = 0; i < gMapData.size( ); ++i )
+		gMapData[i] = (char)( i * 2654435761u >> 24 );
+
+	BYTEARRAY RawStatString;
+	UTIL_AppendByteArray( RawStatString, (uint32_t)0x00084002, false );
+	RawStatString.push_back( 0 );
+	UTIL_AppendByteArray( RawStatString, (uint16_t)116, false );
+	UTIL_AppendByteArray( RawStatString, (uint16_t)116, false );
+	UTIL_AppendByteArray( RawStatString, (uint32_t)0xDEADBEEF, false );
+	UTIL_AppendByteArray( RawStatString, string( "Maps\\Download\\DotA v6.83d.w3x" ) );
+	UTIL_AppendByteArray( RawStatString, string( "GHost" ) );
+	RawStatString.push_back( 0 );
+	gStatString = UTIL_EncodeStatString( RawStatString );
+	gMapGameType = UTIL_CreateByteArray( (uint32_t)0x00000001, false );
+}
+
+//
+// benchmarks
+//
+
+uint64_t BenchIncomingAction( uint32_t iterations )
+{
+	uint64_t Sink = 0;
+
+	for( uint32_t i = 0; i < iterations; ++i )
+		Sink += gGameProtocol->SEND_W3GS_INCOMING_ACTION( &gActionRun[0], gActionRun.size( ), 100 ).size( );
+
+	return Sink;
+}
+
+uint64_t BenchSlotInfo( uint32_t iterations )
+{
+	uint64_t Sink = 0;
+
+	for( uint32_t i = 0; i < iterations; ++i )
+		Sink += gGameProtocol->SEND_W3GS_SLOTINFO( gSlots, 12345, 3, 12 ).size( );
+
+	return Sink;
+}
+
+uint64_t BenchMapPart( uint32_t iterations )
+{
+	uint64_t Sink = 0;
+	uint32_t Start = 0;
+
+	for( uint32_t i = 0; i < iterations; ++i )
+	{
+		Sink += gGameProtocol->SEND_W3GS_MAPPART( 1, 2, Start, &gMapData ).size( );
+		Start += 1442;
+
+		if( Start >= gMapData.size( ) )
+			Start = 0;
+	}
+
+	return Sink;
+}
+
+uint64_t BenchGameInfo( uint32_t iterations )
+{
+	uint64_t Sink = 0;
+	string GameName = "DotA -apem #123";
+
+	for( uint32_t i = 0; i < iterations; ++i )
+		Sink += gGameProtocol->SEND_W3GS_GAMEINFO( true, 26, gMapGameType, GameName, i, gStatString, 12, 12, 6112, 2, 0x5EED5EED ).size( );
+
+	return Sink;
+}
+
+uint64_t BenchGameInfoPatch( uint32_t iterations )
+{
+	uint64_t Sink = 0;
+	BYTEARRAY Packet = gGameProtocol->SEND_W3GS_GAMEINFO( true, 26, gMapGameType, "DotA -apem #123", 0, gStatString, 12, 12, 6112, 2, 0x5EED5EED );
+
+	for( uint32_t i = 0; i < iterations; ++i )
+		Sink += gGameProtocol->PATCH_W3GS_GAMEINFO( Packet, 12 - i % 12, i ) ? Packet.size( ) : 0;
+
+	return Sink;
+}
+
+uint64_t BenchWriteIncomingAction( uint32_t iterations )
+{
+	// the writer functions append to a frame that's reused between packets like CBaseGame :: m_SendFrame
+
+	uint64_t Sink = 0;
+	BYTEARRAY Frame;
+
+	for( uint32_t i = 0; i < iterations; ++i )
+	{
+		Frame.clear( );
+		gGameProtocol->WRITE_W3GS_INCOMING_ACTION( Frame, &gActionRun[0], gActionRun.size( ), 100 );
+		Sink += Frame.size( );
+	}
+
+	return Sink;
+}
+
+uint64_t BenchWriteSlotInfo( uint32_t iterations )
+{
+	uint64_t Sink = 0;
+	BYTEARRAY Frame;
+
+	for( uint32_t i = 0; i < iterations; ++i )
+	{
+		Frame.clear( );
+		gGameProtocol->WRITE_W3GS_SLOTINFO( Frame, gSlots, 12345, 3, 12 );
+		Sink += Frame.size( );
+	}
+
+	return Sink;
+}
+
+uint64_t BenchWriteMapPart( uint32_t iterations )
+{
+	uint64_t Sink = 0;
+	uint32_t Start = 0;
+	BYTEARRAY Frame;
+
+	for( uint32_t i = 0; i < iterations; ++i )
+	{
+		Frame.clear( );
+		gGameProtocol->WRITE_W3GS_MAPPART( Frame, 1, 2, Start, &gMapData );
+		Sink += Frame.size( );
+		Start += 1442;
+
+		if( Start >= gMapData.size( ) )
+			Start = 0;
+	}
+
+	return Sink;
+}
+
+uint64_t BenchFixedPing( uint32_t iterations )
+{
+	uint64_t Sink = 0;
+
+	for( uint32_t i = 0; i < iterations; ++i )
+	{
+		CW3GSPingFromHost Ping;
+		Ping.SetUInt32<4>( i );
+		Sink += Ping.GetData( )[4] + Ping.GetSize( );
+	}
+
+	return Sink;
+}
+
+uint64_t BenchOutgoingAction( uint32_t iterations )
+{
+	uint64_t Sink = 0;
+	CIncomingAction Action( 255, NULL, 0 );
+
+	for( uint32_t i = 0; i < iterations; ++i )
+	{
+		if( gGameProtocol->RECEIVE_W3GS_OUTGOING_ACTION( gOutgoingAction, 3, Action ) )
+			Sink += Action.GetLength( );
+	}
+
+	return Sink;
+}
+
+uint64_t BenchReqJoin( uint32_t iterations )
+{
+	uint64_t Sink = 0;
+
+	for( uint32_t i = 0; i < iterations; ++i )
+	{
+		CIncomingJoinPlayer *Join = gGameProtocol->RECEIVE_W3GS_REQJOIN( gReqJoin );
+
+		if( Join )
+			Sink += Join->GetName( ).size( );
+
+		delete Join;
+	}
+
+	return Sink;
+}
+
+uint64_t BenchChatEvent( uint32_t iterations )
+{
+	uint64_t Sink = 0;
+
+	for( uint32_t i = 0; i < iterations; ++i )
+	{
+		CIncomingChatEvent *Event = gBNETProtocol->RECEIVE_SID_CHATEVENT( gChatEvent );
+
+		if( Event )
+			Sink += Event->GetMessage( ).size( );
+
+		delete Event;
+	}
+
+	return Sink;
+}
+
+uint64_t BenchGPSAck( uint32_t iterations )
+{
+	uint64_t Sink = 0;
+
+	for( uint32_t i = 0; i < iterations; ++i )
+		Sink += gGPSProtocol->SEND_GPSS_ACK( i ).size( );
+
+	return Sink;
+}
+
+uint64_t BenchAppendUInt32( uint32_t iterations )
+{
+	uint64_t Sink = 0;
+	BYTEARRAY Buffer;
+	Buffer.reserve( 64 );
+
+	for( uint32_t i = 0; i < iterations; ++i )
+	{
+		Buffer.clear( );
+
+		for( uint32_t j = 0; j < 8; ++j )
+			UTIL_AppendByteArray( Buffer, i + j, false );
+
+		Sink += Buffer.size( );
+	}
+
+	return Sink;
+}
+
+uint64_t BenchAppendByteArray( uint32_t iterations )
+{
+	uint64_t Sink = 0;
+	BYTEARRAY Buffer;
+	Buffer.reserve( 4096 );
+
+	for( uint32_t i = 0; i < iterations; ++i )
+	{
+		Buffer.clear( );
+		UTIL_AppendByteArray( Buffer, gActionRun );
+		Sink += Buffer.size( );
+	}
+
+	return Sink;
+}
+
+uint64_t BenchAppendByteArrayFast( uint32_t iterations )
+{
+	uint64_t Sink = 0;
+	BYTEARRAY Buffer;
+	Buffer.reserve( 4096 );
+
+	for( uint32_t i = 0; i < iterations; ++i )
+	{
+		Buffer.clear( );
+		UTIL_AppendByteArrayFast( Buffer, gActionRun );
+		Sink += Buffer.size( );
+	}
+
+	return Sink;
+}
+
+uint64_t BenchCreateByteArray( uint32_t iterations )
+{
+	uint64_t Sink = 0;
+
+	for( uint32_t i = 0; i < iterations; ++i )
+		Sink += UTIL_CreateByteArray( i, false ).size( );
+
+	return Sink;
+}
+
+uint64_t BenchByteArrayToUInt32( uint32_t iterations )
+{
+	uint64_t Sink = 0;
+
+	for( uint32_t i = 0; i < iterations; ++i )
+		Sink += UTIL_ByteArrayToUInt32( gReqJoin, false, 4 + ( i & 7 ) );
+
+	return Sink;
+}
+
+uint64_t BenchExtractCString( uint32_t iterations )
+{
+	uint64_t Sink = 0;
+
+	for( uint32_t i = 0; i < iterations; ++i )
+		Sink += UTIL_ExtractCString( gReqJoin, 19 ).size( );
+
+	return Sink;
+}
+
+uint64_t BenchSHA1( uint32_t iterations )
+{
+	// 64KB of map data per hash, CMap hashes whole maps the same way when they're loaded
+
+	uint64_t Sink = 0;
+	unsigned char Hash[20];
+
+	for( uint32_t i = 0; i < iterations; ++i )
+	{
+		CSHA1 :: Hash( (const unsigned char *)gMapData.c_str( ) + ( i & 127 ) * 65536, 65536, Hash );
+		Sink += Hash[0];
+	}
+
+	return Sink;
+}
+
+uint64_t BenchCRC32( uint32_t iterations )
+{
+	uint64_t Sink = 0;
+
+	for( uint32_t i = 0; i < iterations; ++i )
+		Sink += CCRC32 :: FullCRC( (const unsigned char *)gMapData.c_str( ) + ( i & 127 ) * 65536, 65536 );
+
+	return Sink;
+}
+
+struct ProtocolBenchmark
+{
+	const char *m_Name;
+	uint64_t (*m_Function)( uint32_t );
+};
+
+const ProtocolBenchmark gBenchmarks[] = {
+	{ "SEND_W3GS_INCOMING_ACTION",		BenchIncomingAction },
+	{ "SEND_W3GS_SLOTINFO",				BenchSlotInfo },
+	{ "SEND_W3GS_MAPPART",				BenchMapPart },
+	{ "SEND_W3GS_GAMEINFO",				BenchGameInfo },
+	{ "PATCH_W3GS_GAMEINFO",			BenchGameInfoPatch },
+	{ "WRITE_W3GS_INCOMING_ACTION",		BenchWriteIncomingAction },
+	{ "WRITE_W3GS_SLOTINFO",			BenchWriteSlotInfo },
+	{ "WRITE_W3GS_MAPPART",				BenchWriteMapPart },
+	{ "CW3GSPingFromHost",				BenchFixedPing },
+	{ "RECEIVE_W3GS_OUTGOING_ACTION",	BenchOutgoingAction },
+	{ "RECEIVE_W3GS_REQJOIN",			BenchReqJoin },
+	{ "RECEIVE_SID_CHATEVENT",			BenchChatEvent },
+	{ "SEND_GPSS_ACK",					BenchGPSAck },
+	{ "UTIL_AppendByteArray(uint32)",	BenchAppendUInt32 },
+	{ "UTIL_AppendByteArray(BYTEARRAY)",	BenchAppendByteArray },
+	{ "UTIL_AppendByteArrayFast",		BenchAppendByteArrayFast },
+	{ "UTIL_CreateByteArray(uint32)",	BenchCreateByteArray },
+	{ "UTIL_ByteArrayToUInt32",			BenchByteArrayToUInt32 },
+	{ "UTIL_ExtractCString",			BenchExtractCString },
+	{ "CSHA1::Hash(64KB)",				BenchSHA1 },
+	{ "CCRC32::FullCRC(64KB)",			BenchCRC32 }
+};
+
+struct BenchmarkResult
+{
+	double m_NanosecondsPerOp;
+	double m_AllocationsPerOp;
+};
+
+BenchmarkResult RunBenchmark( const ProtocolBenchmark &benchmark, uint64_t targetNanoseconds )
+{
+	// double the iteration count until one run takes long enough to time
+	// then keep the fastest of a few runs at that count since scheduler noise only ever adds time
+
+	uint32_t Iterations = 16;
+
+	while( Iterations < 0x40000000 )
+	{
+		uint64_t Start = Nanoseconds( );
+		gSink += benchmark.m_Function( Iterations );
+
+		if( Nanoseconds( ) - Start >= targetNanoseconds / BENCH_RUNS )
+			break;
+
+		Iterations *= 2;
+	}
+
+	uint64_t Fastest = 0;
+	uint64_t Allocations = 0;
+
+	for( uint32_t i = 0; i < BENCH_RUNS; ++i )
+	{
+		uint64_t AllocationsBefore = gAllocations;
+		uint64_t Start = Nanoseconds( );
+		gSink += benchmark.m_Function( Iterations );
+		uint64_t Elapsed = Nanoseconds( ) - Start;
+		Allocations = gAllocations - AllocationsBefore;
+
+		if( i == 0 || Elapsed < Fastest )
+			Fastest = Elapsed;
+	}
+
+	BenchmarkResult Result;
+	Result.m_NanosecondsPerOp = (double)Fastest / Iterations;
+	Result.m_AllocationsPerOp = (double)Allocations / Iterations;
+	return Result;
+}
+
+int main( int argc, char **argv )
+{
+	uint32_t TargetMS = 200;
+	double Tolerance = 10.0;
+	string OutputFile;
+	string CompareFile;
+	string Filter;
+
+	for( int i = 1; i < argc; ++i )
+	{
+		string Arg = argv[i];
+
+		if( Arg == "-t" && i + 1 < argc )
+			TargetMS = strtoul( argv[++i], NULL, 10 );
+		else if( Arg == "-o" && i + 1 < argc )
+			OutputFile = argv[++i];
+		else if( Arg == "-compare" && i + 1 < argc )
+			CompareFile = argv[++i];
+		else if( Arg == "-tolerance" && i + 1 < argc )
+			Tolerance = atof( argv[++i] );
+		else if( Arg[0] != '-' )
+			Filter = Arg;
+		else
+		{
+			cout << "usage: protocol_bench [-t ms per benchmark] [-o results] [-compare results] [-tolerance percent] [name filter]" << endl;
+			return 1;
+		}
+	}
+
+	if( TargetMS == 0 )
+		TargetMS = 1;
+
+	// saved results are "name ns_per_op allocs_per_op" lines, the name can't contain spaces
+
+	map<string, BenchmarkResult> Baseline;
+
+	if( !CompareFile.empty( ) )
+	{
+		ifstream In( CompareFile.c_str( ) );
+
+		if( In.fail( ) )
+		{
+			cout << "error: unable to read [" << CompareFile << "]" << endl;
+			return 1;
+		}
+
+		string Name;
+		BenchmarkResult Result;
+
+		while( In >> Name >> Result.m_NanosecondsPerOp >> Result.m_AllocationsPerOp )
+			Baseline[Name] = Result;
+	}
+
+	SetupFixtures( );
+
+	ofstream Out;
+
+	if( !OutputFile.empty( ) )
+	{
+		Out.open( OutputFile.c_str( ), ios :: out | ios :: trunc );
+
+		if( Out.fail( ) )
+		{
+			cout << "error: unable to open [" << OutputFile << "] for writing" << endl;
+			return 1;
+		}
+	}
+
+	uint32_t Regressions = 0;
+	cout << "benchmark                              ns/op   allocs/op" << ( Baseline.empty( ) ? "" : "   baseline ns/op  change" ) << endl;
+
+	for( uint32_t i = 0; i < sizeof( gBenchmarks ) / sizeof( gBenchmarks[0] ); ++i )
+	{
+		const ProtocolBenchmark &Benchmark = gBenchmarks[i];
+
+		if( !Filter.empty( ) && string( Benchmark.m_Name ).find( Filter ) == string :: npos )
+			continue;
+
+		BenchmarkResult Result = RunBenchmark( Benchmark, (uint64_t)TargetMS * 1000000 );
+		cout << left << setw( 34 ) << Benchmark.m_Name << right << fixed << setprecision( 1 ) << setw( 11 ) << Result.m_NanosecondsPerOp << setprecision( 2 ) << setw( 12 ) << Result.m_AllocationsPerOp;
+
+		map<string, BenchmarkResult> :: iterator Old = Baseline.find( Benchmark.m_Name );
+
+		if( Old != Baseline.end( ) )
+		{
+			double Change = Old->second.m_NanosecondsPerOp > 0 ? ( Result.m_NanosecondsPerOp / Old->second.m_NanosecondsPerOp - 1.0 ) * 100 : 0.0;
+			cout << setprecision( 1 ) << setw( 17 ) << Old->second.m_NanosecondsPerOp << setw( 7 ) << showpos << Change << "%" << noshowpos;
+
+			// allocation counts are exact so any increase is a regression, the time gets some slack for noise
+
+			if( Change > Tolerance || Result.m_AllocationsPerOp > Old->second.m_AllocationsPerOp + 0.01 )
+			{
+				cout << "  REGRESSION";
+				++Regressions;
+			}
+		}
+
+		cout << endl;
+
+		if( Out.is_open( ) )
+			Out << Benchmark.m_Name << " " << Result.m_NanosecondsPerOp << " " << Result.m_AllocationsPerOp << endl;
+	}
+
+	if( !Baseline.empty( ) )
+		cout << Regressions << " regressions (tolerance " << Tolerance << "%)" << endl;
+
+	return Regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,238 @@
+/*
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*/
+
+// protocol_test
+// checks the decoders and hashes the bot relies on against known data, every check prints a line and any failure makes the program exit with 1
+// run it with "make check"
+
+#include "ghost.h"
+#include "util.h"
+#include "crc32.h"
+#include "sha1.h"
+#include "actiondecoder.h"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+void CONSOLE_Print( string message )
+{
+	cout << message << endl;
+}
+
+void DEBUG_Print( string message )
+{
+	CONSOLE_Print( message );
+}
+
+void DEBUG_Print( BYTEARRAY b )
+{
+	CONSOLE_Print( UTIL_ByteArrayToHexString( b ) );
+}
+
+uint32_t GetTicks( )
+{
+	static const boost :: posix_time :: ptime Start = boost :: posix_time :: microsec_clock :: universal_time( );
+	return (uint32_t)( boost :: posix_time :: microsec_clock :: universal_time( ) - Start ).total_milliseconds( );
+}
+
+uint32_t GetTime( )
+{
+	return GetTicks( ) / 1000;
+}
+
+uint32_t gFailures = 0;
+
+void Check( bool ok, string what )
+{
+	if( ok )
+		CONSOLE_Print( "[PASS] " + what );
+	else
+	{
+		CONSOLE_Print( "[FAIL] " + what );
+		++gFailures;
+	}
+}
+
+//
+// CActionDecoder
+//
+
+// one player's action block as a 1.24 client sends it inside W3GS_OUTGOING_ACTION, a right click move, a right click on a unit,
+// a give item, a two target ability and then the DotA "dr.x" game cache write that follows them
+// every action before the 0x6B has to be measured exactly or the decoder lands in the middle of an action and never reaches it
+
+const unsigned char gActionBlock[] = {
+	0x11,											// unit/building ability (with target position)
+	0x40, 0x00,										// ability flags
+	0x03, 0x00, 0x0D, 0x00,							// order id (smart)
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,	// unknown
+	0x00, 0x00, 0xA0, 0xC4,							// target x (-1280.0)
+	0x00, 0x00, 0x80, 0x44,							// target y (1024.0)
+
+	0x12,											// unit/building ability (with target position and target object id)
+	0x40, 0x00,										// ability flags
+	0x03, 0x00, 0x0D, 0x00,							// order id (smart)
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,	// unknown
+	0x00, 0x00, 0xC8, 0xC3,							// target x (-400.0)
+	0x00, 0x00, 0x48, 0x44,							// target y (800.0)
+	0x3C, 0x1B, 0x00, 0x00, 0x3C, 0x1B, 0x00, 0x00,	// target object id
+
+	0x13,											// give item to unit / drop item on ground
+	0x40, 0x00,										// ability flags
+	0x03, 0x00, 0x0D, 0x00,							// order id (smart)
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,	// unknown
+	0x00, 0x00, 0xC8, 0xC3,							// target x (-400.0)
+	0x00, 0x00, 0x48, 0x44,							// target y (800.0)
+	0x46, 0x1B, 0x00, 0x00, 0x46, 0x1B, 0x00, 0x00,	// target object id
+	0x50, 0x1B, 0x00, 0x00, 0x50, 0x1B, 0x00, 0x00,	// item object id
+
+	0x14,											// unit/building ability (with two target positions and two item ids)
+	0x40, 0x00,										// ability flags
+	0x0F, 0x00, 0x0D, 0x00,							// order id 1
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,	// unknown
+	0x00, 0x00, 0xA0, 0xC4,							// target x 1 (-1280.0)
+	0x00, 0x00, 0x80, 0x44,							// target y 1 (1024.0)
+	0x03, 0x00, 0x0D, 0x00,							// order id 2
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// unknown
+	0x00, 0x00, 0xC8, 0xC3,							// target x 2 (-400.0)
+	0x00, 0x00, 0x48, 0x44,							// target y 2 (800.0)
+
+	0x6B,											// sync stored integer
+	'd', 'r', '.', 'x', 0x00,						// file
+	'D', 'a', 't', 'a', 0x00,						// mission key
+	'H', 'e', 'r', 'o', '1', 0x00,					// key
+	0x3C, 0x1B, 0x00, 0x00							// value
+};
+
+class CRecordingHandler : public CActionHandler
+{
+public:
+	vector<unsigned char> m_IDs;
+	vector<uint32_t> m_Lengths;
+	vector<string> m_SyncStored;
+	uint32_t m_Value;
+
+	CRecordingHandler( ) : m_Value( 0 ) { }
+
+	virtual bool OnAction( unsigned char pid, unsigned char actionID, const unsigned char *data, uint32_t length, bool countsForAPM )
+	{
+		m_IDs.push_back( actionID );
+		m_Lengths.push_back( length );
+		return true;
+	}
+
+	virtual void OnSyncStored( unsigned char pid, unsigned char actionID, const char *file, const char *missionKey, const char *key, uint32_t value )
+	{
+		m_SyncStored.push_back( file );
+		m_SyncStored.push_back( missionKey );
+		m_SyncStored.push_back( key );
+		m_Value = value;
+	}
+};
+
+void TestActionDecoder( )
+{
+	const unsigned char *Data = gActionBlock;
+	uint32_t Length = sizeof( gActionBlock );
+
+	Check( CActionDecoder :: GetActionLength( Data, Length ) == 23, "CActionDecoder :: GetActionLength 0x11 is 23 bytes" );
+	Check( CActionDecoder :: GetActionLength( Data + 23, Length - 23 ) == 31, "CActionDecoder :: GetActionLength 0x12 is 31 bytes" );
+	Check( CActionDecoder :: GetActionLength( Data + 54, Length - 54 ) == 39, "CActionDecoder :: GetActionLength 0x13 is 39 bytes" );
+	Check( CActionDecoder :: GetActionLength( Data + 93, Length - 93 ) == 44, "CActionDecoder :: GetActionLength 0x14 is 44 bytes" );
+	Check( CActionDecoder :: GetActionLength( Data, 22 ) == 0, "CActionDecoder :: GetActionLength rejects a truncated 0x11" );
+
+	CRecordingHandler Handler;
+	Check( CActionDecoder :: Decode( 1, Data, Length, &Handler ), "CActionDecoder :: Decode walks the whole block" );
+
+	unsigned char IDs[] = { 0x11, 0x12, 0x13, 0x14, W3GACTION_SYNCSTOREDINTEGER };
+	uint32_t Lengths[] = { 23, 31, 39, 44, 21 };
+	Check( Handler.m_IDs == vector<unsigned char>( IDs, IDs + 5 ), "CActionDecoder :: Decode finds the actions 0x11, 0x12, 0x13, 0x14, 0x6B in order" );
+	Check( Handler.m_Lengths == vector<uint32_t>( Lengths, Lengths + 5 ), "CActionDecoder :: Decode measures every action" );
+	Check( Handler.m_SyncStored.size( ) == 3 && Handler.m_SyncStored[0] == "dr.x" && Handler.m_SyncStored[1] == "Data" && Handler.m_SyncStored[2] == "Hero1", "CActionDecoder :: Decode splits the 0x6B strings" );
+	Check( Handler.m_Value == 0x1B3C, "CActionDecoder :: Decode reads the 0x6B value" );
+}
+
+//
+// CSHA1 and CCRC32
+//
+
+// the SHA1 vectors are the FIPS 180 known answers also listed in sha1.h, the CRC32 vector is the standard "123456789" check value
+
+bool CheckSHA1( const unsigned char *hash, const char *expected )
+{
+	char Hex[41];
+
+	for( unsigned int i = 0; i < 20; ++i )
+		snprintf( Hex + i * 2, 3, "%02X", hash[i] );
+
+	return strcmp( Hex, expected ) == 0;
+}
+
+void TestSHA1( )
+{
+	unsigned char Hash[20];
+
+	CSHA1 :: Hash( (const unsigned char *)"abc", 3, Hash );
+	Check( CheckSHA1( Hash, "A9993E364706816ABA3E25717850C26C9CD0D89D" ), "CSHA1 :: Hash \"abc\"" );
+
+	string Message = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+	CSHA1 :: Hash( (const unsigned char *)Message.c_str( ), Message.size( ), Hash );
+	Check( CheckSHA1( Hash, "84983E441C3BD26EBAAE4AA1F95129E5E54670F1" ), "CSHA1 :: Hash 448 bit message" );
+
+	string Million( 1000000, 'a' );
+	CSHA1 :: Hash( (const unsigned char *)Million.c_str( ), Million.size( ), Hash );
+	Check( CheckSHA1( Hash, "34AA973CD4C4DAA4F61EEB2BDBAD27316534016F" ), "CSHA1 :: Hash a million \"a\"" );
+
+	// the same million bytes through the streaming interface in uneven pieces like CMap hashes a map
+
+	CSHA1 SHA1;
+	SHA1.Reset( );
+
+	for( uint32_t i = 0; i < Million.size( ); i += 4093 )
+		SHA1.Update( (const unsigned char *)Million.c_str( ) + i, min( (uint32_t)4093, (uint32_t)Million.size( ) - i ) );
+
+	SHA1.Final( );
+	SHA1.GetHash( Hash );
+	Check( CheckSHA1( Hash, "34AA973CD4C4DAA4F61EEB2BDBAD27316534016F" ), "CSHA1 :: Update a million \"a\" in 4093 byte pieces" );
+}
+
+void TestCRC32( )
+{
+	const unsigned char *Data = (const unsigned char *)"123456789";
+
+	Check( CCRC32 :: FullCRC( Data, 9 ) == 0xCBF43926, "CCRC32 :: FullCRC \"123456789\"" );
+
+	uint32_t CRC = 0xFFFFFFFF;
+	CCRC32 :: PartialCRC( &CRC, Data, 4 );
+	CCRC32 :: PartialCRC( &CRC, Data + 4, 5 );
+	Check( ( CRC ^ 0xFFFFFFFF ) == 0xCBF43926, "CCRC32 :: PartialCRC \"123456789\" in two pieces" );
+	Check( CCRC32 :: FullCRC( Data, 0 ) == 0, "CCRC32 :: FullCRC of nothing" );
+}
+
+int main( int argc, char **argv )
+{
+	TestActionDecoder( );
+	TestSHA1( );
+	TestCRC32( );
+
+	if( gFailures > 0 )
+	{
+		CONSOLE_Print( "[TEST] " + UTIL_ToString( gFailures ) + " check(s) failed" );
+		return 1;
+	}
+
+	CONSOLE_Print( "[TEST] all checks passed" );
+	return 0;
+}
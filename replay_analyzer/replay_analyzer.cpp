@@ -0,0 +1,701 @@
+/*
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*/
+
+// replay_analyzer
+// decodes a large number of saved replays (.w3g) offline and writes one summary per game
+// each worker thread handles one replay at a time, the file is memory mapped and decompressed straight from the mapping by CPacked
+// the blocks are then walked with the same CReplay, CActionDecoder and CDotAGameCache code the bot uses while hosting
+
+#include "ghost.h"
+#include "util.h"
+#include "gameslot.h"
+#include "packed.h"
+#include "replay.h"
+#include "ghostdb.h"
+#include "actiondecoder.h"
+#include "dotagamecache.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+using namespace boost :: filesystem;
+
+#ifdef WIN32
+ #include <windows.h>
+#else
+ #include <fcntl.h>
+ #include <unistd.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+#endif
+
+bool gVerbose = false;
+boost :: mutex gConsoleMutex;
+
+void CONSOLE_Print( string message )
+{
+	// the ghost classes print a few lines for every replay they load so they're only shown in verbose mode
+
+	if( !gVerbose )
+		return;
+
+	boost :: mutex :: scoped_lock lock( gConsoleMutex );
+	cerr << message << endl;
+}
+
+void DEBUG_Print( string message )
+{
+	CONSOLE_Print( message );
+}
+
+void DEBUG_Print( BYTEARRAY b )
+{
+	CONSOLE_Print( UTIL_ByteArrayToHexString( b ) );
+}
+
+uint32_t GetTicks( )
+{
+	static const boost :: posix_time :: ptime Start = boost :: posix_time :: microsec_clock :: universal_time( );
+	return (uint32_t)( boost :: posix_time :: microsec_clock :: universal_time( ) - Start ).total_milliseconds( );
+}
+
+uint32_t GetTime( )
+{
+	return GetTicks( ) / 1000;
+}
+
+//
+// CMappedFile
+//
+
+class CMappedFile
+{
+private:
+	const char *m_Data;
+	size_t m_Size;
+#ifdef WIN32
+	HANDLE m_File;
+	HANDLE m_Mapping;
+#else
+	int m_File;
+#endif
+
+public:
+	CMappedFile( const string &fileName );
+	~CMappedFile( );
+
+	bool GetValid( )			{ return m_Data != NULL; }
+	const char *GetData( )		{ return m_Data; }
+	size_t GetSize( )			{ return m_Size; }
+};
+
+#ifdef WIN32
+
+CMappedFile :: CMappedFile( const string &fileName ) : m_Data( NULL ), m_Size( 0 ), m_Mapping( NULL )
+{
+	m_File = CreateFileA( fileName.c_str( ), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+
+	if( m_File == INVALID_HANDLE_VALUE )
+		return;
+
+	LARGE_INTEGER Size;
+
+	if( !GetFileSizeEx( m_File, &Size ) || Size.QuadPart == 0 )
+		return;
+
+	m_Mapping = CreateFileMappingA( m_File, NULL, PAGE_READONLY, 0, 0, NULL );
+
+	if( !m_Mapping )
+		return;
+
+	m_Data = (const char *)MapViewOfFile( m_Mapping, FILE_MAP_READ, 0, 0, 0 );
+
+	if( m_Data )
+		m_Size = (size_t)Size.QuadPart;
+}
+
+CMappedFile :: ~CMappedFile( )
+{
+	if( m_Data )
+		UnmapViewOfFile( m_Data );
+
+	if( m_Mapping )
+		CloseHandle( m_Mapping );
+
+	if( m_File != INVALID_HANDLE_VALUE )
+		CloseHandle( m_File );
+}
+
+#else
+
+CMappedFile :: CMappedFile( const string &fileName ) : m_Data( NULL ), m_Size( 0 )
+{
+	m_File = open( fileName.c_str( ), O_RDONLY );
+
+	if( m_File < 0 )
+		return;
+
+	struct stat Stat;
+
+	if( fstat( m_File, &Stat ) != 0 || Stat.st_size == 0 )
+		return;
+
+	void *Data = mmap( NULL, Stat.st_size, PROT_READ, MAP_PRIVATE, m_File, 0 );
+
+	if( Data == MAP_FAILED )
+		return;
+
+	// the replay is read once from start to end
+
+	madvise( Data, Stat.st_size, MADV_SEQUENTIAL );
+	m_Data = (const char *)Data;
+	m_Size = Stat.st_size;
+}
+
+CMappedFile :: ~CMappedFile( )
+{
+	if( m_Data )
+		munmap( (void *)m_Data, m_Size );
+
+	if( m_File >= 0 )
+		close( m_File );
+}
+
+#endif
+
+//
+// CReplayAnalysis
+//
+
+#define ANALYSIS_MAX_PIDS	16
+
+struct AnalysisChat
+{
+	uint32_t m_Time;
+	unsigned char m_PID;
+	uint32_t m_Mode;
+	string m_Message;
+};
+
+class CReplayAnalysis : public CDotAGameCache
+{
+private:
+	string m_File;
+	string m_Error;
+	string m_GameName;
+	string m_MapPath;
+	string m_HostName;
+	uint32_t m_War3Version;
+	uint32_t m_ReplayLength;
+	uint32_t m_Time;									// current game time while walking the blocks
+	vector<PIDPlayer> m_Players;
+	vector<CGameSlot> m_Slots;
+	uint32_t m_Actions[ANALYSIS_MAX_PIDS];
+	uint32_t m_ChatMessages[ANALYSIS_MAX_PIDS];
+	uint32_t m_LeftAt[ANALYSIS_MAX_PIDS];				// 0 if the player stayed until the end of the replay
+	uint32_t m_LeftReason[ANALYSIS_MAX_PIDS];
+	vector<AnalysisChat> m_Chat;
+
+public:
+	CReplayAnalysis( const string &nFile );
+	virtual ~CReplayAnalysis( );
+
+	string GetError( )	{ return m_Error; }
+
+	bool Analyze( );
+	string GetCSV( );
+	string GetJSON( );
+
+	virtual bool OnAction( unsigned char pid, unsigned char actionID, const unsigned char *data, uint32_t length, bool countsForAPM );
+
+private:
+	void ProcessTimeSlot( const BYTEARRAY &block );
+	void ProcessChatMessage( const BYTEARRAY &block );
+	void ProcessLeaveGame( const BYTEARRAY &block );
+	uint32_t GetPlayedTime( unsigned char pid );
+	string GetPlayerName( unsigned char pid );
+};
+
+static string CSVEscape( const string &s )
+{
+	if( s.find_first_of( ",\"\r\n" ) == string :: npos )
+		return s;
+
+	string Result = "\"";
+
+	for( string :: const_iterator i = s.begin( ); i != s.end( ); ++i )
+	{
+		if( *i == '"' )
+			Result += "\"\"";
+		else
+			Result += *i;
+	}
+
+	return Result + "\"";
+}
+
+static string JSONEscape( const string &s )
+{
+	string Result = "\"";
+
+	for( string :: const_iterator i = s.begin( ); i != s.end( ); ++i )
+	{
+		unsigned char c = *i;
+
+		if( c == '"' )
+			Result += "\\\"";
+		else if( c == '\\' )
+			Result += "\\\\";
+		else if( c == '\n' )
+			Result += "\\n";
+		else if( c == '\r' )
+			Result += "\\r";
+		else if( c == '\t' )
+			Result += "\\t";
+		else if( c < 0x20 )
+		{
+			char Buffer[8];
+			snprintf( Buffer, sizeof( Buffer ), "\\u%04x", c );
+			Result += Buffer;
+		}
+		else
+			Result += c;
+	}
+
+	return Result + "\"";
+}
+
+CReplayAnalysis :: CReplayAnalysis( const string &nFile ) : m_File( nFile ), m_War3Version( 0 ), m_ReplayLength( 0 ), m_Time( 0 )
+{
+	memset( m_Actions, 0, sizeof( m_Actions ) );
+	memset( m_ChatMessages, 0, sizeof( m_ChatMessages ) );
+	memset( m_LeftAt, 0, sizeof( m_LeftAt ) );
+	memset( m_LeftReason, 0, sizeof( m_LeftReason ) );
+}
+
+CReplayAnalysis :: ~CReplayAnalysis( )
+{
+
+}
+
+bool CReplayAnalysis :: Analyze( )
+{
+	CMappedFile File( m_File );
+
+	if( !File.GetValid( ) )
+	{
+		m_Error = "unable to map file";
+		return false;
+	}
+
+	CReplay Replay;
+	Replay.Load( File.GetData( ), File.GetSize( ), true );
+
+	if( !Replay.GetValid( ) )
+	{
+		m_Error = "unable to decompress replay";
+		return false;
+	}
+
+	Replay.ParseReplay( true );
+
+	if( !Replay.GetValid( ) )
+	{
+		m_Error = "unable to parse replay";
+		return false;
+	}
+
+	m_GameName = Replay.GetGameName( );
+	m_HostName = Replay.GetHostName( );
+	m_War3Version = Replay.GetWar3Version( );
+	m_ReplayLength = Replay.GetReplayLength( );
+	m_Players = Replay.GetPlayers( );
+	m_Slots = Replay.GetSlots( );
+
+	// the map path is the first string after the 13 byte map info in the decoded stat string
+
+	string StatString = Replay.GetStatString( );
+	BYTEARRAY StatStringBA( StatString.begin( ), StatString.end( ) );
+	BYTEARRAY Decoded = UTIL_DecodeStatString( StatStringBA );
+
+	if( Decoded.size( ) > 13 )
+	{
+		BYTEARRAY MapPath = UTIL_ExtractCString( Decoded, 13 );
+		m_MapPath = string( MapPath.begin( ), MapPath.end( ) );
+	}
+
+	queue<BYTEARRAY> *Blocks = Replay.GetBlocks( );
+
+	while( !Blocks->empty( ) )
+	{
+		const BYTEARRAY &Block = Blocks->front( );
+
+		if( Block[0] == CReplay :: REPLAY_TIMESLOT )
+			ProcessTimeSlot( Block );
+		else if( Block[0] == CReplay :: REPLAY_CHATMESSAGE )
+			ProcessChatMessage( Block );
+		else if( Block[0] == CReplay :: REPLAY_LEAVEGAME )
+			ProcessLeaveGame( Block );
+
+		Blocks->pop( );
+	}
+
+	// prefer the length we actually walked over the header value since some replays are saved with a wrong header
+
+	if( m_Time > 0 )
+		m_ReplayLength = m_Time;
+
+	return true;
+}
+
+void CReplayAnalysis :: ProcessTimeSlot( const BYTEARRAY &block )
+{
+	// 1 byte block id, 2 bytes block size, 2 bytes time increment, then one action block per player:
+	// 1 byte pid, 2 bytes action block size, n bytes actions
+
+	if( block.size( ) < 5 )
+		return;
+
+	m_Time += block[3] | block[4] << 8;
+	uint32_t i = 5;
+
+	while( i + 3 <= block.size( ) )
+	{
+		unsigned char PID = block[i];
+		uint32_t Size = block[i + 1] | block[i + 2] << 8;
+		i += 3;
+
+		if( i + Size > block.size( ) )
+			break;
+
+		CActionDecoder :: Decode( PID, &block[i], Size, this );
+		i += Size;
+	}
+}
+
+void CReplayAnalysis :: ProcessChatMessage( const BYTEARRAY &block )
+{
+	// 1 byte block id, 1 byte pid, 2 bytes block size, 1 byte flags, [4 bytes chat mode], null terminated message
+	// flags 0x10 are messages sent in the lobby which don't have a chat mode
+
+	if( block.size( ) < 6 )
+		return;
+
+	AnalysisChat Chat;
+	Chat.m_Time = m_Time;
+	Chat.m_PID = block[1];
+	Chat.m_Mode = 0;
+	uint32_t Start = 5;
+
+	if( block[4] != 0x10 )
+	{
+		if( block.size( ) < 10 )
+			return;
+
+		Chat.m_Mode = block[5] | block[6] << 8 | block[7] << 16 | (uint32_t)block[8] << 24;
+		Start = 9;
+	}
+
+	BYTEARRAY Message = UTIL_ExtractCString( const_cast<BYTEARRAY &>( block ), Start );
+	Chat.m_Message = string( Message.begin( ), Message.end( ) );
+
+	if( Chat.m_PID < ANALYSIS_MAX_PIDS )
+		++m_ChatMessages[Chat.m_PID];
+
+	m_Chat.push_back( Chat );
+}
+
+void CReplayAnalysis :: ProcessLeaveGame( const BYTEARRAY &block )
+{
+	// 1 byte block id, 4 bytes reason, 1 byte pid, 4 bytes result, 4 bytes unknown
+
+	if( block.size( ) < 14 )
+		return;
+
+	unsigned char PID = block[5];
+
+	if( PID < ANALYSIS_MAX_PIDS && m_LeftAt[PID] == 0 )
+	{
+		m_LeftAt[PID] = m_Time;
+		m_LeftReason[PID] = block[1] | block[2] << 8 | block[3] << 16 | (uint32_t)block[4] << 24;
+	}
+}
+
+bool CReplayAnalysis :: OnAction( unsigned char pid, unsigned char actionID, const unsigned char *data, uint32_t length, bool countsForAPM )
+{
+	if( countsForAPM && pid < ANALYSIS_MAX_PIDS )
+		++m_Actions[pid];
+
+	return true;
+}
+
+uint32_t CReplayAnalysis :: GetPlayedTime( unsigned char pid )
+{
+	if( pid < ANALYSIS_MAX_PIDS && m_LeftAt[pid] != 0 )
+		return m_LeftAt[pid];
+
+	return m_ReplayLength;
+}
+
+string CReplayAnalysis :: GetPlayerName( unsigned char pid )
+{
+	for( vector<PIDPlayer> :: iterator i = m_Players.begin( ); i != m_Players.end( ); ++i )
+	{
+		if( i->first == pid )
+			return i->second;
+	}
+
+	return string( );
+}
+
+string CReplayAnalysis :: GetCSV( )
+{
+	// one row per occupied human slot
+
+	string Result;
+	string Prefix = CSVEscape( m_File ) + "," + CSVEscape( m_GameName ) + "," + CSVEscape( m_MapPath ) + "," + UTIL_ToString( m_War3Version ) + "," + UTIL_ToString( m_ReplayLength ) + "," + UTIL_ToString( m_Winner ) + "," + UTIL_ToString( m_Min * 60 + m_Sec ) + ",";
+
+	for( vector<CGameSlot> :: iterator i = m_Slots.begin( ); i != m_Slots.end( ); ++i )
+	{
+		if( i->GetSlotStatus( ) != SLOTSTATUS_OCCUPIED || i->GetComputer( ) != 0 || i->GetPID( ) >= ANALYSIS_MAX_PIDS )
+			continue;
+
+		unsigned char PID = i->GetPID( );
+		unsigned char Colour = i->GetColour( );
+		uint32_t Played = GetPlayedTime( PID );
+		uint32_t APM = Played > 0 ? (uint32_t)( (uint64_t)m_Actions[PID] * 60000 / Played ) : 0;
+		Result += Prefix + UTIL_ToString( PID ) + "," + CSVEscape( GetPlayerName( PID ) ) + "," + UTIL_ToString( Colour ) + "," + UTIL_ToString( i->GetTeam( ) ) + ",";
+		Result += UTIL_ToString( m_Actions[PID] ) + "," + UTIL_ToString( APM ) + "," + UTIL_ToString( m_ChatMessages[PID] ) + "," + UTIL_ToString( m_LeftAt[PID] ) + "," + UTIL_ToString( m_LeftReason[PID] );
+
+		CDBDotAPlayer *Player = GetPlayer( Colour );
+
+		if( Player )
+		{
+			Result += "," + UTIL_ToString( Player->GetKills( ) ) + "," + UTIL_ToString( Player->GetDeaths( ) ) + "," + UTIL_ToString( Player->GetAssists( ) ) + "," + UTIL_ToString( Player->GetCreepKills( ) ) + "," + UTIL_ToString( Player->GetCreepDenies( ) ) + "," + UTIL_ToString( Player->GetNeutralKills( ) ) + ",";
+			Result += UTIL_ToString( Player->GetTowerKills( ) ) + "," + UTIL_ToString( Player->GetRaxKills( ) ) + "," + UTIL_ToString( Player->GetCourierKills( ) ) + "," + UTIL_ToString( Player->GetGold( ) ) + "," + CSVEscape( Player->GetHero( ) ) + "\n";
+		}
+		else
+			Result += ",,,,,,,,,,,\n";
+	}
+
+	return Result;
+}
+
+string CReplayAnalysis :: GetJSON( )
+{
+	string Result = "{\"file\":" + JSONEscape( m_File ) + ",\"game_name\":" + JSONEscape( m_GameName ) + ",\"map\":" + JSONEscape( m_MapPath ) + ",\"host\":" + JSONEscape( m_HostName );
+	Result += ",\"war3_version\":" + UTIL_ToString( m_War3Version ) + ",\"length\":" + UTIL_ToString( m_ReplayLength ) + ",\"winner\":" + UTIL_ToString( m_Winner ) + ",\"dota_length\":" + UTIL_ToString( m_Min * 60 + m_Sec ) + ",\"players\":[";
+	bool First = true;
+
+	for( vector<CGameSlot> :: iterator i = m_Slots.begin( ); i != m_Slots.end( ); ++i )
+	{
+		if( i->GetSlotStatus( ) != SLOTSTATUS_OCCUPIED || i->GetComputer( ) != 0 || i->GetPID( ) >= ANALYSIS_MAX_PIDS )
+			continue;
+
+		unsigned char PID = i->GetPID( );
+		unsigned char Colour = i->GetColour( );
+		uint32_t Played = GetPlayedTime( PID );
+		uint32_t APM = Played > 0 ? (uint32_t)( (uint64_t)m_Actions[PID] * 60000 / Played ) : 0;
+
+		if( !First )
+			Result += ",";
+
+		First = false;
+		Result += "{\"pid\":" + UTIL_ToString( PID ) + ",\"name\":" + JSONEscape( GetPlayerName( PID ) ) + ",\"colour\":" + UTIL_ToString( Colour ) + ",\"team\":" + UTIL_ToString( i->GetTeam( ) );
+		Result += ",\"actions\":" + UTIL_ToString( m_Actions[PID] ) + ",\"apm\":" + UTIL_ToString( APM ) + ",\"chat_messages\":" + UTIL_ToString( m_ChatMessages[PID] ) + ",\"left_at\":" + UTIL_ToString( m_LeftAt[PID] ) + ",\"left_reason\":" + UTIL_ToString( m_LeftReason[PID] );
+
+		CDBDotAPlayer *Player = GetPlayer( Colour );
+
+		if( Player )
+		{
+			Result += ",\"dota\":{\"kills\":" + UTIL_ToString( Player->GetKills( ) ) + ",\"deaths\":" + UTIL_ToString( Player->GetDeaths( ) ) + ",\"assists\":" + UTIL_ToString( Player->GetAssists( ) ) + ",\"creep_kills\":" + UTIL_ToString( Player->GetCreepKills( ) );
+			Result += ",\"creep_denies\":" + UTIL_ToString( Player->GetCreepDenies( ) ) + ",\"neutral_kills\":" + UTIL_ToString( Player->GetNeutralKills( ) ) + ",\"tower_kills\":" + UTIL_ToString( Player->GetTowerKills( ) ) + ",\"rax_kills\":" + UTIL_ToString( Player->GetRaxKills( ) );
+			Result += ",\"courier_kills\":" + UTIL_ToString( Player->GetCourierKills( ) ) + ",\"gold\":" + UTIL_ToString( Player->GetGold( ) ) + ",\"hero\":" + JSONEscape( Player->GetHero( ) ) + "}";
+		}
+
+		Result += "}";
+	}
+
+	Result += "],\"chat\":[";
+
+	for( vector<AnalysisChat> :: iterator i = m_Chat.begin( ); i != m_Chat.end( ); ++i )
+	{
+		if( i != m_Chat.begin( ) )
+			Result += ",";
+
+		Result += "{\"time\":" + UTIL_ToString( i->m_Time ) + ",\"pid\":" + UTIL_ToString( i->m_PID ) + ",\"mode\":" + UTIL_ToString( i->m_Mode ) + ",\"message\":" + JSONEscape( i->m_Message ) + "}";
+	}
+
+	return Result + "]}\n";
+}
+
+//
+// worker threads
+//
+
+struct AnalysisJob
+{
+	vector<string> m_Files;
+	vector<string> m_Results;
+	bool m_JSON;
+	boost :: mutex m_Mutex;
+	uint32_t m_Next;
+	uint32_t m_Failed;
+};
+
+void AnalysisWorker( AnalysisJob *job )
+{
+	while( 1 )
+	{
+		uint32_t Index;
+
+		{
+			boost :: mutex :: scoped_lock lock( job->m_Mutex );
+
+			if( job->m_Next >= job->m_Files.size( ) )
+				return;
+
+			Index = job->m_Next++;
+		}
+
+		// each replay is written to its own result slot so the output keeps the input order without any locking
+
+		CReplayAnalysis Analysis( job->m_Files[Index] );
+
+		if( Analysis.Analyze( ) )
+			job->m_Results[Index] = job->m_JSON ? Analysis.GetJSON( ) : Analysis.GetCSV( );
+		else
+		{
+			boost :: mutex :: scoped_lock lock( job->m_Mutex );
+			++job->m_Failed;
+
+			{
+				boost :: mutex :: scoped_lock consoleLock( gConsoleMutex );
+				cerr << "warning: skipping [" << job->m_Files[Index] << "] - " << Analysis.GetError( ) << endl;
+			}
+		}
+	}
+}
+
+void AddReplays( const path &p, vector<string> &files )
+{
+	if( is_directory( p ) )
+	{
+		recursive_directory_iterator EndIterator;
+
+		for( recursive_directory_iterator i( p ); i != EndIterator; ++i )
+		{
+			string Extension = i->path( ).extension( ).string( );
+			transform( Extension.begin( ), Extension.end( ), Extension.begin( ), (int(*)(int))tolower );
+
+			if( !is_directory( i->status( ) ) && Extension == ".w3g" )
+				files.push_back( i->path( ).string( ) );
+		}
+	}
+	else
+		files.push_back( p.string( ) );
+}
+
+int main( int argc, char **argv )
+{
+	uint32_t Threads = boost :: thread :: hardware_concurrency( );
+	bool JSON = false;
+	string OutputFile;
+	vector<string> Files;
+
+	for( int i = 1; i < argc; ++i )
+	{
+		string Arg = argv[i];
+
+		if( Arg == "-j" && i + 1 < argc )
+			Threads = strtoul( argv[++i], NULL, 10 );
+		else if( Arg == "-o" && i + 1 < argc )
+			OutputFile = argv[++i];
+		else if( Arg == "--json" )
+			JSON = true;
+		else if( Arg == "--csv" )
+			JSON = false;
+		else if( Arg == "-v" )
+			gVerbose = true;
+		else
+			AddReplays( path( Arg ), Files );
+	}
+
+	if( Files.empty( ) )
+	{
+		cerr << "usage: replay_analyzer [-j threads] [-o output] [--csv|--json] [-v] <replay or directory> [...]" << endl;
+		cerr << "  --csv writes one row per player (default), --json writes one JSON object per game (JSON lines)" << endl;
+		return 1;
+	}
+
+	if( Threads == 0 )
+		Threads = 1;
+
+	if( Threads > Files.size( ) )
+		Threads = Files.size( );
+
+	std :: ofstream OutFile;
+
+	if( !OutputFile.empty( ) )
+	{
+		OutFile.open( OutputFile.c_str( ), ios :: out | ios :: binary );
+
+		if( OutFile.fail( ) )
+		{
+			cerr << "error: unable to open [" << OutputFile << "] for writing" << endl;
+			return 1;
+		}
+	}
+
+	ostream &Out = OutputFile.empty( ) ? cout : OutFile;
+	cerr << "analyzing " << Files.size( ) << " replays with " << Threads << " threads" << endl;
+
+	AnalysisJob Job;
+	Job.m_Files = Files;
+	Job.m_Results.resize( Files.size( ) );
+	Job.m_JSON = JSON;
+	Job.m_Next = 0;
+	Job.m_Failed = 0;
+
+	boost :: posix_time :: ptime Start = boost :: posix_time :: microsec_clock :: universal_time( );
+	boost :: thread_group Workers;
+
+	for( uint32_t i = 0; i < Threads; ++i )
+		Workers.create_thread( boost :: bind( &AnalysisWorker, &Job ) );
+
+	Workers.join_all( );
+	double Seconds = ( boost :: posix_time :: microsec_clock :: universal_time( ) - Start ).total_microseconds( ) / 1000000.0;
+
+	if( !JSON )
+		Out << "file,game_name,map,war3_version,length,winner,dota_length,pid,name,colour,team,actions,apm,chat_messages,left_at,left_reason,kills,deaths,assists,creep_kills,creep_denies,neutral_kills,tower_kills,rax_kills,courier_kills,gold,hero\n";
+
+	for( vector<string> :: iterator i = Job.m_Results.begin( ); i != Job.m_Results.end( ); ++i )
+		Out << *i;
+
+	Out.flush( );
+
+	uint32_t Analyzed = Files.size( ) - Job.m_Failed;
+	cerr << "analyzed " << Analyzed << " replays (" << Job.m_Failed << " failed) in " << fixed << setprecision( 2 ) << Seconds << " seconds";
+
+	if( Seconds > 0.0 )
+		cerr << ", " << setprecision( 1 ) << Files.size( ) / Seconds << " replays/second";
+
+	cerr << endl;
+	return Job.m_Failed == 0 ? 0 : 2;
+}
@@ -38,6 +38,8 @@ using namespace std;
 #include "elo.h"
 
 #include <string.h>
+#include <time.h>
+#include <algorithm>
 
 #ifdef WIN32
  #include <winsock.h>
@@ -118,12 +120,189 @@ float UTIL_ToFloat( string &s )
 	return result;
 }
 
+uint32_t GetTicks( )
+{
+#ifdef WIN32
+	return GetTickCount( );
+#else
+	struct timespec t;
+	clock_gettime( CLOCK_MONOTONIC, &t );
+	return t.tv_sec * 1000 + t.tv_nsec / 1000000;
+#endif
+}
+
+string ToLower( string s )
+{
+	transform( s.begin( ), s.end( ), s.begin( ), (int(*)(int))tolower );
+	return s;
+}
+
+bool MySQLQuery( MYSQL *conn, const string &query )
+{
+	if( mysql_real_query( conn, query.c_str( ), query.size( ) ) != 0 )
+	{
+		cout << "error: " << mysql_error( conn ) << endl;
+		return false;
+	}
+
+	return true;
+}
+
+//
+// the ratings are loaded once, every unscored game is scored in memory in gameid order and only the changed ratings are written back
+// players are keyed by lowercase name and server to match the case insensitive join the per game queries used to do
+//
+
+struct EloPlayer
+{
+	uint32_t m_ID;			// 0 if the player doesn't have a row in dota_elo_scores yet
+	string m_Name;
+	string m_Server;
+	float m_Score;
+	bool m_Changed;
+};
+
+struct EloGamePlayer
+{
+	string m_Name;
+	string m_Server;
+	uint32_t m_Colour;
+	uint32_t m_Winner;
+};
+
+typedef map<string, EloPlayer> EloPlayerMap;
+
+bool ScoreGame( uint32_t GameID, vector<EloGamePlayer> &players, EloPlayerMap &ratings )
+{
+	if( players.empty( ) )
+	{
+		cout << "gameid " << GameID << " has no players, ignoring\n";
+		return false;
+	}
+
+	if( players.size( ) > 10 )
+	{
+		cout << "gameid " << GameID << " has more than 10 players, ignoring\n";
+		return false;
+	}
+
+	EloPlayer *ratingplayers[10];
+	int num_players = 0;
+	float player_ratings[10];
+	int player_teams[10];
+	int num_teams = 2;
+	float team_ratings[2];
+	float team_winners[2];
+	int team_numplayers[2];
+	team_ratings[0] = 0.0;
+	team_ratings[1] = 0.0;
+	team_numplayers[0] = 0;
+	team_numplayers[1] = 0;
+
+	for( vector<EloGamePlayer> :: iterator i = players.begin( ); i != players.end( ); ++i )
+	{
+		if( i->m_Winner != 1 && i->m_Winner != 2 )
+		{
+			cout << "gameid " << GameID << " has no winner, ignoring\n";
+			return false;
+		}
+		else if( i->m_Winner == 1 )
+		{
+			team_winners[0] = 1.0;
+			team_winners[1] = 0.0;
+		}
+		else
+		{
+			team_winners[0] = 0.0;
+			team_winners[1] = 1.0;
+		}
+
+		if( i->m_Colour >= 1 && i->m_Colour <= 5 )
+			player_teams[num_players] = 0;
+		else if( i->m_Colour >= 7 && i->m_Colour <= 11 )
+			player_teams[num_players] = 1;
+		else
+		{
+			cout << "gameid " << GameID << " has a player with an invalid newcolour, ignoring\n";
+			return false;
+		}
+
+		// new players are only added to the map once the game is known to be scored
+
+		EloPlayerMap :: iterator Rating = ratings.find( ToLower( i->m_Name ) + '\0' + ToLower( i->m_Server ) );
+
+		if( Rating != ratings.end( ) )
+		{
+			ratingplayers[num_players] = &Rating->second;
+			player_ratings[num_players] = Rating->second.m_Score;
+		}
+		else
+		{
+			ratingplayers[num_players] = NULL;
+			player_ratings[num_players] = 1000.0;
+		}
+
+		team_ratings[player_teams[num_players]] += player_ratings[num_players];
+		team_numplayers[player_teams[num_players]]++;
+		num_players++;
+	}
+
+	if( team_numplayers[0] == 0 )
+	{
+		cout << "gameid " << GameID << " has no Sentinel players, ignoring\n";
+		return false;
+	}
+	else if( team_numplayers[1] == 0 )
+	{
+		cout << "gameid " << GameID << " has no Scourge players, ignoring\n";
+		return false;
+	}
+
+	float old_player_ratings[10];
+	memcpy( old_player_ratings, player_ratings, sizeof( float ) * 10 );
+	team_ratings[0] /= team_numplayers[0];
+	team_ratings[1] /= team_numplayers[1];
+	elo_recalculate_ratings( num_players, player_ratings, player_teams, num_teams, team_ratings, team_winners );
+
+	for( int i = 0; i < num_players; i++ )
+	{
+		if( !ratingplayers[i] )
+		{
+			cout << "new player [" << players[i].m_Name << "] found\n";
+			EloPlayer &Player = ratings[ToLower( players[i].m_Name ) + '\0' + ToLower( players[i].m_Server )];
+			Player.m_ID = 0;
+			Player.m_Name = players[i].m_Name;
+			Player.m_Server = players[i].m_Server;
+			ratingplayers[i] = &Player;
+		}
+
+		ratingplayers[i]->m_Score = player_ratings[i];
+		ratingplayers[i]->m_Changed = true;
+		cout << "player [" << players[i].m_Name << "] rating " << (uint32_t)old_player_ratings[i] << " -> " << (uint32_t)player_ratings[i] << "\n";
+	}
+
+	return true;
+}
+
 int main( int argc, char **argv )
 {
 	string CFGFile = "update_dota_elo.cfg";
+	uint32_t Since = 0;
 
-	if( argc > 1 && argv[1] )
-		CFGFile = argv[1];
+	for( int i = 1; i < argc; i++ )
+	{
+		string Arg = argv[i];
+
+		if( Arg == "--since" && i + 1 < argc )
+		{
+			// only games with a higher gameid are considered, pass the watermark printed by the previous run to skip the already scored history
+
+			string Value = argv[++i];
+			Since = UTIL_ToUInt32( Value );
+		}
+		else
+			CFGFile = Arg;
+	}
 
 	CConfig CFG;
 	CFG.Read( CFGFile );
@@ -179,16 +358,13 @@ int main( int argc, char **argv )
 		return 1;
 	}
 
-	cout << "getting unscored games" << endl;
-	queue<uint32_t> UnscoredGames;
+	uint32_t StartTicks = GetTicks( );
+	uint32_t MaxGameID = 0;
 
-	string QSelectUnscored = "SELECT id FROM games WHERE id NOT IN ( SELECT gameid FROM dota_elo_games_scored ) ORDER BY id";
+	// games created while we're running are left for the next run
 
-	if( mysql_real_query( Connection, QSelectUnscored.c_str( ), QSelectUnscored.size( ) ) != 0 )
-	{
-		cout << "error: " << mysql_error( Connection ) << endl;
+	if( !MySQLQuery( Connection, "SELECT MAX(id) FROM games" ) )
 		return 1;
-	}
 	else
 	{
 		MYSQL_RES *Result = mysql_store_result( Connection );
@@ -197,11 +373,8 @@ int main( int argc, char **argv )
 		{
 			vector<string> Row = MySQLFetchRow( Result );
 
-			while( !Row.empty( ) )
-			{
-				UnscoredGames.push( UTIL_ToUInt32( Row[0] ) );
-				Row = MySQLFetchRow( Result );
-			}
+			if( !Row.empty( ) && !Row[0].empty( ) )
+				MaxGameID = UTIL_ToUInt32( Row[0] );
 
 			mysql_free_result( Result );
 		}
@@ -212,186 +385,152 @@ int main( int argc, char **argv )
 		}
 	}
 
-	cout << "found " << UnscoredGames.size( ) << " unscored games" << endl;
+	cout << "loading ratings" << endl;
+	EloPlayerMap Ratings;
 
-	while( !UnscoredGames.empty( ) )
+	if( !MySQLQuery( Connection, "SELECT id, name, server, score FROM dota_elo_scores" ) )
+		return 1;
+	else
 	{
-		uint32_t GameID = UnscoredGames.front( );
-		UnscoredGames.pop( );
+		MYSQL_RES *Result = mysql_use_result( Connection );
+
+		if( Result )
+		{
+			vector<string> Row = MySQLFetchRow( Result );
 
-		string QSelectPlayers = "SELECT dota_elo_scores.id, gameplayers.name, spoofedrealm, newcolour, winner, score FROM dotaplayers LEFT JOIN dotagames ON dotagames.gameid=dotaplayers.gameid LEFT JOIN gameplayers ON gameplayers.gameid=dotaplayers.gameid AND gameplayers.colour=dotaplayers.colour LEFT JOIN dota_elo_scores ON dota_elo_scores.name=gameplayers.name AND server=spoofedrealm WHERE dotaplayers.gameid=" + UTIL_ToString( GameID );
+			while( Row.size( ) == 4 )
+			{
+				EloPlayer &Player = Ratings[ToLower( Row[1] ) + '\0' + ToLower( Row[2] )];
+				Player.m_ID = UTIL_ToUInt32( Row[0] );
+				Player.m_Name = Row[1];
+				Player.m_Server = Row[2];
+				Player.m_Score = UTIL_ToFloat( Row[3] );
+				Player.m_Changed = false;
+				Row = MySQLFetchRow( Result );
+			}
 
-		if( mysql_real_query( Connection, QSelectPlayers.c_str( ), QSelectPlayers.size( ) ) != 0 )
+			mysql_free_result( Result );
+		}
+		else
 		{
 			cout << "error: " << mysql_error( Connection ) << endl;
 			return 1;
 		}
-		else
-		{
-			MYSQL_RES *Result = mysql_store_result( Connection );
+	}
 
-			if( Result )
-			{
-				cout << "gameid " << UTIL_ToString( GameID ) << " found" << endl;
-
-				bool ignore = false;
-				uint32_t rowids[10];
-				string names[10];
-				string servers[10];
-				bool exists[10];
-				int num_players = 0;
-				float player_ratings[10];
-				int player_teams[10];
-				int num_teams = 2;
-				float team_ratings[2];
-				float team_winners[2];
-				int team_numplayers[2];
-				team_ratings[0] = 0.0;
-				team_ratings[1] = 0.0;
-				team_numplayers[0] = 0;
-				team_numplayers[1] = 0;
-
-				vector<string> Row = MySQLFetchRow( Result );
-
-				while( Row.size( ) == 6 )
-				{
-					if( num_players >= 10 )
-					{
-						cout << "gameid " << UTIL_ToString( GameID ) << " has more than 10 players, ignoring" << endl;
-						ignore = true;
-						break;
-					}
+	uint32_t LoadTicks = GetTicks( );
+	cout << "loaded " << Ratings.size( ) << " ratings in " << LoadTicks - StartTicks << " ms" << endl;
+	cout << "scoring unscored games after gameid " << Since << " up to gameid " << MaxGameID << endl;
 
-					uint32_t Winner = UTIL_ToUInt32( Row[4] );
+	// stream every player of every unscored game in one query, the rows arrive grouped by gameid so each game is scored once its last row has been read
+	// nothing else can be sent on the connection until the result has been read completely, which is fine since the ratings are only written back afterwards
 
-					if( Winner != 1 && Winner != 2 )
-					{
-						cout << "gameid " << UTIL_ToString( GameID ) << " has no winner, ignoring" << endl;
-						ignore = true;
-						break;
-					}
-					else if( Winner == 1 )
-					{
-						team_winners[0] = 1.0;
-						team_winners[1] = 0.0;
-					}
-					else
-					{
-						team_winners[0] = 0.0;
-						team_winners[1] = 1.0;
-					}
-
-					if( !Row[0].empty( ) )
-						rowids[num_players] = UTIL_ToUInt32( Row[0] );
-					else
-						rowids[num_players] = 0;
+	string QSelectPlayers = "SELECT dotaplayers.gameid, gameplayers.name, spoofedrealm, newcolour, winner FROM dotaplayers LEFT JOIN dotagames ON dotagames.gameid=dotaplayers.gameid LEFT JOIN gameplayers ON gameplayers.gameid=dotaplayers.gameid AND gameplayers.colour=dotaplayers.colour LEFT JOIN dota_elo_games_scored ON dota_elo_games_scored.gameid=dotaplayers.gameid WHERE dota_elo_games_scored.id IS NULL AND dotaplayers.gameid>" + UTIL_ToString( Since ) + " AND dotaplayers.gameid<=" + UTIL_ToString( MaxGameID ) + " ORDER BY dotaplayers.gameid";
+	uint32_t GamesFound = 0;
+	uint32_t GamesScored = 0;
 
-					names[num_players] = Row[1];
-					servers[num_players] = Row[2];
+	if( !MySQLQuery( Connection, QSelectPlayers ) )
+		return 1;
+	else
+	{
+		MYSQL_RES *Result = mysql_use_result( Connection );
 
-					if( !Row[5].empty( ) )
-					{
-						exists[num_players] = true;
-						player_ratings[num_players] = UTIL_ToFloat( Row[5] );
-					}
-					else
-					{
-						cout << "new player [" << Row[1] << "] found" << endl;
-						exists[num_players] = false;
-						player_ratings[num_players] = 1000.0;
-					}
+		if( Result )
+		{
+			uint32_t GameID = 0;
+			vector<EloGamePlayer> Players;
+			vector<string> Row = MySQLFetchRow( Result );
 
-					uint32_t Colour = UTIL_ToUInt32( Row[3] );
+			while( 1 )
+			{
+				uint32_t RowGameID = Row.size( ) == 5 ? UTIL_ToUInt32( Row[0] ) : 0;
 
-					if( Colour >= 1 && Colour <= 5 )
-					{
-						player_teams[num_players] = 0;
-						team_ratings[0] += player_ratings[num_players];
-						team_numplayers[0]++;
-					}
-					else if( Colour >= 7 && Colour <= 11 )
-					{
-						player_teams[num_players] = 1;
-						team_ratings[1] += player_ratings[num_players];
-						team_numplayers[1]++;
-					}
-					else
+				if( RowGameID != GameID )
+				{
+					if( GameID != 0 )
 					{
-						cout << "gameid " << UTIL_ToString( GameID ) << " has a player with an invalid newcolour, ignoring" << endl;
-						ignore = true;
-						break;
+						GamesFound++;
+
+						if( ScoreGame( GameID, Players, Ratings ) )
+							GamesScored++;
 					}
 
-					num_players++;
-					Row = MySQLFetchRow( Result );
+					GameID = RowGameID;
+					Players.clear( );
 				}
 
-				mysql_free_result( Result );
+				if( Row.size( ) != 5 )
+					break;
 
-				if( !ignore )
-				{
-					if( num_players == 0 )
-						cout << "gameid " << UTIL_ToString( GameID ) << " has no players, ignoring" << endl;
-					else if( team_numplayers[0] == 0 )
-						cout << "gameid " << UTIL_ToString( GameID ) << " has no Sentinel players, ignoring" << endl;
-					else if( team_numplayers[1] == 0 )
-						cout << "gameid " << UTIL_ToString( GameID ) << " has no Scourge players, ignoring" << endl;
-					else
-					{
-						cout << "gameid " << UTIL_ToString( GameID ) << " is calculating" << endl;
-
-						float old_player_ratings[10];
-						memcpy( old_player_ratings, player_ratings, sizeof( float ) * 10 );
-						team_ratings[0] /= team_numplayers[0];
-						team_ratings[1] /= team_numplayers[1];
-						elo_recalculate_ratings( num_players, player_ratings, player_teams, num_teams, team_ratings, team_winners );
-
-						for( int i = 0; i < num_players; i++ )
-						{
-							cout << "player [" << names[i] << "] rating " << UTIL_ToString( (uint32_t)old_player_ratings[i] ) << " -> " << UTIL_ToString( (uint32_t)player_ratings[i] ) << endl;
-
-							if( exists[i] )
-							{
-								string QUpdateScore = "UPDATE dota_elo_scores SET score=" + UTIL_ToString( player_ratings[i], 2 ) + " WHERE id=" + UTIL_ToString( rowids[i] );
-
-								if( mysql_real_query( Connection, QUpdateScore.c_str( ), QUpdateScore.size( ) ) != 0 )
-								{
-									cout << "error: " << mysql_error( Connection ) << endl;
-									return 1;
-								}
-							}
-							else
-							{
-								string EscName = MySQLEscapeString( Connection, names[i] );
-								string EscServer = MySQLEscapeString( Connection, servers[i] );
-								string QInsertScore = "INSERT INTO dota_elo_scores ( name, server, score ) VALUES ( '" + EscName + "', '" + EscServer + "', " + UTIL_ToString( player_ratings[i], 2 ) + " )";
-
-								if( mysql_real_query( Connection, QInsertScore.c_str( ), QInsertScore.size( ) ) != 0 )
-								{
-									cout << "error: " << mysql_error( Connection ) << endl;
-									return 1;
-								}
-							}
-						}
-					}
-				}				
+				EloGamePlayer Player;
+				Player.m_Name = Row[1];
+				Player.m_Server = Row[2];
+				Player.m_Colour = Row[3].empty( ) ? 0 : UTIL_ToUInt32( Row[3] );
+				Player.m_Winner = Row[4].empty( ) ? 0 : UTIL_ToUInt32( Row[4] );
+				Players.push_back( Player );
+				Row = MySQLFetchRow( Result );
 			}
-			else
+
+			if( mysql_errno( Connection ) != 0 )
 			{
 				cout << "error: " << mysql_error( Connection ) << endl;
+				mysql_free_result( Result );
 				return 1;
 			}
-		}
-
-		string QInsertScored = "INSERT INTO dota_elo_games_scored ( gameid ) VALUES ( " + UTIL_ToString( GameID ) + " )";
 
-		if( mysql_real_query( Connection, QInsertScored.c_str( ), QInsertScored.size( ) ) != 0 )
+			mysql_free_result( Result );
+		}
+		else
 		{
 			cout << "error: " << mysql_error( Connection ) << endl;
 			return 1;
 		}
 	}
 
+	uint32_t ScoreTicks = GetTicks( );
+	cout << "scored " << GamesScored << " of " << GamesFound << " games in " << ScoreTicks - LoadTicks << " ms" << endl;
+	cout << "writing ratings" << endl;
+
+	// upsert the changed ratings in batches, existing rows are matched on their primary key and new players get a NULL id so they're inserted
+
+	uint32_t RatingsWritten = 0;
+	string QUpsert;
+
+	for( EloPlayerMap :: iterator i = Ratings.begin( ); i != Ratings.end( ); ++i )
+	{
+		if( !i->second.m_Changed )
+			continue;
+
+		if( QUpsert.empty( ) )
+			QUpsert = "INSERT INTO dota_elo_scores ( id, name, server, score ) VALUES ";
+		else
+			QUpsert += ", ";
+
+		QUpsert += "( " + ( i->second.m_ID == 0 ? string( "NULL" ) : UTIL_ToString( i->second.m_ID ) ) + ", '" + MySQLEscapeString( Connection, i->second.m_Name ) + "', '" + MySQLEscapeString( Connection, i->second.m_Server ) + "', " + UTIL_ToString( i->second.m_Score, 2 ) + " )";
+		RatingsWritten++;
+
+		if( RatingsWritten % 500 == 0 )
+		{
+			if( !MySQLQuery( Connection, QUpsert + " ON DUPLICATE KEY UPDATE score=VALUES(score)" ) )
+				return 1;
+
+			QUpsert.clear( );
+		}
+	}
+
+	if( !QUpsert.empty( ) && !MySQLQuery( Connection, QUpsert + " ON DUPLICATE KEY UPDATE score=VALUES(score)" ) )
+		return 1;
+
+	// every game in the range is marked as scored including the ones without dota players or that were ignored, as before
+
+	string QInsertScored = "INSERT INTO dota_elo_games_scored ( gameid ) SELECT games.id FROM games LEFT JOIN dota_elo_games_scored ON dota_elo_games_scored.gameid=games.id WHERE dota_elo_games_scored.id IS NULL AND games.id>" + UTIL_ToString( Since ) + " AND games.id<=" + UTIL_ToString( MaxGameID );
+
+	if( !MySQLQuery( Connection, QInsertScored ) )
+		return 1;
+
+	uint32_t WriteTicks = GetTicks( );
+	cout << "wrote " << RatingsWritten << " ratings in " << WriteTicks - ScoreTicks << " ms" << endl;
+
 	cout << "copying dota elo scores to scores table" << endl;
 
 	string QCopyScores1 = "DELETE FROM scores WHERE category='dota_elo'";
@@ -419,6 +558,13 @@ int main( int argc, char **argv )
 		return 1;
 	}
 
-	cout << "done" << endl;
+	uint32_t EndTicks = GetTicks( );
+	cout << "done in " << EndTicks - StartTicks << " ms";
+
+	if( EndTicks > StartTicks )
+		cout << " (" << (uint64_t)GamesFound * 1000 / ( EndTicks - StartTicks ) << " games/sec)";
+
+	cout << endl;
+	cout << "next run: --since " << MaxGameID << endl;
 	return 0;
 }
@@ -38,6 +38,7 @@ using namespace std;
 #include "elo.h"
 
 #include <string.h>
+#include <time.h>
 
 #ifdef WIN32
  #include <winsock.h>
@@ -118,12 +119,187 @@ float UTIL_ToFloat( string &s )
 	return result;
 }
 
+uint32_t GetTicks( )
+{
+#ifdef WIN32
+	return GetTickCount( );
+#else
+	struct timespec t;
+	clock_gettime( CLOCK_MONOTONIC, &t );
+	return t.tv_sec * 1000 + t.tv_nsec / 1000000;
+#endif
+}
+
+bool MySQLQuery( MYSQL *conn, const string &query )
+{
+	if( mysql_real_query( conn, query.c_str( ), query.size( ) ) != 0 )
+	{
+		cout << "error: " << mysql_error( conn ) << endl;
+		return false;
+	}
+
+	return true;
+}
+
+//
+// the ratings for the category are loaded once, every unscored game is scored in memory in gameid order and only the changed ratings are written back
+// players are keyed by lowercase name and server (the names are already lowercased by the queries)
+//
+
+struct EloPlayer
+{
+	uint32_t m_ID;			// 0 if the player doesn't have a row in w3mmd_elo_scores yet
+	string m_Name;
+	string m_Server;
+	float m_Score;
+	bool m_Changed;
+};
+
+struct EloGamePlayer
+{
+	string m_Name;
+	string m_Server;
+	string m_Flag;
+	string m_Practicing;
+};
+
+typedef map<string, EloPlayer> EloPlayerMap;
+
+bool ScoreGame( uint32_t GameID, vector<EloGamePlayer> &players, EloPlayerMap &ratings )
+{
+	bool winner = false;
+	EloPlayer *ratingplayers[12];
+	string names[12];
+	string servers[12];
+	int num_players = 0;
+	float player_ratings[12];
+	int player_teams[12];
+	int num_teams = 0;
+	float team_ratings[12];
+	float team_winners[12];
+	int team_numplayers[12];
+
+	for( int i = 0; i < 12; i++ )
+	{
+		team_ratings[i] = 0.0;
+		team_numplayers[i] = 0;
+	}
+
+	for( vector<EloGamePlayer> :: iterator i = players.begin( ); i != players.end( ); ++i )
+	{
+		if( num_players >= 12 )
+		{
+			cout << "gameid " << GameID << " has more than 12 players, ignoring\n";
+			return false;
+		}
+
+		if( i->m_Flag == "drawer" )
+		{
+			cout << "ignoring player [" << i->m_Name << "|" << i->m_Server << "] because they drew\n";
+			continue;
+		}
+
+		if( i->m_Practicing == "1" )
+		{
+			cout << "ignoring player [" << i->m_Name << "|" << i->m_Server << "] because they were practicing\n";
+			continue;
+		}
+
+		if( i->m_Flag == "winner" )
+		{
+			// keep track of whether at least one player won or not since we shouldn't score the game if nobody won
+
+			winner = true;
+
+			// note: we pretend each player is on a different team (i.e. it was a free for all)
+			// this is because the ELO algorithm requires that each team either all won or all lost as a group
+			// however, the MMD system stores win/loss flags on a per player basis and doesn't constrain the flags based on team
+
+			team_winners[num_players] = 1.0;
+		}
+		else
+			team_winners[num_players] = 0.0;
+
+		names[num_players] = i->m_Name;
+		servers[num_players] = i->m_Server;
+
+		// new players are only added to the map once the game is known to be scored
+
+		EloPlayerMap :: iterator Rating = ratings.find( i->m_Name + '\0' + i->m_Server );
+
+		if( Rating != ratings.end( ) )
+		{
+			ratingplayers[num_players] = &Rating->second;
+			player_ratings[num_players] = Rating->second.m_Score;
+		}
+		else
+		{
+			ratingplayers[num_players] = NULL;
+			player_ratings[num_players] = 1000.0;
+		}
+
+		player_teams[num_players] = num_players;
+		team_ratings[num_players] = player_ratings[num_players];
+		team_numplayers[num_players]++;
+		num_players++;
+	}
+
+	num_teams = num_players;
+
+	if( num_players == 0 )
+	{
+		cout << "gameid " << GameID << " has no players or is the wrong category, ignoring\n";
+		return false;
+	}
+	else if( !winner )
+	{
+		cout << "gameid " << GameID << " has no winner, ignoring\n";
+		return false;
+	}
+
+	float old_player_ratings[12];
+	memcpy( old_player_ratings, player_ratings, sizeof( float ) * 12 );
+	elo_recalculate_ratings( num_players, player_ratings, player_teams, num_teams, team_ratings, team_winners );
+
+	for( int i = 0; i < num_players; i++ )
+	{
+		if( !ratingplayers[i] )
+		{
+			cout << "new player [" << names[i] << "|" << servers[i] << "] found\n";
+			EloPlayer &Player = ratings[names[i] + '\0' + servers[i]];
+			Player.m_ID = 0;
+			Player.m_Name = names[i];
+			Player.m_Server = servers[i];
+			ratingplayers[i] = &Player;
+		}
+
+		ratingplayers[i]->m_Score = player_ratings[i];
+		ratingplayers[i]->m_Changed = true;
+		cout << "player [" << names[i] << "|" << servers[i] << "] rating " << (uint32_t)old_player_ratings[i] << " -> " << (uint32_t)player_ratings[i] << "\n";
+	}
+
+	return true;
+}
+
 int main( int argc, char **argv )
 {
 	string CFGFile = "update_w3mmd_elo.cfg";
+	uint32_t Since = 0;
 
-	if( argc > 1 && argv[1] )
-		CFGFile = argv[1];
+	for( int i = 1; i < argc; i++ )
+	{
+		string Arg = argv[i];
+
+		if( Arg == "--since" && i + 1 < argc )
+		{
+			// only games with a higher gameid are considered, pass the watermark printed by the previous run to skip the already scored history
+
+			string Value = argv[++i];
+			Since = UTIL_ToUInt32( Value );
+		}
+		else
+			CFGFile = Arg;
+	}
 
 	CConfig CFG;
 	CFG.Read( CFGFile );
@@ -186,16 +362,14 @@ int main( int argc, char **argv )
 		return 1;
 	}
 
-	cout << "getting unscored games" << endl;
-	queue<uint32_t> UnscoredGames;
+	string EscCategory = MySQLEscapeString( Connection, Category );
+	uint32_t StartTicks = GetTicks( );
+	uint32_t MaxGameID = 0;
 
-	string QSelectUnscored = "SELECT id FROM games WHERE id NOT IN ( SELECT gameid FROM w3mmd_elo_games_scored WHERE category='" + MySQLEscapeString( Connection, Category ) + "' ) ORDER BY id";
+	// games created while we're running are left for the next run
 
-	if( mysql_real_query( Connection, QSelectUnscored.c_str( ), QSelectUnscored.size( ) ) != 0 )
-	{
-		cout << "error: " << mysql_error( Connection ) << endl;
+	if( !MySQLQuery( Connection, "SELECT MAX(id) FROM games" ) )
 		return 1;
-	}
 	else
 	{
 		MYSQL_RES *Result = mysql_store_result( Connection );
@@ -204,11 +378,8 @@ int main( int argc, char **argv )
 		{
 			vector<string> Row = MySQLFetchRow( Result );
 
-			while( !Row.empty( ) )
-			{
-				UnscoredGames.push( UTIL_ToUInt32( Row[0] ) );
-				Row = MySQLFetchRow( Result );
-			}
+			if( !Row.empty( ) && !Row[0].empty( ) )
+				MaxGameID = UTIL_ToUInt32( Row[0] );
 
 			mysql_free_result( Result );
 		}
@@ -219,190 +390,159 @@ int main( int argc, char **argv )
 		}
 	}
 
-	cout << "found " << UnscoredGames.size( ) << " unscored games" << endl;
+	cout << "loading ratings" << endl;
+	EloPlayerMap Ratings;
 
-	while( !UnscoredGames.empty( ) )
+	if( !MySQLQuery( Connection, "SELECT id, LOWER(name), server, score FROM w3mmd_elo_scores WHERE category='" + EscCategory + "'" ) )
+		return 1;
+	else
 	{
-		uint32_t GameID = UnscoredGames.front( );
-		UnscoredGames.pop( );
+		MYSQL_RES *Result = mysql_use_result( Connection );
 
-		// lowercase the name because there was a bug in GHost++ 13.3 and earlier that didn't automatically lowercase it when using MySQL
+		if( Result )
+		{
+			vector<string> Row = MySQLFetchRow( Result );
 
-		string QSelectPlayers = "SELECT w3mmd_elo_scores.id, LOWER(gameplayers.name), spoofedrealm, flag, practicing, score FROM w3mmdplayers LEFT JOIN gameplayers ON gameplayers.gameid=w3mmdplayers.gameid AND LOWER(gameplayers.name)=LOWER(w3mmdplayers.name) LEFT JOIN w3mmd_elo_scores ON LOWER(w3mmd_elo_scores.name)=LOWER(gameplayers.name) AND server=spoofedrealm WHERE w3mmdplayers.category='" + MySQLEscapeString( Connection, Category ) + "' AND w3mmdplayers.gameid=" + UTIL_ToString( GameID );
+			while( Row.size( ) == 4 )
+			{
+				EloPlayer &Player = Ratings[Row[1] + '\0' + Row[2]];
+				Player.m_ID = UTIL_ToUInt32( Row[0] );
+				Player.m_Name = Row[1];
+				Player.m_Server = Row[2];
+				Player.m_Score = UTIL_ToFloat( Row[3] );
+				Player.m_Changed = false;
+				Row = MySQLFetchRow( Result );
+			}
 
-		if( mysql_real_query( Connection, QSelectPlayers.c_str( ), QSelectPlayers.size( ) ) != 0 )
+			mysql_free_result( Result );
+		}
+		else
 		{
 			cout << "error: " << mysql_error( Connection ) << endl;
 			return 1;
 		}
-		else
-		{
-			MYSQL_RES *Result = mysql_store_result( Connection );
-
-			if( Result )
-			{
-				cout << "gameid " << UTIL_ToString( GameID ) << " found" << endl;
-
-				bool ignore = false;
-				bool winner = false;
-				uint32_t rowids[12];
-				string names[12];
-				string servers[12];
-				bool exists[12];
-				int num_players = 0;
-				float player_ratings[12];
-				int player_teams[12];
-				int num_teams = 0;
-				float team_ratings[12];
-				float team_winners[12];
-				int team_numplayers[12];
-
-				for( int i = 0; i < 12; i++ )
-				{
-					team_ratings[i] = 0.0;
-					team_numplayers[i] = 0;
-				}
-
-				vector<string> Row = MySQLFetchRow( Result );
-
-				while( Row.size( ) == 6 )
-				{
-					// Row[0] = rowid
-					// Row[1] = name
-					// Row[2] = server
-					// Row[3] = flag
-					// Row[4] = practicing
-					// Row[5] = score
-
-					if( num_players >= 12 )
-					{
-						cout << "gameid " << UTIL_ToString( GameID ) << " has more than 12 players, ignoring" << endl;
-						ignore = true;
-						break;
-					}
-
-					if( Row[3] == "drawer" )
-					{
-						cout << "ignoring player [" << Row[1] << "|" << Row[2] << "] because they drew" << endl;
-						continue;
-					}
+	}
 
-					if( Row[4] == "1" )
-					{
-						cout << "ignoring player [" << Row[1] << "|" << Row[2] << "] because they were practicing" << endl;
-						continue;
-					}
+	uint32_t LoadTicks = GetTicks( );
+	cout << "loaded " << Ratings.size( ) << " ratings in " << LoadTicks - StartTicks << " ms" << endl;
+	cout << "scoring unscored games after gameid " << Since << " up to gameid " << MaxGameID << endl;
 
-					if( Row[3] == "winner" )
-					{
-						// keep track of whether at least one player won or not since we shouldn't score the game if nobody won
+	// stream every player of every unscored game in one query, the rows arrive grouped by gameid so each game is scored once its last row has been read
+	// nothing else can be sent on the connection until the result has been read completely, which is fine since the ratings are only written back afterwards
+	// lowercase the name because there was a bug in GHost++ 13.3 and earlier that didn't automatically lowercase it when using MySQL
 
-						winner = true;
+	string QSelectPlayers = "SELECT w3mmdplayers.gameid, LOWER(gameplayers.name), spoofedrealm, flag, practicing FROM w3mmdplayers LEFT JOIN gameplayers ON gameplayers.gameid=w3mmdplayers.gameid AND LOWER(gameplayers.name)=LOWER(w3mmdplayers.name) LEFT JOIN w3mmd_elo_games_scored ON w3mmd_elo_games_scored.gameid=w3mmdplayers.gameid AND w3mmd_elo_games_scored.category='" + EscCategory + "' WHERE w3mmdplayers.category='" + EscCategory + "' AND w3mmd_elo_games_scored.id IS NULL AND w3mmdplayers.gameid>" + UTIL_ToString( Since ) + " AND w3mmdplayers.gameid<=" + UTIL_ToString( MaxGameID ) + " ORDER BY w3mmdplayers.gameid";
+	uint32_t GamesFound = 0;
+	uint32_t GamesScored = 0;
 
-						// note: we pretend each player is on a different team (i.e. it was a free for all)
-						// this is because the ELO algorithm requires that each team either all won or all lost as a group
-						// however, the MMD system stores win/loss flags on a per player basis and doesn't constrain the flags based on team
-						// another option is to throw an error when this is detected and ignore the game completely
-						// at this point I'm not sure which option is more correct
+	if( !MySQLQuery( Connection, QSelectPlayers ) )
+		return 1;
+	else
+	{
+		MYSQL_RES *Result = mysql_use_result( Connection );
 
-						team_winners[num_players] = 1.0;
-					}
-					else
-						team_winners[num_players] = 0.0;
+		if( Result )
+		{
+			uint32_t GameID = 0;
+			vector<EloGamePlayer> Players;
+			vector<string> Row = MySQLFetchRow( Result );
 
-					if( !Row[0].empty( ) )
-						rowids[num_players] = UTIL_ToUInt32( Row[0] );
-					else
-						rowids[num_players] = 0;
+			while( 1 )
+			{
+				// Row[0] = gameid
+				// Row[1] = name
+				// Row[2] = server
+				// Row[3] = flag
+				// Row[4] = practicing
 
-					names[num_players] = Row[1];
-					servers[num_players] = Row[2];
+				uint32_t RowGameID = Row.size( ) == 5 ? UTIL_ToUInt32( Row[0] ) : 0;
 
-					if( !Row[5].empty( ) )
-					{
-						exists[num_players] = true;
-						player_ratings[num_players] = UTIL_ToFloat( Row[5] );
-					}
-					else
+				if( RowGameID != GameID )
+				{
+					if( GameID != 0 )
 					{
-						cout << "new player [" << Row[1] << "|" << Row[2] << "] found" << endl;
-						exists[num_players] = false;
-						player_ratings[num_players] = 1000.0;
+						GamesFound++;
+
+						if( ScoreGame( GameID, Players, Ratings ) )
+							GamesScored++;
 					}
 
-					player_teams[num_players] = num_players;
-					team_ratings[num_players] = player_ratings[num_players];
-					team_numplayers[num_players]++;
-					num_players++;
-					Row = MySQLFetchRow( Result );
+					GameID = RowGameID;
+					Players.clear( );
 				}
 
-				num_teams = num_players;
-				mysql_free_result( Result );
+				if( Row.size( ) != 5 )
+					break;
 
-				if( !ignore )
-				{
-					if( num_players == 0 )
-						cout << "gameid " << UTIL_ToString( GameID ) << " has no players or is the wrong category, ignoring" << endl;
-					else if( !winner )
-						cout << "gameid " << UTIL_ToString( GameID ) << " has no winner, ignoring" << endl;
-					else
-					{
-						cout << "gameid " << UTIL_ToString( GameID ) << " is calculating" << endl;
-
-						float old_player_ratings[12];
-						memcpy( old_player_ratings, player_ratings, sizeof( float ) * 12 );
-						// team_ratings[0] /= team_numplayers[0];
-						// team_ratings[1] /= team_numplayers[1];
-						elo_recalculate_ratings( num_players, player_ratings, player_teams, num_teams, team_ratings, team_winners );
-
-						for( int i = 0; i < num_players; i++ )
-						{
-							cout << "player [" << names[i] << "|" << servers[i] << "] rating " << UTIL_ToString( (uint32_t)old_player_ratings[i] ) << " -> " << UTIL_ToString( (uint32_t)player_ratings[i] ) << endl;
-
-							if( exists[i] )
-							{
-								string QUpdateScore = "UPDATE w3mmd_elo_scores SET score=" + UTIL_ToString( player_ratings[i], 2 ) + " WHERE id=" + UTIL_ToString( rowids[i] );
-
-								if( mysql_real_query( Connection, QUpdateScore.c_str( ), QUpdateScore.size( ) ) != 0 )
-								{
-									cout << "error: " << mysql_error( Connection ) << endl;
-									return 1;
-								}
-							}
-							else
-							{
-								string EscCategory = MySQLEscapeString( Connection, Category );
-								string EscName = MySQLEscapeString( Connection, names[i] );
-								string EscServer = MySQLEscapeString( Connection, servers[i] );
-								string QInsertScore = "INSERT INTO w3mmd_elo_scores ( category, name, server, score ) VALUES ( '" + EscCategory + "', '" + EscName + "', '" + EscServer + "', " + UTIL_ToString( player_ratings[i], 2 ) + " )";
-
-								if( mysql_real_query( Connection, QInsertScore.c_str( ), QInsertScore.size( ) ) != 0 )
-								{
-									cout << "error: " << mysql_error( Connection ) << endl;
-									return 1;
-								}
-							}
-						}
-					}
-				}				
+				EloGamePlayer Player;
+				Player.m_Name = Row[1];
+				Player.m_Server = Row[2];
+				Player.m_Flag = Row[3];
+				Player.m_Practicing = Row[4];
+				Players.push_back( Player );
+				Row = MySQLFetchRow( Result );
 			}
-			else
+
+			if( mysql_errno( Connection ) != 0 )
 			{
 				cout << "error: " << mysql_error( Connection ) << endl;
+				mysql_free_result( Result );
 				return 1;
 			}
-		}
-
-		string QInsertScored = "INSERT INTO w3mmd_elo_games_scored ( category, gameid ) VALUES ( '" + MySQLEscapeString( Connection, Category ) + "', " + UTIL_ToString( GameID ) + " )";
 
-		if( mysql_real_query( Connection, QInsertScored.c_str( ), QInsertScored.size( ) ) != 0 )
+			mysql_free_result( Result );
+		}
+		else
 		{
 			cout << "error: " << mysql_error( Connection ) << endl;
 			return 1;
 		}
 	}
 
+	uint32_t ScoreTicks = GetTicks( );
+	cout << "scored " << GamesScored << " of " << GamesFound << " games in " << ScoreTicks - LoadTicks << " ms" << endl;
+	cout << "writing ratings" << endl;
+
+	// upsert the changed ratings in batches, existing rows are matched on their primary key and new players get a NULL id so they're inserted
+
+	uint32_t RatingsWritten = 0;
+	string QUpsert;
+
+	for( EloPlayerMap :: iterator i = Ratings.begin( ); i != Ratings.end( ); ++i )
+	{
+		if( !i->second.m_Changed )
+			continue;
+
+		if( QUpsert.empty( ) )
+			QUpsert = "INSERT INTO w3mmd_elo_scores ( id, category, name, server, score ) VALUES ";
+		else
+			QUpsert += ", ";
+
+		QUpsert += "( " + ( i->second.m_ID == 0 ? string( "NULL" ) : UTIL_ToString( i->second.m_ID ) ) + ", '" + EscCategory + "', '" + MySQLEscapeString( Connection, i->second.m_Name ) + "', '" + MySQLEscapeString( Connection, i->second.m_Server ) + "', " + UTIL_ToString( i->second.m_Score, 2 ) + " )";
+		RatingsWritten++;
+
+		if( RatingsWritten % 500 == 0 )
+		{
+			if( !MySQLQuery( Connection, QUpsert + " ON DUPLICATE KEY UPDATE score=VALUES(score)" ) )
+				return 1;
+
+			QUpsert.clear( );
+		}
+	}
+
+	if( !QUpsert.empty( ) && !MySQLQuery( Connection, QUpsert + " ON DUPLICATE KEY UPDATE score=VALUES(score)" ) )
+		return 1;
+
+	// every game in the range is marked as scored for this category including the ones without players in it or that were ignored, as before
+
+	string QInsertScored = "INSERT INTO w3mmd_elo_games_scored ( category, gameid ) SELECT '" + EscCategory + "', games.id FROM games LEFT JOIN w3mmd_elo_games_scored ON w3mmd_elo_games_scored.gameid=games.id AND w3mmd_elo_games_scored.category='" + EscCategory + "' WHERE w3mmd_elo_games_scored.id IS NULL AND games.id>" + UTIL_ToString( Since ) + " AND games.id<=" + UTIL_ToString( MaxGameID );
+
+	if( !MySQLQuery( Connection, QInsertScored ) )
+		return 1;
+
+	uint32_t WriteTicks = GetTicks( );
+	cout << "wrote " << RatingsWritten << " ratings in " << WriteTicks - ScoreTicks << " ms" << endl;
+
 	cout << "copying w3mmd elo scores to scores table" << endl;
 
 	string QCopyScores1 = "DELETE FROM scores WHERE category='" + MySQLEscapeString( Connection, Category ) + "'";
@@ -430,6 +570,13 @@ int main( int argc, char **argv )
 		return 1;
 	}
 
-	cout << "done" << endl;
+	uint32_t EndTicks = GetTicks( );
+	cout << "done in " << EndTicks - StartTicks << " ms";
+
+	if( EndTicks > StartTicks )
+		cout << " (" << (uint64_t)GamesFound * 1000 / ( EndTicks - StartTicks ) << " games/sec)";
+
+	cout << endl;
+	cout << "next run: --since " << MaxGameID << endl;
 	return 0;
 }
@@ -0,0 +1,1354 @@
+/*
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*/
+
+// w3gs_swarm
+// simulates a large number of Warcraft III clients against a running host to find out how many games and players a build can sustain
+// lobbies are found the same way a LAN client finds them, by listening for the W3GS_GAMEINFO broadcasts the host sends to UDP port 6112
+// so the host should run with udp_broadcasttarget = 127.0.0.1 and autohost enabled (full lobbies then start on their own and are rehosted)
+// every client joins, checks or downloads the map, loads, answers each W3GS_INCOMING_ACTION with a keepalive and sends actions at a configurable APM
+// with -gproxy the clients also speak the GProxy++ protocol and can be told to drop their connection once per game and reconnect
+// the clients are spread over a few worker threads which poll their sockets, select( ) isn't used because the descriptors quickly go past FD_SETSIZE
+// the report shows join latency, map download throughput, action stream jitter and (with -pid) the host's CPU time per connected player
+
+#include "ghost.h"
+#include "util.h"
+#include "crc32.h"
+#include "gameslot.h"
+#include "gameprotocol.h"
+#include "gpsprotocol.h"
+
+#include <signal.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#define SWARM_HISTOGRAM_BUCKETS		5000	// one bucket per millisecond, everything slower lands in the last one
+#define SWARM_LOBBY_EXPIRE			12000	// the host broadcasts each lobby every 5 seconds
+#define SWARM_LOBBY_TIMEOUT			300000	// give up on a lobby that hasn't started after this long
+#define SWARM_GPROXY_ACK_INTERVAL	10000
+#define SWARM_STATS_INTERVAL		1000
+
+bool gVerbose = false;
+volatile bool gExit = false;
+boost :: mutex gConsoleMutex;
+
+void CONSOLE_Print( string message )
+{
+	if( !gVerbose )
+		return;
+
+	boost :: mutex :: scoped_lock lock( gConsoleMutex );
+	cerr << message << endl;
+}
+
+void DEBUG_Print( string message )
+{
+	CONSOLE_Print( message );
+}
+
+void DEBUG_Print( BYTEARRAY b )
+{
+	CONSOLE_Print( UTIL_ByteArrayToHexString( b ) );
+}
+
+uint32_t GetTicks( )
+{
+	static const boost :: posix_time :: ptime Start = boost :: posix_time :: microsec_clock :: universal_time( );
+	return (uint32_t)( boost :: posix_time :: microsec_clock :: universal_time( ) - Start ).total_milliseconds( );
+}
+
+uint32_t GetTime( )
+{
+	return GetTicks( ) / 1000;
+}
+
+void SignalCatcher( int s )
+{
+	gExit = true;
+}
+
+inline uint16_t ReadUInt16( const unsigned char *data )
+{
+	return (uint16_t)( data[0] | ( data[1] << 8 ) );
+}
+
+inline uint32_t ReadUInt32( const unsigned char *data )
+{
+	return (uint32_t)data[0] | ( (uint32_t)data[1] << 8 ) | ( (uint32_t)data[2] << 16 ) | ( (uint32_t)data[3] << 24 );
+}
+
+//
+// SwarmOptions
+//
+
+struct SwarmOptions
+{
+	uint32_t m_Clients;
+	uint32_t m_Threads;
+	uint32_t m_Ramp;			// milliseconds between two clients starting
+	uint32_t m_Duration;		// seconds the whole run lasts
+	uint32_t m_GameTime;		// seconds each client plays before leaving and joining the next lobby
+	uint32_t m_LoadTime;		// milliseconds each client spends "loading" the map
+	uint32_t m_APM;
+	uint32_t m_ReportInterval;
+	uint32_t m_Reconnect;		// seconds into the game at which GProxy++ clients drop their connection, 0 to never drop
+	uint16_t m_LANPort;
+	uint32_t m_HostAddress;		// overrides the address the broadcasts come from (network byte order), 0 to use it
+	uint32_t m_HostPID;
+	bool m_Download;
+	bool m_GProxy;
+	string m_NamePrefix;
+};
+
+SwarmOptions gOptions;
+
+//
+// CSwarmHistogram
+//
+
+class CSwarmHistogram
+{
+private:
+	vector<uint32_t> m_Buckets;
+	uint64_t m_Count;
+	uint64_t m_Sum;
+	uint32_t m_Max;
+
+public:
+	CSwarmHistogram( ) : m_Buckets( SWARM_HISTOGRAM_BUCKETS, 0 ), m_Count( 0 ), m_Sum( 0 ), m_Max( 0 ) { }
+
+	uint64_t GetCount( ) const	{ return m_Count; }
+	uint32_t GetMax( ) const	{ return m_Max; }
+	double GetMean( ) const		{ return m_Count ? (double)m_Sum / m_Count : 0.0; }
+
+	void Add( uint32_t value )
+	{
+		++m_Buckets[value < SWARM_HISTOGRAM_BUCKETS ? value : SWARM_HISTOGRAM_BUCKETS - 1];
+		++m_Count;
+		m_Sum += value;
+
+		if( value > m_Max )
+			m_Max = value;
+	}
+
+	void Merge( const CSwarmHistogram &other )
+	{
+		for( uint32_t i = 0; i < SWARM_HISTOGRAM_BUCKETS; ++i )
+			m_Buckets[i] += other.m_Buckets[i];
+
+		m_Count += other.m_Count;
+		m_Sum += other.m_Sum;
+
+		if( other.m_Max > m_Max )
+			m_Max = other.m_Max;
+	}
+
+	uint32_t GetPercentile( double percentile ) const
+	{
+		if( m_Count == 0 )
+			return 0;
+
+		uint64_t Target = (uint64_t)( m_Count * percentile / 100.0 );
+		uint64_t Seen = 0;
+
+		for( uint32_t i = 0; i < SWARM_HISTOGRAM_BUCKETS; ++i )
+		{
+			Seen += m_Buckets[i];
+
+			if( Seen > Target )
+				return i;
+		}
+
+		return m_Max;
+	}
+
+	string ToString( ) const
+	{
+		if( m_Count == 0 )
+			return "n/a";
+
+		return "avg " + UTIL_ToString( GetMean( ), 1 ) + " p50 " + UTIL_ToString( GetPercentile( 50 ) ) + " p99 " + UTIL_ToString( GetPercentile( 99 ) ) + " max " + UTIL_ToString( m_Max ) + " ms";
+	}
+};
+
+//
+// CSwarmStats
+//
+
+// each worker collects into its own CSwarmStats without locking and folds it into the shared one once a second
+
+class CSwarmStats
+{
+public:
+	CSwarmHistogram m_JoinLatency;		// connect to W3GS_SLOTINFOJOIN
+	CSwarmHistogram m_Jitter;			// distance between two W3GS_INCOMING_ACTIONs minus the announced send interval
+	CSwarmHistogram m_ReconnectLatency;	// GPS_RECONNECT to GPS_RECONNECT reply
+	uint64_t m_DownloadBytes;
+	uint64_t m_DownloadTicks;
+	uint32_t m_Downloads;
+	uint32_t m_Joins;
+	uint32_t m_Rejects;
+	uint32_t m_Failures;
+	uint32_t m_GamesLoaded;
+	uint32_t m_Reconnects;
+	uint64_t m_ActionsSent;
+	uint64_t m_KeepAlivesSent;
+	uint64_t m_ActionPacketsReceived;
+
+	CSwarmStats( ) : m_DownloadBytes( 0 ), m_DownloadTicks( 0 ), m_Downloads( 0 ), m_Joins( 0 ), m_Rejects( 0 ), m_Failures( 0 ), m_GamesLoaded( 0 ), m_Reconnects( 0 ), m_ActionsSent( 0 ), m_KeepAlivesSent( 0 ), m_ActionPacketsReceived( 0 ) { }
+
+	void Merge( const CSwarmStats &other )
+	{
+		m_JoinLatency.Merge( other.m_JoinLatency );
+		m_Jitter.Merge( other.m_Jitter );
+		m_ReconnectLatency.Merge( other.m_ReconnectLatency );
+		m_DownloadBytes += other.m_DownloadBytes;
+		m_DownloadTicks += other.m_DownloadTicks;
+		m_Downloads += other.m_Downloads;
+		m_Joins += other.m_Joins;
+		m_Rejects += other.m_Rejects;
+		m_Failures += other.m_Failures;
+		m_GamesLoaded += other.m_GamesLoaded;
+		m_Reconnects += other.m_Reconnects;
+		m_ActionsSent += other.m_ActionsSent;
+		m_KeepAlivesSent += other.m_KeepAlivesSent;
+		m_ActionPacketsReceived += other.m_ActionPacketsReceived;
+	}
+};
+
+//
+// CSwarmLobbyList
+//
+
+struct SwarmLobby
+{
+	uint32_t m_Address;		// network byte order
+	uint16_t m_Port;
+	uint32_t m_HostCounter;
+	uint32_t m_EntryKey;
+	string m_GameName;
+	uint32_t m_LastSeen;
+	bool m_Full;
+};
+
+class CSwarmLobbyList
+{
+private:
+	boost :: mutex m_Mutex;
+	vector<SwarmLobby> m_Lobbies;
+
+public:
+	void Update( uint32_t address, const BYTEARRAY &gameInfo );
+	bool Pick( SwarmLobby &lobby );
+	void SetFull( const SwarmLobby &lobby );
+	uint32_t GetOpenCount( );
+};
+
+void CSwarmLobbyList :: Update( uint32_t address, const BYTEARRAY &gameInfo )
+{
+	// see CGameProtocol :: SEND_W3GS_GAMEINFO for the layout, the port is always the last field
+
+	if( gameInfo.size( ) < 24 || gameInfo[0] != W3GS_HEADER_CONSTANT || gameInfo[1] != CGameProtocol :: W3GS_GAMEINFO )
+		return;
+
+	SwarmLobby Lobby;
+	Lobby.m_Address = gOptions.m_HostAddress ? gOptions.m_HostAddress : address;
+	Lobby.m_HostCounter = ReadUInt32( &gameInfo[12] );
+	Lobby.m_EntryKey = ReadUInt32( &gameInfo[16] );
+	Lobby.m_Port = ReadUInt16( &gameInfo[gameInfo.size( ) - 2] );
+	Lobby.m_LastSeen = GetTicks( );
+	Lobby.m_Full = false;
+
+	for( BYTEARRAY :: const_iterator i = gameInfo.begin( ) + 20; i != gameInfo.end( ) && *i != 0; ++i )
+		Lobby.m_GameName.push_back( *i );
+
+	boost :: mutex :: scoped_lock lock( m_Mutex );
+
+	for( vector<SwarmLobby> :: iterator i = m_Lobbies.begin( ); i != m_Lobbies.end( ); ++i )
+	{
+		if( i->m_Address == Lobby.m_Address && i->m_Port == Lobby.m_Port && i->m_HostCounter == Lobby.m_HostCounter )
+		{
+			i->m_LastSeen = Lobby.m_LastSeen;
+			return;
+		}
+	}
+
+	CONSOLE_Print( "[SWARM] found lobby [" + Lobby.m_GameName + "] on port " + UTIL_ToString( Lobby.m_Port ) );
+	m_Lobbies.push_back( Lobby );
+}
+
+bool CSwarmLobbyList :: Pick( SwarmLobby &lobby )
+{
+	// fill the oldest lobby first, that's the one the host will start next
+
+	boost :: mutex :: scoped_lock lock( m_Mutex );
+	uint32_t Ticks = GetTicks( );
+
+	for( vector<SwarmLobby> :: iterator i = m_Lobbies.begin( ); i != m_Lobbies.end( ); )
+	{
+		if( Ticks - i->m_LastSeen >= SWARM_LOBBY_EXPIRE )
+			i = m_Lobbies.erase( i );
+		else
+			++i;
+	}
+
+	for( vector<SwarmLobby> :: iterator i = m_Lobbies.begin( ); i != m_Lobbies.end( ); ++i )
+	{
+		if( !i->m_Full )
+		{
+			lobby = *i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void CSwarmLobbyList :: SetFull( const SwarmLobby &lobby )
+{
+	boost :: mutex :: scoped_lock lock( m_Mutex );
+
+	for( vector<SwarmLobby> :: iterator i = m_Lobbies.begin( ); i != m_Lobbies.end( ); ++i )
+	{
+		if( i->m_Address == lobby.m_Address && i->m_Port == lobby.m_Port && i->m_HostCounter == lobby.m_HostCounter )
+			i->m_Full = true;
+	}
+}
+
+uint32_t CSwarmLobbyList :: GetOpenCount( )
+{
+	boost :: mutex :: scoped_lock lock( m_Mutex );
+	uint32_t Open = 0;
+
+	for( vector<SwarmLobby> :: iterator i = m_Lobbies.begin( ); i != m_Lobbies.end( ); ++i )
+	{
+		if( !i->m_Full )
+			++Open;
+	}
+
+	return Open;
+}
+
+CSwarmLobbyList gLobbies;
+
+void DiscoveryThread( )
+{
+	int Socket = socket( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+	int OptVal = 1;
+	setsockopt( Socket, SOL_SOCKET, SO_REUSEADDR, (const char *)&OptVal, sizeof( int ) );
+
+	struct sockaddr_in Address;
+	memset( &Address, 0, sizeof( Address ) );
+	Address.sin_family = AF_INET;
+	Address.sin_addr.s_addr = INADDR_ANY;
+	Address.sin_port = htons( gOptions.m_LANPort );
+
+	if( Socket < 0 || ::bind( Socket, (struct sockaddr *)&Address, sizeof( Address ) ) < 0 )
+	{
+		cerr << "error: unable to listen for LAN games on UDP port " << gOptions.m_LANPort << " (" << strerror( errno ) << ")" << endl;
+		gExit = true;
+		return;
+	}
+
+	unsigned char Buffer[1024];
+
+	while( !gExit )
+	{
+		struct pollfd Poll = { Socket, POLLIN, 0 };
+
+		if( poll( &Poll, 1, 100 ) <= 0 )
+			continue;
+
+		struct sockaddr_in From;
+		socklen_t FromLen = sizeof( From );
+		int c = recvfrom( Socket, (char *)Buffer, sizeof( Buffer ), 0, (struct sockaddr *)&From, &FromLen );
+
+		if( c > 0 )
+			gLobbies.Update( From.sin_addr.s_addr, BYTEARRAY( Buffer, Buffer + c ) );
+	}
+
+	close( Socket );
+}
+
+//
+// CSwarmClient
+//
+
+#define SWARM_WAITING		0	// waiting for its start time or for a lobby
+#define SWARM_CONNECTING	1
+#define SWARM_LOBBY			2
+#define SWARM_DOWNLOADING	3
+#define SWARM_LOADING		4
+#define SWARM_PLAYING		5
+#define SWARM_RECONNECTING	6
+#define SWARM_STATES		7
+
+const char *gStateNames[SWARM_STATES] = { "waiting", "connecting", "lobby", "downloading", "loading", "playing", "reconnecting" };
+
+class CSwarmClient
+{
+private:
+	CGPSProtocol *m_GPSProtocol;
+	CSwarmStats *m_Stats;
+	string m_Name;
+	int m_Socket;
+	unsigned char m_State;
+	bool m_Connected;
+	BYTEARRAY m_RecvBuffer;
+	BYTEARRAY m_SendBuffer;
+	SwarmLobby m_Lobby;
+	uint32_t m_NextJoinTicks;
+	uint32_t m_ConnectTicks;
+	uint32_t m_StateTicks;			// when the current state was entered
+	uint32_t m_PlayingTicks;		// when the game started for this client, a reconnect doesn't reset it
+	unsigned char m_PID;
+	uint32_t m_MapSize;
+	uint32_t m_MapReceived;
+	uint32_t m_DownloadStartTicks;
+	uint32_t m_LoadedTicks;			// when to send W3GS_GAMELOADED_SELF
+	uint32_t m_LastActionTicks;		// when the previous W3GS_INCOMING_ACTION arrived
+	uint32_t m_NextActionTicks;
+	uint32_t m_Checksum;			// running crc of the action stream, identical for every client in the game so the host never sees a desync
+	uint32_t m_PacketsReceived;		// W3GS packets only, this is what GProxy++ acks
+	uint32_t m_PacketsSent;
+	bool m_GProxyActive;
+	uint16_t m_ReconnectPort;
+	uint32_t m_ReconnectKey;
+	deque<BYTEARRAY> m_GProxyBuffer;	// packets sent during the game that the host hasn't acked yet
+	uint32_t m_GProxyBufferFirst;	// the packet number of the front of m_GProxyBuffer
+	uint32_t m_LastGProxyAckTicks;
+	uint32_t m_ReconnectTicks;		// when to drop the connection, 0 once it has been done this game
+
+public:
+	CSwarmClient( CGPSProtocol *nGPSProtocol, CSwarmStats *nStats, const string &nName, uint32_t nStartTicks );
+	~CSwarmClient( );
+
+	int GetSocket( )					{ return m_Socket; }
+	unsigned char GetState( )			{ return m_State; }
+	bool GetConnected( )				{ return m_Connected; }
+	bool GetWantsWrite( )				{ return !m_Connected || !m_SendBuffer.empty( ); }
+
+	void DoRecv( );
+	void DoSend( );
+	void Update( uint32_t ticks );
+
+private:
+	bool Connect( uint16_t port );
+	void Disconnect( );
+	void Fail( const string &reason );
+	void Reset( uint32_t ticks );
+	void SetState( unsigned char state, uint32_t ticks );
+	void Send( const BYTEARRAY &packet );
+	void ProcessPacket( const unsigned char *data, uint32_t length, uint32_t ticks );
+	void ProcessGPSPacket( const unsigned char *data, uint32_t length, uint32_t ticks );
+	void SendAction( );
+	void SendMapSize( unsigned char sizeFlag, uint32_t mapSize );
+	void UnqueueGProxyBuffer( uint32_t lastPacket );
+
+	BYTEARRAY MakePacket( unsigned char id, const BYTEARRAY &payload );
+};
+
+CSwarmClient :: CSwarmClient( CGPSProtocol *nGPSProtocol, CSwarmStats *nStats, const string &nName, uint32_t nStartTicks ) : m_GPSProtocol( nGPSProtocol ), m_Stats( nStats ), m_Name( nName ), m_Socket( -1 ), m_State( SWARM_WAITING ), m_Connected( false ), m_NextJoinTicks( nStartTicks ), m_ConnectTicks( 0 ), m_StateTicks( 0 ), m_PlayingTicks( 0 ), m_PID( 255 ), m_MapSize( 0 ), m_MapReceived( 0 ), m_DownloadStartTicks( 0 ), m_LoadedTicks( 0 ), m_LastActionTicks( 0 ), m_NextActionTicks( 0 ), m_Checksum( 0 ), m_PacketsReceived( 0 ), m_PacketsSent( 0 ), m_GProxyActive( false ), m_ReconnectPort( 0 ), m_ReconnectKey( 0 ), m_GProxyBufferFirst( 0 ), m_LastGProxyAckTicks( 0 ), m_ReconnectTicks( 0 )
+{
+
+}
+
+CSwarmClient :: ~CSwarmClient( )
+{
+	Disconnect( );
+}
+
+bool CSwarmClient :: Connect( uint16_t port )
+{
+	m_Socket = socket( AF_INET, SOCK_STREAM, IPPROTO_TCP );
+
+	if( m_Socket < 0 )
+	{
+		m_Socket = -1;
+		return false;
+	}
+
+	int OptVal = 1;
+	setsockopt( m_Socket, IPPROTO_TCP, TCP_NODELAY, (const char *)&OptVal, sizeof( int ) );
+	fcntl( m_Socket, F_SETFL, fcntl( m_Socket, F_GETFL ) | O_NONBLOCK );
+
+	struct sockaddr_in Address;
+	memset( &Address, 0, sizeof( Address ) );
+	Address.sin_family = AF_INET;
+	Address.sin_addr.s_addr = m_Lobby.m_Address;
+	Address.sin_port = htons( port );
+
+	if( connect( m_Socket, (struct sockaddr *)&Address, sizeof( Address ) ) < 0 && errno != EINPROGRESS )
+	{
+		Disconnect( );
+		return false;
+	}
+
+	m_Connected = false;
+	m_RecvBuffer.clear( );
+	m_SendBuffer.clear( );
+	return true;
+}
+
+void CSwarmClient :: Disconnect( )
+{
+	if( m_Socket != -1 )
+	{
+		close( m_Socket );
+		m_Socket = -1;
+	}
+
+	m_Connected = false;
+}
+
+void CSwarmClient :: Fail( const string &reason )
+{
+	CONSOLE_Print( "[SWARM: " + m_Name + "] " + reason + " while " + gStateNames[m_State] );
+	++m_Stats->m_Failures;
+	Reset( GetTicks( ) );
+}
+
+void CSwarmClient :: Reset( uint32_t ticks )
+{
+	// go back to waiting and join whichever lobby is open a few seconds from now
+
+	Disconnect( );
+	m_RecvBuffer.clear( );
+	m_SendBuffer.clear( );
+	SetState( SWARM_WAITING, ticks );
+	m_NextJoinTicks = ticks + 1000 + rand( ) % 4000;
+}
+
+void CSwarmClient :: SetState( unsigned char state, uint32_t ticks )
+{
+	m_State = state;
+	m_StateTicks = ticks;
+}
+
+BYTEARRAY CSwarmClient :: MakePacket( unsigned char id, const BYTEARRAY &payload )
+{
+	BYTEARRAY packet;
+	packet.reserve( 4 + payload.size( ) );
+	packet.push_back( W3GS_HEADER_CONSTANT );
+	packet.push_back( id );
+	UTIL_AppendByteArray( packet, (uint16_t)( 4 + payload.size( ) ), false );
+	packet.insert( packet.end( ), payload.begin( ), payload.end( ) );
+	return packet;
+}
+
+void CSwarmClient :: Send( const BYTEARRAY &packet )
+{
+	// count W3GS packets the same way CGamePlayer does and keep the in game ones around until the host acks them
+
+	if( packet[0] == W3GS_HEADER_CONSTANT )
+	{
+		++m_PacketsSent;
+
+		if( m_GProxyActive && ( m_State == SWARM_LOADING || m_State == SWARM_PLAYING || m_State == SWARM_RECONNECTING ) )
+		{
+			if( m_GProxyBuffer.empty( ) )
+				m_GProxyBufferFirst = m_PacketsSent;
+
+			m_GProxyBuffer.push_back( packet );
+		}
+	}
+
+	// while reconnecting the packet stays in the GProxy++ buffer and goes out once the host has told us what it already has
+
+	if( m_State != SWARM_RECONNECTING )
+		m_SendBuffer.insert( m_SendBuffer.end( ), packet.begin( ), packet.end( ) );
+}
+
+void CSwarmClient :: UnqueueGProxyBuffer( uint32_t lastPacket )
+{
+	while( !m_GProxyBuffer.empty( ) && m_GProxyBufferFirst <= lastPacket )
+	{
+		m_GProxyBuffer.pop_front( );
+		++m_GProxyBufferFirst;
+	}
+}
+
+void CSwarmClient :: DoRecv( )
+{
+	if( m_Socket == -1 )
+		return;
+
+	unsigned char Buffer[4096];
+
+	while( true )
+	{
+		ssize_t c = recv( m_Socket, (char *)Buffer, sizeof( Buffer ), 0 );
+
+		if( c > 0 )
+			m_RecvBuffer.insert( m_RecvBuffer.end( ), Buffer, Buffer + c );
+		else if( c == 0 )
+		{
+			Fail( "connection closed by host" );
+			return;
+		}
+		else
+		{
+			if( errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR )
+				Fail( string( "socket error (" ) + strerror( errno ) + ")" );
+
+			return;
+		}
+	}
+}
+
+void CSwarmClient :: DoSend( )
+{
+	if( m_Socket == -1 )
+		return;
+
+	if( !m_Connected )
+	{
+		int Error = 0;
+		socklen_t ErrorLen = sizeof( Error );
+		getsockopt( m_Socket, SOL_SOCKET, SO_ERROR, (char *)&Error, &ErrorLen );
+
+		if( Error != 0 )
+		{
+			Fail( string( "connect failed (" ) + strerror( Error ) + ")" );
+			return;
+		}
+
+		m_Connected = true;
+	}
+
+	if( m_SendBuffer.empty( ) )
+		return;
+
+	ssize_t c = send( m_Socket, (const char *)&m_SendBuffer[0], m_SendBuffer.size( ), MSG_NOSIGNAL );
+
+	if( c > 0 )
+		m_SendBuffer.erase( m_SendBuffer.begin( ), m_SendBuffer.begin( ) + c );
+	else if( c < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR )
+		Fail( string( "socket error (" ) + strerror( errno ) + ")" );
+}
+
+void CSwarmClient :: Update( uint32_t ticks )
+{
+	if( m_State == SWARM_WAITING )
+	{
+		if( ticks < m_NextJoinTicks )
+			return;
+
+		if( !gLobbies.Pick( m_Lobby ) )
+		{
+			m_NextJoinTicks = ticks + 500 + rand( ) % 500;
+			return;
+		}
+
+		m_PID = 255;
+		m_MapSize = 0;
+		m_MapReceived = 0;
+		m_LastActionTicks = 0;
+		m_Checksum = 0;
+		m_PacketsReceived = 0;
+		m_PacketsSent = 0;
+		m_GProxyActive = false;
+		m_GProxyBuffer.clear( );
+		m_ReconnectTicks = 0;
+
+		if( !Connect( m_Lobby.m_Port ) )
+		{
+			Fail( "unable to create socket" );
+			return;
+		}
+
+		m_ConnectTicks = ticks;
+		SetState( SWARM_CONNECTING, ticks );
+
+		// W3GS_REQJOIN, see CGameProtocol :: RECEIVE_W3GS_REQJOIN
+
+		BYTEARRAY Payload;
+		UTIL_AppendByteArray( Payload, m_Lobby.m_HostCounter, false );
+		UTIL_AppendByteArray( Payload, m_Lobby.m_EntryKey, false );
+		Payload.push_back( 0 );
+		UTIL_AppendByteArray( Payload, (uint16_t)6112, false );
+		UTIL_AppendByteArray( Payload, (uint32_t)0, false );
+		UTIL_AppendByteArray( Payload, m_Name );
+		UTIL_AppendByteArray( Payload, (uint32_t)1, false );
+		UTIL_AppendByteArray( Payload, (uint16_t)6112, false );
+		UTIL_AppendByteArray( Payload, (uint32_t)htonl( INADDR_LOOPBACK ), false );
+		Send( MakePacket( CGameProtocol :: W3GS_REQJOIN, Payload ) );
+		return;
+	}
+
+	// extract whole packets
+
+	uint32_t Offset = 0;
+
+	while( m_Socket != -1 && m_RecvBuffer.size( ) - Offset >= 4 )
+	{
+		const unsigned char *Data = &m_RecvBuffer[Offset];
+		uint16_t Length = ReadUInt16( Data + 2 );
+
+		if( ( Data[0] != W3GS_HEADER_CONSTANT && Data[0] != GPS_HEADER_CONSTANT ) || Length < 4 )
+		{
+			Fail( "received invalid packet" );
+			return;
+		}
+
+		if( m_RecvBuffer.size( ) - Offset < Length )
+			break;
+
+		if( Data[0] == W3GS_HEADER_CONSTANT )
+		{
+			++m_PacketsReceived;
+			ProcessPacket( Data, Length, ticks );
+		}
+		else
+			ProcessGPSPacket( Data, Length, ticks );
+
+		Offset += Length;
+	}
+
+	if( Offset > 0 && m_Socket != -1 )
+		m_RecvBuffer.erase( m_RecvBuffer.begin( ), m_RecvBuffer.begin( ) + Offset );
+
+	if( m_State == SWARM_WAITING )
+		return;
+
+	if( ( m_State == SWARM_LOBBY || m_State == SWARM_DOWNLOADING ) && ticks - m_StateTicks >= SWARM_LOBBY_TIMEOUT )
+	{
+		Send( MakePacket( CGameProtocol :: W3GS_LEAVEGAME, UTIL_CreateByteArray( (uint32_t)PLAYERLEAVE_LOBBY, false ) ) );
+		DoSend( );
+		Fail( "lobby timed out" );
+		return;
+	}
+
+	if( m_State == SWARM_LOADING && m_LoadedTicks != 0 && ticks >= m_LoadedTicks )
+	{
+		m_LoadedTicks = 0;
+		Send( MakePacket( CGameProtocol :: W3GS_GAMELOADED_SELF, BYTEARRAY( ) ) );
+	}
+
+	if( m_State == SWARM_PLAYING )
+	{
+		if( gOptions.m_APM > 0 && ticks >= m_NextActionTicks )
+		{
+			SendAction( );
+
+			// spread the actions out a bit, real players click in bursts
+
+			uint32_t Interval = 60000 / gOptions.m_APM;
+			m_NextActionTicks = ticks + Interval / 2 + rand( ) % ( Interval + 1 );
+		}
+
+		if( m_GProxyActive && m_ReconnectTicks != 0 && ticks >= m_ReconnectTicks )
+		{
+			// pull the plug and come back through the reconnect port like GProxy++ would
+
+			m_ReconnectTicks = 0;
+			Disconnect( );
+
+			if( !Connect( m_ReconnectPort ) )
+			{
+				Fail( "unable to create socket" );
+				return;
+			}
+
+			SetState( SWARM_RECONNECTING, ticks );
+			m_SendBuffer = m_GPSProtocol->SEND_GPSC_RECONNECT( m_PID, m_ReconnectKey, m_PacketsReceived );
+			return;
+		}
+
+		if( ticks - m_PlayingTicks >= gOptions.m_GameTime * 1000 )
+		{
+			Send( MakePacket( CGameProtocol :: W3GS_LEAVEGAME, UTIL_CreateByteArray( (uint32_t)PLAYERLEAVE_LOST, false ) ) );
+			DoSend( );
+			Reset( ticks );
+			return;
+		}
+	}
+
+	if( m_GProxyActive && m_State != SWARM_RECONNECTING && ticks - m_LastGProxyAckTicks >= SWARM_GPROXY_ACK_INTERVAL )
+	{
+		BYTEARRAY Ack = m_GPSProtocol->SEND_GPSC_ACK( m_PacketsReceived );
+		m_SendBuffer.insert( m_SendBuffer.end( ), Ack.begin( ), Ack.end( ) );
+		m_LastGProxyAckTicks = ticks;
+	}
+}
+
+void CSwarmClient :: ProcessPacket( const unsigned char *data, uint32_t length, uint32_t ticks )
+{
+	switch( data[1] )
+	{
+	case CGameProtocol :: W3GS_SLOTINFOJOIN:
+		if( length >= 7 )
+		{
+			uint16_t SlotInfoSize = ReadUInt16( data + 4 );
+
+			if( length >= 7u + SlotInfoSize )
+				m_PID = data[6 + SlotInfoSize];
+
+			m_Stats->m_JoinLatency.Add( ticks - m_ConnectTicks );
+			++m_Stats->m_Joins;
+			SetState( SWARM_LOBBY, ticks );
+
+			if( gOptions.m_GProxy )
+				Send( m_GPSProtocol->SEND_GPSC_INIT( 1 ) );
+		}
+
+		break;
+
+	case CGameProtocol :: W3GS_REJECTJOIN:
+		++m_Stats->m_Rejects;
+
+		// a full lobby is expected once the swarm outgrows it, anything else is worth a look
+
+		if( length >= 8 && ReadUInt32( data + 4 ) == REJECTJOIN_FULL )
+		{
+			gLobbies.SetFull( m_Lobby );
+			Reset( ticks );
+		}
+		else
+			Fail( "rejected" );
+
+		break;
+
+	case CGameProtocol :: W3GS_PING_FROM_HOST:
+		if( length >= 8 )
+		{
+			BYTEARRAY Payload( data + 4, data + 8 );
+			Send( MakePacket( CGameProtocol :: W3GS_PONG_TO_HOST, Payload ) );
+		}
+
+		break;
+
+	case CGameProtocol :: W3GS_MAPCHECK:
+	{
+		// 4 bytes unknown, null terminated map path, then the map size
+
+		uint32_t i = 8;
+
+		while( i < length && data[i] != 0 )
+			++i;
+
+		if( i + 5 <= length )
+			m_MapSize = ReadUInt32( data + i + 1 );
+
+		if( gOptions.m_Download )
+			SendMapSize( 1, 0 );
+		else
+			SendMapSize( 1, m_MapSize );
+
+		break;
+	}
+
+	case CGameProtocol :: W3GS_STARTDOWNLOAD:
+		m_MapReceived = 0;
+		m_DownloadStartTicks = ticks;
+		SetState( SWARM_DOWNLOADING, ticks );
+		break;
+
+	case CGameProtocol :: W3GS_MAPPART:
+		if( length >= 18 )
+		{
+			// to PID, from PID, 4 bytes unknown, start position, crc, data
+
+			uint32_t Start = ReadUInt32( data + 10 );
+			uint32_t Size = length - 18;
+
+			if( Start == m_MapReceived )
+				m_MapReceived += Size;
+
+			if( m_MapSize > 0 && m_MapReceived >= m_MapSize )
+			{
+				m_Stats->m_DownloadBytes += m_MapReceived;
+				m_Stats->m_DownloadTicks += ticks - m_DownloadStartTicks;
+				++m_Stats->m_Downloads;
+				SendMapSize( 1, m_MapSize );
+				SetState( SWARM_LOBBY, ticks );
+			}
+			else
+				SendMapSize( 3, m_MapReceived );
+		}
+
+		break;
+
+	case CGameProtocol :: W3GS_COUNTDOWN_END:
+		SetState( SWARM_LOADING, ticks );
+		m_LoadedTicks = ticks + gOptions.m_LoadTime / 2 + rand( ) % ( gOptions.m_LoadTime + 1 );
+		break;
+
+	case CGameProtocol :: W3GS_INCOMING_ACTION:
+		if( length >= 6 )
+		{
+			if( m_State == SWARM_LOADING && m_LoadedTicks == 0 )
+			{
+				++m_Stats->m_GamesLoaded;
+				SetState( SWARM_PLAYING, ticks );
+				m_PlayingTicks = ticks;
+				m_NextActionTicks = ticks + rand( ) % 2000;
+
+				if( m_GProxyActive && gOptions.m_Reconnect > 0 )
+					m_ReconnectTicks = ticks + gOptions.m_Reconnect * 1000 + rand( ) % 5000;
+			}
+
+			uint16_t SendInterval = ReadUInt16( data + 4 );
+
+			if( m_LastActionTicks != 0 && m_State == SWARM_PLAYING )
+			{
+				uint32_t Delta = ticks - m_LastActionTicks;
+				m_Stats->m_Jitter.Add( Delta > SendInterval ? Delta - SendInterval : SendInterval - Delta );
+			}
+
+			m_LastActionTicks = ticks;
+			++m_Stats->m_ActionPacketsReceived;
+
+			if( length > 8 )
+				CCRC32 :: PartialCRC( &m_Checksum, data + 8, length - 8 );
+
+			// W3GS_OUTGOING_KEEPALIVE, one for every W3GS_INCOMING_ACTION
+
+			BYTEARRAY Payload;
+			Payload.push_back( 0 );
+			UTIL_AppendByteArray( Payload, m_Checksum, false );
+			Send( MakePacket( CGameProtocol :: W3GS_OUTGOING_KEEPALIVE, Payload ) );
+			++m_Stats->m_KeepAlivesSent;
+		}
+
+		break;
+
+	case CGameProtocol :: W3GS_INCOMING_ACTION2:
+		if( length > 8 )
+			CCRC32 :: PartialCRC( &m_Checksum, data + 8, length - 8 );
+
+		break;
+
+	default:
+		break;
+	}
+}
+
+void CSwarmClient :: ProcessGPSPacket( const unsigned char *data, uint32_t length, uint32_t ticks )
+{
+	if( data[1] == CGPSProtocol :: GPS_INIT && length >= 12 )
+	{
+		// reconnect port, PID, reconnect key, number of empty actions
+
+		m_GProxyActive = true;
+		m_ReconnectPort = ReadUInt16( data + 4 );
+		m_ReconnectKey = ReadUInt32( data + 7 );
+		m_LastGProxyAckTicks = ticks;
+	}
+	else if( data[1] == CGPSProtocol :: GPS_ACK && length >= 8 )
+		UnqueueGProxyBuffer( ReadUInt32( data + 4 ) );
+	else if( data[1] == CGPSProtocol :: GPS_RECONNECT && length >= 8 && m_State == SWARM_RECONNECTING )
+	{
+		// the host tells us how many of our packets it got, everything after that is sent again
+		// the host replays what we missed on its side without further prompting
+
+		UnqueueGProxyBuffer( ReadUInt32( data + 4 ) );
+
+		for( deque<BYTEARRAY> :: iterator i = m_GProxyBuffer.begin( ); i != m_GProxyBuffer.end( ); ++i )
+			m_SendBuffer.insert( m_SendBuffer.end( ), i->begin( ), i->end( ) );
+
+		m_Stats->m_ReconnectLatency.Add( ticks - m_StateTicks );
+		++m_Stats->m_Reconnects;
+		SetState( SWARM_PLAYING, ticks );
+		m_LastActionTicks = 0;
+	}
+	else if( data[1] == CGPSProtocol :: GPS_REJECT )
+		Fail( "reconnect rejected" );
+}
+
+void CSwarmClient :: SendMapSize( unsigned char sizeFlag, uint32_t mapSize )
+{
+	// see CGameProtocol :: RECEIVE_W3GS_MAPSIZE
+
+	BYTEARRAY Payload;
+	UTIL_AppendByteArray( Payload, (uint32_t)1, false );
+	Payload.push_back( sizeFlag );
+	UTIL_AppendByteArray( Payload, mapSize, false );
+	Send( MakePacket( CGameProtocol :: W3GS_MAPSIZE, Payload ) );
+}
+
+void CSwarmClient :: SendAction( )
+{
+	// W3GS_OUTGOING_ACTION is a 4 byte crc (which the host ignores) followed by the action
+	// alternate between the two actions players send most, selecting a unit and right clicking somewhere on the map
+
+	BYTEARRAY Payload;
+	UTIL_AppendByteArray( Payload, (uint32_t)0, false );
+
+	if( rand( ) % 3 == 0 )
+	{
+		// 0x16 change selection: mode, unit count, object id pair per unit
+
+		Payload.push_back( 0x16 );
+		Payload.push_back( 1 );
+		UTIL_AppendByteArray( Payload, (uint16_t)1, false );
+		UTIL_AppendByteArray( Payload, (uint32_t)( 0x1000 + m_PID ), false );
+		UTIL_AppendByteArray( Payload, (uint32_t)( 0x1000 + m_PID ), false );
+	}
+	else
+	{
+		// 0x12 order with target position and object: flags, order id, 8 bytes unknown, x, y, object id pair
+
+		Payload.push_back( 0x12 );
+		UTIL_AppendByteArray( Payload, (uint16_t)0x0040, false );
+		UTIL_AppendByteArray( Payload, (uint32_t)0x000D0003, false );
+		UTIL_AppendByteArray( Payload, (uint32_t)0xFFFFFFFF, false );
+		UTIL_AppendByteArray( Payload, (uint32_t)0xFFFFFFFF, false );
+		float X = (float)( rand( ) % 16384 ) - 8192.0f;
+		float Y = (float)( rand( ) % 16384 ) - 8192.0f;
+		uint32_t Bits;
+		memcpy( &Bits, &X, 4 );
+		UTIL_AppendByteArray( Payload, Bits, false );
+		memcpy( &Bits, &Y, 4 );
+		UTIL_AppendByteArray( Payload, Bits, false );
+		UTIL_AppendByteArray( Payload, (uint32_t)0xFFFFFFFF, false );
+		UTIL_AppendByteArray( Payload, (uint32_t)0xFFFFFFFF, false );
+	}
+
+	Send( MakePacket( CGameProtocol :: W3GS_OUTGOING_ACTION, Payload ) );
+	++m_Stats->m_ActionsSent;
+}
+
+//
+// CSwarmWorker
+//
+
+class CSwarmWorker
+{
+public:
+	CGPSProtocol m_GPSProtocol;
+	CSwarmStats m_Stats;			// owned by the worker thread
+	vector<CSwarmClient *> m_Clients;
+	uint32_t m_StateCounts[SWARM_STATES];	// guarded by gStatsMutex
+
+	CSwarmWorker( )
+	{
+		memset( m_StateCounts, 0, sizeof( m_StateCounts ) );
+	}
+
+	~CSwarmWorker( )
+	{
+		for( vector<CSwarmClient *> :: iterator i = m_Clients.begin( ); i != m_Clients.end( ); ++i )
+			delete *i;
+	}
+
+	void Run( );
+};
+
+boost :: mutex gStatsMutex;
+CSwarmStats gStats;
+
+void CSwarmWorker :: Run( )
+{
+	vector<struct pollfd> Polls;
+	vector<CSwarmClient *> Polled;
+	uint32_t LastStatsTicks = GetTicks( );
+
+	while( !gExit )
+	{
+		Polls.clear( );
+		Polled.clear( );
+
+		for( vector<CSwarmClient *> :: iterator i = m_Clients.begin( ); i != m_Clients.end( ); ++i )
+		{
+			if( (*i)->GetSocket( ) == -1 )
+				continue;
+
+			struct pollfd Poll = { (*i)->GetSocket( ), (short)( POLLIN | ( (*i)->GetWantsWrite( ) ? POLLOUT : 0 ) ), 0 };
+			Polls.push_back( Poll );
+			Polled.push_back( *i );
+		}
+
+		if( Polls.empty( ) )
+			usleep( 10000 );
+		else
+			poll( &Polls[0], Polls.size( ), 10 );
+
+		for( uint32_t i = 0; i < Polls.size( ); ++i )
+		{
+			if( Polls[i].revents & POLLOUT )
+				Polled[i]->DoSend( );
+
+			if( Polls[i].revents & ( POLLIN | POLLHUP | POLLERR ) )
+				Polled[i]->DoRecv( );
+		}
+
+		uint32_t Ticks = GetTicks( );
+
+		for( vector<CSwarmClient *> :: iterator i = m_Clients.begin( ); i != m_Clients.end( ); ++i )
+		{
+			(*i)->Update( Ticks );
+
+			if( (*i)->GetConnected( ) )
+				(*i)->DoSend( );
+		}
+
+		if( Ticks - LastStatsTicks >= SWARM_STATS_INTERVAL )
+		{
+			boost :: mutex :: scoped_lock lock( gStatsMutex );
+			gStats.Merge( m_Stats );
+			memset( m_StateCounts, 0, sizeof( m_StateCounts ) );
+
+			for( vector<CSwarmClient *> :: iterator i = m_Clients.begin( ); i != m_Clients.end( ); ++i )
+				++m_StateCounts[(*i)->GetState( )];
+
+			lock.unlock( );
+			m_Stats = CSwarmStats( );
+			LastStatsTicks = Ticks;
+		}
+	}
+}
+
+//
+// host CPU
+//
+
+// utime + stime of the host process in milliseconds, read from /proc so this only works on Linux
+
+bool GetProcessCPU( uint32_t pid, uint64_t &cpuMS )
+{
+	string Stat = UTIL_FileRead( "/proc/" + UTIL_ToString( pid ) + "/stat" );
+
+	// the process name is in parentheses and may contain spaces, the fields we want are the 12th and 13th after it
+
+	string :: size_type End = Stat.rfind( ')' );
+
+	if( End == string :: npos )
+		return false;
+
+	stringstream SS( Stat.substr( End + 1 ) );
+	string Field;
+	uint64_t UTime = 0;
+	uint64_t STime = 0;
+
+	for( int i = 1; i <= 13 && SS >> Field; ++i )
+	{
+		if( i == 12 )
+			UTime = strtoull( Field.c_str( ), NULL, 10 );
+		else if( i == 13 )
+			STime = strtoull( Field.c_str( ), NULL, 10 );
+	}
+
+	cpuMS = ( UTime + STime ) * 1000 / sysconf( _SC_CLK_TCK );
+	return true;
+}
+
+void PrintReport( const CSwarmStats &stats, vector<CSwarmWorker *> &workers, uint32_t seconds, double hostCPU )
+{
+	uint32_t States[SWARM_STATES];
+	memset( States, 0, sizeof( States ) );
+
+	for( vector<CSwarmWorker *> :: iterator i = workers.begin( ); i != workers.end( ); ++i )
+	{
+		for( uint32_t j = 0; j < SWARM_STATES; ++j )
+			States[j] += (*i)->m_StateCounts[j];
+	}
+
+	uint32_t Connected = States[SWARM_LOBBY] + States[SWARM_DOWNLOADING] + States[SWARM_LOADING] + States[SWARM_PLAYING] + States[SWARM_RECONNECTING];
+	cout << "[" << seconds << "s]";
+
+	for( uint32_t i = 0; i < SWARM_STATES; ++i )
+		cout << " " << gStateNames[i] << " " << States[i];
+
+	cout << " | open lobbies " << gLobbies.GetOpenCount( ) << endl;
+	cout << "  joins " << stats.m_Joins << " rejects " << stats.m_Rejects << " failures " << stats.m_Failures << " games loaded " << stats.m_GamesLoaded << " reconnects " << stats.m_Reconnects << endl;
+	cout << "  join latency " << stats.m_JoinLatency.ToString( ) << endl;
+	cout << "  tick jitter " << stats.m_Jitter.ToString( ) << " over " << stats.m_ActionPacketsReceived << " action packets (" << stats.m_ActionsSent << " actions, " << stats.m_KeepAlivesSent << " keepalives sent)" << endl;
+
+	if( stats.m_Downloads > 0 && stats.m_DownloadTicks > 0 )
+		cout << "  map downloads " << stats.m_Downloads << " at " << fixed << setprecision( 1 ) << (double)stats.m_DownloadBytes / 1024 / ( (double)stats.m_DownloadTicks / 1000 ) << " KB/s per client" << endl;
+
+	if( stats.m_Reconnects > 0 )
+		cout << "  reconnect latency " << stats.m_ReconnectLatency.ToString( ) << endl;
+
+	if( hostCPU >= 0.0 )
+	{
+		cout << "  host cpu " << fixed << setprecision( 1 ) << hostCPU << "%";
+
+		if( Connected > 0 )
+			cout << " (" << setprecision( 3 ) << hostCPU / Connected << "% per player)";
+
+		cout << endl;
+	}
+
+	cout.unsetf( ios :: floatfield );
+}
+
+int main( int argc, char **argv )
+{
+	gOptions.m_Clients = 100;
+	gOptions.m_Threads = 4;
+	gOptions.m_Ramp = 20;
+	gOptions.m_Duration = 600;
+	gOptions.m_GameTime = 300;
+	gOptions.m_LoadTime = 5000;
+	gOptions.m_APM = 120;
+	gOptions.m_ReportInterval = 10;
+	gOptions.m_Reconnect = 0;
+	gOptions.m_LANPort = 6112;
+	gOptions.m_HostAddress = 0;
+	gOptions.m_HostPID = 0;
+	gOptions.m_Download = false;
+	gOptions.m_GProxy = false;
+	gOptions.m_NamePrefix = "swarm";
+
+	for( int i = 1; i < argc; ++i )
+	{
+		string Arg = argv[i];
+
+		if( Arg == "-n" && i + 1 < argc )
+			gOptions.m_Clients = strtoul( argv[++i], NULL, 10 );
+		else if( Arg == "-j" && i + 1 < argc )
+			gOptions.m_Threads = strtoul( argv[++i], NULL, 10 );
+		else if( Arg == "-ramp" && i + 1 < argc )
+			gOptions.m_Ramp = strtoul( argv[++i], NULL, 10 );
+		else if( Arg == "-t" && i + 1 < argc )
+			gOptions.m_Duration = strtoul( argv[++i], NULL, 10 );
+		else if( Arg == "-gametime" && i + 1 < argc )
+			gOptions.m_GameTime = strtoul( argv[++i], NULL, 10 );
+		else if( Arg == "-loadtime" && i + 1 < argc )
+			gOptions.m_LoadTime = strtoul( argv[++i], NULL, 10 );
+		else if( Arg == "-apm" && i + 1 < argc )
+			gOptions.m_APM = strtoul( argv[++i], NULL, 10 );
+		else if( Arg == "-report" && i + 1 < argc )
+			gOptions.m_ReportInterval = strtoul( argv[++i], NULL, 10 );
+		else if( Arg == "-reconnect" && i + 1 < argc )
+			gOptions.m_Reconnect = strtoul( argv[++i], NULL, 10 );
+		else if( Arg == "-lanport" && i + 1 < argc )
+			gOptions.m_LANPort = (uint16_t)strtoul( argv[++i], NULL, 10 );
+		else if( Arg == "-host" && i + 1 < argc )
+			gOptions.m_HostAddress = inet_addr( argv[++i] );
+		else if( Arg == "-pid" && i + 1 < argc )
+			gOptions.m_HostPID = strtoul( argv[++i], NULL, 10 );
+		else if( Arg == "-name" && i + 1 < argc )
+			gOptions.m_NamePrefix = argv[++i];
+		else if( Arg == "-download" )
+			gOptions.m_Download = true;
+		else if( Arg == "-gproxy" )
+			gOptions.m_GProxy = true;
+		else if( Arg == "-v" )
+			gVerbose = true;
+		else
+		{
+			cerr << "usage: w3gs_swarm [-n clients] [-j threads] [-ramp ms] [-t seconds] [-gametime seconds] [-loadtime ms] [-apm apm]" << endl;
+			cerr << "                  [-download] [-gproxy] [-reconnect seconds] [-lanport port] [-host address] [-pid host pid] [-name prefix] [-report seconds] [-v]" << endl;
+			cerr << "  -download makes every client download the map (needs bot_allowdownloads), otherwise they claim to have it" << endl;
+			cerr << "  -gproxy speaks GProxy++ (needs bot_reconnect), -reconnect drops each GProxy++ client's connection this long into every game" << endl;
+			cerr << "  -pid reports the CPU time the host process uses per connected client" << endl;
+			return 1;
+		}
+	}
+
+	if( gOptions.m_Clients == 0 )
+		gOptions.m_Clients = 1;
+
+	if( gOptions.m_Threads == 0 )
+		gOptions.m_Threads = 1;
+
+	if( gOptions.m_Threads > gOptions.m_Clients )
+		gOptions.m_Threads = gOptions.m_Clients;
+
+	signal( SIGINT, SignalCatcher );
+	signal( SIGPIPE, SIG_IGN );
+	srand( time( NULL ) );
+
+	vector<CSwarmWorker *> Workers;
+
+	for( uint32_t i = 0; i < gOptions.m_Threads; ++i )
+		Workers.push_back( new CSwarmWorker( ) );
+
+	uint32_t Start = GetTicks( );
+
+	for( uint32_t i = 0; i < gOptions.m_Clients; ++i )
+	{
+		// names are limited to 15 characters by the client
+
+		string Name = gOptions.m_NamePrefix.substr( 0, 9 ) + UTIL_ToString( i );
+		CSwarmWorker *Worker = Workers[i % Workers.size( )];
+		Worker->m_Clients.push_back( new CSwarmClient( &Worker->m_GPSProtocol, &Worker->m_Stats, Name, Start + i * gOptions.m_Ramp ) );
+	}
+
+	cerr << "starting " << gOptions.m_Clients << " clients on " << gOptions.m_Threads << " threads, listening for lobbies on UDP port " << gOptions.m_LANPort << endl;
+
+	boost :: thread_group Threads;
+	Threads.create_thread( &DiscoveryThread );
+
+	for( vector<CSwarmWorker *> :: iterator i = Workers.begin( ); i != Workers.end( ); ++i )
+		Threads.create_thread( boost :: bind( &CSwarmWorker :: Run, *i ) );
+
+	uint64_t FirstCPU = 0;
+	uint64_t LastCPU = 0;
+	uint32_t LastReportTicks = Start;
+	bool HaveCPU = gOptions.m_HostPID != 0 && GetProcessCPU( gOptions.m_HostPID, FirstCPU );
+	LastCPU = FirstCPU;
+
+	if( gOptions.m_HostPID != 0 && !HaveCPU )
+		cerr << "warning: unable to read the CPU time of process " << gOptions.m_HostPID << endl;
+
+	while( !gExit && GetTicks( ) - Start < gOptions.m_Duration * 1000 )
+	{
+		usleep( 100000 );
+		uint32_t Ticks = GetTicks( );
+
+		if( gOptions.m_ReportInterval == 0 || Ticks - LastReportTicks < gOptions.m_ReportInterval * 1000 )
+			continue;
+
+		// the interval report shows the host's CPU over the last interval, the summary below averages over the whole run
+
+		double HostCPU = -1.0;
+		uint64_t CPU;
+
+		if( HaveCPU && GetProcessCPU( gOptions.m_HostPID, CPU ) )
+		{
+			HostCPU = (double)( CPU - LastCPU ) * 100 / ( Ticks - LastReportTicks );
+			LastCPU = CPU;
+		}
+
+		boost :: mutex :: scoped_lock lock( gStatsMutex );
+		PrintReport( gStats, Workers, ( Ticks - Start ) / 1000, HostCPU );
+		lock.unlock( );
+		LastReportTicks = Ticks;
+	}
+
+	gExit = true;
+	Threads.join_all( );
+
+	uint32_t Ticks = GetTicks( );
+	double HostCPU = -1.0;
+	uint64_t CPU;
+
+	if( HaveCPU && GetProcessCPU( gOptions.m_HostPID, CPU ) && Ticks > Start )
+		HostCPU = (double)( CPU - FirstCPU ) * 100 / ( Ticks - Start );
+
+	cout << "summary" << endl;
+	PrintReport( gStats, Workers, ( Ticks - Start ) / 1000, HostCPU );
+
+	for( vector<CSwarmWorker *> :: iterator i = Workers.begin( ); i != Workers.end( ); ++i )
+		delete *i;
+
+	return 0;
+}